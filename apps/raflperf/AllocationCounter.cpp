@@ -0,0 +1,70 @@
+/**
+ * raflperf: AllocationCounter.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+//#################### GLOBAL VARIABLES ####################
+
+namespace {
+
+/** The size of the header that precedes each allocation (used to record its size, and large enough to preserve the alignment of the allocation). */
+const size_t HEADER_SIZE = 16;
+
+/** The number of times the global operator new has been called. */
+size_t g_allocationCount = 0;
+
+/** The total number of bytes that are currently allocated via the global operator new. */
+size_t g_liveAllocationBytes = 0;
+
+}
+
+//#################### GLOBAL FUNCTIONS ####################
+
+size_t get_allocation_count()
+{
+  return g_allocationCount;
+}
+
+size_t get_live_allocation_bytes()
+{
+  return g_liveAllocationBytes;
+}
+
+void *operator new(size_t size)
+{
+#ifdef WITH_OPENMP
+  #pragma omp atomic
+#endif
+  ++g_allocationCount;
+
+#ifdef WITH_OPENMP
+  #pragma omp atomic
+#endif
+  g_liveAllocationBytes += size;
+
+  // Record the size of the allocation in a header, so that it can be subtracted from the total when the memory is freed.
+  char *p = static_cast<char*>(malloc(HEADER_SIZE + size));
+  if(!p) throw std::bad_alloc();
+  *reinterpret_cast<size_t*>(p) = size;
+  return p + HEADER_SIZE;
+}
+
+void operator delete(void *p)
+{
+  if(!p) return;
+
+  char *header = static_cast<char*>(p) - HEADER_SIZE;
+  const size_t size = *reinterpret_cast<size_t*>(header);
+
+#ifdef WITH_OPENMP
+  #pragma omp atomic
+#endif
+  g_liveAllocationBytes -= size;
+
+  free(header);
+}
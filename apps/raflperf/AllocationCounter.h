@@ -0,0 +1,28 @@
+/**
+ * raflperf: AllocationCounter.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFLPERF_ALLOCATIONCOUNTER
+#define H_RAFLPERF_ALLOCATIONCOUNTER
+
+#include <cstddef>
+
+/**
+ * \brief Gets the number of times the global operator new has been called since the program started.
+ *
+ * Note: raflperf replaces the global operator new in order to support this. The replacement lives in its own
+ *       translation unit so that the compiler cannot inline it into (and mismatch it with) the benchmark code.
+ *
+ * \return  The number of times the global operator new has been called since the program started.
+ */
+size_t get_allocation_count();
+
+/**
+ * \brief Gets the total number of bytes that are currently allocated via the global operator new.
+ *
+ * \return  The total number of bytes that are currently allocated via the global operator new.
+ */
+size_t get_live_allocation_bytes();
+
+#endif
@@ -0,0 +1,1132 @@
+/**
+ * raflperf: Benchmarks.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+using boost::assign::list_of;
+using boost::assign::map_list_of;
+namespace bf = boost::filesystem;
+
+#include <evaluation/splitgenerators/RandomPermutationAndDivisionSplitGenerator.h>
+using namespace evaluation;
+
+#include <infermous/engines/DenseMeanFieldInferenceEngine.h>
+#include <infermous/engines/MeanFieldInferenceEngine.h>
+using namespace infermous;
+
+#include <rafl/base/DenseProbabilityMassFunction.h>
+#include <rafl/base/DescriptorArena.h>
+#include <rafl/core/CompiledForest.h>
+#include <rafl/decisionfunctions/HistogramSplitEvaluator.h>
+#include <rafl/examples/ExampleUtil.h>
+#include <rafl/examples/UnitCircleExampleGenerator.h>
+using namespace rafl;
+
+#include <raflevaluation/RandomForestEvaluator.h>
+using namespace raflevaluation;
+
+#include <tvgutil/IndexedDaryHeap.h>
+#include <tvgutil/PrefixSumUtil.h>
+#include <tvgutil/PriorityQueue.h>
+#include <tvgutil/SerializationUtil.h>
+#include <tvgutil/ThreadLocalRNG.h>
+#include <tvgutil/WordExtractor.h>
+#include <tvgutil/timing/AverageTimer.h>
+#include <tvgutil/timing/Timer.h>
+using namespace tvgutil;
+
+#include "AllocationCounter.h"
+
+//#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+
+void Benchmarks::run(const std::string& name, const std::string& examplesFilename)
+{
+  // Note: The dense PMF, example loading, mean-field, prefix sum, reservoir, random number generation and splittability queue benchmarks do not need any examples.
+  if(name == "densepmf")
+  {
+    run_dense_pmf_benchmark();
+    return;
+  }
+
+  if(name == "exampleloading")
+  {
+    run_example_loading_benchmark();
+    return;
+  }
+
+  if(name == "meanfield")
+  {
+    run_mean_field_benchmark();
+    return;
+  }
+
+  if(name == "prefixsum")
+  {
+    run_prefix_sum_benchmark();
+    return;
+  }
+
+  if(name == "reservoir")
+  {
+    run_reservoir_benchmark();
+    return;
+  }
+
+  if(name == "rngcontention")
+  {
+    run_rng_contention_benchmark();
+    return;
+  }
+
+  if(name == "splittabilityqueue")
+  {
+    run_splittability_queue_benchmark();
+    return;
+  }
+
+  std::vector<Example_CPtr> examples = make_examples(examplesFilename);
+  std::cout << "Number of examples = " << examples.size() << '\n';
+
+  if(name == "batchprediction") run_batch_prediction_benchmark(examples);
+  else if(name == "compiledforest") run_compiled_forest_benchmark(examples);
+  else if(name == "descriptorarena") run_descriptor_arena_benchmark(examples);
+  else if(name == "featureimportance") run_feature_importance_benchmark(examples);
+  else if(name == "modelload") run_model_load_benchmark(examples);
+  else if(name == "multiscale") run_multiscale_accuracy_benchmark(examples);
+  else if(name == "splitevaluation") run_split_evaluation_benchmark(examples);
+  else throw std::runtime_error("Unknown benchmark: " + name);
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+std::vector<Benchmarks::Example_CPtr> Benchmarks::make_examples(const std::string& examplesFilename)
+{
+  if(!examplesFilename.empty()) return ExampleUtil::load_examples<Label>(examplesFilename);
+
+  const unsigned int seed = 12345;
+  std::set<Label> classLabels = list_of(1)(3)(5)(7);
+  UnitCircleExampleGenerator<Label> uceg(classLabels, seed);
+  return uceg.generate_examples(classLabels, 5000);
+}
+
+Benchmarks::RandomForest_Ptr Benchmarks::make_trained_forest(const std::vector<Example_CPtr>& examples, size_t treeCount)
+{
+  // Note: These settings broadly mirror the ones used by spaintgui.
+  std::map<std::string,std::string> settings = map_list_of
+    ("candidateCount", "128")
+    ("decisionFunctionGeneratorParams", "")
+    ("decisionFunctionGeneratorType", "FeatureThresholding")
+    ("gainThreshold", "0.0")
+    ("maxClassSize", "10000")
+    ("maxTreeHeight", "20")
+    ("randomSeed", "1234")
+    ("seenExamplesThreshold", "64")
+    ("splittabilityThreshold", "0.5")
+    ("usePMFReweighting", "1");
+
+  RandomForest_Ptr forest(new RandomForest<Label>(treeCount, DecisionTree<Label>::Settings(settings)));
+  forest->add_examples(examples);
+  while(forest->train(64) > 0);
+  return forest;
+}
+
+void Benchmarks::run_batch_prediction_benchmark(const std::vector<Example_CPtr>& examples)
+{
+  const size_t treeCount = 5;
+  const int descriptorCounts[] = { 512, 8192, 65536 };
+  const int frameCount = 20;
+
+  RandomForest_Ptr forest = make_trained_forest(examples, treeCount);
+
+  size_t nodeCount = 0;
+  for(size_t i = 0; i < treeCount; ++i) nodeCount += forest->get_tree(i)->get_node_count();
+  std::cout << "Trees = " << treeCount << ", Nodes = " << nodeCount << '\n';
+
+  for(size_t d = 0; d < sizeof(descriptorCounts) / sizeof(int); ++d)
+  {
+    // Fill an arena with descriptors by cycling through the examples (as in spaintgui, there is one descriptor per sampled voxel).
+    const int descriptorCount = descriptorCounts[d];
+    const size_t featureCount = examples[0]->get_descriptor_view().size();
+    DescriptorArena arena(descriptorCount, featureCount);
+    for(int i = 0; i < descriptorCount; ++i)
+    {
+      const DescriptorView& descriptor = examples[i % examples.size()]->get_descriptor_view();
+      std::copy(descriptor.begin(), descriptor.end(), arena.get_row(i));
+    }
+
+    std::vector<Label> expectedLabels(descriptorCount), actualLabels(descriptorCount);
+    AverageTimer<boost::chrono::microseconds> predictTimer("RandomForest::predict");
+    AverageTimer<boost::chrono::microseconds> batchTimer("RandomForest::predict_batch");
+
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+      predictTimer.start();
+#ifdef WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int i = 0; i < descriptorCount; ++i)
+      {
+        expectedLabels[i] = forest->predict(arena.get_view(i));
+      }
+      predictTimer.stop();
+
+      batchTimer.start();
+      forest->predict_batch(arena, &actualLabels[0]);
+      batchTimer.stop();
+    }
+
+    if(actualLabels != expectedLabels) throw std::runtime_error("The batch predictions differ from the per-descriptor predictions");
+
+    std::cout << "\nDescriptors = " << descriptorCount << '\n';
+    std::cout << predictTimer << '\n';
+    std::cout << batchTimer << '\n';
+    std::cout << "Speed-up = " << static_cast<double>(predictTimer.average_duration().count()) / batchTimer.average_duration().count() << "x\n";
+  }
+}
+
+void Benchmarks::run_compiled_forest_benchmark(const std::vector<Example_CPtr>& examples)
+{
+  const size_t treeCount = 5;
+  const int descriptorCount = 8192;
+  const int frameCount = 50;
+
+  RandomForest_Ptr forest = make_trained_forest(examples, treeCount);
+
+  AverageTimer<boost::chrono::microseconds> compileTimer("Compile");
+  compileTimer.start();
+  CompiledForest<Label> compiledForest(*forest);
+  compileTimer.stop();
+
+  std::cout << "Trees = " << compiledForest.get_tree_count() << ", Nodes = " << compiledForest.get_node_count() << ", Labels = " << compiledForest.get_label_count() << '\n';
+  std::cout << compileTimer << '\n';
+
+  // Make a frame's worth of descriptors by cycling through the examples (as in spaintgui, there is one descriptor per sampled voxel).
+  std::vector<Descriptor_CPtr> descriptors(descriptorCount);
+  for(int i = 0; i < descriptorCount; ++i)
+  {
+    descriptors[i] = examples[i % examples.size()]->get_descriptor();
+  }
+
+  std::vector<Label> expectedLabels(descriptorCount), actualLabels(descriptorCount);
+  AverageTimer<boost::chrono::microseconds> forestTimer("RandomForest::predict");
+  AverageTimer<boost::chrono::microseconds> compiledForestTimer("CompiledForest::predict");
+
+  for(int frame = 0; frame < frameCount; ++frame)
+  {
+    forestTimer.start();
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < descriptorCount; ++i)
+    {
+      expectedLabels[i] = forest->predict(descriptors[i]);
+    }
+    forestTimer.stop();
+
+    compiledForestTimer.start();
+#ifdef WITH_OPENMP
+    #pragma omp parallel
+#endif
+    {
+      std::vector<float> masses(compiledForest.get_label_count());
+
+#ifdef WITH_OPENMP
+      #pragma omp for
+#endif
+      for(int i = 0; i < descriptorCount; ++i)
+      {
+        actualLabels[i] = compiledForest.predict(&(*descriptors[i])[0], &masses[0]);
+      }
+    }
+    compiledForestTimer.stop();
+  }
+
+  if(actualLabels != expectedLabels) throw std::runtime_error("The compiled forest's predictions differ from those of the original forest");
+
+  std::cout << forestTimer << '\n';
+  std::cout << compiledForestTimer << '\n';
+  std::cout << "Speed-up = " << static_cast<double>(forestTimer.average_duration().count()) / compiledForestTimer.average_duration().count() << "x\n";
+}
+
+void Benchmarks::run_descriptor_arena_benchmark(const std::vector<Example_CPtr>& examples)
+{
+  const size_t treeCount = 5;
+  const int descriptorCount = 8192;
+  const int frameCount = 50;
+
+  RandomForest_Ptr forest = make_trained_forest(examples, treeCount);
+
+  // Make a frame's worth of raw features by cycling through the examples (this plays the role of the feature memory block in spaintgui).
+  const size_t featureCount = examples[0]->get_descriptor_view().size();
+  std::vector<float> features(descriptorCount * featureCount);
+  for(int i = 0; i < descriptorCount; ++i)
+  {
+    const DescriptorView& view = examples[i % examples.size()]->get_descriptor_view();
+    std::copy(view.begin(), view.end(), &features[i * featureCount]);
+  }
+
+  // Note: Making the descriptors and predicting their labels are timed separately, since the latter usually dominates
+  //       the per-frame cost and is the same for both approaches (it does not allocate any descriptors).
+  std::vector<Label> expectedLabels(descriptorCount), actualLabels(descriptorCount);
+  AverageTimer<boost::chrono::microseconds> individualTimer("Making individual descriptors"), individualPredictionTimer("Prediction (individual descriptors)");
+  AverageTimer<boost::chrono::microseconds> arenaTimer("Filling descriptor arena"), arenaPredictionTimer("Prediction (descriptor arena)");
+  size_t individualAllocationCount = 0, arenaAllocationCount = 0;
+  DescriptorArena arena;
+
+  // Note: Only the allocations made whilst making the descriptors are counted, since prediction itself allocates in the same way for both.
+  for(int frame = 0; frame < frameCount; ++frame)
+  {
+    // Make an individual descriptor for each voxel and predict its label.
+    individualTimer.start();
+    size_t allocationCountBefore = get_allocation_count();
+    std::vector<Descriptor_CPtr> descriptors(descriptorCount);
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < descriptorCount; ++i)
+    {
+      const float *featuresForDescriptor = &features[i * featureCount];
+      descriptors[i].reset(new Descriptor(featuresForDescriptor, featuresForDescriptor + featureCount));
+    }
+
+    individualAllocationCount += get_allocation_count() - allocationCountBefore;
+    individualTimer.stop();
+
+    individualPredictionTimer.start();
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < descriptorCount; ++i)
+    {
+      expectedLabels[i] = forest->predict(descriptors[i]);
+    }
+
+    individualPredictionTimer.stop();
+
+    // Copy the descriptors into the (reused) arena and predict the labels via views.
+    arenaTimer.start();
+    allocationCountBefore = get_allocation_count();
+    arena.resize(descriptorCount, featureCount);
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < descriptorCount; ++i)
+    {
+      const float *featuresForDescriptor = &features[i * featureCount];
+      std::copy(featuresForDescriptor, featuresForDescriptor + featureCount, arena.get_row(i));
+    }
+
+    arenaAllocationCount += get_allocation_count() - allocationCountBefore;
+    arenaTimer.stop();
+
+    arenaPredictionTimer.start();
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < descriptorCount; ++i)
+    {
+      actualLabels[i] = forest->predict(arena.get_view(i));
+    }
+
+    arenaPredictionTimer.stop();
+  }
+
+  if(actualLabels != expectedLabels) throw std::runtime_error("The predictions made using the descriptor arena differ from those made using individual descriptors");
+
+  std::cout << "Descriptor allocations per frame (individual) = " << static_cast<double>(individualAllocationCount) / frameCount << '\n';
+  std::cout << "Descriptor allocations per frame (arena) = " << static_cast<double>(arenaAllocationCount) / frameCount << '\n';
+  std::cout << individualTimer << '\n';
+  std::cout << arenaTimer << '\n';
+  std::cout << individualPredictionTimer << '\n';
+  std::cout << arenaPredictionTimer << '\n';
+
+  const double individualTotal = static_cast<double>(individualTimer.average_duration().count() + individualPredictionTimer.average_duration().count());
+  const double arenaTotal = static_cast<double>(arenaTimer.average_duration().count() + arenaPredictionTimer.average_duration().count());
+  std::cout << "Speed-up (making descriptors) = " << static_cast<double>(individualTimer.average_duration().count()) / arenaTimer.average_duration().count() << "x\n";
+  std::cout << "Speed-up (whole frame) = " << individualTotal / arenaTotal << "x\n";
+  std::cout << "Fraction of frame spent on prediction (arena) = " << arenaPredictionTimer.average_duration().count() / arenaTotal << '\n';
+}
+
+void Benchmarks::run_dense_pmf_benchmark()
+{
+  const int leafSizes[] = { 5, 100 };
+  const int labelCountsPerLeafSize = 6;
+  const int runCount = 20000;
+  const int treeCount = 8;
+
+  // Try label counts from 2 to 64 with both small and large leaves (the dense containers should do best when the leaves contain most of the labels).
+  ThreadLocalRNG rng(1234, 1);
+  for(int config = 0; config < 2 * labelCountsPerLeafSize; ++config)
+  {
+    const int examplesPerLeaf = leafSizes[config / labelCountsPerLeafSize];
+    const int labelCount = 2 << (config % labelCountsPerLeafSize);
+
+    // Generate the labels of the examples in the leaves that a descriptor reaches in each tree, together with some per-class multipliers.
+    std::vector<std::vector<Label> > leafLabels(treeCount);
+    for(int t = 0; t < treeCount; ++t)
+    {
+      for(int i = 0; i < examplesPerLeaf; ++i) leafLabels[t].push_back(rng.generate_int_from_uniform(0, labelCount - 1));
+    }
+
+    std::map<Label,float> multipliers;
+    for(Label label = 0; label < labelCount; ++label) multipliers[label] = rng.generate_real_from_uniform<float>(0.5f, 2.0f);
+
+    // Repeatedly build a histogram and PMF for each leaf, calculate their entropies, and combine the PMFs into a forest PMF, using map-based containers.
+    Label bestLabel = 0;
+    float entropy = 0.0f;
+    AverageTimer<boost::chrono::microseconds> mapTimer("Map-based");
+    mapTimer.start();
+    for(int run = 0; run < runCount; ++run)
+    {
+      std::map<Label,float> masses;
+      for(int t = 0; t < treeCount; ++t)
+      {
+        Histogram<Label> histogram;
+        for(int i = 0; i < examplesPerLeaf; ++i) histogram.add(leafLabels[t][i]);
+
+        ProbabilityMassFunction<Label> pmf(histogram, multipliers);
+        entropy += pmf.calculate_entropy();
+
+        const std::map<Label,float>& leafMasses = pmf.get_masses();
+        for(std::map<Label,float>::const_iterator it = leafMasses.begin(), iend = leafMasses.end(); it != iend; ++it)
+        {
+          masses[it->first] += it->second;
+        }
+      }
+
+      bestLabel += ProbabilityMassFunction<Label>(masses).calculate_best_label();
+    }
+    mapTimer.stop();
+
+    // Do the same using the dense containers.
+    Label denseBestLabel = 0;
+    float denseEntropy = 0.0f;
+    AverageTimer<boost::chrono::microseconds> denseTimer("Dense");
+    denseTimer.start();
+    for(int run = 0; run < runCount; ++run)
+    {
+      std::vector<float> masses(labelCount, 0.0f);
+      for(int t = 0; t < treeCount; ++t)
+      {
+        DenseHistogram<Label> histogram(labelCount);
+        for(int i = 0; i < examplesPerLeaf; ++i) histogram.add(leafLabels[t][i]);
+
+        DenseProbabilityMassFunction<Label> pmf(histogram, multipliers);
+        denseEntropy += pmf.calculate_entropy();
+
+        const std::vector<float>& leafMasses = pmf.get_dense_masses();
+        for(size_t k = 0, size = leafMasses.size(); k < size; ++k)
+        {
+          masses[k] += leafMasses[k];
+        }
+      }
+
+      denseBestLabel += DenseProbabilityMassFunction<Label>(masses).calculate_best_label();
+    }
+    denseTimer.stop();
+
+    if(denseBestLabel != bestLabel || denseEntropy != entropy) throw std::runtime_error("The dense PMFs differ from the map-based ones");
+
+    std::cout << "\nExamples per leaf = " << examplesPerLeaf << ", Labels = " << labelCount << '\n';
+    std::cout << mapTimer << '\n';
+    std::cout << denseTimer << '\n';
+    std::cout << "Speed-up = " << static_cast<double>(mapTimer.average_duration().count()) / denseTimer.average_duration().count() << "x\n";
+  }
+}
+
+void Benchmarks::run_example_loading_benchmark()
+{
+  const int exampleCount = 1000000;
+  const int featureCount = 8;
+  const size_t chunkSize = 65536;
+
+  // Generate a file of random examples.
+  bf::path path = bf::temp_directory_path() / bf::unique_path("%%%%-%%%%-%%%%.csv");
+  {
+    std::ofstream fs(path.string().c_str());
+    RandomNumberGenerator rng(12345);
+    char buffer[32];
+    for(int i = 0; i < exampleCount; ++i)
+    {
+      for(int j = 0; j < featureCount; ++j)
+      {
+        sprintf(buffer, "%g,", rng.generate_real_from_uniform<float>(-1.0f, 1.0f));
+        fs << buffer;
+      }
+      fs << rng.generate_int_from_uniform(0, 9) << '\n';
+    }
+  }
+
+  const double fileSizeMB = bf::file_size(path) / (1024.0 * 1024.0);
+  std::cout << "Examples = " << exampleCount << ", Features = " << featureCount << ", File size = " << fileSizeMB << " MB\n";
+
+  // Load the file using the original approach, which splits it into lines of words and then converts each word using boost::lexical_cast.
+  Timer<boost::chrono::milliseconds> wordTimer("WordExtractor + lexical_cast");
+  size_t wordLabelSum = 0;
+  {
+    std::ifstream fs(path.string().c_str());
+    std::vector<std::vector<std::string> > wordLines = WordExtractor::extract_word_lines(fs, ", \r");
+    std::vector<Example_CPtr> examples;
+    for(size_t i = 0, lineCount = wordLines.size(); i < lineCount; ++i)
+    {
+      const std::vector<std::string>& words = wordLines[i];
+      Descriptor_Ptr descriptor(new Descriptor);
+      for(size_t j = 0; j < words.size() - 1; ++j)
+      {
+        descriptor->push_back(boost::lexical_cast<float>(words[j]));
+      }
+      examples.push_back(Example_CPtr(new Example<Label>(descriptor, boost::lexical_cast<Label>(words.back()))));
+    }
+    for(size_t i = 0, size = examples.size(); i < size; ++i) wordLabelSum += examples[i]->get_label();
+  }
+  wordTimer.stop();
+
+  // Load the file using the streaming loader.
+  Timer<boost::chrono::milliseconds> streamingTimer("ExampleUtil::load_examples");
+  size_t streamingLabelSum = 0;
+  {
+    std::vector<Example_CPtr> examples = ExampleUtil::load_examples<Label>(path.string());
+    for(size_t i = 0, size = examples.size(); i < size; ++i) streamingLabelSum += examples[i]->get_label();
+  }
+  streamingTimer.stop();
+
+  // Process the file in chunks, as would be needed for a file that is too large to fit in memory.
+  Timer<boost::chrono::milliseconds> chunkedTimer("ExampleFileReader::read_chunk");
+  size_t chunkedLabelSum = 0;
+  {
+    ExampleFileReader<Label> reader(path.string());
+    for(std::vector<Example_CPtr> chunk = reader.read_chunk(chunkSize); !chunk.empty(); chunk = reader.read_chunk(chunkSize))
+    {
+      for(size_t i = 0, size = chunk.size(); i < size; ++i) chunkedLabelSum += chunk[i]->get_label();
+    }
+  }
+  chunkedTimer.stop();
+
+  bf::remove(path);
+
+  if(streamingLabelSum != wordLabelSum || chunkedLabelSum != wordLabelSum)
+  {
+    throw std::runtime_error("The streaming loaders produced different examples from the word-based loader");
+  }
+
+  const Timer<boost::chrono::milliseconds> *timers[] = { &wordTimer, &streamingTimer, &chunkedTimer };
+  for(size_t i = 0; i < sizeof(timers) / sizeof(timers[0]); ++i)
+  {
+    std::cout << *timers[i] << " (" << fileSizeMB / (timers[i]->duration().count() / 1000.0) << " MB/s)\n";
+  }
+  std::cout << "Speed-up = " << static_cast<double>(wordTimer.duration().count()) / streamingTimer.duration().count() << "x\n";
+}
+
+void Benchmarks::run_feature_importance_benchmark(const std::vector<Example_CPtr>& examples)
+{
+  const size_t treeCount = 5;
+  const size_t reportedFeatureCount = 20;
+
+  RandomForest_Ptr forest = make_trained_forest(examples, treeCount);
+  FeatureImportanceTracker_Ptr tracker = forest->get_feature_importance_tracker();
+  const size_t featureCount = examples[0]->get_descriptor_view().size();
+  std::vector<size_t> usedFeatureIndices = forest->get_used_feature_indices();
+
+  // Every split that was made while training should still be in the forest, so the tracker should agree with the trees.
+  if(tracker->get_used_feature_indices() != usedFeatureIndices)
+  {
+    throw std::runtime_error("The features recorded by the feature importance tracker differ from those used by the trees");
+  }
+
+  size_t splitCount = 0;
+  std::vector<std::pair<double,size_t> > gains;
+  for(size_t i = 0, size = usedFeatureIndices.size(); i < size; ++i)
+  {
+    splitCount += tracker->get_split_count(usedFeatureIndices[i]);
+    gains.push_back(std::make_pair(tracker->get_gain(usedFeatureIndices[i]), usedFeatureIndices[i]));
+  }
+  std::sort(gains.begin(), gains.end(), std::greater<std::pair<double,size_t> >());
+
+  std::cout << "Trees = " << treeCount << ", Splits = " << splitCount << '\n';
+  std::cout << "Features used = " << usedFeatureIndices.size() << " of " << featureCount
+            << " (" << 100.0 * usedFeatureIndices.size() / featureCount << "%)\n";
+
+  std::cout << "\nFeature\tSplits\tTotal Gain\n";
+  for(size_t i = 0, size = std::min(gains.size(), reportedFeatureCount); i < size; ++i)
+  {
+    std::cout << gains[i].second << '\t' << tracker->get_split_count(gains[i].second) << '\t' << gains[i].first << '\n';
+  }
+
+  // Check that the forest makes the same predictions for pruned copies of the descriptors, in which the unused features are zeroed.
+  const size_t descriptorCount = examples.size();
+  DescriptorArena fullArena(descriptorCount, featureCount), prunedArena(descriptorCount, featureCount);
+  for(size_t i = 0; i < descriptorCount; ++i)
+  {
+    const DescriptorView& descriptor = examples[i]->get_descriptor_view();
+    std::copy(descriptor.begin(), descriptor.end(), fullArena.get_row(i));
+
+    float *prunedRow = prunedArena.get_row(i);
+    std::fill(prunedRow, prunedRow + featureCount, 0.0f);
+    for(size_t j = 0, size = usedFeatureIndices.size(); j < size; ++j)
+    {
+      prunedRow[usedFeatureIndices[j]] = descriptor[usedFeatureIndices[j]];
+    }
+  }
+
+  std::vector<Label> fullLabels(descriptorCount), prunedLabels(descriptorCount);
+  forest->predict_batch(fullArena, &fullLabels[0]);
+  forest->predict_batch(prunedArena, &prunedLabels[0]);
+  if(prunedLabels != fullLabels) throw std::runtime_error("The predictions for the pruned descriptors differ from those for the full descriptors");
+
+  std::cout << "\nPredictions for " << descriptorCount << " pruned descriptors match those for the full descriptors\n";
+}
+
+void Benchmarks::run_mean_field_benchmark()
+{
+  const int labelCount = 5;
+  const std::vector<Eigen::Vector2i> neighbourOffsets = CRFUtil::make_circular_neighbour_offsets(2);
+  const size_t iterations = 3;
+  const int sizes[][2] = { {30, 40}, {60, 80}, {120, 160}, {240, 320} };
+  const int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+
+  // Use a Potts model for the pairwise potentials.
+  struct PottsPPC : PairwisePotentialCalculator<Label>
+  {
+    virtual float calculate_potential(const Label& l1, const Label& l2) const
+    {
+      return l1 == l2 ? 0.0f : 0.1f;
+    }
+  };
+  PairwisePotentialCalculator_CPtr<Label> ppc(new PottsPPC);
+
+  std::cout << "Labels = " << labelCount << ", Neighbours = " << neighbourOffsets.size() << ", Iterations = " << iterations << '\n';
+
+  ThreadLocalRNG rng(1234, 1);
+  for(int s = 0; s < sizeCount; ++s)
+  {
+    const int height = sizes[s][0], width = sizes[s][1];
+
+    // Make a grid of random unaries.
+    ProbabilitiesGrid_Ptr<Label> unaries(new ProbabilitiesGrid<Label>(height, width));
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        std::map<Label,float>& psi_i = (*unaries)(y, x);
+        float sum = 0.0f;
+        for(int k = 0; k < labelCount; ++k) sum += psi_i[k] = rng.generate_real_from_uniform<float>(0.05f, 1.0f);
+        for(int k = 0; k < labelCount; ++k) psi_i[k] /= sum;
+      }
+    }
+
+    // Run both inference engines on identical CRFs.
+    CRF2D_Ptr<Label> crf(new CRF2D<Label>(ProbabilitiesGrid_Ptr<Label>(new ProbabilitiesGrid<Label>(*unaries)), ppc));
+    MeanFieldInferenceEngine<Label> engine(crf, neighbourOffsets);
+    AverageTimer<boost::chrono::microseconds> mapTimer("Map-based");
+    mapTimer.start();
+    engine.update_crf(iterations);
+    mapTimer.stop();
+
+    CRF2D_Ptr<Label> denseCRF(new CRF2D<Label>(unaries, ppc));
+    DenseMeanFieldInferenceEngine<Label> denseEngine(denseCRF, neighbourOffsets);
+    AverageTimer<boost::chrono::microseconds> denseTimer("Dense");
+    denseTimer.start();
+    denseEngine.update_crf(iterations);
+    denseTimer.stop();
+
+    // Check that the two engines produced the same marginals.
+    float maxDifference = 0.0f;
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const std::map<Label,float>& Q_i = crf->get_marginals_at(Eigen::Vector2i(x, y));
+        const std::map<Label,float>& denseQ_i = denseCRF->get_marginals_at(Eigen::Vector2i(x, y));
+        for(int k = 0; k < labelCount; ++k)
+        {
+          maxDifference = std::max(maxDifference, fabsf(Q_i.find(k)->second - denseQ_i.find(k)->second));
+        }
+      }
+    }
+
+    if(maxDifference > 1e-4f) throw std::runtime_error("The marginals calculated by the dense mean-field inference engine differ from those of the map-based one");
+
+    std::cout << "\nGrid size = " << width << 'x' << height << '\n';
+    std::cout << mapTimer << '\n';
+    std::cout << denseTimer << '\n';
+    std::cout << "Speed-up = " << static_cast<double>(mapTimer.average_duration().count()) / denseTimer.average_duration().count() << "x\n";
+  }
+}
+
+void Benchmarks::run_model_load_benchmark(const std::vector<Example_CPtr>& examples)
+{
+  const size_t treeCount = 5;
+  const int loadCount = 10;
+
+  // Save the forest both using Boost serialization and as a binary model.
+  RandomForest_Ptr forest = make_trained_forest(examples, treeCount);
+  bf::path forestPath = bf::temp_directory_path() / bf::unique_path("%%%%-%%%%-%%%%.rf");
+  bf::path modelPath = bf::temp_directory_path() / bf::unique_path("%%%%-%%%%-%%%%.rfb");
+  SerializationUtil::save_text(forestPath.string(), *forest);
+  CompiledForest<Label>(*forest).save_binary(modelPath.string());
+
+  std::cout << "Trees = " << treeCount << ", Text archive size = " << bf::file_size(forestPath) << " bytes, Binary model size = " << bf::file_size(modelPath) << " bytes\n";
+
+  AverageTimer<boost::chrono::microseconds> textTimer("SerializationUtil::load_text + compile");
+  AverageTimer<boost::chrono::microseconds> binaryTimer("CompiledForest::load_binary");
+  boost::shared_ptr<const CompiledForest<Label> > textForest, binaryForest;
+
+  for(int i = 0; i < loadCount; ++i)
+  {
+    textTimer.start();
+    RandomForest_Ptr loadedForest = SerializationUtil::load_text(forestPath.string(), loadedForest);
+    textForest.reset(new CompiledForest<Label>(*loadedForest));
+    textTimer.stop();
+
+    binaryTimer.start();
+    binaryForest = CompiledForest<Label>::load_binary(modelPath.string());
+    binaryTimer.stop();
+  }
+
+  // Check that the two loaded forests make the same predictions (this also touches the mapped pages of the binary model).
+  for(size_t i = 0, size = examples.size(); i < size; ++i)
+  {
+    if(binaryForest->predict(examples[i]->get_descriptor()) != textForest->predict(examples[i]->get_descriptor()))
+    {
+      throw std::runtime_error("The binary model's predictions differ from those of the forest loaded using Boost serialization");
+    }
+  }
+
+  bf::remove(forestPath);
+  bf::remove(modelPath);
+
+  std::cout << textTimer << '\n';
+  std::cout << binaryTimer << '\n';
+  std::cout << "Speed-up = " << static_cast<double>(textTimer.average_duration().count()) / binaryTimer.average_duration().count() << "x\n";
+}
+
+void Benchmarks::run_multiscale_accuracy_benchmark(const std::vector<Example_CPtr>& examples)
+{
+  const unsigned int seed = 12345;
+  const size_t treeCounts[] = { 2, 8 };
+
+  // Infer the layout of the descriptors. A multi-scale descriptor consists of scaleCount patches of patchSize * patchSize CIELab values,
+  // followed by a normal and a height, so its size minus 4 must be 3 * scaleCount * patchSize^2. For two or three scales, at most one
+  // odd patch size can satisfy this (since neither 3/2 nor 2/3 is the square of a rational number), so the layout is unambiguous.
+  const size_t featureCount = examples[0]->get_descriptor_view().size();
+  size_t patchSize = 0, scaleCount = 0;
+  for(size_t candidateScaleCount = 2; candidateScaleCount <= 3; ++candidateScaleCount)
+  {
+    if(featureCount < 4 || (featureCount - 4) % (3 * candidateScaleCount) != 0) continue;
+    const size_t patchArea = (featureCount - 4) / (3 * candidateScaleCount);
+    const size_t candidatePatchSize = static_cast<size_t>(sqrt(static_cast<double>(patchArea)) + 0.5);
+    if(candidatePatchSize * candidatePatchSize == patchArea && candidatePatchSize % 2 == 1)
+    {
+      patchSize = candidatePatchSize;
+      scaleCount = candidateScaleCount;
+    }
+  }
+
+  if(scaleCount == 0)
+  {
+    throw std::runtime_error("Error: Descriptors with " + boost::lexical_cast<std::string>(featureCount) + " features do not have a multi-scale VOP layout with two or three scales");
+  }
+
+  std::cout << "Patch size = " << patchSize << ", Scales = " << scaleCount << '\n';
+
+  // Make the single-scale equivalents of the examples by keeping only the first patch, the normal and the height of each descriptor.
+  const size_t patchFeatureCount = patchSize * patchSize * 3;
+  const size_t singleScaleFeatureCount = patchFeatureCount + 4;
+  std::vector<float> singleScaleFeatures(examples.size() * singleScaleFeatureCount);
+  std::vector<Label> labels(examples.size());
+  for(size_t i = 0, size = examples.size(); i < size; ++i)
+  {
+    const DescriptorView& descriptor = examples[i]->get_descriptor_view();
+    float *singleScaleDescriptor = &singleScaleFeatures[i * singleScaleFeatureCount];
+    std::copy(descriptor.begin(), descriptor.begin() + patchFeatureCount, singleScaleDescriptor);
+    std::copy(descriptor.end() - 4, descriptor.end(), singleScaleDescriptor + patchFeatureCount);
+    labels[i] = examples[i]->get_label();
+  }
+
+  std::vector<Example_CPtr> singleScaleExamples = ExampleFileReader<Label>::make_examples(singleScaleFeatures, labels, examples.size(), singleScaleFeatureCount);
+
+  // Evaluate forests of various sizes on both sets of examples, using the same splits for each.
+  SplitGenerator_Ptr splitGenerator(new RandomPermutationAndDivisionSplitGenerator(seed, 5, 0.5f));
+  for(size_t t = 0; t < sizeof(treeCounts) / sizeof(size_t); ++t)
+  {
+    // Note: These settings broadly mirror the ones used by spaintgui.
+    std::map<std::string,std::string> settings = map_list_of
+      ("candidateCount", "128")
+      ("decisionFunctionGeneratorParams", "")
+      ("decisionFunctionGeneratorType", "FeatureThresholding")
+      ("gainThreshold", "0.0")
+      ("maxClassSize", "10000")
+      ("maxTreeHeight", "20")
+      ("randomSeed", "1234")
+      ("seenExamplesThreshold", "64")
+      ("splitBudget", "1048576")
+      ("splittabilityThreshold", "0.5")
+      ("usePMFReweighting", "1");
+    settings["treeCount"] = boost::lexical_cast<std::string>(treeCounts[t]);
+
+    RandomForestEvaluator<Label> evaluator(splitGenerator, settings);
+    std::map<std::string,PerformanceMeasure> singleScaleResults = evaluator.evaluate(singleScaleExamples);
+    std::map<std::string,PerformanceMeasure> multiScaleResults = evaluator.evaluate(examples);
+
+    std::cout << "\nTrees = " << treeCounts[t] << '\n';
+    std::cout << "Single-scale accuracy = " << singleScaleResults.find("Accuracy")->second << '\n';
+    std::cout << "Multi-scale accuracy = " << multiScaleResults.find("Accuracy")->second << '\n';
+  }
+}
+
+void Benchmarks::run_prefix_sum_benchmark()
+{
+  // Make a set of random voxel masks of the kind used when sampling voxels for each label from a 640x480 raycast result.
+  const int labelCount = 10;
+  const int maskLength = 640 * 480 + 1;
+  const int runCount = 20;
+
+  std::vector<unsigned char> masks(labelCount * maskLength);
+  ThreadLocalRNG rng(1234, 1);
+  for(size_t i = 0, size = masks.size(); i < size; ++i)
+  {
+    masks[i] = rng.generate_int_from_uniform(0, 9) == 0 ? 1 : 0;
+  }
+
+  std::vector<int> labels;
+  for(int k = 0; k < labelCount; ++k) labels.push_back(k);
+
+  // Calculate the prefix sums serially, one label at a time.
+  std::vector<unsigned int> serialPrefixSums(masks.size());
+  AverageTimer<boost::chrono::microseconds> serialTimer("Serial");
+  for(int run = 0; run < runCount; ++run)
+  {
+    serialTimer.start();
+    for(int k = 0; k < labelCount; ++k)
+    {
+      const size_t offset = k * maskLength;
+      serialPrefixSums[offset] = 0;
+      for(int i = 1; i < maskLength; ++i)
+      {
+        serialPrefixSums[offset + i] = serialPrefixSums[offset + (i - 1)] + masks[offset + (i - 1)];
+      }
+    }
+    serialTimer.stop();
+  }
+
+  std::cout << "Labels = " << labelCount << ", Mask length = " << maskLength << '\n';
+  std::cout << serialTimer << '\n';
+
+  // Calculate the prefix sums for all of the labels together, using increasing numbers of threads.
+#ifdef WITH_OPENMP
+  const int maxThreadCount = omp_get_max_threads();
+#else
+  const int maxThreadCount = 1;
+#endif
+
+  for(int threadCount = 1; threadCount <= maxThreadCount; ++threadCount)
+  {
+#ifdef WITH_OPENMP
+    omp_set_num_threads(threadCount);
+#endif
+
+    std::vector<unsigned int> parallelPrefixSums(masks.size());
+    AverageTimer<boost::chrono::microseconds> parallelTimer("Parallel (" + boost::lexical_cast<std::string>(threadCount) + " threads)");
+    for(int run = 0; run < runCount; ++run)
+    {
+      parallelTimer.start();
+      PrefixSumUtil::calculate_exclusive_prefix_sums(&masks[0], &parallelPrefixSums[0], maskLength, labels);
+      parallelTimer.stop();
+    }
+
+    if(parallelPrefixSums != serialPrefixSums) throw std::runtime_error("The parallel prefix sums differ from the serial ones");
+
+    std::cout << parallelTimer << '\n';
+    std::cout << "Speed-up = " << static_cast<double>(serialTimer.average_duration().count()) / parallelTimer.average_duration().count() << "x\n";
+  }
+
+#ifdef WITH_OPENMP
+  omp_set_num_threads(maxThreadCount);
+#endif
+}
+
+void Benchmarks::run_reservoir_benchmark()
+{
+  const size_t exampleCount = 1000000;
+  const int labelCount = 10;
+  const size_t maxClassSize = 100;
+  const size_t reservoirCount = 1000;
+
+  // Make the examples, storing their descriptors in a shared arena so that they contribute as little as possible to the memory used.
+  ThreadLocalRNG rng(1234, 1);
+  boost::shared_ptr<DescriptorArena> arena(new DescriptorArena(exampleCount, 2));
+  std::vector<Example_CPtr> examples(exampleCount);
+  std::vector<size_t> reservoirIndices(exampleCount);
+  for(size_t i = 0; i < exampleCount; ++i)
+  {
+    examples[i].reset(new Example<Label>(arena, i, rng.generate_int_from_uniform(0, labelCount - 1)));
+    reservoirIndices[i] = rng.generate_int_from_uniform(0, static_cast<int>(reservoirCount) - 1);
+  }
+
+  // Make the reservoirs, as would be done for the leaves of a forest.
+  const size_t initialBytes = get_live_allocation_bytes();
+  tvgutil::RandomNumberGenerator_Ptr reservoirRNG(new tvgutil::RandomNumberGenerator(1234));
+  std::vector<ExampleReservoir<Label> > reservoirs;
+  reservoirs.reserve(reservoirCount);
+  for(size_t i = 0; i < reservoirCount; ++i)
+  {
+    reservoirs.push_back(ExampleReservoir<Label>(maxClassSize, reservoirRNG));
+  }
+
+  // Add the examples to the reservoirs until they are (almost) full.
+  AverageTimer<boost::chrono::milliseconds> fillTimer("Filling");
+  fillTimer.start();
+  for(size_t i = 0; i < exampleCount; ++i)
+  {
+    reservoirs[reservoirIndices[i]].add_example(examples[i]);
+  }
+  fillTimer.stop();
+
+  size_t storedExampleCount = 0;
+  for(size_t i = 0; i < reservoirCount; ++i)
+  {
+    storedExampleCount += reservoirs[i].current_size();
+  }
+  const size_t reservoirBytes = get_live_allocation_bytes() - initialBytes;
+
+  // Add the examples to the reservoirs again, so that they have to decide whether or not to replace existing examples.
+  const size_t initialAllocationCount = get_allocation_count();
+  AverageTimer<boost::chrono::milliseconds> churnTimer("Churning");
+  churnTimer.start();
+  for(size_t i = 0; i < exampleCount; ++i)
+  {
+    reservoirs[reservoirIndices[i]].add_example(examples[i]);
+  }
+  churnTimer.stop();
+  const size_t churnAllocationCount = get_allocation_count() - initialAllocationCount;
+
+  std::cout << "Examples = " << exampleCount << ", Reservoirs = " << reservoirCount << ", Labels = " << labelCount << ", Max class size = " << maxClassSize << '\n';
+  std::cout << "Stored examples = " << storedExampleCount << '\n';
+  std::cout << "Reservoir memory = " << reservoirBytes / 1024 << " KB (" << static_cast<double>(reservoirBytes) / storedExampleCount << " bytes per stored example)\n";
+  std::cout << fillTimer << '\n';
+  std::cout << churnTimer << '\n';
+  std::cout << "Allocations whilst churning = " << churnAllocationCount << '\n';
+}
+
+void Benchmarks::run_rng_contention_benchmark()
+{
+  const int numberCount = 1 << 22;
+  const int runCount = 10;
+  const unsigned int seed = 1234;
+
+  std::vector<int> numbers(numberCount);
+  RandomNumberGenerator sharedRNG(seed);
+  ThreadLocalRNG threadLocalRNG(seed);
+
+  AverageTimer<boost::chrono::microseconds> sharedTimer("RandomNumberGenerator (shared)");
+  AverageTimer<boost::chrono::microseconds> threadLocalTimer("ThreadLocalRNG");
+
+  for(int run = 0; run < runCount; ++run)
+  {
+    sharedTimer.start();
+#ifdef WITH_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for(int i = 0; i < numberCount; ++i)
+    {
+      numbers[i] = sharedRNG.generate_int_from_uniform(0, numberCount - 1);
+    }
+    sharedTimer.stop();
+
+    threadLocalTimer.start();
+#ifdef WITH_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for(int i = 0; i < numberCount; ++i)
+    {
+      numbers[i] = threadLocalRNG.generate_int_from_uniform(0, numberCount - 1);
+    }
+    threadLocalTimer.stop();
+  }
+
+  std::cout << "Numbers per run = " << numberCount << ", Streams = " << threadLocalRNG.get_stream_count() << '\n';
+  std::cout << sharedTimer << '\n';
+  std::cout << threadLocalTimer << '\n';
+  std::cout << "Speed-up = " << static_cast<double>(sharedTimer.average_duration().count()) / threadLocalTimer.average_duration().count() << "x\n";
+}
+
+void Benchmarks::run_split_evaluation_benchmark(const std::vector<Example_CPtr>& examples)
+{
+  const int candidateCount = 128;
+  const size_t maxClassSize = 10000;
+  const int runCount = 10;
+  tvgutil::RandomNumberGenerator_Ptr rng(new tvgutil::RandomNumberGenerator(1234));
+
+  // Fill a reservoir with the examples, as would happen for a node in a tree.
+  ExampleReservoir<Label> reservoir(maxClassSize, rng);
+  for(size_t i = 0, size = examples.size(); i < size; ++i)
+  {
+    reservoir.add_example(examples[i]);
+  }
+
+  std::vector<Example_CPtr> reservoirExamples = reservoir.get_examples();
+  std::map<Label,float> multipliers = reservoir.get_class_multipliers();
+  float initialEntropy = ExampleUtil::calculate_entropy(*reservoir.get_histogram());
+  float exampleCount = static_cast<float>(reservoirExamples.size());
+  std::cout << "Reservoir size = " << reservoirExamples.size() << '\n';
+
+  const std::string generatorTypes[] = { "FeatureThresholding", "PairwiseOpAndThreshold" };
+  for(size_t g = 0; g < sizeof(generatorTypes) / sizeof(std::string); ++g)
+  {
+    DecisionTree<Label>::DecisionFunctionGenerator_CPtr generator = DecisionFunctionGeneratorFactory<Label>::instance().make(generatorTypes[g], "");
+
+    std::vector<DecisionFunction_Ptr> candidates(candidateCount);
+    for(int i = 0; i < candidateCount; ++i)
+    {
+      candidates[i] = generator->generate_candidate_decision_function(reservoirExamples, rng);
+    }
+
+    // Evaluate the candidates by explicitly partitioning the examples and building a histogram for each half.
+    std::vector<float> expectedGains(candidateCount);
+    AverageTimer<boost::chrono::microseconds> partitionTimer("Partition-based evaluation");
+    for(int run = 0; run < runCount; ++run)
+    {
+      partitionTimer.start();
+#ifdef WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int i = 0; i < candidateCount; ++i)
+      {
+        std::vector<Example_CPtr> leftExamples, rightExamples;
+        for(size_t j = 0, size = reservoirExamples.size(); j < size; ++j)
+        {
+          if(candidates[i]->classify_descriptor(*reservoirExamples[j]->get_descriptor()) == DecisionFunction::DC_LEFT) leftExamples.push_back(reservoirExamples[j]);
+          else rightExamples.push_back(reservoirExamples[j]);
+        }
+
+        float leftEntropy = ExampleUtil::calculate_entropy(leftExamples, multipliers);
+        float rightEntropy = ExampleUtil::calculate_entropy(rightExamples, multipliers);
+        float leftWeight = leftExamples.size() / exampleCount;
+        float rightWeight = rightExamples.size() / exampleCount;
+        expectedGains[i] = initialEntropy - (leftWeight * leftEntropy + rightWeight * rightEntropy);
+      }
+      partitionTimer.stop();
+    }
+
+    // Evaluate the candidates using the histogram-based split evaluator.
+    std::vector<HistogramSplitEvaluator<Label>::Evaluation> evaluations;
+    AverageTimer<boost::chrono::microseconds> histogramTimer("Histogram-based evaluation");
+    for(int run = 0; run < runCount; ++run)
+    {
+      histogramTimer.start();
+      HistogramSplitEvaluator<Label> evaluator(reservoirExamples, multipliers);
+      evaluations = evaluator.evaluate(candidates, initialEntropy);
+      histogramTimer.stop();
+    }
+
+    // Compare the gains.
+    int mismatchCount = 0;
+    float maxDifference = 0.0f;
+    for(int i = 0; i < candidateCount; ++i)
+    {
+      if(evaluations[i].m_gain != expectedGains[i]) ++mismatchCount;
+      maxDifference = std::max(maxDifference, fabsf(evaluations[i].m_gain - expectedGains[i]));
+    }
+
+    std::cout << '\n' << generatorTypes[g] << ":\n";
+    std::cout << "Gain mismatches = " << mismatchCount << '/' << candidateCount << ", Max. difference = " << maxDifference << '\n';
+    std::cout << partitionTimer << '\n';
+    std::cout << histogramTimer << '\n';
+    std::cout << "Speed-up = " << static_cast<double>(partitionTimer.average_duration().count()) / histogramTimer.average_duration().count() << "x\n";
+  }
+}
+
+void Benchmarks::run_splittability_queue_benchmark()
+{
+  typedef IndexedDaryHeap<int,float,signed char,std::greater<float> > Heap;
+  typedef PriorityQueue<int,float,signed char,std::greater<float> > PQ;
+
+  const int nodeCount = 100000;
+  const int roundCount = 50;
+  const size_t splitBudget = 64;
+  const int dirtyFractions[] = { 100, 10 };
+
+  for(size_t f = 0; f < sizeof(dirtyFractions) / sizeof(int); ++f)
+  {
+    // Simulate a sequence of training rounds, as in DecisionTree: in each round, recalculate the splittabilities of a random subset
+    // of the nodes (those to which examples have been added), and then pop the best nodes (as if splitting them) and re-add them.
+    const int dirtyCount = nodeCount / dirtyFractions[f];
+    std::vector<std::vector<int> > dirtyNodes(roundCount);
+    std::vector<std::vector<float> > splittabilities(roundCount);
+    RandomNumberGenerator rng(12345);
+    for(int round = 0; round < roundCount; ++round)
+    {
+      std::set<int> nodes;
+      while(static_cast<int>(nodes.size()) < dirtyCount) nodes.insert(rng.generate_int_from_uniform(0, nodeCount - 1));
+      dirtyNodes[round].assign(nodes.begin(), nodes.end());
+      for(int i = 0; i < dirtyCount; ++i) splittabilities[round].push_back(rng.generate_real_from_uniform<float>(0.0f, 2.0f));
+    }
+
+    PQ pq;
+    Heap heap;
+    const signed char nullData = -1;
+    for(int i = 0; i < nodeCount; ++i)
+    {
+      pq.insert(i, 0.0f, nullData);
+      heap.insert(i, 0.0f, nullData);
+    }
+
+    AverageTimer<boost::chrono::microseconds> pqTimer("PriorityQueue");
+    AverageTimer<boost::chrono::microseconds> heapTimer("IndexedDaryHeap");
+    float pqChecksum = 0.0f, heapChecksum = 0.0f;
+
+    for(int round = 0; round < roundCount; ++round)
+    {
+      pqTimer.start();
+      for(int i = 0; i < dirtyCount; ++i) pq.update_key(dirtyNodes[round][i], splittabilities[round][i]);
+      std::vector<PQ::Element> pqPopped;
+      for(size_t i = 0; i < splitBudget; ++i)
+      {
+        pqPopped.push_back(pq.top());
+        pq.pop();
+      }
+      for(size_t i = 0; i < splitBudget; ++i) pq.insert(pqPopped[i].id(), pqPopped[i].key() * 0.5f, nullData);
+      pqTimer.stop();
+
+      heapTimer.start();
+      heap.update_keys(dirtyNodes[round], splittabilities[round]);
+      std::vector<Heap::Element> heapPopped = heap.pop_k(splitBudget);
+      for(size_t i = 0; i < splitBudget; ++i) heap.insert(heapPopped[i].id(), heapPopped[i].key() * 0.5f, nullData);
+      heapTimer.stop();
+
+      for(size_t i = 0; i < splitBudget; ++i)
+      {
+        pqChecksum += pqPopped[i].key();
+        heapChecksum += heapPopped[i].key();
+      }
+    }
+
+    if(pqChecksum != heapChecksum) throw std::runtime_error("The indexed d-ary heap popped different keys from the priority queue");
+
+    std::cout << "\nNodes = " << nodeCount << ", Dirty nodes per round = " << dirtyCount << '\n';
+    std::cout << pqTimer << '\n';
+    std::cout << heapTimer << '\n';
+    std::cout << "Speed-up = " << static_cast<double>(pqTimer.average_duration().count()) / heapTimer.average_duration().count() << "x\n";
+  }
+}
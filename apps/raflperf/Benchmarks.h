@@ -0,0 +1,149 @@
+/**
+ * raflperf: Benchmarks.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFLPERF_BENCHMARKS
+#define H_RAFLPERF_BENCHMARKS
+
+#include <string>
+#include <vector>
+
+#include <rafl/core/RandomForest.h>
+
+/**
+ * \brief This class provides micro-benchmarks for the performance-critical parts of rafl (and the tvgutil utilities on which it relies).
+ *
+ * Each benchmark is run on a set of examples that are either loaded from a CSV file or generated around the unit circle.
+ */
+class Benchmarks
+{
+  //#################### TYPEDEFS ####################
+public:
+  typedef int Label;
+  typedef boost::shared_ptr<const rafl::Example<Label> > Example_CPtr;
+  typedef boost::shared_ptr<rafl::RandomForest<Label> > RandomForest_Ptr;
+
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Runs the specified benchmark.
+   *
+   * \param name                The name of the benchmark to run.
+   * \param examplesFilename    The name of a CSV file from which to load examples (if empty, examples will be generated instead).
+   * \throws std::runtime_error If the specified benchmark does not exist.
+   */
+  static void run(const std::string& name, const std::string& examplesFilename);
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Makes the examples on which to run a benchmark.
+   *
+   * \param examplesFilename  The name of a CSV file from which to load the examples (if empty, examples will be generated instead).
+   * \return                  The examples.
+   */
+  static std::vector<Example_CPtr> make_examples(const std::string& examplesFilename);
+
+  /**
+   * \brief Makes a random forest and trains it on the specified examples until no more nodes can be split.
+   *
+   * \param examples  The examples on which to train the forest.
+   * \param treeCount The number of trees in the forest.
+   * \return          The trained forest.
+   */
+  static RandomForest_Ptr make_trained_forest(const std::vector<Example_CPtr>& examples, size_t treeCount);
+
+  /**
+   * \brief Compares the time taken to predict labels for various numbers of descriptors one at a time and in a single batch.
+   *
+   * \param examples  The examples to use.
+   */
+  static void run_batch_prediction_benchmark(const std::vector<Example_CPtr>& examples);
+
+  /**
+   * \brief Compares the time taken to predict labels for a frame's worth of descriptors using a random forest and its compiled equivalent.
+   *
+   * \param examples  The examples to use.
+   */
+  static void run_compiled_forest_benchmark(const std::vector<Example_CPtr>& examples);
+
+  /**
+   * \brief Compares the allocations made and time taken when predicting labels for a frame's worth of descriptors stored individually and in a descriptor arena.
+   *
+   * \param examples  The examples to use.
+   */
+  static void run_descriptor_arena_benchmark(const std::vector<Example_CPtr>& examples);
+
+  /**
+   * \brief Compares the time taken to build leaf histograms and PMFs and combine them into forest PMFs using the map-based and dense containers (for various numbers of labels).
+   */
+  static void run_dense_pmf_benchmark();
+
+  /**
+   * \brief Compares the time taken to load a generated file of 10^6 examples using the original word-based loader, the streaming loader and a chunked reader.
+   */
+  static void run_example_loading_benchmark();
+
+  /**
+   * \brief Reports how often, and with how much information gain, each feature is used by the splits of a forest trained on the specified examples.
+   *
+   * It also checks that the forest makes the same predictions for the examples when all of the features it does not use are zeroed.
+   *
+   * \param examples            The examples to use.
+   * \throws std::runtime_error If the predictions for the pruned descriptors differ from those for the full descriptors.
+   */
+  static void run_feature_importance_benchmark(const std::vector<Example_CPtr>& examples);
+
+  /**
+   * \brief Compares the time taken to run mean-field inference on CRFs of various sizes using the map-based and dense inference engines.
+   */
+  static void run_mean_field_benchmark();
+
+  /**
+   * \brief Compares the time taken to load a forest saved using Boost serialization (and compile it) with the time taken to load an equivalent binary model.
+   *
+   * \param examples  The examples to use.
+   */
+  static void run_model_load_benchmark(const std::vector<Example_CPtr>& examples);
+
+  /**
+   * \brief Compares the accuracy of random forests trained on multi-scale VOP descriptors with that of forests trained on their single-scale subsets.
+   *
+   * The examples must have been calculated by a multi-scale VOP feature calculator with two or three scales. Their layout
+   * (the patch size and number of scales) is inferred from the number of features in each descriptor.
+   *
+   * \param examples            The examples to use.
+   * \throws std::runtime_error If the examples do not have a valid multi-scale VOP descriptor layout.
+   */
+  static void run_multiscale_accuracy_benchmark(const std::vector<Example_CPtr>& examples);
+
+  /**
+   * \brief Compares the time taken to calculate the prefix sums of per-label voxel masks serially and in parallel (with varying numbers of threads).
+   */
+  static void run_prefix_sum_benchmark();
+
+  /**
+   * \brief Measures the memory used by, and the time taken to add 10^6 examples to, the example reservoirs for a forest's worth of leaves.
+   */
+  static void run_reservoir_benchmark();
+
+  /**
+   * \brief Compares the time taken to generate random numbers in parallel using a shared (locking) generator and a thread-local generator.
+   */
+  static void run_rng_contention_benchmark();
+
+  /**
+   * \brief Compares the gains and timings of the partition-based and histogram-based ways of evaluating split candidates.
+   *
+   * \param examples  The examples to use.
+   */
+  static void run_split_evaluation_benchmark(const std::vector<Example_CPtr>& examples);
+
+  /**
+   * \brief Compares the time taken to maintain a splittability queue for 10^5 nodes using a map-indexed binary heap and an indexed d-ary heap.
+   */
+  static void run_splittability_queue_benchmark();
+};
+
+#endif
@@ -3,6 +3,8 @@
  * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
  */
 
+#include "Benchmarks.h"
+
 #include <boost/assign/list_of.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 using boost::assign::list_of;
@@ -41,9 +43,27 @@ int main(int argc, char *argv[])
 
   const unsigned int seed = 12345;
 
+  // If requested, run one of the micro-benchmarks instead of the usual evaluation.
+  if((argc == 3 || argc == 4) && std::string(argv[1]) == "--benchmark")
+  {
+    DecisionFunctionGeneratorFactory<Label>::instance().register_rafl_makers();
+
+    try
+    {
+      Benchmarks::run(argv[2], argc == 4 ? argv[3] : "");
+      return 0;
+    }
+    catch(std::exception& e)
+    {
+      std::cerr << e.what() << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
   if(argc != 1 && argc != 4)
   {
     std::cerr << "Usage: raflperf [<training set file> <test set file> <output path>]\n";
+    std::cerr << "       raflperf --benchmark <benchmark name> [<examples file>]\n";
     return EXIT_FAILURE;
   }
 
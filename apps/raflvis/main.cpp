@@ -286,7 +286,7 @@ int main(int argc, char *argv[])
     for(size_t i = 1, iend = currentExamples.size(); i < iend; ++i)
     {
       const Example<Label>& example = *currentExamples[i];
-      const Descriptor& descriptor = *example.get_descriptor();
+      const DescriptorView& descriptor = example.get_descriptor_view();
       featureSpacePlot.draw_cartesian_circle(cv::Point2f(descriptor[0], descriptor[1]), randomPalette[example.get_label()], 2, 2);
     }
     featureSpacePlot.draw_cartesian_axes(basicPalette["Red"]);
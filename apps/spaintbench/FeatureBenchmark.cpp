@@ -0,0 +1,444 @@
+/**
+ * spaintbench: FeatureBenchmark.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "FeatureBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+#include <ITMLib/Engine/DeviceSpecific/CPU/ITMSceneReconstructionEngine_CPU.h>
+
+#include <spaint/features/FeatureSubsetCalculator.h>
+#include <spaint/features/MultiScaleVOPFeatureCalculator.h>
+#include <spaint/features/cpu/VOPFeatureCalculator_CPU.h>
+#include <spaint/features/shared/VOPFeatureCalculator_Shared.h>
+using namespace spaint;
+
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/** The number of voxel blocks spanned by the floor along each of the x and z axes. */
+const int FLOOR_BLOCK_COUNT = 64;
+
+/** The size of the squares in the checkerboard pattern on the floor (in voxels). */
+const int TILE_SIZE = 12;
+
+//#################### LOCAL FUNCTIONS ####################
+
+/**
+ * \brief Generates an RGB patch for the specified voxel by performing a full hash lookup for each sample in the patch
+ *        (as patches were gathered before the introduction of the patch block cache).
+ *
+ * The parameters are as for generate_rgb_patch.
+ */
+void generate_rgb_patch_without_cache(int voxelLocationIndex, const Vector3s *voxelLocations, const Vector3f *xAxes, const Vector3f *yAxes,
+                                      const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData, size_t patchSize, float patchSpacing,
+                                      size_t featureCount, float *features)
+{
+  Vector3f centre = voxelLocations[voxelLocationIndex].toFloat();
+  int halfPatchSize = static_cast<int>(patchSize - 1) / 2;
+  bool isFound;
+  Vector3f xAxis = xAxes[voxelLocationIndex] * patchSpacing;
+  Vector3f yAxis = yAxes[voxelLocationIndex] * patchSpacing;
+
+  size_t offset = voxelLocationIndex * featureCount;
+  for(int y = -halfPatchSize; y <= halfPatchSize; ++y)
+  {
+    Vector3f yLoc = centre + static_cast<float>(y) * yAxis;
+    for(int x = -halfPatchSize; x <= halfPatchSize; ++x)
+    {
+      Vector3i loc = (yLoc + static_cast<float>(x) * xAxis).toIntRound();
+      Vector3u clr(255, 0, 255);
+      SpaintVoxel voxel = readVoxel(voxelData, indexData, loc, isFound);
+      if(isFound) clr = VoxelColourReader<SpaintVoxel::hasColorInformation>::read(voxel);
+      features[offset++] = clr.r;
+      features[offset++] = clr.g;
+      features[offset++] = clr.b;
+    }
+  }
+}
+
+}
+
+//#################### CONSTRUCTORS ####################
+
+FeatureBenchmark::FeatureBenchmark(unsigned int seed)
+: m_rng(seed)
+{
+  m_scene.reset(new Scene(&m_settings.sceneParams, false, MEMORYDEVICE_CPU));
+
+  ITMSceneReconstructionEngine_CPU<SpaintVoxel,ITMVoxelIndex> sceneReconstructionEngine;
+  sceneReconstructionEngine.ResetScene(m_scene.get());
+
+  make_floor();
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+std::vector<std::pair<std::string,FeatureBenchmark::Timer> > FeatureBenchmark::run(const std::vector<int>& voxelCounts, int trialCount)
+{
+  // Use the same feature calculation parameters as the pipeline.
+  const size_t patchSize = 13;
+  const float patchSpacing = 0.01f / m_settings.sceneParams.voxelSize;
+  const size_t binCount = 36;
+
+  std::vector<std::pair<std::string,Timer> > timers;
+  for(size_t i = 0, size = voxelCounts.size(); i < size; ++i)
+  {
+    const int voxelCount = voxelCounts[i];
+    VOPFeatureCalculator_CPU featureCalculator(voxelCount, patchSize, patchSpacing, binCount);
+    ORUtils::MemoryBlock<Vector3s> voxelLocationsMB(voxelCount, true, false);
+    ORUtils::MemoryBlock<float> featuresMB(voxelCount * featureCalculator.get_feature_count(), true, false);
+
+    Timer timer("Calculate Features");
+    for(int trial = 0; trial < trialCount; ++trial)
+    {
+      sample_surface_voxels(voxelLocationsMB);
+
+      timer.start();
+      featureCalculator.calculate_features(voxelLocationsMB, m_scene.get(), featuresMB);
+      timer.stop();
+    }
+
+    timers.push_back(std::make_pair(boost::lexical_cast<std::string>(voxelCount), timer));
+  }
+
+  return timers;
+}
+
+std::vector<std::pair<std::string,FeatureBenchmark::Timer> > FeatureBenchmark::run_cache(const std::vector<int>& maxAges, int voxelCount, int frameCount,
+                                                                                         std::vector<double>& hitRates)
+{
+  // Use the same feature calculation and cache parameters as the pipeline.
+  const size_t patchSize = 13;
+  const float patchSpacing = 0.01f / m_settings.sceneParams.voxelSize;
+  const size_t binCount = 36;
+  const int visibleVoxelCount = 8 * voxelCount;
+  const int weightTolerance = 10;
+
+  // Choose the voxels that are visible in every frame.
+  std::vector<Vector3s> visibleVoxelLocations(visibleVoxelCount);
+  const int surfaceVoxelCount = static_cast<int>(m_surfaceVoxelLocations.size());
+  for(int i = 0; i < visibleVoxelCount; ++i)
+  {
+    visibleVoxelLocations[i] = m_surfaceVoxelLocations[m_rng.generate_int_from_uniform(0, surfaceVoxelCount - 1)];
+  }
+
+  VOPFeatureCalculator_CPU uncachedCalculator(voxelCount, patchSize, patchSpacing, binCount);
+  const size_t featureCount = uncachedCalculator.get_feature_count();
+  ORUtils::MemoryBlock<Vector3s> voxelLocationsMB(voxelCount, true, false);
+  ORUtils::MemoryBlock<float> uncachedFeaturesMB(voxelCount * featureCount, true, false);
+  ORUtils::MemoryBlock<float> cachedFeaturesMB(voxelCount * featureCount, true, false);
+  Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+  const float *uncachedFeatures = uncachedFeaturesMB.GetData(MEMORYDEVICE_CPU);
+  const float *cachedFeatures = cachedFeaturesMB.GetData(MEMORYDEVICE_CPU);
+
+  std::vector<std::pair<std::string,Timer> > timers;
+  hitRates.clear();
+  for(size_t i = 0, size = maxAges.size(); i < size; ++i)
+  {
+    VOPFeatureCache_Ptr cache(new VOPFeatureCache(visibleVoxelCount, weightTolerance, maxAges[i]));
+    VOPFeatureCalculator_CPU cachedCalculator(voxelCount, patchSize, patchSpacing, binCount, cache);
+
+    Timer uncachedTimer("Calculate Features (Uncached)"), cachedTimer("Calculate Features (Cached)");
+    for(int frame = 0; frame < frameCount; ++frame)
+    {
+      for(int j = 0; j < voxelCount; ++j)
+      {
+        voxelLocations[j] = visibleVoxelLocations[m_rng.generate_int_from_uniform(0, visibleVoxelCount - 1)];
+      }
+
+      uncachedTimer.start();
+      uncachedCalculator.calculate_features(voxelLocationsMB, m_scene.get(), uncachedFeaturesMB);
+      uncachedTimer.stop();
+
+      cachedTimer.start();
+      cachedCalculator.calculate_features(voxelLocationsMB, m_scene.get(), cachedFeaturesMB);
+      cachedTimer.stop();
+
+      // Since the scene is static, the cached descriptors should be exactly the same as freshly-calculated ones.
+      if(!std::equal(uncachedFeatures, uncachedFeatures + voxelCount * featureCount, cachedFeatures))
+      {
+        throw std::runtime_error("Error: The feature descriptors calculated with the cache differ from those calculated without it for a maximum age of " + boost::lexical_cast<std::string>(maxAges[i]));
+      }
+    }
+
+    const std::string maxAgeString = boost::lexical_cast<std::string>(maxAges[i]);
+    timers.push_back(std::make_pair(maxAgeString, uncachedTimer));
+    timers.push_back(std::make_pair(maxAgeString, cachedTimer));
+    hitRates.push_back(cache->get_hit_rate());
+  }
+
+  return timers;
+}
+
+std::vector<std::pair<std::string,FeatureBenchmark::Timer> > FeatureBenchmark::run_multiscale(const std::vector<float>& patchSpacings, int voxelCount, int trialCount)
+{
+  const size_t patchSize = 13;
+  const size_t binCount = 36;
+  const size_t patchFeatureCount = patchSize * patchSize * 3;
+
+  VOPFeatureCalculator_CPU singleScaleCalculator(voxelCount, patchSize, patchSpacings[0], binCount);
+  const size_t singleScaleFeatureCount = singleScaleCalculator.get_feature_count();
+  ORUtils::MemoryBlock<Vector3s> voxelLocationsMB(voxelCount, true, false);
+  ORUtils::MemoryBlock<float> singleScaleFeaturesMB(voxelCount * singleScaleFeatureCount, true, false);
+  const float *singleScaleFeatures = singleScaleFeaturesMB.GetData(MEMORYDEVICE_CPU);
+
+  std::vector<std::pair<std::string,Timer> > timers;
+  for(size_t scaleCount = 1, maxScaleCount = patchSpacings.size(); scaleCount <= maxScaleCount; ++scaleCount)
+  {
+    MultiScaleVOPFeatureCalculator multiScaleCalculator(voxelCount, patchSize, std::vector<float>(patchSpacings.begin(), patchSpacings.begin() + scaleCount), binCount);
+    const size_t multiScaleFeatureCount = multiScaleCalculator.get_feature_count();
+    ORUtils::MemoryBlock<float> multiScaleFeaturesMB(voxelCount * multiScaleFeatureCount, true, false);
+    const float *multiScaleFeatures = multiScaleFeaturesMB.GetData(MEMORYDEVICE_CPU);
+
+    Timer singleScaleTimer("Calculate Features (Single-Scale)"), multiScaleTimer("Calculate Features (Multi-Scale)");
+    for(int trial = 0; trial < trialCount; ++trial)
+    {
+      sample_surface_voxels(voxelLocationsMB);
+
+      singleScaleTimer.start();
+      singleScaleCalculator.calculate_features(voxelLocationsMB, m_scene.get(), singleScaleFeaturesMB);
+      singleScaleTimer.stop();
+
+      multiScaleTimer.start();
+      multiScaleCalculator.calculate_features(voxelLocationsMB, m_scene.get(), multiScaleFeaturesMB);
+      multiScaleTimer.stop();
+
+      // Check that the first patch, the normal and the height in each multi-scale descriptor match the single-scale descriptor.
+      for(int i = 0; i < voxelCount; ++i)
+      {
+        const float *singleScaleDescriptor = singleScaleFeatures + i * singleScaleFeatureCount;
+        const float *multiScaleDescriptor = multiScaleFeatures + i * multiScaleFeatureCount;
+        if(!std::equal(singleScaleDescriptor, singleScaleDescriptor + patchFeatureCount, multiScaleDescriptor) ||
+           !std::equal(singleScaleDescriptor + patchFeatureCount, singleScaleDescriptor + singleScaleFeatureCount, multiScaleDescriptor + multiScaleFeatureCount - 4))
+        {
+          throw std::runtime_error("Error: A multi-scale descriptor is inconsistent with the corresponding single-scale descriptor for " + boost::lexical_cast<std::string>(scaleCount) + " scale(s)");
+        }
+      }
+    }
+
+    const std::string scaleCountString = boost::lexical_cast<std::string>(scaleCount);
+    timers.push_back(std::make_pair(scaleCountString, singleScaleTimer));
+    timers.push_back(std::make_pair(scaleCountString, multiScaleTimer));
+  }
+
+  return timers;
+}
+
+std::vector<std::pair<std::string,FeatureBenchmark::Timer> > FeatureBenchmark::run_patch_gathering(const std::vector<int>& patchSizes, int voxelCount, int trialCount,
+                                                                                                   std::vector<double>& lookupsPerPatch)
+{
+  const float patchSpacing = 0.01f / m_settings.sceneParams.voxelSize;
+  const SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+  const ITMVoxelIndex::IndexData *indexData = m_scene->index.getIndexData();
+
+  ORUtils::MemoryBlock<Vector3s> voxelLocationsMB(voxelCount, true, false);
+  std::vector<Vector3f> xAxes(voxelCount), yAxes(voxelCount);
+  const Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+
+  std::vector<std::pair<std::string,Timer> > timers;
+  lookupsPerPatch.clear();
+  for(size_t i = 0, size = patchSizes.size(); i < size; ++i)
+  {
+    const size_t patchSize = patchSizes[i];
+    const size_t featureCount = patchSize * patchSize * 3 + 4;
+    std::vector<float> expectedFeatures(voxelCount * featureCount), features(voxelCount * featureCount);
+    Timer uncachedTimer("Gather Patches (Uncached)"), cachedTimer("Gather Patches (Cached)"), tiledTimer("Gather Patches (Tiled)");
+    std::vector<std::pair<unsigned int,int> > tileOrder(voxelCount);
+    PatchBlockCache cache;
+
+    for(int trial = 0; trial < trialCount; ++trial)
+    {
+      // Sample the voxels from the surface of the floor, and give each of them a coordinate system in the plane of the floor with a random orientation.
+      sample_surface_voxels(voxelLocationsMB);
+      for(int j = 0; j < voxelCount; ++j)
+      {
+        const float angle = m_rng.generate_real_from_uniform(0.0f, static_cast<float>(2 * M_PI));
+        xAxes[j] = Vector3f(cos(angle), 0.0f, sin(angle));
+        yAxes[j] = Vector3f(-sin(angle), 0.0f, cos(angle));
+      }
+
+      // Gather the patches without and with the cache, and check that the results are the same.
+      uncachedTimer.start();
+      for(int j = 0; j < voxelCount; ++j)
+      {
+        generate_rgb_patch_without_cache(j, voxelLocations, &xAxes[0], &yAxes[0], voxelData, indexData, patchSize, patchSpacing, featureCount, &expectedFeatures[0]);
+      }
+      uncachedTimer.stop();
+
+      cachedTimer.start();
+      for(int j = 0; j < voxelCount; ++j)
+      {
+        generate_rgb_patch(j, voxelLocations, &xAxes[0], &yAxes[0], voxelData, indexData, patchSize, patchSpacing, featureCount, &features[0], cache);
+      }
+      cachedTimer.stop();
+
+      if(features != expectedFeatures)
+      {
+        throw std::runtime_error("Error: The patches gathered via the patch block cache differ from the ones gathered without it for patch size " + boost::lexical_cast<std::string>(patchSize));
+      }
+
+      // Gather the patches with the cache again, but this time after sorting the voxels into spatially-coherent tiles
+      // (as the CPU feature calculator does), and check that the results are still the same.
+      std::fill(features.begin(), features.end(), 0.0f);
+      tiledTimer.start();
+      make_tile_order(voxelLocations, voxelCount, tileOrder);
+
+      for(int j = 0; j < voxelCount; ++j)
+      {
+        generate_rgb_patch(tileOrder[j].second, voxelLocations, &xAxes[0], &yAxes[0], voxelData, indexData, patchSize, patchSpacing, featureCount, &features[0], cache);
+      }
+      tiledTimer.stop();
+
+      if(features != expectedFeatures)
+      {
+        throw std::runtime_error("Error: The patches gathered in tile order differ from the ones gathered without the cache for patch size " + boost::lexical_cast<std::string>(patchSize));
+      }
+    }
+
+    const std::string patchSizeString = boost::lexical_cast<std::string>(patchSize);
+    timers.push_back(std::make_pair(patchSizeString, uncachedTimer));
+    timers.push_back(std::make_pair(patchSizeString, cachedTimer));
+    timers.push_back(std::make_pair(patchSizeString, tiledTimer));
+    lookupsPerPatch.push_back(static_cast<double>(cache.lookupCount) / (2 * voxelCount * trialCount));
+  }
+
+  return timers;
+}
+
+std::vector<std::pair<std::string,FeatureBenchmark::Timer> > FeatureBenchmark::run_subset(const std::vector<int>& subsetSizes, int voxelCount, int trialCount)
+{
+  // Use the same feature calculation parameters as the pipeline.
+  const size_t patchSize = 13;
+  const float patchSpacing = 0.01f / m_settings.sceneParams.voxelSize;
+  const size_t binCount = 36;
+
+  VOPFeatureCalculator_CPU fullCalculator(voxelCount, patchSize, patchSpacing, binCount);
+  const int featureCount = static_cast<int>(fullCalculator.get_feature_count());
+  ORUtils::MemoryBlock<Vector3s> voxelLocationsMB(voxelCount, true, false);
+  ORUtils::MemoryBlock<float> fullFeaturesMB(voxelCount * featureCount, true, false);
+  ORUtils::MemoryBlock<float> subsetFeaturesMB(voxelCount * featureCount, true, false);
+  const float *fullFeatures = fullFeaturesMB.GetData(MEMORYDEVICE_CPU);
+  const float *subsetFeatures = subsetFeaturesMB.GetData(MEMORYDEVICE_CPU);
+
+  std::vector<size_t> allFeatureIndices(featureCount);
+  for(int i = 0; i < featureCount; ++i) allFeatureIndices[i] = i;
+
+  std::vector<std::pair<std::string,Timer> > timers;
+  for(size_t i = 0, size = subsetSizes.size(); i < size; ++i)
+  {
+    const int subsetSize = std::min(subsetSizes[i], featureCount);
+    Timer fullTimer("Calculate Features (Full)"), subsetTimer("Calculate Features (Subset)");
+    for(int trial = 0; trial < trialCount; ++trial)
+    {
+      // Choose a random subset of the features (using a partial Fisher-Yates shuffle).
+      for(int j = 0; j < subsetSize; ++j)
+      {
+        std::swap(allFeatureIndices[j], allFeatureIndices[m_rng.generate_int_from_uniform(j, featureCount - 1)]);
+      }
+      FeatureSubsetCalculator subsetCalculator(voxelCount, patchSize, patchSpacing, binCount, std::vector<size_t>(allFeatureIndices.begin(), allFeatureIndices.begin() + subsetSize));
+      std::vector<bool> inSubset(featureCount, false);
+      for(int j = 0; j < subsetSize; ++j) inSubset[allFeatureIndices[j]] = true;
+
+      sample_surface_voxels(voxelLocationsMB);
+
+      fullTimer.start();
+      fullCalculator.calculate_features(voxelLocationsMB, m_scene.get(), fullFeaturesMB);
+      fullTimer.stop();
+
+      subsetTimer.start();
+      subsetCalculator.calculate_features(voxelLocationsMB, m_scene.get(), subsetFeaturesMB);
+      subsetTimer.stop();
+
+      // Check that the features in the subset are identical to those in the full descriptors, and that the others are zero.
+      for(int j = 0; j < voxelCount * featureCount; ++j)
+      {
+        if(subsetFeatures[j] != (inSubset[j % featureCount] ? fullFeatures[j] : 0.0f))
+        {
+          throw std::runtime_error("Error: Feature " + boost::lexical_cast<std::string>(j % featureCount) + " of a descriptor is inconsistent with the full descriptor for a subset of size " + boost::lexical_cast<std::string>(subsetSize));
+        }
+      }
+    }
+
+    const std::string subsetSizeString = boost::lexical_cast<std::string>(subsetSize);
+    timers.push_back(std::make_pair(subsetSizeString, fullTimer));
+    timers.push_back(std::make_pair(subsetSizeString, subsetTimer));
+  }
+
+  return timers;
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void FeatureBenchmark::make_floor()
+{
+  ITMHashEntry *hashTable = m_scene->index.GetEntries();
+  int *allocationList = m_scene->localVBA.GetAllocationList();
+  SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+
+  // Allocate two layers of voxel blocks, one either side of the plane y = 0. For simplicity, we only use blocks whose entries
+  // in the ordered part of the hash table are free (a block that collides with one that is already allocated is skipped).
+  const int halfExtent = FLOOR_BLOCK_COUNT / 2;
+  for(int bz = -halfExtent; bz < halfExtent; ++bz)
+  {
+    for(int by = -1; by <= 0; ++by)
+    {
+      for(int bx = -halfExtent; bx < halfExtent; ++bx)
+      {
+        const Vector3s blockPos(static_cast<short>(bx), static_cast<short>(by), static_cast<short>(bz));
+        ITMHashEntry& hashEntry = hashTable[hashIndex(blockPos)];
+        if(hashEntry.ptr >= -1) continue;
+
+        hashEntry.pos = blockPos;
+        hashEntry.offset = 0;
+        hashEntry.ptr = allocationList[m_scene->localVBA.lastFreeBlockId--];
+
+        // Fill in the voxels in the block. The floor's surface lies at y = 0, with free space above it, and it is
+        // coloured with a checkerboard pattern so that the voxel patches have some dominant orientations to find.
+        for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+        {
+          const int x = bx * SDF_BLOCK_SIZE + linearIdx % SDF_BLOCK_SIZE;
+          const int y = by * SDF_BLOCK_SIZE + (linearIdx / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE;
+          const int z = bz * SDF_BLOCK_SIZE + linearIdx / (SDF_BLOCK_SIZE * SDF_BLOCK_SIZE);
+
+          SpaintVoxel& voxel = voxelData[hashEntry.ptr * SDF_BLOCK_SIZE3 + linearIdx];
+          voxel.sdf = SpaintVoxel::SDF_floatToValue(std::max(-1.0f, std::min(1.0f, y / 4.0f)));
+          voxel.w_depth = 1;
+#ifndef USE_LOW_POWER_MODE
+          const bool light = ((x + 1024) / TILE_SIZE + (z + 1024) / TILE_SIZE) % 2 == 0;
+          voxel.clr = light ? Vector3u(220, 200, 160) : Vector3u(60, 40, 30);
+          voxel.w_color = 1;
+#endif
+
+          // Record the voxels on the surface that are far enough from the edges of the floor for their patches to lie on it.
+          const int margin = 2 * TILE_SIZE;
+          const int limit = halfExtent * SDF_BLOCK_SIZE - margin;
+          if(y == 0 && x >= -limit && x < limit && z >= -limit && z < limit)
+          {
+            m_surfaceVoxelLocations.push_back(Vector3s(static_cast<short>(x), static_cast<short>(y), static_cast<short>(z)));
+          }
+        }
+      }
+    }
+  }
+
+  if(m_surfaceVoxelLocations.empty()) throw std::runtime_error("Error: Could not make the floor for the feature benchmark");
+}
+
+void FeatureBenchmark::sample_surface_voxels(ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB)
+{
+  Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+  const int surfaceVoxelCount = static_cast<int>(m_surfaceVoxelLocations.size());
+  for(int i = 0, voxelCount = static_cast<int>(voxelLocationsMB.dataSize); i < voxelCount; ++i)
+  {
+    voxelLocations[i] = m_surfaceVoxelLocations[m_rng.generate_int_from_uniform(0, surfaceVoxelCount - 1)];
+  }
+}
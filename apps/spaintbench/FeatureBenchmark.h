@@ -0,0 +1,162 @@
+/**
+ * spaintbench: FeatureBenchmark.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTBENCH_FEATUREBENCHMARK
+#define H_SPAINTBENCH_FEATUREBENCHMARK
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ITMLib/Objects/ITMScene.h>
+#include <ITMLib/Utils/ITMLibSettings.h>
+
+#include <spaint/util/SpaintVoxel.h>
+
+#include <tvgutil/RandomNumberGenerator.h>
+#include <tvgutil/timing/AverageTimer.h>
+
+/**
+ * \brief An instance of this class can be used to measure the time taken to calculate VOP feature descriptors on the CPU
+ *        for various numbers of voxels.
+ *
+ * The benchmark uses a CPU-based scene containing a flat, textured floor whose voxels are written directly into the scene,
+ * rather than one reconstructed from images. In each trial, the required number of voxels is sampled at random from the
+ * surface of the floor, and the time taken to calculate their feature descriptors (without a feature cache) is measured.
+ *
+ * The benchmark can also compare the time taken to gather the RGB patches for the voxels by performing a full hash lookup
+ * for every sample with the time taken to gather them via a patch block cache, both in the order in which the voxels were
+ * sampled and after sorting the voxels into spatially-coherent tiles.
+ *
+ * It can also measure how the time taken to calculate multi-scale VOP feature descriptors grows with the number of scales,
+ * and how effective the feature cache is when the same static surface is resampled frame after frame.
+ *
+ * Finally, it can compare the time taken to calculate full VOP feature descriptors with the time taken to calculate only
+ * subsets of their features (as needed by forests that only use some of the features).
+ */
+class FeatureBenchmark
+{
+  //#################### TYPEDEFS ####################
+private:
+  typedef ITMLib::Objects::ITMScene<spaint::SpaintVoxel,ITMVoxelIndex> Scene;
+  typedef boost::shared_ptr<Scene> Scene_Ptr;
+public:
+  typedef tvgutil::AverageTimer<boost::chrono::microseconds> Timer;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The random number generator to use when sampling voxels from the surface. */
+  tvgutil::RandomNumberGenerator m_rng;
+
+  /** The scene. */
+  Scene_Ptr m_scene;
+
+  /** The settings to use for the scene. */
+  ITMLibSettings m_settings;
+
+  /** The locations of the voxels on the surface of the floor (away from its edges). */
+  std::vector<Vector3s> m_surfaceVoxelLocations;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a feature benchmark.
+   *
+   * \param seed  The seed to use for the random number generator.
+   */
+  explicit FeatureBenchmark(unsigned int seed);
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  FeatureBenchmark(const FeatureBenchmark&);
+  FeatureBenchmark& operator=(const FeatureBenchmark&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Runs the benchmark.
+   *
+   * \param voxelCounts The numbers of voxels for which to calculate feature descriptors.
+   * \param trialCount  The number of trials to run for each number of voxels.
+   * \return            The timers for the feature calculation, each paired with the number of voxels concerned (as a string).
+   */
+  std::vector<std::pair<std::string,Timer> > run(const std::vector<int>& voxelCounts, int trialCount);
+
+  /**
+   * \brief Runs the feature cache part of the benchmark.
+   *
+   * This replays a static scene: a fixed set of "visible" voxels is chosen on the surface of the floor, and each frame, the voxels
+   * for which to calculate feature descriptors are sampled from them at random (as in the pipeline's prediction mode, the cache
+   * can hold descriptors for eight times as many voxels as are sampled each frame). For each maximum age specified, the time taken
+   * to calculate the descriptors with a feature cache is measured, together with the time taken to calculate them without one.
+   *
+   * \param maxAges             The maximum ages (in frames) of the cached feature descriptors.
+   * \param voxelCount          The number of voxels for which to calculate feature descriptors each frame.
+   * \param frameCount          The number of frames to replay for each maximum age.
+   * \param hitRates            A vector into which to write the hit rate of the cache for each maximum age.
+   * \return                    The timers for the feature calculation, each paired with the maximum age concerned (as a string).
+   * \throws std::runtime_error If the feature descriptors calculated with the cache ever differ from those calculated without it.
+   */
+  std::vector<std::pair<std::string,Timer> > run_cache(const std::vector<int>& maxAges, int voxelCount, int frameCount, std::vector<double>& hitRates);
+
+  /**
+   * \brief Runs the multi-scale part of the benchmark.
+   *
+   * For each n from 1 to the number of spacings specified, the time taken to calculate multi-scale descriptors using the first n
+   * spacings is measured, together with the time taken to calculate single-scale descriptors using the first spacing for comparison.
+   *
+   * \param patchSpacings      The spacings (in voxels) between the pixels in the patches at the various scales.
+   * \param voxelCount         The number of voxels for which to calculate feature descriptors in each trial.
+   * \param trialCount         The number of trials to run for each number of scales.
+   * \return                   The timers for the feature calculation, each paired with the number of scales concerned (as a string).
+   * \throws std::runtime_error If the first patch, normal or height of a multi-scale descriptor ever differ from the single-scale descriptor.
+   */
+  std::vector<std::pair<std::string,Timer> > run_multiscale(const std::vector<float>& patchSpacings, int voxelCount, int trialCount);
+
+  /**
+   * \brief Runs the patch gathering part of the benchmark.
+   *
+   * \param patchSizes          The patch sizes for which to gather patches (each must be odd).
+   * \param voxelCount          The number of voxels for which to gather patches in each trial.
+   * \param trialCount          The number of trials to run for each patch size.
+   * \param lookupsPerPatch     A vector into which to write the average number of hash lookups performed per patch when using the cache (one per patch size).
+   * \return                    The timers for the various ways of gathering the patches, each paired with the patch size concerned (as a string).
+   * \throws std::runtime_error If the various ways of gathering the patches ever produce different patches.
+   */
+  std::vector<std::pair<std::string,Timer> > run_patch_gathering(const std::vector<int>& patchSizes, int voxelCount, int trialCount, std::vector<double>& lookupsPerPatch);
+
+  /**
+   * \brief Runs the feature subset part of the benchmark.
+   *
+   * For each subset size specified, a subset of that many features is chosen at random in each trial, and the time taken to
+   * calculate only the features in the subset is measured, together with the time taken to calculate the full descriptors.
+   *
+   * \param subsetSizes         The numbers of features in the subsets to calculate.
+   * \param voxelCount          The number of voxels for which to calculate feature descriptors in each trial.
+   * \param trialCount          The number of trials to run for each subset size.
+   * \return                    The timers for the feature calculation, each paired with the subset size concerned (as a string).
+   * \throws std::runtime_error If a feature in a subset ever differs from the full descriptor, or a feature outside it is ever non-zero.
+   */
+  std::vector<std::pair<std::string,Timer> > run_subset(const std::vector<int>& subsetSizes, int voxelCount, int trialCount);
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Writes a flat, textured floor into the scene.
+   */
+  void make_floor();
+
+  /**
+   * \brief Samples the specified number of voxels at random from the surface of the floor.
+   *
+   * \param voxelLocationsMB  A memory block into which to write the locations of the sampled voxels (its size determines the number of voxels to sample).
+   */
+  void sample_surface_voxels(ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB);
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * spaintbench: KernelBenchmark.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "KernelBenchmark.h"
+
+#include <algorithm>
+
+#include <boost/lexical_cast.hpp>
+
+#include <spaint/features/cpu/VOPFeatureKernels_CPU.h>
+using namespace spaint;
+
+//#################### CONSTRUCTORS ####################
+
+KernelBenchmark::KernelBenchmark(unsigned int seed)
+: m_rng(seed)
+{}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+std::vector<std::pair<std::string,KernelBenchmark::Timer> > KernelBenchmark::run(const std::vector<int>& patchSizes, int patchCount, int binCount, int trialCount)
+{
+  // Determine which instruction sets to benchmark.
+  std::vector<VOPFeatureKernels_CPU::InstructionSet> instructionSets;
+  instructionSets.push_back(VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR);
+  if(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::INSTRUCTIONSET_SSE2)) instructionSets.push_back(VOPFeatureKernels_CPU::INSTRUCTIONSET_SSE2);
+  if(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::INSTRUCTIONSET_AVX2)) instructionSets.push_back(VOPFeatureKernels_CPU::INSTRUCTIONSET_AVX2);
+  const size_t instructionSetCount = instructionSets.size();
+
+  std::vector<std::pair<std::string,Timer> > timers;
+
+  for(size_t i = 0, size = patchSizes.size(); i < size; ++i)
+  {
+    const int patchSize = patchSizes[i];
+    const int patchArea = patchSize * patchSize;
+
+    std::vector<Timer> labTimers, histogramTimers;
+    for(size_t j = 0; j < instructionSetCount; ++j)
+    {
+      const std::string instructionSetName = VOPFeatureKernels_CPU::get_instruction_set_name(instructionSets[j]);
+      labTimers.push_back(Timer("Convert To Lab (" + instructionSetName + ")"));
+      histogramTimers.push_back(Timer("Compute Histograms (" + instructionSetName + ")"));
+    }
+
+    std::vector<float> rgbPatches(patchCount * patchArea * 3), labPatches(rgbPatches.size());
+    std::vector<float> intensityPatches(patchCount * patchArea), histograms(patchCount * binCount);
+
+    for(int trial = 0; trial < trialCount; ++trial)
+    {
+      // Generate a batch of patches with random colours and intensities.
+      for(size_t k = 0, rgbSize = rgbPatches.size(); k < rgbSize; ++k)
+      {
+        rgbPatches[k] = m_rng.generate_real_from_uniform<float>(0.0f, 255.0f);
+      }
+
+      for(size_t k = 0, intensitySize = intensityPatches.size(); k < intensitySize; ++k)
+      {
+        intensityPatches[k] = m_rng.generate_real_from_uniform<float>(0.0f, 255.0f);
+      }
+
+      // Run each kernel on the whole batch using each instruction set in turn.
+      for(size_t j = 0; j < instructionSetCount; ++j)
+      {
+        VOPFeatureKernels_CPU kernels(instructionSets[j]);
+
+        // Note that the conversion is done in place, so the patches must be copied first (outside the timed section).
+        std::copy(rgbPatches.begin(), rgbPatches.end(), labPatches.begin());
+        labTimers[j].start();
+        for(int k = 0; k < patchCount; ++k)
+        {
+          kernels.convert_patch_to_lab(&labPatches[k * patchArea * 3], patchArea);
+        }
+        labTimers[j].stop();
+
+        histogramTimers[j].start();
+        for(int k = 0; k < patchCount; ++k)
+        {
+          kernels.compute_histogram(&intensityPatches[k * patchArea], patchSize, binCount, &histograms[k * binCount]);
+        }
+        histogramTimers[j].stop();
+      }
+    }
+
+    const std::string patchSizeString = boost::lexical_cast<std::string>(patchSize);
+    for(size_t j = 0; j < instructionSetCount; ++j) timers.push_back(std::make_pair(patchSizeString, labTimers[j]));
+    for(size_t j = 0; j < instructionSetCount; ++j) timers.push_back(std::make_pair(patchSizeString, histogramTimers[j]));
+  }
+
+  return timers;
+}
@@ -0,0 +1,64 @@
+/**
+ * spaintbench: KernelBenchmark.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTBENCH_KERNELBENCHMARK
+#define H_SPAINTBENCH_KERNELBENCHMARK
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tvgutil/RandomNumberGenerator.h>
+#include <tvgutil/timing/AverageTimer.h>
+
+/**
+ * \brief An instance of this class can be used to measure the time taken by each of the per-patch VOP feature kernels
+ *        (the RGB to CIELab conversion and the computation of histograms of oriented gradients) with each of the
+ *        instruction sets supported by the CPU.
+ *
+ * In each trial, a batch of patches with random colours is generated, and the time taken to run each kernel on the
+ * whole batch with each instruction set is measured. Every instruction set processes exactly the same patches.
+ */
+class KernelBenchmark
+{
+  //#################### TYPEDEFS ####################
+public:
+  typedef tvgutil::AverageTimer<boost::chrono::microseconds> Timer;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The random number generator to use when generating the patches. */
+  tvgutil::RandomNumberGenerator m_rng;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a kernel benchmark.
+   *
+   * \param seed  The seed to use for the random number generator.
+   */
+  explicit KernelBenchmark(unsigned int seed);
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  KernelBenchmark(const KernelBenchmark&);
+  KernelBenchmark& operator=(const KernelBenchmark&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Runs the benchmark.
+   *
+   * \param patchSizes  The patch sizes for which to run the kernels (each must be odd).
+   * \param patchCount  The number of patches in the batch processed in each trial.
+   * \param binCount    The number of bins to use for the histograms of oriented gradients.
+   * \param trialCount  The number of trials to run for each patch size.
+   * \return            The timers for the various kernels and instruction sets, each paired with the patch size concerned (as a string).
+   */
+  std::vector<std::pair<std::string,Timer> > run(const std::vector<int>& patchSizes, int patchCount, int binCount, int trialCount);
+};
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * spaintbench: LabelIndexBenchmark.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "LabelIndexBenchmark.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+#include <ITMLib/Engine/DeviceSpecific/CPU/ITMSceneReconstructionEngine_CPU.h>
+
+#include <spaint/markers/cpu/VoxelMarker_CPU.h>
+using namespace spaint;
+
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/** The largest label with which voxels are marked during the benchmark. */
+const int MAX_LABEL = 7;
+
+/** The number of overlapping rounds of marking to perform in each trial. */
+const int ROUND_COUNT = 4;
+
+}
+
+//#################### CONSTRUCTORS ####################
+
+LabelIndexBenchmark::LabelIndexBenchmark(int voxelCount, unsigned int seed)
+: m_labelIndex(new VoxelLabelIndex), m_rng(seed)
+{
+  // Note: The scene must not use swapping, since the label index only supports scenes without swapping.
+  m_scene.reset(new Scene(&m_settings.sceneParams, false, MEMORYDEVICE_CPU));
+
+  ITMSceneReconstructionEngine_CPU<SpaintVoxel,ITMVoxelIndex> sceneReconstructionEngine;
+  sceneReconstructionEngine.ResetScene(m_scene.get());
+
+  allocate_voxels(voxelCount);
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+std::vector<std::pair<std::string,LabelIndexBenchmark::Timer> > LabelIndexBenchmark::run(int trialCount, int labelledVoxelCount)
+{
+  VoxelMarker_CPU indexedMarker(m_labelIndex), sweepingMarker;
+
+  std::vector<std::pair<std::string,ClearingSettings> > clearingModes;
+  clearingModes.push_back(std::make_pair("CLEAR_ALL", ClearingSettings(CLEAR_ALL, 0, 0)));
+  clearingModes.push_back(std::make_pair("CLEAR_EQ_LABEL", ClearingSettings(CLEAR_EQ_LABEL, 0, 1)));
+  clearingModes.push_back(std::make_pair("CLEAR_EQ_LABEL_NEQ_GROUP", ClearingSettings(CLEAR_EQ_LABEL_NEQ_GROUP, SpaintVoxel::LG_USER, 1)));
+  clearingModes.push_back(std::make_pair("CLEAR_NEQ_GROUP", ClearingSettings(CLEAR_NEQ_GROUP, SpaintVoxel::LG_USER, 0)));
+
+  const std::vector<SpaintVoxel::PackedLabel> defaultLabels(m_voxelLocations.size());
+
+  std::vector<std::pair<std::string,Timer> > timers;
+  for(size_t i = 0, size = clearingModes.size(); i < size; ++i)
+  {
+    const std::string& modeName = clearingModes[i].first;
+    const ClearingSettings& settings = clearingModes[i].second;
+    Timer markingTimer("Marking"), indexedClearingTimer("Indexed Clearing"), rebuildTimer("Index Rebuild"), sweepingClearingTimer("Sweeping Clearing");
+
+    for(int trial = 0; trial < trialCount; ++trial)
+    {
+      // Start from a scene without any labelled voxels, and a (valid) empty index.
+      set_labels(defaultLabels);
+      m_labelIndex->rebuild(m_scene.get());
+
+      // Label some of the voxels.
+      markingTimer.start();
+      label_random_voxels(indexedMarker, labelledVoxelCount);
+      markingTimer.stop();
+
+      // Clear the labels using the index.
+      const std::vector<SpaintVoxel::PackedLabel> labelsBeforeClearing = get_labels();
+      indexedClearingTimer.start();
+      indexedMarker.clear_labels(m_scene.get(), settings);
+      indexedClearingTimer.stop();
+
+      // Restore the labels and rebuild the index from scratch.
+      set_labels(labelsBeforeClearing);
+      rebuildTimer.start();
+      m_labelIndex->rebuild(m_scene.get());
+      rebuildTimer.stop();
+
+      // Clear the labels by sweeping the whole voxel block array.
+      sweepingClearingTimer.start();
+      sweepingMarker.clear_labels(m_scene.get(), settings);
+      sweepingClearingTimer.stop();
+    }
+
+    timers.push_back(std::make_pair(modeName, markingTimer));
+    timers.push_back(std::make_pair(modeName, indexedClearingTimer));
+    timers.push_back(std::make_pair(modeName, rebuildTimer));
+    timers.push_back(std::make_pair(modeName, sweepingClearingTimer));
+  }
+
+  return timers;
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void LabelIndexBenchmark::allocate_voxels(int voxelCount)
+{
+  const int blockCount = (voxelCount + SDF_BLOCK_SIZE3 - 1) / SDF_BLOCK_SIZE3;
+  if(blockCount > SDF_LOCAL_BLOCK_NUM) throw std::runtime_error("Error: Too many voxels requested for the label index benchmark");
+
+  ITMHashEntry *hashTable = m_scene->index.GetEntries();
+  int *allocationList = m_scene->localVBA.GetAllocationList();
+
+  // Allocate voxel blocks at random positions in a cube around the origin. For simplicity, we only use positions whose entries
+  // in the ordered part of the hash table are free (so that we never need to use the excess list).
+  const int range = 64;
+  for(int i = 0; i < blockCount;)
+  {
+    Vector3s blockPos(
+      static_cast<short>(m_rng.generate_int_from_uniform(-range, range - 1)),
+      static_cast<short>(m_rng.generate_int_from_uniform(-range, range - 1)),
+      static_cast<short>(m_rng.generate_int_from_uniform(-range, range - 1))
+    );
+
+    ITMHashEntry& hashEntry = hashTable[hashIndex(blockPos)];
+    if(hashEntry.ptr >= -1) continue;
+
+    hashEntry.pos = blockPos;
+    hashEntry.offset = 0;
+    hashEntry.ptr = allocationList[m_scene->localVBA.lastFreeBlockId--];
+
+    // Record the locations and addresses of the voxels in the new block.
+    for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+    {
+      const int x = linearIdx % SDF_BLOCK_SIZE;
+      const int y = (linearIdx / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE;
+      const int z = linearIdx / (SDF_BLOCK_SIZE * SDF_BLOCK_SIZE);
+      m_voxelLocations.push_back(Vector3s(
+        static_cast<short>(blockPos.x * SDF_BLOCK_SIZE + x),
+        static_cast<short>(blockPos.y * SDF_BLOCK_SIZE + y),
+        static_cast<short>(blockPos.z * SDF_BLOCK_SIZE + z)
+      ));
+      m_voxelAddresses.push_back(hashEntry.ptr * SDF_BLOCK_SIZE3 + linearIdx);
+    }
+
+    ++i;
+  }
+}
+
+std::vector<SpaintVoxel::PackedLabel> LabelIndexBenchmark::get_labels() const
+{
+  std::vector<SpaintVoxel::PackedLabel> labels(m_voxelLocations.size());
+  const SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+  for(size_t i = 0, size = m_voxelLocations.size(); i < size; ++i)
+  {
+    labels[i] = voxelData[m_voxelAddresses[i]].packedLabel;
+  }
+  return labels;
+}
+
+void LabelIndexBenchmark::label_random_voxels(const VoxelMarker& marker, int labelledVoxelCount)
+{
+  ORUtils::MemoryBlock<Vector3s> voxelLocationsMB(labelledVoxelCount, true, false);
+  ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> voxelLabelsMB(labelledVoxelCount, true, false);
+  Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+  SpaintVoxel::PackedLabel *voxelLabels = voxelLabelsMB.GetData(MEMORYDEVICE_CPU);
+
+  // Choose a contiguous run of voxels (i.e. a few neighbouring blocks) from which to pick the voxels to label, in much the same way as a
+  // user might repeatedly paint over the same area with a brush. Since the voxels are picked with replacement from a run that is only
+  // twice as long as the number of voxels labelled in each round, the rounds overlap substantially, and the index ends up containing
+  // both duplicate entries and entries for voxels that have since been relabelled.
+  const int voxelCount = static_cast<int>(m_voxelLocations.size());
+  const int runLength = std::min(2 * labelledVoxelCount, voxelCount);
+  const int runStart = m_rng.generate_int_from_uniform(0, voxelCount - runLength);
+
+  for(int round = 0; round < ROUND_COUNT; ++round)
+  {
+    for(int i = 0; i < labelledVoxelCount; ++i)
+    {
+      voxelLocations[i] = m_voxelLocations[runStart + m_rng.generate_int_from_uniform(0, runLength - 1)];
+      voxelLabels[i] = SpaintVoxel::PackedLabel(
+        static_cast<SpaintVoxel::Label>(m_rng.generate_int_from_uniform(0, MAX_LABEL)),
+        static_cast<SpaintVoxel::LabelGroup>(m_rng.generate_int_from_uniform(SpaintVoxel::LG_FOREST, SpaintVoxel::LG_USER))
+      );
+    }
+
+    // Alternate between marking the voxels with a single label and with per-voxel labels, and force the marking in the last round
+    // (as happens when a marking operation is undone) so that labels in the user group can also be overwritten by other labels.
+    const MarkingMode mode = round == ROUND_COUNT - 1 ? FORCED_MARKING : NORMAL_MARKING;
+    if(round % 2 == 0) marker.mark_voxels(voxelLocationsMB, voxelLabels[0], m_scene.get(), NULL, mode);
+    else marker.mark_voxels(voxelLocationsMB, voxelLabelsMB, m_scene.get(), NULL, mode);
+  }
+}
+
+void LabelIndexBenchmark::set_labels(const std::vector<SpaintVoxel::PackedLabel>& labels)
+{
+  SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+  for(size_t i = 0, size = m_voxelLocations.size(); i < size; ++i)
+  {
+    voxelData[m_voxelAddresses[i]].packedLabel = labels[i];
+  }
+}
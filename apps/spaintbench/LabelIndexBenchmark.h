@@ -0,0 +1,121 @@
+/**
+ * spaintbench: LabelIndexBenchmark.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTBENCH_LABELINDEXBENCHMARK
+#define H_SPAINTBENCH_LABELINDEXBENCHMARK
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ITMLib/Utils/ITMLibSettings.h>
+
+#include <spaint/markers/interface/VoxelMarker.h>
+#include <spaint/markers/VoxelLabelIndex.h>
+
+#include <tvgutil/RandomNumberGenerator.h>
+#include <tvgutil/timing/AverageTimer.h>
+
+/**
+ * \brief An instance of this class can be used to compare the time taken to clear labels using the voxel label index with the time
+ *        taken to sweep the whole voxel block array.
+ *
+ * The benchmark uses a CPU-based scene into which a specified number of voxels are allocated directly (in randomly-placed voxel
+ * blocks), rather than one reconstructed from images. In each trial, a random subset of the voxels is labelled in several
+ * overlapping rounds of marking (so that the index ends up containing both duplicate and stale entries), after which the labels are
+ * cleared in each of the supported clearing modes, once using the index and once by sweeping. (The consistency of the index with the
+ * scene is checked by the VoxelLabelIndex unit test rather than here.)
+ */
+class LabelIndexBenchmark
+{
+  //#################### TYPEDEFS ####################
+private:
+  typedef ITMLib::Objects::ITMScene<spaint::SpaintVoxel,ITMVoxelIndex> Scene;
+  typedef boost::shared_ptr<Scene> Scene_Ptr;
+public:
+  typedef tvgutil::AverageTimer<boost::chrono::microseconds> Timer;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The index of the labelled voxels in the scene. */
+  spaint::VoxelLabelIndex_Ptr m_labelIndex;
+
+  /** The random number generator to use when choosing which voxels to label. */
+  tvgutil::RandomNumberGenerator m_rng;
+
+  /** The scene. */
+  Scene_Ptr m_scene;
+
+  /** The settings to use for the scene. */
+  ITMLibSettings m_settings;
+
+  /** The addresses of the allocated voxels in the voxel block array (parallel to m_voxelLocations). */
+  std::vector<int> m_voxelAddresses;
+
+  /** The locations of the allocated voxels in the scene. */
+  std::vector<Vector3s> m_voxelLocations;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a label index benchmark.
+   *
+   * \param voxelCount  The (minimum) number of voxels to allocate in the scene (this is rounded up to a whole number of voxel blocks).
+   * \param seed        The seed to use for the random number generator.
+   */
+  LabelIndexBenchmark(int voxelCount, unsigned int seed);
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  LabelIndexBenchmark(const LabelIndexBenchmark&);
+  LabelIndexBenchmark& operator=(const LabelIndexBenchmark&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Runs the benchmark.
+   *
+   * \param trialCount          The number of trials to run for each clearing mode.
+   * \param labelledVoxelCount  The number of voxels to label in each round of marking.
+   * \return                    The timers for the various operations that were benchmarked, each paired with the name of the clearing mode concerned.
+   */
+  std::vector<std::pair<std::string,Timer> > run(int trialCount, int labelledVoxelCount);
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Allocates voxel blocks in the scene at random positions until it contains at least the specified number of voxels.
+   *
+   * \param voxelCount  The minimum number of voxels to allocate.
+   */
+  void allocate_voxels(int voxelCount);
+
+  /**
+   * \brief Gets the current labels of the allocated voxels in the scene.
+   *
+   * \return  The current labels of the allocated voxels in the scene (parallel to m_voxelLocations).
+   */
+  std::vector<spaint::SpaintVoxel::PackedLabel> get_labels() const;
+
+  /**
+   * \brief Labels random subsets of the allocated voxels in the scene in several overlapping rounds of marking, using a marker that maintains the index.
+   *
+   * \param marker              The voxel marker to use.
+   * \param labelledVoxelCount  The number of voxels to label in each round of marking.
+   */
+  void label_random_voxels(const spaint::VoxelMarker& marker, int labelledVoxelCount);
+
+  /**
+   * \brief Directly sets the labels of the allocated voxels in the scene.
+   *
+   * \param labels  The labels to set (parallel to m_voxelLocations).
+   */
+  void set_labels(const std::vector<spaint::SpaintVoxel::PackedLabel>& labels);
+};
+
+#endif
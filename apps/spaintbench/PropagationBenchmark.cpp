@@ -0,0 +1,245 @@
+/**
+ * spaintbench: PropagationBenchmark.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "PropagationBenchmark.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include <boost/lexical_cast.hpp>
+
+#include <ITMLib/Engine/DeviceSpecific/CPU/ITMSceneReconstructionEngine_CPU.h>
+
+#include <spaint/propagation/cpu/LabelPropagator_CPU.h>
+#include <spaint/propagation/shared/LabelPropagator_Shared.h>
+using namespace spaint;
+
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/** The x coordinate (in voxels) at which the colour of the floor changes. */
+const int COLOUR_BOUNDARY_X = 4;
+
+/** The number of voxel blocks by which the floor extends either side of the origin along each of the x and z axes. */
+const int FLOOR_HALF_EXTENT = 48;
+
+/** The label to propagate. */
+const SpaintVoxel::Label LABEL = 1;
+
+/** The largest angle allowed between the normals of neighbouring voxels if propagation is to occur (as in the pipeline). */
+const float MAX_ANGLE_BETWEEN_NORMALS = static_cast<float>(2.0f * M_PI / 180.0f);
+
+/** The maximum squared distance allowed between the colours of neighbouring voxels if propagation is to occur (as in the pipeline). */
+const float MAX_SQUARED_DISTANCE_BETWEEN_COLOURS = 50.0f * 50.0f;
+
+/** The maximum squared distance allowed between the positions of neighbouring voxels if propagation is to occur (as in the pipeline). */
+const float MAX_SQUARED_DISTANCE_BETWEEN_VOXELS = static_cast<float>(INT_MAX);
+
+//#################### LOCAL FUNCTIONS ####################
+
+/**
+ * \brief Makes a raycast result that looks straight down at the floor, with the specified number of pixels per voxel.
+ *
+ * \param width           The width of the raycast result.
+ * \param height          The height of the raycast result.
+ * \param pixelsPerVoxel  The number of pixels spanned by each voxel along each axis (this can be less than one).
+ * \return                The raycast result.
+ */
+boost::shared_ptr<ITMFloat4Image> make_raycast_result(int width, int height, float pixelsPerVoxel)
+{
+  boost::shared_ptr<ITMFloat4Image> raycastResult(new ITMFloat4Image(Vector2i(width, height), true, false));
+  Vector4f *raycastResultData = raycastResult->GetData(MEMORYDEVICE_CPU);
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      raycastResultData[y * width + x] = Vector4f((x - width / 2 + 0.25f) / pixelsPerVoxel, 0.0f, (y - height / 2 + 0.25f) / pixelsPerVoxel, 1.0f);
+    }
+  }
+  return raycastResult;
+}
+
+}
+
+//#################### CONSTRUCTORS ####################
+
+PropagationBenchmark::PropagationBenchmark()
+{
+  m_scene.reset(new Scene(&m_settings.sceneParams, false, MEMORYDEVICE_CPU));
+
+  ITMSceneReconstructionEngine_CPU<SpaintVoxel,ITMVoxelIndex> sceneReconstructionEngine;
+  sceneReconstructionEngine.ResetScene(m_scene.get());
+
+  make_floor();
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+std::vector<std::pair<std::string,PropagationBenchmark::Timer> > PropagationBenchmark::run(const std::vector<float>& pixelsPerVoxels, int width, int height,
+                                                                                           int trialCount, std::vector<double>& sweepCounts)
+{
+  const ITMVoxelIndex::IndexData *indexData = m_scene->index.getIndexData();
+  const int raycastResultSize = width * height;
+  std::vector<Vector3f> surfaceNormals(raycastResultSize);
+  SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+
+  // Note that the propagator is allowed to run until no more pixels can be labelled, rather than one sweep per call as in the pipeline.
+  LabelPropagator_CPU propagator(raycastResultSize, MAX_ANGLE_BETWEEN_NORMALS, MAX_SQUARED_DISTANCE_BETWEEN_COLOURS, MAX_SQUARED_DISTANCE_BETWEEN_VOXELS, INT_MAX);
+
+  std::vector<std::pair<std::string,Timer> > timers;
+  sweepCounts.clear();
+  for(size_t i = 0, size = pixelsPerVoxels.size(); i < size; ++i)
+  {
+    boost::shared_ptr<ITMFloat4Image> raycastResult = make_raycast_result(width, height, pixelsPerVoxels[i]);
+    const Vector4f *raycastResultData = raycastResult->GetData(MEMORYDEVICE_CPU);
+
+    Timer incrementalTimer("Incremental Propagation"), sweepTimer("Sweep");
+    size_t sweepCount = 0;
+    for(int trial = 0; trial < trialCount; ++trial)
+    {
+      // Propagate the label to its final extent using the incremental propagator.
+      reset_labels(*raycastResult);
+      incrementalTimer.start();
+      propagator.propagate_label(LABEL, raycastResult.get(), m_scene.get());
+      incrementalTimer.stop();
+
+      // Propagate the label to its final extent by sweeping over the raycast result until the labels stop changing.
+      // Each sweep calculates the surface normals and tests every pixel, as the CPU propagator used to on each frame.
+      reset_labels(*raycastResult);
+      std::vector<SpaintVoxel::PackedLabel> labels = get_floor_labels(), oldLabels;
+      do
+      {
+        oldLabels = labels;
+
+        sweepTimer.start();
+
+#ifdef WITH_OPENMP
+        #pragma omp parallel for
+#endif
+        for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+        {
+          write_surface_normal(voxelIndex, raycastResultData, voxelData, indexData, &surfaceNormals[0]);
+        }
+
+#ifdef WITH_OPENMP
+        #pragma omp parallel for
+#endif
+        for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+        {
+          propagate_from_neighbours(
+            voxelIndex, width, height, LABEL, raycastResultData, &surfaceNormals[0], voxelData, indexData,
+            MAX_ANGLE_BETWEEN_NORMALS, MAX_SQUARED_DISTANCE_BETWEEN_COLOURS, MAX_SQUARED_DISTANCE_BETWEEN_VOXELS
+          );
+        }
+
+        sweepTimer.stop();
+        ++sweepCount;
+
+        labels = get_floor_labels();
+      }
+      while(labels != oldLabels);
+    }
+
+    const std::string pixelsPerVoxelString = boost::lexical_cast<std::string>(pixelsPerVoxels[i]);
+    timers.push_back(std::make_pair(pixelsPerVoxelString, incrementalTimer));
+    timers.push_back(std::make_pair(pixelsPerVoxelString, sweepTimer));
+    sweepCounts.push_back(static_cast<double>(sweepCount) / trialCount);
+  }
+
+  return timers;
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+std::vector<SpaintVoxel::PackedLabel> PropagationBenchmark::get_floor_labels() const
+{
+  const ITMVoxelIndex::IndexData *indexData = m_scene->index.getIndexData();
+  const SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+
+  std::vector<SpaintVoxel::PackedLabel> labels;
+  const int limit = FLOOR_HALF_EXTENT * SDF_BLOCK_SIZE;
+  for(int z = -limit; z < limit; ++z)
+  {
+    for(int x = -limit; x < limit; ++x)
+    {
+      bool isFound;
+      SpaintVoxel voxel = readVoxel(voxelData, indexData, Vector3i(x, 0, z), isFound);
+      labels.push_back(isFound ? voxel.packedLabel : SpaintVoxel::PackedLabel());
+    }
+  }
+  return labels;
+}
+
+void PropagationBenchmark::make_floor()
+{
+  ITMHashEntry *hashTable = m_scene->index.GetEntries();
+  int *allocationList = m_scene->localVBA.GetAllocationList();
+  SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+
+  // Allocate two layers of voxel blocks, one either side of the plane y = 0. For simplicity, we only use blocks whose entries
+  // in the ordered part of the hash table are free (a block that collides with one that is already allocated is skipped).
+  for(int bz = -FLOOR_HALF_EXTENT; bz < FLOOR_HALF_EXTENT; ++bz)
+  {
+    for(int by = -1; by <= 0; ++by)
+    {
+      for(int bx = -FLOOR_HALF_EXTENT; bx < FLOOR_HALF_EXTENT; ++bx)
+      {
+        const Vector3s blockPos(static_cast<short>(bx), static_cast<short>(by), static_cast<short>(bz));
+        ITMHashEntry& hashEntry = hashTable[hashIndex(blockPos)];
+        if(hashEntry.ptr >= -1) continue;
+
+        hashEntry.pos = blockPos;
+        hashEntry.offset = 0;
+        hashEntry.ptr = allocationList[m_scene->localVBA.lastFreeBlockId--];
+
+        // Fill in the voxels in the block. The floor's surface lies at y = 0, with free space above it, and its
+        // colour changes abruptly at x = COLOUR_BOUNDARY_X, so that propagation stops part of the way across it.
+        for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+        {
+          const int x = bx * SDF_BLOCK_SIZE + linearIdx % SDF_BLOCK_SIZE;
+          const int y = by * SDF_BLOCK_SIZE + (linearIdx / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE;
+
+          SpaintVoxel& voxel = voxelData[hashEntry.ptr * SDF_BLOCK_SIZE3 + linearIdx];
+          voxel.sdf = SpaintVoxel::SDF_floatToValue(std::max(-1.0f, std::min(1.0f, y / 4.0f)));
+          voxel.w_depth = 1;
+#ifndef USE_LOW_POWER_MODE
+          voxel.clr = x < COLOUR_BOUNDARY_X ? Vector3u(220, 200, 160) : Vector3u(60, 40, 30);
+          voxel.w_color = 1;
+#endif
+        }
+      }
+    }
+  }
+}
+
+void PropagationBenchmark::reset_labels(const ITMFloat4Image& raycastResult)
+{
+  const ITMVoxelIndex::IndexData *indexData = m_scene->index.getIndexData();
+  const Vector4f *raycastResultData = raycastResult.GetData(MEMORYDEVICE_CPU);
+  SpaintVoxel *voxelData = m_scene->localVBA.GetVoxelBlocks();
+  const int width = raycastResult.noDims.x, height = raycastResult.noDims.y;
+
+  const int limit = FLOOR_HALF_EXTENT * SDF_BLOCK_SIZE;
+  for(int z = -limit; z < limit; ++z)
+  {
+    for(int x = -limit; x < limit; ++x)
+    {
+      mark_voxel(Vector3s(static_cast<short>(x), 0, static_cast<short>(z)), SpaintVoxel::PackedLabel(), NULL, voxelData, indexData, FORCED_MARKING);
+    }
+  }
+
+  // Label the voxels visible in a square an eighth of the height of the raycast result, just to the left of its centre.
+  const int seedSize = height / 8;
+  for(int y = (height - seedSize) / 2; y < (height + seedSize) / 2; ++y)
+  {
+    for(int x = width / 2 - 2 * seedSize; x < width / 2 - seedSize; ++x)
+    {
+      const Vector3s loc = raycastResultData[y * width + x].toVector3().toShortRound();
+      mark_voxel(loc, SpaintVoxel::PackedLabel(LABEL, SpaintVoxel::LG_USER), NULL, voxelData, indexData);
+    }
+  }
+}
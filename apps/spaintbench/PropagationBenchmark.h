@@ -0,0 +1,98 @@
+/**
+ * spaintbench: PropagationBenchmark.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTBENCH_PROPAGATIONBENCHMARK
+#define H_SPAINTBENCH_PROPAGATIONBENCHMARK
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ITMLib/Utils/ITMLibSettings.h>
+
+#include <spaint/util/SpaintVoxel.h>
+
+#include <tvgutil/timing/AverageTimer.h>
+
+/**
+ * \brief An instance of this class can be used to compare the time taken to propagate a label across a synthetic plane on the CPU
+ *        using the incremental label propagator with the time taken to do so by sweeping over the entire raycast result.
+ *
+ * The benchmark uses a CPU-based scene containing a flat floor whose colour changes abruptly part of the way across it, and a
+ * synthetic raycast result that looks straight down at the floor. In each trial, the voxels visible in a small square of the
+ * raycast result are labelled as if painted by the user, and the label is then propagated across the floor, once using the
+ * incremental propagator, and once by repeatedly sweeping over the raycast result until the labels stop changing (each sweep
+ * does what the CPU propagator used to do on each frame).
+ */
+class PropagationBenchmark
+{
+  //#################### TYPEDEFS ####################
+private:
+  typedef ITMLib::Objects::ITMScene<spaint::SpaintVoxel,ITMVoxelIndex> Scene;
+  typedef boost::shared_ptr<Scene> Scene_Ptr;
+public:
+  typedef tvgutil::AverageTimer<boost::chrono::microseconds> Timer;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The scene. */
+  Scene_Ptr m_scene;
+
+  /** The settings to use for the scene. */
+  ITMLibSettings m_settings;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a propagation benchmark.
+   */
+  PropagationBenchmark();
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  PropagationBenchmark(const PropagationBenchmark&);
+  PropagationBenchmark& operator=(const PropagationBenchmark&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Runs the benchmark.
+   *
+   * \param pixelsPerVoxels The numbers of pixels spanned by each voxel in the raycast result (one per zoom level to benchmark).
+   * \param width           The width of the raycast result.
+   * \param height          The height of the raycast result.
+   * \param trialCount      The number of trials to run for each zoom level.
+   * \param sweepCounts     A vector into which to write the average number of sweeps needed to reach the final labelling for each zoom level.
+   * \return                The timers for the two ways of propagating the label, each paired with the zoom level concerned (as a string).
+   */
+  std::vector<std::pair<std::string,Timer> > run(const std::vector<float>& pixelsPerVoxels, int width, int height, int trialCount, std::vector<double>& sweepCounts);
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Gets the labels of all of the voxels on the surface of the floor.
+   *
+   * \return  The labels of the voxels on the surface of the floor.
+   */
+  std::vector<spaint::SpaintVoxel::PackedLabel> get_floor_labels() const;
+
+  /**
+   * \brief Makes the floor.
+   */
+  void make_floor();
+
+  /**
+   * \brief Clears the labels of all of the voxels on the surface of the floor, and then labels the voxels that are visible
+   *        in a small square of the specified raycast result, as if they had been painted by the user.
+   *
+   * \param raycastResult The raycast result.
+   */
+  void reset_labels(const ITMFloat4Image& raycastResult);
+};
+
+#endif
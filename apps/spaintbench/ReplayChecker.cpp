@@ -0,0 +1,214 @@
+/**
+ * spaintbench: ReplayChecker.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "ReplayChecker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef WITH_CUDA
+#include <cuda_runtime.h>
+#endif
+
+#include "SyntheticRoomEngine.h"
+
+using namespace spaint;
+
+using namespace tvginput;
+
+//#################### CONSTRUCTORS ####################
+
+ReplayChecker::ReplayChecker(const Pipeline::Settings_Ptr& settings, const std::string& resourcesDir)
+: m_calibrationFilename(resourcesDir + "DefaultCalibration.txt"), m_resourcesDir(resourcesDir), m_settings(settings)
+{}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+size_t ReplayChecker::run(size_t frameCount, std::ostream& os) const
+{
+  const float poseTolerance = 1e-5f;
+
+  Pipeline_Ptr prefetchingPipeline = make_pipeline(frameCount, true);
+  Pipeline_Ptr synchronousPipeline = make_pipeline(frameCount, false);
+
+  size_t mismatchCount = 0;
+  for(size_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+  {
+    // Run the frame through both pipelines. On the first frame, ask the interactors to switch to the touch selector
+    // (this has no effect if touch interaction is not available).
+    InputState inputState;
+    if(frameIndex == 0)
+    {
+      inputState.press_key(KEYCODE_i);
+      inputState.press_key(KEYCODE_4);
+    }
+
+    const bool prefetchingProcessed = run_frame(*prefetchingPipeline, inputState);
+    const bool synchronousProcessed = run_frame(*synchronousPipeline, inputState);
+
+    if(!prefetchingProcessed && !synchronousProcessed)
+    {
+      os << "[spaintbench] The synthetic sequence ended unexpectedly after " << frameIndex << " frames\n";
+      return mismatchCount + frameCount - frameIndex;
+    }
+
+    if(prefetchingProcessed != synchronousProcessed)
+    {
+      os << "[spaintbench] Frame " << frameIndex << ": Only one of the pipelines processed the frame\n";
+      ++mismatchCount;
+      continue;
+    }
+
+    // Check that the two pipelines saw exactly the same view.
+    const Model_Ptr& prefetchedModel = prefetchingPipeline->get_model();
+    const Model_Ptr& synchronousModel = synchronousPipeline->get_model();
+    bool frameMatches = true;
+    if(!views_match(*prefetchedModel->get_view(), *synchronousModel->get_view()))
+    {
+      os << "[spaintbench] Frame " << frameIndex << ": The views differ\n";
+      frameMatches = false;
+    }
+
+    // Check that they tracked the camera to the same pose.
+    const Matrix4f& prefetchedM = prefetchedModel->get_pose().GetM();
+    const Matrix4f& synchronousM = synchronousModel->get_pose().GetM();
+    float maxPoseDifference = 0.0f;
+    for(int y = 0; y < 4; ++y)
+    {
+      for(int x = 0; x < 4; ++x)
+      {
+        maxPoseDifference = std::max(maxPoseDifference, std::fabs(prefetchedM(x,y) - synchronousM(x,y)));
+      }
+    }
+
+    if(maxPoseDifference > poseTolerance)
+    {
+      os << "[spaintbench] Frame " << frameIndex << ": The tracked poses differ (by up to " << maxPoseDifference << ")\n";
+      frameMatches = false;
+    }
+
+    // Check that they fused the frame into the scene in the same way.
+    const SceneChecksums prefetchedChecksums = calculate_scene_checksums(*prefetchedModel->get_scene());
+    const SceneChecksums synchronousChecksums = calculate_scene_checksums(*synchronousModel->get_scene());
+    if(prefetchedChecksums.m_hashChecksum != synchronousChecksums.m_hashChecksum)
+    {
+      os << "[spaintbench] Frame " << frameIndex << ": The voxel hash tables differ\n";
+      frameMatches = false;
+    }
+    else if(prefetchedChecksums.m_sdfChecksum != synchronousChecksums.m_sdfChecksum)
+    {
+      os << "[spaintbench] Frame " << frameIndex << ": The SDF values in the scenes differ\n";
+      frameMatches = false;
+    }
+
+    if(!frameMatches) ++mismatchCount;
+  }
+
+  return mismatchCount;
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+unsigned long long ReplayChecker::hash_bytes(const void *data, size_t size, unsigned long long hash)
+{
+  const unsigned char *bytes = static_cast<const unsigned char*>(data);
+  for(size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+ReplayChecker::SceneChecksums ReplayChecker::calculate_scene_checksums(Model::Scene& scene) const
+{
+  const unsigned long long fnvOffsetBasis = 14695981039346656037ULL;
+
+  // Copy the voxel hash table across to the host.
+  const int entryCount = SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE;
+  std::vector<ITMHashEntry> hashTable(entryCount);
+  copy_to_host(scene.index.GetEntries(), entryCount, &hashTable[0]);
+
+  // Hash the position and voxels of each allocated voxel block. The hashes of the individual blocks are summed, so that the
+  // checksums do not depend on where in the hash table (or the voxel block array) the blocks were allocated.
+  SceneChecksums checksums = { 0, 0 };
+  const SpaintVoxel *voxelData = scene.localVBA.GetVoxelBlocks();
+  std::vector<SpaintVoxel> block(SDF_BLOCK_SIZE3);
+  for(int entryIndex = 0; entryIndex < entryCount; ++entryIndex)
+  {
+    const ITMHashEntry& entry = hashTable[entryIndex];
+    if(entry.ptr < 0) continue;
+
+    const unsigned long long posHash = hash_bytes(&entry.pos, sizeof(entry.pos), fnvOffsetBasis);
+    checksums.m_hashChecksum += posHash;
+
+    copy_to_host(voxelData + entry.ptr * SDF_BLOCK_SIZE3, SDF_BLOCK_SIZE3, &block[0]);
+    unsigned long long blockHash = posHash;
+    for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+    {
+      blockHash = hash_bytes(&block[linearIdx].sdf, sizeof(block[linearIdx].sdf), blockHash);
+      blockHash = hash_bytes(&block[linearIdx].w_depth, sizeof(block[linearIdx].w_depth), blockHash);
+    }
+    checksums.m_sdfChecksum += blockHash;
+  }
+
+  return checksums;
+}
+
+template <typename T>
+void ReplayChecker::copy_to_host(const T *src, size_t count, T *dest) const
+{
+  if(m_settings->deviceType == ITMLibSettings::DEVICE_CUDA)
+  {
+#ifdef WITH_CUDA
+    if(cudaMemcpy(dest, src, count * sizeof(T), cudaMemcpyDeviceToHost) != cudaSuccess)
+    {
+      throw std::runtime_error("Error: Could not copy the scene from the GPU");
+    }
+#else
+    // This should never happen as things stand - we set deviceType to DEVICE_CPU if CUDA support isn't available.
+    throw std::runtime_error("Error: CUDA support not currently available. Reconfigure in CMake with the WITH_CUDA option set to on.");
+#endif
+  }
+  else std::memcpy(dest, src, count * sizeof(T));
+}
+
+
+Pipeline_Ptr ReplayChecker::make_pipeline(size_t frameCount, bool prefetchFrames) const
+{
+  Pipeline::ImageSourceEngine_Ptr imageSourceEngine(new SyntheticRoomEngine(m_calibrationFilename.c_str(), frameCount));
+  return Pipeline_Ptr(new Pipeline(imageSourceEngine, m_settings, m_resourcesDir, prefetchFrames));
+}
+
+bool ReplayChecker::run_frame(Pipeline& pipeline, const InputState& inputState)
+{
+  if(!pipeline.run_main_section()) return false;
+
+  // Update the selector in the same way as the GUI would when rendering in mono.
+  const bool renderingInMono = true;
+  pipeline.get_interactor()->update_selector(inputState, pipeline.get_raycaster()->get_live_render_state(), renderingInMono);
+  return true;
+}
+
+bool ReplayChecker::views_match(ITMView& lhs, ITMView& rhs) const
+{
+  if(m_settings->deviceType == ITMLibSettings::DEVICE_CUDA)
+  {
+    lhs.depth->UpdateHostFromDevice();
+    lhs.rgb->UpdateHostFromDevice();
+    rhs.depth->UpdateHostFromDevice();
+    rhs.rgb->UpdateHostFromDevice();
+  }
+
+  return lhs.depth->dataSize == rhs.depth->dataSize &&
+         lhs.rgb->dataSize == rhs.rgb->dataSize &&
+         std::memcmp(lhs.depth->GetData(MEMORYDEVICE_CPU), rhs.depth->GetData(MEMORYDEVICE_CPU), lhs.depth->dataSize * sizeof(float)) == 0 &&
+         std::memcmp(lhs.rgb->GetData(MEMORYDEVICE_CPU), rhs.rgb->GetData(MEMORYDEVICE_CPU), lhs.rgb->dataSize * sizeof(Vector4u)) == 0;
+}
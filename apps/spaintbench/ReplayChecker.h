@@ -0,0 +1,130 @@
+/**
+ * spaintbench: ReplayChecker.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTBENCH_REPLAYCHECKER
+#define H_SPAINTBENCH_REPLAYCHECKER
+
+#include <ostream>
+#include <string>
+
+#include "core/Pipeline.h"
+
+/**
+ * \brief An instance of this class can be used to check that prefetching frames in the background does not change the results of the pipeline.
+ *
+ * It replays the same synthetic sequence through two pipelines, one of which prefetches its frames in the background and the other
+ * of which acquires each frame synchronously when it is needed, and checks that the views, the tracked camera poses and the fused
+ * scenes of the two pipelines match on every frame. The scenes are compared using checksums of their voxel hash tables and of the
+ * SDF values and weights of their voxels (these are independent of the order in which the voxel blocks were allocated). Each frame, the selectors of both pipelines are also updated in the same way as the GUI would
+ * update them (using the touch selector if touch interaction is available), since a selector that held on to a view would stop
+ * the frames from being prefetched. (In the synchronous pipeline, this makes the acquisition of the next frame throw.)
+ */
+class ReplayChecker
+{
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct holds checksums that summarise the state of a fused scene.
+   */
+  struct SceneChecksums
+  {
+    /** A checksum of the positions of the voxel blocks that are allocated in the voxel hash table. */
+    unsigned long long m_hashChecksum;
+
+    /** A checksum of the SDF values and depth weights of the voxels in the allocated voxel blocks. */
+    unsigned long long m_sdfChecksum;
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The name of the calibration file to use for the synthetic sequence. */
+  std::string m_calibrationFilename;
+
+  /** The path to the resources directory. */
+  std::string m_resourcesDir;
+
+  /** The settings to use for InfiniTAM. */
+  Pipeline::Settings_Ptr m_settings;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a replay checker.
+   *
+   * \param settings      The settings to use for InfiniTAM.
+   * \param resourcesDir  The path to the resources directory.
+   */
+  ReplayChecker(const Pipeline::Settings_Ptr& settings, const std::string& resourcesDir);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Replays the specified number of frames through both pipelines, reporting any frames on which they differ to a stream.
+   *
+   * \param frameCount  The number of frames to replay.
+   * \param os          The stream.
+   * \return            The number of frames on which the pipelines differed (any frames that only one of the pipelines processed count as differing).
+   */
+  size_t run(size_t frameCount, std::ostream& os) const;
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Calculates checksums that summarise the state of the specified fused scene.
+   *
+   * \param scene The scene.
+   * \return      The checksums.
+   */
+  SceneChecksums calculate_scene_checksums(Model::Scene& scene) const;
+
+  /**
+   * \brief Copies the specified number of elements from the scene memory (which may be on the GPU) into a host array.
+   *
+   * \param src   The scene memory from which to copy the elements.
+   * \param count The number of elements to copy.
+   * \param dest  The host array into which to copy the elements.
+   */
+  template <typename T>
+  void copy_to_host(const T *src, size_t count, T *dest) const;
+
+  /**
+   * \brief Makes a pipeline that replays the specified number of frames of the synthetic sequence.
+   *
+   * \param frameCount      The number of frames to replay.
+   * \param prefetchFrames  Whether or not the pipeline should prefetch its frames in the background.
+   * \return                The pipeline.
+   */
+  Pipeline_Ptr make_pipeline(size_t frameCount, bool prefetchFrames) const;
+
+  /**
+   * \brief Updates a 64-bit FNV-1a hash with the specified bytes.
+   *
+   * \param data  The bytes.
+   * \param size  The number of bytes.
+   * \param hash  The hash to update.
+   * \return      The updated hash.
+   */
+  static unsigned long long hash_bytes(const void *data, size_t size, unsigned long long hash);
+
+  /**
+   * \brief Runs the main section of the specified pipeline on the next frame, and then updates the pipeline's selector.
+   *
+   * \param pipeline    The pipeline.
+   * \param inputState  The input state with which to update the selector.
+   * \return            true, if a frame was processed, or false if the pipeline's image source has run out of images.
+   */
+  static bool run_frame(Pipeline& pipeline, const tvginput::InputState& inputState);
+
+  /**
+   * \brief Determines whether or not two views contain exactly the same RGB and depth images.
+   *
+   * \param lhs The first view.
+   * \param rhs The second view.
+   * \return    true, if the views contain exactly the same RGB and depth images, or false otherwise.
+   */
+  bool views_match(ITMView& lhs, ITMView& rhs) const;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * spaintbench: ScriptedPainter.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "ScriptedPainter.h"
+using namespace spaint;
+
+#include <map>
+#include <stdexcept>
+
+#include <boost/assign/list_of.hpp>
+using boost::assign::map_list_of;
+
+#include <spaint/picking/cpu/Picker_CPU.h>
+#ifdef WITH_CUDA
+#include <spaint/picking/cuda/Picker_CUDA.h>
+#endif
+#include <spaint/util/MemoryBlockFactory.h>
+
+#include <tvgutil/commands/NoOpCommand.h>
+using namespace tvgutil;
+
+#include "commands/MarkVoxelsCommand.h"
+
+//#################### CONSTRUCTORS ####################
+
+ScriptedPainter::ScriptedPainter(ITMLibSettings::DeviceType deviceType)
+: m_pickPointFloatMB(MemoryBlockFactory::instance().make_block<Vector3f>(1)),
+  m_pickPointShortMB(MemoryBlockFactory::instance().make_block<Vector3s>(1)),
+  m_rawUndoMemoryUsage(0)
+{
+  // Set up the brushes (one each for a few of the non-background labels, spread out across the lower part of the image).
+  m_brushes.push_back(Brush(0.25f, 0.75f, 1));
+  m_brushes.push_back(Brush(0.5f, 0.75f, 2));
+  m_brushes.push_back(Brush(0.75f, 0.75f, 3));
+  m_brushes.push_back(Brush(0.5f, 0.5f, 4));
+
+  // Make the picker.
+  if(deviceType == ITMLibSettings::DEVICE_CUDA)
+  {
+#ifdef WITH_CUDA
+    m_picker.reset(new Picker_CUDA);
+#else
+    // This should never happen as things stand - we set deviceType to DEVICE_CPU if CUDA support isn't available.
+    throw std::runtime_error("Error: CUDA support not currently available. Reconfigure in CMake with the WITH_CUDA option set to on.");
+#endif
+  }
+  else
+  {
+    m_picker.reset(new Picker_CPU);
+  }
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void ScriptedPainter::output_undo_memory_usage(std::ostream& os) const
+{
+  const size_t journalledUndoMemoryUsage = m_commandManager.memory_usage();
+  os << "[spaintbench] Undo history: " << m_commandManager.executed_count() << " strokes using " << journalledUndoMemoryUsage << " bytes"
+     << " (the raw selections and old labels would have used " << m_rawUndoMemoryUsage << " bytes";
+  if(journalledUndoMemoryUsage > 0) os << ", a reduction by a factor of " << static_cast<double>(m_rawUndoMemoryUsage) / journalledUndoMemoryUsage;
+  os << ")\n";
+}
+
+void ScriptedPainter::paint(const Interactor_Ptr& interactor, const RenderState_CPtr& renderState)
+{
+  // Specify the precursors map for compressible commands (this ensures that all of the marking done by this call is compressed into a single stroke).
+  static const std::string beginMarkVoxelsDesc = "Begin Mark Voxels";
+  static const std::string markVoxelsDesc = MarkVoxelsCommand::get_static_description();
+  static const std::map<std::string,std::string> precursors = map_list_of(beginMarkVoxelsDesc,markVoxelsDesc)(markVoxelsDesc,markVoxelsDesc);
+
+  m_commandManager.execute_command(Command_CPtr(new NoOpCommand(beginMarkVoxelsDesc)));
+
+  const Vector2i& imageSize = renderState->raycastResult->noDims;
+  for(size_t i = 0, size = m_brushes.size(); i < size; ++i)
+  {
+    const Brush& brush = m_brushes[i];
+
+    // Try to pick the voxel under the brush (if the brush is not over any part of the scene, skip it).
+    int x = static_cast<int>(brush.m_x * imageSize.x);
+    int y = static_cast<int>(brush.m_y * imageSize.y);
+    if(!m_picker->pick(x, y, renderState.get(), *m_pickPointFloatMB)) continue;
+    m_picker->to_short(*m_pickPointFloatMB, *m_pickPointShortMB);
+
+    // Expand the picked voxel into a selection using the interactor's selection transformer, just as for a real user, and mark it.
+    Selector::Selection_CPtr selection(interactor->get_selection_transformer()->transform_selection(*m_pickPointShortMB));
+    const SpaintVoxel::PackedLabel packedLabel(brush.m_label, SpaintVoxel::LG_USER);
+    m_commandManager.execute_compressible_command(Command_CPtr(new MarkVoxelsCommand(selection, packedLabel, interactor)), precursors);
+    m_rawUndoMemoryUsage += selection->dataSize * (sizeof(Vector3s) + sizeof(SpaintVoxel::PackedLabel));
+  }
+}
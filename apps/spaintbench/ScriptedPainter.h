@@ -0,0 +1,114 @@
+/**
+ * spaintbench: ScriptedPainter.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTBENCH_SCRIPTEDPAINTER
+#define H_SPAINTBENCH_SCRIPTEDPAINTER
+
+#include <ostream>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <spaint/picking/interface/Picker.h>
+
+#include <tvgutil/commands/CommandManager.h>
+
+#include "core/Interactor.h"
+
+/**
+ * \brief An instance of this class stands in for a user who is painting labels onto the scene.
+ *
+ * Each time it is asked to paint, it marks the voxels under a fixed set of brush positions in the image with fixed labels,
+ * in the same way as the picking selector would if the user were holding the mouse button down at those positions. Since
+ * the camera is moving, the brushes sweep across different surfaces over time, which gives the training and propagation
+ * sections of the pipeline a steady supply of labelled voxels to work with.
+ *
+ * The marking is done via mark voxels commands executed by a command manager with an unbounded history, just as in the GUI
+ * (the marking done by each call to paint is compressed into a single stroke). This allows the memory used by the undo
+ * history to be compared with the memory that would be needed to store the raw selections and old labels instead.
+ */
+class ScriptedPainter
+{
+  //#################### TYPEDEFS ####################
+private:
+  typedef boost::shared_ptr<const ITMLib::Objects::ITMRenderState> RenderState_CPtr;
+
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct represents a brush that is held at a fixed position in the image.
+   */
+  struct Brush
+  {
+    /** The label with which the brush paints. */
+    spaint::SpaintVoxel::Label m_label;
+
+    /** The x coordinate of the brush, as a fraction of the image width. */
+    float m_x;
+
+    /** The y coordinate of the brush, as a fraction of the image height. */
+    float m_y;
+
+    /**
+     * \brief Constructs a brush.
+     *
+     * \param x     The x coordinate of the brush, as a fraction of the image width.
+     * \param y     The y coordinate of the brush, as a fraction of the image height.
+     * \param label The label with which the brush paints.
+     */
+    Brush(float x, float y, spaint::SpaintVoxel::Label label)
+    : m_label(label), m_x(x), m_y(y)
+    {}
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The brushes. */
+  std::vector<Brush> m_brushes;
+
+  /** The command manager used to execute the mark voxels commands. */
+  tvgutil::CommandManager m_commandManager;
+
+  /** The picker used to find the voxels under the brushes. */
+  boost::shared_ptr<const spaint::Picker> m_picker;
+
+  /** A memory block into which to store the pick point for a brush (in Vector3f format). */
+  boost::shared_ptr<ORUtils::MemoryBlock<Vector3f> > m_pickPointFloatMB;
+
+  /** A memory block into which to store the pick point for a brush (in Vector3s format). */
+  spaint::Selector::Selection_Ptr m_pickPointShortMB;
+
+  /** The number of bytes that would have been needed to store the raw selections and old labels of all of the marking done so far. */
+  size_t m_rawUndoMemoryUsage;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a scripted painter.
+   *
+   * \param deviceType  The device on which the scene is stored.
+   */
+  explicit ScriptedPainter(ITMLibSettings::DeviceType deviceType);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Outputs the memory used by the undo history of the marking done so far, and compares it with the memory that
+   *        would be needed to store the raw selections and old labels instead.
+   *
+   * \param os  The stream to which to output the memory usage.
+   */
+  void output_undo_memory_usage(std::ostream& os) const;
+
+  /**
+   * \brief Marks the voxels under each of the brushes with the brush's label.
+   *
+   * \param interactor  The interactor to use to mark the voxels.
+   * \param renderState The render state associated with the camera position from which to paint.
+   */
+  void paint(const Interactor_Ptr& interactor, const RenderState_CPtr& renderState);
+};
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * spaintbench: SyntheticRoomEngine.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "SyntheticRoomEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//#################### CONSTRUCTORS ####################
+
+SyntheticRoomEngine::SyntheticRoomEngine(const char *calibFilename, size_t frameCount, const Vector2i& imageSize)
+: ImageSourceEngine(calibFilename),
+  m_frameCount(frameCount),
+  m_frameIndex(0),
+  m_imageSize(imageSize),
+  m_room(Eigen::Vector3f(-2.5f, -1.5f, -1.0f), Eigen::Vector3f(2.5f, 1.3f, 4.0f), Eigen::Vector3f(0.85f, 0.8f, 0.7f))
+{
+  // Note: Since y points downwards, the floor of the room is 1.3m below the initial camera position.
+  m_boxes.push_back(Box(Eigen::Vector3f(-0.7f, 0.55f, 1.6f), Eigen::Vector3f(0.7f, 1.3f, 2.4f), Eigen::Vector3f(0.6f, 0.4f, 0.2f)));  // a table
+  m_boxes.push_back(Box(Eigen::Vector3f(1.3f, 0.1f, 2.6f), Eigen::Vector3f(2.5f, 1.3f, 4.0f), Eigen::Vector3f(0.3f, 0.4f, 0.7f)));    // a cabinet
+  m_spheres.push_back(Sphere(Eigen::Vector3f(0.0f, 0.35f, 2.0f), 0.2f, Eigen::Vector3f(0.9f, 0.2f, 0.2f)));                          // a ball on the table
+  m_spheres.push_back(Sphere(Eigen::Vector3f(-1.4f, 1.0f, 2.5f), 0.3f, Eigen::Vector3f(0.2f, 0.8f, 0.3f)));                          // a ball on the floor
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+Vector2i SyntheticRoomEngine::getDepthImageSize(void)
+{
+  return m_imageSize;
+}
+
+void SyntheticRoomEngine::getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth)
+{
+  Eigen::Matrix3f R;
+  Eigen::Vector3f t;
+  calculate_camera_pose(m_frameIndex++, R, t);
+
+  const int width = m_imageSize.x, height = m_imageSize.y;
+  const float depthFx = calib.intrinsics_d.projectionParamsSimple.fx, depthFy = calib.intrinsics_d.projectionParamsSimple.fy;
+  const float depthPx = calib.intrinsics_d.projectionParamsSimple.px, depthPy = calib.intrinsics_d.projectionParamsSimple.py;
+  const float rgbFx = calib.intrinsics_rgb.projectionParamsSimple.fx, rgbFy = calib.intrinsics_rgb.projectionParamsSimple.fy;
+  const float rgbPx = calib.intrinsics_rgb.projectionParamsSimple.px, rgbPy = calib.intrinsics_rgb.projectionParamsSimple.py;
+  const Vector2f disparityParams = calib.disparityCalib.params;
+  Vector4u *rgbData = rgb->GetData(MEMORYDEVICE_CPU);
+  short *depthData = rawDepth->GetData(MEMORYDEVICE_CPU);
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      // Render the depth pixel. Since the z component of the ray direction in camera coordinates is 1, the distance along the
+      // ray to the surface is the depth. The depth is encoded as a raw disparity in the same way as the view builder decodes it.
+      Eigen::Vector3f direction = R * Eigen::Vector3f((x - depthPx) / depthFx, (y - depthPy) / depthFy, 1.0f);
+      const float depth = cast_ray(t, direction).m_distance;
+      const float disparity = disparityParams.x - 8.0f * disparityParams.y * depthFx / depth;
+      depthData[y * width + x] = static_cast<short>(std::max(disparity, 0.0f) + 0.5f);
+
+      // Render the RGB pixel.
+      direction = R * Eigen::Vector3f((x - rgbPx) / rgbFx, (y - rgbPy) / rgbFy, 1.0f);
+      const Hit hit = cast_ray(t, direction);
+      rgbData[y * width + x] = shade(hit, t + hit.m_distance * direction);
+    }
+  }
+}
+
+Vector2i SyntheticRoomEngine::getRGBImageSize(void)
+{
+  return m_imageSize;
+}
+
+bool SyntheticRoomEngine::hasMoreImages(void)
+{
+  return m_frameIndex < m_frameCount;
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void SyntheticRoomEngine::calculate_camera_pose(size_t frameIndex, Eigen::Matrix3f& R, Eigen::Vector3f& t) const
+{
+  // Pan from side to side and tilt up and down, whilst drifting sideways and forwards. The periods are chosen to be mutually
+  // prime-ish so that the trajectory does not repeat for a long time, and all of the motions are zero in the first frame.
+  const float twoPi = 2.0f * static_cast<float>(M_PI);
+  const float f = static_cast<float>(frameIndex);
+  const float yaw = 0.35f * sinf(twoPi * f / 240.0f);
+  const float pitch = 0.1f * sinf(twoPi * f / 310.0f);
+  R = Eigen::AngleAxisf(yaw, Eigen::Vector3f::UnitY()) * Eigen::AngleAxisf(pitch, Eigen::Vector3f::UnitX());
+  t = Eigen::Vector3f(0.3f * sinf(twoPi * f / 370.0f), 0.0f, 0.2f * (1.0f - cosf(twoPi * f / 490.0f)));
+}
+
+SyntheticRoomEngine::Hit SyntheticRoomEngine::cast_ray(const Eigen::Vector3f& origin, const Eigen::Vector3f& direction) const
+{
+  Hit hit;
+
+  // Find the point at which the ray leaves the room (since the camera is inside the room, this is the furthest the ray can go).
+  hit.m_albedo = m_room.m_albedo;
+  hit.m_distance = std::numeric_limits<float>::max();
+  for(int i = 0; i < 3; ++i)
+  {
+    if(direction[i] == 0.0f) continue;
+
+    const float distance = ((direction[i] > 0.0f ? m_room.m_maxs[i] : m_room.m_mins[i]) - origin[i]) / direction[i];
+    if(distance < hit.m_distance)
+    {
+      hit.m_distance = distance;
+      hit.m_normal = Eigen::Vector3f::Zero();
+      hit.m_normal[i] = direction[i] > 0.0f ? -1.0f : 1.0f;
+    }
+  }
+
+  // Check whether the ray hits any of the boxes before that (using the slab method).
+  for(size_t j = 0, size = m_boxes.size(); j < size; ++j)
+  {
+    const Box& box = m_boxes[j];
+    float nearDistance = 0.0f, farDistance = hit.m_distance;
+    int nearAxis = -1;
+    bool missed = false;
+    for(int i = 0; i < 3 && !missed; ++i)
+    {
+      if(direction[i] == 0.0f)
+      {
+        missed = origin[i] < box.m_mins[i] || origin[i] > box.m_maxs[i];
+        continue;
+      }
+
+      float d0 = (box.m_mins[i] - origin[i]) / direction[i];
+      float d1 = (box.m_maxs[i] - origin[i]) / direction[i];
+      if(d0 > d1) std::swap(d0, d1);
+      if(d0 > nearDistance)
+      {
+        nearDistance = d0;
+        nearAxis = i;
+      }
+      farDistance = std::min(farDistance, d1);
+      missed = nearDistance > farDistance;
+    }
+
+    // Note: A near axis of -1 would mean that the camera was inside the box, which cannot happen in practice.
+    if(!missed && nearAxis != -1 && nearDistance < hit.m_distance)
+    {
+      hit.m_albedo = box.m_albedo;
+      hit.m_distance = nearDistance;
+      hit.m_normal = Eigen::Vector3f::Zero();
+      hit.m_normal[nearAxis] = direction[nearAxis] > 0.0f ? -1.0f : 1.0f;
+    }
+  }
+
+  // Check whether the ray hits any of the spheres before that.
+  for(size_t j = 0, size = m_spheres.size(); j < size; ++j)
+  {
+    const Sphere& sphere = m_spheres[j];
+    const Eigen::Vector3f offset = origin - sphere.m_centre;
+    const float a = direction.squaredNorm();
+    const float b = offset.dot(direction);
+    const float c = offset.squaredNorm() - sphere.m_radius * sphere.m_radius;
+    const float discriminant = b * b - a * c;
+    if(discriminant < 0.0f) continue;
+
+    const float distance = (-b - sqrtf(discriminant)) / a;
+    if(distance > 0.0f && distance < hit.m_distance)
+    {
+      hit.m_albedo = sphere.m_albedo;
+      hit.m_distance = distance;
+      hit.m_normal = (offset + distance * direction) / sphere.m_radius;
+    }
+  }
+
+  return hit;
+}
+
+Vector4u SyntheticRoomEngine::shade(const Hit& hit, const Eigen::Vector3f& p) const
+{
+  // Apply a checkered texture with 20cm squares. The texture is looked up half a square behind the surface, since otherwise
+  // faces that happen to lie on a square boundary would flicker between the two shades due to rounding errors.
+  const float squareSize = 0.2f;
+  const Eigen::Vector3f q = (p - 0.5f * squareSize * hit.m_normal) / squareSize;
+  const int parity = static_cast<int>(floorf(q.x())) + static_cast<int>(floorf(q.y())) + static_cast<int>(floorf(q.z()));
+  const float texture = (parity & 1) ? 1.0f : 0.7f;
+
+  // Light the surface using some ambient light and a single directional light from above and behind the initial camera position.
+  const Eigen::Vector3f towardsLight = Eigen::Vector3f(0.3f, -1.0f, -0.5f).normalized();
+  const float lighting = 0.35f + 0.65f * std::max(hit.m_normal.dot(towardsLight), 0.0f);
+
+  const Eigen::Vector3f colour = (255.0f * texture * lighting) * hit.m_albedo;
+  return Vector4u(
+    static_cast<unsigned char>(std::min(colour.x(), 255.0f)),
+    static_cast<unsigned char>(std::min(colour.y(), 255.0f)),
+    static_cast<unsigned char>(std::min(colour.z(), 255.0f)),
+    255
+  );
+}
@@ -0,0 +1,176 @@
+/**
+ * spaintbench: SyntheticRoomEngine.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTBENCH_SYNTHETICROOMENGINE
+#define H_SPAINTBENCH_SYNTHETICROOMENGINE
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <Engine/ImageSourceEngine.h>
+
+/**
+ * \brief An instance of this class can be used to provide synthetic RGB-D images of a procedural room to the spaint pipeline.
+ *
+ * The room is a large box containing a few simple objects (a table, a cabinet and two balls), each with a checkered texture
+ * so that the colour features have some structure to them. The images are rendered on the CPU by casting a ray through each
+ * pixel, from a camera that slowly pans and translates around its starting position (slowly enough for ICP tracking to follow it).
+ * The world coordinate system is that of the camera in the first frame (x right, y down, z forwards), which is also the one that
+ * InfiniTAM uses for its scene.
+ *
+ * The depth images are encoded as raw Kinect-style disparities using the disparity calibration loaded from the calibration file,
+ * so that the view builder can convert them back into depths in the usual way. For simplicity, both images are rendered from the
+ * same camera centre (using their respective intrinsics), i.e. the small translation between the RGB and depth cameras is ignored.
+ */
+class SyntheticRoomEngine : public InfiniTAM::Engine::ImageSourceEngine
+{
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct represents a solid axis-aligned box in the room.
+   */
+  struct Box
+  {
+    /** The colour of the box (each component in [0,1]). */
+    Eigen::Vector3f m_albedo;
+
+    /** The maximum corner of the box. */
+    Eigen::Vector3f m_maxs;
+
+    /** The minimum corner of the box. */
+    Eigen::Vector3f m_mins;
+
+    /**
+     * \brief Constructs a box.
+     *
+     * \param mins    The minimum corner of the box.
+     * \param maxs    The maximum corner of the box.
+     * \param albedo  The colour of the box (each component in [0,1]).
+     */
+    Box(const Eigen::Vector3f& mins, const Eigen::Vector3f& maxs, const Eigen::Vector3f& albedo)
+    : m_albedo(albedo), m_maxs(maxs), m_mins(mins)
+    {}
+  };
+
+  /**
+   * \brief An instance of this struct represents the nearest surface hit by a ray.
+   */
+  struct Hit
+  {
+    /** The colour of the surface (each component in [0,1]). */
+    Eigen::Vector3f m_albedo;
+
+    /** The distance along the ray at which the surface was hit (in units of the ray direction). */
+    float m_distance;
+
+    /** The unit normal of the surface at the hit point. */
+    Eigen::Vector3f m_normal;
+  };
+
+  /**
+   * \brief An instance of this struct represents a solid sphere in the room.
+   */
+  struct Sphere
+  {
+    /** The colour of the sphere (each component in [0,1]). */
+    Eigen::Vector3f m_albedo;
+
+    /** The centre of the sphere. */
+    Eigen::Vector3f m_centre;
+
+    /** The radius of the sphere. */
+    float m_radius;
+
+    /**
+     * \brief Constructs a sphere.
+     *
+     * \param centre  The centre of the sphere.
+     * \param radius  The radius of the sphere.
+     * \param albedo  The colour of the sphere (each component in [0,1]).
+     */
+    Sphere(const Eigen::Vector3f& centre, float radius, const Eigen::Vector3f& albedo)
+    : m_albedo(albedo), m_centre(centre), m_radius(radius)
+    {}
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The solid boxes in the room. */
+  std::vector<Box> m_boxes;
+
+  /** The number of frames to provide. */
+  size_t m_frameCount;
+
+  /** The index of the next frame to provide. */
+  size_t m_frameIndex;
+
+  /** The size of the images to provide. */
+  Vector2i m_imageSize;
+
+  /** The box bounding the room itself (the camera is inside this). */
+  Box m_room;
+
+  /** The solid spheres in the room. */
+  std::vector<Sphere> m_spheres;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a synthetic room engine.
+   *
+   * \param calibFilename The name of a file containing InfiniTAM calibration settings.
+   * \param frameCount    The number of frames to provide.
+   * \param imageSize     The size of the images to provide (this should match the image sizes in the calibration file).
+   */
+  SyntheticRoomEngine(const char *calibFilename, size_t frameCount, const Vector2i& imageSize = Vector2i(640, 480));
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /** Override */
+  virtual Vector2i getDepthImageSize(void);
+
+  /** Override */
+  virtual void getImages(ITMUChar4Image *rgb, ITMShortImage *rawDepth);
+
+  /** Override */
+  virtual Vector2i getRGBImageSize(void);
+
+  /** Override */
+  virtual bool hasMoreImages(void);
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Calculates the pose of the camera in the specified frame.
+   *
+   * \param frameIndex  The index of the frame.
+   * \param R           The rotation of the camera (mapping camera directions to world directions).
+   * \param t           The position of the camera in the world.
+   */
+  void calculate_camera_pose(size_t frameIndex, Eigen::Matrix3f& R, Eigen::Vector3f& t) const;
+
+  /**
+   * \brief Finds the nearest surface in the room that is hit by the specified ray.
+   *
+   * Since the camera is always inside the room, every ray hits something.
+   *
+   * \param origin    The origin of the ray.
+   * \param direction The direction of the ray (not necessarily of unit length).
+   * \return          The nearest surface hit by the ray.
+   */
+  Hit cast_ray(const Eigen::Vector3f& origin, const Eigen::Vector3f& direction) const;
+
+  /**
+   * \brief Shades a surface point.
+   *
+   * \param hit The hit record for the surface point.
+   * \param p   The position of the surface point.
+   * \return    The colour of the surface point.
+   */
+  Vector4u shade(const Hit& hit, const Eigen::Vector3f& p) const;
+};
+
+#endif
@@ -0,0 +1,576 @@
+/**
+ * spaintbench: main.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <spaint/features/cpu/VOPFeatureKernels_CPU.h>
+#include <spaint/util/MemoryBlockFactory.h>
+using namespace spaint;
+
+#include <tvgutil/ExecutableFinder.h>
+using namespace tvgutil;
+
+#include "core/Pipeline.h"
+#include "FeatureBenchmark.h"
+#include "KernelBenchmark.h"
+#include "LabelIndexBenchmark.h"
+#include "PropagationBenchmark.h"
+#include "ReplayChecker.h"
+#include "ScriptedPainter.h"
+#include "SyntheticRoomEngine.h"
+
+//#################### TYPEDEFS ####################
+
+typedef void (*BenchmarkRunner)(const std::string&);
+typedef Pipeline::StageTimer StageTimer;
+typedef FeatureBenchmark::Timer Timer;
+
+//#################### TYPES ####################
+
+/**
+ * \brief An instance of this struct describes one of the single-argument modes of spaintbench (e.g. --cache).
+ */
+struct BenchmarkMode
+{
+  /** A description of the argument that the mode expects (e.g. "output CSV file"). */
+  std::string argumentDescription;
+
+  /** The name of the mode (for use in error messages). */
+  std::string name;
+
+  /** The function that runs the mode, given its argument. */
+  BenchmarkRunner runner;
+
+  BenchmarkMode(const std::string& name_, const std::string& argumentDescription_, BenchmarkRunner runner_)
+  : argumentDescription(argumentDescription_), name(name_), runner(runner_)
+  {}
+};
+
+//#################### FUNCTIONS ####################
+
+/**
+ * \brief Writes a row of timing results to a CSV stream.
+ *
+ * \param os        The CSV stream.
+ * \param modeName  The name of the mode in which the pipeline was running.
+ * \param section   The name of the section or stage of the pipeline that was timed.
+ * \param count     The number of times the section or stage was run.
+ * \param total     The total time spent in the section or stage.
+ */
+void write_row(std::ostream& os, const std::string& modeName, const std::string& section, size_t count, const boost::chrono::microseconds& total)
+{
+  const double average = count > 0 ? static_cast<double>(total.count()) / count : 0.0;
+  os << modeName << ',' << section << ',' << count << ',' << average << ',' << total.count() << '\n';
+}
+
+/**
+ * \brief Writes a set of benchmark timings to a CSV file, one row per timer.
+ *
+ * \param outputFilename   The name of the CSV file.
+ * \param firstColumnName  The name of the first column (i.e. of the benchmark parameter with which each timer is paired).
+ * \param timers           The timers, each paired with the value of the benchmark parameter concerned (as a string).
+ */
+void write_timers_csv(const std::string& outputFilename, const std::string& firstColumnName, const std::vector<std::pair<std::string,Timer> >& timers)
+{
+  std::ofstream fs(outputFilename.c_str());
+  if(!fs) throw std::runtime_error("Error: Could not open '" + outputFilename + "' for writing");
+  fs << firstColumnName << ",section,count,average_us,total_us\n";
+
+  for(size_t i = 0, size = timers.size(); i < size; ++i)
+  {
+    const Timer& timer = timers[i].second;
+    write_row(fs, timers[i].first, timer.name(), timer.count(), timer.total_duration());
+  }
+}
+
+/**
+ * \brief Makes sure that any memory blocks made using the memory block factory are only allocated on the CPU.
+ *
+ * This is needed by the benchmarks that use the feature calculators or the label propagator, which make their memory blocks
+ * using the memory block factory.
+ */
+void use_cpu_memory_blocks()
+{
+  MemoryBlockFactory::instance().set_device_type(ITMLibSettings::DEVICE_CPU);
+}
+
+/**
+ * \brief Runs the feature cache benchmark, and writes its timings to a CSV file.
+ *
+ * The benchmark replays a static scene in which the same set of voxels is visible on every frame, and compares the time taken
+ * to calculate feature descriptors for voxels sampled from them with and without a feature cache, for various maximum ages of
+ * the cached descriptors. It also reports the hit rate of the cache for each maximum age.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_cache_benchmark(const std::string& outputFilename)
+{
+  const int voxelCount = 8192;
+  const int frameCount = 100;
+  const unsigned int seed = 12345;
+
+  std::vector<int> maxAges;
+  maxAges.push_back(1);
+  maxAges.push_back(10);
+  maxAges.push_back(30);
+  maxAges.push_back(100);
+
+  use_cpu_memory_blocks();
+
+  std::cout << "[spaintbench] Benchmarking the feature cache over " << frameCount << " frames of a static scene (" << voxelCount << " voxels per frame)...\n";
+  FeatureBenchmark benchmark(seed);
+  std::vector<double> hitRates;
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run_cache(maxAges, voxelCount, frameCount, hitRates);
+
+  write_timers_csv(outputFilename, "max_age", timers);
+
+  // The timers come in (uncached, cached) pairs, one pair per maximum age.
+  for(size_t i = 0, size = maxAges.size(); i < size; ++i)
+  {
+    const boost::chrono::microseconds timeSaved = timers[i * 2].second.total_duration() - timers[i * 2 + 1].second.total_duration();
+    std::cout << "[spaintbench] Maximum age " << maxAges[i] << ": hit rate " << hitRates[i] * 100.0 << "%, saving "
+              << timeSaved.count() / 1000.0 << "ms in total (" << timeSaved.count() / 1000.0 / frameCount << "ms per frame)\n";
+  }
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Runs the CPU feature calculation benchmark, and writes its timings to a CSV file.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_feature_benchmark(const std::string& outputFilename)
+{
+  const int trialCount = 20;
+  const unsigned int seed = 12345;
+
+  std::vector<int> voxelCounts;
+  voxelCounts.push_back(512);
+  voxelCounts.push_back(8192);
+  voxelCounts.push_back(32768);
+
+  use_cpu_memory_blocks();
+
+  std::cout << "[spaintbench] Benchmarking the calculation of feature descriptors on the CPU...\n";
+  FeatureBenchmark benchmark(seed);
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run(voxelCounts, trialCount);
+
+  write_timers_csv(outputFilename, "voxels", timers);
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Runs the VOP feature kernel benchmark, and writes its timings to a CSV file.
+ *
+ * The benchmark measures the time taken by each of the per-patch kernels with each instruction set supported by the CPU,
+ * for each odd patch size from 7 to 21.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_kernel_benchmark(const std::string& outputFilename)
+{
+  const int patchCount = 8192;
+  const int binCount = 36;
+  const int trialCount = 10;
+  const unsigned int seed = 12345;
+
+  std::vector<int> patchSizes;
+  for(int patchSize = 7; patchSize <= 21; patchSize += 2)
+  {
+    patchSizes.push_back(patchSize);
+  }
+
+  std::cout << "[spaintbench] Benchmarking the VOP feature kernels on " << patchCount << " patches (best instruction set: "
+            << VOPFeatureKernels_CPU::get_instruction_set_name(VOPFeatureKernels_CPU::get_best_instruction_set()) << ")...\n";
+  KernelBenchmark benchmark(seed);
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run(patchSizes, patchCount, binCount, trialCount);
+
+  write_timers_csv(outputFilename, "patch_size", timers);
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Runs the multi-scale feature calculation benchmark, and writes its timings to a CSV file.
+ *
+ * The benchmark measures the time taken to calculate multi-scale VOP feature descriptors with one, two and three scales
+ * (doubling the patch spacing for each successive scale), compared to the time taken to calculate single-scale descriptors.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_multiscale_benchmark(const std::string& outputFilename)
+{
+  const int voxelCount = 8192;
+  const int trialCount = 10;
+  const unsigned int seed = 12345;
+
+  use_cpu_memory_blocks();
+
+  // Use the same base patch spacing as the pipeline.
+  std::vector<float> patchSpacings;
+  const float basePatchSpacing = 0.01f / ITMLibSettings().sceneParams.voxelSize;
+  patchSpacings.push_back(basePatchSpacing);
+  patchSpacings.push_back(basePatchSpacing * 2);
+  patchSpacings.push_back(basePatchSpacing * 4);
+
+  std::cout << "[spaintbench] Benchmarking the calculation of multi-scale feature descriptors for " << voxelCount << " voxels...\n";
+  FeatureBenchmark benchmark(seed);
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run_multiscale(patchSpacings, voxelCount, trialCount);
+
+  write_timers_csv(outputFilename, "scales", timers);
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Runs the patch gathering benchmark, and writes its timings to a CSV file.
+ *
+ * The benchmark compares gathering the RGB patches for the feature descriptors by performing a full hash lookup for every sample
+ * with gathering them via a patch block cache (both with and without first sorting the voxels into tiles), for each odd patch size
+ * from 7 to 21. It also reports the average number of hash lookups that the cache needed to perform for each patch.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_patch_gathering_benchmark(const std::string& outputFilename)
+{
+  const int voxelCount = 8192;
+  const int trialCount = 10;
+  const unsigned int seed = 12345;
+
+  std::vector<int> patchSizes;
+  for(int patchSize = 7; patchSize <= 21; patchSize += 2)
+  {
+    patchSizes.push_back(patchSize);
+  }
+
+  std::cout << "[spaintbench] Benchmarking the gathering of RGB patches for " << voxelCount << " voxels...\n";
+  FeatureBenchmark benchmark(seed);
+  std::vector<double> lookupsPerPatch;
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run_patch_gathering(patchSizes, voxelCount, trialCount, lookupsPerPatch);
+
+  write_timers_csv(outputFilename, "patch_size", timers);
+
+  for(size_t i = 0, size = patchSizes.size(); i < size; ++i)
+  {
+    std::cout << "[spaintbench] Patch size " << patchSizes[i] << ": " << lookupsPerPatch[i] << " hash lookups per patch on average (vs. "
+              << patchSizes[i] * patchSizes[i] << " without the cache)\n";
+  }
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Runs the label propagation benchmark, and writes its timings to a CSV file.
+ *
+ * The benchmark compares the time taken to propagate a label across a synthetic plane to its final extent using the incremental
+ * CPU propagator with the time taken by each sweep over the whole raycast result (as the CPU propagator used to perform once per
+ * frame), for various zoom levels. It also reports the number of sweeps (i.e. frames) that were needed to reach the final extent.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_propagation_benchmark(const std::string& outputFilename)
+{
+  const int width = 640, height = 480;
+  const int trialCount = 3;
+
+  std::vector<float> pixelsPerVoxels;
+  pixelsPerVoxels.push_back(1.0f);
+  pixelsPerVoxels.push_back(2.0f);
+  pixelsPerVoxels.push_back(4.0f);
+  pixelsPerVoxels.push_back(8.0f);
+
+  use_cpu_memory_blocks();
+
+  std::cout << "[spaintbench] Benchmarking the propagation of a label across a synthetic plane (" << width << 'x' << height << " raycast result)...\n";
+  PropagationBenchmark benchmark;
+  std::vector<double> sweepCounts;
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run(pixelsPerVoxels, width, height, trialCount, sweepCounts);
+
+  write_timers_csv(outputFilename, "pixels_per_voxel", timers);
+
+  for(size_t i = 0, size = pixelsPerVoxels.size(); i < size; ++i)
+  {
+    std::cout << "[spaintbench] " << pixelsPerVoxels[i] << " pixel(s) per voxel: " << sweepCounts[i] << " sweeps needed on average to reach the final extent of the label\n";
+  }
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Replays the synthetic sequence through pipelines with and without frame prefetching, and checks that their results match.
+ *
+ * \param frameCountString  The number of frames to replay (as a string).
+ * \throws std::runtime_error If the results of the pipelines differed on any frame.
+ */
+void run_replay_check(const std::string& frameCountString)
+{
+  const size_t frameCount = boost::lexical_cast<size_t>(frameCountString);
+
+  Pipeline::Settings_Ptr settings(new ITMLibSettings);
+  MemoryBlockFactory::instance().set_device_type(settings->deviceType);
+
+  std::cout << "[spaintbench] Replaying " << frameCount << " synthetic frames with and without frame prefetching...\n";
+  const std::string resourcesDir = (find_executable().parent_path() / "resources/").string();
+  ReplayChecker checker(settings, resourcesDir);
+  const size_t mismatchCount = checker.run(frameCount, std::cout);
+
+  if(mismatchCount != 0) throw std::runtime_error("Error: The views or poses differed on " + boost::lexical_cast<std::string>(mismatchCount) + " frame(s)");
+  std::cout << "[spaintbench] The views and poses matched on every frame\n";
+}
+
+/**
+ * \brief Runs the feature subset benchmark, and writes its timings to a CSV file.
+ *
+ * The benchmark compares the time taken to calculate full VOP feature descriptors with the time taken to calculate random
+ * subsets of their features of various sizes, as would be needed by forests that only use some of the features.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_subset_benchmark(const std::string& outputFilename)
+{
+  const int voxelCount = 8192;
+  const int trialCount = 10;
+  const unsigned int seed = 12345;
+
+  use_cpu_memory_blocks();
+
+  std::vector<int> subsetSizes;
+  subsetSizes.push_back(16);
+  subsetSizes.push_back(64);
+  subsetSizes.push_back(128);
+  subsetSizes.push_back(256);
+  subsetSizes.push_back(511);
+
+  std::cout << "[spaintbench] Benchmarking the calculation of feature subsets for " << voxelCount << " voxels...\n";
+  FeatureBenchmark benchmark(seed);
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run_subset(subsetSizes, voxelCount, trialCount);
+
+  write_timers_csv(outputFilename, "subset_size", timers);
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Runs the voxel label index benchmark, and writes its timings to a CSV file.
+ *
+ * \param outputFilename  The name of the CSV file.
+ */
+void run_label_index_benchmark(const std::string& outputFilename)
+{
+  const int voxelCount = 1000000;
+  const int trialCount = 10;
+  const int labelledVoxelCount = 10000;
+  const unsigned int seed = 12345;
+
+  std::cout << "[spaintbench] Benchmarking the voxel label index in a scene with " << voxelCount << " allocated voxels...\n";
+  LabelIndexBenchmark benchmark(voxelCount, seed);
+  std::vector<std::pair<std::string,Timer> > timers = benchmark.run(trialCount, labelledVoxelCount);
+
+  write_timers_csv(outputFilename, "mode", timers);
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+}
+
+/**
+ * \brief Runs the pipeline in the specified mode for up to the specified number of frames, and writes the timings for the mode to a CSV stream.
+ *
+ * In the modes that need labelled voxels (training, train-and-predict and propagation), the scripted painter is used to label
+ * some voxels each frame before the mode-specific section of the pipeline is run, just as a user would in the GUI. The time
+ * spent painting is reported separately and is not included in the time for the frame.
+ *
+ * \param pipeline    The pipeline.
+ * \param mode        The mode in which to run the pipeline.
+ * \param modeName    The name of the mode (for use in the results).
+ * \param frameCount  The maximum number of frames for which to run the pipeline.
+ * \param painter     The scripted painter.
+ * \param os          The CSV stream.
+ * \return            The number of frames that were processed (fewer than frameCount only if the image source ran out of images).
+ */
+size_t run_mode(Pipeline& pipeline, Pipeline::Mode mode, const std::string& modeName, size_t frameCount, ScriptedPainter& painter, std::ostream& os)
+{
+  pipeline.set_mode(mode);
+  const bool paint = mode == Pipeline::MODE_TRAINING || mode == Pipeline::MODE_TRAIN_AND_PREDICT || mode == Pipeline::MODE_PROPAGATION;
+
+  // Since the pipeline's own timers accumulate over the lifetime of the pipeline, take a snapshot of them beforehand
+  // so that we can report the timings for this mode alone.
+  std::vector<StageTimer> stageTimersBefore = pipeline.get_stage_timers();
+  StageTimer mainSectionTimer("Main Section"), modeSpecificSectionTimer("Mode-Specific Section"), paintingTimer("Painting");
+
+  size_t frameIndex = 0;
+  for(; frameIndex < frameCount; ++frameIndex)
+  {
+    mainSectionTimer.start();
+    if(!pipeline.run_main_section()) break;
+    mainSectionTimer.stop();
+
+    const Raycaster::RenderState_Ptr& renderState = pipeline.get_raycaster()->get_live_render_state();
+    if(paint)
+    {
+      paintingTimer.start();
+      painter.paint(pipeline.get_interactor(), renderState);
+      paintingTimer.stop();
+    }
+
+    modeSpecificSectionTimer.start();
+    pipeline.run_mode_specific_section(renderState);
+    modeSpecificSectionTimer.stop();
+  }
+
+  // Write the timings for the whole frame and for the two sections of the pipeline.
+  write_row(os, modeName, "Frame", frameIndex, mainSectionTimer.total_duration() + modeSpecificSectionTimer.total_duration());
+  write_row(os, modeName, mainSectionTimer.name(), mainSectionTimer.count(), mainSectionTimer.total_duration());
+  write_row(os, modeName, modeSpecificSectionTimer.name(), modeSpecificSectionTimer.count(), modeSpecificSectionTimer.total_duration());
+  if(paint) write_row(os, modeName, paintingTimer.name(), paintingTimer.count(), paintingTimer.total_duration());
+
+  // Write the timings for the individual stages and sections of the pipeline that were run in this mode.
+  std::vector<StageTimer> stageTimersAfter = pipeline.get_stage_timers();
+  for(size_t i = 0, size = stageTimersAfter.size(); i < size; ++i)
+  {
+    const size_t count = stageTimersAfter[i].count() - stageTimersBefore[i].count();
+    if(count > 0) write_row(os, modeName, stageTimersAfter[i].name(), count, stageTimersAfter[i].total_duration() - stageTimersBefore[i].total_duration());
+  }
+
+  return frameIndex;
+}
+
+/**
+ * \brief Sets up a set of dummy labels for the benchmark (the same ones that the GUI falls back on if it has no labels file).
+ *
+ * \param labelManager  The label manager.
+ */
+void setup_labels(const LabelManager_Ptr& labelManager)
+{
+  labelManager->add_label("background");
+  for(size_t i = 1, count = labelManager->get_max_label_count(); i < count; ++i)
+  {
+    labelManager->add_label(boost::lexical_cast<std::string>(i));
+  }
+}
+
+/**
+ * \brief Makes the table of single-argument modes of spaintbench, keyed by the command-line flags that select them.
+ *
+ * \return The table of single-argument modes.
+ */
+std::map<std::string,BenchmarkMode> make_benchmark_modes()
+{
+  std::map<std::string,BenchmarkMode> modes;
+  modes.insert(std::make_pair("--cache", BenchmarkMode("feature cache benchmark", "output CSV file", &run_cache_benchmark)));
+  modes.insert(std::make_pair("--features", BenchmarkMode("feature benchmark", "output CSV file", &run_feature_benchmark)));
+  modes.insert(std::make_pair("--kernels", BenchmarkMode("kernel benchmark", "output CSV file", &run_kernel_benchmark)));
+  modes.insert(std::make_pair("--label-index", BenchmarkMode("label index benchmark", "output CSV file", &run_label_index_benchmark)));
+  modes.insert(std::make_pair("--multiscale", BenchmarkMode("multi-scale feature benchmark", "output CSV file", &run_multiscale_benchmark)));
+  modes.insert(std::make_pair("--patches", BenchmarkMode("patch gathering benchmark", "output CSV file", &run_patch_gathering_benchmark)));
+  modes.insert(std::make_pair("--propagation", BenchmarkMode("propagation benchmark", "output CSV file", &run_propagation_benchmark)));
+  modes.insert(std::make_pair("--replay", BenchmarkMode("replay check", "frame count", &run_replay_check)));
+  modes.insert(std::make_pair("--subset", BenchmarkMode("feature subset benchmark", "output CSV file", &run_subset_benchmark)));
+  return modes;
+}
+
+int main(int argc, char *argv[])
+try
+{
+  const std::map<std::string,BenchmarkMode> benchmarkModes = make_benchmark_modes();
+
+  // Parse the command-line arguments.
+  if(argc != 3 && argc != 6)
+  {
+    std::cerr << "Usage: spaintbench <frames per mode> <output CSV file> [<calibration file> <RGB image mask> <depth image mask>]\n";
+    std::cerr << "If no image masks are specified, synthetic frames of a procedural room are used.\n";
+    for(std::map<std::string,BenchmarkMode>::const_iterator it = benchmarkModes.begin(), iend = benchmarkModes.end(); it != iend; ++it)
+    {
+      std::cerr << "Alternatively: spaintbench " << it->first << " <" << it->second.argumentDescription << ">\n";
+    }
+    return EXIT_FAILURE;
+  }
+
+  // If a single-argument mode was requested, run it.
+  std::map<std::string,BenchmarkMode>::const_iterator it = benchmarkModes.find(argv[1]);
+  if(it != benchmarkModes.end())
+  {
+    const BenchmarkMode& benchmarkMode = it->second;
+    if(argc != 3) throw std::runtime_error("Error: The " + benchmarkMode.name + " expects exactly one argument (the " + benchmarkMode.argumentDescription + ")");
+    benchmarkMode.runner(argv[2]);
+    return 0;
+  }
+
+  const size_t framesPerMode = boost::lexical_cast<size_t>(argv[1]);
+  const std::string outputFilename = argv[2];
+
+  // Specify the modes to benchmark. These are run in sequence on the same pipeline, so that the scene reconstructed
+  // in the earlier modes and the forest trained in training mode are available for the later ones.
+  std::vector<std::pair<Pipeline::Mode,std::string> > modes;
+  modes.push_back(std::make_pair(Pipeline::MODE_NORMAL, "NORMAL"));
+  modes.push_back(std::make_pair(Pipeline::MODE_TRAINING, "TRAINING"));
+  modes.push_back(std::make_pair(Pipeline::MODE_PREDICTION, "PREDICTION"));
+  modes.push_back(std::make_pair(Pipeline::MODE_TRAIN_AND_PREDICT, "TRAIN_AND_PREDICT"));
+  modes.push_back(std::make_pair(Pipeline::MODE_PROPAGATION, "PROPAGATION"));
+
+  // Specify the settings.
+  Pipeline::Settings_Ptr settings(new ITMLibSettings);
+  MemoryBlockFactory::instance().set_device_type(settings->deviceType);
+
+  // Construct the pipeline, using either the specified image sequence or a synthetic room as its image source.
+  Pipeline_Ptr pipeline;
+  const std::string resourcesDir = (find_executable().parent_path() / "resources/").string();
+  if(argc == 6)
+  {
+    std::cout << "[spaintbench] Reading images from disk: " << argv[4] << ' ' << argv[5] << '\n';
+    pipeline.reset(new Pipeline(argv[3], argv[4], argv[5], settings, resourcesDir));
+  }
+  else
+  {
+    std::cout << "[spaintbench] Rendering synthetic images of a procedural room\n";
+    const std::string calibrationFilename = resourcesDir + "DefaultCalibration.txt";
+    Pipeline::ImageSourceEngine_Ptr imageSourceEngine(new SyntheticRoomEngine(calibrationFilename.c_str(), framesPerMode * modes.size()));
+    pipeline.reset(new Pipeline(imageSourceEngine, settings, resourcesDir));
+  }
+
+  setup_labels(pipeline->get_model()->get_label_manager());
+  pipeline->get_interactor()->set_semantic_label(1);
+  ScriptedPainter painter(settings->deviceType);
+
+  // Run the pipeline in each mode in turn, writing the timings to the output file.
+  std::ofstream fs(outputFilename.c_str());
+  if(!fs) throw std::runtime_error("Error: Could not open '" + outputFilename + "' for writing");
+  fs << "mode,section,count,average_us,total_us\n";
+
+  for(size_t i = 0, size = modes.size(); i < size; ++i)
+  {
+    std::cout << "[spaintbench] Running in " << modes[i].second << " mode...\n";
+    size_t framesProcessed = run_mode(*pipeline, modes[i].first, modes[i].second, framesPerMode, painter, fs);
+    if(framesProcessed < framesPerMode)
+    {
+      std::cerr << "[spaintbench] Warning: The image source ran out of images after " << framesProcessed << " frames in " << modes[i].second << " mode\n";
+      break;
+    }
+  }
+
+  // Output the overall average latencies of the stages of the pipeline, and the effectiveness of the feature cache.
+  pipeline->output_stage_latencies(std::cout);
+  pipeline->output_feature_cache_statistics(std::cout);
+
+  // Output the memory used by the undo history of the scripted painting.
+  painter.output_undo_memory_usage(std::cout);
+
+  std::cout << "[spaintbench] Results written to " << outputFilename << '\n';
+  return 0;
+}
+catch(std::exception& e)
+{
+  std::cerr << e.what() << '\n';
+  return EXIT_FAILURE;
+}
@@ -34,7 +34,7 @@ using namespace tvgutil;
 //#################### CONSTRUCTORS ####################
 
 Application::Application(const Pipeline_Ptr& pipeline)
-: m_commandManager(10),
+: m_commandManager(INT_MAX, 64 * 1024 * 1024),
   m_pipeline(pipeline),
   m_voiceCommandStream("localhost", "23984")
 {
@@ -45,7 +45,7 @@ private:
 
   //#################### PRIVATE VARIABLES ####################
 private:
-  /** The command manager. */
+  /** The command manager (the depth of the undo history is bounded by the memory it uses, rather than by a fixed number of commands). */
   tvgutil::CommandManager m_commandManager;
 
   /** The current state of the keyboard and mouse. */
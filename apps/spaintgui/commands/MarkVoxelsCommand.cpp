@@ -5,6 +5,9 @@
 
 #include "MarkVoxelsCommand.h"
 
+#include <algorithm>
+
+#include <spaint/markers/shared/VoxelMarker_Shared.h>
 #include <spaint/util/MemoryBlockFactory.h>
 using namespace spaint;
 
@@ -15,7 +18,6 @@ MarkVoxelsCommand::MarkVoxelsCommand(const boost::shared_ptr<const ORUtils::Memo
 : Command(get_static_description()),
   m_interactor(interactor),
   m_label(label),
-  m_oldVoxelLabelsMB(MemoryBlockFactory::instance().make_block<SpaintVoxel::PackedLabel>(voxelLocationsMB->dataSize)),
   m_voxelLocationsMB(voxelLocationsMB)
 {}
 
@@ -23,12 +25,37 @@ MarkVoxelsCommand::MarkVoxelsCommand(const boost::shared_ptr<const ORUtils::Memo
 
 void MarkVoxelsCommand::execute() const
 {
-  m_interactor->mark_voxels(m_voxelLocationsMB, m_label, m_oldVoxelLabelsMB);
+  // If the command has not been executed before, mark the selected voxels and record the changes in the journal.
+  if(m_voxelLocationsMB)
+  {
+    mark_and_record();
+    return;
+  }
+
+  // Otherwise, we are redoing the command, so remark the voxels whose labels were changed the first time round.
+  if(m_journal.get_voxel_count() == 0) return;
+
+  boost::shared_ptr<ORUtils::MemoryBlock<Vector3s> > voxelLocationsMB;
+  boost::shared_ptr<ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> > oldLabelsMB;
+  decode_journal(voxelLocationsMB, oldLabelsMB);
+  m_interactor->mark_voxels(voxelLocationsMB, m_label, boost::shared_ptr<ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> >(), FORCED_MARKING);
+}
+
+size_t MarkVoxelsCommand::get_memory_usage() const
+{
+  size_t result = m_journal.get_memory_usage();
+  if(m_voxelLocationsMB) result += m_voxelLocationsMB->dataSize * sizeof(Vector3s);
+  return result;
 }
 
 void MarkVoxelsCommand::undo() const
 {
-  m_interactor->mark_voxels(m_voxelLocationsMB, m_oldVoxelLabelsMB, FORCED_MARKING);
+  if(m_journal.get_voxel_count() == 0) return;
+
+  boost::shared_ptr<ORUtils::MemoryBlock<Vector3s> > voxelLocationsMB;
+  boost::shared_ptr<ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> > oldLabelsMB;
+  decode_journal(voxelLocationsMB, oldLabelsMB);
+  m_interactor->mark_voxels(voxelLocationsMB, oldLabelsMB, FORCED_MARKING);
 }
 
 //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
@@ -37,3 +64,57 @@ std::string MarkVoxelsCommand::get_static_description()
 {
   return "Mark Voxels";
 }
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void MarkVoxelsCommand::decode_journal(boost::shared_ptr<ORUtils::MemoryBlock<Vector3s> >& voxelLocationsMB,
+                                       boost::shared_ptr<ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> >& oldLabelsMB) const
+{
+  std::vector<Vector3s> voxelLocations;
+  std::vector<SpaintVoxel::PackedLabel> oldLabels;
+  m_journal.decode(voxelLocations, oldLabels);
+
+  const MemoryBlockFactory& mbf = MemoryBlockFactory::instance();
+  voxelLocationsMB = mbf.make_block<Vector3s>(voxelLocations.size());
+  oldLabelsMB = mbf.make_block<SpaintVoxel::PackedLabel>(oldLabels.size());
+  std::copy(voxelLocations.begin(), voxelLocations.end(), voxelLocationsMB->GetData(MEMORYDEVICE_CPU));
+  std::copy(oldLabels.begin(), oldLabels.end(), oldLabelsMB->GetData(MEMORYDEVICE_CPU));
+  voxelLocationsMB->UpdateDeviceFromHost();
+  oldLabelsMB->UpdateDeviceFromHost();
+}
+
+void MarkVoxelsCommand::mark_and_record() const
+{
+  const MemoryBlockFactory& mbf = MemoryBlockFactory::instance();
+  const int voxelCount = static_cast<int>(m_voxelLocationsMB->dataSize);
+
+  // Prefill the old labels with the new label, so that any selected voxels that are not in the scene will look unchanged.
+  boost::shared_ptr<ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> > oldLabelsMB = mbf.make_block<SpaintVoxel::PackedLabel>(voxelCount);
+  std::fill(oldLabelsMB->GetData(MEMORYDEVICE_CPU), oldLabelsMB->GetData(MEMORYDEVICE_CPU) + voxelCount, m_label);
+  oldLabelsMB->UpdateDeviceFromHost();
+
+  // Mark the voxels and make the old labels and voxel locations available on the CPU.
+  m_interactor->mark_voxels(m_voxelLocationsMB, m_label, oldLabelsMB);
+  oldLabelsMB->UpdateHostFromDevice();
+  boost::shared_ptr<const ORUtils::MemoryBlock<Vector3s> > voxelLocationsMB = mbf.make_block_copy(*m_voxelLocationsMB);
+
+  // Record the voxels whose labels were actually changed by the marking (i.e. those whose old labels differ
+  // from the new label and could be overwritten by it). Other voxels need not be touched on undo or redo.
+  const SpaintVoxel::PackedLabel *oldLabels = oldLabelsMB->GetData(MEMORYDEVICE_CPU);
+  const Vector3s *voxelLocations = voxelLocationsMB->GetData(MEMORYDEVICE_CPU);
+  std::vector<Vector3s> changedVoxelLocations;
+  std::vector<SpaintVoxel::PackedLabel> changedOldLabels;
+  for(int i = 0; i < voxelCount; ++i)
+  {
+    if(!(oldLabels[i] == m_label) && can_overwrite_label(oldLabels[i], m_label))
+    {
+      changedVoxelLocations.push_back(voxelLocations[i]);
+      changedOldLabels.push_back(oldLabels[i]);
+    }
+  }
+
+  m_journal = VoxelLabelJournal(changedVoxelLocations, changedOldLabels);
+
+  // Release the selection, since it is no longer needed.
+  m_voxelLocationsMB.reset();
+}
@@ -6,12 +6,18 @@
 #ifndef H_SPAINTGUI_MARKVOXELSCOMMAND
 #define H_SPAINTGUI_MARKVOXELSCOMMAND
 
+#include <spaint/markers/VoxelLabelJournal.h>
+
 #include <tvgutil/commands/Command.h>
 
 #include "../core/Interactor.h"
 
 /**
  * \brief An instance of this class represents a command that can be used to mark voxels in the scene.
+ *
+ * When the command is first executed, it records the voxels whose labels actually changed (together with their old labels)
+ * in a compact journal and then releases the selection it was given. The journal is subsequently used both to undo and
+ * to redo the command, which keeps the memory footprint of the undo history proportional to the changes that were made.
  */
 class MarkVoxelsCommand : public tvgutil::Command
 {
@@ -20,14 +26,14 @@ private:
   /** The interactor that is used to interact with the scene. */
   Interactor_Ptr m_interactor;
 
+  /** A journal recording the voxels whose labels were changed by the command, together with their old labels. */
+  mutable spaint::VoxelLabelJournal m_journal;
+
   /** The semantic label with which to mark the voxels. */
   spaint::SpaintVoxel::PackedLabel m_label;
 
-  /** A memory block into which to store the old labels of the voxels being marked. */
-  boost::shared_ptr<ORUtils::MemoryBlock<spaint::SpaintVoxel::PackedLabel> > m_oldVoxelLabelsMB;
-
-  /** The locations of the voxels in the scene to mark. */
-  boost::shared_ptr<const ORUtils::MemoryBlock<Vector3s> > m_voxelLocationsMB;
+  /** The locations of the voxels in the scene to mark (this is released once the command has first been executed). */
+  mutable boost::shared_ptr<const ORUtils::MemoryBlock<Vector3s> > m_voxelLocationsMB;
 
   //#################### CONSTRUCTORS ####################
 public:
@@ -45,6 +51,9 @@ public:
   /** Override */
   virtual void execute() const;
 
+  /** Override */
+  virtual size_t get_memory_usage() const;
+
   /** Override */
   virtual void undo() const;
 
@@ -56,6 +65,22 @@ public:
    * \return  A short description of what the command does.
    */
   static std::string get_static_description();
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Decodes the journal into memory blocks that can be passed to the interactor.
+   *
+   * \param voxelLocationsMB  A pointer into which to store a memory block containing the locations of the voxels whose labels were changed.
+   * \param oldLabelsMB       A pointer into which to store a memory block containing the old labels of the voxels.
+   */
+  void decode_journal(boost::shared_ptr<ORUtils::MemoryBlock<Vector3s> >& voxelLocationsMB,
+                      boost::shared_ptr<ORUtils::MemoryBlock<spaint::SpaintVoxel::PackedLabel> >& oldLabelsMB) const;
+
+  /**
+   * \brief Marks the selected voxels for the first time, and records the voxels whose labels changed in the journal.
+   */
+  void mark_and_record() const;
 };
 
 #endif
@@ -0,0 +1,173 @@
+/**
+ * spaintgui: FramePrefetcher.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "FramePrefetcher.h"
+
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+//#################### CONSTRUCTORS ####################
+
+FramePrefetcher::FramePrefetcher(const ImageSourceEngine_Ptr& imageSourceEngine, const ViewBuilder_Ptr& viewBuilder, size_t viewCount, bool runInBackground,
+                                 bool buildViewsInBackground)
+: m_acquisitionTimer("Acquisition"),
+  m_buildViewsInBackground(buildViewsInBackground),
+  m_freeSlots(new SlotQueue(viewCount)),
+  m_imageSourceEngine(imageSourceEngine),
+  m_readySlots(new SlotQueue(viewCount)),
+  m_runInBackground(runInBackground),
+  m_viewBuilder(viewBuilder),
+  m_viewBuildingTimer("View Building")
+{
+  // Fill the queue of free slots, each with its own RGB and raw depth images into which input can be read. The views themselves
+  // will be created by the view builder the first time they are used.
+  Vector2i rgbImageSize = m_imageSourceEngine->getRGBImageSize();
+  Vector2i depthImageSize = m_imageSourceEngine->getDepthImageSize();
+  if(depthImageSize.x == -1 || depthImageSize.y == -1) depthImageSize = rgbImageSize;
+  for(size_t i = 0; i < viewCount; ++i)
+  {
+    m_freeSlots->push(new Slot(rgbImageSize, depthImageSize));
+  }
+
+  // Start the background thread (if we're using one).
+  if(m_runInBackground) m_worker = boost::thread(boost::bind(&FramePrefetcher::run_worker, this));
+}
+
+//#################### DESTRUCTOR ####################
+
+FramePrefetcher::~FramePrefetcher()
+{
+  // Stop the background thread. Closing the queues wakes it up if it is waiting for a free slot or for space to hand on a ready one.
+  m_freeSlots->close();
+  m_readySlots->close();
+  if(m_worker.joinable()) m_worker.join();
+
+  // Destroy any slots that are still in the queues. (Slots whose views are still in use elsewhere will be destroyed by their recyclers.)
+  Slot *slot;
+  while(m_freeSlots->pop(slot)) delete slot;
+  while(m_readySlots->pop(slot)) delete slot;
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+Model::View_Ptr FramePrefetcher::get_next_view()
+{
+  Slot *slot;
+
+  if(!m_runInBackground)
+  {
+    // Acquire the frame on the calling thread. Since only the consumer ever returns slots to the queue of free slots in this case,
+    // waiting for a free slot would never succeed: if there isn't one, then something is holding on to views that it shouldn't.
+    if(m_freeSlots->size() == 0) throw std::runtime_error("Error: Cannot acquire the next frame, since all of the views are still in use");
+    m_freeSlots->pop(slot);
+
+    try
+    {
+      if(acquire_frame(*slot))
+      {
+        build_view(*slot);
+        return Model::View_Ptr(slot->m_view, ViewRecycler(m_freeSlots, slot));
+      }
+    }
+    catch(std::exception&)
+    {
+      delete slot;
+      throw;
+    }
+
+    m_freeSlots->push(slot);
+    return Model::View_Ptr();
+  }
+
+  if(m_readySlots->pop(slot))
+  {
+    // If the views are not being built on the background thread, build this one now (on the calling thread).
+    if(!m_buildViewsInBackground)
+    {
+      try
+      {
+        build_view(*slot);
+      }
+      catch(std::exception&)
+      {
+        delete slot;
+        throw;
+      }
+    }
+
+    return Model::View_Ptr(slot->m_view, ViewRecycler(m_freeSlots, slot));
+  }
+
+  // If the background thread has stopped because something went wrong, report the problem.
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  if(!m_error.empty()) throw std::runtime_error("Error: Failed to prefetch the next frame: " + m_error);
+
+  return Model::View_Ptr();
+}
+
+std::vector<FramePrefetcher::StageTimer> FramePrefetcher::get_stage_timers() const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  std::vector<StageTimer> timers;
+  timers.push_back(m_acquisitionTimer);
+  timers.push_back(m_viewBuildingTimer);
+  return timers;
+}
+
+void FramePrefetcher::output_stage_latencies(std::ostream& os) const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  if(m_acquisitionTimer.count() > 0) os << m_acquisitionTimer << '\n';
+  if(m_viewBuildingTimer.count() > 0) os << m_viewBuildingTimer << '\n';
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+bool FramePrefetcher::acquire_frame(Slot& slot)
+{
+  if(!m_imageSourceEngine->hasMoreImages()) return false;
+
+  { boost::lock_guard<boost::mutex> lock(m_mutex); m_acquisitionTimer.start(); }
+  m_imageSourceEngine->getImages(slot.m_rgbImage.get(), slot.m_rawDepthImage.get());
+  { boost::lock_guard<boost::mutex> lock(m_mutex); m_acquisitionTimer.stop(); }
+
+  return true;
+}
+
+void FramePrefetcher::build_view(Slot& slot)
+{
+  const bool useBilateralFilter = false;
+  { boost::lock_guard<boost::mutex> lock(m_mutex); m_viewBuildingTimer.start(); }
+  m_viewBuilder->UpdateView(&slot.m_view, slot.m_rgbImage.get(), slot.m_rawDepthImage.get(), useBilateralFilter);
+  { boost::lock_guard<boost::mutex> lock(m_mutex); m_viewBuildingTimer.stop(); }
+}
+
+void FramePrefetcher::run_worker()
+{
+  Slot *slot = NULL;
+
+  try
+  {
+    while(m_freeSlots->pop(slot))
+    {
+      if(!acquire_frame(*slot)) break;
+      if(m_buildViewsInBackground) build_view(*slot);
+
+      // Hand the slot on to the consumer (if this fails, the prefetcher is being shut down and the slot is no longer needed).
+      if(!m_readySlots->push(slot)) break;
+      slot = NULL;
+    }
+  }
+  catch(std::exception& e)
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_error = e.what();
+  }
+
+  // Destroy any slot that we were still holding, and signal to the consumer that there will be no more frames.
+  delete slot;
+  m_readySlots->close();
+}
@@ -0,0 +1,250 @@
+/**
+ * spaintgui: FramePrefetcher.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINTGUI_FRAMEPREFETCHER
+#define H_SPAINTGUI_FRAMEPREFETCHER
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <tvgutil/BoundedQueue.h>
+#include <tvgutil/timing/AverageTimer.h>
+
+#include "Model.h"
+
+/**
+ * \brief An instance of this class acquires frames from an image source engine and turns them into views on a background thread.
+ *
+ * This allows the acquisition and view building stages of the pipeline for the next frame to overlap with the tracking,
+ * fusion and raycasting stages for the current frame (and with rendering). The frames are multiply buffered: each buffer
+ * slot holds the raw input images for a frame and the view built from them, and a slot whose view has been handed out is
+ * only reused once every shared pointer to the view has been released (i.e. once the model has moved on to a later view).
+ * Since the background thread can only ever get a bounded number of frames ahead of the consumer, and the frames are
+ * delivered in order, the views seen by the consumer are exactly the same as they would have been if the frames had been
+ * acquired synchronously.
+ *
+ * The view builder can optionally be run on the consumer's thread instead (in which case only the acquisition of the frames
+ * overlaps with the rest of the pipeline). This is needed for the CUDA view builder: InfiniTAM issues all of its CUDA work
+ * on the default stream of the context it shares with the consumer's thread, so building views on the background thread
+ * would race with the tracking and fusion kernels for the current frame (and would read views that the consumer is using).
+ *
+ * Note that nothing other than the model should hold on to a view once the model has moved on to a later one: if it did,
+ * the background thread would eventually run out of free views and the pipeline would deadlock. For testing purposes,
+ * the prefetcher can also be made to acquire the frames synchronously (i.e. on the consumer's thread, when asked).
+ */
+class FramePrefetcher
+{
+  //#################### PUBLIC TYPEDEFS ####################
+public:
+  typedef tvgutil::AverageTimer<boost::chrono::microseconds> StageTimer;
+
+  //#################### PRIVATE TYPEDEFS ####################
+private:
+  typedef boost::shared_ptr<InfiniTAM::Engine::ImageSourceEngine> ImageSourceEngine_Ptr;
+  typedef boost::shared_ptr<ITMShortImage> ITMShortImage_Ptr;
+  typedef boost::shared_ptr<ITMUChar4Image> ITMUChar4Image_Ptr;
+  typedef boost::shared_ptr<ITMViewBuilder> ViewBuilder_Ptr;
+
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct represents a buffer slot that holds the raw input images for a frame and the view built from them.
+   */
+  struct Slot
+  {
+    /** The image into which the depth input for the frame is read. */
+    ITMShortImage_Ptr m_rawDepthImage;
+
+    /** The image into which the RGB input for the frame is read. */
+    ITMUChar4Image_Ptr m_rgbImage;
+
+    /** The view built from the input images (initially NULL, since it is created by the view builder the first time it is used). */
+    ITMView *m_view;
+
+    /**
+     * \brief Constructs a buffer slot.
+     *
+     * \param rgbImageSize    The size of the RGB input images.
+     * \param depthImageSize  The size of the depth input images.
+     */
+    Slot(const Vector2i& rgbImageSize, const Vector2i& depthImageSize)
+    : m_rawDepthImage(new ITMShortImage(depthImageSize, true, true)), m_rgbImage(new ITMUChar4Image(rgbImageSize, true, true)), m_view(NULL)
+    {}
+
+    /**
+     * \brief Destroys the buffer slot (and its view).
+     */
+    ~Slot()
+    {
+      delete m_view;
+    }
+
+  private:
+    // Deliberately private and unimplemented.
+    Slot(const Slot&);
+    Slot& operator=(const Slot&);
+  };
+
+  typedef tvgutil::BoundedQueue<Slot*> SlotQueue;
+  typedef boost::shared_ptr<SlotQueue> SlotQueue_Ptr;
+
+  /**
+   * \brief An instance of this struct is used as the deleter for the views handed out by the prefetcher.
+   *
+   * Rather than destroying a view, it returns the slot containing it to the queue of free slots so that it can be reused.
+   * If the prefetcher has been shut down in the meantime, the slot (and hence the view) is destroyed instead.
+   */
+  struct ViewRecycler
+  {
+    /** The queue of free slots. */
+    SlotQueue_Ptr m_freeSlots;
+
+    /** The slot containing the view. */
+    Slot *m_slot;
+
+    /**
+     * \brief Constructs a view recycler.
+     *
+     * \param freeSlots The queue of free slots.
+     * \param slot      The slot containing the view.
+     */
+    ViewRecycler(const SlotQueue_Ptr& freeSlots, Slot *slot)
+    : m_freeSlots(freeSlots), m_slot(slot)
+    {}
+
+    /**
+     * \brief Returns the slot containing a view to the queue of free slots (or destroys it if the queue has been closed).
+     *
+     * \param view  The view.
+     */
+    void operator()(ITMView *view) const
+    {
+      if(!m_freeSlots->push(m_slot)) delete m_slot;
+    }
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The timer for the acquisition stage. */
+  StageTimer m_acquisitionTimer;
+
+  /** The message associated with any exception that was thrown on the background thread. */
+  std::string m_error;
+
+  /** Whether or not the views are built on the background thread (if not, they are built by get_next_view on the consumer's thread). */
+  bool m_buildViewsInBackground;
+
+  /** A queue of slots that are free to be filled by the background thread. */
+  SlotQueue_Ptr m_freeSlots;
+
+  /** The engine used to provide input images. */
+  ImageSourceEngine_Ptr m_imageSourceEngine;
+
+  /** The mutex used to synchronise access to the stage timers and the error message. */
+  mutable boost::mutex m_mutex;
+
+  /** A queue of slots whose frames are ready to be consumed. */
+  SlotQueue_Ptr m_readySlots;
+
+  /** Whether or not the frames are acquired on the background thread (if not, they are acquired synchronously by get_next_view). */
+  bool m_runInBackground;
+
+  /** The view builder. */
+  ViewBuilder_Ptr m_viewBuilder;
+
+  /** The timer for the view building stage. */
+  StageTimer m_viewBuildingTimer;
+
+  /** The background thread. */
+  boost::thread m_worker;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a frame prefetcher and (by default) starts its background thread.
+   *
+   * Note: Once the prefetcher has been constructed, the image source engine and view builder must only be used via the prefetcher.
+   *
+   * \param imageSourceEngine The engine used to provide input images.
+   * \param viewBuilder       The view builder.
+   * \param viewCount               The number of views to use (at least two are needed to allow acquisition to overlap with processing).
+   * \param runInBackground         Whether or not to acquire the frames on a background thread (if not, they are acquired synchronously).
+   * \param buildViewsInBackground  Whether or not to build the views on the background thread as well (this must be false for the CUDA view builder).
+   */
+  FramePrefetcher(const ImageSourceEngine_Ptr& imageSourceEngine, const ViewBuilder_Ptr& viewBuilder, size_t viewCount = 2, bool runInBackground = true,
+                  bool buildViewsInBackground = true);
+
+  //#################### DESTRUCTOR ####################
+public:
+  /**
+   * \brief Stops the background thread and destroys the prefetcher.
+   */
+  ~FramePrefetcher();
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  FramePrefetcher(const FramePrefetcher&);
+  FramePrefetcher& operator=(const FramePrefetcher&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the view for the next frame, waiting for it to become available (or acquiring it synchronously) if necessary.
+   *
+   * \return                    The view for the next frame, or NULL if the image source engine has run out of images.
+   * \throws std::runtime_error If the view could not be acquired or built, or if the frames are being acquired synchronously
+   *                            and all of the views are still in use.
+   */
+  Model::View_Ptr get_next_view();
+
+  /**
+   * \brief Gets copies of the timers for the acquisition and view building stages.
+   *
+   * \return  Copies of the timers for the acquisition and view building stages.
+   */
+  std::vector<StageTimer> get_stage_timers() const;
+
+  /**
+   * \brief Outputs the average latencies of the acquisition and view building stages to a stream.
+   *
+   * \param os  The stream.
+   */
+  void output_stage_latencies(std::ostream& os) const;
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Acquires the next frame from the image source engine (if there is one).
+   *
+   * \param slot  The slot into whose input images to read the frame.
+   * \return      true, if a frame was acquired, or false if the image source engine has run out of images.
+   */
+  bool acquire_frame(Slot& slot);
+
+  /**
+   * \brief Turns the frame in the specified slot into a view (creating the view if it does not yet exist).
+   *
+   * \param slot  The slot.
+   */
+  void build_view(Slot& slot);
+
+  /**
+   * \brief Repeatedly acquires frames (and, if desired, turns them into views) until the image source engine runs out of images or the prefetcher is shut down.
+   *
+   * Note: This is run on the background thread.
+   */
+  void run_worker();
+};
+
+//#################### TYPEDEFS ####################
+
+typedef boost::shared_ptr<FramePrefetcher> FramePrefetcher_Ptr;
+
+#endif
@@ -21,6 +21,8 @@ using namespace spaint;
 #endif
 
 #ifdef WITH_ARRAYFIRE
+#include <boost/bind.hpp>
+
 #include <spaint/selectors/TouchSelector.h>
 #endif
 
@@ -48,8 +50,11 @@ Interactor::Interactor(const Model_Ptr& model)
   }
   else
   {
-    // Use the CPU implementation.
-    m_voxelMarker.reset(new VoxelMarker_CPU);
+    // Use the CPU implementation. If the scene does not use swapping, give the voxel marker an index of the labelled voxels
+    // to maintain, so that clearing labels does not need to sweep the whole voxel block array.
+    VoxelLabelIndex_Ptr labelIndex;
+    if(!model->get_settings()->useSwapping) labelIndex.reset(new VoxelLabelIndex);
+    m_voxelMarker.reset(new VoxelMarker_CPU(labelIndex));
   }
 }
 
@@ -57,8 +62,7 @@ Interactor::Interactor(const Model_Ptr& model)
 
 void Interactor::clear_labels(ClearingSettings settings)
 {
-  ITMLocalVBA<SpaintVoxel>& localVBA = m_model->get_scene()->localVBA;
-  m_voxelMarker->clear_labels(localVBA.GetVoxelBlocks(), localVBA.allocatedSize, settings);
+  m_voxelMarker->clear_labels(m_model->get_scene().get(), settings);
 }
 
 Interactor::Selection_CPtr Interactor::get_selection() const
@@ -92,6 +96,11 @@ void Interactor::mark_voxels(const Selection_CPtr& selection, const PackedLabels
   m_voxelMarker->mark_voxels(*selection, *labels, m_model->get_scene().get(), NULL, mode);
 }
 
+void Interactor::notify_labels_changed()
+{
+  m_voxelMarker->notify_labels_changed();
+}
+
 bool Interactor::selector_is_active() const
 {
   return m_selector->is_active();
@@ -118,7 +127,12 @@ void Interactor::update_selector(const InputState& inputState, const RenderState
     {
       const TouchSettings_Ptr touchSettings(new TouchSettings(m_model->get_resources_dir() + "/TouchSettings.xml"));
       const size_t maxKeptTouchPoints = 50;
-      m_selector.reset(new TouchSelector(settings, touchSettings, m_model->get_tracking_state(), m_model->get_view(), maxKeptTouchPoints));
+
+      // Note: The touch selector gets the current view from the model whenever it needs it, since the frame prefetcher hands out
+      //       a different view each frame, and holding on to one would prevent the prefetcher from reusing it.
+      Model::View_CPtr (Model::*getView)() const = &Model::get_view;
+      TouchSelector::ViewProvider viewProvider = boost::bind(getView, m_model);
+      m_selector.reset(new TouchSelector(settings, touchSettings, m_model->get_tracking_state(), viewProvider, maxKeptTouchPoints));
 
       const int initialSelectionRadius = 1;
       m_selectionTransformer = SelectionTransformerFactory::make_voxel_to_cube(initialSelectionRadius, m_model->get_settings()->deviceType);
@@ -114,6 +114,11 @@ public:
    */
   void mark_voxels(const Selection_CPtr& selection, const PackedLabels_CPtr& labels, spaint::MarkingMode mode = spaint::NORMAL_MARKING);
 
+  /**
+   * \brief Notifies the interactor that the labels of some voxels in the scene have been changed without its involvement (e.g. by label propagation).
+   */
+  void notify_labels_changed();
+
   /**
    * \brief Gets whether or not the current selector is active.
    *
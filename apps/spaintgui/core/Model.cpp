@@ -91,7 +91,7 @@ Model::View_CPtr Model::get_view() const
   return m_view;
 }
 
-void Model::set_view(ITMView *view)
+void Model::set_view(const View_Ptr& view)
 {
-  if(m_view.get() != view) m_view.reset(view);
+  m_view = view;
 }
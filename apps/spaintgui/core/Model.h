@@ -177,7 +177,7 @@ public:
    *
    * \param view  The new current view of the scene.
    */
-  void set_view(ITMView *view);
+  void set_view(const View_Ptr& view);
 };
 
 //#################### TYPEDEFS ####################
@@ -42,20 +42,49 @@ using namespace InfiniTAM::Engine;
 
 #ifdef WITH_OPENNI
 Pipeline::Pipeline(const std::string& calibrationFilename, const boost::optional<std::string>& openNIDeviceURI, const Settings_Ptr& settings,
-                   const std::string& resourcesDir, TrackerType trackerType, const std::string& trackerParams, bool useInternalCalibration)
-: m_resourcesDir(resourcesDir), m_trackerParams(trackerParams), m_trackerType(trackerType)
+                   const std::string& resourcesDir, TrackerType trackerType, const std::string& trackerParams, bool useInternalCalibration,
+                   const VOPFeatureCache_Ptr& featureCache)
+: m_fusionTimer("Fusion"),
+  m_predictionTimer("Prediction"),
+  m_propagationTimer("Propagation"),
+  m_raycastPreparationTimer("Raycast Preparation"),
+  m_resourcesDir(resourcesDir),
+  m_trackerParams(trackerParams),
+  m_trackerType(trackerType),
+  m_trackingTimer("Tracking"),
+  m_trainingTimer("Training")
 {
   m_imageSourceEngine.reset(new OpenNIEngine(calibrationFilename.c_str(), openNIDeviceURI ? openNIDeviceURI->c_str() : NULL, useInternalCalibration));
-  initialise(settings);
+  initialise(settings, true, featureCache);
 }
 #endif
 
 Pipeline::Pipeline(const std::string& calibrationFilename, const std::string& rgbImageMask, const std::string& depthImageMask,
-                   const Settings_Ptr& settings, const std::string& resourcesDir)
-: m_resourcesDir(resourcesDir)
+                   const Settings_Ptr& settings, const std::string& resourcesDir, const VOPFeatureCache_Ptr& featureCache)
+: m_fusionTimer("Fusion"),
+  m_predictionTimer("Prediction"),
+  m_propagationTimer("Propagation"),
+  m_raycastPreparationTimer("Raycast Preparation"),
+  m_resourcesDir(resourcesDir),
+  m_trackingTimer("Tracking"),
+  m_trainingTimer("Training")
 {
   m_imageSourceEngine.reset(new ImageFileReader(calibrationFilename.c_str(), rgbImageMask.c_str(), depthImageMask.c_str()));
-  initialise(settings);
+  initialise(settings, true, featureCache);
+}
+
+Pipeline::Pipeline(const ImageSourceEngine_Ptr& imageSourceEngine, const Settings_Ptr& settings, const std::string& resourcesDir, bool prefetchFrames,
+                   const VOPFeatureCache_Ptr& featureCache)
+: m_fusionTimer("Fusion"),
+  m_imageSourceEngine(imageSourceEngine),
+  m_predictionTimer("Prediction"),
+  m_propagationTimer("Propagation"),
+  m_raycastPreparationTimer("Raycast Preparation"),
+  m_resourcesDir(resourcesDir),
+  m_trackingTimer("Tracking"),
+  m_trainingTimer("Training")
+{
+  initialise(settings, prefetchFrames, featureCache);
 }
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
@@ -95,6 +124,34 @@ Raycaster_CPtr Pipeline::get_raycaster() const
   return m_raycaster;
 }
 
+std::vector<Pipeline::StageTimer> Pipeline::get_stage_timers() const
+{
+  std::vector<StageTimer> timers = m_framePrefetcher->get_stage_timers();
+  timers.push_back(m_trackingTimer);
+  timers.push_back(m_fusionTimer);
+  timers.push_back(m_raycastPreparationTimer);
+  timers.push_back(m_trainingTimer);
+  timers.push_back(m_predictionTimer);
+  timers.push_back(m_propagationTimer);
+  return timers;
+}
+
+void Pipeline::output_feature_cache_statistics(std::ostream& os) const
+{
+  if(m_featureCache) m_featureCache->output_statistics(os);
+}
+
+void Pipeline::output_stage_latencies(std::ostream& os) const
+{
+  m_framePrefetcher->output_stage_latencies(os);
+  if(m_trackingTimer.count() > 0) os << m_trackingTimer << '\n';
+  if(m_fusionTimer.count() > 0) os << m_fusionTimer << '\n';
+  if(m_raycastPreparationTimer.count() > 0) os << m_raycastPreparationTimer << '\n';
+  if(m_trainingTimer.count() > 0) os << m_trainingTimer << '\n';
+  if(m_predictionTimer.count() > 0) os << m_predictionTimer << '\n';
+  if(m_propagationTimer.count() > 0) os << m_propagationTimer << '\n';
+}
+
 void Pipeline::reset_forest()
 {
   const size_t treeCount = 5;
@@ -102,29 +159,32 @@ void Pipeline::reset_forest()
   m_forest.reset(new RandomForest<SpaintVoxel::Label>(treeCount, dtSettings));
 }
 
-void Pipeline::run_main_section()
+bool Pipeline::run_main_section()
 {
-  if(!m_imageSourceEngine->hasMoreImages()) return;
+  // Get the view for the next frame (if there is one). The frame will have been acquired and turned into a view
+  // in the background whilst the previous frame was being processed.
+  Model::View_Ptr newView = m_framePrefetcher->get_next_view();
+  if(!newView) return false;
+  m_model->set_view(newView);
 
   const Raycaster::RenderState_Ptr& liveRenderState = m_raycaster->get_live_render_state();
   const Model::Scene_Ptr& scene = m_model->get_scene();
   const Model::TrackingState_Ptr& trackingState = m_model->get_tracking_state();
   const Model::View_Ptr& view = m_model->get_view();
 
-  // Get the next frame.
-  ITMView *newView = view.get();
-  m_imageSourceEngine->getImages(m_inputRGBImage.get(), m_inputRawDepthImage.get());
-  const bool useBilateralFilter = false;
-  m_viewBuilder->UpdateView(&newView, m_inputRGBImage.get(), m_inputRawDepthImage.get(), useBilateralFilter);
-  m_model->set_view(newView);
-
   // Track the camera (we can only do this once we've started reconstructing the model because we need something to track against).
-  if(m_reconstructionStarted) m_trackingController->Track(trackingState.get(), view.get());
+  if(m_reconstructionStarted)
+  {
+    m_trackingTimer.start();
+    m_trackingController->Track(trackingState.get(), view.get());
+    m_trackingTimer.stop();
+  }
 
   // Determine whether or not fusion should be run.
   bool runFusion = m_fusionEnabled;
   if(m_fallibleTracker && m_fallibleTracker->lost_tracking()) runFusion = false;
 
+  m_fusionTimer.start();
   if(runFusion)
   {
     // Run the fusion process.
@@ -136,9 +196,14 @@ void Pipeline::run_main_section()
     // Update the list of visible blocks so that things are kept up to date even when we're not fusing.
     m_denseMapper->UpdateVisibleList(view.get(), trackingState.get(), scene.get(), liveRenderState.get());
   }
+  m_fusionTimer.stop();
 
   // Raycast from the live camera position to prepare for tracking in the next frame.
+  m_raycastPreparationTimer.start();
   m_trackingController->Prepare(trackingState.get(), view.get(), liveRenderState.get());
+  m_raycastPreparationTimer.stop();
+
+  return true;
 }
 
 void Pipeline::run_mode_specific_section(const RenderState_CPtr& renderState)
@@ -192,7 +257,7 @@ void Pipeline::set_mode(Mode mode)
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
-void Pipeline::initialise(const Settings_Ptr& settings)
+void Pipeline::initialise(const Settings_Ptr& settings, bool prefetchFrames, const VOPFeatureCache_Ptr& featureCache)
 {
   // Make sure that we're not trying to run on the GPU if CUDA support isn't enabled.
 #ifndef WITH_CUDA
@@ -208,10 +273,6 @@ void Pipeline::initialise(const Settings_Ptr& settings)
   Vector2i depthImageSize = m_imageSourceEngine->getDepthImageSize();
   if(depthImageSize.x == -1 || depthImageSize.y == -1) depthImageSize = rgbImageSize;
 
-  // Set up the RGB and raw depth images into which input is to be read each frame.
-  m_inputRGBImage.reset(new ITMUChar4Image(rgbImageSize, true, true));
-  m_inputRawDepthImage.reset(new ITMShortImage(depthImageSize, true, true));
-
   // Set up the scene.
   MemoryDeviceType memoryType = settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU;
   Model::Scene_Ptr scene(new Model::Scene(&settings->sceneParams, settings->useSwapping, memoryType));
@@ -282,14 +343,21 @@ void Pipeline::initialise(const Settings_Ptr& settings)
   const float patchSpacing = 0.01f / settings->sceneParams.voxelSize; // 10mm = 0.01m (dividing by the voxel size, which is in m, expresses the spacing in voxels)
   const size_t binCount = 36;                                         // 10 degrees per bin
 
+  // If the caller has supplied a cache for the feature descriptors, use it. Note that caching is off by default, since
+  // cached descriptors can be reused for a while after the surfaces around their voxels have changed, and so using the
+  // cache can change the pipeline's output.
+  m_featureCache = featureCache;
+
   m_featureCalculator = FeatureCalculatorFactory::make_vop_feature_calculator(
     std::max(m_maxPredictionVoxelCount, maxTrainingVoxelCount),
-    m_patchSize, patchSpacing, binCount, settings->deviceType
+    m_patchSize, patchSpacing, binCount, settings->deviceType, m_featureCache
   );
 
   // Set up the memory blocks needed for prediction and training.
   MemoryBlockFactory& mbf = MemoryBlockFactory::instance();
   const size_t featureCount = m_featureCalculator->get_feature_count();
+  m_predictedLabels.resize(m_maxPredictionVoxelCount);
+  m_predictionDescriptorArena.reset(new DescriptorArena(m_maxPredictionVoxelCount, featureCount));
   m_predictionFeaturesMB = mbf.make_block<float>(m_maxPredictionVoxelCount * featureCount);
   m_predictionLabelsMB = mbf.make_block<SpaintVoxel::PackedLabel>(m_maxPredictionVoxelCount);
   m_predictionVoxelLocationsMB = mbf.make_block<Vector3s>(m_maxPredictionVoxelCount);
@@ -307,6 +375,13 @@ void Pipeline::initialise(const Settings_Ptr& settings)
   // Set up the random forest.
   reset_forest();
 
+  // Start prefetching frames from the image source engine (unless we've been asked to acquire them synchronously). Note that
+  // the CUDA view builder uses the same CUDA context and stream as the rest of the pipeline, so when we're running on the GPU,
+  // the views are built on this thread (only the acquisition of the frames happens in the background).
+  const size_t viewCount = 2;
+  const bool buildViewsInBackground = settings->deviceType != ITMLibSettings::DEVICE_CUDA;
+  m_framePrefetcher.reset(new FramePrefetcher(m_imageSourceEngine, m_viewBuilder, viewCount, prefetchFrames, buildViewsInBackground));
+
   m_featureInspectionWindowName = "Feature Inspection";
   m_fusionEnabled = true;
   m_mode = MODE_NORMAL;
@@ -365,14 +440,19 @@ void Pipeline::run_prediction_section(const RenderState_CPtr& samplingRenderStat
   // If the random forest is not yet valid, early out.
   if(!m_forest->is_valid()) return;
 
+  m_predictionTimer.start();
+
   // Sample some voxels for which to predict labels.
   m_predictionSampler->sample_voxels(samplingRenderState->raycastResult, m_maxPredictionVoxelCount, *m_predictionVoxelLocationsMB);
 
   // Calculate feature descriptors for the sampled voxels.
   m_featureCalculator->calculate_features(*m_predictionVoxelLocationsMB, m_model->get_scene().get(), *m_predictionFeaturesMB);
-  std::vector<Descriptor_CPtr> descriptors = ForestUtil::make_descriptors(*m_predictionFeaturesMB, m_maxPredictionVoxelCount, m_featureCalculator->get_feature_count());
+  ForestUtil::make_descriptors(*m_predictionFeaturesMB, m_maxPredictionVoxelCount, m_featureCalculator->get_feature_count(), *m_predictionDescriptorArena);
+
+  // Predict labels for the voxels based on the feature descriptors. Note that we predict all of the labels in a single batch,
+  // which lets the forest walk the descriptors through its trees a level at a time, rather than one descriptor at a time.
+  m_forest->predict_batch(*m_predictionDescriptorArena, &m_predictedLabels[0]);
 
-  // Predict labels for the voxels based on the feature descriptors.
   SpaintVoxel::PackedLabel *labels = m_predictionLabelsMB->GetData(MEMORYDEVICE_CPU);
 
 #ifdef WITH_OPENMP
@@ -380,18 +460,25 @@ void Pipeline::run_prediction_section(const RenderState_CPtr& samplingRenderStat
 #endif
   for(int i = 0; i < static_cast<int>(m_maxPredictionVoxelCount); ++i)
   {
-    labels[i] = SpaintVoxel::PackedLabel(m_forest->predict(descriptors[i]), SpaintVoxel::LG_FOREST);
+    labels[i] = SpaintVoxel::PackedLabel(m_predictedLabels[i], SpaintVoxel::LG_FOREST);
   }
 
   m_predictionLabelsMB->UpdateDeviceFromHost();
 
   // Mark the voxels with their predicted labels.
   m_interactor->mark_voxels(m_predictionVoxelLocationsMB, m_predictionLabelsMB);
+
+  m_predictionTimer.stop();
 }
 
 void Pipeline::run_propagation_section(const RenderState_CPtr& renderState)
 {
+  m_propagationTimer.start();
   m_labelPropagator->propagate_label(m_interactor->get_semantic_label(), renderState->raycastResult, m_model->get_scene().get());
+  m_propagationTimer.stop();
+
+  // The label propagator writes the labels of the voxels directly, so let the interactor know that they have changed.
+  m_interactor->notify_labels_changed();
 }
 
 void Pipeline::run_training_section(const RenderState_CPtr& samplingRenderState)
@@ -399,6 +486,8 @@ void Pipeline::run_training_section(const RenderState_CPtr& samplingRenderState)
   // If we haven't been provided with a camera position from which to sample, early out.
   if(!samplingRenderState) return;
 
+  m_trainingTimer.start();
+
   // Calculate a mask indicating the labels that are currently in use and from which we want to train.
   // Note that we deliberately avoid training from the background label (0), since the entire scene is
   // initially labelled as background and so training from the background would cause us to learn
@@ -446,6 +535,8 @@ void Pipeline::run_training_section(const RenderState_CPtr& samplingRenderState)
   const size_t splitBudget = 20;
   m_forest->add_examples(examples);
   m_forest->train(splitBudget);
+
+  m_trainingTimer.stop();
 }
 
 void Pipeline::setup_tracker(const Settings_Ptr& settings, const Model::Scene_Ptr& scene, const Vector2i& trackedImageSize)
@@ -6,16 +6,23 @@
 #ifndef H_SPAINTGUI_PIPELINE
 #define H_SPAINTGUI_PIPELINE
 
+#include <ostream>
+#include <vector>
+
 #include <boost/optional.hpp>
 
 #include <rafl/core/RandomForest.h>
 
+#include <spaint/features/VOPFeatureCache.h>
 #include <spaint/features/interface/FeatureCalculator.h>
 #include <spaint/propagation/interface/LabelPropagator.h>
 #include <spaint/sampling/interface/PerLabelVoxelSampler.h>
 #include <spaint/sampling/interface/UniformVoxelSampler.h>
 #include <spaint/trackers/FallibleTracker.h>
 
+#include <tvgutil/timing/AverageTimer.h>
+
+#include "FramePrefetcher.h"
 #include "Interactor.h"
 #include "Model.h"
 #include "Raycaster.h"
@@ -25,18 +32,20 @@
  */
 class Pipeline
 {
-  //#################### TYPEDEFS ####################
+  //#################### PUBLIC TYPEDEFS ####################
+public:
+  typedef boost::shared_ptr<InfiniTAM::Engine::ImageSourceEngine> ImageSourceEngine_Ptr;
+  typedef boost::shared_ptr<ITMLibSettings> Settings_Ptr;
+  typedef tvgutil::AverageTimer<boost::chrono::microseconds> StageTimer;
+
+  //#################### PRIVATE TYPEDEFS ####################
 private:
   typedef boost::shared_ptr<ITMDenseMapper<spaint::SpaintVoxel,ITMVoxelIndex> > DenseMapper_Ptr;
-  typedef boost::shared_ptr<InfiniTAM::Engine::ImageSourceEngine> ImageSourceEngine_Ptr;
   typedef boost::shared_ptr<ITMIMUCalibrator> IMUCalibrator_Ptr;
-  typedef boost::shared_ptr<ITMShortImage> ITMShortImage_Ptr;
-  typedef boost::shared_ptr<ITMUChar4Image> ITMUChar4Image_Ptr;
   typedef boost::shared_ptr<ITMLowLevelEngine> LowLevelEngine_Ptr;
   typedef boost::shared_ptr<rafl::RandomForest<spaint::SpaintVoxel::Label> > RandomForest_Ptr;
   typedef boost::shared_ptr<ITMRenderState> RenderState_Ptr;
   typedef boost::shared_ptr<const ITMRenderState> RenderState_CPtr;
-  typedef boost::shared_ptr<ITMLibSettings> Settings_Ptr;
   typedef boost::shared_ptr<ITMTracker> ITMTracker_Ptr;
   typedef boost::shared_ptr<ITMTrackingController> TrackingController_Ptr;
   typedef boost::shared_ptr<ITMTrackingState> TrackingState_Ptr;
@@ -88,6 +97,9 @@ private:
   /** A pointer to a tracker that can detect tracking failures (if available). */
   spaint::FallibleTracker *m_fallibleTracker;
 
+  /** The cache of previously-calculated feature descriptors used by the feature calculator (NULL if feature caching is not being used). */
+  spaint::VOPFeatureCache_Ptr m_featureCache;
+
   /** The feature calculator. */
   spaint::FeatureCalculator_CPtr m_featureCalculator;
 
@@ -97,21 +109,21 @@ private:
   /** The random forest. */
   RandomForest_Ptr m_forest;
 
+  /** The frame prefetcher that acquires frames and turns them into views in the background. */
+  FramePrefetcher_Ptr m_framePrefetcher;
+
   /** Whether or not the user wants fusion to be run as part of the pipeline. */
   bool m_fusionEnabled;
 
-  /** The engine used to provide input images to the fusion pipeline. */
+  /** The timer for the fusion stage. */
+  StageTimer m_fusionTimer;
+
+  /** The engine used to provide input images to the fusion pipeline (once the pipeline has been initialised, this is only used via the frame prefetcher). */
   ImageSourceEngine_Ptr m_imageSourceEngine;
 
   /** The IMU calibrator. */
   IMUCalibrator_Ptr m_imuCalibrator;
 
-  /** The image into which depth input is to be read each frame. */
-  ITMShortImage_Ptr m_inputRawDepthImage;
-
-  /** The image into which RGB input is to be read each frame. */
-  ITMUChar4Image_Ptr m_inputRGBImage;
-
   /** The interactor that is used to interact with the InfiniTAM scene. */
   Interactor_Ptr m_interactor;
 
@@ -136,6 +148,12 @@ private:
   /** The side length of a VOP patch (must be odd). */
   size_t m_patchSize;
 
+  /** A buffer into which the forest writes the labels it predicts for the voxels sampled during prediction (reused from frame to frame to avoid allocations). */
+  std::vector<spaint::SpaintVoxel::Label> m_predictedLabels;
+
+  /** An arena in which to store the feature descriptors for the voxels sampled during prediction (reused from frame to frame to avoid allocations). */
+  boost::shared_ptr<rafl::DescriptorArena> m_predictionDescriptorArena;
+
   /** A memory block in which to store the feature vectors computed for the various voxels during prediction. */
   boost::shared_ptr<ORUtils::MemoryBlock<float> > m_predictionFeaturesMB;
 
@@ -145,9 +163,18 @@ private:
   /** The voxel sampler used in prediction mode. */
   spaint::UniformVoxelSampler_CPtr m_predictionSampler;
 
+  /** The timer for the prediction section. */
+  StageTimer m_predictionTimer;
+
   /** A memory block in which to store the locations of the voxels sampled for prediction purposes. */
   spaint::Selector::Selection_Ptr m_predictionVoxelLocationsMB;
 
+  /** The timer for the propagation section. */
+  StageTimer m_propagationTimer;
+
+  /** The timer for the raycast preparation stage. */
+  StageTimer m_raycastPreparationTimer;
+
   /** The raycaster that is used to cast rays into the InfiniTAM scene. */
   Raycaster_Ptr m_raycaster;
 
@@ -172,6 +199,9 @@ private:
   /** The tracking controller. */
   TrackingController_Ptr m_trackingController;
 
+  /** The timer for the tracking stage. */
+  StageTimer m_trackingTimer;
+
   /** A memory block in which to store the feature vectors computed for the various voxels during training. */
   boost::shared_ptr<ORUtils::MemoryBlock<float> > m_trainingFeaturesMB;
 
@@ -181,13 +211,16 @@ private:
   /** The voxel sampler used in training mode. */
   spaint::PerLabelVoxelSampler_CPtr m_trainingSampler;
 
+  /** The timer for the training section. */
+  StageTimer m_trainingTimer;
+
   /** A memory block in which to store the number of voxels sampled for each label for training purposes. */
   boost::shared_ptr<ORUtils::MemoryBlock<unsigned int> > m_trainingVoxelCountsMB;
 
   /** A memory block in which to store the locations of the voxels sampled for training purposes. */
   spaint::Selector::Selection_Ptr m_trainingVoxelLocationsMB;
 
-  /** The view builder. */
+  /** The view builder (once the pipeline has been initialised, this is only used via the frame prefetcher). */
   ViewBuilder_Ptr m_viewBuilder;
 
   //#################### CONSTRUCTORS ####################
@@ -203,10 +236,11 @@ public:
    * \param trackerType             The type of tracker to use.
    * \param trackerParams           The parameters for the tracker (if any).
    * \param useInternalCalibration  A flag indicating whether or not to use internal calibration.
+   * \param featureCache            An optional cache in which to store the calculated feature descriptors for reuse (CPU only; NULL to disable caching).
    */
   Pipeline(const std::string& calibrationFilename, const boost::optional<std::string>& openNIDeviceURI, const Settings_Ptr& settings,
            const std::string& resourcesDir, TrackerType trackerType = TRACKER_INFINITAM, const std::string& trackerParams = "",
-           bool useInternalCalibration = false);
+           bool useInternalCalibration = false, const spaint::VOPFeatureCache_Ptr& featureCache = spaint::VOPFeatureCache_Ptr());
 #endif
 
   /**
@@ -217,9 +251,22 @@ public:
    * \param depthImageMask      The mask for the depth image filenames (e.g. "Teddy/Frames/%04i.pgm").
    * \param settings            The settings to use for InfiniTAM.
    * \param resourcesDir        The path to the resources directory.
+   * \param featureCache        An optional cache in which to store the calculated feature descriptors for reuse (CPU only; NULL to disable caching).
    */
   Pipeline(const std::string& calibrationFilename, const std::string& rgbImageMask, const std::string& depthImageMask,
-           const Settings_Ptr& settings, const std::string& resourcesDir);
+           const Settings_Ptr& settings, const std::string& resourcesDir, const spaint::VOPFeatureCache_Ptr& featureCache = spaint::VOPFeatureCache_Ptr());
+
+  /**
+   * \brief Constructs an instance of the pipeline that uses the specified image source engine (e.g. a synthetic one for benchmarking purposes).
+   *
+   * \param imageSourceEngine The engine used to provide input images to the pipeline.
+   * \param settings          The settings to use for InfiniTAM.
+   * \param resourcesDir      The path to the resources directory.
+   * \param prefetchFrames    Whether or not to acquire frames in the background (if not, each frame is acquired when it is needed).
+   * \param featureCache      An optional cache in which to store the calculated feature descriptors for reuse (CPU only; NULL to disable caching).
+   */
+  Pipeline(const ImageSourceEngine_Ptr& imageSourceEngine, const Settings_Ptr& settings, const std::string& resourcesDir, bool prefetchFrames = true,
+           const spaint::VOPFeatureCache_Ptr& featureCache = spaint::VOPFeatureCache_Ptr());
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
@@ -272,6 +319,32 @@ public:
    */
   Raycaster_CPtr get_raycaster() const;
 
+  /**
+   * \brief Gets copies of the timers for the various stages and sections of the pipeline (including those of the frame prefetcher).
+   *
+   * Note: The frame prefetcher runs ahead of the rest of the pipeline, so its timers may include the acquisition and view building
+   *       for up to a couple of frames that have not yet been processed by the main section.
+   *
+   * \return  Copies of the timers for the various stages and sections of the pipeline.
+   */
+  std::vector<StageTimer> get_stage_timers() const;
+
+  /**
+   * \brief Outputs the hit rate of the feature cache (if any) and an estimate of the time it has saved to a stream.
+   *
+   * \param os  The stream.
+   */
+  void output_feature_cache_statistics(std::ostream& os) const;
+
+  /**
+   * \brief Outputs the average latencies of the various stages and sections of the pipeline to a stream.
+   *
+   * Note: The latencies are measured on the host, so for the CUDA implementations they may not include the time spent on the GPU.
+   *
+   * \param os  The stream.
+   */
+  void output_stage_latencies(std::ostream& os) const;
+
   /**
    * \brief Resets the random forest.
    */
@@ -280,9 +353,13 @@ public:
   /**
    * \brief Runs the main section of the pipeline.
    *
-   * This involves processing the next frame from the image source engine.
+   * This involves processing the next frame from the image source engine. The frame is acquired and turned into
+   * a view in the background (whilst the previous frame is being processed), after which it is used for tracking
+   * and fusion, and for preparing the raycast against which to track the following frame.
+   *
+   * \return true, if a frame was processed, or false if the image source engine has run out of images.
    */
-  void run_main_section();
+  bool run_main_section();
 
   /**
    * \brief Runs the mode-specific section of the pipeline.
@@ -313,9 +390,11 @@ private:
   /**
    * \brief Initialises the pipeline.
    *
-   * \param settings  The settings to use for InfiniTAM.
+   * \param settings        The settings to use for InfiniTAM.
+   * \param prefetchFrames  Whether or not to acquire frames in the background.
+   * \param featureCache    An optional cache in which to store the calculated feature descriptors for reuse (may be NULL).
    */
-  void initialise(const Settings_Ptr& settings);
+  void initialise(const Settings_Ptr& settings, bool prefetchFrames, const spaint::VOPFeatureCache_Ptr& featureCache);
 
   /**
    * \brief Makes a hybrid tracker that refines the results of a primary tracker using ICP.
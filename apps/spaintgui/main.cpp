@@ -133,6 +133,10 @@ try
   Application app(pipeline);
   app.run();
 
+  // Output the average latencies of the stages of the pipeline, and the effectiveness of the feature cache.
+  pipeline->output_stage_latencies(std::cout);
+  pipeline->output_feature_cache_statistics(std::cout);
+
 #ifdef WITH_OVR
   // If we built with Rift support, shut down the Rift SDK.
   ovr_Shutdown();
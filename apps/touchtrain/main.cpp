@@ -11,6 +11,7 @@ using boost::assign::list_of;
 #include <evaluation/util/CartesianProductParameterSetGenerator.h>
 using namespace evaluation;
 
+#include <rafl/core/CompiledForest.h>
 #include <rafl/decisionfunctions/DecisionFunctionGeneratorFactory.h>
 using namespace rafl;
 
@@ -154,5 +155,10 @@ int main(int argc, char *argv[])
   std::cout << "[touchtrain] Saving the forest to: " << forestPath << "\n";
   SerializationUtil::save_text(forestPath, *randomForest);
 
+  // Also output a compiled version of the forest as a binary model, which can be loaded much more quickly by the touch detector.
+  std::string modelPath = forestPath + "b";
+  std::cout << "[touchtrain] Saving the binary model to: " << modelPath << "\n";
+  CompiledForest<Label>(*randomForest).save_binary(modelPath);
+
   return 0;
 }
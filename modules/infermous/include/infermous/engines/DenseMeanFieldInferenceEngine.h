@@ -0,0 +1,345 @@
+/**
+ * infermous: DenseMeanFieldInferenceEngine.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_INFERMOUS_DENSEMEANFIELDINFERENCEENGINE
+#define H_INFERMOUS_DENSEMEANFIELDINFERENCEENGINE
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "../base/CRF2D.h"
+
+namespace infermous {
+
+/**
+ * \brief An instance of an instantiation of this class template can be used to run mean-field inference on a 2D CRF using dense arrays.
+ *
+ * This produces the same results as MeanFieldInferenceEngine, but is much faster. Rather than working with the CRF's grids of
+ * label -> probability maps, it stores the unary potentials and marginals as contiguous [height][width][labelCount] arrays,
+ * and precomputes the pairwise potentials between every pair of labels into a matrix, so that no map lookups or virtual
+ * calls are needed during an update. Moreover, since the pairwise potentials depend only on the labels involved, the
+ * marginals of a pixel's neighbours can be summed before (rather than after) they are weighted by the pairwise potentials.
+ * The rows of the CRF are updated in parallel (if OpenMP is available).
+ *
+ * The marginals in the CRF itself are updated at the end of each call to update_crf. The engine assumes that nothing else
+ * changes the CRF's marginals while it is in use.
+ */
+template <typename Label>
+class DenseMeanFieldInferenceEngine
+{
+  //#################### TYPEDEFS ####################
+public:
+  typedef infermous::CRF2D_Ptr<Label> CRF2D_Ptr;
+  typedef infermous::CRF2D_CPtr<Label> CRF2D_CPtr;
+  typedef infermous::ProbabilitiesGrid<Label> ProbabilitiesGrid;
+  typedef infermous::ProbabilitiesGrid_Ptr<Label> ProbabilitiesGrid_Ptr;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The CRF on which the mean-field inference engine works. */
+  CRF2D_Ptr m_crf;
+
+  /** A grid of marginal probabilities that will be swapped with the grid in the CRF at the end of each call to update_crf. */
+  ProbabilitiesGrid_Ptr m_crfMarginals;
+
+  /** The height of the CRF. */
+  int m_height;
+
+  /** The number of labels. */
+  int m_labelCount;
+
+  /** The labels, in ascending order (the position of a label in this list is its index in the dense arrays). */
+  std::vector<Label> m_labels;
+
+  /** The current marginal probabilities, stored as a [height][width][labelCount] array. */
+  std::vector<float> m_marginals;
+
+  /** A list of offsets used to specify the neighbours of each pixel. */
+  std::vector<Eigen::Vector2i> m_neighbourOffsets;
+
+  /** An array of updated marginal probabilities that will be swapped with the current marginals at the end of each time step. */
+  std::vector<float> m_newMarginals;
+
+  /** The pairwise potentials, stored as a [labelCount][labelCount] matrix whose (L',L) element is phi_ij(L,L'). */
+  std::vector<float> m_pairwisePotentials;
+
+  /** The unary potentials, phi_i(L), stored as a [height][width][labelCount] array (the potentials of labels a pixel does not have are infinite). */
+  std::vector<float> m_unaryPotentials;
+
+  /** The width of the CRF. */
+  int m_width;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a dense mean-field inference engine.
+   *
+   * \param crf               The CRF on which the mean-field inference engine works.
+   * \param neighbourOffsets  A list of offsets used to specify the neighbours of each pixel.
+   */
+  DenseMeanFieldInferenceEngine(const CRF2D_Ptr& crf, const std::vector<Eigen::Vector2i>& neighbourOffsets)
+  : m_crf(crf),
+    m_height(crf->get_height()),
+    m_neighbourOffsets(neighbourOffsets),
+    m_width(crf->get_width())
+  {
+    // Collect the labels that are used anywhere in the CRF and assign each of them an index.
+    std::set<Label> labels;
+    for(int y = 0; y < m_height; ++y)
+    {
+      for(int x = 0; x < m_width; ++x)
+      {
+        const std::map<Label,float>& psi_i = crf->get_unaries_at(Eigen::Vector2i(x, y));
+        for(typename std::map<Label,float>::const_iterator kt = psi_i.begin(), kend = psi_i.end(); kt != kend; ++kt)
+        {
+          labels.insert(kt->first);
+        }
+      }
+    }
+
+    m_labels.assign(labels.begin(), labels.end());
+    m_labelCount = static_cast<int>(m_labels.size());
+
+    std::map<Label,int> labelIndices;
+    for(int k = 0; k < m_labelCount; ++k)
+    {
+      labelIndices.insert(std::make_pair(m_labels[k], k));
+    }
+
+    // Precompute the pairwise potentials between every pair of labels.
+    PairwisePotentialCalculator_CPtr<Label> pairwisePotentialCalculator = crf->get_pairwise_potential_calculator();
+    m_pairwisePotentials.resize(m_labelCount * m_labelCount);
+    for(int k = 0; k < m_labelCount; ++k)
+    {
+      for(int kDash = 0; kDash < m_labelCount; ++kDash)
+      {
+        m_pairwisePotentials[kDash * m_labelCount + k] = pairwisePotentialCalculator->calculate_potential(m_labels[k], m_labels[kDash]);
+      }
+    }
+
+    // Copy the unary potentials and the current marginals into dense arrays. A label that a pixel does not have is given an infinite
+    // unary potential and a marginal probability of zero: this ensures that it never contributes to the pixel's neighbours' updates.
+    const size_t elementCount = static_cast<size_t>(m_height) * m_width * m_labelCount;
+    m_marginals.resize(elementCount, 0.0f);
+    m_newMarginals.resize(elementCount, 0.0f);
+    m_unaryPotentials.resize(elementCount, std::numeric_limits<float>::infinity());
+
+    for(int y = 0; y < m_height; ++y)
+    {
+      for(int x = 0; x < m_width; ++x)
+      {
+        const Eigen::Vector2i i(x, y);
+        const size_t offset = pixel_offset(x, y);
+
+        const std::map<Label,float>& psi_i = crf->get_unaries_at(i);
+        for(typename std::map<Label,float>::const_iterator kt = psi_i.begin(), kend = psi_i.end(); kt != kend; ++kt)
+        {
+          m_unaryPotentials[offset + labelIndices[kt->first]] = -logf(kt->second);
+        }
+
+        const std::map<Label,float>& Q_i = crf->get_marginals_at(i);
+        for(typename std::map<Label,float>::const_iterator kt = Q_i.begin(), kend = Q_i.end(); kt != kend; ++kt)
+        {
+          m_marginals[offset + labelIndices[kt->first]] = kt->second;
+        }
+      }
+    }
+
+    // Make the grid of marginal probabilities that will be swapped into the CRF. Its maps are given the same labels as the unaries,
+    // so that writing the updated marginals into it never needs to insert anything.
+    m_crfMarginals.reset(new ProbabilitiesGrid(m_height, m_width));
+    for(int y = 0; y < m_height; ++y)
+    {
+      for(int x = 0; x < m_width; ++x)
+      {
+        const std::map<Label,float>& psi_i = crf->get_unaries_at(Eigen::Vector2i(x, y));
+        std::map<Label,float>& Q_i = (*m_crfMarginals)(y, x);
+        for(typename std::map<Label,float>::const_iterator kt = psi_i.begin(), kend = psi_i.end(); kt != kend; ++kt)
+        {
+          Q_i.insert(std::make_pair(kt->first, 0.0f));
+        }
+      }
+    }
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the CRF on which the mean-field inference engine works.
+   *
+   * \return  The CRF on which the mean-field inference engine works.
+   */
+  CRF2D_CPtr get_crf() const
+  {
+    return m_crf;
+  }
+
+  /**
+   * \brief Gets the labels, in the order in which their marginal probabilities are stored for each pixel.
+   *
+   * \return  The labels.
+   */
+  const std::vector<Label>& get_labels() const
+  {
+    return m_labels;
+  }
+
+  /**
+   * \brief Gets the current marginal probabilities for the specified location.
+   *
+   * \param loc The location whose marginal probabilities we want to get.
+   * \return    A pointer to the marginal probabilities for the specified location (one for each label, in the order returned by get_labels).
+   */
+  const float *get_marginals_at(const Eigen::Vector2i& loc) const
+  {
+    return &m_marginals[pixel_offset(loc.x(), loc.y())];
+  }
+
+  /**
+   * \brief Predicts the labels for each pixel in the CRF, without going via the CRF's own marginals.
+   *
+   * If several labels are equally likely for a pixel, the smallest one is chosen (as in CRFUtil::predict_labels).
+   *
+   * \return  The grid of predicted labels.
+   */
+  Grid<Label> predict_labels() const
+  {
+    Grid<Label> result(m_height, m_width);
+    for(int y = 0; y < m_height; ++y)
+    {
+      for(int x = 0; x < m_width; ++x)
+      {
+        const float *Q_i = &m_marginals[pixel_offset(x, y)];
+        int bestIndex = 0;
+        for(int k = 1; k < m_labelCount; ++k)
+        {
+          if(Q_i[k] > Q_i[bestIndex]) bestIndex = k;
+        }
+        result(y, x) = m_labels[bestIndex];
+      }
+    }
+    return result;
+  }
+
+  /**
+   * \brief Updates the CRF on which the mean-field inference engine works.
+   *
+   * \param iterations  The number of update iterations to run.
+   */
+  void update_crf(size_t iterations)
+  {
+    if(m_labelCount == 0) return;
+
+    for(size_t i = 0; i < iterations; ++i)
+    {
+#ifdef WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int y = 0; y < m_height; ++y)
+      {
+        std::vector<float> neighbourSums(m_labelCount), M_i(m_labelCount);
+        for(int x = 0; x < m_width; ++x)
+        {
+          compute_updated_pixel(x, y, &neighbourSums[0], &M_i[0]);
+        }
+      }
+
+      // Swap the new marginals into place.
+      m_marginals.swap(m_newMarginals);
+    }
+
+    // Write the marginals into the CRF.
+    for(int y = 0; y < m_height; ++y)
+    {
+      for(int x = 0; x < m_width; ++x)
+      {
+        const float *Q_i = &m_marginals[pixel_offset(x, y)];
+        std::map<Label,float>& crfQ_i = (*m_crfMarginals)(y, x);
+        int k = 0;
+        for(typename std::map<Label,float>::iterator kt = crfQ_i.begin(), kend = crfQ_i.end(); kt != kend; ++kt)
+        {
+          while(m_labels[k] < kt->first) ++k;
+          kt->second = Q_i[k];
+        }
+      }
+    }
+
+    m_crf->swap_marginals(m_crfMarginals);
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Computes the updated version of the specified pixel in the CRF.
+   *
+   * See p.6 of the original SemanticPaint paper for details. For each label L, we compute
+   *
+   *   M_i(L) = phi_i(L) + \sum_{L'} phi_ij(L,L') * (\sum_j Q_j^{t-1}(L')),
+   *
+   * and then Q_i^t(L) = 1/Z_i * e^-M_i(L). The inner loops all run over contiguous arrays of labels, so that the compiler can vectorise them.
+   *
+   * \param x             The x coordinate of the pixel whose updated version we want to compute.
+   * \param y             The y coordinate of the pixel whose updated version we want to compute.
+   * \param neighbourSums Scratch space for the sums of the neighbours' marginals (one element per label).
+   * \param M_i           Scratch space for the values of M_i(L) (one element per label).
+   */
+  void compute_updated_pixel(int x, int y, float *neighbourSums, float *M_i)
+  {
+    const int labelCount = m_labelCount;
+
+    // Sum the marginals of the pixel's neighbours, skipping any neighbours that are not within the CRF.
+    for(int k = 0; k < labelCount; ++k) neighbourSums[k] = 0.0f;
+    for(std::vector<Eigen::Vector2i>::const_iterator nt = m_neighbourOffsets.begin(), nend = m_neighbourOffsets.end(); nt != nend; ++nt)
+    {
+      const int jx = x + nt->x(), jy = y + nt->y();
+      if(jx < 0 || jx >= m_width || jy < 0 || jy >= m_height) continue;
+
+      const float *Q_j = &m_marginals[pixel_offset(jx, jy)];
+      for(int k = 0; k < labelCount; ++k) neighbourSums[k] += Q_j[k];
+    }
+
+    // Calculate M_i(L) for every L.
+    const size_t offset = pixel_offset(x, y);
+    const float *phi_i = &m_unaryPotentials[offset];
+    for(int k = 0; k < labelCount; ++k) M_i[k] = phi_i[k];
+    for(int kDash = 0; kDash < labelCount; ++kDash)
+    {
+      const float neighbourSum = neighbourSums[kDash];
+      const float *phi_ij_LDash = &m_pairwisePotentials[kDash * labelCount];
+      for(int k = 0; k < labelCount; ++k) M_i[k] += phi_ij_LDash[k] * neighbourSum;
+    }
+
+    // Calculate the unnormalised new probabilities for the pixel, together with the normalisation constant, and then normalise them.
+    float *Q_i = &m_newMarginals[offset];
+    float Z_i = 0.0f;
+    for(int k = 0; k < labelCount; ++k)
+    {
+      Q_i[k] = expf(-M_i[k]);
+      Z_i += Q_i[k];
+    }
+
+    const float oneOverZ_i = 1.0f / Z_i;
+    for(int k = 0; k < labelCount; ++k) Q_i[k] *= oneOverZ_i;
+  }
+
+  /**
+   * \brief Calculates the offset of the first element for the specified pixel in the dense arrays.
+   *
+   * \param x The x coordinate of the pixel.
+   * \param y The y coordinate of the pixel.
+   * \return  The offset of the first element for the pixel in the dense arrays.
+   */
+  size_t pixel_offset(int x, int y) const
+  {
+    return (static_cast<size_t>(y) * m_width + x) * m_labelCount;
+  }
+};
+
+}
+
+#endif
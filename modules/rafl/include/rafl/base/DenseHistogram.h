@@ -0,0 +1,245 @@
+/**
+ * rafl: DenseHistogram.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_DENSEHISTOGRAM
+#define H_RAFL_DENSEHISTOGRAM
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/split_member.hpp>
+
+#include <tvgutil/LimitedContainer.h>
+
+namespace rafl {
+
+/**
+ * \brief An instance of an instantiation of this class template represents a histogram over the specified label type, stored as an array of bins.
+ *
+ * This has the same interface (and serialization format) as Histogram, but rather than storing its bins in a map, it stores the bins
+ * for small, non-negative labels in an array indexed by a compact label ID (namely, the label itself). Adding an instance of such a
+ * label to the histogram or reading its bin is thus a simple array access. The bins for any other labels (i.e. negative labels and
+ * labels >= DENSE_LABEL_LIMIT) are stored in a map, as for Histogram, so that a label set that is not small and dense from 0 still
+ * works, and a single large label never causes a correspondingly large array to be allocated.
+ */
+template <typename Label>
+class DenseHistogram
+{
+  //#################### CONSTANTS ####################
+public:
+  /** The number of labels (starting from 0) whose bins are stored in the array rather than the map. */
+  static const size_t DENSE_LABEL_LIMIT = 256;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The bins that record the number of instances of each small, non-negative label that have been seen (indexed by label ID). */
+  std::vector<size_t> m_bins;
+
+  /** The total number of instances that are in the histogram. */
+  size_t m_count;
+
+  /** The bins that record the number of instances of any other label that have been seen. */
+  std::map<Label,size_t> m_sparseBins;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs an empty histogram.
+   *
+   * \param labelCount  The number of array bins to allocate up-front (the array grows if a label with a larger ID is added).
+   */
+  explicit DenseHistogram(size_t labelCount = 0)
+  : m_bins(std::min(labelCount, DENSE_LABEL_LIMIT)), m_count(0)
+  {}
+
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Attempts to get the compact ID of the specified label.
+   *
+   * Only labels in the range [0,DENSE_LABEL_LIMIT) have compact IDs (the ID of such a label is the label itself).
+   *
+   * \param label The label.
+   * \param id    A variable into which to write the ID of the label (if it has one).
+   * \return      true, if the label has a compact ID, or false otherwise.
+   */
+  static bool try_get_label_id(const Label& label, size_t& id)
+  {
+    const long long value = static_cast<long long>(label);
+    if(value < 0 || value >= static_cast<long long>(DENSE_LABEL_LIMIT)) return false;
+    id = static_cast<size_t>(value);
+    return true;
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Adds an instance of the specified label to the histogram.
+   *
+   * \param label The label for which to add an instance.
+   */
+  void add(const Label& label)
+  {
+    size_t id;
+    if(try_get_label_id(label, id))
+    {
+      if(id >= m_bins.size()) m_bins.resize(id + 1, 0);
+      ++m_bins[id];
+    }
+    else ++m_sparseBins[label];
+
+    ++m_count;
+  }
+
+  /**
+   * \brief Gets whether or not this is an empty histogram.
+   *
+   * \return  true, if the histogram is empty, or false otherwise.
+   */
+  bool empty() const
+  {
+    return get_count() == 0;
+  }
+
+  /**
+   * \brief Gets the number of instances of the specified label that have been seen.
+   *
+   * \param label The label.
+   * \return      The number of instances of the label that have been seen.
+   */
+  size_t get_bin(const Label& label) const
+  {
+    size_t id;
+    if(try_get_label_id(label, id)) return id < m_bins.size() ? m_bins[id] : 0;
+
+    typename std::map<Label,size_t>::const_iterator it = m_sparseBins.find(label);
+    return it != m_sparseBins.end() ? it->second : 0;
+  }
+
+  /**
+   * \brief Gets the bins that record the number of instances of each label that have been seen.
+   *
+   * Note that, as with Histogram, only labels that have been seen have bins in the map. The map is built on demand,
+   * so callers that care about performance should use get_dense_bins instead.
+   *
+   * \return The bins that record the number of instances of each label that have been seen.
+   */
+  std::map<Label,size_t> get_bins() const
+  {
+    std::map<Label,size_t> bins(m_sparseBins);
+    for(size_t id = 0, size = m_bins.size(); id < size; ++id)
+    {
+      if(m_bins[id] > 0) bins.insert(std::make_pair(static_cast<Label>(id), m_bins[id]));
+    }
+    return bins;
+  }
+
+  /**
+   * \brief Gets the total number of instances that are in the histogram.
+   *
+   * \return The total number of instances that are in the histogram.
+   */
+  size_t get_count() const
+  {
+    return m_count;
+  }
+
+  /**
+   * \brief Gets the array of bins that record the number of instances of each small, non-negative label that have been seen.
+   *
+   * \return The array of bins (indexed by label ID).
+   */
+  const std::vector<size_t>& get_dense_bins() const
+  {
+    return m_bins;
+  }
+
+  /**
+   * \brief Gets the bins that record the number of instances of each label without a compact ID that have been seen.
+   *
+   * \return The bins for the labels without compact IDs.
+   */
+  const std::map<Label,size_t>& get_sparse_bins() const
+  {
+    return m_sparseBins;
+  }
+
+  //#################### SERIALIZATION ####################
+private:
+  /**
+   * \brief Loads the histogram from an archive.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void load(Archive& ar, const unsigned int version)
+  {
+    std::map<Label,size_t> bins;
+    ar & bins;
+    ar & m_count;
+
+    m_bins.clear();
+    m_sparseBins.clear();
+    for(typename std::map<Label,size_t>::const_iterator it = bins.begin(), iend = bins.end(); it != iend; ++it)
+    {
+      size_t id;
+      if(try_get_label_id(it->first, id))
+      {
+        if(id >= m_bins.size()) m_bins.resize(id + 1, 0);
+        m_bins[id] = it->second;
+      }
+      else m_sparseBins.insert(m_sparseBins.end(), *it);
+    }
+  }
+
+  /**
+   * \brief Saves the histogram to an archive.
+   *
+   * The histogram is saved in exactly the same way as the equivalent Histogram, so that the two can be used interchangeably in archives.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void save(Archive& ar, const unsigned int version) const
+  {
+    std::map<Label,size_t> bins = get_bins();
+    ar & bins;
+    ar & m_count;
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+  friend class boost::serialization::access;
+};
+
+//#################### STATIC MEMBER DEFINITIONS ####################
+
+template <typename Label> const size_t DenseHistogram<Label>::DENSE_LABEL_LIMIT;
+
+//#################### STREAM OPERATORS ####################
+
+/**
+ * \brief Outputs a dense histogram to the specified stream.
+ *
+ * \param os  The stream to which to output the histogram.
+ * \param rhs The histogram to output.
+ * \return    The stream.
+ */
+template <typename Label>
+std::ostream& operator<<(std::ostream& os, const DenseHistogram<Label>& rhs)
+{
+  const size_t ELEMENT_DISPLAY_LIMIT = 10;
+  os << tvgutil::make_limited_container(rhs.get_bins(), ELEMENT_DISPLAY_LIMIT);
+  return os;
+}
+
+}
+
+#endif
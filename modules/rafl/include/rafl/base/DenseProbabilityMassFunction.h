@@ -0,0 +1,386 @@
+/**
+ * rafl: DenseProbabilityMassFunction.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_DENSEPROBABILITYMASSFUNCTION
+#define H_RAFL_DENSEPROBABILITYMASSFUNCTION
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+
+#include "DenseHistogram.h"
+#include "ProbabilityMassFunction.h"
+
+namespace rafl {
+
+/**
+ * \brief An instance of an instantiation of this class template represents a probability mass function (PMF), stored as an array of masses.
+ *
+ * This has the same interface as ProbabilityMassFunction (and calculates exactly the same results), but stores the masses of
+ * labels that have compact IDs (see DenseHistogram) in an array indexed by those IDs rather than in a map. The masses of any
+ * other labels are stored in a map, as for ProbabilityMassFunction.
+ *
+ * Datatype Invariant: The masses in the PMF must sum to 1.
+ */
+template <typename Label>
+class DenseProbabilityMassFunction
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The masses for the various labels (indexed by label ID). */
+  std::vector<float> m_masses;
+
+  /** Flags indicating which labels are in the PMF (a label can be in the PMF with a mass of zero, as for ProbabilityMassFunction). */
+  std::vector<unsigned char> m_present;
+
+  /** The masses for any labels without compact IDs (all of which are in the PMF). */
+  std::map<Label,float> m_sparseMasses;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a probability mass function (PMF) by normalising a map from labels -> masses.
+   *
+   * \pre
+   *   - !masses.empty()
+   *   - Each mass >= 0
+   *   - At least one mass > 0
+   *
+   * \param masses  The label -> masses map to normalise.
+   */
+  explicit DenseProbabilityMassFunction(const std::map<Label,float>& masses)
+  {
+    assert(!masses.empty());
+
+    for(typename std::map<Label,float>::const_iterator it = masses.begin(), iend = masses.end(); it != iend; ++it)
+    {
+      size_t id;
+      if(DenseHistogram<Label>::try_get_label_id(it->first, id))
+      {
+        if(id >= m_masses.size())
+        {
+          m_masses.resize(id + 1, 0.0f);
+          m_present.resize(id + 1, 0);
+        }
+        m_masses[id] = it->second;
+        m_present[id] = 1;
+      }
+      else m_sparseMasses.insert(m_sparseMasses.end(), *it);
+    }
+
+    normalise();
+    ensure_invariant();
+  }
+
+  /**
+   * \brief Constructs a probability mass function (PMF) by normalising an array of masses.
+   *
+   * Labels whose masses are zero are considered not to be in the PMF.
+   *
+   * \pre
+   *   - Each mass >= 0
+   *   - At least one mass > 0
+   *
+   * \param masses  The masses to normalise (indexed by label ID, so there can be at most DenseHistogram<Label>::DENSE_LABEL_LIMIT of them).
+   */
+  explicit DenseProbabilityMassFunction(const std::vector<float>& masses)
+  : m_masses(masses), m_present(masses.size())
+  {
+    assert(masses.size() <= DenseHistogram<Label>::DENSE_LABEL_LIMIT);
+    for(size_t id = 0, size = m_masses.size(); id < size; ++id)
+    {
+      m_present[id] = m_masses[id] > 0.0f ? 1 : 0;
+    }
+
+    normalise();
+    ensure_invariant();
+  }
+
+  /**
+   * \brief Constructs a probability mass function (PMF) as a normalised version of the specified histogram.
+   *
+   * \param histogram   The histogram from which to construct a PMF.
+   * \param multipliers Optional per-class ratios that can be used to scale the probabilities for the different labels.
+   */
+  explicit DenseProbabilityMassFunction(const DenseHistogram<Label>& histogram, const boost::optional<std::map<Label,float> >& multipliers = boost::none)
+  {
+    // Determine the masses for the labels in the histogram by dividing the number of instances in each bin by the histogram count.
+    const std::vector<size_t>& bins = histogram.get_dense_bins();
+    size_t count = histogram.get_count();
+    if(count == 0) throw std::runtime_error("Cannot make a probability mass function from an empty histogram");
+
+    m_masses.resize(bins.size(), 0.0f);
+    m_present.resize(bins.size(), 0);
+    for(size_t id = 0, size = bins.size(); id < size; ++id)
+    {
+      if(bins[id] == 0) continue;
+      m_masses[id] = calculate_mass(static_cast<Label>(id), bins[id], count, multipliers);
+      m_present[id] = 1;
+    }
+
+    const std::map<Label,size_t>& sparseBins = histogram.get_sparse_bins();
+    for(typename std::map<Label,size_t>::const_iterator it = sparseBins.begin(), iend = sparseBins.end(); it != iend; ++it)
+    {
+      m_sparseMasses.insert(m_sparseMasses.end(), std::make_pair(it->first, calculate_mass(it->first, it->second, count, multipliers)));
+    }
+
+    if(multipliers) normalise();
+
+    ensure_invariant();
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Returns a label in the PMF that has the highest mass.
+   *
+   * If there is more than one label with the highest mass, the smallest one is returned (as for ProbabilityMassFunction).
+   *
+   * \return  The calculated label.
+   */
+  Label calculate_best_label() const
+  {
+    // Note: The labels without compact IDs that precede the labels with compact IDs are the negative ones.
+    const typename std::map<Label,float>::const_iterator split = first_large_sparse_mass();
+
+    bool found = false;
+    Label bestLabel = Label();
+    float bestMass = 0.0f;
+    for(typename std::map<Label,float>::const_iterator it = m_sparseMasses.begin(); it != split; ++it)
+    {
+      if(!found || it->second > bestMass) { bestLabel = it->first; bestMass = it->second; found = true; }
+    }
+    for(size_t id = 0, size = m_masses.size(); id < size; ++id)
+    {
+      if(m_present[id] && (!found || m_masses[id] > bestMass)) { bestLabel = static_cast<Label>(id); bestMass = m_masses[id]; found = true; }
+    }
+    for(typename std::map<Label,float>::const_iterator it = split, iend = m_sparseMasses.end(); it != iend; ++it)
+    {
+      if(!found || it->second > bestMass) { bestLabel = it->first; bestMass = it->second; found = true; }
+    }
+    return bestLabel;
+  }
+
+  /**
+   * \brief Calculates the entropy of the PMF using the definition H(X) = -sum_{i} P(x_i) log2(P(x_i)).
+   *
+   * \return The entropy of the PMF. When outcomes are equally likely, the entropy will be high; when the outcome is predictable, the entropy wil be low.
+   */
+  float calculate_entropy() const
+  {
+    // Note: The masses are visited in ascending order of label (as in ProbabilityMassFunction), so that the sums are bit-identical.
+    const typename std::map<Label,float>::const_iterator split = first_large_sparse_mass();
+
+    float entropy = 0.0f;
+    for(typename std::map<Label,float>::const_iterator it = m_sparseMasses.begin(); it != split; ++it)
+    {
+      add_entropy_term(it->second, entropy);
+    }
+    for(size_t id = 0, size = m_masses.size(); id < size; ++id)
+    {
+      add_entropy_term(m_masses[id], entropy);
+    }
+    for(typename std::map<Label,float>::const_iterator it = split, iend = m_sparseMasses.end(); it != iend; ++it)
+    {
+      add_entropy_term(it->second, entropy);
+    }
+    return -entropy;
+  }
+
+  /**
+   * \brief Gets the array of masses for the various labels.
+   *
+   * \return The array of masses (indexed by label ID).
+   */
+  const std::vector<float>& get_dense_masses() const
+  {
+    return m_masses;
+  }
+
+  /**
+   * \brief Gets the masses for any labels without compact IDs.
+   *
+   * \return The masses for the labels without compact IDs.
+   */
+  const std::map<Label,float>& get_sparse_masses() const
+  {
+    return m_sparseMasses;
+  }
+
+  /**
+   * \brief Gets the mass for the specified label.
+   *
+   * \param label The label.
+   * \return      The mass for the label (zero, if the label is not in the PMF).
+   */
+  float get_mass(const Label& label) const
+  {
+    size_t id;
+    if(DenseHistogram<Label>::try_get_label_id(label, id)) return id < m_masses.size() ? m_masses[id] : 0.0f;
+
+    typename std::map<Label,float>::const_iterator it = m_sparseMasses.find(label);
+    return it != m_sparseMasses.end() ? it->second : 0.0f;
+  }
+
+  /**
+   * \brief Gets the masses for the various labels.
+   *
+   * The map is built on demand, so callers that care about performance should use get_dense_masses instead.
+   *
+   * \return The masses for the various labels.
+   */
+  std::map<Label,float> get_masses() const
+  {
+    std::map<Label,float> masses(m_sparseMasses);
+    for(size_t id = 0, size = m_masses.size(); id < size; ++id)
+    {
+      if(m_present[id]) masses.insert(std::make_pair(static_cast<Label>(id), m_masses[id]));
+    }
+    return masses;
+  }
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Adds the entropy term for the specified mass to a running sum.
+   *
+   * \param mass    The mass.
+   * \param entropy The running sum.
+   */
+  static void add_entropy_term(float mass, float& entropy)
+  {
+    if(mass > 0)
+    {
+      // Note: If P(x_i) = 0, the value of the corresponding sum 0*log2(0) is taken to be 0, since lim{p->0+} p*log2(p) = 0.
+      entropy += mass * log2(mass);
+    }
+  }
+
+  /**
+   * \brief Calculates the mass for a label in a histogram.
+   *
+   * \param label       The label.
+   * \param binCount    The number of instances of the label in the histogram.
+   * \param count       The total number of instances in the histogram.
+   * \param multipliers Optional per-class ratios that can be used to scale the probabilities for the different labels.
+   * \return            The mass for the label.
+   */
+  static float calculate_mass(const Label& label, size_t binCount, size_t count, const boost::optional<std::map<Label,float> >& multipliers)
+  {
+    float mass = static_cast<float>(binCount) / count;
+
+    // Scale the mass by the relevant multiplier for the corresponding class (if supplied).
+    if(multipliers)
+    {
+      typename std::map<Label,float>::const_iterator jt = multipliers->find(label);
+      if(jt != multipliers->end()) mass *= jt->second;
+    }
+
+    // As for ProbabilityMassFunction, our implementation is dependent on the masses never becoming too small.
+    assert(mass >= SMALL_EPSILON);
+
+    return mass;
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Calculates the sum of the masses in the PMF.
+   *
+   * \return  The sum of the masses in the PMF.
+   */
+  float calculate_sum() const
+  {
+    // Note: The masses are summed in ascending order of label (as in ProbabilityMassFunction), so that the sums are bit-identical.
+    const typename std::map<Label,float>::const_iterator split = first_large_sparse_mass();
+
+    float sum = 0.0f;
+    for(typename std::map<Label,float>::const_iterator it = m_sparseMasses.begin(); it != split; ++it)
+    {
+      assert(it->second >= 0.0f);
+      sum += it->second;
+    }
+    for(size_t id = 0, size = m_masses.size(); id < size; ++id)
+    {
+      assert(m_masses[id] >= 0.0f);
+      sum += m_masses[id];
+    }
+    for(typename std::map<Label,float>::const_iterator it = split, iend = m_sparseMasses.end(); it != iend; ++it)
+    {
+      assert(it->second >= 0.0f);
+      sum += it->second;
+    }
+    return sum;
+  }
+
+  /**
+   * \brief Ensures that the datatype invariant for the PMF is satisfied, i.e. that its masses sum to 1.
+   */
+  void ensure_invariant() const
+  {
+    const float MAX_TOLERANCE = 1e-5f;
+    float sum = calculate_sum();
+    if(fabs(sum - 1.0f) >= MAX_TOLERANCE)
+    {
+      throw std::runtime_error("The masses in the PMF should sum to 1, but they sum to " + boost::lexical_cast<std::string>(sum));
+    }
+  }
+
+  /**
+   * \brief Normalises the PMF by dividing by the sum of its masses.
+   */
+  void normalise()
+  {
+    // Calculate the sum of the masses in the PMF.
+    float sum = calculate_sum();
+    if(fabs(sum) < SMALL_EPSILON) throw std::runtime_error("Cannot normalise the probability mass function: denominator too small");
+
+    // Normalise the PMF by dividing each mass by the sum.
+    for(size_t id = 0, size = m_masses.size(); id < size; ++id)
+    {
+      m_masses[id] /= sum;
+    }
+    for(typename std::map<Label,float>::iterator it = m_sparseMasses.begin(), iend = m_sparseMasses.end(); it != iend; ++it)
+    {
+      it->second /= sum;
+    }
+  }
+
+  /**
+   * \brief Finds the first of the masses for the labels without compact IDs whose label is larger than any compact ID.
+   *
+   * The labels without compact IDs that precede this one are the negative ones.
+   *
+   * \return An iterator to the first such mass (or the end of the map, if there are none).
+   */
+  typename std::map<Label,float>::const_iterator first_large_sparse_mass() const
+  {
+    return m_sparseMasses.lower_bound(static_cast<Label>(0));
+  }
+};
+
+//#################### STREAM OPERATORS ####################
+
+/**
+ * \brief Outputs a dense probability mass function (PMF) to the specified stream.
+ *
+ * \param os  The stream to which to output the PMF.
+ * \param rhs The PMF to output.
+ * \return    The stream.
+ */
+template <typename Label>
+std::ostream& operator<<(std::ostream& os, const DenseProbabilityMassFunction<Label>& rhs)
+{
+  const size_t ELEMENT_DISPLAY_LIMIT = 3;
+  os << tvgutil::make_limited_container(rhs.get_masses(), ELEMENT_DISPLAY_LIMIT);
+  return os;
+}
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * rafl: DescriptorArena.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_DESCRIPTORARENA
+#define H_RAFL_DESCRIPTORARENA
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+
+#include "DescriptorView.h"
+
+namespace rafl {
+
+/**
+ * \brief An instance of this class stores a set of feature descriptors contiguously, as the rows of a single aligned float matrix.
+ *
+ * Each row starts on a cache-line boundary (i.e. the row stride is the feature count rounded up to a whole number of
+ * cache lines). Resizing an arena only allocates if its existing storage is too small, so an arena that is reused for
+ * each frame will stop allocating once it has grown to the largest size needed.
+ */
+class DescriptorArena
+{
+  //#################### CONSTANTS ####################
+public:
+  /** The alignment (in floats) of the start of each row (64 bytes, i.e. one cache line). */
+  static const size_t ROW_ALIGNMENT = 16;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The underlying (over-allocated) storage for the arena. */
+  std::vector<float> m_buffer;
+
+  /** The offset of the first row within the buffer (needed to align the rows). */
+  size_t m_offset;
+
+  /** The number of descriptors in the arena. */
+  size_t m_descriptorCount;
+
+  /** The number of features in each descriptor. */
+  size_t m_featureCount;
+
+  /** The distance (in floats) between the starts of consecutive rows. */
+  size_t m_stride;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs an empty arena.
+   */
+  DescriptorArena()
+  : m_offset(0), m_descriptorCount(0), m_featureCount(0), m_stride(0)
+  {}
+
+  /**
+   * \brief Constructs an arena that can store the specified number of descriptors.
+   *
+   * \param descriptorCount The number of descriptors.
+   * \param featureCount    The number of features in each descriptor.
+   */
+  DescriptorArena(size_t descriptorCount, size_t featureCount)
+  : m_offset(0), m_descriptorCount(0), m_featureCount(0), m_stride(0)
+  {
+    resize(descriptorCount, featureCount);
+  }
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  DescriptorArena(const DescriptorArena&);
+  DescriptorArena& operator=(const DescriptorArena&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the number of descriptors in the arena.
+   *
+   * \return  The number of descriptors in the arena.
+   */
+  size_t get_descriptor_count() const
+  {
+    return m_descriptorCount;
+  }
+
+  /**
+   * \brief Gets the number of features in each descriptor.
+   *
+   * \return  The number of features in each descriptor.
+   */
+  size_t get_feature_count() const
+  {
+    return m_featureCount;
+  }
+
+  /**
+   * \brief Gets the specified row of the arena.
+   *
+   * \param i The index of the row.
+   * \return  A pointer to the first feature in the row.
+   */
+  float *get_row(size_t i)
+  {
+    return &m_buffer[m_offset + i * m_stride];
+  }
+
+  /**
+   * \brief Gets the specified row of the arena.
+   *
+   * \param i The index of the row.
+   * \return  A pointer to the first feature in the row.
+   */
+  const float *get_row(size_t i) const
+  {
+    return &m_buffer[m_offset + i * m_stride];
+  }
+
+  /**
+   * \brief Gets the distance (in floats) between the starts of consecutive rows.
+   *
+   * \return  The distance (in floats) between the starts of consecutive rows.
+   */
+  size_t get_stride() const
+  {
+    return m_stride;
+  }
+
+  /**
+   * \brief Gets a view of the specified descriptor.
+   *
+   * \param i                   The index of the descriptor.
+   * \return                    A view of the descriptor.
+   * \throws std::out_of_range  If the index is invalid.
+   */
+  DescriptorView get_view(size_t i) const
+  {
+    if(i >= m_descriptorCount) throw std::out_of_range("Bad descriptor index");
+    return DescriptorView(get_row(i), m_featureCount);
+  }
+
+  /**
+   * \brief Makes a standalone copy of the specified descriptor.
+   *
+   * \param i                   The index of the descriptor.
+   * \return                    The copy of the descriptor.
+   * \throws std::out_of_range  If the index is invalid.
+   */
+  Descriptor_Ptr make_descriptor(size_t i) const
+  {
+    DescriptorView view = get_view(i);
+    return Descriptor_Ptr(new Descriptor(view.begin(), view.end()));
+  }
+
+  /**
+   * \brief Resizes the arena so that it can store the specified number of descriptors.
+   *
+   * The contents of the arena are unspecified after a resize. No allocation takes place unless the arena's existing storage is too small.
+   *
+   * \param descriptorCount The number of descriptors.
+   * \param featureCount    The number of features in each descriptor.
+   */
+  void resize(size_t descriptorCount, size_t featureCount)
+  {
+    m_descriptorCount = descriptorCount;
+    m_featureCount = featureCount;
+    m_stride = (featureCount + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+
+    // Over-allocate by one alignment unit so that we can always align the first row.
+    size_t requiredSize = descriptorCount * m_stride + ROW_ALIGNMENT;
+    if(m_buffer.size() < requiredSize) m_buffer.resize(requiredSize);
+
+    // Note: The offset must be recalculated whenever the buffer is reallocated.
+    const size_t alignmentInBytes = ROW_ALIGNMENT * sizeof(float);
+    boost::uintptr_t address = reinterpret_cast<boost::uintptr_t>(&m_buffer[0]);
+    m_offset = ((alignmentInBytes - address % alignmentInBytes) % alignmentInBytes) / sizeof(float);
+  }
+};
+
+}
+
+#endif
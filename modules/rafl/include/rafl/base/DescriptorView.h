@@ -0,0 +1,121 @@
+/**
+ * rafl: DescriptorView.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_DESCRIPTORVIEW
+#define H_RAFL_DESCRIPTORVIEW
+
+#include <cassert>
+
+#include "Descriptor.h"
+
+namespace rafl {
+
+/**
+ * \brief An instance of this class provides a lightweight, non-owning, read-only view of a feature descriptor.
+ *
+ * Views allow code that only needs to read descriptors (e.g. decision functions) to work equally well with
+ * descriptors stored as individual vectors and descriptors stored as rows of a DescriptorArena. The storage
+ * being viewed must outlive the view.
+ */
+class DescriptorView
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** A pointer to the first feature in the descriptor. */
+  const float *m_data;
+
+  /** The number of features in the descriptor. */
+  size_t m_size;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs an empty view.
+   */
+  DescriptorView()
+  : m_data(NULL), m_size(0)
+  {}
+
+  /**
+   * \brief Constructs a view of a descriptor that is stored as a raw array of features.
+   *
+   * \param data  A pointer to the first feature in the descriptor.
+   * \param size  The number of features in the descriptor.
+   */
+  DescriptorView(const float *data, size_t size)
+  : m_data(data), m_size(size)
+  {}
+
+  /**
+   * \brief Constructs a view of a descriptor that is stored as a vector.
+   *
+   * Note: This constructor is deliberately implicit, so that descriptors can be passed wherever views are expected.
+   *
+   * \param descriptor  The descriptor.
+   */
+  DescriptorView(const Descriptor& descriptor)
+  : m_data(descriptor.empty() ? NULL : &descriptor[0]), m_size(descriptor.size())
+  {}
+
+  //#################### PUBLIC OPERATORS ####################
+public:
+  /**
+   * \brief Gets the specified feature of the descriptor.
+   *
+   * \param i The index of the feature.
+   * \return  The feature.
+   */
+  const float& operator[](size_t i) const
+  {
+    assert(i < m_size);
+    return m_data[i];
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets a pointer to the first feature in the descriptor.
+   *
+   * \return  A pointer to the first feature in the descriptor.
+   */
+  const float *begin() const
+  {
+    return m_data;
+  }
+
+  /**
+   * \brief Gets a pointer to the features of the descriptor.
+   *
+   * \return  A pointer to the features of the descriptor.
+   */
+  const float *data() const
+  {
+    return m_data;
+  }
+
+  /**
+   * \brief Gets a pointer to just beyond the last feature in the descriptor.
+   *
+   * \return  A pointer to just beyond the last feature in the descriptor.
+   */
+  const float *end() const
+  {
+    return m_data + m_size;
+  }
+
+  /**
+   * \brief Gets the number of features in the descriptor.
+   *
+   * \return  The number of features in the descriptor.
+   */
+  size_t size() const
+  {
+    return m_size;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,716 @@
+/**
+ * rafl: CompiledForest.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_COMPILEDFOREST
+#define H_RAFL_COMPILEDFOREST
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+
+#include <boost/crc.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/static_assert.hpp>
+
+#include "../decisionfunctions/FeatureThresholdingDecisionFunction.h"
+#include "../decisionfunctions/PairwiseOpAndThresholdDecisionFunction.h"
+#include "RandomForest.h"
+
+namespace rafl {
+
+/**
+ * \brief An instance of an instantiation of this class template represents a read-only, "compiled" version of a random forest
+ *        that is optimised for fast prediction.
+ *
+ * Compiling a forest lowers all of its decision trees into a single contiguous node table that is stored as a structure of arrays
+ * (node types, feature indices, thresholds and child indices), together with a dense block of leaf masses that stores the PMF of
+ * each leaf as a row of floats (one per label). Descriptors can then be classified without any virtual calls, pointer chasing or
+ * map construction. The predictions made by a compiled forest are bit-exact with those made by the forest from which it was compiled.
+ *
+ * Note that a compiled forest is a snapshot: it does not reflect any training done on the original forest after it was compiled.
+ *
+ * A compiled forest can be saved to a compact binary model file (see save_binary for the format). Loading a model file maps it
+ * into memory and serves predictions straight from the mapped pages, so no parsing or copying of the node table is needed.
+ */
+template <typename Label>
+class CompiledForest
+{
+  //#################### ENUMERATIONS ####################
+private:
+  /**
+   * \brief The different types of node that can appear in the node table.
+   */
+  enum NodeType
+  {
+    /** A leaf node. */
+    NT_LEAF,
+
+    /** A branch node that tests an individual feature against a threshold. */
+    NT_FEATURE_THRESHOLD,
+
+    /** A branch node that tests the sum of two features against a threshold. */
+    NT_PAIRWISE_ADD,
+
+    /** A branch node that tests the difference of two features against a threshold. */
+    NT_PAIRWISE_SUBTRACT
+  };
+
+  /**
+   * \brief The sections of a binary model file (in the order in which they appear in the file).
+   */
+  enum ModelFileSection
+  {
+    MFS_TREE_ROOT_INDICES,
+    MFS_LABELS,
+    MFS_NODE_TYPES,
+    MFS_FIRST_FEATURE_INDICES,
+    MFS_SECOND_FEATURE_INDICES,
+    MFS_THRESHOLDS,
+    MFS_LEFT_CHILD_OR_LEAF_INDICES,
+    MFS_RIGHT_CHILD_INDICES,
+    MFS_LEAF_MASSES,
+    MFS_COUNT
+  };
+
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct represents the header of a binary model file.
+   */
+  struct ModelFileHeader
+  {
+    /** The magic string identifying the file as a compiled forest model file. */
+    char m_magic[8];
+
+    /** A tag written in the byte order of the machine that saved the file (used to detect files saved on machines with a different byte order). */
+    boost::uint32_t m_endianTag;
+
+    /** The version of the file format. */
+    boost::uint32_t m_version;
+
+    /** The number of trees in the forest. */
+    boost::uint32_t m_treeCount;
+
+    /** The total number of nodes in the node table. */
+    boost::uint32_t m_nodeCount;
+
+    /** The number of distinct labels that the forest can predict. */
+    boost::uint32_t m_labelCount;
+
+    /** The number of leaves in the forest (i.e. the number of rows in the leaf mass block). */
+    boost::uint32_t m_leafCount;
+
+    /** The CRC-32 checksum of everything in the file after the header. */
+    boost::uint32_t m_checksum;
+
+    /** Padding (reserved for future use) that makes the header exactly one cache line long. */
+    boost::uint32_t m_reserved[7];
+  };
+
+  //#################### TYPEDEFS ####################
+private:
+  typedef DecisionTree<Label> DT;
+  typedef boost::shared_ptr<const DT> DT_CPtr;
+
+  //#################### CONSTANTS ####################
+private:
+  /** The alignment (in bytes) of each section of a binary model file. */
+  static const size_t MODEL_FILE_ALIGNMENT = 64;
+
+  /** The value of the endian tag in a binary model file saved on a machine with the same byte order as this one. */
+  static const boost::uint32_t MODEL_FILE_ENDIAN_TAG = 0x01020304;
+
+  /** The current version of the binary model file format. */
+  static const boost::uint32_t MODEL_FILE_VERSION = 1;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The indices of the first features tested by the branch nodes (unused for leaves). */
+  const int *m_firstFeatureIndices;
+
+  /** The label corresponding to each column of the leaf mass block (in increasing order). */
+  std::vector<Label> m_labels;
+
+  /** The number of leaves in the forest. */
+  size_t m_leafCount;
+
+  /** The dense leaf mass block, containing one row of m_labels.size() masses for each leaf. */
+  const float *m_leafMasses;
+
+  /**
+   * For a branch node, the index of its left child in the node table. For a leaf node,
+   * the index of its row in the leaf mass block.
+   */
+  const int *m_leftChildOrLeafIndices;
+
+  /** The region of memory into which the model file was mapped (for a forest loaded from a model file). */
+  boost::shared_ptr<boost::interprocess::mapped_region> m_mappedRegion;
+
+  /** The total number of nodes in the node table. */
+  size_t m_nodeCount;
+
+  /** The types of the nodes in the node table. */
+  const unsigned char *m_nodeTypes;
+
+  /** The indices of the right children of the branch nodes in the node table (-1 for leaves). */
+  const int *m_rightChildIndices;
+
+  /** The indices of the second features tested by the pairwise branch nodes (unused for other nodes). */
+  const int *m_secondFeatureIndices;
+
+  /**
+   * The storage for the node table and leaf mass block (for a forest that was compiled in memory). For a forest that was loaded
+   * from a model file, the storage is empty, and the pointers to the node table and leaf mass block point into the mapped region.
+   */
+  std::vector<int> m_storedFirstFeatureIndices;
+  std::vector<float> m_storedLeafMasses;
+  std::vector<int> m_storedLeftChildOrLeafIndices;
+  std::vector<unsigned char> m_storedNodeTypes;
+  std::vector<int> m_storedRightChildIndices;
+  std::vector<int> m_storedSecondFeatureIndices;
+  std::vector<float> m_storedThresholds;
+  std::vector<int> m_storedTreeRootIndices;
+
+  /** The thresholds used by the branch nodes (unused for leaves). */
+  const float *m_thresholds;
+
+  /** The number of trees in the forest. */
+  size_t m_treeCount;
+
+  /** The indices of the roots of the individual trees in the node table. */
+  const int *m_treeRootIndices;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Compiles the specified random forest.
+   *
+   * \param forest              The random forest to compile.
+   * \throws std::runtime_error If the forest is not yet valid, or if it contains a decision function of a type that cannot be compiled.
+   */
+  explicit CompiledForest(const RandomForest<Label>& forest)
+  {
+    if(!forest.is_valid()) throw std::runtime_error("Cannot compile a random forest that has not yet been trained");
+
+    // Determine the set of labels that can be predicted by the forest, so that we can assign each one a column in the leaf mass block.
+    std::set<Label> labels;
+    for(size_t i = 0, treeCount = forest.get_tree_count(); i < treeCount; ++i)
+    {
+      DT_CPtr tree = forest.get_tree(i);
+      for(int nodeIndex = 0, nodeCount = static_cast<int>(tree->get_node_count()); nodeIndex < nodeCount; ++nodeIndex)
+      {
+        if(!tree->is_leaf(nodeIndex)) continue;
+        DenseProbabilityMassFunction<Label> pmf = tree->make_pmf(nodeIndex);
+        const std::map<Label,float> masses = pmf.get_masses();
+        for(typename std::map<Label,float>::const_iterator it = masses.begin(), iend = masses.end(); it != iend; ++it)
+        {
+          labels.insert(it->first);
+        }
+      }
+    }
+    m_labels.assign(labels.begin(), labels.end());
+
+    // Lower each tree into the node table in turn.
+    for(size_t i = 0, treeCount = forest.get_tree_count(); i < treeCount; ++i)
+    {
+      DT_CPtr tree = forest.get_tree(i);
+      m_storedTreeRootIndices.push_back(compile_subtree(*tree, tree->get_root_index()));
+    }
+
+    // Point the node table and leaf mass block at the storage.
+    m_leafCount = m_storedLeafMasses.size() / m_labels.size();
+    m_nodeCount = m_storedNodeTypes.size();
+    m_treeCount = m_storedTreeRootIndices.size();
+    m_firstFeatureIndices = &m_storedFirstFeatureIndices[0];
+    m_leafMasses = &m_storedLeafMasses[0];
+    m_leftChildOrLeafIndices = &m_storedLeftChildOrLeafIndices[0];
+    m_nodeTypes = &m_storedNodeTypes[0];
+    m_rightChildIndices = &m_storedRightChildIndices[0];
+    m_secondFeatureIndices = &m_storedSecondFeatureIndices[0];
+    m_thresholds = &m_storedThresholds[0];
+    m_treeRootIndices = &m_storedTreeRootIndices[0];
+  }
+
+private:
+  /**
+   * \brief Constructs an empty compiled forest (used when loading a forest from a model file).
+   */
+  CompiledForest()
+  : m_firstFeatureIndices(NULL), m_leafCount(0), m_leafMasses(NULL), m_leftChildOrLeafIndices(NULL), m_nodeCount(0), m_nodeTypes(NULL),
+    m_rightChildIndices(NULL), m_secondFeatureIndices(NULL), m_thresholds(NULL), m_treeCount(0), m_treeRootIndices(NULL)
+  {}
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  CompiledForest(const CompiledForest&);
+  CompiledForest& operator=(const CompiledForest&);
+
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Loads a compiled forest from a binary model file (see save_binary).
+   *
+   * The file is mapped into memory, and the forest's node table and leaf mass block point directly into the mapped
+   * pages, which remain mapped for as long as the forest exists.
+   *
+   * \param path                The path to the model file.
+   * \return                    The loaded forest.
+   * \throws std::runtime_error If the file cannot be mapped, or is not a valid model file (e.g. if its checksum does not match).
+   */
+  static boost::shared_ptr<const CompiledForest> load_binary(const std::string& path)
+  {
+    BOOST_STATIC_ASSERT(sizeof(ModelFileHeader) == MODEL_FILE_ALIGNMENT);
+
+    // Map the file into memory.
+    boost::shared_ptr<boost::interprocess::mapped_region> region;
+    try
+    {
+      boost::interprocess::file_mapping mapping(path.c_str(), boost::interprocess::read_only);
+      region.reset(new boost::interprocess::mapped_region(mapping, boost::interprocess::read_only));
+    }
+    catch(boost::interprocess::interprocess_exception&)
+    {
+      throw std::runtime_error("Could not map the forest model file: " + path);
+    }
+
+    const char *data = static_cast<const char*>(region->get_address());
+    const size_t size = region->get_size();
+
+    // Read and check the header.
+    ModelFileHeader header;
+    if(size < sizeof(ModelFileHeader)) throw std::runtime_error("The forest model file is truncated: " + path);
+    memcpy(&header, data, sizeof(ModelFileHeader));
+
+    if(memcmp(header.m_magic, get_model_file_magic(), sizeof(header.m_magic)) != 0)
+    {
+      throw std::runtime_error("Not a forest model file: " + path);
+    }
+
+    if(header.m_endianTag != MODEL_FILE_ENDIAN_TAG)
+    {
+      throw std::runtime_error("The forest model file was saved on a machine with a different byte order: " + path);
+    }
+
+    if(header.m_version != MODEL_FILE_VERSION)
+    {
+      throw std::runtime_error("Unsupported forest model file version: " + path);
+    }
+
+    // Check that the file has exactly the size implied by the header, and that its checksum matches.
+    std::vector<size_t> offsets;
+    if(size != calculate_model_file_layout(header, offsets)) throw std::runtime_error("The forest model file has the wrong size: " + path);
+
+    boost::crc_32_type crc;
+    crc.process_bytes(data + sizeof(ModelFileHeader), size - sizeof(ModelFileHeader));
+    if(crc.checksum() != header.m_checksum) throw std::runtime_error("The forest model file is corrupt (checksum mismatch): " + path);
+
+    // Point the forest at the sections of the mapped file. Note that the labels are copied, since they are stored as 32-bit integers.
+    boost::shared_ptr<CompiledForest> forest(new CompiledForest);
+    forest->m_mappedRegion = region;
+    forest->m_leafCount = header.m_leafCount;
+    forest->m_nodeCount = header.m_nodeCount;
+    forest->m_treeCount = header.m_treeCount;
+
+    const boost::int32_t *labels = reinterpret_cast<const boost::int32_t*>(data + offsets[MFS_LABELS]);
+    forest->m_labels.assign(labels, labels + header.m_labelCount);
+
+    forest->m_firstFeatureIndices = reinterpret_cast<const int*>(data + offsets[MFS_FIRST_FEATURE_INDICES]);
+    forest->m_leafMasses = reinterpret_cast<const float*>(data + offsets[MFS_LEAF_MASSES]);
+    forest->m_leftChildOrLeafIndices = reinterpret_cast<const int*>(data + offsets[MFS_LEFT_CHILD_OR_LEAF_INDICES]);
+    forest->m_nodeTypes = reinterpret_cast<const unsigned char*>(data + offsets[MFS_NODE_TYPES]);
+    forest->m_rightChildIndices = reinterpret_cast<const int*>(data + offsets[MFS_RIGHT_CHILD_INDICES]);
+    forest->m_secondFeatureIndices = reinterpret_cast<const int*>(data + offsets[MFS_SECOND_FEATURE_INDICES]);
+    forest->m_thresholds = reinterpret_cast<const float*>(data + offsets[MFS_THRESHOLDS]);
+    forest->m_treeRootIndices = reinterpret_cast<const int*>(data + offsets[MFS_TREE_ROOT_INDICES]);
+
+    return forest;
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Calculates an overall forest PMF for the specified descriptor.
+   *
+   * \param descriptor  The descriptor.
+   * \return            The PMF.
+   */
+  ProbabilityMassFunction<Label> calculate_pmf(const Descriptor_CPtr& descriptor) const
+  {
+    return calculate_pmf(DescriptorView(*descriptor));
+  }
+
+  /**
+   * \brief Calculates an overall forest PMF for the specified descriptor.
+   *
+   * \param descriptor  A view of the descriptor.
+   * \return            The PMF.
+   */
+  ProbabilityMassFunction<Label> calculate_pmf(const DescriptorView& descriptor) const
+  {
+    std::vector<float> masses(m_labels.size());
+    accumulate_masses(descriptor.data(), &masses[0]);
+
+    std::map<Label,float> massMap;
+    for(size_t k = 0, labelCount = m_labels.size(); k < labelCount; ++k)
+    {
+      if(masses[k] > 0.0f) massMap.insert(std::make_pair(m_labels[k], masses[k]));
+    }
+
+    return ProbabilityMassFunction<Label>(massMap);
+  }
+
+  /**
+   * \brief Gets the number of distinct labels that the forest can predict.
+   *
+   * \return  The number of distinct labels that the forest can predict.
+   */
+  size_t get_label_count() const
+  {
+    return m_labels.size();
+  }
+
+  /**
+   * \brief Gets the total number of nodes in the node table.
+   *
+   * \return  The total number of nodes in the node table.
+   */
+  size_t get_node_count() const
+  {
+    return m_nodeCount;
+  }
+
+  /**
+   * \brief Gets the number of trees in the forest.
+   *
+   * \return  The number of trees in the forest.
+   */
+  size_t get_tree_count() const
+  {
+    return m_treeCount;
+  }
+
+  /**
+   * \brief Predicts a label for the specified descriptor.
+   *
+   * \param descriptor  The descriptor.
+   * \return            The predicted label.
+   */
+  Label predict(const Descriptor_CPtr& descriptor) const
+  {
+    return predict(DescriptorView(*descriptor));
+  }
+
+  /**
+   * \brief Predicts a label for the specified descriptor.
+   *
+   * \param descriptor  A view of the descriptor.
+   * \return            The predicted label.
+   */
+  Label predict(const DescriptorView& descriptor) const
+  {
+    std::vector<float> masses(m_labels.size());
+    return predict(descriptor.data(), &masses[0]);
+  }
+
+  /**
+   * \brief Predicts a label for a descriptor that is stored as a raw array of features.
+   *
+   * This version avoids all memory allocation, and is intended for use in tight prediction loops.
+   *
+   * \param features  The features of the descriptor.
+   * \param masses    A scratch buffer with space for get_label_count() masses.
+   * \return          The predicted label.
+   */
+  Label predict(const float *features, float *masses) const
+  {
+    accumulate_masses(features, masses);
+
+    // Normalise the summed masses and pick the label with the highest mass. Note that the summation, normalisation
+    // and tie-breaking are all done in increasing label order so as to exactly match RandomForest::predict.
+    const size_t labelCount = m_labels.size();
+    float sum = 0.0f;
+    for(size_t k = 0; k < labelCount; ++k) sum += masses[k];
+
+    size_t bestIndex = 0;
+    float bestMass = masses[0] / sum;
+    for(size_t k = 1; k < labelCount; ++k)
+    {
+      float mass = masses[k] / sum;
+      if(mass > bestMass)
+      {
+        bestIndex = k;
+        bestMass = mass;
+      }
+    }
+
+    return m_labels[bestIndex];
+  }
+
+  /**
+   * \brief Saves the compiled forest to a binary model file.
+   *
+   * The file consists of a 64-byte header (see ModelFileHeader), followed by the sections of the forest (see ModelFileSection),
+   * each of which is stored as a raw array in the byte order of the machine saving the file, starting at a 64-byte boundary.
+   * The labels are stored as 32-bit integers. The header contains a magic string, an endian tag, a format version number,
+   * the sizes of the sections, and a CRC-32 checksum of the rest of the file, all of which are checked on loading.
+   *
+   * \param path                The path to the model file.
+   * \throws std::runtime_error If the file cannot be written.
+   */
+  void save_binary(const std::string& path) const
+  {
+    // Fill in the header.
+    ModelFileHeader header;
+    memset(&header, 0, sizeof(ModelFileHeader));
+    memcpy(header.m_magic, get_model_file_magic(), sizeof(header.m_magic));
+    header.m_endianTag = MODEL_FILE_ENDIAN_TAG;
+    header.m_version = MODEL_FILE_VERSION;
+    header.m_treeCount = static_cast<boost::uint32_t>(m_treeCount);
+    header.m_nodeCount = static_cast<boost::uint32_t>(m_nodeCount);
+    header.m_labelCount = static_cast<boost::uint32_t>(m_labels.size());
+    header.m_leafCount = static_cast<boost::uint32_t>(m_leafCount);
+
+    // Assemble the rest of the file in memory.
+    std::vector<size_t> offsets;
+    std::vector<char> buffer(calculate_model_file_layout(header, offsets), 0);
+
+    std::vector<boost::int32_t> labels(m_labels.begin(), m_labels.end());
+    const void *sections[MFS_COUNT];
+    sections[MFS_TREE_ROOT_INDICES] = m_treeRootIndices;
+    sections[MFS_LABELS] = labels.empty() ? NULL : &labels[0];
+    sections[MFS_NODE_TYPES] = m_nodeTypes;
+    sections[MFS_FIRST_FEATURE_INDICES] = m_firstFeatureIndices;
+    sections[MFS_SECOND_FEATURE_INDICES] = m_secondFeatureIndices;
+    sections[MFS_THRESHOLDS] = m_thresholds;
+    sections[MFS_LEFT_CHILD_OR_LEAF_INDICES] = m_leftChildOrLeafIndices;
+    sections[MFS_RIGHT_CHILD_INDICES] = m_rightChildIndices;
+    sections[MFS_LEAF_MASSES] = m_leafMasses;
+
+    for(int i = 0; i < MFS_COUNT; ++i)
+    {
+      const size_t sectionSize = calculate_section_size(header, static_cast<ModelFileSection>(i));
+      if(sectionSize > 0) memcpy(&buffer[offsets[i]], sections[i], sectionSize);
+    }
+
+    // Checksum everything after the header, then write the header into the start of the buffer.
+    boost::crc_32_type crc;
+    crc.process_bytes(&buffer[sizeof(ModelFileHeader)], buffer.size() - sizeof(ModelFileHeader));
+    header.m_checksum = crc.checksum();
+    memcpy(&buffer[0], &header, sizeof(ModelFileHeader));
+
+    // Write the buffer to the file.
+    std::ofstream fs(path.c_str(), std::ios::binary);
+    if(!fs.write(&buffer[0], buffer.size())) throw std::runtime_error("Could not write the forest model file: " + path);
+  }
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Calculates the layout of a binary model file with the specified header.
+   *
+   * \param header  The header of the model file.
+   * \param offsets A vector into which to write the offset of each section of the file, followed by the total size of the file.
+   * \return        The total size of the file (in bytes).
+   */
+  static size_t calculate_model_file_layout(const ModelFileHeader& header, std::vector<size_t>& offsets)
+  {
+    offsets.resize(MFS_COUNT + 1);
+
+    size_t offset = sizeof(ModelFileHeader);
+    for(int i = 0; i < MFS_COUNT; ++i)
+    {
+      offsets[i] = offset;
+      offset += calculate_section_size(header, static_cast<ModelFileSection>(i));
+      offset = (offset + MODEL_FILE_ALIGNMENT - 1) / MODEL_FILE_ALIGNMENT * MODEL_FILE_ALIGNMENT;
+    }
+
+    offsets[MFS_COUNT] = offset;
+    return offset;
+  }
+
+  /**
+   * \brief Calculates the size (in bytes, excluding padding) of the specified section of a binary model file with the specified header.
+   *
+   * \param header  The header of the model file.
+   * \param section The section.
+   * \return        The size of the section.
+   */
+  static size_t calculate_section_size(const ModelFileHeader& header, ModelFileSection section)
+  {
+    BOOST_STATIC_ASSERT(sizeof(int) == sizeof(boost::int32_t) && sizeof(float) == 4);
+
+    switch(section)
+    {
+      case MFS_TREE_ROOT_INDICES:
+        return header.m_treeCount * sizeof(boost::int32_t);
+      case MFS_LABELS:
+        return header.m_labelCount * sizeof(boost::int32_t);
+      case MFS_NODE_TYPES:
+        return header.m_nodeCount * sizeof(unsigned char);
+      case MFS_FIRST_FEATURE_INDICES:
+      case MFS_SECOND_FEATURE_INDICES:
+      case MFS_LEFT_CHILD_OR_LEAF_INDICES:
+      case MFS_RIGHT_CHILD_INDICES:
+        return header.m_nodeCount * sizeof(boost::int32_t);
+      case MFS_THRESHOLDS:
+        return header.m_nodeCount * sizeof(float);
+      case MFS_LEAF_MASSES:
+        return static_cast<size_t>(header.m_leafCount) * header.m_labelCount * sizeof(float);
+      default:
+        // This should never happen.
+        throw std::runtime_error("Unknown forest model file section");
+    }
+  }
+
+  /**
+   * \brief Gets the magic string with which a binary model file starts.
+   *
+   * \return  The magic string with which a binary model file starts (8 bytes long, including the terminating NUL).
+   */
+  static const char *get_model_file_magic()
+  {
+    return "RAFLCFM";
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Sums the masses of the leaves that the specified descriptor reaches in the various trees.
+   *
+   * \param features  The features of the descriptor.
+   * \param masses    A buffer with space for get_label_count() masses, into which to write the summed masses.
+   */
+  void accumulate_masses(const float *features, float *masses) const
+  {
+    const size_t labelCount = m_labels.size();
+    std::fill(masses, masses + labelCount, 0.0f);
+
+    for(size_t i = 0; i < m_treeCount; ++i)
+    {
+      const float *leafMasses = &m_leafMasses[find_leaf(features, m_treeRootIndices[i]) * labelCount];
+      for(size_t k = 0; k < labelCount; ++k) masses[k] += leafMasses[k];
+    }
+  }
+
+  /**
+   * \brief Lowers a subtree of a decision tree into the node table.
+   *
+   * \param tree              The decision tree.
+   * \param subtreeRootIndex  The index of the root of the subtree in the decision tree's node array.
+   * \return                  The index of the root of the lowered subtree in the node table.
+   */
+  int compile_subtree(const DT& tree, int subtreeRootIndex)
+  {
+    int index = static_cast<int>(m_storedNodeTypes.size());
+    m_storedNodeTypes.push_back(NT_LEAF);
+    m_storedFirstFeatureIndices.push_back(0);
+    m_storedSecondFeatureIndices.push_back(0);
+    m_storedThresholds.push_back(0.0f);
+    m_storedLeftChildOrLeafIndices.push_back(-1);
+    m_storedRightChildIndices.push_back(-1);
+
+    if(tree.is_leaf(subtreeRootIndex))
+    {
+      // Add a row for the leaf to the leaf mass block.
+      const size_t labelCount = m_labels.size();
+      m_storedLeftChildOrLeafIndices[index] = static_cast<int>(m_storedLeafMasses.size() / labelCount);
+      m_storedLeafMasses.resize(m_storedLeafMasses.size() + labelCount, 0.0f);
+
+      DenseProbabilityMassFunction<Label> pmf = tree.make_pmf(subtreeRootIndex);
+      const std::map<Label,float> masses = pmf.get_masses();
+      float *leafMasses = &m_storedLeafMasses[m_storedLeafMasses.size() - labelCount];
+      for(typename std::map<Label,float>::const_iterator it = masses.begin(), iend = masses.end(); it != iend; ++it)
+      {
+        leafMasses[std::lower_bound(m_labels.begin(), m_labels.end(), it->first) - m_labels.begin()] = it->second;
+      }
+    }
+    else
+    {
+      // Lower the node's decision function.
+      DecisionFunction_CPtr splitter = tree.get_splitter(subtreeRootIndex);
+      if(const FeatureThresholdingDecisionFunction *df = dynamic_cast<const FeatureThresholdingDecisionFunction*>(splitter.get()))
+      {
+        m_storedNodeTypes[index] = NT_FEATURE_THRESHOLD;
+        m_storedFirstFeatureIndices[index] = static_cast<int>(df->get_feature_index());
+        m_storedThresholds[index] = df->get_threshold();
+      }
+      else if(const PairwiseOpAndThresholdDecisionFunction *df = dynamic_cast<const PairwiseOpAndThresholdDecisionFunction*>(splitter.get()))
+      {
+        switch(df->get_op())
+        {
+          case PairwiseOpAndThresholdDecisionFunction::PO_ADD:
+            m_storedNodeTypes[index] = NT_PAIRWISE_ADD;
+            break;
+          case PairwiseOpAndThresholdDecisionFunction::PO_SUBTRACT:
+            m_storedNodeTypes[index] = NT_PAIRWISE_SUBTRACT;
+            break;
+          default:
+            // This should never happen.
+            throw std::runtime_error("Cannot compile a pairwise decision function with an unknown operation");
+        }
+
+        m_storedFirstFeatureIndices[index] = static_cast<int>(df->get_first_feature_index());
+        m_storedSecondFeatureIndices[index] = static_cast<int>(df->get_second_feature_index());
+        m_storedThresholds[index] = df->get_threshold();
+      }
+      else throw std::runtime_error("Cannot compile a decision function of an unknown type");
+
+      // Recursively lower the node's children.
+      int leftChildIndex = compile_subtree(tree, tree.get_left_child_index(subtreeRootIndex));
+      int rightChildIndex = compile_subtree(tree, tree.get_right_child_index(subtreeRootIndex));
+      m_storedLeftChildOrLeafIndices[index] = leftChildIndex;
+      m_storedRightChildIndices[index] = rightChildIndex;
+    }
+
+    return index;
+  }
+
+  /**
+   * \brief Finds the leaf that a descriptor reaches in the tree rooted at the specified node.
+   *
+   * \param features  The features of the descriptor.
+   * \param rootIndex The index of the tree's root in the node table.
+   * \return          The index of the leaf's row in the leaf mass block.
+   */
+  int find_leaf(const float *features, int rootIndex) const
+  {
+    int curIndex = rootIndex;
+    for(;;)
+    {
+      float value;
+      switch(m_nodeTypes[curIndex])
+      {
+        case NT_FEATURE_THRESHOLD:
+          value = features[m_firstFeatureIndices[curIndex]];
+          break;
+        case NT_PAIRWISE_ADD:
+          value = features[m_firstFeatureIndices[curIndex]] + features[m_secondFeatureIndices[curIndex]];
+          break;
+        case NT_PAIRWISE_SUBTRACT:
+          value = features[m_firstFeatureIndices[curIndex]] - features[m_secondFeatureIndices[curIndex]];
+          break;
+        default: // NT_LEAF
+          return m_leftChildOrLeafIndices[curIndex];
+      }
+
+      curIndex = value < m_thresholds[curIndex] ? m_leftChildOrLeafIndices[curIndex] : m_rightChildIndices[curIndex];
+    }
+  }
+};
+
+//#################### STATIC MEMBER DEFINITIONS ####################
+
+template <typename Label> const size_t CompiledForest<Label>::MODEL_FILE_ALIGNMENT;
+template <typename Label> const boost::uint32_t CompiledForest<Label>::MODEL_FILE_ENDIAN_TAG;
+template <typename Label> const boost::uint32_t CompiledForest<Label>::MODEL_FILE_VERSION;
+
+}
+
+#endif
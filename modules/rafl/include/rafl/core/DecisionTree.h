@@ -6,13 +6,15 @@
 #ifndef H_RAFL_DECISIONTREE
 #define H_RAFL_DECISIONTREE
 
+#include <algorithm>
 #include <set>
 #include <stdexcept>
 
-#include <tvgutil/PriorityQueue.h>
+#include <tvgutil/IndexedDaryHeap.h>
 #include <tvgutil/PropertyUtil.h>
 
 #include "../decisionfunctions/DecisionFunctionGeneratorFactory.h"
+#include "../decisionfunctions/FeatureImportanceTracker.h"
 
 namespace rafl {
 
@@ -262,7 +264,7 @@ public:
 private:
   typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
   typedef boost::shared_ptr<Node> Node_Ptr;
-  typedef tvgutil::PriorityQueue<int,float,signed char,std::greater<float> > SplittabilityQueue;
+  typedef tvgutil::IndexedDaryHeap<int,float,signed char,std::greater<float> > SplittabilityQueue;
 
   //#################### PRIVATE VARIABLES ####################
 private:
@@ -272,6 +274,9 @@ private:
   /** The indices of nodes to which examples have been added during the current call to add_examples() and whose splittability may need recalculating. */
   std::set<int> m_dirtyNodes;
 
+  /** The tracker used to accumulate statistics about the features used by the splits made in the tree. */
+  FeatureImportanceTracker_Ptr m_featureImportanceTracker;
+
   /** The inverses of the L1-normalised class frequencies observed in the training data. */
   boost::optional<std::map<Label,float> > m_inverseClassWeights;
 
@@ -301,7 +306,7 @@ public:
    * \param settings  The settings needed to configure the decision tree.
    */
   explicit DecisionTree(const Settings& settings)
-  : m_isValid(false), m_settings(settings), m_treeDepth(0)
+  : m_featureImportanceTracker(new FeatureImportanceTracker), m_isValid(false), m_settings(settings), m_treeDepth(0)
   {
     m_rootIndex = add_node(0);
 
@@ -380,6 +385,46 @@ public:
     return totalLeafEntropy / leafCount;
   }
 
+  /**
+   * \brief Finds the leaves reached by a contiguous range of the descriptors in an arena.
+   *
+   * Rather than walking each descriptor from the root to a leaf in turn, this walks all of the descriptors
+   * down the tree together, one level at a time, so that the nodes near the top of the tree (which every
+   * descriptor visits) are fetched once per level rather than once per descriptor.
+   *
+   * \param descriptors     The arena containing the descriptors.
+   * \param begin           The index of the first descriptor in the range.
+   * \param count           The number of descriptors in the range.
+   * \param leafIndices     An array with space for count indices, into which to write the indices of the leaves reached by the descriptors.
+   * \param activeIndices   A scratch buffer with space for count indices.
+   */
+  void find_leaves(const DescriptorArena& descriptors, size_t begin, size_t count, int *leafIndices, int *activeIndices) const
+  {
+    // Start every descriptor at the root.
+    const size_t featureCount = descriptors.get_feature_count();
+    size_t activeCount = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+      leafIndices[i] = m_rootIndex;
+      if(!is_leaf(m_rootIndex)) activeIndices[activeCount++] = static_cast<int>(i);
+    }
+
+    // Repeatedly move each descriptor that has not yet reached a leaf down one level, until they all have.
+    while(activeCount > 0)
+    {
+      size_t remainingCount = 0;
+      for(size_t j = 0; j < activeCount; ++j)
+      {
+        const int i = activeIndices[j];
+        const Node& n = *m_nodes[leafIndices[i]];
+        DescriptorView descriptor(descriptors.get_row(begin + i), featureCount);
+        leafIndices[i] = n.m_splitter->classify_descriptor(descriptor) == DecisionFunction::DC_LEFT ? n.m_leftChildIndex : n.m_rightChildIndex;
+        if(!is_leaf(leafIndices[i])) activeIndices[remainingCount++] = i;
+      }
+      activeCount = remainingCount;
+    }
+  }
+
   /**
    * \brief Gets a histogram holding the class frequencies observed in the training data.
    *
@@ -390,6 +435,17 @@ public:
     return m_classFrequencies;
   }
 
+  /**
+   * \brief Gets the index of the specified node's left child in the tree's node array.
+   *
+   * \param nodeIndex The index of the node.
+   * \return          The index of the node's left child, or -1 if the node is a leaf.
+   */
+  int get_left_child_index(int nodeIndex) const
+  {
+    return m_nodes[nodeIndex]->m_leftChildIndex;
+  }
+
   /**
    * \brief Gets the number of nodes in the tree.
    *
@@ -400,6 +456,48 @@ public:
     return m_nodes.size();
   }
 
+  /**
+   * \brief Gets the index of the specified node's right child in the tree's node array.
+   *
+   * \param nodeIndex The index of the node.
+   * \return          The index of the node's right child, or -1 if the node is a leaf.
+   */
+  int get_right_child_index(int nodeIndex) const
+  {
+    return m_nodes[nodeIndex]->m_rightChildIndex;
+  }
+
+  /**
+   * \brief Gets the index of the root node in the tree's node array.
+   *
+   * \return  The index of the root node in the tree's node array.
+   */
+  int get_root_index() const
+  {
+    return m_rootIndex;
+  }
+
+  /**
+   * \brief Gets the decision function used to split the specified node.
+   *
+   * \param nodeIndex The index of the node.
+   * \return          The node's decision function, or NULL if the node is a leaf.
+   */
+  DecisionFunction_CPtr get_splitter(int nodeIndex) const
+  {
+    return m_nodes[nodeIndex]->m_splitter;
+  }
+
+  /**
+   * \brief Gets the tracker used to accumulate statistics about the features used by the splits made in the tree.
+   *
+   * \return The feature importance tracker.
+   */
+  FeatureImportanceTracker_CPtr get_feature_importance_tracker() const
+  {
+    return m_featureImportanceTracker;
+  }
+
   /**
    * \brief Gets the depth of the tree.
    *
@@ -410,6 +508,17 @@ public:
     return m_treeDepth;
   }
 
+  /**
+   * \brief Returns whether or not the specified node is a leaf.
+   *
+   * \param nodeIndex  The index of the node.
+   * \return           true, if the specified node is a leaf, or false otherwise.
+   */
+  bool is_leaf(int nodeIndex) const
+  {
+    return m_nodes[nodeIndex]->m_leftChildIndex == -1;
+  }
+
   /**
    * \brief Gets whether or not the tree is valid.
    *
@@ -422,18 +531,40 @@ public:
     return m_isValid;
   }
 
- /**
+  /**
    * \brief Looks up the probability mass function for the leaf to which an example with the specified descriptor would be added.
    *
    * \param descriptor  The descriptor.
    * \return            The probability mass function for the leaf to which an example with that descriptor would be added.
    */
-  ProbabilityMassFunction<Label> lookup_pmf(const Descriptor_CPtr& descriptor) const
+  DenseProbabilityMassFunction<Label> lookup_pmf(const Descriptor_CPtr& descriptor) const
+  {
+    return lookup_pmf(DescriptorView(*descriptor));
+  }
+
+  /**
+   * \brief Looks up the probability mass function for the leaf to which an example with the specified descriptor would be added.
+   *
+   * \param descriptor  A view of the descriptor.
+   * \return            The probability mass function for the leaf to which an example with that descriptor would be added.
+   */
+  DenseProbabilityMassFunction<Label> lookup_pmf(const DescriptorView& descriptor) const
   {
-    int leafIndex = find_leaf(*descriptor);
+    int leafIndex = find_leaf(descriptor);
     return make_pmf(leafIndex);
   }
 
+  /**
+   * \brief Makes a probability mass function for the specified leaf.
+   *
+   * \param leafIndex The leaf for which to make the probability mass function.
+   * \return          The probability mass function.
+   */
+  DenseProbabilityMassFunction<Label> make_pmf(int leafIndex) const
+  {
+    return DenseProbabilityMassFunction<Label>(*m_nodes[leafIndex]->m_reservoir.get_histogram(), m_inverseClassWeights);
+  }
+
   /**
    * \brief Outputs the decision tree to a stream.
    *
@@ -455,6 +586,17 @@ public:
     return lookup_pmf(descriptor).calculate_best_label();
   }
 
+  /**
+   * \brief Predicts a label for the specified descriptor.
+   *
+   * \param descriptor  A view of the descriptor.
+   * \return            The predicted label.
+   */
+  Label predict(const DescriptorView& descriptor) const
+  {
+    return lookup_pmf(descriptor).calculate_best_label();
+  }
+
   /**
    * \brief Trains the tree by splitting a number of suitable nodes.
    *
@@ -503,7 +645,7 @@ private:
   void add_example(const Example_CPtr& example)
   {
     // Find the leaf to which to add the new example.
-    int leafIndex = find_leaf(*example->get_descriptor());
+    int leafIndex = find_leaf(example->get_descriptor_view());
 
     // Add the example to the leaf's reservoir.
     m_nodes[leafIndex]->m_reservoir.add_example(example);
@@ -534,44 +676,76 @@ private:
     return id;
   }
 
+  /**
+   * \brief Calculates the splittability of the specified node.
+   *
+   * \param nodeIndex  The index of the node.
+   * \return           The splittability of the node.
+   */
+  float calculate_splittability(int nodeIndex) const
+  {
+    const ExampleReservoir<Label>& reservoir = m_nodes[nodeIndex]->m_reservoir;
+    if(m_nodes[nodeIndex]->m_depth + 1 < m_settings.maxTreeHeight && reservoir.seen_examples() >= m_settings.seenExamplesThreshold)
+    {
+      return ExampleUtil::calculate_entropy(*reservoir.get_histogram(), m_inverseClassWeights);
+    }
+    else
+    {
+      return 0.0f;
+    }
+  }
+
   /**
    * \brief Fills the specified reservoir with examples sampled from an input set of examples.
    *
+   * The input examples will normally already be grouped by label (in ascending order of label), since they come from a reservoir
+   * (see ExampleReservoir::get_examples) and splitting them preserves their order. In that case, the groups are used directly.
+   * Otherwise, the examples are grouped by (stably) sorting a copy of them.
+   *
    * \param inputExamples The set of examples from which to sample.
    * \param multipliers   The per-class ratios between the total number of examples seen for a class and the number of examples currently in the source reservoir.
    * \param reservoir     The reservoir to fill.
    */
   void fill_reservoir(const std::vector<Example_CPtr>& inputExamples, const std::map<Label,float>& multipliers, ExampleReservoir<Label>& reservoir)
   {
-    // Group the input examples by label.
-    std::map<Label,std::vector<Example_CPtr> > inputExamplesByLabel;
-    for(typename std::vector<Example_CPtr>::const_iterator it = inputExamples.begin(), iend = inputExamples.end(); it != iend; ++it)
+    // Group the input examples by label (if they are not already grouped).
+    const std::vector<Example_CPtr> *examples = &inputExamples;
+    std::vector<Example_CPtr> sortedExamples;
+    if(!is_grouped_by_label(inputExamples))
     {
-      inputExamplesByLabel[(*it)->get_label()].push_back(*it);
+      sortedExamples = inputExamples;
+      std::stable_sort(sortedExamples.begin(), sortedExamples.end(), &has_smaller_label);
+      examples = &sortedExamples;
     }
 
     // For each group:
-    for(typename std::map<Label,std::vector<Example_CPtr> >::const_iterator it = inputExamplesByLabel.begin(), iend = inputExamplesByLabel.end(); it != iend; ++it)
+    for(size_t groupBegin = 0, size = examples->size(); groupBegin < size;)
     {
+      const Label& label = (*examples)[groupBegin]->get_label();
+      size_t groupEnd = groupBegin + 1;
+      while(groupEnd < size && (*examples)[groupEnd]->get_label() == label) ++groupEnd;
+
 #if 1
       // Sample the appropriate number of examples (based on the multiplier for the group) and add them to the target reservoir.
-      typename std::map<Label,float>::const_iterator jt = multipliers.find(it->first);
+      typename std::map<Label,float>::const_iterator jt = multipliers.find(label);
       if(jt == multipliers.end()) throw std::runtime_error("The input examples appear to be from a different reservoir than the multipliers");
 
       float multiplier = jt->second;
-      size_t sampleCount = static_cast<size_t>(it->second.size() * multiplier + 0.5f);
-      std::vector<Example_CPtr> sampledExamples = sample_examples(it->second, sampleCount);
+      size_t sampleCount = static_cast<size_t>((groupEnd - groupBegin) * multiplier + 0.5f);
+      std::vector<Example_CPtr> sampledExamples = sample_examples(examples->begin() + groupBegin, examples->begin() + groupEnd, sampleCount);
       for(size_t j = 0; j < sampleCount; ++j)
       {
         reservoir.add_example(sampledExamples[j]);
       }
 #else
       // Simply add all of the examples for the group to the target reservoir (useful for debugging purposes).
-      for(size_t j = 0, size = it->second.size(); j < size; ++j)
+      for(size_t j = groupBegin; j < groupEnd; ++j)
       {
-        reservoir.add_example(it->second[j]);
+        reservoir.add_example((*examples)[j]);
       }
 #endif
+
+      groupBegin = groupEnd;
     }
   }
 
@@ -581,7 +755,7 @@ private:
    * \param descriptor  The descriptor.
    * \return            The index of the leaf to which an example with the descriptor would currently be added.
    */
-  int find_leaf(const Descriptor& descriptor) const
+  int find_leaf(const DescriptorView& descriptor) const
   {
     int curIndex = m_rootIndex;
     while(!is_leaf(curIndex))
@@ -591,28 +765,6 @@ private:
     return curIndex;
   }
 
-  /**
-   * \brief Returns whether or not the specified node is a leaf.
-   *
-   * \param nodeIndex  The index of the node.
-   * \return           true, if the specified node is a leaf, or false otherwise.
-   */
-  bool is_leaf(int nodeIndex) const
-  {
-    return m_nodes[nodeIndex]->m_leftChildIndex == -1;
-  }
-
-  /**
-   * \brief Makes a probability mass function for the specified leaf.
-   *
-   * \param leafIndex The leaf for which to make the probability mass function.
-   * \return          The probability mass function.
-   */
-  ProbabilityMassFunction<Label> make_pmf(int leafIndex) const
-  {
-    return ProbabilityMassFunction<Label>(*m_nodes[leafIndex]->m_reservoir.get_histogram(), m_inverseClassWeights);
-  }
-
   /**
    * \brief Outputs a subtree of the decision tree to a stream.
    *
@@ -638,19 +790,21 @@ private:
   }
 
   /**
-   * \brief Randomly samples sampleCount examples (with replacement) from the specified set of input examples.
+   * \brief Randomly samples sampleCount examples (with replacement) from the specified range of input examples.
    *
-   * \param inputExamples The set of examples from which to sample.
-   * \param sampleCount   The number of samples to choose.
-   * \return              The chosen set of examples.
+   * \param inputBegin  An iterator pointing to the start of the range of examples from which to sample.
+   * \param inputEnd    An iterator pointing to the end of the range of examples from which to sample.
+   * \param sampleCount The number of samples to choose.
+   * \return            The chosen set of examples.
    */
-  std::vector<Example_CPtr> sample_examples(const std::vector<Example_CPtr>& inputExamples, size_t sampleCount)
+  std::vector<Example_CPtr> sample_examples(typename std::vector<Example_CPtr>::const_iterator inputBegin, typename std::vector<Example_CPtr>::const_iterator inputEnd, size_t sampleCount)
   {
     std::vector<Example_CPtr> outputExamples;
+    outputExamples.reserve(sampleCount);
     for(size_t i = 0; i < sampleCount; ++i)
     {
-      int exampleIndex = m_settings.randomNumberGenerator->generate_int_from_uniform(0, static_cast<int>(inputExamples.size()) - 1);
-      outputExamples.push_back(inputExamples[exampleIndex]);
+      int exampleIndex = m_settings.randomNumberGenerator->generate_int_from_uniform(0, static_cast<int>(inputEnd - inputBegin) - 1);
+      outputExamples.push_back(inputBegin[exampleIndex]);
     }
     return outputExamples;
   }
@@ -673,8 +827,9 @@ private:
     );
     if(!split) return false;
 
-    // Set the decision function of the node to be split.
+    // Set the decision function of the node to be split, and record the features it uses.
     n.m_splitter = split->m_decisionFunction;
+    m_featureImportanceTracker->record_split(n.m_splitter->get_feature_indices(), split->m_gain);
 
     // Add left and right child nodes and populate their example reservoirs based on the chosen split.
     size_t childDepth = n.m_depth + 1;
@@ -699,10 +854,14 @@ private:
    */
   void update_dirty_nodes()
   {
-    for(std::set<int>::const_iterator it = m_dirtyNodes.begin(), iend = m_dirtyNodes.end(); it != iend; ++it)
+    // Recalculate the splittabilities of the dirty nodes, and then update the splittability queue in a single bulk operation.
+    std::vector<int> nodeIndices(m_dirtyNodes.begin(), m_dirtyNodes.end());
+    std::vector<float> splittabilities(nodeIndices.size());
+    for(size_t i = 0, size = nodeIndices.size(); i < size; ++i)
     {
-      update_splittability(*it);
+      splittabilities[i] = calculate_splittability(nodeIndices[i]);
     }
+    m_splittabilityQueue.update_keys(nodeIndices, splittabilities);
 
     // Clear the list of dirty nodes once their splittability has been updated.
     m_dirtyNodes.clear();
@@ -715,20 +874,8 @@ private:
    */
   void update_splittability(int nodeIndex)
   {
-    // Recalculate the node's splittability.
-    const ExampleReservoir<Label>& reservoir = m_nodes[nodeIndex]->m_reservoir;
-    float splittability;
-    if(m_nodes[nodeIndex]->m_depth + 1 < m_settings.maxTreeHeight && reservoir.seen_examples() >= m_settings.seenExamplesThreshold)
-    {
-      splittability = ExampleUtil::calculate_entropy(*reservoir.get_histogram(), m_inverseClassWeights);
-    }
-    else
-    {
-      splittability = 0.0f;
-    }
-
-    // Update the splittability queue to reflect the node's new splittability.
-    m_splittabilityQueue.update_key(nodeIndex, splittability);
+    // Recalculate the node's splittability, and update the splittability queue to reflect it.
+    m_splittabilityQueue.update_key(nodeIndex, calculate_splittability(nodeIndex));
   }
 
   /**
@@ -747,6 +894,35 @@ private:
     }
   }
 
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Determines whether or not the first of two examples has a smaller label than the second.
+   *
+   * \param lhs The first example.
+   * \param rhs The second example.
+   * \return    true, if the first example has a smaller label than the second, or false otherwise.
+   */
+  static bool has_smaller_label(const Example_CPtr& lhs, const Example_CPtr& rhs)
+  {
+    return lhs->get_label() < rhs->get_label();
+  }
+
+  /**
+   * \brief Determines whether or not the specified examples are grouped by label, with the groups in ascending order of label.
+   *
+   * \param examples  The examples.
+   * \return          true, if the examples are grouped by label, or false otherwise.
+   */
+  static bool is_grouped_by_label(const std::vector<Example_CPtr>& examples)
+  {
+    for(size_t i = 1, size = examples.size(); i < size; ++i)
+    {
+      if(has_smaller_label(examples[i], examples[i - 1])) return false;
+    }
+    return true;
+  }
+
   //#################### SERIALIZATION ####################
 private:
   /**
@@ -760,6 +936,7 @@ private:
   {
     ar & m_classFrequencies;
     ar & m_dirtyNodes;
+    ar & m_featureImportanceTracker;
     ar & m_inverseClassWeights;
     ar & m_isValid;
     ar & m_nodes;
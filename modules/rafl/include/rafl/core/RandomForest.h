@@ -6,6 +6,12 @@
 #ifndef H_RAFL_RANDOMFOREST
 #define H_RAFL_RANDOMFOREST
 
+#include <climits>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
 #include "DecisionTree.h"
 
 namespace rafl {
@@ -23,6 +29,11 @@ private:
   typedef boost::shared_ptr<DT> DT_Ptr;
   typedef boost::shared_ptr<const DT> DT_CPtr;
 
+  //#################### CONSTANTS ####################
+private:
+  /** The number of descriptors in each of the tiles into which the descriptors are divided for batch prediction. */
+  static const size_t PREDICTION_TILE_SIZE = 256;
+
   //#################### PRIVATE VARIABLES ####################
 private:
   /** The settings needed to configure the decision trees. */
@@ -44,7 +55,7 @@ public:
   {
     for(size_t i = 0; i < treeCount; ++i)
     {
-      m_trees.push_back(DT_Ptr(new DT(settings)));
+      m_trees.push_back(make_tree());
     }
   }
 
@@ -65,10 +76,15 @@ public:
    */
   void add_examples(const std::vector<Example_CPtr>& examples)
   {
-    // Add the new examples to the different trees.
-    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
+    // Add the new examples to the different trees (in parallel, since the trees share no mutable state).
+    int treeCount = static_cast<int>(m_trees.size());
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < treeCount; ++i)
     {
-      (*it)->add_examples(examples);
+      m_trees[i]->add_examples(examples);
     }
   }
 
@@ -81,10 +97,21 @@ public:
    */
   void add_examples(const std::vector<Example_CPtr>& examples, const std::vector<size_t>& indices)
   {
-    // Add the new examples to the different trees.
-    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
+    // Validate the indices up-front, since exceptions cannot propagate out of a parallel region.
+    for(std::vector<size_t>::const_iterator it = indices.begin(), iend = indices.end(); it != iend; ++it)
     {
-      (*it)->add_examples(examples, indices);
+      if(*it >= examples.size()) throw std::out_of_range("Bad example index whilst trying to add examples to the forest");
+    }
+
+    // Add the new examples to the different trees (in parallel, since the trees share no mutable state).
+    int treeCount = static_cast<int>(m_trees.size());
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < treeCount; ++i)
+    {
+      m_trees[i]->add_examples(examples, indices);
     }
   }
 
@@ -98,20 +125,117 @@ public:
    */
   ProbabilityMassFunction<Label> calculate_pmf(const Descriptor_CPtr& descriptor) const
   {
-    // Sum the masses from the individual tree PMFs for the descriptor.
-    std::map<Label,float> masses;
+    return calculate_pmf(DescriptorView(*descriptor));
+  }
+
+  /**
+   * \brief Calculates an overall forest PMF for the specified descriptor.
+   *
+   * This is simply the average of the PMFs for the specified descriptor in the various decision trees.
+   *
+   * \param descriptor  A view of the descriptor.
+   * \return            The PMF.
+   */
+  ProbabilityMassFunction<Label> calculate_pmf(const DescriptorView& descriptor) const
+  {
+    // Sum the masses from the individual tree PMFs for the descriptor (in an array indexed by label ID, or in a map for any
+    // labels without compact IDs). Labels that are not in a tree's PMF have zero masses in its array, so adding them leaves
+    // the sums unchanged.
+    std::vector<float> masses;
+    std::map<Label,float> summedMasses;
     for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
     {
-      ProbabilityMassFunction<Label> individualPMF = (*it)->lookup_pmf(descriptor);
-      const std::map<Label,float>& individualMasses = individualPMF.get_masses();
-      for(typename std::map<Label,float>::const_iterator jt = individualMasses.begin(), jend = individualMasses.end(); jt != jend; ++jt)
+      DenseProbabilityMassFunction<Label> individualPMF = (*it)->lookup_pmf(descriptor);
+      const std::vector<float>& individualMasses = individualPMF.get_dense_masses();
+      if(individualMasses.size() > masses.size()) masses.resize(individualMasses.size(), 0.0f);
+      for(size_t id = 0, size = individualMasses.size(); id < size; ++id)
+      {
+        masses[id] += individualMasses[id];
+      }
+
+      const std::map<Label,float>& sparseMasses = individualPMF.get_sparse_masses();
+      for(typename std::map<Label,float>::const_iterator jt = sparseMasses.begin(), jend = sparseMasses.end(); jt != jend; ++jt)
+      {
+        summedMasses[jt->first] += jt->second;
+      }
+    }
+
+    // Create a normalised probability mass function from the summed masses of the labels that were in the tree PMFs
+    // (the masses in a tree PMF are never zero, so these are exactly the labels whose summed masses are non-zero).
+    for(size_t id = 0, size = masses.size(); id < size; ++id)
+    {
+      if(masses[id] > 0.0f) summedMasses.insert(std::make_pair(static_cast<Label>(id), masses[id]));
+    }
+    return ProbabilityMassFunction<Label>(summedMasses);
+  }
+
+  /**
+   * \brief Calculates overall forest PMFs for all of the descriptors in an arena.
+   *
+   * The PMFs calculated are exactly the same as those that would be calculated by calling calculate_pmf on each descriptor
+   * in turn, but the descriptors are processed in tiles (in parallel), walking each tile through each tree a level at a
+   * time and making the PMF for each leaf reached by the descriptors in the tile only once.
+   *
+   * \param descriptors The arena containing the descriptors.
+   * \return            The PMFs for the descriptors (in the same order as the descriptors themselves).
+   */
+  std::vector<ProbabilityMassFunction<Label> > calculate_pmfs_batch(const DescriptorArena& descriptors) const
+  {
+    const int tileCount = static_cast<int>((descriptors.get_descriptor_count() + PREDICTION_TILE_SIZE - 1) / PREDICTION_TILE_SIZE);
+    std::vector<std::vector<ProbabilityMassFunction<Label> > > tilePMFs(tileCount);
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for(int tile = 0; tile < tileCount; ++tile)
+    {
+      const size_t begin = tile * PREDICTION_TILE_SIZE;
+      const size_t count = std::min(PREDICTION_TILE_SIZE, descriptors.get_descriptor_count() - begin);
+
+      std::vector<Label> labels;
+      std::vector<float> masses;
+      std::vector<unsigned char> present;
+      calculate_tile_masses(descriptors, begin, count, labels, masses, present);
+
+      // Make a normalised PMF from the summed masses for each descriptor, using only the labels that were in the leaf PMFs for the descriptor.
+      const size_t labelCount = labels.size();
+      tilePMFs[tile].reserve(count);
+      for(size_t i = 0; i < count; ++i)
       {
-        masses[jt->first] += jt->second;
+        std::map<Label,float> descriptorMasses;
+        for(size_t k = 0; k < labelCount; ++k)
+        {
+          if(present[i * labelCount + k]) descriptorMasses.insert(descriptorMasses.end(), std::make_pair(labels[k], masses[i * labelCount + k]));
+        }
+        tilePMFs[tile].push_back(ProbabilityMassFunction<Label>(descriptorMasses));
       }
     }
 
-    // Create a normalised probability mass function from the summed masses.
-    return ProbabilityMassFunction<Label>(masses);
+    std::vector<ProbabilityMassFunction<Label> > pmfs;
+    pmfs.reserve(descriptors.get_descriptor_count());
+    for(int tile = 0; tile < tileCount; ++tile)
+    {
+      pmfs.insert(pmfs.end(), tilePMFs[tile].begin(), tilePMFs[tile].end());
+    }
+    return pmfs;
+  }
+
+  /**
+   * \brief Gets statistics about the features used by the splits made in the trees of the forest.
+   *
+   * The statistics are summed over the trackers of the individual trees, so they survive serialization and
+   * do not depend on whether or not the trees share a decision function generator.
+   *
+   * \return A new tracker containing the summed statistics.
+   */
+  FeatureImportanceTracker_Ptr get_feature_importance_tracker() const
+  {
+    FeatureImportanceTracker_Ptr tracker(new FeatureImportanceTracker);
+    for(size_t i = 0, size = m_trees.size(); i < size; ++i)
+    {
+      tracker->add(*m_trees[i]->get_feature_importance_tracker());
+    }
+    return tracker;
   }
 
   /**
@@ -135,6 +259,33 @@ public:
   {
     return m_trees.size();
   }
+
+  /**
+   * \brief Gets the (sorted) indices of the features on which the forest's predictions currently depend.
+   *
+   * These are the features used by the decision functions of the branch nodes in the trees. Unlike the statistics held by
+   * the feature importance tracker, they only reflect the current structure of the trees, and are available for forests
+   * that have been loaded from disk. The predictions of the forest do not depend on the values of any other features.
+   *
+   * \return The indices of the features on which the forest's predictions currently depend.
+   */
+  std::vector<size_t> get_used_feature_indices() const
+  {
+    std::set<size_t> usedFeatureIndices;
+    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
+    {
+      const DT& tree = **it;
+      for(int nodeIndex = 0, nodeCount = static_cast<int>(tree.get_node_count()); nodeIndex < nodeCount; ++nodeIndex)
+      {
+        DecisionFunction_CPtr splitter = tree.get_splitter(nodeIndex);
+        if(!splitter) continue;
+
+        std::vector<size_t> featureIndices = splitter->get_feature_indices();
+        usedFeatureIndices.insert(featureIndices.begin(), featureIndices.end());
+      }
+    }
+    return std::vector<size_t>(usedFeatureIndices.begin(), usedFeatureIndices.end());
+  }
   
   /**
    * \brief Gets whether or not the forest is valid.
@@ -198,6 +349,76 @@ public:
     return calculate_pmf(descriptor).calculate_best_label();
   }
 
+  /**
+   * \brief Predicts a label for the specified descriptor.
+   *
+   * \param descriptor  A view of the descriptor.
+   * \return            The predicted label.
+   */
+  Label predict(const DescriptorView& descriptor) const
+  {
+    return calculate_pmf(descriptor).calculate_best_label();
+  }
+
+  /**
+   * \brief Predicts labels for all of the descriptors in an arena.
+   *
+   * The labels predicted are exactly the same as those that would be predicted by calling predict on each descriptor
+   * in turn, but the descriptors are processed in tiles (see calculate_pmfs_batch), and no PMFs are constructed for
+   * the individual descriptors.
+   *
+   * \param descriptors The arena containing the descriptors.
+   * \param labels      An array with space for one label per descriptor, into which to write the predicted labels.
+   */
+  void predict_batch(const DescriptorArena& descriptors, Label *labels) const
+  {
+    const int tileCount = static_cast<int>((descriptors.get_descriptor_count() + PREDICTION_TILE_SIZE - 1) / PREDICTION_TILE_SIZE);
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for(int tile = 0; tile < tileCount; ++tile)
+    {
+      const size_t begin = tile * PREDICTION_TILE_SIZE;
+      const size_t count = std::min(PREDICTION_TILE_SIZE, descriptors.get_descriptor_count() - begin);
+
+      std::vector<Label> tileLabels;
+      std::vector<float> masses;
+      std::vector<unsigned char> present;
+      calculate_tile_masses(descriptors, begin, count, tileLabels, masses, present);
+
+      // Normalise the summed masses for each descriptor and pick the label with the highest mass. Note that the summation,
+      // normalisation and tie-breaking are all done in increasing label order so as to exactly match predict.
+      const size_t labelCount = tileLabels.size();
+      for(size_t i = 0; i < count; ++i)
+      {
+        const float *descriptorMasses = &masses[i * labelCount];
+        const unsigned char *descriptorPresent = &present[i * labelCount];
+
+        float sum = 0.0f;
+        for(size_t k = 0; k < labelCount; ++k)
+        {
+          if(descriptorPresent[k]) sum += descriptorMasses[k];
+        }
+
+        int bestIndex = -1;
+        float bestMass = 0.0f;
+        for(size_t k = 0; k < labelCount; ++k)
+        {
+          if(!descriptorPresent[k]) continue;
+          float mass = descriptorMasses[k] / sum;
+          if(bestIndex == -1 || mass > bestMass)
+          {
+            bestIndex = static_cast<int>(k);
+            bestMass = mass;
+          }
+        }
+
+        labels[begin + i] = tileLabels[bestIndex];
+      }
+    }
+  }
+
   /**
    * \brief Resets the specified tree.
    *
@@ -206,7 +427,7 @@ public:
    */
   void reset_tree(size_t treeIndex)
   {
-    if(treeIndex < m_trees.size()) m_trees[treeIndex].reset(new DT(m_settings));
+    if(treeIndex < m_trees.size()) m_trees[treeIndex] = make_tree();
     else throw std::runtime_error("Bad tree index whilst trying to reset tree");
   }
 
@@ -214,18 +435,142 @@ public:
    * \brief Trains the forest by splitting a number of suitable nodes in each tree.
    *
    * The number of nodes that are split in each training step is limited to ensure that a step is not overly costly.
+   * The trees are trained in parallel. Since each tree has its own random number generator, the result does not
+   * depend on the number of threads used.
    *
    * \param splitBudget The maximum number of nodes per tree that may be split in this training step.
    * \return            The total number of nodes that have been split across all the trees.
    */
   size_t train(size_t splitBudget)
   {
-    size_t nodesSplit = 0;
-    for(typename std::vector<DT_Ptr>::const_iterator it = m_trees.begin(), iend = m_trees.end(); it != iend; ++it)
+    int nodesSplit = 0;
+    int treeCount = static_cast<int>(m_trees.size());
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for reduction(+:nodesSplit)
+#endif
+    for(int i = 0; i < treeCount; ++i)
+    {
+      nodesSplit += static_cast<int>(m_trees[i]->train(splitBudget));
+    }
+
+    return static_cast<size_t>(nodesSplit);
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Sums the masses of the leaves that a tile of the descriptors in an arena reach in the various trees.
+   *
+   * \param descriptors The arena containing the descriptors.
+   * \param begin       The index of the first descriptor in the tile.
+   * \param count       The number of descriptors in the tile.
+   * \param labels      A vector into which to write the labels in the PMFs of the leaves reached by the descriptors (in increasing order).
+   * \param masses      A vector into which to write the summed masses for each descriptor (one row of labels.size() masses per descriptor).
+   * \param present     A vector into which to write flags indicating which labels were in the leaf PMFs for each descriptor (laid out as for masses).
+   */
+  void calculate_tile_masses(const DescriptorArena& descriptors, size_t begin, size_t count, std::vector<Label>& labels, std::vector<float>& masses, std::vector<unsigned char>& present) const
+  {
+    const size_t treeCount = m_trees.size();
+
+    // Find the leaves that the descriptors reach in each tree.
+    std::vector<int> leafIndices(treeCount * count), activeIndices(count);
+    for(size_t t = 0; t < treeCount; ++t)
+    {
+      m_trees[t]->find_leaves(descriptors, begin, count, &leafIndices[t * count], &activeIndices[0]);
+    }
+
+    // Make the PMF for each distinct leaf reached exactly once, and record which of these PMFs each descriptor uses in each tree.
+    std::vector<DenseProbabilityMassFunction<Label> > leafPMFs;
+    std::vector<size_t> leafPMFIndices(treeCount * count);
+    std::set<Label> labelSet;
+    for(size_t t = 0; t < treeCount; ++t)
     {
-      nodesSplit += (*it)->train(splitBudget);
+      std::map<int,size_t> pmfIndicesForLeaves;
+      for(size_t i = 0; i < count; ++i)
+      {
+        const int leafIndex = leafIndices[t * count + i];
+        std::map<int,size_t>::const_iterator it = pmfIndicesForLeaves.find(leafIndex);
+        if(it == pmfIndicesForLeaves.end())
+        {
+          it = pmfIndicesForLeaves.insert(std::make_pair(leafIndex, leafPMFs.size())).first;
+          leafPMFs.push_back(m_trees[t]->make_pmf(leafIndex));
+
+          const std::vector<float>& leafMasses = leafPMFs.back().get_dense_masses();
+          for(size_t id = 0, size = leafMasses.size(); id < size; ++id)
+          {
+            if(leafMasses[id] > 0.0f) labelSet.insert(static_cast<Label>(id));
+          }
+
+          const std::map<Label,float>& sparseMasses = leafPMFs.back().get_sparse_masses();
+          for(typename std::map<Label,float>::const_iterator jt = sparseMasses.begin(), jend = sparseMasses.end(); jt != jend; ++jt)
+          {
+            labelSet.insert(jt->first);
+          }
+        }
+        leafPMFIndices[t * count + i] = it->second;
+      }
+    }
+
+    // Store the leaf PMFs as dense rows of masses (one per label).
+    labels.assign(labelSet.begin(), labelSet.end());
+    const size_t labelCount = labels.size();
+    std::vector<float> leafMasses(leafPMFs.size() * labelCount, 0.0f);
+    std::vector<unsigned char> leafPresent(leafPMFs.size() * labelCount, 0);
+    for(size_t j = 0, size = leafPMFs.size(); j < size; ++j)
+    {
+      const std::vector<float>& pmfMasses = leafPMFs[j].get_dense_masses();
+      for(size_t id = 0, size = pmfMasses.size(); id < size; ++id)
+      {
+        if(pmfMasses[id] == 0.0f) continue;
+        const size_t k = std::lower_bound(labels.begin(), labels.end(), static_cast<Label>(id)) - labels.begin();
+        leafMasses[j * labelCount + k] = pmfMasses[id];
+        leafPresent[j * labelCount + k] = 1;
+      }
+
+      const std::map<Label,float>& sparseMasses = leafPMFs[j].get_sparse_masses();
+      for(typename std::map<Label,float>::const_iterator it = sparseMasses.begin(), iend = sparseMasses.end(); it != iend; ++it)
+      {
+        const size_t k = std::lower_bound(labels.begin(), labels.end(), it->first) - labels.begin();
+        leafMasses[j * labelCount + k] = it->second;
+        leafPresent[j * labelCount + k] = 1;
+      }
+    }
+
+    // Sum the leaf masses for each descriptor. Note that the masses are added in tree order (as in calculate_pmf), and that
+    // adding the zero masses of labels that are not in a leaf PMF leaves the sums unchanged, so the sums are bit-identical.
+    masses.assign(count * labelCount, 0.0f);
+    present.assign(count * labelCount, 0);
+    for(size_t i = 0; i < count; ++i)
+    {
+      float *descriptorMasses = &masses[i * labelCount];
+      unsigned char *descriptorPresent = &present[i * labelCount];
+      for(size_t t = 0; t < treeCount; ++t)
+      {
+        const size_t j = leafPMFIndices[t * count + i];
+        for(size_t k = 0; k < labelCount; ++k)
+        {
+          descriptorMasses[k] += leafMasses[j * labelCount + k];
+          descriptorPresent[k] |= leafPresent[j * labelCount + k];
+        }
+      }
     }
-    return nodesSplit;
+  }
+
+  /**
+   * \brief Makes a new decision tree for the forest.
+   *
+   * Each tree is given its own random number generator, seeded from the forest's generator. This allows the trees
+   * to be trained in parallel without contending for a shared generator, whilst keeping the results deterministic.
+   *
+   * \return The new decision tree.
+   */
+  DT_Ptr make_tree()
+  {
+    typename DT::Settings treeSettings = m_settings;
+    unsigned int treeSeed = static_cast<unsigned int>(m_settings.randomNumberGenerator->generate_int_from_uniform(0, INT_MAX));
+    treeSettings.randomNumberGenerator.reset(new tvgutil::RandomNumberGenerator(treeSeed));
+    return DT_Ptr(new DT(treeSettings));
   }
 
   //#################### SERIALIZATION ####################
@@ -246,6 +591,10 @@ private:
   friend class boost::serialization::access;
 };
 
+//#################### STATIC MEMBER DEFINITIONS ####################
+
+template <typename Label> const size_t RandomForest<Label>::PREDICTION_TILE_SIZE;
+
 }
 
 #endif
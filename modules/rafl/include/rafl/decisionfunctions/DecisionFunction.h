@@ -7,6 +7,7 @@
 #define H_RAFL_DECISIONFUNCTION
 
 #include <iosfwd>
+#include <vector>
 
 /*
 Note: It is CRUCIALLY IMPORTANT that the archive headers are included before the points at which we invoke BOOST_CLASS_EXPORT
@@ -21,7 +22,7 @@ header to avoid inadvertent mistakes.
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/serialization.hpp>
 
-#include "../base/Descriptor.h"
+#include "../base/DescriptorView.h"
 
 namespace rafl {
 
@@ -57,7 +58,14 @@ public:
    * \param descriptor  The descriptor to classify.
    * \return            DC_LEFT, if the descriptor should be sent down the left subtree of the node, or DC_RIGHT otherwise.
    */
-  virtual DescriptorClassification classify_descriptor(const Descriptor& descriptor) const = 0;
+  virtual DescriptorClassification classify_descriptor(const DescriptorView& descriptor) const = 0;
+
+  /**
+   * \brief Gets the indices of the features in a feature descriptor on which the decision function depends.
+   *
+   * \return The indices of the features in a feature descriptor on which the decision function depends.
+   */
+  virtual std::vector<size_t> get_feature_indices() const = 0;
 
   /**
    * \brief Outputs the decision function to the specified stream.
@@ -101,6 +109,7 @@ inline std::ostream& operator<<(std::ostream& os, const DecisionFunction& rhs)
 //#################### TYPEDEFS ####################
 
 typedef boost::shared_ptr<DecisionFunction> DecisionFunction_Ptr;
+typedef boost::shared_ptr<const DecisionFunction> DecisionFunction_CPtr;
 
 }
 
@@ -6,6 +6,8 @@
 #ifndef H_RAFL_DECISIONFUNCTIONGENERATOR
 #define H_RAFL_DECISIONFUNCTIONGENERATOR
 
+#include <algorithm>
+#include <climits>
 #include <utility>
 
 #ifdef WITH_OPENMP
@@ -15,6 +17,7 @@
 #include "../examples/ExampleReservoir.h"
 #include "../examples/ExampleUtil.h"
 #include "DecisionFunction.h"
+#include "HistogramSplitEvaluator.h"
 
 namespace rafl {
 
@@ -40,6 +43,9 @@ public:
     /** The decision function that induced the split. */
     DecisionFunction_Ptr m_decisionFunction;
 
+    /** The information gain achieved by the split. */
+    float m_gain;
+
     /** The examples that were sent left by the decision function. */
     std::vector<Example_CPtr> m_leftExamples;
 
@@ -52,11 +58,6 @@ public:
   typedef boost::shared_ptr<Split> Split_Ptr;
   typedef boost::shared_ptr<const Split> Split_CPtr;
 
-  //#################### PRIVATE VARIABLES ####################
-private:
-  /* The split candidates. */
-  mutable std::vector<Split> m_splitCandidates;
-
   //#################### DESTRUCTOR ####################
 public:
   /**
@@ -112,108 +113,100 @@ public:
 #endif
 
     // Generate the split candidates.
-    if(m_splitCandidates.size() != candidateCount) m_splitCandidates.resize(candidateCount);
-    for(int i = 0; i < candidateCount; ++i)
-    {
-      m_splitCandidates[i].m_decisionFunction = generate_candidate_decision_function(examples, randomNumberGenerator);
-    }
+    std::vector<DecisionFunction_Ptr> candidates = generate_candidates(examples, candidateCount, randomNumberGenerator);
 
-    // Pick the best split candidate and return it.
+    // Evaluate the information gain that would result from each split candidate.
+    std::map<Label,float> multipliers = reservoir.get_class_multipliers();
+    if(inverseClassWeights) multipliers = combine_multipliers(multipliers, *inverseClassWeights);
+    HistogramSplitEvaluator<Label> evaluator(examples, multipliers);
+    std::vector<typename HistogramSplitEvaluator<Label>::Evaluation> evaluations = evaluator.evaluate(candidates, initialEntropy);
+
+    // Pick the best split candidate (ties are broken in favour of the candidate with the lowest index).
     float bestGain = static_cast<float>(INT_MIN);
     int bestIndex = -1;
-
-#ifdef WITH_OPENMP
-    #pragma omp parallel for
-#endif
     for(int i = 0; i < candidateCount; ++i)
     {
-#if 0 && WITH_OPENMP
-      int threadID = omp_get_thread_num();
-      int threadCount = omp_get_num_threads();
-      std::cout << "threadID=" << threadID << " threadCount=" << threadCount << '\n';
-#endif
-
 #if 0
-      std::cout << *splitCandidate->m_decisionFunction << '\n';
+      std::cout << *candidates[i] << ": " << evaluations[i].m_gain << '\n';
 #endif
 
-      // Partition the examples using the split candidate's decision function.
-      m_splitCandidates[i].m_leftExamples.clear();
-      m_splitCandidates[i].m_rightExamples.clear();
-      for(size_t j = 0, size = examples.size(); j < size; ++j)
+      const typename HistogramSplitEvaluator<Label>::Evaluation& evaluation = evaluations[i];
+      if(evaluation.m_gain > bestGain && evaluation.m_gain > gainThreshold && evaluation.m_leftCount != 0 && evaluation.m_rightCount != 0)
       {
-        if(m_splitCandidates[i].m_decisionFunction->classify_descriptor(*examples[j]->get_descriptor()) == DecisionFunction::DC_LEFT)
-        {
-          m_splitCandidates[i].m_leftExamples.push_back(examples[j]);
-        }
-        else
-        {
-          m_splitCandidates[i].m_rightExamples.push_back(examples[j]);
-        }
+        bestGain = evaluation.m_gain;
+        bestIndex = i;
       }
+    }
 
-      // Calculate the information gain we would obtain from this split.
-      float gain = calculate_information_gain(reservoir, initialEntropy, m_splitCandidates[i].m_leftExamples, m_splitCandidates[i].m_rightExamples, inverseClassWeights);
+    // If no split candidate had a high enough gain, early out.
+    if(bestIndex == -1) return Split_CPtr();
 
-#ifdef WITH_OPENMP
-      #pragma omp critical
-#endif
+    // Otherwise, partition the examples using the best split candidate's decision function and return the resulting split.
+    Split_Ptr bestSplitCandidate(new Split);
+    bestSplitCandidate->m_decisionFunction = candidates[bestIndex];
+    bestSplitCandidate->m_gain = bestGain;
+    for(size_t j = 0, size = examples.size(); j < size; ++j)
+    {
+      if(bestSplitCandidate->m_decisionFunction->classify_descriptor(examples[j]->get_descriptor_view()) == DecisionFunction::DC_LEFT)
+      {
+        bestSplitCandidate->m_leftExamples.push_back(examples[j]);
+      }
+      else
       {
-        if(gain > bestGain)
-        {
-          if(gain > gainThreshold && !m_splitCandidates[i].m_leftExamples.empty() && !m_splitCandidates[i].m_rightExamples.empty())
-          {
-            bestGain = gain;
-            bestIndex = i;
-          }
-        }
+        bestSplitCandidate->m_rightExamples.push_back(examples[j]);
       }
     }
 
-    Split_Ptr bestSplitCandidate;
-    if(bestIndex != -1) bestSplitCandidate.reset(new Split(m_splitCandidates[bestIndex]));
-
-    // Return a split candidate that had maximum gain (note that this may be NULL if no split had a high enough gain).
     return bestSplitCandidate;
   }
 
-  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
   /**
-   * \brief Calculates the information gain that results from splitting an example reservoir in a particular way.
+   * \brief Generates the specified number of candidate decision functions to split the specified set of examples.
+   *
+   * The candidates are generated in parallel, in fixed-size batches. Each batch has its own random number generator, seeded
+   * (serially) from the specified one, so the threads do not contend for a single generator, and the candidates generated
+   * depend only on the state of the specified generator, not on the number of threads used.
    *
-   * \param reservoir           The reservoir.
-   * \param initialEntropy      The entropy of the example set before the split.
-   * \param leftExamples        The examples that end up in the left half of the split.
-   * \param rightExamples       The examples that end up in the right half of the split.
-   * \param inverseClassWeights The (optional) inverses of the L1-normalised class frequencies observed in the training data.
-   * \return                    The information gain resulting from the split.
+   * \param examples              The examples to split.
+   * \param candidateCount        The number of candidates to generate.
+   * \param randomNumberGenerator A random number generator.
+   * \return                      The candidate decision functions.
    */
-  static float calculate_information_gain(const ExampleReservoir<Label>& reservoir, float initialEntropy, const std::vector<Example_CPtr>& leftExamples, const std::vector<Example_CPtr>& rightExamples, const boost::optional<std::map<Label,float> >& inverseClassWeights)
+  std::vector<DecisionFunction_Ptr> generate_candidates(const std::vector<Example_CPtr>& examples, int candidateCount, const tvgutil::RandomNumberGenerator_Ptr& randomNumberGenerator) const
   {
-    float exampleCount = static_cast<float>(reservoir.current_size());
-    std::map<Label,float> multipliers = reservoir.get_class_multipliers();
-    if(inverseClassWeights) multipliers = combine_multipliers(multipliers, *inverseClassWeights);
-
-    float leftEntropy = ExampleUtil::calculate_entropy(leftExamples, multipliers);
-    float rightEntropy = ExampleUtil::calculate_entropy(rightExamples, multipliers);
-    float leftWeight = leftExamples.size() / exampleCount;
-    float rightWeight = rightExamples.size() / exampleCount;
+    const int batchSize = 8;
+    const int batchCount = (candidateCount + batchSize - 1) / batchSize;
 
-#if 0
-    std::cout << "L: " << ExampleUtil::make_histogram(leftExamples) << ' ' << leftEntropy << '\n';
-    std::cout << "R: " << ExampleUtil::make_histogram(rightExamples) << ' ' << rightEntropy << '\n';
-#endif
+    // Seed a random number generator for each batch.
+    std::vector<tvgutil::RandomNumberGenerator_Ptr> batchGenerators(batchCount);
+    for(int i = 0; i < batchCount; ++i)
+    {
+      unsigned int seed = static_cast<unsigned int>(randomNumberGenerator->generate_int_from_uniform(0, INT_MAX));
+      batchGenerators[i].reset(new tvgutil::RandomNumberGenerator(seed));
+    }
 
-    float gain = initialEntropy - (leftWeight * leftEntropy + rightWeight * rightEntropy);
+    // Generate the candidates in each batch using the batch's own generator.
+    // Note: Each batch writes only to its own range of candidates, so no synchronisation is needed.
+    std::vector<DecisionFunction_Ptr> candidates(candidateCount);
 
-#if 0
-    std::cout << "Gain: " << gain << '\n';
+#ifdef WITH_OPENMP
+    #pragma omp parallel for schedule(dynamic)
 #endif
+    for(int i = 0; i < batchCount; ++i)
+    {
+      for(int j = i * batchSize, end = std::min(j + batchSize, candidateCount); j < end; ++j)
+      {
+        candidates[j] = generate_candidate_decision_function(examples, batchGenerators[i]);
+      }
+    }
 
-    return gain;
+    return candidates;
   }
 
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
   /**
    * \brief Multiplies together two sets of multipliers that share some labels in common.
    *
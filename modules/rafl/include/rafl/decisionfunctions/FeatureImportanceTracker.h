@@ -0,0 +1,196 @@
+/**
+ * rafl: FeatureImportanceTracker.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_FEATUREIMPORTANCETRACKER
+#define H_RAFL_FEATUREIMPORTANCETRACKER
+
+#include <vector>
+
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace rafl {
+
+/**
+ * \brief An instance of this class accumulates the number of node splits in which each feature of a descriptor is used,
+ *        and the total information gain achieved by those splits.
+ *
+ * Each tree in a forest has its own tracker (which is serialized along with the tree), and the trackers of the individual
+ * trees can be added together to get the statistics for the whole forest. Access to a tracker is synchronised, so that
+ * a forest's statistics can safely be read whilst its trees are being trained in parallel. If a split uses several
+ * features, each of them is credited with the whole of its gain.
+ */
+class FeatureImportanceTracker
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The total information gain achieved by the splits in which each feature has been used. */
+  std::vector<double> m_gains;
+
+  /** The mutex used to synchronise access to the tracker. */
+  mutable boost::mutex m_mutex;
+
+  /** The number of splits in which each feature has been used. */
+  std::vector<size_t> m_splitCounts;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs an empty feature importance tracker.
+   */
+  FeatureImportanceTracker() {}
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  FeatureImportanceTracker(const FeatureImportanceTracker&);
+  FeatureImportanceTracker& operator=(const FeatureImportanceTracker&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Adds the statistics accumulated by another tracker to this one.
+   *
+   * \param rhs The other tracker.
+   */
+  void add(const FeatureImportanceTracker& rhs)
+  {
+    std::vector<double> rhsGains;
+    std::vector<size_t> rhsSplitCounts;
+    {
+      boost::lock_guard<boost::mutex> rhsLock(rhs.m_mutex);
+      rhsGains = rhs.m_gains;
+      rhsSplitCounts = rhs.m_splitCounts;
+    }
+
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    if(rhsSplitCounts.size() > m_splitCounts.size())
+    {
+      m_gains.resize(rhsSplitCounts.size(), 0.0);
+      m_splitCounts.resize(rhsSplitCounts.size(), 0);
+    }
+
+    for(size_t i = 0, size = rhsSplitCounts.size(); i < size; ++i)
+    {
+      m_gains[i] += rhsGains[i];
+      m_splitCounts[i] += rhsSplitCounts[i];
+    }
+  }
+
+  /**
+   * \brief Gets the number of features for which the tracker holds statistics.
+   *
+   * This is one more than the largest index of any feature that has been used in a split (or zero if there have been no splits).
+   *
+   * \return  The number of features for which the tracker holds statistics.
+   */
+  size_t get_feature_count() const
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    return m_splitCounts.size();
+  }
+
+  /**
+   * \brief Gets the total information gain achieved by the splits in which the specified feature has been used.
+   *
+   * \param featureIndex  The index of the feature.
+   * \return              The total information gain achieved by the splits in which the feature has been used.
+   */
+  double get_gain(size_t featureIndex) const
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    return featureIndex < m_gains.size() ? m_gains[featureIndex] : 0.0;
+  }
+
+  /**
+   * \brief Gets the number of splits in which the specified feature has been used.
+   *
+   * \param featureIndex  The index of the feature.
+   * \return              The number of splits in which the feature has been used.
+   */
+  size_t get_split_count(size_t featureIndex) const
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    return featureIndex < m_splitCounts.size() ? m_splitCounts[featureIndex] : 0;
+  }
+
+  /**
+   * \brief Gets the (sorted) indices of all the features that have been used in at least one split.
+   *
+   * \return  The indices of all the features that have been used in at least one split.
+   */
+  std::vector<size_t> get_used_feature_indices() const
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    std::vector<size_t> result;
+    for(size_t i = 0, size = m_splitCounts.size(); i < size; ++i)
+    {
+      if(m_splitCounts[i] != 0) result.push_back(i);
+    }
+    return result;
+  }
+
+  /**
+   * \brief Records a split that used the specified features.
+   *
+   * \param featureIndices  The indices of the features used by the split.
+   * \param gain            The information gain achieved by the split.
+   */
+  void record_split(const std::vector<size_t>& featureIndices, float gain)
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    for(size_t i = 0, size = featureIndices.size(); i < size; ++i)
+    {
+      size_t featureIndex = featureIndices[i];
+      if(featureIndex >= m_splitCounts.size())
+      {
+        m_gains.resize(featureIndex + 1, 0.0);
+        m_splitCounts.resize(featureIndex + 1, 0);
+      }
+
+      ++m_splitCounts[featureIndex];
+      m_gains[featureIndex] += gain;
+    }
+  }
+
+  /**
+   * \brief Discards all of the statistics accumulated so far.
+   */
+  void reset()
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_gains.clear();
+    m_splitCounts.clear();
+  }
+
+  //#################### SERIALIZATION ####################
+private:
+  /**
+   * \brief Serializes the tracker to/from an archive.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void serialize(Archive& ar, const unsigned int version)
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    ar & m_gains;
+    ar & m_splitCounts;
+  }
+
+  friend class boost::serialization::access;
+};
+
+//#################### TYPEDEFS ####################
+
+typedef boost::shared_ptr<FeatureImportanceTracker> FeatureImportanceTracker_Ptr;
+typedef boost::shared_ptr<const FeatureImportanceTracker> FeatureImportanceTracker_CPtr;
+
+}
+
+#endif
@@ -0,0 +1,448 @@
+/**
+ * rafl: HistogramSplitEvaluator.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_HISTOGRAMSPLITEVALUATOR
+#define H_RAFL_HISTOGRAMSPLITEVALUATOR
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include "../base/ProbabilityMassFunction.h"
+#include "../examples/Example.h"
+#include "FeatureThresholdingDecisionFunction.h"
+#include "PairwiseOpAndThresholdDecisionFunction.h"
+
+namespace rafl {
+
+/**
+ * \brief An instance of an instantiation of this class template can be used to calculate the information gains
+ *        that would result from splitting a set of examples using each of a number of candidate decision functions.
+ *
+ * Rather than partitioning the examples into explicit left and right sets for each candidate and building a
+ * histogram for each set, the evaluator maps the labels of the examples to dense indices once up-front and then
+ * accumulates left/right label counts directly. Candidates that threshold the same response (e.g. the same feature)
+ * share a single pass over the examples: the responses are computed and sorted once, and the label counts for all
+ * of the thresholds are then accumulated in one sweep.
+ *
+ * The gains calculated are bit-identical to those that would be obtained by partitioning the examples and calling
+ * ExampleUtil::calculate_entropy on each half, since the entropies are computed using exactly the same sequence of
+ * floating-point operations as ProbabilityMassFunction.
+ */
+template <typename Label>
+class HistogramSplitEvaluator
+{
+  //#################### TYPEDEFS ####################
+private:
+  typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+  /**
+   * A key identifying the response computed by a candidate decision function, namely (response type, first feature index, second feature index).
+   * Candidates with the same key differ only in their thresholds. Candidates whose type is not recognised each get a unique key of their own.
+   */
+  typedef std::pair<int,std::pair<size_t,size_t> > ResponseKey;
+
+  //#################### ENUMERATIONS ####################
+private:
+  /**
+   * \brief The values of this enumeration denote the different types of response that can be thresholded by a candidate.
+   */
+  enum ResponseType
+  {
+    RT_FEATURE,
+    RT_PAIRWISE_ADD,
+    RT_PAIRWISE_SUBTRACT,
+    RT_UNKNOWN
+  };
+
+  //#################### NESTED TYPES ####################
+public:
+  /**
+   * \brief An instance of this struct represents the result of evaluating a candidate decision function.
+   */
+  struct Evaluation
+  {
+    /** The information gain that would result from splitting the examples using the candidate. */
+    float m_gain;
+
+    /** The number of examples that the candidate would send left. */
+    size_t m_leftCount;
+
+    /** The number of examples that the candidate would send right. */
+    size_t m_rightCount;
+  };
+
+private:
+  /**
+   * \brief An instance of this struct represents a group of candidates that threshold the same response.
+   */
+  struct CandidateGroup
+  {
+    /** The indices of the candidates in the group. */
+    std::vector<int> m_candidateIndices;
+
+    /** The response type of the candidates in the group. */
+    ResponseType m_responseType;
+
+    /** The index of the first feature used to compute the response. */
+    size_t m_firstFeatureIndex;
+
+    /** The index of the second feature used to compute the response (if any). */
+    size_t m_secondFeatureIndex;
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** Views of the descriptors of the examples being split. */
+  std::vector<DescriptorView> m_descriptors;
+
+  /** The dense indices of the labels of the examples being split. */
+  std::vector<int> m_labelIndices;
+
+  /** The per-class multipliers, indexed by dense label index (labels without a multiplier get 1.0f, which leaves their masses unchanged). */
+  std::vector<float> m_multipliers;
+
+  /** The number of examples of each class in the set being split, indexed by dense label index. */
+  std::vector<size_t> m_totalCounts;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs an evaluator that can evaluate candidate splits of the specified set of examples.
+   *
+   * Note: The examples must remain alive for as long as the evaluator is in use.
+   *
+   * \param examples    The examples to be split.
+   * \param multipliers The per-class ratios to use to scale the probabilities for the different labels when calculating entropies.
+   */
+  HistogramSplitEvaluator(const std::vector<Example_CPtr>& examples, const std::map<Label,float>& multipliers)
+  {
+    // Assign dense indices to the labels, preserving their order so that entropies are summed in the same order as in a PMF.
+    std::map<Label,int> labelIndices;
+    for(typename std::vector<Example_CPtr>::const_iterator it = examples.begin(), iend = examples.end(); it != iend; ++it)
+    {
+      labelIndices.insert(std::make_pair((*it)->get_label(), 0));
+    }
+
+    int labelCount = 0;
+    m_multipliers.reserve(labelIndices.size());
+    for(typename std::map<Label,int>::iterator it = labelIndices.begin(), iend = labelIndices.end(); it != iend; ++it)
+    {
+      it->second = labelCount++;
+      typename std::map<Label,float>::const_iterator jt = multipliers.find(it->first);
+      m_multipliers.push_back(jt != multipliers.end() ? jt->second : 1.0f);
+    }
+
+    // Record the descriptor and dense label index of each example, and the overall label counts.
+    size_t exampleCount = examples.size();
+    m_descriptors.resize(exampleCount);
+    m_labelIndices.resize(exampleCount);
+    m_totalCounts.resize(labelCount, 0);
+    for(size_t i = 0; i < exampleCount; ++i)
+    {
+      m_descriptors[i] = examples[i]->get_descriptor_view();
+      m_labelIndices[i] = labelIndices[examples[i]->get_label()];
+      ++m_totalCounts[m_labelIndices[i]];
+    }
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Evaluates the specified candidate decision functions.
+   *
+   * \param candidates      The candidate decision functions.
+   * \param initialEntropy  The entropy of the example set before the split.
+   * \return                The evaluations of the candidates (in the same order as the candidates themselves).
+   */
+  std::vector<Evaluation> evaluate(const std::vector<DecisionFunction_Ptr>& candidates, float initialEntropy) const
+  {
+    std::vector<Evaluation> evaluations(candidates.size());
+    std::vector<CandidateGroup> groups = group_candidates(candidates);
+    int groupCount = static_cast<int>(groups.size());
+
+    // Note: Each group writes only to the evaluations of its own candidates, so no synchronisation is needed.
+#ifdef WITH_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i = 0; i < groupCount; ++i)
+    {
+      evaluate_group(groups[i], candidates, initialEntropy, evaluations);
+    }
+
+    return evaluations;
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Calculates the entropy of the label distribution represented by the specified (dense) label counts.
+   *
+   * This deliberately mirrors the calculations performed by the ProbabilityMassFunction constructor and
+   * ProbabilityMassFunction::calculate_entropy, so that the results are bit-identical.
+   *
+   * \param counts  The label counts.
+   * \param total   The sum of the label counts.
+   * \param masses  A scratch buffer (with one element per label) in which to store the masses.
+   * \return        The entropy of the label distribution.
+   */
+  float calculate_entropy(const std::vector<size_t>& counts, size_t total, std::vector<float>& masses) const
+  {
+    if(total == 0) return 0.0f;
+
+    // Calculate the scaled masses for the labels that are present, and their sum.
+    float sum = 0.0f;
+    for(size_t i = 0, size = counts.size(); i < size; ++i)
+    {
+      if(counts[i] == 0) continue;
+      masses[i] = static_cast<float>(counts[i]) / total;
+      masses[i] *= m_multipliers[i];
+      sum += masses[i];
+    }
+
+    if(fabs(sum) < SMALL_EPSILON) throw std::runtime_error("Cannot normalise the probability mass function: denominator too small");
+
+    // Normalise the masses and calculate the entropy.
+    float entropy = 0.0f;
+    for(size_t i = 0, size = counts.size(); i < size; ++i)
+    {
+      if(counts[i] == 0) continue;
+      float mass = masses[i] / sum;
+      if(mass > 0) entropy += mass * log2(mass);
+    }
+    return -entropy;
+  }
+
+  /**
+   * \brief Calculates the response of an example for the specified group of candidates.
+   *
+   * \param group         The group of candidates.
+   * \param candidate     A candidate in the group (used for candidates whose response type is unknown).
+   * \param exampleIndex  The index of the example.
+   * \return              The response of the example.
+   */
+  float calculate_response(const CandidateGroup& group, const DecisionFunction& candidate, size_t exampleIndex) const
+  {
+    const DescriptorView& descriptor = m_descriptors[exampleIndex];
+    switch(group.m_responseType)
+    {
+      case RT_FEATURE:
+        return descriptor[group.m_firstFeatureIndex];
+      case RT_PAIRWISE_ADD:
+        return descriptor[group.m_firstFeatureIndex] + descriptor[group.m_secondFeatureIndex];
+      case RT_PAIRWISE_SUBTRACT:
+        return descriptor[group.m_firstFeatureIndex] - descriptor[group.m_secondFeatureIndex];
+      default:
+        // For candidates of unknown type, the "response" is simply 0 for left and 1 for right, thresholded at 0.5.
+        return candidate.classify_descriptor(descriptor) == DecisionFunction::DC_LEFT ? 0.0f : 1.0f;
+    }
+  }
+
+  /**
+   * \brief Evaluates a candidate, given the label counts for the examples that it sends left.
+   *
+   * \param leftCounts      The label counts for the examples that the candidate sends left.
+   * \param leftTotal       The number of examples that the candidate sends left.
+   * \param initialEntropy  The entropy of the example set before the split.
+   * \param rightCounts     A scratch buffer in which to store the label counts for the examples that the candidate sends right.
+   * \param masses          A scratch buffer in which to store masses.
+   * \return                The evaluation of the candidate.
+   */
+  Evaluation evaluate_counts(const std::vector<size_t>& leftCounts, size_t leftTotal, float initialEntropy, std::vector<size_t>& rightCounts, std::vector<float>& masses) const
+  {
+    for(size_t i = 0, size = leftCounts.size(); i < size; ++i)
+    {
+      rightCounts[i] = m_totalCounts[i] - leftCounts[i];
+    }
+
+    Evaluation evaluation;
+    evaluation.m_leftCount = leftTotal;
+    evaluation.m_rightCount = m_descriptors.size() - leftTotal;
+
+    float exampleCount = static_cast<float>(m_descriptors.size());
+    float leftEntropy = calculate_entropy(leftCounts, evaluation.m_leftCount, masses);
+    float rightEntropy = calculate_entropy(rightCounts, evaluation.m_rightCount, masses);
+    float leftWeight = evaluation.m_leftCount / exampleCount;
+    float rightWeight = evaluation.m_rightCount / exampleCount;
+    evaluation.m_gain = initialEntropy - (leftWeight * leftEntropy + rightWeight * rightEntropy);
+
+    return evaluation;
+  }
+
+  /**
+   * \brief Evaluates a group of candidates that threshold the same response.
+   *
+   * \param group           The group of candidates.
+   * \param candidates      The complete set of candidates.
+   * \param initialEntropy  The entropy of the example set before the split.
+   * \param evaluations     The evaluations array into which to write the evaluations of the candidates in the group.
+   */
+  void evaluate_group(const CandidateGroup& group, const std::vector<DecisionFunction_Ptr>& candidates, float initialEntropy, std::vector<Evaluation>& evaluations) const
+  {
+    const size_t exampleCount = m_descriptors.size();
+    const size_t labelCount = m_totalCounts.size();
+    const std::vector<int>& candidateIndices = group.m_candidateIndices;
+    const size_t groupSize = candidateIndices.size();
+
+    // Compute the response of each example once for the whole group.
+    std::vector<float> responses(exampleCount);
+    for(size_t i = 0; i < exampleCount; ++i)
+    {
+      responses[i] = calculate_response(group, *candidates[candidateIndices[0]], i);
+    }
+
+    // Look up the threshold for each candidate in the group.
+    std::vector<std::pair<float,int> > thresholds(groupSize);
+    for(size_t k = 0; k < groupSize; ++k)
+    {
+      thresholds[k] = std::make_pair(get_threshold(group, *candidates[candidateIndices[k]]), candidateIndices[k]);
+    }
+
+    std::vector<size_t> leftCounts(labelCount), rightCounts(labelCount);
+    std::vector<float> masses(labelCount);
+
+    // If the group is small, it is cheaper to simply count the examples sent left by each candidate directly (which takes O(kn) time).
+    // Otherwise, we sort the examples by response and sweep through them, evaluating the thresholds in order (which takes O(n log n) time).
+    if(groupSize <= log2(static_cast<float>(exampleCount)))
+    {
+      for(size_t k = 0; k < groupSize; ++k)
+      {
+        std::fill(leftCounts.begin(), leftCounts.end(), 0);
+        size_t leftTotal = 0;
+
+        float threshold = thresholds[k].first;
+        for(size_t i = 0; i < exampleCount; ++i)
+        {
+          if(responses[i] < threshold)
+          {
+            ++leftCounts[m_labelIndices[i]];
+            ++leftTotal;
+          }
+        }
+
+        evaluations[thresholds[k].second] = evaluate_counts(leftCounts, leftTotal, initialEntropy, rightCounts, masses);
+      }
+    }
+    else
+    {
+      // Sort the examples by response. Examples whose responses are NaN are always sent right, so we exclude them from the sweep.
+      std::vector<std::pair<float,int> > sortedResponses;
+      sortedResponses.reserve(exampleCount);
+      for(size_t i = 0; i < exampleCount; ++i)
+      {
+        if(responses[i] == responses[i]) sortedResponses.push_back(std::make_pair(responses[i], m_labelIndices[i]));
+      }
+      std::sort(sortedResponses.begin(), sortedResponses.end());
+
+      // Likewise sort the thresholds, moving any NaN thresholds (which send everything right) to the front.
+      std::vector<std::pair<float,int> > nanThresholds, sortedThresholds;
+      for(size_t k = 0; k < groupSize; ++k)
+      {
+        if(thresholds[k].first == thresholds[k].first) sortedThresholds.push_back(thresholds[k]);
+        else nanThresholds.push_back(thresholds[k]);
+      }
+      std::sort(sortedThresholds.begin(), sortedThresholds.end());
+
+      for(size_t k = 0, size = nanThresholds.size(); k < size; ++k)
+      {
+        evaluations[nanThresholds[k].second] = evaluate_counts(leftCounts, 0, initialEntropy, rightCounts, masses);
+      }
+
+      // Sweep through the examples, accumulating the label counts of the examples whose responses are below each successive threshold.
+      size_t leftTotal = 0;
+      for(size_t k = 0, size = sortedThresholds.size(); k < size; ++k)
+      {
+        float threshold = sortedThresholds[k].first;
+        while(leftTotal < sortedResponses.size() && sortedResponses[leftTotal].first < threshold)
+        {
+          ++leftCounts[sortedResponses[leftTotal].second];
+          ++leftTotal;
+        }
+
+        evaluations[sortedThresholds[k].second] = evaluate_counts(leftCounts, leftTotal, initialEntropy, rightCounts, masses);
+      }
+    }
+  }
+
+  /**
+   * \brief Gets the threshold used by a candidate in the specified group.
+   *
+   * \param group     The group.
+   * \param candidate The candidate.
+   * \return          The threshold used by the candidate.
+   */
+  float get_threshold(const CandidateGroup& group, const DecisionFunction& candidate) const
+  {
+    switch(group.m_responseType)
+    {
+      case RT_FEATURE:
+        return static_cast<const FeatureThresholdingDecisionFunction&>(candidate).get_threshold();
+      case RT_PAIRWISE_ADD:
+      case RT_PAIRWISE_SUBTRACT:
+        return static_cast<const PairwiseOpAndThresholdDecisionFunction&>(candidate).get_threshold();
+      default:
+        return 0.5f;
+    }
+  }
+
+  /**
+   * \brief Groups the specified candidates according to the responses that they threshold.
+   *
+   * \param candidates  The candidates.
+   * \return            The groups of candidates.
+   */
+  std::vector<CandidateGroup> group_candidates(const std::vector<DecisionFunction_Ptr>& candidates) const
+  {
+    std::map<ResponseKey,size_t> groupIndices;
+    std::vector<CandidateGroup> groups;
+
+    for(int i = 0, size = static_cast<int>(candidates.size()); i < size; ++i)
+    {
+      CandidateGroup group;
+      group.m_firstFeatureIndex = group.m_secondFeatureIndex = 0;
+
+      if(const FeatureThresholdingDecisionFunction *ft = dynamic_cast<const FeatureThresholdingDecisionFunction*>(candidates[i].get()))
+      {
+        group.m_responseType = RT_FEATURE;
+        group.m_firstFeatureIndex = ft->get_feature_index();
+      }
+      else if(const PairwiseOpAndThresholdDecisionFunction *pw = dynamic_cast<const PairwiseOpAndThresholdDecisionFunction*>(candidates[i].get()))
+      {
+        group.m_responseType = pw->get_op() == PairwiseOpAndThresholdDecisionFunction::PO_ADD ? RT_PAIRWISE_ADD : RT_PAIRWISE_SUBTRACT;
+        group.m_firstFeatureIndex = pw->get_first_feature_index();
+        group.m_secondFeatureIndex = pw->get_second_feature_index();
+      }
+      else
+      {
+        // Candidates of unknown type cannot share a response, so we give each of them a group of its own.
+        group.m_responseType = RT_UNKNOWN;
+        group.m_firstFeatureIndex = static_cast<size_t>(i);
+      }
+
+      ResponseKey key(group.m_responseType, std::make_pair(group.m_firstFeatureIndex, group.m_secondFeatureIndex));
+      std::map<ResponseKey,size_t>::const_iterator it = groupIndices.find(key);
+      if(it == groupIndices.end())
+      {
+        groupIndices.insert(std::make_pair(key, groups.size()));
+        groups.push_back(group);
+        groups.back().m_candidateIndices.push_back(i);
+      }
+      else groups[it->second].m_candidateIndices.push_back(i);
+    }
+
+    return groups;
+  }
+};
+
+}
+
+#endif
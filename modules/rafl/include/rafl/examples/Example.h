@@ -9,23 +9,35 @@
 #include <ostream>
 
 #include <boost/serialization/serialization.hpp>
+#include <boost/serialization/split_member.hpp>
 
 #include <tvgutil/LimitedContainer.h>
 
-#include "../base/Descriptor.h"
+#include "../base/DescriptorArena.h"
 
 namespace rafl {
 
 /**
  * \brief An instance of an instantiation of this class template represents a training example for a random forest.
+ *
+ * The feature descriptor for an example can either be stored individually or as a row of a shared descriptor arena.
  */
 template <typename Label>
 class Example
 {
   //#################### PRIVATE VARIABLES ####################
 private:
-  /** The feature descriptor for the example. */
-  Descriptor_CPtr m_descriptor;
+  /** The arena containing the feature descriptor for the example (if it is stored in an arena). */
+  boost::shared_ptr<const DescriptorArena> m_arena;
+
+  /**
+   * The feature descriptor for the example (if it is stored individually). This is also filled in for an arena-based
+   * example when it is saved, since arena-based examples are serialized in exactly the same way as other examples.
+   */
+  mutable Descriptor_CPtr m_descriptor;
+
+  /** A view of the feature descriptor for the example. */
+  DescriptorView m_descriptorView;
 
   /** The label for the example. */
   Label m_label;
@@ -39,7 +51,20 @@ public:
    * \param label       The label for the example.
    */
   Example(const Descriptor_CPtr& descriptor, const Label& label)
-  : m_descriptor(descriptor), m_label(label)
+  : m_descriptor(descriptor), m_descriptorView(*descriptor), m_label(label)
+  {}
+
+  /**
+   * \brief Constructs an example whose feature descriptor is stored as a row of an arena.
+   *
+   * The example shares ownership of the arena, so the arena will be kept alive for as long as the example is.
+   *
+   * \param arena The arena containing the feature descriptor for the example.
+   * \param row   The row of the arena that contains the feature descriptor.
+   * \param label The label for the example.
+   */
+  Example(const boost::shared_ptr<const DescriptorArena>& arena, size_t row, const Label& label)
+  : m_arena(arena), m_descriptorView(arena->get_view(row)), m_label(label)
   {}
 
 private:
@@ -55,11 +80,25 @@ public:
   /**
    * \brief Gets the feature descriptor for the example.
    *
+   * Note: If the descriptor is stored in an arena, this makes a standalone copy of it. Code that only
+   *       needs to read the descriptor should use get_descriptor_view(), which never copies.
+   *
    * \return  The feature descriptor for the example.
    */
-  const Descriptor_CPtr& get_descriptor() const
+  Descriptor_CPtr get_descriptor() const
   {
-    return m_descriptor;
+    if(m_descriptor) return m_descriptor;
+    else return Descriptor_CPtr(new Descriptor(m_descriptorView.begin(), m_descriptorView.end()));
+  }
+
+  /**
+   * \brief Gets a view of the feature descriptor for the example.
+   *
+   * \return  A view of the feature descriptor for the example.
+   */
+  const DescriptorView& get_descriptor_view() const
+  {
+    return m_descriptorView;
   }
 
   /**
@@ -75,18 +114,38 @@ public:
   //#################### SERIALIZATION ####################
 private:
   /**
-   * \brief Serializes the example to/from an archive.
+   * \brief Loads the example from an archive.
    *
    * \param ar      The archive.
    * \param version The file format version number.
    */
   template <typename Archive>
-  void serialize(Archive& ar, const unsigned int version)
+  void load(Archive& ar, const unsigned int version)
   {
     ar & m_descriptor;
     ar & m_label;
+    m_descriptorView = DescriptorView(*m_descriptor);
   }
 
+  /**
+   * \brief Saves the example to an archive.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void save(Archive& ar, const unsigned int version) const
+  {
+    // Save an arena-based example as a standalone descriptor. Note that the copy is cached in the example rather than being a
+    // temporary, since the archive tracks shared pointers by address and the address of a temporary might subsequently be reused.
+    if(!m_descriptor) m_descriptor = get_descriptor();
+
+    ar & m_descriptor;
+    ar & m_label;
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
   friend class boost::serialization::access;
 };
 
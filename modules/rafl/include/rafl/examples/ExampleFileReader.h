@@ -0,0 +1,322 @@
+/**
+ * rafl: ExampleFileReader.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_RAFL_EXAMPLEFILEREADER
+#define H_RAFL_EXAMPLEFILEREADER
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include "../base/DescriptorArena.h"
+#include "Example.h"
+
+namespace rafl {
+
+/**
+ * \brief An instance of an instantiation of this class template can be used to stream examples from a file of comma-separated values.
+ *
+ * Each non-blank line of the file contains the features of an example, followed by its label. The values may be separated by commas,
+ * spaces or tabs, and lines may end with either "\n" or "\r\n". Every line must contain the same number of features.
+ *
+ * The file is read in large blocks, and the values are parsed in place within each block, so no per-line or per-value strings are
+ * constructed. The examples can be read in chunks of a bounded size (the examples in each chunk share a descriptor arena), which
+ * makes it possible to process files that are too large to be loaded into memory in their entirety.
+ */
+template <typename Label>
+class ExampleFileReader
+{
+  //#################### TYPEDEFS ####################
+private:
+  typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+  //#################### CONSTANTS ####################
+public:
+  /** The default size (in bytes) of the blocks in which the file is read. */
+  static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The buffer into which blocks of the file are read (this always contains a NUL after the valid data, to stop the parsing functions). */
+  std::vector<char> m_buffer;
+
+  /** The offset of the end of the valid data in the buffer. */
+  size_t m_bufferEnd;
+
+  /** The offset in the buffer of the start of the next line to be parsed. */
+  size_t m_bufferPos;
+
+  /** The number of features in each example (0 until the first example has been read). */
+  size_t m_featureCount;
+
+  /** The name of the file. */
+  std::string m_filename;
+
+  /** The file stream. */
+  std::ifstream m_fs;
+
+  /** The number of the line most recently read from the file (used for error messages). */
+  size_t m_lineNumber;
+
+  /** A scratch buffer for the features of the examples in a chunk (reused across chunks to avoid reallocating it). */
+  std::vector<float> m_scratchFeatures;
+
+  /** A scratch buffer for the labels of the examples in a chunk (reused across chunks to avoid reallocating it). */
+  std::vector<Label> m_scratchLabels;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a reader that will stream examples from the specified file.
+   *
+   * \param filename              The name of the file.
+   * \param blockSize             The size (in bytes) of the blocks in which to read the file (the buffer will grow if a line is longer than this).
+   * \throws std::runtime_error   If the file cannot be opened.
+   */
+  explicit ExampleFileReader(const std::string& filename, size_t blockSize = DEFAULT_BLOCK_SIZE)
+  : m_buffer(std::max<size_t>(blockSize, 1) + 1), m_bufferEnd(0), m_bufferPos(0), m_featureCount(0), m_filename(filename),
+    m_fs(filename.c_str(), std::ios::binary), m_lineNumber(0)
+  {
+    if(!m_fs) throw std::runtime_error("Error: '" + filename + "' could not be opened");
+    m_buffer[0] = '\0';
+  }
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  ExampleFileReader(const ExampleFileReader&);
+  ExampleFileReader& operator=(const ExampleFileReader&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the number of features in each example.
+   *
+   * \return  The number of features in each example (0 if no examples have been read yet).
+   */
+  size_t get_feature_count() const
+  {
+    return m_featureCount;
+  }
+
+  /**
+   * \brief Reads the next chunk of examples from the file.
+   *
+   * The descriptors of the examples in the chunk are stored in a single descriptor arena that is shared by the examples.
+   *
+   * \param maxExampleCount     The maximum number of examples to read.
+   * \return                    The examples that were read (an empty chunk indicates that the end of the file has been reached).
+   * \throws std::runtime_error If the file contains a line that cannot be parsed.
+   */
+  std::vector<Example_CPtr> read_chunk(size_t maxExampleCount)
+  {
+    m_scratchFeatures.clear();
+    m_scratchLabels.clear();
+    size_t exampleCount = read_rows(maxExampleCount, m_scratchFeatures, m_scratchLabels);
+    return make_examples(m_scratchFeatures, m_scratchLabels, exampleCount, m_featureCount);
+  }
+
+  /**
+   * \brief Reads up to the specified number of rows from the file, appending their features and labels to the specified arrays.
+   *
+   * \param maxRowCount         The maximum number of rows to read.
+   * \param features            The array to which to append the features of the rows (get_feature_count() per row).
+   * \param labels              The array to which to append the labels of the rows.
+   * \return                    The number of rows that were read (fewer than maxRowCount only if the end of the file has been reached).
+   * \throws std::runtime_error If the file contains a line that cannot be parsed.
+   */
+  size_t read_rows(size_t maxRowCount, std::vector<float>& features, std::vector<Label>& labels)
+  {
+    size_t rowCount = 0;
+    const char *lineBegin, *lineEnd;
+    while(rowCount < maxRowCount && next_line(lineBegin, lineEnd))
+    {
+      if(parse_line(lineBegin, lineEnd, features, labels)) ++rowCount;
+    }
+    return rowCount;
+  }
+
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Makes a set of examples whose descriptors are stored in a single descriptor arena.
+   *
+   * \param features      The features of the examples (featureCount per example).
+   * \param labels        The labels of the examples.
+   * \param exampleCount  The number of examples.
+   * \param featureCount  The number of features in each example.
+   * \return              The examples.
+   */
+  static std::vector<Example_CPtr> make_examples(const std::vector<float>& features, const std::vector<Label>& labels, size_t exampleCount, size_t featureCount)
+  {
+    std::vector<Example_CPtr> examples;
+    if(exampleCount == 0) return examples;
+
+    boost::shared_ptr<DescriptorArena> arena(new DescriptorArena(exampleCount, featureCount));
+    for(size_t i = 0; i < exampleCount; ++i)
+    {
+      std::copy(&features[i * featureCount], &features[i * featureCount] + featureCount, arena->get_row(i));
+    }
+
+    examples.reserve(exampleCount);
+    for(size_t i = 0; i < exampleCount; ++i)
+    {
+      examples.push_back(Example_CPtr(new Example<Label>(arena, i, labels[i])));
+    }
+
+    return examples;
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Throws an exception indicating that the current line of the file could not be parsed.
+   *
+   * \param reason              The reason why the line could not be parsed.
+   * \throws std::runtime_error Always.
+   */
+  void fail(const std::string& reason) const
+  {
+    throw std::runtime_error("Error: Line " + boost::lexical_cast<std::string>(m_lineNumber) + " of '" + m_filename + "' " + reason);
+  }
+
+  /**
+   * \brief Finds the next line of the file, reading more of the file into the buffer if necessary.
+   *
+   * \param lineBegin A pointer to the first character of the line.
+   * \param lineEnd   A pointer to one past the last character of the line (which will be either a newline or the NUL after the valid data).
+   * \return          true, if a line was found, or false if the end of the file has been reached.
+   */
+  bool next_line(const char *& lineBegin, const char *& lineEnd)
+  {
+    for(;;)
+    {
+      // If there's a complete line in the buffer, return it.
+      const char *newline = static_cast<const char*>(memchr(&m_buffer[m_bufferPos], '\n', m_bufferEnd - m_bufferPos));
+      if(newline)
+      {
+        lineBegin = &m_buffer[m_bufferPos];
+        lineEnd = newline;
+        m_bufferPos = newline + 1 - &m_buffer[0];
+        ++m_lineNumber;
+        return true;
+      }
+
+      // Otherwise, move any partial line to the start of the buffer, growing the buffer if the partial line fills it.
+      const size_t partialSize = m_bufferEnd - m_bufferPos;
+      if(partialSize > 0) memmove(&m_buffer[0], &m_buffer[m_bufferPos], partialSize);
+      m_bufferPos = 0;
+      m_bufferEnd = partialSize;
+      if(m_bufferEnd + 1 == m_buffer.size()) m_buffer.resize(2 * m_buffer.size() - 1);
+
+      // Then read more of the file into the buffer. If the end of the file has been reached, return any final unterminated line.
+      m_fs.read(&m_buffer[m_bufferEnd], m_buffer.size() - 1 - m_bufferEnd);
+      const size_t bytesRead = static_cast<size_t>(m_fs.gcount());
+      m_bufferEnd += bytesRead;
+      m_buffer[m_bufferEnd] = '\0';
+
+      if(bytesRead == 0)
+      {
+        if(m_bufferEnd == 0) return false;
+
+        lineBegin = &m_buffer[0];
+        lineEnd = &m_buffer[m_bufferEnd];
+        m_bufferPos = m_bufferEnd;
+        ++m_lineNumber;
+        return true;
+      }
+    }
+  }
+
+  /**
+   * \brief Parses a line of the file, appending its features and label to the specified arrays.
+   *
+   * \param lineBegin           A pointer to the first character of the line.
+   * \param lineEnd             A pointer to one past the last character of the line.
+   * \param features            The array to which to append the features.
+   * \param labels              The array to which to append the label.
+   * \return                    true, if the line contained an example, or false if it was blank.
+   * \throws std::runtime_error If the line cannot be parsed.
+   */
+  bool parse_line(const char *lineBegin, const char *lineEnd, std::vector<float>& features, std::vector<Label>& labels)
+  {
+    // Find the label, which is the last value on the line.
+    const char *labelEnd = lineEnd;
+    while(labelEnd != lineBegin && is_delimiter(labelEnd[-1])) --labelEnd;
+    if(labelEnd == lineBegin) return false;
+
+    const char *labelBegin = labelEnd;
+    while(labelBegin != lineBegin && !is_delimiter(labelBegin[-1])) --labelBegin;
+
+    // Parse the features, which are all of the other values on the line.
+    const size_t oldSize = features.size();
+    const char *p = lineBegin;
+    for(;;)
+    {
+      while(p != labelBegin && is_delimiter(*p)) ++p;
+      if(p == labelBegin) break;
+
+      char *valueEnd;
+      float value = strtof(p, &valueEnd);
+      if(valueEnd == p || (valueEnd != labelBegin && !is_delimiter(*valueEnd)))
+      {
+        features.resize(oldSize);
+        fail("contains a value that is not a valid feature");
+      }
+
+      features.push_back(value);
+      p = valueEnd;
+    }
+
+    // Check that the line has the same number of features as all of the previous lines.
+    const size_t featureCount = features.size() - oldSize;
+    if(m_featureCount == 0) m_featureCount = featureCount;
+    if(featureCount != m_featureCount || featureCount == 0)
+    {
+      features.resize(oldSize);
+      fail("has " + boost::lexical_cast<std::string>(featureCount) + " features, but " + boost::lexical_cast<std::string>(m_featureCount) + " were expected");
+    }
+
+    // Parse the label.
+    try
+    {
+      labels.push_back(boost::lexical_cast<Label>(labelBegin, labelEnd - labelBegin));
+    }
+    catch(boost::bad_lexical_cast&)
+    {
+      features.resize(oldSize);
+      fail("contains an invalid label");
+    }
+
+    return true;
+  }
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Determines whether or not the specified character separates the values on a line.
+   *
+   * \param c The character.
+   * \return  true, if the character is a delimiter, or false otherwise.
+   */
+  static bool is_delimiter(char c)
+  {
+    return c == ',' || c == ' ' || c == '\t' || c == '\r';
+  }
+};
+
+//#################### STATIC MEMBER DEFINITIONS ####################
+
+template <typename Label> const size_t ExampleFileReader<Label>::DEFAULT_BLOCK_SIZE;
+
+}
+
+#endif
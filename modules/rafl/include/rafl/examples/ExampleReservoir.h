@@ -13,15 +13,24 @@
 #include <map>
 #include <vector>
 
+#include <boost/serialization/split_member.hpp>
+
 #include <tvgutil/RandomNumberGenerator.h>
 
-#include "../base/Histogram.h"
+#include "../base/DenseHistogram.h"
 #include "Example.h"
 
 namespace rafl {
 
 /**
  * \brief An instance of an instantiation of this class template represents a reservoir to store the examples for a node.
+ *
+ * The reservoir is stored as a structure of arrays over the classes it has seen: a sorted array of class labels, and parallel arrays
+ * of per-class seen counts and per-class example arrays. Finding the class of a new example is thus a binary search over a (small)
+ * contiguous array, and deciding whether or not to keep the example needs no further lookups. The examples for each class are
+ * kept in the order in which they were added (with replaced examples taking the places of the ones they replace), and the classes
+ * are kept in ascending order of label, so get_examples returns the examples grouped by label. The histogram of the labels seen is
+ * a DenseHistogram.
  */
 template <typename Label>
 class ExampleReservoir
@@ -29,17 +38,23 @@ class ExampleReservoir
   //#################### TYPEDEFS ####################
 private:
   typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
-  typedef boost::shared_ptr<Histogram<Label> > Histogram_Ptr;
-  typedef boost::shared_ptr<const Histogram<Label> > Histogram_CPtr;
+  typedef boost::shared_ptr<DenseHistogram<Label> > Histogram_Ptr;
+  typedef boost::shared_ptr<const DenseHistogram<Label> > Histogram_CPtr;
 
   //#################### PRIVATE VARIABLES ####################
 private:
+  /** The examples currently in the reservoir for each class (parallel to m_classLabels). */
+  std::vector<std::vector<Example_CPtr> > m_classExamples;
+
+  /** The labels of the classes for which examples have been added to the reservoir (in ascending order). */
+  std::vector<Label> m_classLabels;
+
+  /** The total number of examples of each class that have been added to the reservoir over time (parallel to m_classLabels). */
+  std::vector<size_t> m_classSeenCounts;
+
   /** The total number of examples currently in the reservoir. */
   size_t m_curSize;
 
-  /** The examples in the reservoir. */
-  std::map<Label,std::vector<Example_CPtr> > m_examples;
-
   /** The histogram of the label distribution of all of the examples that have ever been added to the reservoir. */
   Histogram_Ptr m_histogram;
 
@@ -64,7 +79,7 @@ public:
    * \param randomNumberGenerator A random number generator.
    */
   ExampleReservoir(size_t maxClassSize, const tvgutil::RandomNumberGenerator_Ptr& randomNumberGenerator)
-  : m_curSize(0), m_histogram(new Histogram<Label>), m_maxClassSize(maxClassSize), m_randomNumberGenerator(randomNumberGenerator), m_seenExamples(0)
+  : m_curSize(0), m_histogram(new DenseHistogram<Label>), m_maxClassSize(maxClassSize), m_randomNumberGenerator(randomNumberGenerator), m_seenExamples(0)
   {}
 
   /**
@@ -90,10 +105,19 @@ public:
   {
     bool changed = false;
 
-    std::vector<Example_CPtr>& examplesForClass = m_examples[example->get_label()];
+    const size_t classIndex = find_or_add_class(example->get_label());
+    std::vector<Example_CPtr>& examplesForClass = m_classExamples[classIndex];
+    size_t& seenCount = m_classSeenCounts[classIndex];
+    ++seenCount;
+
     if(examplesForClass.size() < m_maxClassSize)
     {
-      // If we haven't yet reached the maximum number of examples for this class, simply add the new one.
+      // If we haven't yet reached the maximum number of examples for this class, simply add the new one. Note that we grow the
+      // array for the class ourselves, so that its capacity never exceeds the maximum class size.
+      if(examplesForClass.size() == examplesForClass.capacity())
+      {
+        examplesForClass.reserve(std::min(std::max<size_t>(2 * examplesForClass.capacity(), 4), m_maxClassSize));
+      }
       examplesForClass.push_back(example);
       ++m_curSize;
       changed = true;
@@ -101,8 +125,9 @@ public:
     else
     {
       // Otherwise, randomly decide whether or not to replace one of the existing examples for this class with the new one.
-      size_t binSize = m_histogram->get_bins().find(example->get_label())->second;
-      size_t k = m_randomNumberGenerator->generate_int_from_uniform(0, static_cast<int>(binSize) - 1);
+      // Note that the seen count here includes the new example: this ensures that each of the examples of the class that
+      // have been seen so far is equally likely to be in the reservoir.
+      size_t k = m_randomNumberGenerator->generate_int_from_uniform(0, static_cast<int>(seenCount) - 1);
       if(k < examplesForClass.size())
       {
         examplesForClass[k] = example;
@@ -120,7 +145,10 @@ public:
    */
   void clear()
   {
-    m_examples.clear();
+    // Note: We swap with empty arrays rather than just clearing them, since we want to free the memory they use.
+    std::vector<std::vector<Example_CPtr> >().swap(m_classExamples);
+    std::vector<Label>().swap(m_classLabels);
+    std::vector<size_t>().swap(m_classSeenCounts);
     m_histogram.reset();
     m_randomNumberGenerator.reset();
   }
@@ -143,31 +171,27 @@ public:
   std::map<Label,float> get_class_multipliers() const
   {
     std::map<Label,float> result;
-
-    const std::map<Label,size_t>& bins = m_histogram->get_bins();
-    typename std::map<Label,std::vector<Example_CPtr> >::const_iterator it = m_examples.begin(), iend = m_examples.end();
-    typename std::map<Label,size_t>::const_iterator jt = bins.begin();
-    for(; it != iend; ++it, ++jt)
+    for(size_t i = 0, size = m_classLabels.size(); i < size; ++i)
     {
-      assert(it->first == jt->first);
-      result.insert(std::make_pair(it->first, static_cast<float>(jt->second) / it->second.size()));
+      result.insert(result.end(), std::make_pair(m_classLabels[i], static_cast<float>(m_classSeenCounts[i]) / m_classExamples[i].size()));
     }
-
     return result;
   }
 
   /**
    * \brief Gets the examples currently in the reservoir.
    *
+   * The examples are grouped by label, with the groups in ascending order of label.
+   *
    * \return  The examples currently in the reservoir.
    */
   std::vector<Example_CPtr> get_examples() const
   {
     std::vector<Example_CPtr> examples;
     examples.reserve(m_curSize);
-    for(typename std::map<Label,std::vector<Example_CPtr> >::const_iterator it = m_examples.begin(), iend = m_examples.end(); it != iend; ++it)
+    for(size_t i = 0, size = m_classExamples.size(); i < size; ++i)
     {
-      std::copy(it->second.begin(), it->second.end(), std::back_inserter(examples));
+      std::copy(m_classExamples[i].begin(), m_classExamples[i].end(), std::back_inserter(examples));
     }
     return examples;
   }
@@ -192,8 +216,29 @@ public:
     return m_seenExamples;
   }
 
-  //#################### STREAM OPERATORS ####################
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Finds the index of the class with the specified label, adding the class to the reservoir if it is not yet present.
+   *
+   * \param label The label of the class.
+   * \return      The index of the class.
+   */
+  size_t find_or_add_class(const Label& label)
+  {
+    typename std::vector<Label>::iterator it = std::lower_bound(m_classLabels.begin(), m_classLabels.end(), label);
+    const size_t classIndex = std::distance(m_classLabels.begin(), it);
+    if(it == m_classLabels.end() || *it != label)
+    {
+      m_classLabels.insert(it, label);
+      m_classSeenCounts.insert(m_classSeenCounts.begin() + classIndex, 0);
+      m_classExamples.insert(m_classExamples.begin() + classIndex, std::vector<Example_CPtr>());
+    }
+    return classIndex;
+  }
 
+  //#################### STREAM OPERATORS ####################
+public:
   /**
    * \brief Outputs a reservoir to a stream.
    *
@@ -203,33 +248,78 @@ public:
    */
   friend std::ostream& operator<<(std::ostream& os, const ExampleReservoir& rhs)
   {
-    for(typename std::vector<Example_CPtr>::const_iterator it = rhs.m_examples.begin(), iend = rhs.m_examples.end(); it != iend; ++it)
+    for(size_t i = 0, size = rhs.m_classExamples.size(); i < size; ++i)
     {
-      os << (*it)->get_label() << ' ';
+      for(size_t j = 0, classSize = rhs.m_classExamples[i].size(); j < classSize; ++j)
+      {
+        os << rhs.m_classLabels[i] << ' ';
+      }
     }
 
     return os;
   }
 
-  //#################### SERIALIZATION #################### 
+  //#################### SERIALIZATION ####################
 private:
   /**
-   * \brief Serializes the example reservoir to/from an archive.
+   * \brief Loads the example reservoir from an archive.
    *
    * \param ar      The archive.
    * \param version The file format version number.
    */
   template <typename Archive>
-  void serialize(Archive& ar, const unsigned int version)
+  void load(Archive& ar, const unsigned int version)
   {
+    std::map<Label,std::vector<Example_CPtr> > examples;
     ar & m_curSize;
-    ar & m_examples;
+    ar & examples;
     ar & m_histogram;
     ar & m_maxClassSize;
     ar & m_randomNumberGenerator;
     ar & m_seenExamples;
+
+    // Rebuild the class arrays. (Note that the reservoir of a node that has been split has been cleared, and so has no histogram.)
+    m_classExamples.clear();
+    m_classLabels.clear();
+    m_classSeenCounts.clear();
+    for(typename std::map<Label,std::vector<Example_CPtr> >::iterator it = examples.begin(), iend = examples.end(); it != iend; ++it)
+    {
+      const size_t seenCount = m_histogram->get_bin(it->first);
+
+      m_classLabels.push_back(it->first);
+      m_classSeenCounts.push_back(seenCount != 0 ? seenCount : it->second.size());
+      m_classExamples.push_back(std::vector<Example_CPtr>());
+      m_classExamples.back().swap(it->second);
+    }
   }
 
+  /**
+   * \brief Saves the example reservoir to an archive.
+   *
+   * The reservoir is saved in the same format as was used when its examples were stored in a label -> examples map.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void save(Archive& ar, const unsigned int version) const
+  {
+    std::map<Label,std::vector<Example_CPtr> > examples;
+    for(size_t i = 0, size = m_classLabels.size(); i < size; ++i)
+    {
+      examples.insert(examples.end(), std::make_pair(m_classLabels[i], m_classExamples[i]));
+    }
+
+    ar & m_curSize;
+    ar & examples;
+    ar & m_histogram;
+    ar & m_maxClassSize;
+    ar & m_randomNumberGenerator;
+    ar & m_seenExamples;
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
   friend class boost::serialization::access;
 };
 
@@ -6,15 +6,10 @@
 #ifndef H_RAFL_EXAMPLEUTIL
 #define H_RAFL_EXAMPLEUTIL
 
-#include <fstream>
-
-#include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
 
-#include <tvgutil/WordExtractor.h>
-
-#include "../base/ProbabilityMassFunction.h"
-#include "Example.h"
+#include "../base/DenseProbabilityMassFunction.h"
+#include "ExampleFileReader.h"
 
 namespace rafl {
 
@@ -54,40 +49,45 @@ public:
   }
 
   /**
-   * \brief Loads a set of examples from the specified file.
+   * \brief Calculates the entropy of a label distribution represented by the specified dense histogram.
    *
-   * \param filename  The name of the file from which to load the examples.
-   * \return          The loaded examples.
+   * \param histogram   The histogram.
+   * \param multipliers Optional per-class ratios that can be used to scale the probabilities for the different labels.
+   * \return            The entropy of the label distribution represented by the histogram.
    */
   template <typename Label>
-  static std::vector<boost::shared_ptr<const Example<Label> > > load_examples(const std::string& filename)
+  static float calculate_entropy(const DenseHistogram<Label>& histogram,
+                                 const typename boost::mpl::identity<boost::optional<std::map<Label,float> > >::type& multipliers = boost::none)
   {
-    // FIXME: Make this robust to bad data.
+    return histogram.empty() ? 0.0f : DenseProbabilityMassFunction<Label>(histogram, multipliers).calculate_entropy();
+  }
 
+  /**
+   * \brief Loads a set of examples from the specified file.
+   *
+   * Each line of the file contains the features of an example, followed by its label (see ExampleFileReader).
+   * The file is read in chunks, and the examples in each chunk are appended to the result as soon as they have
+   * been read, so only one chunk's worth of features is ever held in temporary storage. The examples in each
+   * chunk share a descriptor arena. To process files that are too large to load in their entirety, use
+   * ExampleFileReader::read_chunk directly.
+   *
+   * \param filename            The name of the file from which to load the examples.
+   * \param chunkSize           The maximum number of examples to read in each chunk.
+   * \return                    The loaded examples.
+   * \throws std::runtime_error If the file cannot be opened, or contains a line that cannot be parsed.
+   */
+  template <typename Label>
+  static std::vector<boost::shared_ptr<const Example<Label> > > load_examples(const std::string& filename, size_t chunkSize = 4096)
+  {
     typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
-    std::vector<Example_CPtr> result;
 
-    std::ifstream fs(filename.c_str());
-    if(!fs) throw std::runtime_error("Error: '" + filename + "' could not be opened");
-
-    const std::string delimiters(", \r");
-    std::vector<std::vector<std::string> > wordLines = tvgutil::WordExtractor::extract_word_lines(fs, delimiters);
-
-    for(size_t i = 0, lineCount = wordLines.size(); i < lineCount; ++i)
+    std::vector<Example_CPtr> examples;
+    ExampleFileReader<Label> reader(filename);
+    for(std::vector<Example_CPtr> chunk = reader.read_chunk(chunkSize); !chunk.empty(); chunk = reader.read_chunk(chunkSize))
     {
-      const std::vector<std::string>& words = wordLines[i];
-
-      Descriptor_Ptr descriptor(new Descriptor);
-      for(int j = 0; j < words.size() - 1; ++j)
-      {
-        descriptor->push_back(boost::lexical_cast<float>(words[j]));
-      }
-
-      Label label = boost::lexical_cast<Label>(words.back());
-      result.push_back(Example_CPtr(new Example<Label>(descriptor, label)));
+      examples.insert(examples.end(), chunk.begin(), chunk.end());
     }
-
-    return result;
+    return examples;
   }
 
   /**
@@ -17,11 +17,26 @@ FeatureThresholdingDecisionFunction::FeatureThresholdingDecisionFunction(size_t
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
-DecisionFunction::DescriptorClassification FeatureThresholdingDecisionFunction::classify_descriptor(const Descriptor& descriptor) const
+DecisionFunction::DescriptorClassification FeatureThresholdingDecisionFunction::classify_descriptor(const DescriptorView& descriptor) const
 {
   return descriptor[m_featureIndex] < m_threshold ? DC_LEFT : DC_RIGHT;
 }
 
+size_t FeatureThresholdingDecisionFunction::get_feature_index() const
+{
+  return m_featureIndex;
+}
+
+std::vector<size_t> FeatureThresholdingDecisionFunction::get_feature_indices() const
+{
+  return std::vector<size_t>(1, m_featureIndex);
+}
+
+float FeatureThresholdingDecisionFunction::get_threshold() const
+{
+  return m_threshold;
+}
+
 void FeatureThresholdingDecisionFunction::output(std::ostream& os) const
 {
   os << "Feature " << m_featureIndex << " < " << m_threshold;
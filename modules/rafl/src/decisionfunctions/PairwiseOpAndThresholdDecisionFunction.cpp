@@ -23,12 +23,40 @@ PairwiseOpAndThresholdDecisionFunction::PairwiseOpAndThresholdDecisionFunction()
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
-DecisionFunction::DescriptorClassification PairwiseOpAndThresholdDecisionFunction::classify_descriptor(const Descriptor& descriptor) const
+DecisionFunction::DescriptorClassification PairwiseOpAndThresholdDecisionFunction::classify_descriptor(const DescriptorView& descriptor) const
 {
   float result = apply_op(m_op, descriptor[m_firstFeatureIndex], descriptor[m_secondFeatureIndex]);
   return result < m_threshold ? DC_LEFT : DC_RIGHT;
 }
 
+std::vector<size_t> PairwiseOpAndThresholdDecisionFunction::get_feature_indices() const
+{
+  std::vector<size_t> featureIndices(2);
+  featureIndices[0] = m_firstFeatureIndex;
+  featureIndices[1] = m_secondFeatureIndex;
+  return featureIndices;
+}
+
+size_t PairwiseOpAndThresholdDecisionFunction::get_first_feature_index() const
+{
+  return m_firstFeatureIndex;
+}
+
+PairwiseOpAndThresholdDecisionFunction::Op PairwiseOpAndThresholdDecisionFunction::get_op() const
+{
+  return m_op;
+}
+
+size_t PairwiseOpAndThresholdDecisionFunction::get_second_feature_index() const
+{
+  return m_secondFeatureIndex;
+}
+
+float PairwiseOpAndThresholdDecisionFunction::get_threshold() const
+{
+  return m_threshold;
+}
+
 void PairwiseOpAndThresholdDecisionFunction::output(std::ostream& os) const
 {
   os << "First Feature " << m_firstFeatureIndex << ' '
@@ -6,8 +6,12 @@
 #ifndef H_SPAINT_FEATURECALCULATORFACTORY
 #define H_SPAINT_FEATURECALCULATORFACTORY
 
+#include <vector>
+
 #include <ITMLib/Utils/ITMLibSettings.h>
 
+#include "VOPFeatureCache.h"
+#include "cpu/VOPFeatureKernels_CPU.h"
 #include "interface/FeatureCalculator.h"
 
 namespace spaint {
@@ -19,6 +23,31 @@ struct FeatureCalculatorFactory
 {
   //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
 
+  /**
+   * \brief Makes a feature subset calculator, which calculates only the specified features of the VOP feature descriptors.
+   *
+   * \param maxVoxelLocationCount The maximum number of voxel locations for which we will be calculating features at any one time.
+   * \param patchSize             The side length of a VOP patch (must be odd).
+   * \param patchSpacing          The spacing in the scene (in voxels) between individual pixels in a patch.
+   * \param binCount              The number of bins into which to quantize orientations when aligning voxel patches.
+   * \param featureIndices        The indices of the features to calculate (the other features will be set to zero).
+   * \param deviceType            The device on which the feature calculator should operate (currently only the CPU is supported).
+   */
+  static FeatureCalculator_CPtr make_feature_subset_calculator(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount,
+                                                               const std::vector<size_t>& featureIndices, ITMLibSettings::DeviceType deviceType);
+
+  /**
+   * \brief Makes a multi-scale VOP feature calculator.
+   *
+   * \param maxVoxelLocationCount The maximum number of voxel locations for which we will be calculating features at any one time.
+   * \param patchSize             The side length of a VOP patch (must be odd).
+   * \param patchSpacings         The spacings in the scene (in voxels) between individual pixels in the patches at the various scales.
+   * \param binCount              The number of bins into which to quantize orientations when aligning voxel patches.
+   * \param deviceType            The device on which the feature calculator should operate (currently only the CPU is supported).
+   */
+  static FeatureCalculator_CPtr make_multiscale_vop_feature_calculator(size_t maxVoxelLocationCount, size_t patchSize, const std::vector<float>& patchSpacings,
+                                                                       size_t binCount, ITMLibSettings::DeviceType deviceType);
+
   /**
    * \brief Makes a VOP feature calculator.
    *
@@ -27,9 +56,13 @@ struct FeatureCalculatorFactory
    * \param patchSpacing          The spacing in the scene (in voxels) between individual pixels in a patch.
    * \param binCount              The number of bins into which to quantize orientations when aligning voxel patches.
    * \param deviceType            The device on which the feature calculator should operate.
+   * \param cache                 An optional cache in which to store the calculated feature descriptors for reuse (currently only supported on the CPU).
+   * \param instructionSet        The instruction set with which to run the CPU kernels (ignored on the GPU). Anything other than the scalar
+   *                              instruction set produces descriptors that are not bit-exact with the scalar or CUDA ones.
    */
   static FeatureCalculator_CPtr make_vop_feature_calculator(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount,
-                                                            ITMLibSettings::DeviceType deviceType);
+                                                            ITMLibSettings::DeviceType deviceType, const VOPFeatureCache_Ptr& cache = VOPFeatureCache_Ptr(),
+                                                            VOPFeatureKernels_CPU::InstructionSet instructionSet = VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR);
 };
 
 }
@@ -0,0 +1,112 @@
+/**
+ * spaint: FeatureSubsetCalculator.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINT_FEATURESUBSETCALCULATOR
+#define H_SPAINT_FEATURESUBSETCALCULATOR
+
+#include <utility>
+#include <vector>
+
+#include "cpu/VOPFeatureCalculator_CPU.h"
+#include "cpu/VOPFeatureKernels_CPU.h"
+#include "interface/FeatureCalculator.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class can be used to calculate a subset of the features in the VOP feature descriptors for voxels
+ *        sampled from a scene using the CPU.
+ *
+ * The descriptors it produces have the same layout as ordinary VOP descriptors, so that they can be passed to a forest that
+ * was trained on ordinary descriptors. The features in the subset (typically the ones used by the forest's decision functions)
+ * are identical to those an ordinary VOP feature calculator would produce; all of the other features are set to zero. Since a
+ * forest's predictions only depend on the features its decision functions use, it will make the same predictions for these
+ * descriptors as it would for the full ones.
+ *
+ * The coordinate system for each voxel still has to be aligned using its full (unrotated) patch whenever the subset contains
+ * any patch features, but only the pixels of the oriented patch that are actually needed are gathered and converted to CIELab.
+ */
+class FeatureSubsetCalculator : public FeatureCalculator
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The VOP feature calculator used to calculate the surface normals and to generate and align the coordinate systems for the voxels. */
+  VOPFeatureCalculator_CPU m_baseFeatureCalculator;
+
+  /** The (sorted) indices of the features in the subset. */
+  std::vector<size_t> m_featureIndices;
+
+  /** The vectorised kernels used to convert the gathered pixels to CIELab. */
+  VOPFeatureKernels_CPU m_kernels;
+
+  /** The number of entries at the start of m_pixelIndices that are converted using the vectorised code (a multiple of the vector width). */
+  int m_paddedVectorisedPixelCount;
+
+  /** The pairs of feature indices and gathered pixel buffer offsets for the patch features in the subset. */
+  std::vector<std::pair<int,int> > m_patchFeatureOffsets;
+
+  /** The side length of a VOP patch (must be odd). */
+  size_t m_patchSize;
+
+  /** The spacing in the scene (in voxels) between individual pixels in a patch. */
+  float m_patchSpacing;
+
+  /** The (raster-order) indices of the patch pixels to gather (the vectorised pixels, padded with repeats of the first one, then the scalar pixels). */
+  std::vector<int> m_pixelIndices;
+
+  /** A buffer into which to write the surface normals when the subset contains no patch features. */
+  mutable std::vector<Vector3f> m_surfaceNormals;
+
+  /** The order in which to gather the pixels for the voxels (pairs of tile keys and voxel indices, sorted by tile key). */
+  mutable std::vector<std::pair<unsigned int,int> > m_tileOrder;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a feature subset calculator.
+   *
+   * \param maxVoxelLocationCount The maximum number of voxel locations for which we will be calculating features at any one time.
+   * \param patchSize             The side length of a VOP patch (must be odd).
+   * \param patchSpacing          The spacing in the scene (in voxels) between individual pixels in a patch.
+   * \param binCount              The number of bins into which to quantize orientations when aligning voxel patches.
+   * \param featureIndices        The indices of the features in the subset (e.g. as returned by RandomForest::get_used_feature_indices).
+   * \throws std::runtime_error   If any of the feature indices is out of range.
+   */
+  FeatureSubsetCalculator(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount, const std::vector<size_t>& featureIndices);
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  FeatureSubsetCalculator(const FeatureSubsetCalculator&);
+  FeatureSubsetCalculator& operator=(const FeatureSubsetCalculator&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /** Override */
+  virtual void calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+                                  const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                  ORUtils::MemoryBlock<float>& featuresMB) const;
+
+  /** Override */
+  virtual size_t get_feature_count() const;
+
+  /**
+   * \brief Gets the (sorted) indices of the features in the subset.
+   *
+   * \return  The indices of the features in the subset.
+   */
+  const std::vector<size_t>& get_feature_indices() const;
+
+  /**
+   * \brief Gets the number of patch pixels that are gathered for each voxel.
+   *
+   * \return  The number of patch pixels that are gathered for each voxel.
+   */
+  size_t get_gathered_pixel_count() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * spaint: FeatureWorkspace.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINT_FEATUREWORKSPACE
+#define H_SPAINT_FEATUREWORKSPACE
+
+#include <cstddef>
+#include <vector>
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class provides preallocated scratch space for the CPU-based calculation of VOP feature descriptors.
+ *
+ * When aligning the coordinate systems of the voxels with the dominant orientations of their patches, each voxel needs an intensity
+ * patch and a histogram of oriented gradients, but these are only needed while the voxel is being processed. The workspace thus gives
+ * each OpenMP thread its own intensity patch and histogram, which the thread reuses for every voxel it processes. This avoids the need
+ * to allocate fresh storage for every voxel on each call, and since no two threads ever share a histogram, the bins can be updated
+ * without any atomic operations.
+ *
+ * The storage for each thread is padded to a whole number of cache lines, so that the threads do not falsely share them.
+ *
+ * Note: A workspace may be used concurrently by the threads of a single parallel region, provided that the number of threads in the
+ *       region does not exceed the workspace's thread count (this can be ensured via a num_threads clause).
+ */
+class FeatureWorkspace
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The number of bins in each histogram. */
+  size_t m_binCount;
+
+  /** The storage for the intensity patches and histograms of the threads (each thread's histogram follows its intensity patch). */
+  std::vector<float> m_buffer;
+
+  /** The number of pixels in each intensity patch. */
+  size_t m_patchArea;
+
+  /** The offset between the storage for consecutive threads in the buffer (in floats). */
+  size_t m_threadStride;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a feature workspace.
+   *
+   * \param patchSize   The side length of a VOP patch.
+   * \param binCount    The number of bins into which orientations are quantized.
+   * \param threadCount The number of threads for which to provide storage (if 0, storage is provided for each thread that OpenMP can use).
+   */
+  FeatureWorkspace(size_t patchSize, size_t binCount, size_t threadCount = 0);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the histogram for the calling thread.
+   *
+   * \return  The histogram for the calling thread (its contents are whatever the thread last wrote into it).
+   */
+  float *get_histogram();
+
+  /**
+   * \brief Gets the intensity patch for the calling thread.
+   *
+   * \return  The intensity patch for the calling thread (its contents are whatever the thread last wrote into it).
+   */
+  float *get_intensity_patch();
+
+  /**
+   * \brief Gets the number of threads for which the workspace provides storage.
+   *
+   * \return  The number of threads for which the workspace provides storage.
+   */
+  int get_thread_count() const;
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Gets the storage for the calling thread.
+   *
+   * \return  The storage for the calling thread.
+   */
+  float *get_thread_storage();
+};
+
+}
+
+#endif
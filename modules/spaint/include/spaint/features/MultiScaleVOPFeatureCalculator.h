@@ -0,0 +1,91 @@
+/**
+ * spaint: MultiScaleVOPFeatureCalculator.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINT_MULTISCALEVOPFEATURECALCULATOR
+#define H_SPAINT_MULTISCALEVOPFEATURECALCULATOR
+
+#include <utility>
+#include <vector>
+
+#include "cpu/VOPFeatureCalculator_CPU.h"
+#include "cpu/VOPFeatureKernels_CPU.h"
+#include "interface/FeatureCalculator.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class can be used to calculate multi-scale VOP feature descriptors for voxels sampled from a scene using the CPU.
+ *
+ * A multi-scale descriptor contains a CIELab patch for each of a number of different patch spacings (typically two or three),
+ * followed by the surface normal and the height of the voxel, as for an ordinary VOP descriptor. Sampling patches with larger
+ * spacings lets the descriptor capture more of a voxel's surroundings, which helps to distinguish large, smooth surfaces.
+ *
+ * The coordinate system for each voxel is generated and aligned with the dominant orientation of its patch only once, using
+ * the first spacing, and is then shared by all of the scales. As a result, the first patch and the normal and height of each
+ * descriptor are identical to the descriptor that an ordinary VOP feature calculator with the first spacing would produce.
+ */
+class MultiScaleVOPFeatureCalculator : public FeatureCalculator
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The single-scale VOP feature calculator used to generate and align the coordinate systems for the voxels. */
+  VOPFeatureCalculator_CPU m_baseFeatureCalculator;
+
+  /** A memory block into which to store the single-scale feature descriptors calculated when aligning the coordinate systems. */
+  boost::shared_ptr<ORUtils::MemoryBlock<float> > m_baseFeaturesMB;
+
+  /** The vectorised kernels used to convert the RGB patches to CIELab. */
+  VOPFeatureKernels_CPU m_kernels;
+
+  /** The side length of a VOP patch (must be odd). */
+  size_t m_patchSize;
+
+  /** The spacings in the scene between individual pixels in the patches at the various scales. */
+  std::vector<float> m_patchSpacings;
+
+  /** The order in which to gather the RGB patches for the voxels (pairs of tile keys and voxel indices, sorted by tile key). */
+  mutable std::vector<std::pair<unsigned int,int> > m_tileOrder;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a multi-scale VOP feature calculator.
+   *
+   * \param maxVoxelLocationCount The maximum number of voxel locations for which we will be calculating features at any one time.
+   * \param patchSize             The side length of a VOP patch (must be odd).
+   * \param patchSpacings         The spacings in the scene (in voxels) between individual pixels in the patches at the various scales
+   *                              (the first spacing is used to align the voxels' coordinate systems).
+   * \param binCount              The number of bins into which to quantize orientations when aligning voxel patches.
+   * \throws std::runtime_error   If no patch spacings are specified.
+   */
+  MultiScaleVOPFeatureCalculator(size_t maxVoxelLocationCount, size_t patchSize, const std::vector<float>& patchSpacings, size_t binCount);
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  MultiScaleVOPFeatureCalculator(const MultiScaleVOPFeatureCalculator&);
+  MultiScaleVOPFeatureCalculator& operator=(const MultiScaleVOPFeatureCalculator&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /** Override */
+  virtual void calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+                                  const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                  ORUtils::MemoryBlock<float>& featuresMB) const;
+
+  /** Override */
+  virtual size_t get_feature_count() const;
+
+  /**
+   * \brief Gets the number of scales at which patches are sampled.
+   *
+   * \return  The number of scales at which patches are sampled.
+   */
+  size_t get_scale_count() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * spaint: VOPFeatureCache.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VOPFEATURECACHE
+#define H_SPAINT_VOPFEATURECACHE
+
+#include <ostream>
+#include <vector>
+
+#include <boost/chrono/chrono.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "../util/SpaintVoxel.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class can be used to cache the VOP feature descriptors that have been calculated for voxels in a scene.
+ *
+ * When predicting labels, the same (static) surfaces tend to be resampled frame after frame, so recomputing their features each
+ * time is largely wasted effort. The cache stores the feature descriptor for each voxel location it sees, together with the depth
+ * and colour weights the voxel had when the descriptor was calculated. A cached descriptor is considered valid for as long as the
+ * voxel's weights stay within a specified tolerance of those values: once they move further than that, the voxel's surroundings
+ * are deemed to have been updated sufficiently by fusion that the descriptor must be recalculated.
+ *
+ * Since InfiniTAM stops increasing a voxel's weights once they reach their maximum, the weights of a voxel that has been observed
+ * for a while will no longer change, even if fusion goes on to update its neighbours. For that reason, cached descriptors also
+ * have a maximum age, measured in batches of lookups (the feature calculator starts a new batch each time it is asked to calculate
+ * features, i.e. once or twice per frame in the pipeline): a descriptor that was calculated more than that many batches ago is
+ * recalculated regardless of the voxel's weights.
+ *
+ * The cache has a fixed capacity. When it is full, the oldest entries are evicted first.
+ */
+class VOPFeatureCache
+{
+  //#################### NESTED TYPES ####################
+private:
+  /**
+   * \brief An instance of this struct records the voxel to which a slot in the cache currently belongs.
+   */
+  struct Entry
+  {
+    /** The index of the batch of lookups in which the feature descriptor was calculated. */
+    size_t batchIndex;
+
+    /** The key of the voxel location. */
+    long long key;
+
+    /** The colour weight of the voxel when its feature descriptor was calculated. */
+    int colourWeight;
+
+    /** The depth weight of the voxel when its feature descriptor was calculated. */
+    int depthWeight;
+
+    /** Whether or not the slot is in use. */
+    bool used;
+  };
+
+  /**
+   * \brief An instance of this struct can be used to hash voxel location keys.
+   *
+   * Locations are hashed in the same way as InfiniTAM's voxel block hash (i.e. based on the position of the
+   * block containing the voxel), with the voxel's offset within its block mixed in to separate its neighbours.
+   */
+  struct KeyHasher
+  {
+    size_t operator()(long long key) const;
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The index of the current batch of lookups. */
+  size_t m_batchIndex;
+
+  /** The maximum number of feature descriptors that can be cached. */
+  size_t m_capacity;
+
+  /** The total time spent calculating feature descriptors that were not in the cache. */
+  boost::chrono::microseconds m_computationTime;
+
+  /** The number of feature descriptors that have been calculated because they were not in the cache. */
+  size_t m_computedCount;
+
+  /** The entries recording the voxel to which each slot belongs. */
+  std::vector<Entry> m_entries;
+
+  /** The number of features in each feature descriptor. */
+  size_t m_featureCount;
+
+  /** The cached feature descriptors (packed sequentially, one per slot). */
+  std::vector<float> m_features;
+
+  /** The number of successful lookups. */
+  size_t m_hitCount;
+
+  /** The number of lookups. */
+  size_t m_lookupCount;
+
+  /** The maximum number of batches of lookups for which a cached feature descriptor remains valid after the one in which it was calculated. */
+  size_t m_maxAge;
+
+  /** The slot to be used for the next feature descriptor that is stored (slots are reused in FIFO order). */
+  size_t m_nextSlot;
+
+  /** A map from voxel location keys to the slots containing their feature descriptors. */
+  boost::unordered_map<long long,size_t,KeyHasher> m_slots;
+
+  /** The amount by which a voxel's depth or colour weight may change before its cached feature descriptor becomes invalid. */
+  int m_weightTolerance;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a VOP feature cache.
+   *
+   * Note: The number of features in each feature descriptor is specified by the feature calculator that uses the cache (see set_feature_count).
+   *
+   * \param capacity        The maximum number of feature descriptors that can be cached.
+   * \param weightTolerance The amount by which a voxel's depth or colour weight may change before its cached feature descriptor becomes invalid.
+   * \param maxAge          The maximum number of batches of lookups for which a cached feature descriptor remains valid after the one in which it was calculated.
+   */
+  VOPFeatureCache(size_t capacity, int weightTolerance, size_t maxAge);
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  VOPFeatureCache(const VOPFeatureCache&);
+  VOPFeatureCache& operator=(const VOPFeatureCache&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Clears the cache.
+   */
+  void clear();
+
+  /**
+   * \brief Gets the fraction of lookups that have succeeded.
+   *
+   * \return  The fraction of lookups that have succeeded (or 0 if there have not yet been any lookups).
+   */
+  double get_hit_rate() const;
+
+  /**
+   * \brief Looks up the cached feature descriptor for the specified voxel.
+   *
+   * \param voxelLocation The location of the voxel.
+   * \param voxel         The voxel itself (used to check that the cached feature descriptor is still valid).
+   * \return              A pointer to the cached feature descriptor, if there is a valid one, or NULL otherwise.
+   */
+  const float *lookup(const Vector3s& voxelLocation, const SpaintVoxel& voxel);
+
+  /**
+   * \brief Outputs the hit rate of the cache and an estimate of the time it has saved to a stream.
+   *
+   * The time saved is estimated as the number of cache hits multiplied by the average time taken to calculate a feature descriptor.
+   *
+   * \param os  The stream.
+   */
+  void output_statistics(std::ostream& os) const;
+
+  /**
+   * \brief Records the time that was spent calculating feature descriptors that were not in the cache.
+   *
+   * \param computedCount   The number of feature descriptors that were calculated.
+   * \param computationTime The time spent calculating them.
+   */
+  void record_computation(size_t computedCount, const boost::chrono::microseconds& computationTime);
+
+  /**
+   * \brief Clears the cache and sets the number of features in each of the feature descriptors it will subsequently store.
+   *
+   * \param featureCount The number of features in each feature descriptor.
+   */
+  void set_feature_count(size_t featureCount);
+
+  /**
+   * \brief Starts a new batch of lookups (this ages all of the feature descriptors in the cache by one batch).
+   */
+  void start_batch();
+
+  /**
+   * \brief Stores the feature descriptor for the specified voxel in the cache.
+   *
+   * \param voxelLocation The location of the voxel.
+   * \param voxel         The voxel itself (its weights are stored so that the validity of the feature descriptor can later be checked).
+   * \param features      The feature descriptor for the voxel.
+   */
+  void store(const Vector3s& voxelLocation, const SpaintVoxel& voxel, const float *features);
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Gets the colour weight of a voxel (or 0 if voxels do not store colour information).
+   *
+   * \param voxel The voxel.
+   * \return      The colour weight of the voxel.
+   */
+  static int get_colour_weight(const SpaintVoxel& voxel);
+
+  /**
+   * \brief Makes a key for a voxel location by packing its coordinates into a single integer.
+   *
+   * \param voxelLocation The voxel location.
+   * \return              The key.
+   */
+  static long long make_key(const Vector3s& voxelLocation);
+};
+
+//#################### TYPEDEFS ####################
+
+typedef boost::shared_ptr<VOPFeatureCache> VOPFeatureCache_Ptr;
+
+}
+
+#endif
@@ -6,7 +6,13 @@
 #ifndef H_SPAINT_VOPFEATURECALCULATOR_CPU
 #define H_SPAINT_VOPFEATURECALCULATOR_CPU
 
+#include <utility>
+#include <vector>
+
+#include "../FeatureWorkspace.h"
+#include "../VOPFeatureCache.h"
 #include "../interface/VOPFeatureCalculator.h"
+#include "VOPFeatureKernels_CPU.h"
 
 namespace spaint {
 /**
@@ -14,6 +20,32 @@ namespace spaint {
  */
 class VOPFeatureCalculator_CPU : public VOPFeatureCalculator
 {
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** An optional cache of previously-calculated feature descriptors (may be NULL). */
+  VOPFeatureCache_Ptr m_cache;
+
+  /** The vectorised kernels used to convert the RGB patches to CIELab and to compute the histograms of oriented gradients. */
+  VOPFeatureKernels_CPU m_kernels;
+
+  /** A memory block into which to store the feature descriptors for the voxels that were not found in the cache. */
+  boost::shared_ptr<ORUtils::MemoryBlock<float> > m_missFeaturesMB;
+
+  /** The indices (in the input) of the voxels that were not found in the cache. */
+  mutable std::vector<int> m_missIndices;
+
+  /** A memory block into which to store the locations of the voxels that were not found in the cache. */
+  boost::shared_ptr<ORUtils::MemoryBlock<Vector3s> > m_missLocationsMB;
+
+  /** The voxels that were not found in the cache. */
+  mutable std::vector<SpaintVoxel> m_missVoxels;
+
+  /** The order in which to gather the RGB patches for the voxels (pairs of tile keys and voxel indices, sorted by tile key). */
+  mutable std::vector<std::pair<unsigned int,int> > m_tileOrder;
+
+  /** The preallocated scratch space used when aligning the coordinate systems of the voxels with the dominant orientations of their patches. */
+  mutable FeatureWorkspace m_workspace;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -23,26 +55,39 @@ public:
    * \param patchSize             The side length of a VOP patch (must be odd).
    * \param patchSpacing          The spacing in the scene (in voxels) between individual pixels in a patch.
    * \param binCount              The number of bins into which to quantize orientations when aligning voxel patches.
+   * \param cache                 An optional cache in which to store the calculated feature descriptors for reuse (may be NULL).
+   * \param instructionSet        The instruction set with which to run the CIELab and histogram kernels (the vectorised
+   *                              kernels are faster, but their descriptors are not bit-exact with the scalar or CUDA ones).
    */
-  VOPFeatureCalculator_CPU(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount);
+  VOPFeatureCalculator_CPU(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount,
+                           const VOPFeatureCache_Ptr& cache = VOPFeatureCache_Ptr(),
+                           VOPFeatureKernels_CPU::InstructionSet instructionSet = VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /** Override */
+  virtual void calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+                                  const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                  ORUtils::MemoryBlock<float>& featuresMB) const;
 
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
   /** Override */
-  virtual void calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
+  virtual void calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
+                                         const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                          ORUtils::MemoryBlock<float>& featuresMB) const;
 
   /** Override */
   virtual void convert_patches_to_lab(int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const;
 
   /** Override */
-  virtual void fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, ORUtils::MemoryBlock<float>& featuresMB) const;
+  virtual void fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const;
 
   /** Override */
   virtual void generate_coordinate_systems(int voxelLocationCount) const;
 
   /** Override */
-  virtual void generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+  virtual void generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
                                     const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                     ORUtils::MemoryBlock<float>& featuresMB) const;
 
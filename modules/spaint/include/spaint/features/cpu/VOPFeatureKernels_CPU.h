@@ -0,0 +1,141 @@
+/**
+ * spaint: VOPFeatureKernels_CPU.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VOPFEATUREKERNELS_CPU
+#define H_SPAINT_VOPFEATUREKERNELS_CPU
+
+#include <string>
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class provides vectorised CPU implementations of the per-pixel kernels that dominate the cost of
+ *        calculating VOP feature descriptors, namely the RGB to CIELab conversion and the computation of histograms of oriented
+ *        gradients.
+ *
+ * The scalar versions of these kernels (in VOPFeatureCalculator_Shared.h) call pow once per colour channel and atan2 once per
+ * pixel. The vectorised versions instead process 4 (SSE2) or 8 (AVX2) pixels at a time, using Newton's method to compute cube
+ * roots and a polynomial approximation to compute arctangents. Their results agree with those of the scalar versions up to a
+ * small tolerance, except that the CIELab a and b values of (near-)grey pixels, which are badly conditioned (they are divided
+ * by their almost-zero sum), may differ more significantly. In rare cases, a gradient whose orientation lies extremely close
+ * to the boundary between two bins may also be counted in the adjacent bin.
+ *
+ * Since the vectorised versions are not bit-exact, using them would make the CPU descriptors depend on the machine, and stop
+ * them matching the descriptors (calculated by the scalar or CUDA code) on which existing forests were trained. The scalar
+ * versions are therefore used by default, and the vectorised versions must be explicitly requested when the kernels are
+ * constructed (get_best_instruction_set can be used to find the best instruction set supported by the CPU on which the code
+ * is running; the detection is done at runtime, so the same binary can be run on any x86 CPU). On non-x86 platforms, only
+ * the scalar versions are available.
+ */
+class VOPFeatureKernels_CPU
+{
+  //#################### ENUMERATIONS ####################
+public:
+  /**
+   * \brief The values of this enumeration denote the instruction sets with which the kernels can be run.
+   */
+  enum InstructionSet
+  {
+    /** Use the scalar versions of the kernels. */
+    INSTRUCTIONSET_SCALAR,
+
+    /** Use SSE2 to process 4 pixels at a time. */
+    INSTRUCTIONSET_SSE2,
+
+    /** Use AVX2 to process 8 pixels at a time. */
+    INSTRUCTIONSET_AVX2
+  };
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The instruction set with which the kernels are run. */
+  InstructionSet m_instructionSet;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a set of VOP feature kernels that use the scalar versions of the kernels.
+   */
+  VOPFeatureKernels_CPU();
+
+  /**
+   * \brief Constructs a set of VOP feature kernels that use the specified instruction set.
+   *
+   * \param instructionSet      The instruction set to use.
+   * \throws std::runtime_error If the instruction set is not supported by the CPU.
+   */
+  explicit VOPFeatureKernels_CPU(InstructionSet instructionSet);
+
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Gets the best instruction set supported by the CPU.
+   *
+   * \return  The best instruction set supported by the CPU.
+   */
+  static InstructionSet get_best_instruction_set();
+
+  /**
+   * \brief Gets the name of the specified instruction set.
+   *
+   * \param instructionSet  The instruction set.
+   * \return                The name of the instruction set.
+   */
+  static std::string get_instruction_set_name(InstructionSet instructionSet);
+
+  /**
+   * \brief Determines whether or not the specified instruction set is supported by the CPU.
+   *
+   * \param instructionSet  The instruction set.
+   * \return                true, if the instruction set is supported by the CPU, or false otherwise.
+   */
+  static bool is_supported(InstructionSet instructionSet);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Computes a histogram of oriented gradients from a patch of intensity values.
+   *
+   * This is equivalent to calling compute_histogram_for_patch for each pixel in the patch (after clearing the histogram).
+   *
+   * \param intensityPatch  The patch of intensity values from which to calculate the histogram.
+   * \param patchSize       The side length of the patch (must be odd).
+   * \param binCount        The number of bins into which to quantize the gradient orientations.
+   * \param histogram       The location into which to write the histogram for the patch.
+   */
+  void compute_histogram(const float *intensityPatch, int patchSize, int binCount, float *histogram) const;
+
+  /**
+   * \brief Converts an RGB patch to the CIELab colour space in place.
+   *
+   * This is equivalent to convert_patch_to_lab, but operates on a single patch.
+   *
+   * \param patch       The patch, stored as interleaved RGB values in the range [0,255].
+   * \param pixelCount  The number of pixels in the patch.
+   */
+  void convert_patch_to_lab(float *patch, int pixelCount) const;
+
+  /**
+   * \brief Gets the instruction set with which the kernels are run.
+   *
+   * \return  The instruction set with which the kernels are run.
+   */
+  InstructionSet get_instruction_set() const;
+
+  /**
+   * \brief Gets the number of pixels that the CIELab conversion processes at a time.
+   *
+   * When a patch is converted, all but the last (pixelCount % width) pixels are converted using the vectorised code,
+   * and the remaining pixels are converted using the scalar code. Callers that need to reproduce the conversion of
+   * individual pixels exactly (e.g. the feature subset calculator) can use this to tell which code a pixel will go through.
+   *
+   * \return The number of pixels that the CIELab conversion processes at a time (1 for the scalar kernels).
+   */
+  int get_vector_width() const;
+};
+
+}
+
+#endif
@@ -29,20 +29,21 @@ public:
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
   /** Override */
-  virtual void calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
+  virtual void calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
+                                         const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                          ORUtils::MemoryBlock<float>& featuresMB) const;
 
   /** Override */
   virtual void convert_patches_to_lab(int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const;
 
   /** Override */
-  virtual void fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, ORUtils::MemoryBlock<float>& featuresMB) const;
+  virtual void fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const;
 
   /** Override */
   virtual void generate_coordinate_systems(int voxelLocationCount) const;
 
   /** Override */
-  virtual void generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+  virtual void generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
                                     const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                     ORUtils::MemoryBlock<float>& featuresMB) const;
 
@@ -60,12 +60,14 @@ private:
   /**
    * \brief Calculates the surface normals at the voxel locations.
    *
-   * \param voxelLocationsMB  A memory block containing the locations of the voxels for which to calculate the surface normals.
-   * \param voxelData         The scene's voxel data.
-   * \param indexData         The scene's index data.
-   * \param featuresMB        A memory block into which to store the calculated feature descriptors (packed sequentially).
+   * \param voxelLocationsMB    A memory block containing the locations of the voxels for which to calculate the surface normals.
+   * \param voxelLocationCount  The number of voxel locations for which we are calculating features.
+   * \param voxelData           The scene's voxel data.
+   * \param indexData           The scene's index data.
+   * \param featuresMB          A memory block into which to store the calculated feature descriptors (packed sequentially).
    */
-  virtual void calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
+  virtual void calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
+                                         const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                          ORUtils::MemoryBlock<float>& featuresMB) const = 0;
 
   /**
@@ -79,10 +81,11 @@ private:
   /**
    * \brief Writes the height of each voxel into the corresponding feature vector for use as an extra feature.
    *
-   * \param voxelLocationsMB  A memory block containing the locations of the voxels for which to fill in the heights.
-   * \param featuresMB        A memory block into which to store the calculated feature descriptors (packed sequentially).
+   * \param voxelLocationsMB    A memory block containing the locations of the voxels for which to fill in the heights.
+   * \param voxelLocationCount  The number of voxel locations for which we are calculating features.
+   * \param featuresMB          A memory block into which to store the calculated feature descriptors (packed sequentially).
    */
-  virtual void fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, ORUtils::MemoryBlock<float>& featuresMB) const = 0;
+  virtual void fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const = 0;
 
   /**
    * \brief Generates coordinate systems in the tangent planes to the surfaces at the voxel locations.
@@ -94,12 +97,13 @@ private:
   /**
    * \brief Generates an RGB patch for each voxel by sampling from a regularly-spaced grid around it in its tangent plane.
    *
-   * \param voxelLocationsMB  A memory block containing the locations of the voxels for which to generate RGB patches.
-   * \param voxelData         The scene's voxel data.
-   * \param indexData         The scene's index data.
-   * \param featuresMB        A memory block into which to store the calculated feature descriptors (packed sequentially).
+   * \param voxelLocationsMB    A memory block containing the locations of the voxels for which to generate RGB patches.
+   * \param voxelLocationCount  The number of voxel locations for which we are calculating features.
+   * \param voxelData           The scene's voxel data.
+   * \param indexData           The scene's index data.
+   * \param featuresMB          A memory block into which to store the calculated feature descriptors (packed sequentially).
    */
-  virtual void generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+  virtual void generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
                                     const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                     ORUtils::MemoryBlock<float>& featuresMB) const = 0;
 
@@ -115,6 +119,24 @@ private:
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
+  /**
+   * \brief Generates a coordinate system in the tangent plane to the surface at each of the first voxelLocationCount voxels
+   *        in the specified memory block, and aligns it with the dominant orientation in the voxel's RGB patch.
+   *
+   * This is the first stage of calculating the feature descriptors for the voxels. It is exposed separately so that
+   * calculators that sample patches at several different scales can share a single coordinate system for each voxel.
+   * After it has run, the coordinate systems can be obtained via get_x_axes and get_y_axes. The feature descriptors
+   * will contain the surface normals and the unaligned RGB patches for the voxels.
+   *
+   * \param voxelLocationsMB    A memory block containing the locations of the voxels for which to generate coordinate systems.
+   * \param voxelLocationCount  The number of voxel locations for which to generate coordinate systems.
+   * \param scene               The scene.
+   * \param featuresMB          A memory block into which to store the partially-calculated feature descriptors (packed sequentially).
+   */
+  void align_coordinate_systems(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
+                                const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                ORUtils::MemoryBlock<float>& featuresMB) const;
+
   /** Override */
   virtual void calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
                                   const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
@@ -123,6 +145,34 @@ public:
   /** Override */
   virtual size_t get_feature_count() const;
 
+  /**
+   * \brief Gets the x axes of the coordinate systems most recently generated for the voxels.
+   *
+   * \return The x axes of the coordinate systems most recently generated for the voxels.
+   */
+  const ORUtils::MemoryBlock<Vector3f>& get_x_axes() const;
+
+  /**
+   * \brief Gets the y axes of the coordinate systems most recently generated for the voxels.
+   *
+   * \return The y axes of the coordinate systems most recently generated for the voxels.
+   */
+  const ORUtils::MemoryBlock<Vector3f>& get_y_axes() const;
+
+  //#################### PROTECTED MEMBER FUNCTIONS ####################
+protected:
+  /**
+   * \brief Calculates VOP feature descriptors for the first voxelLocationCount voxels in the specified memory block.
+   *
+   * \param voxelLocationsMB    A memory block containing the locations of the voxels for which to calculate feature descriptors.
+   * \param voxelLocationCount  The number of voxel locations for which to calculate feature descriptors.
+   * \param scene               The scene.
+   * \param featuresMB          A memory block into which to store the calculated feature descriptors (packed sequentially).
+   */
+  void compute_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
+                        const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                        ORUtils::MemoryBlock<float>& featuresMB) const;
+
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
   /**
@@ -6,11 +6,84 @@
 #ifndef H_SPAINT_VOPFEATURECALCULATOR_SHARED
 #define H_SPAINT_VOPFEATURECALCULATOR_SHARED
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "../../util/ColourConversion_Shared.h"
 #include "../../util/SpaintVoxel.h"
 
 namespace spaint {
 
+//#################### TYPES ####################
+
+/**
+ * \brief An instance of this struct caches the addresses of the voxel blocks that are touched when gathering a VOP patch,
+ *        so that the hash entry for each block only needs to be looked up once per patch.
+ *
+ * The samples in a patch are spaced only a voxel or two apart, so a patch touches only a small neighbourhood of voxel blocks.
+ * The cache is direct-mapped: each block is assigned to the slot given by the low two bits of each of its coordinates, so any
+ * 4x4x4 neighbourhood of blocks can be cached without conflicts, and finding a block in the cache takes constant time. Blocks
+ * that turn out not to be allocated are cached as well. If two blocks touched by a patch share a slot (which can only happen
+ * for the largest patches), the one that was used most recently replaces the other.
+ */
+struct PatchBlockCache
+{
+  //#################### ENUMERATIONS ####################
+
+  /** The number of slots in the cache (one for each block in a 4x4x4 neighbourhood). */
+  enum { CAPACITY = 64 };
+
+  //#################### PUBLIC VARIABLES ####################
+
+  /** The offsets of the cached blocks in the voxel data (or -1 for blocks that are not allocated). */
+  int blockOffsets[CAPACITY];
+
+  /** The positions of the cached blocks. */
+  Vector3s blockPositions[CAPACITY];
+
+  /** The number of lookups that have been performed in the scene's hash table (this is never reset, and is useful for profiling). */
+  int lookupCount;
+
+  /** A bit mask indicating which of the slots currently contain a block. */
+  unsigned long long validSlots;
+
+  //#################### CONSTRUCTORS ####################
+
+  /**
+   * \brief Constructs an empty patch block cache.
+   */
+  _CPU_AND_GPU_CODE_
+  PatchBlockCache()
+  : lookupCount(0), validSlots(0)
+  {}
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+
+  /**
+   * \brief Clears the cache (e.g. before starting to gather a new patch).
+   */
+  _CPU_AND_GPU_CODE_
+  void clear()
+  {
+    validSlots = 0;
+  }
+
+  /**
+   * \brief Gets the slot to which the block at the specified position is assigned.
+   *
+   * \param blockPos The position of the block.
+   * \return         The slot to which the block is assigned.
+   */
+  _CPU_AND_GPU_CODE_
+  static int get_slot(const Vector3s& blockPos)
+  {
+    return (blockPos.x & 3) | ((blockPos.y & 3) << 2) | ((blockPos.z & 3) << 4);
+  }
+};
+
+//#################### FUNCTIONS ####################
+
 /**
  * \brief Converts the RGB patch for the specified voxel to the CIELab colour space.
  *
@@ -35,6 +108,43 @@ inline void convert_patch_to_lab(int voxelLocationIndex, size_t featureCount, fl
   }
 }
 
+/**
+ * \brief Computes the quantized orientation and magnitude of the intensity gradient at the specified pixel in a patch.
+ *
+ * \param indexInPatch    The index of the pixel within the patch.
+ * \param patchSize       The side length of a VOP patch (must be odd).
+ * \param intensityPatch  The patch of intensity values.
+ * \param binCount        The number of bins into which to quantize the gradient orientations.
+ * \param bin             A location into which to write the bin into which the gradient orientation falls.
+ * \param mag             A location into which to write the magnitude of the gradient.
+ * \return                true, if the pixel is far enough from the boundaries of the patch for a gradient to be computed, or false otherwise.
+ */
+_CPU_AND_GPU_CODE_
+inline bool compute_oriented_gradient(int indexInPatch, size_t patchSize, const float *intensityPatch, size_t binCount, int& bin, float& mag)
+{
+  // Compute the (x,y) coordinates of the pixel within the patch.
+  const size_t y = indexInPatch / patchSize;
+  const size_t x = indexInPatch % patchSize;
+
+  // Check that we're within the boundaries of the patch and can safely compute a gradient.
+  if(x == 0 || y == 0 || x == patchSize - 1 || y == patchSize - 1) return false;
+
+  // Compute the x and y derivatives.
+  float xDeriv = intensityPatch[indexInPatch + 1] - intensityPatch[indexInPatch - 1];
+  float yDeriv = intensityPatch[indexInPatch + patchSize] - intensityPatch[indexInPatch - patchSize];
+
+  // Compute the magnitude.
+  mag = static_cast<float>(sqrt(xDeriv * xDeriv + yDeriv * yDeriv));
+
+  // Compute the orientation.
+  double ori = atan2(yDeriv, xDeriv) + 2 * M_PI;
+
+  // Quantize the orientation.
+  bin = static_cast<int>(binCount * ori / (2 * M_PI)) % binCount;
+
+  return true;
+}
+
 /**
  * \brief Computes a histogram of oriented gradients from a patch of intensity values.
  *
@@ -50,27 +160,10 @@ inline void convert_patch_to_lab(int voxelLocationIndex, size_t featureCount, fl
 _CPU_AND_GPU_CODE_
 inline void compute_histogram_for_patch(int tid, size_t patchSize, const float *intensityPatch, size_t binCount, float *histogram)
 {
-  // Compute the index and (x,y) coordinates of the pixel we're processing within the current patch.
-  const int indexInPatch = tid % (patchSize * patchSize);
-  const size_t y = indexInPatch / patchSize;
-  const size_t x = indexInPatch % patchSize;
-
-  // Provided we're within the boundaries of the patch and can safely compute a gradient:
-  if(x != 0 && y != 0 && x != patchSize - 1 && y != patchSize - 1)
+  int bin;
+  float mag;
+  if(compute_oriented_gradient(tid % (patchSize * patchSize), patchSize, intensityPatch, binCount, bin, mag))
   {
-    // Compute the x and y derivatives.
-    float xDeriv = intensityPatch[indexInPatch + 1] - intensityPatch[indexInPatch - 1];
-    float yDeriv = intensityPatch[indexInPatch + patchSize] - intensityPatch[indexInPatch - patchSize];
-
-    // Compute the magnitude.
-    float mag = static_cast<float>(sqrt(xDeriv * xDeriv + yDeriv * yDeriv));
-
-    // Compute the orientation.
-    double ori = atan2(yDeriv, xDeriv) + 2 * M_PI;
-
-    // Quantize the orientation and update the histogram.
-    int bin = static_cast<int>(binCount * ori / (2 * M_PI)) % binCount;
-
 #if defined(__CUDACC__) && defined(__CUDA_ARCH__)
     atomicAdd(&histogram[bin], mag);
 #else
@@ -111,6 +204,45 @@ inline void compute_intensities_for_patch(int tid, const float *features, int fe
   intensityPatch[indexInPatch] = convert_rgb_to_grey(r, g, b);
 }
 
+/**
+ * \brief Computes a key that can be used to sort voxels into spatially-coherent tiles before gathering their patches.
+ *
+ * The key is the Morton code of the position of the voxel block containing the voxel (using the low 10 bits of each
+ * coordinate). Gathering the patches of voxels in key order means that consecutive patches mostly touch the same
+ * voxel blocks, so the hash entries and voxel data they read are likely to still be in the cache.
+ *
+ * \param voxelLocation The location of the voxel.
+ * \return              The key for the voxel.
+ */
+_CPU_AND_GPU_CODE_
+inline unsigned int compute_tile_key(const Vector3s& voxelLocation)
+{
+  unsigned int key = 0;
+  const unsigned int x = (voxelLocation.x >> 3) & 0x3ff, y = (voxelLocation.y >> 3) & 0x3ff, z = (voxelLocation.z >> 3) & 0x3ff;
+  for(int bit = 0; bit < 10; ++bit)
+  {
+    key |= (((x >> bit) & 1) << (3 * bit)) | (((y >> bit) & 1) << (3 * bit + 1)) | (((z >> bit) & 1) << (3 * bit + 2));
+  }
+  return key;
+}
+
+/**
+ * \brief Sorts the specified voxels into spatially-coherent tiles, so that consecutive voxels mostly read from the same voxel blocks.
+ *
+ * \param voxelLocations      The locations of the voxels.
+ * \param voxelLocationCount  The number of voxels.
+ * \param tileOrder           A vector into which to write the (tile key, voxel location index) pairs, sorted by tile key.
+ */
+inline void make_tile_order(const Vector3s *voxelLocations, int voxelLocationCount, std::vector<std::pair<unsigned int,int> >& tileOrder)
+{
+  tileOrder.resize(voxelLocationCount);
+  for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
+  {
+    tileOrder[voxelLocationIndex] = std::make_pair(compute_tile_key(voxelLocations[voxelLocationIndex]), voxelLocationIndex);
+  }
+  std::sort(tileOrder.begin(), tileOrder.end());
+}
+
 /**
  * \brief Writes the height of the specified voxel into the corresponding feature vector for use as an extra feature.
  *
@@ -125,6 +257,62 @@ inline void fill_in_height(int voxelLocationIndex, const Vector3s *voxelLocation
   features[(voxelLocationIndex + 1) * featureCount - 1] = voxelLocations[voxelLocationIndex].y;
 }
 
+/**
+ * \brief Looks up the voxel block at the specified position in the scene's hash table.
+ *
+ * \param blockPos    The position of the voxel block.
+ * \param indexData   The scene's index data.
+ * \return            The offset of the voxel block in the scene's voxel data, or -1 if the block is not allocated.
+ */
+_CPU_AND_GPU_CODE_
+inline int find_voxel_block(const Vector3s& blockPos, const ITMVoxelIndex::IndexData *indexData)
+{
+  int hashIdx = hashIndex(blockPos);
+  while(true)
+  {
+    const ITMHashEntry& hashEntry = indexData[hashIdx];
+    if(hashEntry.pos == blockPos && hashEntry.ptr >= 0)
+    {
+      return hashEntry.ptr * SDF_BLOCK_SIZE3;
+    }
+
+    if(hashEntry.offset < 1) return -1;
+    hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+  }
+}
+
+/**
+ * \brief Reads the voxel (if any) at the specified location in the scene, using a patch block cache to avoid repeated hash lookups.
+ *
+ * \param loc         The location of the voxel.
+ * \param voxelData   The scene's voxel data.
+ * \param indexData   The scene's index data.
+ * \param cache       The patch block cache.
+ * \return            A pointer to the voxel, if it exists, or NULL otherwise.
+ */
+_CPU_AND_GPU_CODE_
+inline const SpaintVoxel *read_voxel_via_cache(const Vector3i& loc, const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData, PatchBlockCache& cache)
+{
+  // Determine the position of the block containing the voxel, and the index of the voxel within the block. Since the blocks are
+  // 8x8x8, this can be done with shifts and masks (the shifts are arithmetic, so they round towards negative infinity).
+  const Vector3s blockPos(static_cast<short>(loc.x >> 3), static_cast<short>(loc.y >> 3), static_cast<short>(loc.z >> 3));
+  const int linearIdx = (loc.x & 7) + ((loc.y & 7) << 3) + ((loc.z & 7) << 6);
+
+  // If the block is not in the cache, look it up in the hash table and add it to the cache (replacing any block currently in its slot).
+  const int slot = PatchBlockCache::get_slot(blockPos);
+  const unsigned long long slotBit = 1ULL << slot;
+  if(!(cache.validSlots & slotBit) || cache.blockPositions[slot] != blockPos)
+  {
+    cache.blockPositions[slot] = blockPos;
+    cache.blockOffsets[slot] = find_voxel_block(blockPos, indexData);
+    cache.validSlots |= slotBit;
+    ++cache.lookupCount;
+  }
+
+  const int blockOffset = cache.blockOffsets[slot];
+  return blockOffset >= 0 ? &voxelData[blockOffset + linearIdx] : NULL;
+}
+
 /**
  * \brief Generates a unit vector that is perpendicular to the specified plane normal.
  *
@@ -176,7 +364,64 @@ inline void generate_coordinate_system(int voxelLocationIndex, const Vector3f *s
 /**
  * \brief Generates an RGB patch for the specified voxel by sampling from a regularly-spaced grid around it in its tangent plane.
  *
- * The RGB patches will be stored as the patch segments of the feature descriptors for the various voxels.
+ * The RGB patches will be stored as the patch segments of the feature descriptors for the various voxels. The voxels are read
+ * via the specified patch block cache (which is cleared first), so each voxel block touched by the patch is only looked up once.
+ *
+ * \param voxelLocationIndex  The index of the voxel for which to generate an RGB patch.
+ * \param voxelLocations      The locations of the voxels for which to generate RGB patches.
+ * \param xAxes               The x axes of the coordinate systems in the tangent planes to the surfaces at the voxel locations.
+ * \param yAxes               The y axes of the coordinate systems in the tangent planes to the surfaces at the voxel locations.
+ * \param voxelData           The scene's voxel data.
+ * \param indexData           The scene's index data.
+ * \param patchSize           The side length of a VOP patch (must be odd).
+ * \param patchSpacing        The spacing in the scene (in voxels) between individual pixels in a patch.
+ * \param featureCount        The number of features in a feature descriptor for a voxel.
+ * \param features            The feature descriptors for the various voxels (stored sequentially).
+ * \param cache               The patch block cache to use.
+ */
+_CPU_AND_GPU_CODE_
+inline void generate_rgb_patch(int voxelLocationIndex, const Vector3s *voxelLocations, const Vector3f *xAxes, const Vector3f *yAxes,
+                               const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData, size_t patchSize, float patchSpacing,
+                               size_t featureCount, float *features, PatchBlockCache& cache)
+{
+  // Get the location of the voxel at the centre of the patch.
+  Vector3f centre = voxelLocations[voxelLocationIndex].toFloat();
+
+  // Generate an RGB patch around the voxel on a patchSize * patchSize grid aligned with the voxel's x and y axes.
+  int halfPatchSize = static_cast<int>(patchSize - 1) / 2;
+  Vector3f xAxis = xAxes[voxelLocationIndex] * patchSpacing;
+  Vector3f yAxis = yAxes[voxelLocationIndex] * patchSpacing;
+  cache.clear();
+
+  // For each pixel in the patch:
+  size_t offset = voxelLocationIndex * featureCount;
+  for(int y = -halfPatchSize; y <= halfPatchSize; ++y)
+  {
+    Vector3f yLoc = centre + static_cast<float>(y) * yAxis;
+    for(int x = -halfPatchSize; x <= halfPatchSize; ++x)
+    {
+      // Compute the location of the pixel in world space.
+      Vector3i loc = (yLoc + static_cast<float>(x) * xAxis).toIntRound();
+
+      // If there is a voxel at that location, get its colour; otherwise, default to magenta.
+      Vector3u clr(255, 0, 255);
+      const SpaintVoxel *voxel = read_voxel_via_cache(loc, voxelData, indexData, cache);
+      if(voxel) clr = VoxelColourReader<SpaintVoxel::hasColorInformation>::read(*voxel);
+
+      // Write the colour values into the relevant places in the features array.
+      features[offset++] = clr.r;
+      features[offset++] = clr.g;
+      features[offset++] = clr.b;
+    }
+  }
+}
+
+/**
+ * \brief Generates an RGB patch for the specified voxel by sampling from a regularly-spaced grid around it in its tangent plane.
+ *
+ * The RGB patches will be stored as the patch segments of the feature descriptors for the various voxels. Each voxel is looked up
+ * directly in the scene, without a patch block cache (this is the version used on the GPU, where a per-thread cache would have to
+ * live in slow local memory).
  *
  * \param voxelLocationIndex  The index of the voxel for which to generate an RGB patch.
  * \param voxelLocations      The locations of the voxels for which to generate RGB patches.
@@ -226,6 +471,59 @@ inline void generate_rgb_patch(int voxelLocationIndex, const Vector3s *voxelLoca
   }
 }
 
+/**
+ * \brief Generates the specified pixels of the RGB patch for a voxel.
+ *
+ * Each pixel is sampled in exactly the same way as by generate_rgb_patch, but only the specified pixels are sampled,
+ * and their colours are written consecutively into the output array rather than into the voxel's feature descriptor.
+ *
+ * \param voxelLocationIndex  The index of the voxel for which to generate the pixels.
+ * \param voxelLocations      The locations of the voxels for which to generate RGB patches.
+ * \param xAxes               The x axes of the coordinate systems in the tangent planes to the surfaces at the voxel locations.
+ * \param yAxes               The y axes of the coordinate systems in the tangent planes to the surfaces at the voxel locations.
+ * \param voxelData           The scene's voxel data.
+ * \param indexData           The scene's index data.
+ * \param patchSize           The side length of a VOP patch (must be odd).
+ * \param patchSpacing        The spacing in the scene (in voxels) between individual pixels in a patch.
+ * \param pixelIndices        The (raster-order) indices in the patch of the pixels to generate.
+ * \param pixelCount          The number of pixels to generate.
+ * \param rgb                 The location into which to write the colours of the pixels (as interleaved RGB values).
+ * \param cache               The patch block cache to use.
+ */
+_CPU_AND_GPU_CODE_
+inline void generate_rgb_patch_pixels(int voxelLocationIndex, const Vector3s *voxelLocations, const Vector3f *xAxes, const Vector3f *yAxes,
+                                      const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData, size_t patchSize, float patchSpacing,
+                                      const int *pixelIndices, int pixelCount, float *rgb, PatchBlockCache& cache)
+{
+  // Get the location of the voxel at the centre of the patch.
+  Vector3f centre = voxelLocations[voxelLocationIndex].toFloat();
+
+  int halfPatchSize = static_cast<int>(patchSize - 1) / 2;
+  Vector3f xAxis = xAxes[voxelLocationIndex] * patchSpacing;
+  Vector3f yAxis = yAxes[voxelLocationIndex] * patchSpacing;
+  cache.clear();
+
+  // For each specified pixel:
+  for(int i = 0; i < pixelCount; ++i)
+  {
+    // Compute the location of the pixel in world space (using the same arithmetic as generate_rgb_patch).
+    int x = pixelIndices[i] % static_cast<int>(patchSize) - halfPatchSize;
+    int y = pixelIndices[i] / static_cast<int>(patchSize) - halfPatchSize;
+    Vector3f yLoc = centre + static_cast<float>(y) * yAxis;
+    Vector3i loc = (yLoc + static_cast<float>(x) * xAxis).toIntRound();
+
+    // If there is a voxel at that location, get its colour; otherwise, default to magenta.
+    Vector3u clr(255, 0, 255);
+    const SpaintVoxel *voxel = read_voxel_via_cache(loc, voxelData, indexData, cache);
+    if(voxel) clr = VoxelColourReader<SpaintVoxel::hasColorInformation>::read(*voxel);
+
+    // Write the colour values into the output array.
+    *rgb++ = clr.r;
+    *rgb++ = clr.g;
+    *rgb++ = clr.b;
+  }
+}
+
 /**
  * \brief Updates the coordinate system for a voxel to align it with the dominant orientation in the voxel's RGB patch.
  *
@@ -0,0 +1,159 @@
+/**
+ * spaint: VoxelLabelIndex.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VOXELLABELINDEX
+#define H_SPAINT_VOXELLABELINDEX
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ITMLib/Objects/ITMScene.h>
+
+#include "../util/SpaintVoxel.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class maintains a sparse, per-label index of the labelled voxels in a (CPU-based) scene.
+ *
+ * Clearing labels by sweeping the whole voxel block array costs time proportional to the capacity of the array, even when only
+ * a handful of voxels are actually labelled. The index instead records the locations of the voxels that have been labelled,
+ * so that label-clearing operations and label queries only need to visit those voxels.
+ *
+ * The index maintains the following invariant: every voxel in the scene's local voxel block array whose packed label differs
+ * from the default one appears in the location list for its current label. The lists may also contain stale entries (e.g.
+ * for voxels that have since been relabelled or cleared, or duplicates of voxels that have been marked more than once); these
+ * are filtered out whenever a list is queried, and are periodically compacted away as new entries are added, so that the size
+ * of each list stays proportional to the number of voxels that actually have its label.
+ *
+ * The invariant can only be maintained if all labelling goes through the index. Code that writes voxel labels directly (e.g.
+ * label propagation) must invalidate the index afterwards, in which case it will be rebuilt from the scene when next needed.
+ */
+class VoxelLabelIndex
+{
+  //#################### TYPEDEFS ####################
+private:
+  typedef ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> Scene;
+
+  //#################### CONSTANTS ####################
+public:
+  /** The number of distinct labels that can be indexed (labels are stored in a 6-bit field in each voxel). */
+  static const int LABEL_COUNT = 64;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The size of the location list for each label when it was last compacted. */
+  std::vector<size_t> m_compactedSizes;
+
+  /** The locations of the voxels that may currently have each label (indexed by label). */
+  std::vector<std::vector<Vector3s> > m_locations;
+
+  /** Whether or not the index is currently known to be consistent with the scene. */
+  bool m_valid;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs an empty voxel label index.
+   *
+   * The index starts out invalid, and will be rebuilt from the scene the first time it is needed.
+   */
+  VoxelLabelIndex();
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Records that a set of voxels in the scene have been marked with the specified label.
+   *
+   * \param voxelLocations  The locations of the voxels.
+   * \param voxelCount      The number of voxels.
+   * \param label           The label with which the voxels have been marked.
+   * \param scene           The scene.
+   */
+  void add_voxels(const Vector3s *voxelLocations, int voxelCount, SpaintVoxel::PackedLabel label, const Scene *scene);
+
+  /**
+   * \brief Records that a set of voxels in the scene have been marked with the specified labels.
+   *
+   * \param voxelLocations  The locations of the voxels.
+   * \param voxelLabels     The labels with which the voxels have been marked (one per voxel).
+   * \param voxelCount      The number of voxels.
+   * \param scene           The scene.
+   */
+  void add_voxels(const Vector3s *voxelLocations, const SpaintVoxel::PackedLabel *voxelLabels, int voxelCount, const Scene *scene);
+
+  /**
+   * \brief Gets the locations of the voxels in the scene that may have the specified label.
+   *
+   * The list of locations is compacted before being returned, so every voxel in the local voxel block array that currently has
+   * the label appears in it exactly once. The only other entries it can contain are for voxels that are not currently in the local
+   * voxel block array (these are kept in case the voxels are swapped back in later).
+   *
+   * \param label The label.
+   * \param scene The scene.
+   * \return      The locations of the voxels in the scene that may have the specified label.
+   */
+  const std::vector<Vector3s>& get_voxels(SpaintVoxel::Label label, const Scene *scene);
+
+  /**
+   * \brief Marks the index as no longer being consistent with the scene (e.g. because some voxel labels have been changed directly).
+   */
+  void invalidate();
+
+  /**
+   * \brief Gets whether or not the index is currently known to be consistent with the scene.
+   *
+   * \return  true, if the index is currently known to be consistent with the scene, or false otherwise.
+   */
+  bool is_valid() const;
+
+  /**
+   * \brief Rebuilds the index from scratch by scanning the allocated voxel blocks in the scene.
+   *
+   * This takes time proportional to the number of allocated voxels, rather than to the capacity of the voxel block array.
+   *
+   * \param scene The scene.
+   */
+  void rebuild(const Scene *scene);
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Compacts the location list for the specified label.
+   *
+   * Compaction removes duplicate entries, and entries for voxels that are in the local voxel block array but no longer have the label.
+   *
+   * \param label The label.
+   * \param scene The scene.
+   */
+  void compact(SpaintVoxel::Label label, const Scene *scene);
+
+  /**
+   * \brief Compacts the location list for each label that has at least doubled in size since it was last compacted.
+   *
+   * This bounds the memory used by the index, at an amortised constant cost per added entry.
+   *
+   * \param scene The scene.
+   */
+  void compact_grown_lists(const Scene *scene);
+
+  /**
+   * \brief Adds an entry for a voxel to the location list for its label (if it has a non-default label).
+   *
+   * \param loc   The location of the voxel.
+   * \param label The packed label of the voxel.
+   */
+  void record_voxel(const Vector3s& loc, SpaintVoxel::PackedLabel label);
+};
+
+//#################### TYPEDEFS ####################
+
+typedef boost::shared_ptr<VoxelLabelIndex> VoxelLabelIndex_Ptr;
+typedef boost::shared_ptr<const VoxelLabelIndex> VoxelLabelIndex_CPtr;
+
+}
+
+#endif
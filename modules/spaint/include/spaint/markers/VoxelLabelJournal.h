@@ -0,0 +1,121 @@
+/**
+ * spaint: VoxelLabelJournal.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_SPAINT_VOXELLABELJOURNAL
+#define H_SPAINT_VOXELLABELJOURNAL
+
+#include <vector>
+
+#include "../util/SpaintVoxel.h"
+
+namespace spaint {
+
+/**
+ * \brief An instance of this class stores a compact record of the voxels whose labels were changed by a marking operation,
+ *        together with their old labels, so that the operation can later be undone or redone.
+ *
+ * The voxel locations and labels are stored in two separate byte streams:
+ *
+ * - The locations are split into runs of voxels that are adjacent along the x axis (the order in which the voxel-to-cube
+ *   selection transformer emits them). Each run is stored as the (zigzag and variable-length encoded) offset of its first
+ *   voxel from the voxel that would have followed the previous run, followed by its length. A row of a brush cube thus
+ *   typically costs only a few bytes, however long it is.
+ * - The old labels are run-length encoded, each run being stored as a packed label byte followed by its length.
+ *
+ * The order of the voxels is preserved, so decoding the journal yields exactly the locations and labels from which it was built.
+ */
+class VoxelLabelJournal
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The run-length encoded old labels of the voxels. */
+  std::vector<uchar> m_labelData;
+
+  /** The delta and run-length encoded locations of the voxels. */
+  std::vector<uchar> m_locationData;
+
+  /** The number of voxels in the journal. */
+  size_t m_voxelCount;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs an empty journal.
+   */
+  VoxelLabelJournal();
+
+  /**
+   * \brief Constructs a journal recording the specified voxels and their old labels.
+   *
+   * \param voxelLocations      The locations of the voxels.
+   * \param oldLabels           The old labels of the voxels (one per voxel).
+   * \throws std::runtime_error If the numbers of voxel locations and labels differ.
+   */
+  VoxelLabelJournal(const std::vector<Vector3s>& voxelLocations, const std::vector<SpaintVoxel::PackedLabel>& oldLabels);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Decodes the journal.
+   *
+   * \param voxelLocations  A vector into which to write the locations of the voxels.
+   * \param oldLabels       A vector into which to write the old labels of the voxels (one per voxel).
+   */
+  void decode(std::vector<Vector3s>& voxelLocations, std::vector<SpaintVoxel::PackedLabel>& oldLabels) const;
+
+  /**
+   * \brief Gets the amount of memory used to store the encoded journal.
+   *
+   * \return  The amount of memory used to store the encoded journal (in bytes).
+   */
+  size_t get_memory_usage() const;
+
+  /**
+   * \brief Gets the number of voxels in the journal.
+   *
+   * \return  The number of voxels in the journal.
+   */
+  size_t get_voxel_count() const;
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Reads a variable-length encoded unsigned integer from a byte stream.
+   *
+   * \param data  The byte stream.
+   * \param pos   The position in the byte stream from which to read (updated to point just after the integer).
+   * \return      The integer.
+   */
+  static unsigned int read_varint(const std::vector<uchar>& data, size_t& pos);
+
+  /**
+   * \brief Reads a zigzag and variable-length encoded signed integer from a byte stream.
+   *
+   * \param data  The byte stream.
+   * \param pos   The position in the byte stream from which to read (updated to point just after the integer).
+   * \return      The integer.
+   */
+  static int read_zigzag(const std::vector<uchar>& data, size_t& pos);
+
+  /**
+   * \brief Writes an unsigned integer to a byte stream using a variable-length encoding (7 bits per byte, least significant bits first).
+   *
+   * \param value The integer.
+   * \param data  The byte stream.
+   */
+  static void write_varint(unsigned int value, std::vector<uchar>& data);
+
+  /**
+   * \brief Writes a signed integer to a byte stream using a zigzag encoding (so that integers of small magnitude yield short encodings).
+   *
+   * \param value The integer.
+   * \param data  The byte stream.
+   */
+  static void write_zigzag(int value, std::vector<uchar>& data);
+};
+
+}
+
+#endif
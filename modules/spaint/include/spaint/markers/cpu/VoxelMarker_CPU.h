@@ -6,6 +6,7 @@
 #ifndef H_SPAINT_VOXELMARKER_CPU
 #define H_SPAINT_VOXELMARKER_CPU
 
+#include "../VoxelLabelIndex.h"
 #include "../interface/VoxelMarker.h"
 
 namespace spaint {
@@ -15,10 +16,28 @@ namespace spaint {
  */
 class VoxelMarker_CPU : public VoxelMarker
 {
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** An optional index of the labelled voxels in the scene (if present, this is used to avoid sweeping the whole voxel block array when clearing labels). */
+  VoxelLabelIndex_Ptr m_labelIndex;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a CPU-based voxel marker.
+   *
+   * If a label index is specified, the voxel marker keeps it up to date as it marks voxels, and uses it to clear labels in time
+   * proportional to the number of labelled voxels. The index must be used for a single scene, and must only be used in scenes
+   * that do not use swapping (since voxels that are swapped out are not visible to the index when it is rebuilt).
+   *
+   * \param labelIndex  An optional index of the labelled voxels in the scene.
+   */
+  explicit VoxelMarker_CPU(const VoxelLabelIndex_Ptr& labelIndex = VoxelLabelIndex_Ptr());
+
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
   /** Override */
-  virtual void clear_labels(SpaintVoxel *voxels, int voxelCount, ClearingSettings settings) const;
+  virtual void clear_labels(ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene, ClearingSettings settings) const;
 
   /** Override */
   virtual void mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, SpaintVoxel::PackedLabel label,
@@ -32,6 +51,9 @@ public:
                            ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
                            ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> *oldVoxelLabelsMB,
                            MarkingMode mode) const;
+
+  /** Override */
+  virtual void notify_labels_changed() const;
 };
 
 }
@@ -28,13 +28,12 @@ public:
   //#################### PUBLIC ABSTRACT MEMBER FUNCTIONS ####################
 public:
   /**
-   * \brief Clears the labels of some or all of the voxels in an array, depending on the settings specified.
+   * \brief Clears the labels of some or all of the voxels in the scene, depending on the settings specified.
    *
-   * \param voxels      The array of voxels.
-   * \param voxelCount  The number of voxels in the array.
-   * \param settings    The settings to use for the label-clearing operation.
+   * \param scene     The scene.
+   * \param settings  The settings to use for the label-clearing operation.
    */
-  virtual void clear_labels(SpaintVoxel *voxels, int voxelCount, ClearingSettings settings) const = 0;
+  virtual void clear_labels(ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene, ClearingSettings settings) const = 0;
 
   /**
    * \brief Marks a set of voxels in the scene with the specified semantic label.
@@ -64,6 +63,16 @@ public:
                            ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
                            ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> *oldVoxelLabelsMB = NULL,
                            MarkingMode mode = NORMAL_MARKING) const = 0;
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Notifies the voxel marker that the labels of some voxels in the scene have been changed without its involvement
+   *        (e.g. by label propagation).
+   *
+   * By default, this does nothing. Voxel markers that keep track of which voxels in the scene are labelled should override it.
+   */
+  virtual void notify_labels_changed() const {}
 };
 
 }
@@ -6,15 +6,53 @@
 #ifndef H_SPAINT_LABELPROPAGATOR_CPU
 #define H_SPAINT_LABELPROPAGATOR_CPU
 
+#include <vector>
+
 #include "../interface/LabelPropagator.h"
 
 namespace spaint {
 
 /**
  * \brief An instance of this class can be used to propagate a specified label across surfaces in the scene using the CPU.
+ *
+ * Rather than testing every pixel in the raycast result against its neighbours each time it is run, the CPU propagator
+ * propagates incrementally. It first determines which pixels already have the label being propagated (which is cheap),
+ * and then only tests the pixels whose neighbours have the label. Each pixel that gets labelled as a result becomes part
+ * of a frontier from which propagation continues in the next sweep. This avoids the (expensive) neighbour tests for pixels
+ * that could not possibly be labelled.
+ *
+ * By default, only one sweep is performed per call, as in the CUDA propagator, so that labels spread across the scene
+ * at the same rate (one sweep per frame) on both devices. Within a sweep, each pixel is tested against the labels that
+ * were present at the start of the sweep. The CUDA propagator tests all of the pixels in parallel and may also see some
+ * of the labels marked earlier in the same sweep, so it can occasionally get slightly further in a single frame, but
+ * both propagators converge to the same labelling over successive frames (the CPU test checks this against repeated
+ * sweeps over the whole raycast result).
  */
 class LabelPropagator_CPU : public LabelPropagator
 {
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The pixels to be tested in the current iteration of propagation. */
+  mutable std::vector<int> m_candidates;
+
+  /** Flags indicating which of the candidates were marked with the label being propagated in the current iteration. */
+  mutable std::vector<unsigned char> m_candidatesMarked;
+
+  /** The pixels that were labelled in the most recent iteration of propagation. */
+  mutable std::vector<int> m_frontier;
+
+  /** Flags indicating which pixels in the raycast result have voxels that are marked with the label being propagated. */
+  mutable std::vector<unsigned char> m_labelled;
+
+  /** The maximum number of sweeps to perform each time the propagator is run. */
+  const int m_maxSweepsPerCall;
+
+  /** The locations of the voxels corresponding to the pixels in the raycast result. */
+  mutable std::vector<Vector3s> m_pixelVoxelLocations;
+
+  /** The iteration in which each pixel was most recently made a candidate (used to avoid testing pixels more than once per iteration). */
+  mutable std::vector<int> m_queuedIterations;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
@@ -24,17 +62,54 @@ public:
    * \param maxAngleBetweenNormals            The largest angle allowed between the normals of neighbouring voxels if propagation is to occur.
    * \param maxSquaredDistanceBetweenColours  The maximum squared distance allowed between the colours of neighbouring voxels if propagation is to occur.
    * \param maxSquaredDistanceBetweenVoxels   The maximum squared distance allowed between the positions of neighbouring voxels if propagation is to occur.
+   * \param maxSweepsPerCall                  The maximum number of sweeps to perform each time the propagator is run (INT_MAX propagates until no more pixels can be labelled).
    */
-  LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels);
+  LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels,
+                      int maxSweepsPerCall = 1);
 
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
   /** Override */
   virtual void calculate_normals(const ITMFloat4Image *raycastResult, const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene) const;
 
+  /**
+   * \brief Determines whether or not the specified pixel has labelled neighbours from which the label being propagated could potentially be propagated.
+   *
+   * A pixel can only be labelled via propagation if both its neighbours at distances 2 and 5 in at least one direction are labelled.
+   *
+   * \param x       The x coordinate of the pixel.
+   * \param y       The y coordinate of the pixel.
+   * \param width   The width of the raycast result.
+   * \param height  The height of the raycast result.
+   * \return        true, if the pixel has suitable labelled neighbours, or false otherwise.
+   */
+  bool has_labelled_neighbours(int x, int y, int width, int height) const;
+
+  /**
+   * \brief Determines whether or not the specified pixel is labelled.
+   *
+   * \param x       The x coordinate of the pixel.
+   * \param y       The y coordinate of the pixel.
+   * \param width   The width of the raycast result.
+   * \param height  The height of the raycast result.
+   * \return        true, if the pixel is within the raycast result and is labelled, or false otherwise.
+   */
+  bool is_labelled(int x, int y, int width, int height) const;
+
   /** Override */
   virtual void perform_propagation(SpaintVoxel::Label label, const ITMFloat4Image *raycastResult,
                                    ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene) const;
+
+  /**
+   * \brief Makes the specified pixel a candidate for the next iteration of propagation if it could potentially be labelled.
+   *
+   * \param x         The x coordinate of the pixel.
+   * \param y         The y coordinate of the pixel.
+   * \param width     The width of the raycast result.
+   * \param height    The height of the raycast result.
+   * \param iteration The index of the next iteration.
+   */
+  void try_add_candidate(int x, int y, int width, int height, int iteration) const;
 };
 
 }
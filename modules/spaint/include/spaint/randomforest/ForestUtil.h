@@ -22,12 +22,15 @@ struct ForestUtil
   /**
    * \brief Makes rafl feature descriptors from feature descriptors that are stored implicitly and contiguously in an InfiniTAM memory block.
    *
+   * The descriptors are written into the rows of a descriptor arena. If the same arena is reused each frame, this does not allocate any memory
+   * once the arena has grown to the necessary size.
+   *
    * \param featuresMB      The InfiniTAM memory block containing the feature descriptors.
    * \param descriptorCount The number of feature descriptors that are stored in the memory block.
    * \param featureCount    The number of features in a feature descriptor.
-   * \return                The rafl feature descriptors.
+   * \param descriptorArena The arena into which to write the rafl feature descriptors.
    */
-  static std::vector<rafl::Descriptor_CPtr> make_descriptors(const ORUtils::MemoryBlock<float>& featuresMB, size_t descriptorCount, size_t featureCount);
+  static void make_descriptors(const ORUtils::MemoryBlock<float>& featuresMB, size_t descriptorCount, size_t featureCount, rafl::DescriptorArena& descriptorArena);
 
   /**
    * \brief Makes rafl examples from feature descriptors that are stored implicitly and contiguously in an InfiniTAM memory block.
@@ -37,6 +40,10 @@ struct ForestUtil
    * segment i, the first descriptorCounts[i] (<= maxDescriptorsPerLabel) feature descriptors are valid and can be used to make
    * examples. Each feature descriptor in segment i is assigned label i when making examples.
    *
+   * Note: Unlike the descriptors made for prediction, the descriptors for the examples are deliberately not stored in a shared arena.
+   *       The examples end up in the reservoirs of the forest, where they can live for a long time, and a single surviving example
+   *       would otherwise keep the arena for an entire frame alive.
+   *
    * \param featuresMB              The InfiniTAM memory block containing the feature descriptors.
    * \param descriptorCountsMB      An InfiniTAM memory block containing the numbers of descriptors in each label segment that are valid.
    * \param featureCount            The number of features in a feature descriptor.
@@ -16,7 +16,7 @@ namespace tvgutil {
 
 //#################### FORWARD DECLARATIONS ####################
 
-class RandomNumberGenerator;
+class ThreadLocalRNG;
 
 }
 
@@ -44,8 +44,8 @@ protected:
   /** The size of the raycast result (in pixels). */
   const int m_raycastResultSize;
 
-  /** A random number generator. */
-  boost::shared_ptr<tvgutil::RandomNumberGenerator> m_rng;
+  /** A random number generator with a fixed number of streams, one for each chunk of the work (this avoids contention when sampling in parallel). */
+  boost::shared_ptr<tvgutil::ThreadLocalRNG> m_rng;
 
   /**
    * A memory block in which to store the prefix sums for the voxel masks. These are used to determine the locations in the
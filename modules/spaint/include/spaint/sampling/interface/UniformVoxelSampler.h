@@ -16,7 +16,7 @@ namespace tvgutil {
 
 //#################### FORWARD DECLARATIONS ####################
 
-class RandomNumberGenerator;
+class ThreadLocalRNG;
 
 }
 
@@ -32,8 +32,8 @@ protected:
   /** The size of the raycast result (in pixels). */
   const int m_raycastResultSize;
 
-  /** A random number generator. */
-  boost::shared_ptr<tvgutil::RandomNumberGenerator> m_rng;
+  /** A random number generator with a fixed number of streams, one for each chunk of the work (this avoids contention when sampling in parallel). */
+  boost::shared_ptr<tvgutil::ThreadLocalRNG> m_rng;
 
   /** A memory block in which to store the indices of the voxels to be sampled from the raycast result. */
   boost::shared_ptr<ORUtils::MemoryBlock<int> > m_sampledVoxelIndicesMB;
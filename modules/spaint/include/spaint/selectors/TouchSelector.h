@@ -6,6 +6,8 @@
 #ifndef H_SPAINT_TOUCHSELECTOR
 #define H_SPAINT_TOUCHSELECTOR
 
+#include <boost/function.hpp>
+
 #include <Eigen/Dense>
 
 #include <ITMLib/Objects/ITMTrackingState.h>
@@ -31,9 +33,11 @@ private:
   typedef boost::shared_ptr<const ITMUChar4Image> ITMUChar4Image_CPtr;
   typedef boost::shared_ptr<TouchDetector> TouchDetector_Ptr;
   typedef boost::shared_ptr<ITMTrackingState> TrackingState_Ptr;
-  typedef boost::shared_ptr<ITMView> View_Ptr;
   typedef boost::shared_ptr<const ITMView> View_CPtr;
 
+public:
+  typedef boost::function<View_CPtr()> ViewProvider;
+
   //#################### PRIVATE VARIABLES ####################
 private:
   /** The number of touch points that were kept in the most recent update. */
@@ -57,8 +61,11 @@ private:
   /** The tracking state. */
   TrackingState_Ptr m_trackingState;
 
-  /** The view. */
-  View_Ptr m_view;
+  /**
+   * A function that can be used to get the current view (this contains the raw depth image). Note that the view must not be cached,
+   * since the pipeline hands out a different view each frame and can only reuse a view once nothing else is holding on to it.
+   */
+  ViewProvider m_viewProvider;
 
   //#################### CONSTRUCTORS ####################
 public:
@@ -68,11 +75,11 @@ public:
    * \param itmSettings         The settings to use for InfiniTAM.
    * \param touchSettings       The settings to use for the touch detector.
    * \param trackingState       The InfiniTAM tracking state (contains the camera pose).
-   * \param view                The InfiniTAM view (contains the raw depth image).
+   * \param viewProvider        A function that can be used to get the current InfiniTAM view (contains the raw depth image).
    * \param maxKeptTouchPoints  The maximum number of touch points that we should keep in a single update (we limit this for performance reasons).
    */
   TouchSelector(const ITMSettings_CPtr& itmSettings, const TouchSettings_Ptr& touchSettings, const TrackingState_Ptr& trackingState,
-                const View_Ptr& view, size_t maxKeptTouchPoints);
+                const ViewProvider& viewProvider, size_t maxKeptTouchPoints);
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
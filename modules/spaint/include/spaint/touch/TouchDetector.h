@@ -11,7 +11,7 @@
 #include <ITMLib/Objects/ITMRenderState.h>
 #include <ITMLib/Utils/ITMLibSettings.h>
 
-#include <rafl/core/RandomForest.h>
+#include <rafl/core/CompiledForest.h>
 
 #include <rigging/SimpleCamera.h>
 
@@ -39,8 +39,8 @@ private:
   typedef boost::shared_ptr<const ITMLib::Objects::ITMRenderState> RenderState_CPtr;
   typedef boost::shared_ptr<const ITMLibSettings> ITMSettings_CPtr;
   typedef int Label;
-  typedef rafl::RandomForest<Label> RF;
-  typedef boost::shared_ptr<RF> RF_Ptr;
+  typedef rafl::CompiledForest<Label> CF;
+  typedef boost::shared_ptr<const CF> CF_CPtr;
   typedef boost::shared_ptr<const ITMView> View_CPtr;
 
   //#################### PRIVATE DEBUGGING VARIABLES ####################
@@ -71,8 +71,8 @@ private:
   /** An image in which each pixel is the absolute difference between the raw depth image and the depth raycast. */
   AFArray_Ptr m_diffRawRaycast;
 
-  /** The random forest used to score the candidate connected components. */
-  RF_Ptr m_forest;
+  /** The (compiled) random forest used to score the candidate connected components. */
+  CF_CPtr m_forest;
 
   /** The height of the images on which the touch detector is running. */
   int m_imageHeight;
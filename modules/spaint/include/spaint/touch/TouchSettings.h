@@ -7,7 +7,7 @@
 
 #include <boost/filesystem.hpp>
 
-#include <rafl/core/RandomForest.h>
+#include <rafl/core/CompiledForest.h>
 
 namespace spaint {
 
@@ -19,12 +19,17 @@ class TouchSettings
   //#################### TYPEDEFS ####################
 private:
   typedef int Label;
+  typedef rafl::CompiledForest<Label> CF;
+  typedef boost::shared_ptr<const CF> CF_CPtr;
   typedef rafl::RandomForest<Label> RF;
   typedef boost::shared_ptr<RF> RF_Ptr;
 
   //#################### PRIVATE VARIABLES ####################
 private:
-  /** The full path to the file containing the random forest used to filter touch regions. */
+  /**
+   * The full path to the file containing the random forest used to filter touch regions. This can either be a forest
+   * saved using Boost serialization, or (if it has the extension .rfb) a binary model saved by a compiled forest.
+   */
   boost::filesystem::path fullForestPath;
 
   /** A flag indicating whether or not to save images of the candidate connected components. */
@@ -71,13 +76,14 @@ public:
   const std::string& get_save_candidate_components_path() const;
 
   /**
-   * \brief Loads a random forest from the file specified by the forest path.
+   * \brief Loads a random forest from the file specified by the forest path, and compiles it for fast prediction.
    *
+   * If the file is a binary model (with the extension .rfb), it is mapped into memory rather than being deserialized and compiled.
    * The loading is done in TouchSettings rather than TouchDetector to work around a weird compiler bug.
    *
-   * \return  The random forest that has been loaded.
+   * \return  The compiled random forest that has been loaded.
    */
-  RF_Ptr load_forest() const;
+  CF_CPtr load_forest() const;
 
   /**
    * \brief Gets whether or not to save images of the candidate connected components.
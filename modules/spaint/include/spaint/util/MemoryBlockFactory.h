@@ -52,6 +52,25 @@ public:
     return boost::shared_ptr<ORUtils::MemoryBlock<T> >(new ORUtils::MemoryBlock<T>(dataSize, true, allocateGPU));
   }
 
+  /**
+   * \brief Makes a copy of the specified memory block whose contents are guaranteed to be up to date on the CPU.
+   *
+   * \param source The memory block to copy.
+   * \return       The copy.
+   */
+  template <typename T>
+  boost::shared_ptr<ORUtils::MemoryBlock<T> > make_block_copy(const ORUtils::MemoryBlock<T>& source) const
+  {
+    boost::shared_ptr<ORUtils::MemoryBlock<T> > copy = make_block<T>(source.dataSize);
+    if(m_deviceType == ITMLibSettings::DEVICE_CUDA)
+    {
+      copy->SetFrom(&source, ORUtils::MemoryBlock<T>::CUDA_TO_CUDA);
+      copy->UpdateHostFromDevice();
+    }
+    else copy->SetFrom(&source, ORUtils::MemoryBlock<T>::CPU_TO_CPU);
+    return copy;
+  }
+
   /**
    * \brief Sets the type of device on which the memory blocks made by the factory will primarily be used.
    *
@@ -5,6 +5,8 @@
 
 #include "features/FeatureCalculatorFactory.h"
 
+#include "features/FeatureSubsetCalculator.h"
+#include "features/MultiScaleVOPFeatureCalculator.h"
 #include "features/cpu/VOPFeatureCalculator_CPU.h"
 
 #ifdef WITH_CUDA
@@ -15,14 +17,38 @@ namespace spaint {
 
 //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
 
+FeatureCalculator_CPtr FeatureCalculatorFactory::make_feature_subset_calculator(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount,
+                                                                                const std::vector<size_t>& featureIndices, ITMLibSettings::DeviceType deviceType)
+{
+  if(deviceType == ITMLibSettings::DEVICE_CUDA)
+  {
+    throw std::runtime_error("Error: Feature subset calculation is not currently supported on CUDA.");
+  }
+
+  return FeatureCalculator_CPtr(new FeatureSubsetCalculator(maxVoxelLocationCount, patchSize, patchSpacing, binCount, featureIndices));
+}
+
+FeatureCalculator_CPtr FeatureCalculatorFactory::make_multiscale_vop_feature_calculator(size_t maxVoxelLocationCount, size_t patchSize, const std::vector<float>& patchSpacings,
+                                                                                        size_t binCount, ITMLibSettings::DeviceType deviceType)
+{
+  if(deviceType == ITMLibSettings::DEVICE_CUDA)
+  {
+    throw std::runtime_error("Error: Multi-scale VOP feature calculation is not currently supported on CUDA.");
+  }
+
+  return FeatureCalculator_CPtr(new MultiScaleVOPFeatureCalculator(maxVoxelLocationCount, patchSize, patchSpacings, binCount));
+}
+
 FeatureCalculator_CPtr FeatureCalculatorFactory::make_vop_feature_calculator(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount,
-                                                                             ITMLibSettings::DeviceType deviceType)
+                                                                             ITMLibSettings::DeviceType deviceType, const VOPFeatureCache_Ptr& cache,
+                                                                             VOPFeatureKernels_CPU::InstructionSet instructionSet)
 {
   FeatureCalculator_CPtr calculator;
 
   if(deviceType == ITMLibSettings::DEVICE_CUDA)
   {
 #ifdef WITH_CUDA
+    if(cache) throw std::runtime_error("Error: Feature caching is not currently supported by the CUDA implementation of the VOP feature calculator.");
     calculator.reset(new VOPFeatureCalculator_CUDA(maxVoxelLocationCount, patchSize, patchSpacing, binCount));
 #else
     throw std::runtime_error("Error: CUDA support not currently available. Reconfigure in CMake with the WITH_CUDA option set to on.");
@@ -30,7 +56,7 @@ FeatureCalculator_CPtr FeatureCalculatorFactory::make_vop_feature_calculator(siz
   }
   else
   {
-    calculator.reset(new VOPFeatureCalculator_CPU(maxVoxelLocationCount, patchSize, patchSpacing, binCount));
+    calculator.reset(new VOPFeatureCalculator_CPU(maxVoxelLocationCount, patchSize, patchSpacing, binCount, cache, instructionSet));
   }
 
   return calculator;
@@ -0,0 +1,160 @@
+/**
+ * spaint: FeatureSubsetCalculator.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "features/FeatureSubsetCalculator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+
+#include "features/shared/VOPFeatureCalculator_Shared.h"
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+FeatureSubsetCalculator::FeatureSubsetCalculator(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount, const std::vector<size_t>& featureIndices)
+: m_baseFeatureCalculator(maxVoxelLocationCount, patchSize, patchSpacing, binCount),
+  m_featureIndices(featureIndices),
+  m_paddedVectorisedPixelCount(0),
+  m_patchSize(patchSize),
+  m_patchSpacing(patchSpacing)
+{
+  std::sort(m_featureIndices.begin(), m_featureIndices.end());
+  m_featureIndices.erase(std::unique(m_featureIndices.begin(), m_featureIndices.end()), m_featureIndices.end());
+  if(!m_featureIndices.empty() && m_featureIndices.back() >= get_feature_count())
+  {
+    throw std::runtime_error("Error: A feature index is out of range for a VOP feature descriptor");
+  }
+
+  // Determine which patch pixels are needed, and divide them up according to whether an ordinary VOP feature calculator
+  // would convert them to CIELab using the vectorised code or the scalar code, so that we can reproduce their values exactly.
+  const int patchArea = static_cast<int>(patchSize * patchSize);
+  const int vectorWidth = m_kernels.get_vector_width();
+  const int vectorisedLimit = patchArea - patchArea % vectorWidth;
+  std::vector<int> vectorisedPixels, scalarPixels;
+  for(size_t i = 0, size = m_featureIndices.size(); i < size && m_featureIndices[i] < static_cast<size_t>(patchArea * 3); ++i)
+  {
+    int pixelIndex = static_cast<int>(m_featureIndices[i] / 3);
+    std::vector<int>& pixels = pixelIndex < vectorisedLimit ? vectorisedPixels : scalarPixels;
+    if(pixels.empty() || pixels.back() != pixelIndex) pixels.push_back(pixelIndex);
+  }
+
+  // Pad the vectorised pixels to a whole number of vectors, so that they are all converted using the vectorised code.
+  m_pixelIndices = vectorisedPixels;
+  while(m_pixelIndices.size() % vectorWidth != 0) m_pixelIndices.push_back(vectorisedPixels[0]);
+  m_paddedVectorisedPixelCount = static_cast<int>(m_pixelIndices.size());
+  m_pixelIndices.insert(m_pixelIndices.end(), scalarPixels.begin(), scalarPixels.end());
+
+  // Record where in the buffer of gathered pixels each patch feature in the subset will end up.
+  for(size_t i = 0, size = m_featureIndices.size(); i < size && m_featureIndices[i] < static_cast<size_t>(patchArea * 3); ++i)
+  {
+    int featureIndex = static_cast<int>(m_featureIndices[i]);
+    int position = static_cast<int>(std::find(m_pixelIndices.begin(), m_pixelIndices.end(), featureIndex / 3) - m_pixelIndices.begin());
+    m_patchFeatureOffsets.push_back(std::make_pair(featureIndex, position * 3 + featureIndex % 3));
+  }
+
+  m_surfaceNormals.resize(maxVoxelLocationCount);
+  m_tileOrder.reserve(maxVoxelLocationCount);
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void FeatureSubsetCalculator::calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+                                                 const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                                 ORUtils::MemoryBlock<float>& featuresMB) const
+{
+  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
+  const size_t featureCount = get_feature_count();
+  float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
+  const ITMVoxelIndex::IndexData *indexData = scene->index.getIndexData();
+  const int patchFeatureCount = static_cast<int>(m_patchSize * m_patchSize * 3);
+  const int pixelCount = static_cast<int>(m_pixelIndices.size());
+  const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+  const Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+
+  // Determine which of the non-patch features (the surface normal and the height) are not in the subset, and will need to be cleared.
+  bool normalNeeded = false;
+  std::vector<size_t> unusedNonPatchFeatures;
+  for(size_t f = patchFeatureCount; f < featureCount; ++f)
+  {
+    if(std::binary_search(m_featureIndices.begin(), m_featureIndices.end(), f))
+    {
+      if(f + 1 < featureCount) normalNeeded = true;
+    }
+    else unusedNonPatchFeatures.push_back(f);
+  }
+
+  // If the subset contains any patch features, generate a coordinate system for each voxel and align it with the dominant orientation
+  // of the voxel's patch. This also writes the surface normals and the unrotated patches into the feature descriptors.
+  if(pixelCount > 0) m_baseFeatureCalculator.align_coordinate_systems(voxelLocationsMB, voxelLocationCount, scene, featuresMB);
+
+  const Vector3f *xAxes = m_baseFeatureCalculator.get_x_axes().GetData(MEMORYDEVICE_CPU);
+  const Vector3f *yAxes = m_baseFeatureCalculator.get_y_axes().GetData(MEMORYDEVICE_CPU);
+
+  // Sort the voxels into spatially-coherent tiles, so that consecutive voxels mostly read from the same voxel blocks.
+  make_tile_order(voxelLocations, voxelLocationCount, m_tileOrder);
+
+  // For each voxel, gather the pixels of its oriented patch that are needed and convert them to CIELab, then write the features
+  // in the subset into the voxel's descriptor and clear all of the others.
+#ifdef WITH_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std::vector<float> rgb(pixelCount * 3);
+
+#ifdef WITH_OPENMP
+    #pragma omp for
+#endif
+    for(int i = 0; i < voxelLocationCount; ++i)
+    {
+      const int voxelLocationIndex = m_tileOrder[i].second;
+      float *descriptor = features + voxelLocationIndex * featureCount;
+
+      if(pixelCount > 0)
+      {
+        PatchBlockCache cache;
+        generate_rgb_patch_pixels(voxelLocationIndex, voxelLocations, xAxes, yAxes, voxelData, indexData, m_patchSize, m_patchSpacing, &m_pixelIndices[0], pixelCount, &rgb[0], cache);
+        m_kernels.convert_patch_to_lab(&rgb[0], m_paddedVectorisedPixelCount);
+        m_kernels.convert_patch_to_lab(&rgb[m_paddedVectorisedPixelCount * 3], pixelCount - m_paddedVectorisedPixelCount);
+      }
+      else if(normalNeeded)
+      {
+        write_surface_normal(voxelLocationIndex, voxelLocations, voxelData, indexData, &m_surfaceNormals[0], featureCount, features);
+      }
+
+      std::fill(descriptor, descriptor + patchFeatureCount, 0.0f);
+      for(size_t j = 0, size = m_patchFeatureOffsets.size(); j < size; ++j)
+      {
+        descriptor[m_patchFeatureOffsets[j].first] = rgb[m_patchFeatureOffsets[j].second];
+      }
+
+      fill_in_height(voxelLocationIndex, voxelLocations, featureCount, features);
+      for(size_t j = 0, size = unusedNonPatchFeatures.size(); j < size; ++j)
+      {
+        descriptor[unusedNonPatchFeatures[j]] = 0.0f;
+      }
+    }
+  }
+}
+
+size_t FeatureSubsetCalculator::get_feature_count() const
+{
+  // The descriptors have the same layout as ordinary VOP descriptors.
+  return m_baseFeatureCalculator.get_feature_count();
+}
+
+const std::vector<size_t>& FeatureSubsetCalculator::get_feature_indices() const
+{
+  return m_featureIndices;
+}
+
+size_t FeatureSubsetCalculator::get_gathered_pixel_count() const
+{
+  return m_pixelIndices.size();
+}
+
+}
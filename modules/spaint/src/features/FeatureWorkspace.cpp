@@ -0,0 +1,73 @@
+/**
+ * spaint: FeatureWorkspace.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "features/FeatureWorkspace.h"
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/** The number of floats in a cache line. */
+const size_t FLOATS_PER_CACHE_LINE = 64 / sizeof(float);
+
+}
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+FeatureWorkspace::FeatureWorkspace(size_t patchSize, size_t binCount, size_t threadCount)
+: m_binCount(binCount), m_patchArea(patchSize * patchSize)
+{
+  if(threadCount == 0)
+  {
+#ifdef WITH_OPENMP
+    threadCount = static_cast<size_t>(omp_get_max_threads());
+#else
+    threadCount = 1;
+#endif
+  }
+
+  // Round the storage for each thread up to a whole number of cache lines.
+  const size_t threadSize = m_patchArea + m_binCount;
+  m_threadStride = (threadSize + FLOATS_PER_CACHE_LINE - 1) / FLOATS_PER_CACHE_LINE * FLOATS_PER_CACHE_LINE;
+  m_buffer.resize(threadCount * m_threadStride);
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+float *FeatureWorkspace::get_histogram()
+{
+  return get_thread_storage() + m_patchArea;
+}
+
+float *FeatureWorkspace::get_intensity_patch()
+{
+  return get_thread_storage();
+}
+
+int FeatureWorkspace::get_thread_count() const
+{
+  return static_cast<int>(m_buffer.size() / m_threadStride);
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+float *FeatureWorkspace::get_thread_storage()
+{
+#ifdef WITH_OPENMP
+  const size_t threadIndex = static_cast<size_t>(omp_get_thread_num());
+#else
+  const size_t threadIndex = 0;
+#endif
+
+  return &m_buffer[threadIndex * m_threadStride];
+}
+
+}
@@ -0,0 +1,95 @@
+/**
+ * spaint: MultiScaleVOPFeatureCalculator.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "features/MultiScaleVOPFeatureCalculator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+
+#include "features/shared/VOPFeatureCalculator_Shared.h"
+#include "util/MemoryBlockFactory.h"
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+MultiScaleVOPFeatureCalculator::MultiScaleVOPFeatureCalculator(size_t maxVoxelLocationCount, size_t patchSize, const std::vector<float>& patchSpacings, size_t binCount)
+: m_baseFeatureCalculator(maxVoxelLocationCount, patchSize, patchSpacings.empty() ? 0.0f : patchSpacings[0], binCount),
+  m_patchSize(patchSize),
+  m_patchSpacings(patchSpacings)
+{
+  if(patchSpacings.empty()) throw std::runtime_error("Error: A multi-scale VOP feature calculator needs at least one patch spacing");
+
+  m_baseFeaturesMB = MemoryBlockFactory::instance().make_block<float>(maxVoxelLocationCount * m_baseFeatureCalculator.get_feature_count());
+  m_tileOrder.reserve(maxVoxelLocationCount);
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void MultiScaleVOPFeatureCalculator::calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+                                                        const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                                        ORUtils::MemoryBlock<float>& featuresMB) const
+{
+  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
+
+  // Generate a coordinate system for each voxel and align it with the dominant orientation of the voxel's patch at the first scale.
+  // This also writes the surface normals into the single-scale feature descriptors, from where they can be copied below.
+  m_baseFeatureCalculator.align_coordinate_systems(voxelLocationsMB, voxelLocationCount, scene, *m_baseFeaturesMB);
+
+  const size_t baseFeatureCount = m_baseFeatureCalculator.get_feature_count();
+  const float *baseFeatures = m_baseFeaturesMB->GetData(MEMORYDEVICE_CPU);
+  const size_t featureCount = get_feature_count();
+  float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
+  const ITMVoxelIndex::IndexData *indexData = scene->index.getIndexData();
+  const int patchArea = static_cast<int>(m_patchSize * m_patchSize);
+  const int scaleCount = static_cast<int>(m_patchSpacings.size());
+  const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+  const Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+  const Vector3f *xAxes = m_baseFeatureCalculator.get_x_axes().GetData(MEMORYDEVICE_CPU);
+  const Vector3f *yAxes = m_baseFeatureCalculator.get_y_axes().GetData(MEMORYDEVICE_CPU);
+
+  // Sort the voxels into spatially-coherent tiles, so that consecutive patches mostly read from the same voxel blocks.
+  make_tile_order(voxelLocations, voxelLocationCount, m_tileOrder);
+
+  // For each voxel, read an oriented RGB patch at each scale into the corresponding segment of its descriptor, convert
+  // the patches to CIELab, and then fill in the surface normal and the height of the voxel as for a single-scale descriptor.
+  // Note that generate_rgb_patch writes to the start of a voxel's descriptor, so we offset the features array for each scale.
+#ifdef WITH_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < voxelLocationCount; ++i)
+  {
+    const int voxelLocationIndex = m_tileOrder[i].second;
+    float *descriptor = features + voxelLocationIndex * featureCount;
+    PatchBlockCache cache;
+
+    for(int scale = 0; scale < scaleCount; ++scale)
+    {
+      float *scaleFeatures = features + scale * patchArea * 3;
+      generate_rgb_patch(voxelLocationIndex, voxelLocations, xAxes, yAxes, voxelData, indexData, m_patchSize, m_patchSpacings[scale], featureCount, scaleFeatures, cache);
+      m_kernels.convert_patch_to_lab(descriptor + scale * patchArea * 3, patchArea);
+    }
+
+    const float *baseNormal = baseFeatures + (voxelLocationIndex + 1) * baseFeatureCount - 4;
+    std::copy(baseNormal, baseNormal + 3, descriptor + featureCount - 4);
+    fill_in_height(voxelLocationIndex, voxelLocations, featureCount, features);
+  }
+}
+
+size_t MultiScaleVOPFeatureCalculator::get_feature_count() const
+{
+  // A feature vector consists of a patch of CIELab colour values for each scale, the surface normal,
+  // and the height of the voxel in the scene.
+  return m_patchSpacings.size() * m_patchSize * m_patchSize * 3 + 3 + 1;
+}
+
+size_t MultiScaleVOPFeatureCalculator::get_scale_count() const
+{
+  return m_patchSpacings.size();
+}
+
+}
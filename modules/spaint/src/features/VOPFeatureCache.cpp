@@ -0,0 +1,165 @@
+/**
+ * spaint: VOPFeatureCache.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "features/VOPFeatureCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+VOPFeatureCache::VOPFeatureCache(size_t capacity, int weightTolerance, size_t maxAge)
+: m_batchIndex(0),
+  m_capacity(capacity),
+  m_computationTime(0),
+  m_computedCount(0),
+  m_entries(capacity),
+  m_featureCount(0),
+  m_hitCount(0),
+  m_lookupCount(0),
+  m_maxAge(maxAge),
+  m_nextSlot(0),
+  m_weightTolerance(weightTolerance)
+{
+  m_slots.rehash(capacity);
+  clear();
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VOPFeatureCache::clear()
+{
+  for(size_t i = 0; i < m_capacity; ++i)
+  {
+    m_entries[i].used = false;
+  }
+
+  m_nextSlot = 0;
+  m_slots.clear();
+}
+
+double VOPFeatureCache::get_hit_rate() const
+{
+  return m_lookupCount > 0 ? static_cast<double>(m_hitCount) / m_lookupCount : 0.0;
+}
+
+const float *VOPFeatureCache::lookup(const Vector3s& voxelLocation, const SpaintVoxel& voxel)
+{
+  ++m_lookupCount;
+
+  boost::unordered_map<long long,size_t,KeyHasher>::const_iterator it = m_slots.find(make_key(voxelLocation));
+  if(it == m_slots.end()) return NULL;
+
+  // If the voxel's feature descriptor is too old, or the voxel's weights have changed too much since the descriptor was calculated,
+  // the descriptor is no longer valid.
+  const Entry& entry = m_entries[it->second];
+  if(m_batchIndex - entry.batchIndex > m_maxAge) return NULL;
+  if(abs(voxel.w_depth - entry.depthWeight) > m_weightTolerance) return NULL;
+  if(abs(get_colour_weight(voxel) - entry.colourWeight) > m_weightTolerance) return NULL;
+
+  ++m_hitCount;
+  return &m_features[it->second * m_featureCount];
+}
+
+void VOPFeatureCache::output_statistics(std::ostream& os) const
+{
+  os << "VOP Feature Cache: " << m_hitCount << '/' << m_lookupCount << " hits (" << get_hit_rate() * 100.0 << "%)";
+  if(m_computedCount > 0)
+  {
+    const double averageComputationTime = static_cast<double>(m_computationTime.count()) / m_computedCount;
+    os << ", ~" << static_cast<long long>(m_hitCount * averageComputationTime) / 1000 << "ms saved";
+  }
+  os << '\n';
+}
+
+void VOPFeatureCache::record_computation(size_t computedCount, const boost::chrono::microseconds& computationTime)
+{
+  m_computedCount += computedCount;
+  m_computationTime += computationTime;
+}
+
+void VOPFeatureCache::set_feature_count(size_t featureCount)
+{
+  clear();
+  m_featureCount = featureCount;
+  m_features.resize(m_capacity * featureCount);
+}
+
+void VOPFeatureCache::start_batch()
+{
+  ++m_batchIndex;
+}
+
+void VOPFeatureCache::store(const Vector3s& voxelLocation, const SpaintVoxel& voxel, const float *features)
+{
+  if(m_capacity == 0 || m_featureCount == 0) return;
+
+  // Find the slot to use: if the voxel already has one, reuse it; otherwise, evict the oldest entry in the cache.
+  const long long key = make_key(voxelLocation);
+  size_t slot;
+  boost::unordered_map<long long,size_t,KeyHasher>::const_iterator it = m_slots.find(key);
+  if(it != m_slots.end())
+  {
+    slot = it->second;
+  }
+  else
+  {
+    slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % m_capacity;
+    if(m_entries[slot].used) m_slots.erase(m_entries[slot].key);
+    m_slots.insert(std::make_pair(key, slot));
+  }
+
+  // Record the current batch and the voxel's current weights, and copy its feature descriptor into the slot.
+  Entry& entry = m_entries[slot];
+  entry.batchIndex = m_batchIndex;
+  entry.key = key;
+  entry.colourWeight = get_colour_weight(voxel);
+  entry.depthWeight = voxel.w_depth;
+  entry.used = true;
+  std::copy(features, features + m_featureCount, &m_features[slot * m_featureCount]);
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+int VOPFeatureCache::get_colour_weight(const SpaintVoxel& voxel)
+{
+#ifndef USE_LOW_POWER_MODE
+  return voxel.w_color;
+#else
+  return 0;
+#endif
+}
+
+long long VOPFeatureCache::make_key(const Vector3s& voxelLocation)
+{
+  return (static_cast<long long>(static_cast<unsigned short>(voxelLocation.x)) << 32) |
+         (static_cast<long long>(static_cast<unsigned short>(voxelLocation.y)) << 16) |
+         static_cast<long long>(static_cast<unsigned short>(voxelLocation.z));
+}
+
+//#################### HASHING ####################
+
+size_t VOPFeatureCache::KeyHasher::operator()(long long key) const
+{
+  // Unpack the voxel location from the key.
+  const int x = static_cast<short>((key >> 32) & 0xffff);
+  const int y = static_cast<short>((key >> 16) & 0xffff);
+  const int z = static_cast<short>(key & 0xffff);
+
+  // Determine the position of the voxel block containing the voxel (rounding towards negative infinity), and the voxel's offset within it.
+  const int blockX = (x < 0 ? x - SDF_BLOCK_SIZE + 1 : x) / SDF_BLOCK_SIZE;
+  const int blockY = (y < 0 ? y - SDF_BLOCK_SIZE + 1 : y) / SDF_BLOCK_SIZE;
+  const int blockZ = (z < 0 ? z - SDF_BLOCK_SIZE + 1 : z) / SDF_BLOCK_SIZE;
+  const size_t offset = (x - blockX * SDF_BLOCK_SIZE) + (y - blockY * SDF_BLOCK_SIZE) * SDF_BLOCK_SIZE + (z - blockZ * SDF_BLOCK_SIZE) * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+
+  // Hash the block position in the same way as InfiniTAM, and combine the result with the voxel's offset within the block.
+  const size_t blockHash = ((unsigned int)blockX * 73856093u) ^ ((unsigned int)blockY * 19349669u) ^ ((unsigned int)blockZ * 83492791u);
+  return blockHash * SDF_BLOCK_SIZE3 + offset;
+}
+
+}
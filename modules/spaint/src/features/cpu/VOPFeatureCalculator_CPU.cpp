@@ -5,23 +5,107 @@
 
 #include "features/cpu/VOPFeatureCalculator_CPU.h"
 
-#include <vector>
+#include <algorithm>
+
+#include <boost/chrono/chrono.hpp>
 
 #include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
 
 #include "features/shared/VOPFeatureCalculator_Shared.h"
+#include "util/MemoryBlockFactory.h"
 
 namespace spaint {
 
 //#################### CONSTRUCTORS ####################
 
-VOPFeatureCalculator_CPU::VOPFeatureCalculator_CPU(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount)
-: VOPFeatureCalculator(maxVoxelLocationCount, patchSize, patchSpacing, binCount)
-{}
+VOPFeatureCalculator_CPU::VOPFeatureCalculator_CPU(size_t maxVoxelLocationCount, size_t patchSize, float patchSpacing, size_t binCount,
+                                                   const VOPFeatureCache_Ptr& cache, VOPFeatureKernels_CPU::InstructionSet instructionSet)
+: VOPFeatureCalculator(maxVoxelLocationCount, patchSize, patchSpacing, binCount), m_cache(cache), m_kernels(instructionSet), m_workspace(patchSize, binCount)
+{
+  m_tileOrder.reserve(maxVoxelLocationCount);
+
+  if(m_cache)
+  {
+    m_cache->set_feature_count(get_feature_count());
+
+    MemoryBlockFactory& mbf = MemoryBlockFactory::instance();
+    m_missFeaturesMB = mbf.make_block<float>(maxVoxelLocationCount * get_feature_count());
+    m_missLocationsMB = mbf.make_block<Vector3s>(maxVoxelLocationCount);
+    m_missIndices.reserve(maxVoxelLocationCount);
+    m_missVoxels.reserve(maxVoxelLocationCount);
+  }
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VOPFeatureCalculator_CPU::calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+                                                  const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                                  ORUtils::MemoryBlock<float>& featuresMB) const
+{
+  // If we're not using a cache, simply calculate the features for all of the voxels.
+  if(!m_cache)
+  {
+    VOPFeatureCalculator::calculate_features(voxelLocationsMB, scene, featuresMB);
+    return;
+  }
+
+  const size_t featureCount = get_feature_count();
+  float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
+  const ITMVoxelIndex::IndexData *indexData = scene->index.getIndexData();
+  const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
+  const Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+  Vector3s *missLocations = m_missLocationsMB->GetData(MEMORYDEVICE_CPU);
+
+  // Start a new batch of lookups, so that the cache can expire feature descriptors that are too old to trust.
+  m_cache->start_batch();
+
+  // Copy the feature descriptors for any voxels that have valid entries in the cache into the output,
+  // and make a note of the remaining voxels, for which the feature descriptors must be calculated.
+  m_missIndices.clear();
+  m_missVoxels.clear();
+  for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
+  {
+    const Vector3s& voxelLocation = voxelLocations[voxelLocationIndex];
+    bool isFound;
+    SpaintVoxel voxel = readVoxel(voxelData, indexData, Vector3i(voxelLocation.x, voxelLocation.y, voxelLocation.z), isFound);
+
+    const float *cachedFeatures = isFound ? m_cache->lookup(voxelLocation, voxel) : NULL;
+    if(cachedFeatures)
+    {
+      std::copy(cachedFeatures, cachedFeatures + featureCount, features + voxelLocationIndex * featureCount);
+    }
+    else
+    {
+      missLocations[m_missIndices.size()] = voxelLocation;
+      m_missIndices.push_back(voxelLocationIndex);
+      m_missVoxels.push_back(voxel);
+    }
+  }
+
+  if(m_missIndices.empty()) return;
+
+  // Calculate the feature descriptors for the voxels that were not in the cache.
+  const int missCount = static_cast<int>(m_missIndices.size());
+  boost::chrono::high_resolution_clock::time_point t0 = boost::chrono::high_resolution_clock::now();
+  compute_features(*m_missLocationsMB, missCount, scene, *m_missFeaturesMB);
+  boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+  m_cache->record_computation(missCount, boost::chrono::duration_cast<boost::chrono::microseconds>(t1 - t0));
+
+  // Copy the newly-calculated feature descriptors into the output, and store them in the cache for future use
+  // (note that there is no point in caching the descriptors for voxels that have not yet been fused into the scene).
+  const float *missFeatures = m_missFeaturesMB->GetData(MEMORYDEVICE_CPU);
+  for(int i = 0; i < missCount; ++i)
+  {
+    const float *missFeature = missFeatures + i * featureCount;
+    std::copy(missFeature, missFeature + featureCount, features + m_missIndices[i] * featureCount);
+    if(m_missVoxels[i].w_depth > 0) m_cache->store(missLocations[i], m_missVoxels[i], missFeature);
+  }
+}
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
-void VOPFeatureCalculator_CPU::calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+void VOPFeatureCalculator_CPU::calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
                                                          const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                                          ORUtils::MemoryBlock<float>& featuresMB) const
 {
@@ -29,7 +113,6 @@ void VOPFeatureCalculator_CPU::calculate_surface_normals(const ORUtils::MemoryBl
   float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
   Vector3f *surfaceNormals = m_surfaceNormalsMB->GetData(MEMORYDEVICE_CPU);
   const Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
-  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
 
 #ifdef WITH_OPENMP
   #pragma omp parallel for
@@ -50,15 +133,14 @@ void VOPFeatureCalculator_CPU::convert_patches_to_lab(int voxelLocationCount, OR
 #endif
   for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
   {
-    convert_patch_to_lab(voxelLocationIndex, featureCount, features);
+    m_kernels.convert_patch_to_lab(features + voxelLocationIndex * featureCount, static_cast<int>(m_patchSize * m_patchSize));
   }
 }
 
-void VOPFeatureCalculator_CPU::fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, ORUtils::MemoryBlock<float>& featuresMB) const
+void VOPFeatureCalculator_CPU::fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const
 {
   const size_t featureCount = get_feature_count();
   float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
-  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
   const Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
 
 #ifdef WITH_OPENMP
@@ -85,7 +167,7 @@ void VOPFeatureCalculator_CPU::generate_coordinate_systems(int voxelLocationCoun
   }
 }
 
-void VOPFeatureCalculator_CPU::generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+void VOPFeatureCalculator_CPU::generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
                                                     const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                                     ORUtils::MemoryBlock<float>& featuresMB) const
 {
@@ -94,14 +176,18 @@ void VOPFeatureCalculator_CPU::generate_rgb_patches(const ORUtils::MemoryBlock<V
   const Vector3f *xAxes = m_xAxesMB->GetData(MEMORYDEVICE_CPU);
   const Vector3f *yAxes = m_yAxesMB->GetData(MEMORYDEVICE_CPU);
   const Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
-  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
 
+  // Sort the voxels into spatially-coherent tiles, so that consecutive patches mostly read from the same voxel blocks.
+  make_tile_order(voxelLocations, voxelLocationCount, m_tileOrder);
+
+  // Generate the patches in tile order. Each patch resolves the voxel blocks it touches via its own patch block cache.
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
-  for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
+  for(int i = 0; i < voxelLocationCount; ++i)
   {
-    generate_rgb_patch(voxelLocationIndex, voxelLocations, xAxes, yAxes, voxelData, indexData, m_patchSize, m_patchSpacing, featureCount, features);
+    PatchBlockCache cache;
+    generate_rgb_patch(m_tileOrder[i].second, voxelLocations, xAxes, yAxes, voxelData, indexData, m_patchSize, m_patchSpacing, featureCount, features, cache);
   }
 }
 
@@ -114,39 +200,25 @@ void VOPFeatureCalculator_CPU::update_coordinate_systems(int voxelLocationCount,
   Vector3f *xAxes = m_xAxesMB->GetData(MEMORYDEVICE_CPU);
   Vector3f *yAxes = m_yAxesMB->GetData(MEMORYDEVICE_CPU);
 
-  std::vector<std::vector<float> > histograms(voxelLocationCount, std::vector<float>(m_binCount));
-  std::vector<std::vector<float> > intensities(voxelLocationCount, std::vector<float>(patchArea));
-
-  int threadCount = voxelLocationCount * patchArea;
-
-  // Convert each voxel's RGB patch to an intensity patch.
+  // For each voxel, compute a histogram of oriented gradients from its intensity patch, calculate the dominant orientation
+  // and rotate its coordinate system to align with that as necessary. Each thread processes whole voxels, using its own
+  // scratch space in the workspace (the number of threads is limited to ensure that each thread has some).
 #ifdef WITH_OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(m_workspace.get_thread_count())
 #endif
-  for(int tid = 0; tid < threadCount; ++tid)
+  for(int voxelLocationIndex = 0; voxelLocationIndex < voxelLocationCount; ++voxelLocationIndex)
   {
-    int voxelLocationIndex = tid / patchArea;
-    compute_intensities_for_patch(tid, features, featureCount, patchSize, &intensities[voxelLocationIndex][0]);
-  }
+    const int firstTid = voxelLocationIndex * patchArea;
+    float *intensityPatch = m_workspace.get_intensity_patch();
+    float *histogram = m_workspace.get_histogram();
 
-  // Compute a histogram of oriented gradients from the intensity patch for each voxel.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int tid = 0; tid < threadCount; ++tid)
-  {
-    int voxelLocationIndex = tid / patchArea;
-    compute_histogram_for_patch(tid, m_patchSize, &intensities[voxelLocationIndex][0], m_binCount, &histograms[voxelLocationIndex][0]);
-  }
+    for(int indexInPatch = 0; indexInPatch < patchArea; ++indexInPatch)
+    {
+      compute_intensities_for_patch(firstTid + indexInPatch, features, featureCount, patchSize, intensityPatch);
+    }
 
-  // Calculate the dominant orientation for each voxel and rotate its coordinate system to align with that as necessary.
-#ifdef WITH_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int tid = 0; tid < threadCount; ++tid)
-  {
-    int voxelLocationIndex = tid / patchArea;
-    update_coordinate_system(tid, patchArea, &histograms[voxelLocationIndex][0], m_binCount, &xAxes[voxelLocationIndex], &yAxes[voxelLocationIndex]);
+    m_kernels.compute_histogram(intensityPatch, patchSize, static_cast<int>(m_binCount), histogram);
+    update_coordinate_system(firstTid, patchArea, histogram, m_binCount, &xAxes[voxelLocationIndex], &yAxes[voxelLocationIndex]);
   }
 }
 
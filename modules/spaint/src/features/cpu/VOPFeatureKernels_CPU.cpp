@@ -0,0 +1,642 @@
+/**
+ * spaint: VOPFeatureKernels_CPU.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "features/cpu/VOPFeatureKernels_CPU.h"
+
+#include <stdexcept>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+
+#include "features/shared/VOPFeatureCalculator_Shared.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define SPAINT_VOP_KERNELS_X86
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #endif
+#endif
+
+// On GCC and Clang, the functions that use a particular instruction set must be marked as targeting it (since the rest of the code
+// is compiled for the baseline architecture). Visual Studio allows the intrinsics for any instruction set to be used anywhere.
+#if defined(__GNUC__)
+  #define SPAINT_TARGET_SSE2 __attribute__((target("sse2")))
+  #define SPAINT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define SPAINT_TARGET_SSE2
+  #define SPAINT_TARGET_AVX2
+#endif
+
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/** The value below which the CIELab conversion uses a linear function rather than a cube root. */
+const float LAB_THRESHOLD = 0.008856f;
+
+/** The value of tan(pi / 8), above which arctangents are computed via the identity atan(a) = pi / 4 + atan((a - 1) / (a + 1)). */
+const float TAN_EIGHTH_PI = 0.414213562f;
+
+//#################### LOCAL FUNCTIONS ####################
+
+/**
+ * \brief Computes a histogram of oriented gradients from a patch of intensity values using the scalar kernel.
+ *
+ * \param intensityPatch  The patch of intensity values from which to calculate the histogram.
+ * \param patchSize       The side length of the patch (must be odd).
+ * \param binCount        The number of bins into which to quantize the gradient orientations.
+ * \param histogram       The histogram to which to add the gradients (must have been cleared beforehand).
+ */
+void compute_histogram_scalar(const float *intensityPatch, int patchSize, int binCount, float *histogram)
+{
+  for(int y = 1; y < patchSize - 1; ++y)
+  {
+    for(int x = 1; x < patchSize - 1; ++x)
+    {
+      int bin;
+      float mag;
+      if(spaint::compute_oriented_gradient(y * patchSize + x, patchSize, intensityPatch, binCount, bin, mag)) histogram[bin] += mag;
+    }
+  }
+}
+
+/**
+ * \brief Converts an RGB patch to the CIELab colour space in place using the scalar kernel.
+ *
+ * \param patch       The patch, stored as interleaved RGB values in the range [0,255].
+ * \param pixelCount  The number of pixels in the patch.
+ */
+void convert_patch_to_lab_scalar(float *patch, int pixelCount)
+{
+  for(int i = 0; i < pixelCount; ++i, patch += 3)
+  {
+    Vector3f lab = spaint::convert_rgb_to_lab(Vector3f(patch[0] / 255.0f, patch[1] / 255.0f, patch[2] / 255.0f));
+    patch[0] = lab.x;
+    patch[1] = lab.y;
+    patch[2] = lab.z;
+  }
+}
+
+#ifdef SPAINT_VOP_KERNELS_X86
+
+/**
+ * \brief Determines whether or not the CPU (and operating system) support AVX2.
+ *
+ * \return  true, if the CPU supports AVX2, or false otherwise.
+ */
+bool cpu_supports_avx2()
+{
+#if defined(__GNUC__)
+  // Note that GCC only reports AVX2 as supported if the operating system saves the AVX registers on context switches.
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if(info[0] < 7) return false;
+
+  // Check that the CPU supports AVX and that the operating system saves the AVX registers on context switches.
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+  if(!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return false;
+#endif
+}
+
+/**
+ * \brief Determines whether or not the CPU supports SSE2.
+ *
+ * \return  true, if the CPU supports SSE2, or false otherwise.
+ */
+bool cpu_supports_sse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+  // SSE2 is part of the baseline x86-64 architecture.
+  return true;
+#elif defined(__GNUC__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2") != 0;
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[3] & (1 << 26)) != 0;
+#else
+  return false;
+#endif
+}
+
+/**
+ * \brief Adds the gradients at a run of consecutive pixels in a patch (as computed by one of the vectorised kernels) to a histogram.
+ *
+ * \param intensityPatch  The patch of intensity values.
+ * \param indexInPatch    The index within the patch of the first of the pixels.
+ * \param patchSize       The side length of the patch.
+ * \param binCount        The number of bins into which to quantize the gradient orientations.
+ * \param bins            The bins into which the gradient orientations fall.
+ * \param mags            The magnitudes of the gradients.
+ * \param pixelCount      The number of pixels in the run.
+ * \param boundaryMask    A bit mask denoting the pixels whose gradients must be requantized using the scalar kernel.
+ * \param histogram       The histogram to which to add the gradients.
+ */
+inline void accumulate_gradients(const float *intensityPatch, int indexInPatch, int patchSize, int binCount, int *bins, float *mags,
+                                 int pixelCount, int boundaryMask, float *histogram)
+{
+  for(int k = 0; k < pixelCount; ++k)
+  {
+    if(boundaryMask & (1 << k))
+    {
+      spaint::compute_oriented_gradient(indexInPatch + k, patchSize, intensityPatch, binCount, bins[k], mags[k]);
+    }
+
+    histogram[bins[k]] += mags[k];
+  }
+}
+
+//~~~~~~~~~~~~~~~~~~~~ SSE2 ~~~~~~~~~~~~~~~~~~~~
+
+/**
+ * \brief Selects between two vectors of floats based on a mask.
+ *
+ * \param mask  The mask.
+ * \param a     The vector whose elements should be selected where the mask is set.
+ * \param b     The vector whose elements should be selected where the mask is clear.
+ * \return      The selected elements.
+ */
+SPAINT_TARGET_SSE2
+inline __m128 select_sse2(__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/**
+ * \brief Computes the cube roots of a vector of non-negative floats.
+ *
+ * An initial estimate is made by dividing the exponent of each float by three (by manipulating its bit pattern),
+ * and this is then refined using three iterations of Newton's method.
+ *
+ * \param t The vector of floats.
+ * \return  The cube roots of the floats.
+ */
+SPAINT_TARGET_SSE2
+inline __m128 cbrt_sse2(__m128 t)
+{
+  const __m128 third = _mm_set1_ps(1.0f / 3.0f);
+  __m128i bits = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_castps_si128(t)), third));
+  __m128 y = _mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(709921077)));
+
+  for(int i = 0; i < 3; ++i)
+  {
+    y = _mm_mul_ps(_mm_add_ps(_mm_add_ps(y, y), _mm_div_ps(t, _mm_mul_ps(y, y))), third);
+  }
+
+  return y;
+}
+
+/**
+ * \brief A vectorised version of rgb_to_lab_f.
+ */
+SPAINT_TARGET_SSE2
+inline __m128 rgb_to_lab_f_sse2(__m128 t)
+{
+  const __m128 linear = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(7.787f), t), _mm_set1_ps(16.0f / 116.0f));
+  return select_sse2(_mm_cmpgt_ps(t, _mm_set1_ps(LAB_THRESHOLD)), cbrt_sse2(t), linear);
+}
+
+/**
+ * \brief Converts a block of 4 pixels in an RGB patch to the CIELab colour space in place.
+ *
+ * \param patch The first pixel in the block, stored as interleaved RGB values in the range [0,255].
+ */
+SPAINT_TARGET_SSE2
+void convert_block_to_lab_sse2(float *patch)
+{
+  // Deinterleave the red, green and blue values of the pixels.
+  float rs[4], gs[4], bs[4];
+  for(int k = 0; k < 4; ++k)
+  {
+    rs[k] = patch[3*k];
+    gs[k] = patch[3*k+1];
+    bs[k] = patch[3*k+2];
+  }
+
+  const __m128 scale = _mm_set1_ps(255.0f);
+  const __m128 r = _mm_div_ps(_mm_loadu_ps(rs), scale), g = _mm_div_ps(_mm_loadu_ps(gs), scale), b = _mm_div_ps(_mm_loadu_ps(bs), scale);
+
+  // Convert the colours to CIE XYZ.
+  __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.412453f), r), _mm_mul_ps(_mm_set1_ps(0.357580f), g)), _mm_mul_ps(_mm_set1_ps(0.180423f), b));
+  __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.212671f), r), _mm_mul_ps(_mm_set1_ps(0.715160f), g)), _mm_mul_ps(_mm_set1_ps(0.072169f), b));
+  __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.019334f), r), _mm_mul_ps(_mm_set1_ps(0.119193f), g)), _mm_mul_ps(_mm_set1_ps(0.950227f), b));
+  x = _mm_div_ps(x, _mm_set1_ps(0.950456f));
+  z = _mm_div_ps(z, _mm_set1_ps(1.088754f));
+
+  // Convert the colours from CIE XYZ to CIELab, and normalise the a and b values as in convert_rgb_to_lab.
+  const __m128 fx = rgb_to_lab_f_sse2(x), fy = rgb_to_lab_f_sse2(y), fz = rgb_to_lab_f_sse2(z);
+  const __m128 L = select_sse2(
+    _mm_cmpgt_ps(y, _mm_set1_ps(LAB_THRESHOLD)),
+    _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(116.0f), fy), _mm_set1_ps(16.0f)),
+    _mm_mul_ps(_mm_set1_ps(903.3f), y)
+  );
+  __m128 A = _mm_mul_ps(_mm_set1_ps(500.0f), _mm_sub_ps(fx, fy));
+  __m128 B = _mm_mul_ps(_mm_set1_ps(200.0f), _mm_sub_ps(fy, fz));
+  const __m128 AplusB = _mm_add_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_add_ps(A, B)), _mm_set1_ps(0.000001f));
+  A = _mm_div_ps(A, AplusB);
+  B = _mm_div_ps(B, AplusB);
+
+  // Write the results back into the patch.
+  _mm_storeu_ps(rs, L);
+  _mm_storeu_ps(gs, A);
+  _mm_storeu_ps(bs, B);
+  for(int k = 0; k < 4; ++k)
+  {
+    patch[3*k] = rs[k];
+    patch[3*k+1] = gs[k];
+    patch[3*k+2] = bs[k];
+  }
+}
+
+/**
+ * \brief Computes the quantized orientations and magnitudes of the intensity gradients at 4 consecutive pixels in a patch.
+ *
+ * The orientations are computed using the arctangent approximation from the Cephes library (which is accurate to within
+ * a couple of ulps). Horizontal, vertical and diagonal gradients lie exactly on the boundaries between bins for common
+ * bin counts, and the bins into which compute_oriented_gradient puts them depend on how it rounds, so rather than trying
+ * to replicate its rounding, the pixels at which such gradients occur are flagged so that they can be requantized by it.
+ *
+ * \param intensityPatch  The patch of intensity values.
+ * \param indexInPatch    The index within the patch of the first of the pixels (which must all be away from the boundaries of the patch).
+ * \param patchSize       The side length of the patch.
+ * \param binCount        The number of bins into which to quantize the gradient orientations.
+ * \param bins            A location into which to write the bins into which the gradient orientations fall.
+ * \param mags            A location into which to write the magnitudes of the gradients.
+ * \return                A bit mask denoting the pixels whose gradients are horizontal, vertical or diagonal.
+ */
+SPAINT_TARGET_SSE2
+int compute_oriented_gradients_sse2(const float *intensityPatch, int indexInPatch, int patchSize, int binCount, int *bins, float *mags)
+{
+  const float *p = intensityPatch + indexInPatch;
+  const __m128 xDeriv = _mm_sub_ps(_mm_loadu_ps(p + 1), _mm_loadu_ps(p - 1));
+  const __m128 yDeriv = _mm_sub_ps(_mm_loadu_ps(p + patchSize), _mm_loadu_ps(p - patchSize));
+  _mm_storeu_ps(mags, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(xDeriv, xDeriv), _mm_mul_ps(yDeriv, yDeriv))));
+
+  // Compute the arctangent of the ratio between the smaller and the larger of the absolute derivatives (or zero if both are zero).
+  const __m128 signMask = _mm_set1_ps(-0.0f), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+  const __m128 absX = _mm_andnot_ps(signMask, xDeriv), absY = _mm_andnot_ps(signMask, yDeriv);
+  const __m128 maxAbs = _mm_max_ps(absX, absY);
+  __m128 a = _mm_and_ps(_mm_div_ps(_mm_min_ps(absX, absY), maxAbs), _mm_cmpgt_ps(maxAbs, zero));
+
+  const __m128 reduce = _mm_cmpgt_ps(a, _mm_set1_ps(TAN_EIGHTH_PI));
+  a = select_sse2(reduce, _mm_div_ps(_mm_sub_ps(a, one), _mm_add_ps(a, one)), a);
+  const __m128 a2 = _mm_mul_ps(a, a);
+  __m128 poly = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(8.05374449538e-2f), a2), _mm_set1_ps(1.38776856032e-1f));
+  poly = _mm_add_ps(_mm_mul_ps(poly, a2), _mm_set1_ps(1.99777106478e-1f));
+  poly = _mm_sub_ps(_mm_mul_ps(poly, a2), _mm_set1_ps(3.33329491539e-1f));
+  const __m128 angle = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(poly, a2), a), a);
+
+  // Convert the angle to bins (adding an eighth of a turn if the range was reduced), and then use the signs and relative sizes
+  // of the derivatives to find the octant. Note that the offsets are all added in bins rather than radians to keep them exact.
+  const float fullTurn = static_cast<float>(binCount);
+  __m128 t = _mm_mul_ps(angle, _mm_set1_ps(fullTurn / static_cast<float>(2 * M_PI)));
+  t = _mm_add_ps(t, _mm_and_ps(reduce, _mm_set1_ps(fullTurn / 8)));
+  t = select_sse2(_mm_cmpgt_ps(absY, absX), _mm_sub_ps(_mm_set1_ps(fullTurn / 4), t), t);
+  t = select_sse2(_mm_cmplt_ps(xDeriv, zero), _mm_sub_ps(_mm_set1_ps(fullTurn / 2), t), t);
+  t = select_sse2(_mm_cmplt_ps(yDeriv, zero), _mm_sub_ps(_mm_set1_ps(fullTurn), t), t);
+  t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpge_ps(t, _mm_set1_ps(fullTurn)), _mm_set1_ps(fullTurn)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(bins), _mm_cvttps_epi32(t));
+
+  const __m128 onBoundary = _mm_or_ps(_mm_cmpeq_ps(absX, absY), _mm_cmpeq_ps(_mm_min_ps(absX, absY), zero));
+  return _mm_movemask_ps(_mm_and_ps(onBoundary, _mm_cmpgt_ps(maxAbs, zero)));
+}
+
+/**
+ * \brief Computes a histogram of oriented gradients from a patch of intensity values using SSE2.
+ */
+SPAINT_TARGET_SSE2
+void compute_histogram_sse2(const float *intensityPatch, int patchSize, int binCount, float *histogram)
+{
+  const int vectorisedWidth = (patchSize - 2) / 4 * 4;
+  int bins[4];
+  float mags[4];
+  for(int y = 1; y < patchSize - 1; ++y)
+  {
+    for(int x = 1; x < vectorisedWidth + 1; x += 4)
+    {
+      const int indexInPatch = y * patchSize + x;
+      const int boundaryMask = compute_oriented_gradients_sse2(intensityPatch, indexInPatch, patchSize, binCount, bins, mags);
+      accumulate_gradients(intensityPatch, indexInPatch, patchSize, binCount, bins, mags, 4, boundaryMask, histogram);
+    }
+
+    // Process any remaining pixels in the row using the scalar kernel.
+    for(int x = vectorisedWidth + 1; x < patchSize - 1; ++x)
+    {
+      int bin;
+      float mag;
+      if(spaint::compute_oriented_gradient(y * patchSize + x, patchSize, intensityPatch, binCount, bin, mag)) histogram[bin] += mag;
+    }
+  }
+}
+
+/**
+ * \brief Converts an RGB patch to the CIELab colour space in place using SSE2.
+ */
+SPAINT_TARGET_SSE2
+void convert_patch_to_lab_sse2(float *patch, int pixelCount)
+{
+  const int vectorisedCount = pixelCount / 4 * 4;
+  for(int i = 0; i < vectorisedCount; i += 4)
+  {
+    convert_block_to_lab_sse2(patch + 3 * i);
+  }
+  convert_patch_to_lab_scalar(patch + 3 * vectorisedCount, pixelCount - vectorisedCount);
+}
+
+//~~~~~~~~~~~~~~~~~~~~ AVX2 ~~~~~~~~~~~~~~~~~~~~
+
+/**
+ * \brief Computes the cube roots of a vector of non-negative floats (see cbrt_sse2).
+ */
+SPAINT_TARGET_AVX2
+inline __m256 cbrt_avx2(__m256 t)
+{
+  const __m256 third = _mm256_set1_ps(1.0f / 3.0f);
+  __m256i bits = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(t)), third));
+  __m256 y = _mm256_castsi256_ps(_mm256_add_epi32(bits, _mm256_set1_epi32(709921077)));
+
+  for(int i = 0; i < 3; ++i)
+  {
+    y = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(y, y), _mm256_div_ps(t, _mm256_mul_ps(y, y))), third);
+  }
+
+  return y;
+}
+
+/**
+ * \brief A vectorised version of rgb_to_lab_f.
+ */
+SPAINT_TARGET_AVX2
+inline __m256 rgb_to_lab_f_avx2(__m256 t)
+{
+  const __m256 linear = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(7.787f), t), _mm256_set1_ps(16.0f / 116.0f));
+  return _mm256_blendv_ps(linear, cbrt_avx2(t), _mm256_cmp_ps(t, _mm256_set1_ps(LAB_THRESHOLD), _CMP_GT_OQ));
+}
+
+/**
+ * \brief Converts a block of 8 pixels in an RGB patch to the CIELab colour space in place (see convert_block_to_lab_sse2).
+ */
+SPAINT_TARGET_AVX2
+void convert_block_to_lab_avx2(float *patch)
+{
+  float rs[8], gs[8], bs[8];
+  for(int k = 0; k < 8; ++k)
+  {
+    rs[k] = patch[3*k];
+    gs[k] = patch[3*k+1];
+    bs[k] = patch[3*k+2];
+  }
+
+  const __m256 scale = _mm256_set1_ps(255.0f);
+  const __m256 r = _mm256_div_ps(_mm256_loadu_ps(rs), scale), g = _mm256_div_ps(_mm256_loadu_ps(gs), scale), b = _mm256_div_ps(_mm256_loadu_ps(bs), scale);
+
+  __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.412453f), r), _mm256_mul_ps(_mm256_set1_ps(0.357580f), g)), _mm256_mul_ps(_mm256_set1_ps(0.180423f), b));
+  __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.212671f), r), _mm256_mul_ps(_mm256_set1_ps(0.715160f), g)), _mm256_mul_ps(_mm256_set1_ps(0.072169f), b));
+  __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.019334f), r), _mm256_mul_ps(_mm256_set1_ps(0.119193f), g)), _mm256_mul_ps(_mm256_set1_ps(0.950227f), b));
+  x = _mm256_div_ps(x, _mm256_set1_ps(0.950456f));
+  z = _mm256_div_ps(z, _mm256_set1_ps(1.088754f));
+
+  const __m256 fx = rgb_to_lab_f_avx2(x), fy = rgb_to_lab_f_avx2(y), fz = rgb_to_lab_f_avx2(z);
+  const __m256 L = _mm256_blendv_ps(
+    _mm256_mul_ps(_mm256_set1_ps(903.3f), y),
+    _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(116.0f), fy), _mm256_set1_ps(16.0f)),
+    _mm256_cmp_ps(y, _mm256_set1_ps(LAB_THRESHOLD), _CMP_GT_OQ)
+  );
+  __m256 A = _mm256_mul_ps(_mm256_set1_ps(500.0f), _mm256_sub_ps(fx, fy));
+  __m256 B = _mm256_mul_ps(_mm256_set1_ps(200.0f), _mm256_sub_ps(fy, fz));
+  const __m256 AplusB = _mm256_add_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_add_ps(A, B)), _mm256_set1_ps(0.000001f));
+  A = _mm256_div_ps(A, AplusB);
+  B = _mm256_div_ps(B, AplusB);
+
+  _mm256_storeu_ps(rs, L);
+  _mm256_storeu_ps(gs, A);
+  _mm256_storeu_ps(bs, B);
+  for(int k = 0; k < 8; ++k)
+  {
+    patch[3*k] = rs[k];
+    patch[3*k+1] = gs[k];
+    patch[3*k+2] = bs[k];
+  }
+}
+
+/**
+ * \brief Computes the quantized orientations and magnitudes of the intensity gradients at 8 consecutive pixels in a patch
+ *        (see compute_oriented_gradients_sse2).
+ */
+SPAINT_TARGET_AVX2
+int compute_oriented_gradients_avx2(const float *intensityPatch, int indexInPatch, int patchSize, int binCount, int *bins, float *mags)
+{
+  const float *p = intensityPatch + indexInPatch;
+  const __m256 xDeriv = _mm256_sub_ps(_mm256_loadu_ps(p + 1), _mm256_loadu_ps(p - 1));
+  const __m256 yDeriv = _mm256_sub_ps(_mm256_loadu_ps(p + patchSize), _mm256_loadu_ps(p - patchSize));
+  _mm256_storeu_ps(mags, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(xDeriv, xDeriv), _mm256_mul_ps(yDeriv, yDeriv))));
+
+  const __m256 signMask = _mm256_set1_ps(-0.0f), zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+  const __m256 absX = _mm256_andnot_ps(signMask, xDeriv), absY = _mm256_andnot_ps(signMask, yDeriv);
+  const __m256 maxAbs = _mm256_max_ps(absX, absY);
+  __m256 a = _mm256_and_ps(_mm256_div_ps(_mm256_min_ps(absX, absY), maxAbs), _mm256_cmp_ps(maxAbs, zero, _CMP_GT_OQ));
+
+  const __m256 reduce = _mm256_cmp_ps(a, _mm256_set1_ps(TAN_EIGHTH_PI), _CMP_GT_OQ);
+  a = _mm256_blendv_ps(a, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), reduce);
+  const __m256 a2 = _mm256_mul_ps(a, a);
+  __m256 poly = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(8.05374449538e-2f), a2), _mm256_set1_ps(1.38776856032e-1f));
+  poly = _mm256_add_ps(_mm256_mul_ps(poly, a2), _mm256_set1_ps(1.99777106478e-1f));
+  poly = _mm256_sub_ps(_mm256_mul_ps(poly, a2), _mm256_set1_ps(3.33329491539e-1f));
+  const __m256 angle = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(poly, a2), a), a);
+
+  const float fullTurn = static_cast<float>(binCount);
+  __m256 t = _mm256_mul_ps(angle, _mm256_set1_ps(fullTurn / static_cast<float>(2 * M_PI)));
+  t = _mm256_add_ps(t, _mm256_and_ps(reduce, _mm256_set1_ps(fullTurn / 8)));
+  t = _mm256_blendv_ps(t, _mm256_sub_ps(_mm256_set1_ps(fullTurn / 4), t), _mm256_cmp_ps(absY, absX, _CMP_GT_OQ));
+  t = _mm256_blendv_ps(t, _mm256_sub_ps(_mm256_set1_ps(fullTurn / 2), t), _mm256_cmp_ps(xDeriv, zero, _CMP_LT_OQ));
+  t = _mm256_blendv_ps(t, _mm256_sub_ps(_mm256_set1_ps(fullTurn), t), _mm256_cmp_ps(yDeriv, zero, _CMP_LT_OQ));
+  t = _mm256_sub_ps(t, _mm256_and_ps(_mm256_cmp_ps(t, _mm256_set1_ps(fullTurn), _CMP_GE_OQ), _mm256_set1_ps(fullTurn)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(bins), _mm256_cvttps_epi32(t));
+
+  const __m256 onBoundary = _mm256_or_ps(_mm256_cmp_ps(absX, absY, _CMP_EQ_OQ), _mm256_cmp_ps(_mm256_min_ps(absX, absY), zero, _CMP_EQ_OQ));
+  return _mm256_movemask_ps(_mm256_and_ps(onBoundary, _mm256_cmp_ps(maxAbs, zero, _CMP_GT_OQ)));
+}
+
+/**
+ * \brief Computes a histogram of oriented gradients from a patch of intensity values using AVX2.
+ */
+SPAINT_TARGET_AVX2
+void compute_histogram_avx2(const float *intensityPatch, int patchSize, int binCount, float *histogram)
+{
+  int bins[8];
+  float mags[8];
+  for(int y = 1; y < patchSize - 1; ++y)
+  {
+    int x = 1;
+    for(; x + 8 <= patchSize - 1; x += 8)
+    {
+      const int indexInPatch = y * patchSize + x;
+      const int boundaryMask = compute_oriented_gradients_avx2(intensityPatch, indexInPatch, patchSize, binCount, bins, mags);
+      accumulate_gradients(intensityPatch, indexInPatch, patchSize, binCount, bins, mags, 8, boundaryMask, histogram);
+    }
+
+    // Since AVX2 implies SSE2, process any remaining block of 4 pixels in the row using SSE2 (this matters for small patches,
+    // whose rows may be too short for AVX2 to be used at all), and any pixels beyond that using the scalar kernel.
+    for(; x + 4 <= patchSize - 1; x += 4)
+    {
+      const int indexInPatch = y * patchSize + x;
+      const int boundaryMask = compute_oriented_gradients_sse2(intensityPatch, indexInPatch, patchSize, binCount, bins, mags);
+      accumulate_gradients(intensityPatch, indexInPatch, patchSize, binCount, bins, mags, 4, boundaryMask, histogram);
+    }
+
+    for(; x < patchSize - 1; ++x)
+    {
+      int bin;
+      float mag;
+      if(spaint::compute_oriented_gradient(y * patchSize + x, patchSize, intensityPatch, binCount, bin, mag)) histogram[bin] += mag;
+    }
+  }
+}
+
+/**
+ * \brief Converts an RGB patch to the CIELab colour space in place using AVX2.
+ */
+SPAINT_TARGET_AVX2
+void convert_patch_to_lab_avx2(float *patch, int pixelCount)
+{
+  const int vectorisedCount = pixelCount / 8 * 8;
+  for(int i = 0; i < vectorisedCount; i += 8)
+  {
+    convert_block_to_lab_avx2(patch + 3 * i);
+  }
+  convert_patch_to_lab_scalar(patch + 3 * vectorisedCount, pixelCount - vectorisedCount);
+}
+
+#endif
+
+}
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+VOPFeatureKernels_CPU::VOPFeatureKernels_CPU()
+: m_instructionSet(INSTRUCTIONSET_SCALAR)
+{}
+
+VOPFeatureKernels_CPU::VOPFeatureKernels_CPU(InstructionSet instructionSet)
+: m_instructionSet(instructionSet)
+{
+  if(!is_supported(instructionSet))
+  {
+    throw std::runtime_error("Error: The " + get_instruction_set_name(instructionSet) + " instruction set is not supported by this CPU");
+  }
+}
+
+//#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+
+VOPFeatureKernels_CPU::InstructionSet VOPFeatureKernels_CPU::get_best_instruction_set()
+{
+  if(is_supported(INSTRUCTIONSET_AVX2)) return INSTRUCTIONSET_AVX2;
+  else if(is_supported(INSTRUCTIONSET_SSE2)) return INSTRUCTIONSET_SSE2;
+  else return INSTRUCTIONSET_SCALAR;
+}
+
+std::string VOPFeatureKernels_CPU::get_instruction_set_name(InstructionSet instructionSet)
+{
+  switch(instructionSet)
+  {
+    case INSTRUCTIONSET_AVX2:
+      return "AVX2";
+    case INSTRUCTIONSET_SSE2:
+      return "SSE2";
+    default:
+      return "Scalar";
+  }
+}
+
+bool VOPFeatureKernels_CPU::is_supported(InstructionSet instructionSet)
+{
+  switch(instructionSet)
+  {
+#ifdef SPAINT_VOP_KERNELS_X86
+    case INSTRUCTIONSET_AVX2:
+      return cpu_supports_avx2();
+    case INSTRUCTIONSET_SSE2:
+      return cpu_supports_sse2();
+#endif
+    case INSTRUCTIONSET_SCALAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VOPFeatureKernels_CPU::compute_histogram(const float *intensityPatch, int patchSize, int binCount, float *histogram) const
+{
+  for(int binIndex = 0; binIndex < binCount; ++binIndex) histogram[binIndex] = 0.0f;
+
+  switch(m_instructionSet)
+  {
+#ifdef SPAINT_VOP_KERNELS_X86
+    case INSTRUCTIONSET_AVX2:
+      compute_histogram_avx2(intensityPatch, patchSize, binCount, histogram);
+      break;
+    case INSTRUCTIONSET_SSE2:
+      compute_histogram_sse2(intensityPatch, patchSize, binCount, histogram);
+      break;
+#endif
+    default:
+      compute_histogram_scalar(intensityPatch, patchSize, binCount, histogram);
+      break;
+  }
+}
+
+void VOPFeatureKernels_CPU::convert_patch_to_lab(float *patch, int pixelCount) const
+{
+  switch(m_instructionSet)
+  {
+#ifdef SPAINT_VOP_KERNELS_X86
+    case INSTRUCTIONSET_AVX2:
+      convert_patch_to_lab_avx2(patch, pixelCount);
+      break;
+    case INSTRUCTIONSET_SSE2:
+      convert_patch_to_lab_sse2(patch, pixelCount);
+      break;
+#endif
+    default:
+      convert_patch_to_lab_scalar(patch, pixelCount);
+      break;
+  }
+}
+
+VOPFeatureKernels_CPU::InstructionSet VOPFeatureKernels_CPU::get_instruction_set() const
+{
+  return m_instructionSet;
+}
+
+int VOPFeatureKernels_CPU::get_vector_width() const
+{
+  switch(m_instructionSet)
+  {
+#ifdef SPAINT_VOP_KERNELS_X86
+    case INSTRUCTIONSET_AVX2:
+      return 8;
+    case INSTRUCTIONSET_SSE2:
+      return 4;
+#endif
+    default:
+      return 1;
+  }
+}
+
+}
@@ -97,12 +97,10 @@ VOPFeatureCalculator_CUDA::VOPFeatureCalculator_CUDA(size_t maxVoxelLocationCoun
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
-void VOPFeatureCalculator_CUDA::calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+void VOPFeatureCalculator_CUDA::calculate_surface_normals(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
                                                           const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                                           ORUtils::MemoryBlock<float>& featuresMB) const
 {
-  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
-
   int threadsPerBlock = 256;
   int numBlocks = (voxelLocationCount + threadsPerBlock - 1) / threadsPerBlock;
 
@@ -138,10 +136,8 @@ void VOPFeatureCalculator_CUDA::convert_patches_to_lab(int voxelLocationCount, O
 #endif
 }
 
-void VOPFeatureCalculator_CUDA::fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, ORUtils::MemoryBlock<float>& featuresMB) const
+void VOPFeatureCalculator_CUDA::fill_in_heights(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount, ORUtils::MemoryBlock<float>& featuresMB) const
 {
-  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
-
   int threadsPerBlock = 256;
   int numBlocks = (voxelLocationCount + threadsPerBlock - 1) / threadsPerBlock;
 
@@ -175,12 +171,10 @@ void VOPFeatureCalculator_CUDA::generate_coordinate_systems(int voxelLocationCou
 #endif
 }
 
-void VOPFeatureCalculator_CUDA::generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+void VOPFeatureCalculator_CUDA::generate_rgb_patches(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
                                                      const SpaintVoxel *voxelData, const ITMVoxelIndex::IndexData *indexData,
                                                      ORUtils::MemoryBlock<float>& featuresMB) const
 {
-  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
-
   int threadsPerBlock = 256;
   int numBlocks = (voxelLocationCount + threadsPerBlock - 1) / threadsPerBlock;
 
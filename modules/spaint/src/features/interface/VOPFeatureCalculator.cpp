@@ -34,25 +34,20 @@ VOPFeatureCalculator::VOPFeatureCalculator(size_t maxVoxelLocationCount, size_t
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
-void VOPFeatureCalculator::calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
-                                              const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
-                                              ORUtils::MemoryBlock<float>& featuresMB) const
+void VOPFeatureCalculator::align_coordinate_systems(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
+                                                    const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                                    ORUtils::MemoryBlock<float>& featuresMB) const
 {
-#if defined(WITH_OPENCV) && DEBUG_FEATURE_DISPLAY
-  process_debug_window();
-#endif
-
   // Calculate the surface normals at the voxel locations (this also writes them into the feature vectors).
   const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
   const ITMVoxelIndex::IndexData *indexData = scene->index.getIndexData();
-  calculate_surface_normals(voxelLocationsMB, voxelData, indexData, featuresMB);
+  calculate_surface_normals(voxelLocationsMB, voxelLocationCount, voxelData, indexData, featuresMB);
 
   // Construct a coordinate system in the tangent plane to the surface at each voxel location.
-  const int voxelLocationCount = static_cast<int>(voxelLocationsMB.dataSize);
   generate_coordinate_systems(voxelLocationCount);
 
   // Read an RGB patch around each voxel location.
-  generate_rgb_patches(voxelLocationsMB, voxelData, indexData, featuresMB);
+  generate_rgb_patches(voxelLocationsMB, voxelLocationCount, voxelData, indexData, featuresMB);
 
 #if defined(WITH_OPENCV) && DEBUG_FEATURE_DISPLAY
   display_features(featuresMB, voxelLocationCount, "Feature Samples Before Rotation");
@@ -60,9 +55,49 @@ void VOPFeatureCalculator::calculate_features(const ORUtils::MemoryBlock<Vector3
 
   // Determine the dominant orientation for each patch and update the coordinate systems accordingly.
   update_coordinate_systems(voxelLocationCount, featuresMB);
+}
+
+void VOPFeatureCalculator::calculate_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
+                                              const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                              ORUtils::MemoryBlock<float>& featuresMB) const
+{
+  compute_features(voxelLocationsMB, static_cast<int>(voxelLocationsMB.dataSize), scene, featuresMB);
+}
+
+size_t VOPFeatureCalculator::get_feature_count() const
+{
+  // A feature vector consists of a patch of CIELab colour values, the surface normal,
+  // and the height of the voxel in the scene.
+  return m_patchSize * m_patchSize * 3 + 3 + 1;
+}
+
+const ORUtils::MemoryBlock<Vector3f>& VOPFeatureCalculator::get_x_axes() const
+{
+  return *m_xAxesMB;
+}
+
+const ORUtils::MemoryBlock<Vector3f>& VOPFeatureCalculator::get_y_axes() const
+{
+  return *m_yAxesMB;
+}
+
+//#################### PROTECTED MEMBER FUNCTIONS ####################
+
+void VOPFeatureCalculator::compute_features(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, int voxelLocationCount,
+                                            const ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene,
+                                            ORUtils::MemoryBlock<float>& featuresMB) const
+{
+#if defined(WITH_OPENCV) && DEBUG_FEATURE_DISPLAY
+  process_debug_window();
+#endif
+
+  // Construct a coordinate system in the tangent plane to the surface at each voxel location, and align it with the dominant orientation of the voxel's patch.
+  align_coordinate_systems(voxelLocationsMB, voxelLocationCount, scene, featuresMB);
 
   // Read a new RGB patch around each voxel location that is oriented based on the dominant orientation.
-  generate_rgb_patches(voxelLocationsMB, voxelData, indexData, featuresMB);
+  const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+  const ITMVoxelIndex::IndexData *indexData = scene->index.getIndexData();
+  generate_rgb_patches(voxelLocationsMB, voxelLocationCount, voxelData, indexData, featuresMB);
 
 #if defined(WITH_OPENCV) && DEBUG_FEATURE_DISPLAY
   display_features(featuresMB, voxelLocationCount, "Feature Samples After Rotation");
@@ -80,14 +115,7 @@ void VOPFeatureCalculator::calculate_features(const ORUtils::MemoryBlock<Vector3
   // we write are simply the y values of the voxels. We ensure that scene up corresponds to world up by making
   // use of the gyro in the Oculus Rift. (If the Rift is not being used, the camera should simply be held
   // horizontally when running the application.)
-  fill_in_heights(voxelLocationsMB, featuresMB);
-}
-
-size_t VOPFeatureCalculator::get_feature_count() const
-{
-  // A feature vector consists of a patch of CIELab colour values, the surface normal,
-  // and the height of the voxel in the scene.
-  return m_patchSize * m_patchSize * 3 + 3 + 1;
+  fill_in_heights(voxelLocationsMB, voxelLocationCount, featuresMB);
 }
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
@@ -0,0 +1,184 @@
+/**
+ * spaint: VoxelLabelIndex.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "markers/VoxelLabelIndex.h"
+
+#include <algorithm>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/** The size below which a location list is never compacted when entries are added to it (compacting tiny lists is not worth the effort). */
+const size_t MIN_COMPACTION_SIZE = 1024;
+
+//#################### LOCAL FUNCTIONS ####################
+
+/**
+ * \brief Determines whether or not one voxel location precedes another in lexicographical order.
+ *
+ * \param lhs The first voxel location.
+ * \param rhs The second voxel location.
+ * \return    true, if the first voxel location precedes the second, or false otherwise.
+ */
+bool location_less(const Vector3s& lhs, const Vector3s& rhs)
+{
+  if(lhs.x != rhs.x) return lhs.x < rhs.x;
+  if(lhs.y != rhs.y) return lhs.y < rhs.y;
+  return lhs.z < rhs.z;
+}
+
+}
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+VoxelLabelIndex::VoxelLabelIndex()
+: m_compactedSizes(LABEL_COUNT, 0), m_locations(LABEL_COUNT), m_valid(false)
+{}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VoxelLabelIndex::add_voxels(const Vector3s *voxelLocations, int voxelCount, SpaintVoxel::PackedLabel label, const Scene *scene)
+{
+  // If the index is invalid, there is no point in recording the voxels, since the index will be rebuilt from the scene before it is next used.
+  if(!m_valid) return;
+
+  for(int i = 0; i < voxelCount; ++i)
+  {
+    record_voxel(voxelLocations[i], label);
+  }
+
+  compact_grown_lists(scene);
+}
+
+void VoxelLabelIndex::add_voxels(const Vector3s *voxelLocations, const SpaintVoxel::PackedLabel *voxelLabels, int voxelCount, const Scene *scene)
+{
+  if(!m_valid) return;
+
+  for(int i = 0; i < voxelCount; ++i)
+  {
+    record_voxel(voxelLocations[i], voxelLabels[i]);
+  }
+
+  compact_grown_lists(scene);
+}
+
+const std::vector<Vector3s>& VoxelLabelIndex::get_voxels(SpaintVoxel::Label label, const Scene *scene)
+{
+  if(!m_valid) rebuild(scene);
+  compact(label, scene);
+  return m_locations[label];
+}
+
+void VoxelLabelIndex::invalidate()
+{
+  m_valid = false;
+}
+
+bool VoxelLabelIndex::is_valid() const
+{
+  return m_valid;
+}
+
+void VoxelLabelIndex::rebuild(const Scene *scene)
+{
+  for(int label = 0; label < LABEL_COUNT; ++label)
+  {
+    m_locations[label].clear();
+  }
+
+  // Scan the voxels in each voxel block that is currently in the local voxel block array, and record any that have a non-default label.
+  // Note that voxel blocks that have been swapped out to the global cache have a negative pointer, and are therefore skipped.
+  const ITMHashEntry *hashTable = scene->index.getIndexData();
+  const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+  for(int entryIndex = 0; entryIndex < ITMVoxelIndex::noTotalEntries; ++entryIndex)
+  {
+    const ITMHashEntry& hashEntry = hashTable[entryIndex];
+    if(hashEntry.ptr < 0) continue;
+
+    const SpaintVoxel *block = voxelData + hashEntry.ptr * SDF_BLOCK_SIZE3;
+    for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+    {
+      const SpaintVoxel::PackedLabel& packedLabel = block[linearIdx].packedLabel;
+      if(packedLabel == SpaintVoxel::PackedLabel()) continue;
+
+      const int x = linearIdx % SDF_BLOCK_SIZE;
+      const int y = (linearIdx / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE;
+      const int z = linearIdx / (SDF_BLOCK_SIZE * SDF_BLOCK_SIZE);
+      m_locations[packedLabel.label].push_back(Vector3s(
+        static_cast<short>(hashEntry.pos.x * SDF_BLOCK_SIZE + x),
+        static_cast<short>(hashEntry.pos.y * SDF_BLOCK_SIZE + y),
+        static_cast<short>(hashEntry.pos.z * SDF_BLOCK_SIZE + z)
+      ));
+    }
+  }
+
+  // Since each voxel has been recorded exactly once, the lists are already compact.
+  for(int label = 0; label < LABEL_COUNT; ++label)
+  {
+    m_compactedSizes[label] = m_locations[label].size();
+  }
+
+  m_valid = true;
+}
+
+//#################### PRIVATE MEMBER FUNCTIONS ####################
+
+void VoxelLabelIndex::compact(SpaintVoxel::Label label, const Scene *scene)
+{
+  std::vector<Vector3s>& locations = m_locations[label];
+
+  // If any entries have been added since the list was last compacted, remove any duplicates.
+  if(locations.size() > m_compactedSizes[label])
+  {
+    std::sort(locations.begin(), locations.end(), location_less);
+    locations.erase(std::unique(locations.begin(), locations.end()), locations.end());
+  }
+
+  // Remove the entries for any voxels that are in the local voxel block array but no longer have the label. Entries for voxels
+  // that are not in the local voxel block array are kept, since their voxels may still have the label when they are swapped in.
+  const ITMVoxelIndex::IndexData *indexData = scene->index.getIndexData();
+  const SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+
+  size_t keptCount = 0;
+  for(size_t i = 0, size = locations.size(); i < size; ++i)
+  {
+    bool isFound;
+    int voxelAddress = findVoxel(indexData, locations[i].toInt(), isFound);
+    if(isFound)
+    {
+      const SpaintVoxel::PackedLabel& packedLabel = voxelData[voxelAddress].packedLabel;
+      if(packedLabel.label != label || packedLabel == SpaintVoxel::PackedLabel()) continue;
+    }
+
+    locations[keptCount++] = locations[i];
+  }
+
+  locations.resize(keptCount);
+  m_compactedSizes[label] = keptCount;
+}
+
+void VoxelLabelIndex::compact_grown_lists(const Scene *scene)
+{
+  for(int label = 0; label < LABEL_COUNT; ++label)
+  {
+    if(m_locations[label].size() >= std::max(2 * m_compactedSizes[label], MIN_COMPACTION_SIZE))
+    {
+      compact(static_cast<SpaintVoxel::Label>(label), scene);
+    }
+  }
+}
+
+void VoxelLabelIndex::record_voxel(const Vector3s& loc, SpaintVoxel::PackedLabel label)
+{
+  // Voxels with the default label are never recorded, since there is no need to clear them.
+  if(!(label == SpaintVoxel::PackedLabel())) m_locations[label.label].push_back(loc);
+}
+
+}
@@ -0,0 +1,144 @@
+/**
+ * spaint: VoxelLabelJournal.cpp
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#include "markers/VoxelLabelJournal.h"
+
+#include <stdexcept>
+
+namespace spaint {
+
+//#################### CONSTRUCTORS ####################
+
+VoxelLabelJournal::VoxelLabelJournal()
+: m_voxelCount(0)
+{}
+
+VoxelLabelJournal::VoxelLabelJournal(const std::vector<Vector3s>& voxelLocations, const std::vector<SpaintVoxel::PackedLabel>& oldLabels)
+: m_voxelCount(voxelLocations.size())
+{
+  if(oldLabels.size() != m_voxelCount)
+  {
+    throw std::runtime_error("Error: Cannot construct a voxel label journal from different numbers of voxel locations and labels");
+  }
+
+  // Encode the voxel locations as runs of voxels that are adjacent along the x axis.
+  Vector3s expectedLoc(0, 0, 0);
+  for(size_t i = 0; i < m_voxelCount;)
+  {
+    const Vector3s& runStart = voxelLocations[i];
+    size_t runLength = 1;
+    while(i + runLength < m_voxelCount)
+    {
+      const Vector3s& loc = voxelLocations[i + runLength];
+      if(loc.x != runStart.x + static_cast<int>(runLength) || loc.y != runStart.y || loc.z != runStart.z) break;
+      ++runLength;
+    }
+
+    write_zigzag(runStart.x - expectedLoc.x, m_locationData);
+    write_zigzag(runStart.y - expectedLoc.y, m_locationData);
+    write_zigzag(runStart.z - expectedLoc.z, m_locationData);
+    write_varint(static_cast<unsigned int>(runLength - 1), m_locationData);
+
+    expectedLoc = Vector3s(static_cast<short>(runStart.x + runLength), runStart.y, runStart.z);
+    i += runLength;
+  }
+
+  // Encode the old labels as runs of identical labels.
+  for(size_t i = 0; i < m_voxelCount;)
+  {
+    const SpaintVoxel::PackedLabel& label = oldLabels[i];
+    size_t runLength = 1;
+    while(i + runLength < m_voxelCount && oldLabels[i + runLength] == label) ++runLength;
+
+    m_labelData.push_back(static_cast<uchar>((label.group << 6) | label.label));
+    write_varint(static_cast<unsigned int>(runLength - 1), m_labelData);
+
+    i += runLength;
+  }
+
+  // Release any excess capacity in the byte streams, since the journal may be kept for a long time.
+  std::vector<uchar>(m_labelData).swap(m_labelData);
+  std::vector<uchar>(m_locationData).swap(m_locationData);
+}
+
+//#################### PUBLIC MEMBER FUNCTIONS ####################
+
+void VoxelLabelJournal::decode(std::vector<Vector3s>& voxelLocations, std::vector<SpaintVoxel::PackedLabel>& oldLabels) const
+{
+  voxelLocations.clear();
+  voxelLocations.reserve(m_voxelCount);
+  oldLabels.clear();
+  oldLabels.reserve(m_voxelCount);
+
+  Vector3s expectedLoc(0, 0, 0);
+  for(size_t pos = 0, size = m_locationData.size(); pos < size;)
+  {
+    const int x = expectedLoc.x + read_zigzag(m_locationData, pos);
+    const int y = expectedLoc.y + read_zigzag(m_locationData, pos);
+    const int z = expectedLoc.z + read_zigzag(m_locationData, pos);
+    const int runLength = static_cast<int>(read_varint(m_locationData, pos)) + 1;
+
+    for(int j = 0; j < runLength; ++j)
+    {
+      voxelLocations.push_back(Vector3s(static_cast<short>(x + j), static_cast<short>(y), static_cast<short>(z)));
+    }
+
+    expectedLoc = Vector3s(static_cast<short>(x + runLength), static_cast<short>(y), static_cast<short>(z));
+  }
+
+  for(size_t pos = 0, size = m_labelData.size(); pos < size;)
+  {
+    const uchar packedLabel = m_labelData[pos++];
+    const SpaintVoxel::PackedLabel label(packedLabel & 0x3f, static_cast<SpaintVoxel::LabelGroup>(packedLabel >> 6));
+    const unsigned int runLength = read_varint(m_labelData, pos) + 1;
+    oldLabels.insert(oldLabels.end(), runLength, label);
+  }
+}
+
+size_t VoxelLabelJournal::get_memory_usage() const
+{
+  return sizeof(VoxelLabelJournal) + m_labelData.capacity() + m_locationData.capacity();
+}
+
+size_t VoxelLabelJournal::get_voxel_count() const
+{
+  return m_voxelCount;
+}
+
+//#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+
+unsigned int VoxelLabelJournal::read_varint(const std::vector<uchar>& data, size_t& pos)
+{
+  unsigned int value = 0;
+  for(int shift = 0;; shift += 7)
+  {
+    const uchar byte = data[pos++];
+    value |= static_cast<unsigned int>(byte & 0x7f) << shift;
+    if((byte & 0x80) == 0) return value;
+  }
+}
+
+int VoxelLabelJournal::read_zigzag(const std::vector<uchar>& data, size_t& pos)
+{
+  const unsigned int value = read_varint(data, pos);
+  return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+void VoxelLabelJournal::write_varint(unsigned int value, std::vector<uchar>& data)
+{
+  while(value >= 0x80)
+  {
+    data.push_back(static_cast<uchar>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  data.push_back(static_cast<uchar>(value));
+}
+
+void VoxelLabelJournal::write_zigzag(int value, std::vector<uchar>& data)
+{
+  write_varint((static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31), data);
+}
+
+}
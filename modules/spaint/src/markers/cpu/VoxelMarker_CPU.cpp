@@ -9,16 +9,55 @@
 
 namespace spaint {
 
+//#################### CONSTRUCTORS ####################
+
+VoxelMarker_CPU::VoxelMarker_CPU(const VoxelLabelIndex_Ptr& labelIndex)
+: m_labelIndex(labelIndex)
+{}
+
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
-void VoxelMarker_CPU::clear_labels(SpaintVoxel *voxels, int voxelCount, ClearingSettings settings) const
+void VoxelMarker_CPU::clear_labels(ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene, ClearingSettings settings) const
 {
+  // If there is no label index, sweep the whole voxel block array.
+  if(!m_labelIndex)
+  {
+    SpaintVoxel *voxels = scene->localVBA.GetVoxelBlocks();
+    int voxelCount = scene->localVBA.allocatedSize;
+
 #ifdef WITH_OPENMP
-  #pragma omp parallel for
+    #pragma omp parallel for
 #endif
-  for(int i = 0; i < voxelCount; ++i)
+    for(int i = 0; i < voxelCount; ++i)
+    {
+      clear_label(voxels[i], settings);
+    }
+
+    return;
+  }
+
+  // Otherwise, only visit the voxels that the index says may have labels that could be cleared. If the clearing mode only affects
+  // voxels with a specific label, that is just the voxels in the list for that label; if not, it is the voxels in all of the lists.
+  SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+  const ITMVoxelIndex::IndexData *voxelIndex = scene->index.getIndexData();
+
+  const bool singleLabel = settings.mode == CLEAR_EQ_LABEL || settings.mode == CLEAR_EQ_LABEL_NEQ_GROUP;
+  const int firstLabel = singleLabel ? settings.label : 0;
+  const int lastLabel = singleLabel ? settings.label : VoxelLabelIndex::LABEL_COUNT - 1;
+  for(int label = firstLabel; label <= lastLabel; ++label)
   {
-    clear_label(voxels[i], settings);
+    const std::vector<Vector3s>& voxelLocations = m_labelIndex->get_voxels(static_cast<SpaintVoxel::Label>(label), scene);
+    int voxelCount = static_cast<int>(voxelLocations.size());
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < voxelCount; ++i)
+    {
+      bool isFound;
+      int voxelAddress = findVoxel(voxelIndex, voxelLocations[i].toInt(), isFound);
+      if(isFound) clear_label(voxelData[voxelAddress], settings);
+    }
   }
 }
 
@@ -41,6 +80,8 @@ void VoxelMarker_CPU::mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLoc
   {
     mark_voxel(voxelLocations[i], label, oldVoxelLabels ? &oldVoxelLabels[i] : NULL, voxelData, voxelIndex, mode);
   }
+
+  if(m_labelIndex) m_labelIndex->add_voxels(voxelLocations, voxelCount, label, scene);
 }
 
 void VoxelMarker_CPU::mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB,
@@ -64,6 +105,13 @@ void VoxelMarker_CPU::mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLoc
   {
     mark_voxel(voxelLocations[i], voxelLabels[i], oldVoxelLabels ? &oldVoxelLabels[i] : NULL, voxelData, voxelIndex, mode);
   }
+
+  if(m_labelIndex) m_labelIndex->add_voxels(voxelLocations, voxelLabels, voxelCount, scene);
+}
+
+void VoxelMarker_CPU::notify_labels_changed() const
+{
+  if(m_labelIndex) m_labelIndex->invalidate();
 }
 
 }
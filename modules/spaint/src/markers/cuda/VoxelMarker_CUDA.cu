@@ -33,12 +33,15 @@ __global__ void ck_mark_voxels(const Vector3s *voxelLocations, const SpaintVoxel
 
 //#################### PUBLIC MEMBER FUNCTIONS ####################
 
-void VoxelMarker_CUDA::clear_labels(SpaintVoxel *voxels, int voxelCount, ClearingSettings settings) const
+void VoxelMarker_CUDA::clear_labels(ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene, ClearingSettings settings) const
 {
+  ITMLocalVBA<SpaintVoxel>& localVBA = scene->localVBA;
+  int voxelCount = localVBA.allocatedSize;
+
   int threadsPerBlock = 256;
   int numBlocks = (voxelCount + threadsPerBlock - 1) / threadsPerBlock;
 
-  ck_clear_labels<<<numBlocks,threadsPerBlock>>>(voxels, voxelCount, settings);
+  ck_clear_labels<<<numBlocks,threadsPerBlock>>>(localVBA.GetVoxelBlocks(), voxelCount, settings);
 }
 
 void VoxelMarker_CUDA::mark_voxels(const ORUtils::MemoryBlock<Vector3s>& voxelLocationsMB, SpaintVoxel::PackedLabel label,
@@ -5,14 +5,18 @@
 
 #include "propagation/cpu/LabelPropagator_CPU.h"
 
+#include <algorithm>
+
 #include "propagation/shared/LabelPropagator_Shared.h"
 
 namespace spaint {
 
 //#################### CONSTRUCTORS ####################
 
-LabelPropagator_CPU::LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels)
-: LabelPropagator(raycastResultSize, maxAngleBetweenNormals, maxSquaredDistanceBetweenColours, maxSquaredDistanceBetweenVoxels)
+LabelPropagator_CPU::LabelPropagator_CPU(size_t raycastResultSize, float maxAngleBetweenNormals, float maxSquaredDistanceBetweenColours, float maxSquaredDistanceBetweenVoxels,
+                                         int maxSweepsPerCall)
+: LabelPropagator(raycastResultSize, maxAngleBetweenNormals, maxSquaredDistanceBetweenColours, maxSquaredDistanceBetweenVoxels),
+  m_maxSweepsPerCall(maxSweepsPerCall)
 {}
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
@@ -34,6 +38,19 @@ void LabelPropagator_CPU::calculate_normals(const ITMFloat4Image *raycastResult,
   }
 }
 
+bool LabelPropagator_CPU::has_labelled_neighbours(int x, int y, int width, int height) const
+{
+  return (is_labelled(x - 2, y, width, height) && is_labelled(x - 5, y, width, height)) ||
+         (is_labelled(x + 2, y, width, height) && is_labelled(x + 5, y, width, height)) ||
+         (is_labelled(x, y - 2, width, height) && is_labelled(x, y - 5, width, height)) ||
+         (is_labelled(x, y + 2, width, height) && is_labelled(x, y + 5, width, height));
+}
+
+bool LabelPropagator_CPU::is_labelled(int x, int y, int width, int height) const
+{
+  return x >= 0 && x < width && y >= 0 && y < height && m_labelled[y * width + x];
+}
+
 void LabelPropagator_CPU::perform_propagation(SpaintVoxel::Label label, const ITMFloat4Image *raycastResult,
                                               ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> *scene) const
 {
@@ -45,16 +62,130 @@ void LabelPropagator_CPU::perform_propagation(SpaintVoxel::Label label, const IT
   SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
   const int width = raycastResult->noDims.x;
 
+  // Marking a voxel labels every pixel in the raycast result that maps to it, not just the pixel that was tested. We look for
+  // such pixels in a window of this radius around each newly-labelled pixel (voxels rarely span more pixels than this). The
+  // window is only an optimisation: if a voxel spans more pixels than this, the pixels beyond the window are still reached,
+  // since each of them is two pixels from a pixel of the same voxel that has been found, and is therefore retested (and
+  // passes the test, since its neighbours are labelled). The CPU test for the propagator checks this against repeated sweeps.
+  const int sharedVoxelWindowRadius = 5;
+
+  m_labelled.resize(raycastResultSize);
+  m_pixelVoxelLocations.resize(raycastResultSize);
+  m_queuedIterations.assign(raycastResultSize, -1);
+
+  // Determine which pixels in the raycast result already have voxels that are marked with the label being propagated.
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
   for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
   {
-    propagate_from_neighbours(
-      voxelIndex, width, height, label, raycastResultData, surfaceNormals, voxelData, indexData,
-      m_maxAngleBetweenNormals, m_maxSquaredDistanceBetweenColours, m_maxSquaredDistanceBetweenVoxels
-    );
+    Vector3f loc = raycastResultData[voxelIndex].toVector3();
+    m_pixelVoxelLocations[voxelIndex] = loc.toShortRound();
+
+    bool foundPoint;
+    const SpaintVoxel voxel = readVoxel(voxelData, indexData, loc.toIntRound(), foundPoint);
+    m_labelled[voxelIndex] = foundPoint && voxel.packedLabel.label == label;
+  }
+
+  // Make the initial candidates for propagation, namely the unlabelled pixels that have suitable labelled neighbours.
+  m_candidates.clear();
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      try_add_candidate(x, y, width, height, 0);
+    }
+  }
+
+  for(int iteration = 0; iteration < m_maxSweepsPerCall && !m_candidates.empty(); ++iteration)
+  {
+    // Test each candidate against its neighbours. The tests are all made before any of the candidates are marked,
+    // so that the result of the sweep does not depend on the order in which the candidates are processed.
+    const int candidateCount = static_cast<int>(m_candidates.size());
+    m_candidatesMarked.resize(candidateCount);
+
+#ifdef WITH_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < candidateCount; ++i)
+    {
+      m_candidatesMarked[i] = should_propagate_from_neighbours(
+        m_candidates[i], width, height, label, raycastResultData, surfaceNormals, voxelData, indexData,
+        m_maxAngleBetweenNormals, m_maxSquaredDistanceBetweenColours, m_maxSquaredDistanceBetweenVoxels
+      );
+    }
+
+    // Mark the candidates that passed their tests with the label being propagated.
+    for(int i = 0; i < candidateCount; ++i)
+    {
+      if(m_candidatesMarked[i])
+      {
+        mark_voxel(m_pixelVoxelLocations[m_candidates[i]], SpaintVoxel::PackedLabel(label, SpaintVoxel::LG_PROPAGATED), NULL, voxelData, indexData);
+      }
+    }
+
+    // If this was the last sweep we are allowed to perform, there is no need to find the candidates for the next one.
+    if(iteration + 1 == m_maxSweepsPerCall) break;
+
+    // Add all of the pixels that are now labelled to the frontier.
+    m_frontier.clear();
+    for(int i = 0; i < candidateCount; ++i)
+    {
+      if(!m_candidatesMarked[i]) continue;
+
+      // If the voxel could not actually be marked (e.g. because it has a different label that was supplied by the user), skip it.
+      const int voxelIndex = m_candidates[i];
+      const Vector3s& voxelLoc = m_pixelVoxelLocations[voxelIndex];
+      bool foundPoint;
+      const SpaintVoxel voxel = readVoxel(voxelData, indexData, voxelLoc.toInt(), foundPoint);
+      if(!foundPoint || voxel.packedLabel.label != label) continue;
+
+      // Add the pixel itself and any nearby pixels that map to the same voxel.
+      const int x = voxelIndex % width, y = voxelIndex / width;
+      for(int ny = std::max(y - sharedVoxelWindowRadius, 0), nyEnd = std::min(y + sharedVoxelWindowRadius, height - 1); ny <= nyEnd; ++ny)
+      {
+        for(int nx = std::max(x - sharedVoxelWindowRadius, 0), nxEnd = std::min(x + sharedVoxelWindowRadius, width - 1); nx <= nxEnd; ++nx)
+        {
+          const int neighbourIndex = ny * width + nx;
+          const Vector3s& neighbourVoxelLoc = m_pixelVoxelLocations[neighbourIndex];
+          if(!m_labelled[neighbourIndex] && neighbourVoxelLoc.x == voxelLoc.x && neighbourVoxelLoc.y == voxelLoc.y && neighbourVoxelLoc.z == voxelLoc.z)
+          {
+            m_labelled[neighbourIndex] = true;
+            m_frontier.push_back(neighbourIndex);
+          }
+        }
+      }
+    }
+
+    // Make the candidates for the next iteration. Since a pixel can only be labelled if both its neighbours at distances
+    // 2 and 5 in some direction are labelled, the only pixels whose status can have changed are those at these distances
+    // from the frontier.
+    m_candidates.clear();
+    for(size_t i = 0, size = m_frontier.size(); i < size; ++i)
+    {
+      const int x = m_frontier[i] % width, y = m_frontier[i] / width;
+      try_add_candidate(x + 2, y, width, height, iteration + 1);
+      try_add_candidate(x + 5, y, width, height, iteration + 1);
+      try_add_candidate(x - 2, y, width, height, iteration + 1);
+      try_add_candidate(x - 5, y, width, height, iteration + 1);
+      try_add_candidate(x, y + 2, width, height, iteration + 1);
+      try_add_candidate(x, y + 5, width, height, iteration + 1);
+      try_add_candidate(x, y - 2, width, height, iteration + 1);
+      try_add_candidate(x, y - 5, width, height, iteration + 1);
+    }
   }
 }
 
+void LabelPropagator_CPU::try_add_candidate(int x, int y, int width, int height, int iteration) const
+{
+  if(x < 0 || x >= width || y < 0 || y >= height) return;
+
+  const int voxelIndex = y * width + x;
+  if(m_labelled[voxelIndex] || m_queuedIterations[voxelIndex] == iteration) return;
+  if(!has_labelled_neighbours(x, y, width, height)) return;
+
+  m_queuedIterations[voxelIndex] = iteration;
+  m_candidates.push_back(voxelIndex);
+}
+
 }
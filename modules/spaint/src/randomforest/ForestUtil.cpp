@@ -9,26 +9,24 @@ namespace spaint {
 
 //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
 
-std::vector<rafl::Descriptor_CPtr> ForestUtil::make_descriptors(const ORUtils::MemoryBlock<float>& featuresMB, size_t descriptorCount, size_t featureCount)
+void ForestUtil::make_descriptors(const ORUtils::MemoryBlock<float>& featuresMB, size_t descriptorCount, size_t featureCount, rafl::DescriptorArena& descriptorArena)
 {
   // Make sure that the features are available and up-to-date on the CPU.
   featuresMB.UpdateHostFromDevice();
 
   // Make the rafl feature descriptors.
   const float *features = featuresMB.GetData(MEMORYDEVICE_CPU);
-  std::vector<rafl::Descriptor_CPtr> descriptors(descriptorCount);
+  descriptorArena.resize(descriptorCount, featureCount);
 
 #ifdef WITH_OPENMP
   #pragma omp parallel for
 #endif
   for(int i = 0; i < static_cast<int>(descriptorCount); ++i)
   {
-    // Copy the relevant features into a descriptor and add it.
+    // Copy the relevant features into a row of the arena.
     const float *featuresForDescriptor = features + i * featureCount;
-    descriptors[i].reset(new rafl::Descriptor(featuresForDescriptor, featuresForDescriptor + featureCount));
+    std::copy(featuresForDescriptor, featuresForDescriptor + featureCount, descriptorArena.get_row(i));
   }
-
-  return descriptors;
 }
 
 }
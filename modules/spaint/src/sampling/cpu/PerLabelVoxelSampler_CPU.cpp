@@ -5,6 +5,10 @@
 
 #include "sampling/cpu/PerLabelVoxelSampler_CPU.h"
 
+#include <vector>
+
+#include <tvgutil/PrefixSumUtil.h>
+
 #include "sampling/shared/PerLabelVoxelSampler_Shared.h"
 
 namespace spaint {
@@ -23,21 +27,15 @@ void PerLabelVoxelSampler_CPU::calculate_voxel_mask_prefix_sums(const ORUtils::M
   const unsigned char *voxelMasks = m_voxelMasksMB->GetData(MEMORYDEVICE_CPU);
   unsigned int *voxelMaskPrefixSums = m_voxelMaskPrefixSumsMB->GetData(MEMORYDEVICE_CPU);
 
-  // For each possible label:
-  const int stride = m_raycastResultSize + 1;
-  for(size_t k = 0; k < m_maxLabelCount; ++k)
+  // Determine which labels are currently in use.
+  std::vector<int> usedLabels;
+  for(int k = 0; k < static_cast<int>(m_maxLabelCount); ++k)
   {
-    // If the label is not currently in use, continue.
-    if(!labelMask[k]) continue;
-
-    // Calculate the prefix sum of the voxel mask.
-    const size_t offset = k * stride;
-    voxelMaskPrefixSums[offset] = 0;
-    for(int i = 1; i < stride; ++i)
-    {
-      voxelMaskPrefixSums[offset + i] = voxelMaskPrefixSums[offset + (i - 1)] + voxelMasks[offset + (i - 1)];
-    }
+    if(labelMask[k]) usedLabels.push_back(k);
   }
+
+  // Calculate the prefix sums of the voxel masks for all of the used labels in a single parallel pass.
+  tvgutil::PrefixSumUtil::calculate_exclusive_prefix_sums(voxelMasks, voxelMaskPrefixSums, m_raycastResultSize + 1, usedLabels);
 }
 
 void PerLabelVoxelSampler_CPU::calculate_voxel_masks(const ITMFloat4Image *raycastResult,
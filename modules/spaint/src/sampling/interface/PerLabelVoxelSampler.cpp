@@ -5,10 +5,21 @@
 
 #include "sampling/interface/PerLabelVoxelSampler.h"
 
-#include <tvgutil/RandomNumberGenerator.h>
+#include <algorithm>
+
+#include <tvgutil/ThreadLocalRNG.h>
 
 #include "util/MemoryBlockFactory.h"
 
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/** The number of random number streams used to choose the candidate voxel indices (fixed, so that the choice does not depend on the number of threads). */
+const size_t RNG_STREAM_COUNT = 16;
+
+}
+
 namespace spaint {
 
 //#################### CONSTRUCTORS ####################
@@ -19,7 +30,7 @@ PerLabelVoxelSampler::PerLabelVoxelSampler(size_t maxLabelCount, size_t maxVoxel
   m_maxLabelCount(maxLabelCount),
   m_maxVoxelsPerLabel(maxVoxelsPerLabel),
   m_raycastResultSize(raycastResultSize),
-  m_rng(new tvgutil::RandomNumberGenerator(seed)),
+  m_rng(new tvgutil::ThreadLocalRNG(seed, RNG_STREAM_COUNT)),
   m_voxelMaskPrefixSumsMB(MemoryBlockFactory::instance().make_block<unsigned int>(maxLabelCount * (raycastResultSize + 1))),
   m_voxelMasksMB(MemoryBlockFactory::instance().make_block<unsigned char>(maxLabelCount * (raycastResultSize + 1)))
 {
@@ -95,32 +106,31 @@ void PerLabelVoxelSampler::choose_candidate_voxel_indices(const ORUtils::MemoryB
   const unsigned int *voxelCountsForLabels = voxelCountsForLabelsMB.GetData(MEMORYDEVICE_CPU);
   int *candidateVoxelIndices = m_candidateVoxelIndicesMB->GetData(MEMORYDEVICE_CPU);
 
-  // For each possible label:
-  for(size_t k = 0; k < m_maxLabelCount; ++k)
+  // For each candidate voxel index of each used label, either use the corresponding candidate voxel (if we don't have enough
+  // candidate voxels for the label, in which case we use all of the ones we do have), or choose one of the candidate voxels at
+  // random (if we do have enough candidate voxels, in which case we sample the maximum possible number of voxels from them).
+  // The indices are divided into a fixed number of contiguous chunks, each of which is chosen using its own random number
+  // stream, so all of the indices can be chosen in a single parallel loop without contention.
+  const int maxVoxelsPerLabel = static_cast<int>(m_maxVoxelsPerLabel);
+  const int indexCount = static_cast<int>(m_maxLabelCount) * maxVoxelsPerLabel;
+  const int streamCount = static_cast<int>(RNG_STREAM_COUNT);
+  const int chunkSize = (indexCount + streamCount - 1) / streamCount;
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for(int streamIndex = 0; streamIndex < streamCount; ++streamIndex)
   {
-    // If the label is not currently in use, ignore it.
-    if(!labelMask[k]) continue;
-
-    if(voxelCountsForLabels[k] < m_maxVoxelsPerLabel)
+    for(int j = streamIndex * chunkSize, end = std::min(j + chunkSize, indexCount); j < end; ++j)
     {
-      // If we don't have enough candidate voxels for this label, just use all of the ones we do have.
-      for(size_t i = 0; i < voxelCountsForLabels[k]; ++i)
-      {
-        candidateVoxelIndices[k * m_maxVoxelsPerLabel + i] = static_cast<int>(i);
-      }
-
-      for(size_t i = voxelCountsForLabels[k]; i < m_maxVoxelsPerLabel; ++i)
-      {
-        candidateVoxelIndices[k * m_maxVoxelsPerLabel + i] = -1;
-      }
-    }
-    else
-    {
-      // If we do have enough candidate voxels for this label, sample the maximum possible number of voxels from the candidates.
-      for(size_t i = 0; i < m_maxVoxelsPerLabel; ++i)
-      {
-        candidateVoxelIndices[k * m_maxVoxelsPerLabel + i] = m_rng->generate_int_from_uniform(0, voxelCountsForLabels[k] - 1);
-      }
+      // If the label is not currently in use, ignore it.
+      const int k = j / maxVoxelsPerLabel;
+      if(!labelMask[k]) continue;
+
+      const int i = j % maxVoxelsPerLabel;
+      const int voxelCount = static_cast<int>(voxelCountsForLabels[k]);
+      if(voxelCount < maxVoxelsPerLabel) candidateVoxelIndices[j] = i < voxelCount ? i : -1;
+      else candidateVoxelIndices[j] = m_rng->generate_int_from_uniform(0, voxelCount - 1, streamIndex);
     }
   }
 
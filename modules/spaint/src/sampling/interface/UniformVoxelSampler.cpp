@@ -5,17 +5,31 @@
 
 #include "sampling/interface/UniformVoxelSampler.h"
 
-#include <tvgutil/RandomNumberGenerator.h>
+#include <algorithm>
+
+#include <tvgutil/ThreadLocalRNG.h>
 
 #include "util/MemoryBlockFactory.h"
 
+namespace {
+
+//#################### LOCAL CONSTANTS ####################
+
+/**
+ * The number of random number streams to use. Each stream is used for a fixed chunk of the samples, so the samples chosen
+ * depend only on the seed, and not on the number of threads available on the machine.
+ */
+const size_t RNG_STREAM_COUNT = 16;
+
+}
+
 namespace spaint {
 
 //#################### CONSTRUCTORS ####################
 
 UniformVoxelSampler::UniformVoxelSampler(int raycastResultSize, unsigned int seed)
 : m_raycastResultSize(raycastResultSize),
-  m_rng(new tvgutil::RandomNumberGenerator(seed)),
+  m_rng(new tvgutil::ThreadLocalRNG(seed, RNG_STREAM_COUNT)),
   m_sampledVoxelIndicesMB(MemoryBlockFactory::instance().make_block<int>(raycastResultSize))
 {}
 
@@ -27,11 +41,22 @@ UniformVoxelSampler::~UniformVoxelSampler() {}
 
 void UniformVoxelSampler::sample_voxels(const ITMFloat4Image *raycastResult, size_t numVoxelsToSample, ORUtils::MemoryBlock<Vector3s>& sampledVoxelLocationsMB) const
 {
-  // Choose which voxels to sample from the raycast result.
+  // Choose which voxels to sample from the raycast result. The samples are divided into a fixed number of contiguous chunks,
+  // each of which is chosen using its own random number stream, so the chunks can be processed in parallel without contention.
   int *sampledVoxelIndices = m_sampledVoxelIndicesMB->GetData(MEMORYDEVICE_CPU);
-  for(size_t i = 0; i < numVoxelsToSample; ++i)
+  const int voxelsToSample = static_cast<int>(numVoxelsToSample);
+  const int streamCount = static_cast<int>(RNG_STREAM_COUNT);
+  const int chunkSize = (voxelsToSample + streamCount - 1) / streamCount;
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for(int streamIndex = 0; streamIndex < streamCount; ++streamIndex)
   {
-    sampledVoxelIndices[i] = m_rng->generate_int_from_uniform(0, m_raycastResultSize - 1);
+    for(int i = streamIndex * chunkSize, end = std::min(i + chunkSize, voxelsToSample); i < end; ++i)
+    {
+      sampledVoxelIndices[i] = m_rng->generate_int_from_uniform(0, m_raycastResultSize - 1, streamIndex);
+    }
   }
   m_sampledVoxelIndicesMB->UpdateDeviceFromHost();
 
@@ -28,15 +28,15 @@ namespace spaint {
 //#################### CONSTRUCTORS ####################
 
 TouchSelector::TouchSelector(const ITMSettings_CPtr& itmSettings, const TouchSettings_Ptr& touchSettings, const TrackingState_Ptr& trackingState,
-                             const View_Ptr& view, size_t maxKeptTouchPoints)
+                             const ViewProvider& viewProvider, size_t maxKeptTouchPoints)
 : Selector(itmSettings),
   m_keptTouchPointCount(0),  
   m_keptTouchPointsFloatMB(new ORUtils::MemoryBlock<Vector3f>(maxKeptTouchPoints, true, true)),
   m_keptTouchPointsShortMB(new ORUtils::MemoryBlock<Vector3s>(maxKeptTouchPoints, true, true)),
   m_maxKeptTouchPoints(maxKeptTouchPoints),
-  m_touchDetector(new TouchDetector(view->depth->noDims, itmSettings, touchSettings)),
+  m_touchDetector(new TouchDetector(viewProvider()->depth->noDims, itmSettings, touchSettings)),
   m_trackingState(trackingState),
-  m_view(view)
+  m_viewProvider(viewProvider)
 {
   m_isActive = true;
 
@@ -96,9 +96,10 @@ Selector::Selection_CPtr TouchSelector::get_selection() const
 
 void TouchSelector::update(const InputState& inputState, const RenderState_CPtr& renderState, bool renderingInMono)
 {
-  // Detect any points that the user is touching in the scene.
+  // Detect any points that the user is touching in the scene. Note that we only hold on to the current view for the duration of the update.
   MoveableCamera_CPtr camera(new SimpleCamera(CameraPoseConverter::pose_to_camera(*m_trackingState->pose_d)));
-  ITMFloatImage_Ptr depthImage(m_view->depth, boost::serialization::null_deleter());
+  View_CPtr view = m_viewProvider();
+  ITMFloatImage_Ptr depthImage(view->depth, boost::serialization::null_deleter());
   TIME(std::vector<Eigen::Vector2i> touchPoints = m_touchDetector->determine_touch_points(camera, depthImage, renderState), milliseconds, runningTouchDetectorOnFrame);
 #if DEBUGGING
   std::cout << runningTouchDetectorOnFrame << '\n';
@@ -76,8 +76,8 @@ TouchDetector::TouchDetector(const Vector2i& imgSize, const ITMSettings_CPtr& it
   m_forest = m_touchSettings->load_forest();
 
 #if defined(DEBUG_TOUCH_VERBOSE)
-  // Output the statistics of the forest for debugging purposes.
-  m_forest->output_statistics(std::cout);
+  // Output the size of the forest for debugging purposes.
+  std::cout << "Trees = " << m_forest->get_tree_count() << ", Nodes = " << m_forest->get_node_count() << ", Labels = " << m_forest->get_label_count() << '\n';
 #endif
 }
 
@@ -63,15 +63,17 @@ const std::string& TouchSettings::get_save_candidate_components_path() const
   return saveCandidateComponentsPath;
 }
 
-TouchSettings::RF_Ptr TouchSettings::load_forest() const
+TouchSettings::CF_CPtr TouchSettings::load_forest() const
 {
-  // Register the relevant decision function generators with the factory.
+  // If the forest has been saved as a binary model, map it into memory directly.
+  if(fullForestPath.extension() == ".rfb") return CF::load_binary(fullForestPath.string());
+
+  // Otherwise, register the relevant decision function generators with the factory.
   rafl::DecisionFunctionGeneratorFactory<Label>::instance().register_rafl_makers();
 
-  // Load the forest.
+  // Load the forest and compile it.
   RF_Ptr forest = SerializationUtil::load_text(fullForestPath.string(), forest);
-
-  return forest;
+  return CF_CPtr(new CF(*forest));
 }
 
 bool TouchSettings::should_save_candidate_components() const
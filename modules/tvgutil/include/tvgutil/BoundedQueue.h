@@ -0,0 +1,151 @@
+/**
+ * tvgutil: BoundedQueue.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_TVGUTIL_BOUNDEDQUEUE
+#define H_TVGUTIL_BOUNDEDQUEUE
+
+#include <deque>
+#include <stdexcept>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace tvgutil {
+
+/**
+ * \brief An instance of an instantiation of this class template represents a thread-safe FIFO queue with a fixed capacity.
+ *
+ * Pushing onto a full queue blocks until space becomes available, and popping from an empty queue blocks until an element
+ * becomes available. This makes the queue suitable for handing work from one stage of a pipeline to the next, since a stage
+ * that gets too far ahead of its successor will automatically be made to wait. A queue can be closed to indicate that no
+ * more elements will be pushed onto it: once this has happened, pops drain any remaining elements and then fail.
+ */
+template <typename T>
+class BoundedQueue
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The maximum number of elements the queue can contain. */
+  size_t m_capacity;
+
+  /** Whether or not the queue has been closed. */
+  bool m_closed;
+
+  /** The elements in the queue. */
+  std::deque<T> m_elements;
+
+  /** The mutex used to synchronise access to the queue. */
+  mutable boost::mutex m_mutex;
+
+  /** A condition variable that is signalled when an element is pushed or the queue is closed. */
+  boost::condition_variable m_notEmpty;
+
+  /** A condition variable that is signalled when an element is popped or the queue is closed. */
+  boost::condition_variable m_notFull;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a bounded queue.
+   *
+   * \param capacity              The maximum number of elements the queue can contain.
+   * \throws std::invalid_argument If the capacity is zero.
+   */
+  explicit BoundedQueue(size_t capacity)
+  : m_capacity(capacity), m_closed(false)
+  {
+    if(capacity == 0) throw std::invalid_argument("Cannot construct a bounded queue with zero capacity");
+  }
+
+  //#################### COPY CONSTRUCTOR & ASSIGNMENT OPERATOR ####################
+private:
+  // Deliberately private and unimplemented.
+  BoundedQueue(const BoundedQueue&);
+  BoundedQueue& operator=(const BoundedQueue&);
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Closes the queue, waking any threads that are waiting to push or pop.
+   */
+  void close()
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_closed = true;
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+  }
+
+  /**
+   * \brief Gets the maximum number of elements the queue can contain.
+   *
+   * \return  The maximum number of elements the queue can contain.
+   */
+  size_t capacity() const
+  {
+    return m_capacity;
+  }
+
+  /**
+   * \brief Gets whether or not the queue has been closed.
+   *
+   * \return  true, if the queue has been closed, or false otherwise.
+   */
+  bool is_closed() const
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    return m_closed;
+  }
+
+  /**
+   * \brief Pops the element at the front of the queue, waiting for one to become available if necessary.
+   *
+   * \param element A location into which to write the popped element.
+   * \return        true, if an element was popped, or false if the queue was closed and is empty.
+   */
+  bool pop(T& element)
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while(m_elements.empty() && !m_closed) m_notEmpty.wait(lock);
+    if(m_elements.empty()) return false;
+
+    element = m_elements.front();
+    m_elements.pop_front();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  /**
+   * \brief Pushes an element onto the back of the queue, waiting for space to become available if necessary.
+   *
+   * \param element The element to push.
+   * \return        true, if the element was pushed, or false if the queue was closed.
+   */
+  bool push(const T& element)
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while(m_elements.size() >= m_capacity && !m_closed) m_notFull.wait(lock);
+    if(m_closed) return false;
+
+    m_elements.push_back(element);
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+  /**
+   * \brief Gets the number of elements currently in the queue.
+   *
+   * \return  The number of elements currently in the queue.
+   */
+  size_t size() const
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    return m_elements.size();
+  }
+};
+
+}
+
+#endif
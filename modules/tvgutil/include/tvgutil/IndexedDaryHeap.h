@@ -0,0 +1,469 @@
+/**
+ * tvgutil: IndexedDaryHeap.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_TVGUTIL_INDEXEDDARYHEAP
+#define H_TVGUTIL_INDEXEDDARYHEAP
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+
+namespace tvgutil {
+
+/**
+ * \brief An instance of an instantiation of this class template represents a priority queue over small, non-negative integer IDs
+ *        that allows the keys of queue elements to be updated in-place.
+ *
+ * This has the same interface as PriorityQueue, but is designed to scale to large numbers of elements. Rather than maintaining
+ * a map from IDs to heap positions, it maintains a dense array indexed by ID, so finding an element is a single array access.
+ * The heap itself is a d-ary heap (4-ary by default), which is shallower than a binary heap and whose children are adjacent in
+ * memory, making sifts cheaper. It also supports updating the keys of many elements at once (rebuilding the heap in linear time
+ * if enough of the keys have changed), and popping several elements at once.
+ *
+ * Note that the dense position array has as many entries as the largest ID ever inserted (plus one), so the IDs should be drawn
+ * from a compact range (e.g. they could be the indices of the nodes in a tree).
+ *
+ * \tparam ID     The element ID type (a non-negative integer used for the lookup)
+ * \tparam Key    The key type (the type of the priority values used to determine the element order)
+ * \tparam Data   The auxiliary data type (any information clients might wish to store with each element)
+ * \tparam Comp   A predicate specifying how the keys should be compared (the default predicate is std::less<Key>,
+ *                which specifies that elements with smaller keys will be extracted first)
+ * \tparam Arity  The number of children of each node in the heap
+ */
+template <typename ID, typename Key, typename Data, typename Comp = std::less<Key>, size_t Arity = 4>
+class IndexedDaryHeap
+{
+  BOOST_STATIC_ASSERT(boost::is_integral<ID>::value);
+  BOOST_STATIC_ASSERT(Arity >= 2);
+
+  //#################### NESTED CLASSES ####################
+public:
+  /**
+   * \brief Each element of the heap stores its ID, its key and potentially some auxiliary data that may be useful to client code.
+   *
+   * Its auxiliary data may be changed by the client, but its key may only be changed via the heap's update_key() and update_keys() methods.
+   */
+  class Element
+  {
+  private:
+    ID m_id;
+    Key m_key;
+    Data m_data;
+
+  public:
+    Element() : m_id(), m_key(), m_data() {}
+    Element(const ID& id, const Key& key, const Data& data) : m_id(id), m_key(key), m_data(data) {}
+
+    Data& data()            { return m_data; }
+    const ID& id() const    { return m_id; }
+    const Key& key() const  { return m_key; }
+
+    friend class IndexedDaryHeap;
+
+    //~~~~~~~~~~~~~~~~~~~~ SERIALIZATION ~~~~~~~~~~~~~~~~~~~~
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+      ar & m_id;
+      ar & m_key;
+      ar & m_data;
+    }
+
+    friend class boost::serialization::access;
+  };
+
+  //#################### CONSTANTS ####################
+private:
+  /** The value stored in the position array for IDs that are not in the heap. */
+  static const size_t NOT_PRESENT = static_cast<size_t>(-1);
+
+  /** The minimum number of elements that a bulk update must change (relative to the size of the heap) before it is worth rebuilding the heap. */
+  static const size_t REBUILD_DIVISOR = 4;
+
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The elements in the heap. */
+  std::vector<Element> m_heap;
+
+  /** The positions of the elements in the heap, indexed by ID (NOT_PRESENT for IDs that are not in the heap). */
+  std::vector<size_t> m_positions;
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Clears the heap.
+   */
+  void clear()
+  {
+    std::vector<Element>().swap(m_heap);
+    std::vector<size_t>().swap(m_positions);
+  }
+
+  /**
+   * \brief Returns whether or not the heap contains an element with the specified ID.
+   *
+   * \param id  The ID.
+   * \return    true, if it does contain such an element, or false otherwise.
+   */
+  bool contains(ID id) const
+  {
+    return id >= 0 && static_cast<size_t>(id) < m_positions.size() && m_positions[id] != NOT_PRESENT;
+  }
+
+  /**
+   * \brief Returns a reference to the element with the specified ID.
+   *
+   * \pre
+   *   - contains(id)
+   *
+   * \param id  The ID.
+   * \return    The element with the specified ID.
+   */
+  Element& element(ID id)
+  {
+    return m_heap[m_positions[id]];
+  }
+
+  /**
+   * \brief Returns whether or not the heap is empty.
+   *
+   * \return  true, if the heap is empty, or false otherwise.
+   */
+  bool empty() const
+  {
+    return m_heap.empty();
+  }
+
+  /**
+   * \brief Erases the element with the specified ID from the heap.
+   *
+   * \pre
+   *   - contains(id)
+   * \post
+   *   - !contains(id)
+   *
+   * \param id  The ID.
+   */
+  void erase(ID id)
+  {
+    size_t i = m_positions[id];
+    m_positions[id] = NOT_PRESENT;
+
+    // Move the last element in the heap into the hole, and restore the heap property around it.
+    Element last = m_heap.back();
+    m_heap.pop_back();
+    if(i < m_heap.size())
+    {
+      if(i > 0 && Comp()(last.key(), m_heap[parent(i)].key())) sift_up(i, last);
+      else sift_down(i, last);
+    }
+  }
+
+  /**
+   * \brief Inserts a new element into the heap.
+   *
+   * \param id                    The new element's ID.
+   * \param key                   The new element's key.
+   * \param data                  The new element's auxiliary data.
+   * \throws std::invalid_argument If the ID is negative.
+   * \throws std::runtime_error    If an element with the specified ID is already in the heap.
+   */
+  void insert(ID id, const Key& key, const Data& data)
+  {
+    if(id < 0) throw std::invalid_argument("Cannot insert an element with a negative ID into an indexed heap");
+    if(contains(id)) throw std::runtime_error("An element with the specified ID is already in the heap");
+
+    if(static_cast<size_t>(id) >= m_positions.size()) m_positions.resize(id + 1, NOT_PRESENT);
+
+    Element e(id, key, data);
+    m_heap.push_back(e);
+    sift_up(m_heap.size() - 1, e);
+  }
+
+  /**
+   * \brief Removes the element at the front of the heap.
+   *
+   * \pre
+   *   - !empty()
+   */
+  void pop()
+  {
+    erase(m_heap[0].id());
+  }
+
+  /**
+   * \brief Removes up to k elements from the front of the heap.
+   *
+   * \param k The maximum number of elements to remove.
+   * \return  The removed elements, in the order in which they would have been removed by repeated calls to pop().
+   */
+  std::vector<Element> pop_k(size_t k)
+  {
+    std::vector<Element> result;
+    result.reserve(std::min(k, m_heap.size()));
+    while(result.size() < k && !m_heap.empty())
+    {
+      result.push_back(m_heap[0]);
+      pop();
+    }
+    return result;
+  }
+
+  /**
+   * \brief Returns the number of elements in the heap.
+   *
+   * \return  The number of elements in the heap.
+   */
+  size_t size() const
+  {
+    return m_heap.size();
+  }
+
+  /**
+   * \brief Returns the element at the front of the heap.
+   *
+   * \pre
+   *   - !empty()
+   *
+   * \return  The element at the front of the heap.
+   */
+  const Element& top() const
+  {
+    return m_heap[0];
+  }
+
+  /**
+   * \brief Updates the key of the specified element with a new value.
+   *
+   * \pre
+   *   - contains(id)
+   *
+   * \param id  The ID of the element whose key is to be updated.
+   * \param key The new key value.
+   */
+  void update_key(ID id, const Key& key)
+  {
+    size_t i = m_positions[id];
+    Element e = m_heap[i];
+    if(Comp()(key, e.key()))
+    {
+      // The element should move towards the front of the heap.
+      e.m_key = key;
+      sift_up(i, e);
+    }
+    else if(Comp()(e.key(), key))
+    {
+      // The element should move towards the back of the heap.
+      e.m_key = key;
+      sift_down(i, e);
+    }
+  }
+
+  /**
+   * \brief Updates the keys of the specified elements with new values.
+   *
+   * If enough of the elements in the heap are being updated, the new keys are written in place and the heap is rebuilt in
+   * linear time. Otherwise, the elements are updated one at a time. Either way, the heap contains the same set of elements
+   * and keys afterwards, but elements with equal keys may end up in a different order than if update_key had been used.
+   *
+   * \pre
+   *   - contains(ids[i]) for each i
+   *
+   * \param ids                   The IDs of the elements whose keys are to be updated.
+   * \param keys                  The new key values (one per ID).
+   * \throws std::invalid_argument If the numbers of IDs and keys differ.
+   */
+  void update_keys(const std::vector<ID>& ids, const std::vector<Key>& keys)
+  {
+    if(ids.size() != keys.size()) throw std::invalid_argument("The numbers of IDs and keys must be the same");
+
+    if(ids.size() * REBUILD_DIVISOR >= m_heap.size())
+    {
+      for(size_t i = 0, size = ids.size(); i < size; ++i)
+      {
+        m_heap[m_positions[ids[i]]].m_key = keys[i];
+      }
+      rebuild();
+    }
+    else
+    {
+      for(size_t i = 0, size = ids.size(); i < size; ++i)
+      {
+        update_key(ids[i], keys[i]);
+      }
+    }
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Places an element at the specified position in the heap, and records its position.
+   *
+   * \param i The position.
+   * \param e The element.
+   */
+  void place(size_t i, const Element& e)
+  {
+    m_heap[i] = e;
+    m_positions[e.id()] = i;
+  }
+
+  /**
+   * \brief Rebuilds the heap from its elements (in linear time), and recalculates their positions.
+   */
+  void rebuild()
+  {
+    for(size_t i = 0, size = m_heap.size(); i < size; ++i)
+    {
+      m_positions[m_heap[i].id()] = i;
+    }
+
+    if(m_heap.size() < 2) return;
+
+    for(size_t i = parent(m_heap.size() - 1) + 1; i-- > 0;)
+    {
+      Element e = m_heap[i];
+      sift_down(i, e);
+    }
+  }
+
+  /**
+   * \brief Moves an element down from the specified (vacant) position in the heap until the heap property is restored.
+   *
+   * \param i The position from which to start.
+   * \param e The element to place.
+   */
+  void sift_down(size_t i, const Element& e)
+  {
+    const size_t size = m_heap.size();
+    for(;;)
+    {
+      // Find the best child of the current position (if any).
+      size_t firstChild = first_child(i);
+      if(firstChild >= size) break;
+
+      size_t bestChild = firstChild;
+      for(size_t c = firstChild + 1, cend = std::min(firstChild + Arity, size); c < cend; ++c)
+      {
+        if(Comp()(m_heap[c].key(), m_heap[bestChild].key())) bestChild = c;
+      }
+
+      // If the element should come before its best child, we're done. Otherwise, move the child up into the hole.
+      if(!Comp()(m_heap[bestChild].key(), e.key())) break;
+      place(i, m_heap[bestChild]);
+      i = bestChild;
+    }
+
+    place(i, e);
+  }
+
+  /**
+   * \brief Moves an element up from the specified (vacant) position in the heap until the heap property is restored.
+   *
+   * \param i The position from which to start.
+   * \param e The element to place.
+   */
+  void sift_up(size_t i, const Element& e)
+  {
+    while(i > 0 && Comp()(e.key(), m_heap[parent(i)].key()))
+    {
+      size_t p = parent(i);
+      place(i, m_heap[p]);
+      i = p;
+    }
+
+    place(i, e);
+  }
+
+  //#################### PRIVATE STATIC MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Gets the position of the first child of the specified position in the heap.
+   *
+   * \param i The position.
+   * \return  The position of its first child.
+   */
+  static size_t first_child(size_t i)
+  {
+    return Arity * i + 1;
+  }
+
+  /**
+   * \brief Gets the position of the parent of the specified (non-root) position in the heap.
+   *
+   * \param i The position.
+   * \return  The position of its parent.
+   */
+  static size_t parent(size_t i)
+  {
+    return (i - 1) / Arity;
+  }
+
+  //#################### SERIALIZATION ####################
+private:
+  /**
+   * \brief Loads the heap from an archive.
+   *
+   * The heap is rebuilt after loading, so this can load heaps saved by PriorityQueue as well as ones saved by IndexedDaryHeap.
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void load(Archive& ar, const unsigned int version)
+  {
+    std::map<ID,size_t> dictionary;
+    ar & dictionary;
+    ar & m_heap;
+
+    m_positions.assign(dictionary.empty() ? 0 : static_cast<size_t>(dictionary.rbegin()->first) + 1, NOT_PRESENT);
+    rebuild();
+  }
+
+  /**
+   * \brief Saves the heap to an archive.
+   *
+   * The heap is saved in the same format as a PriorityQueue (i.e. as an ID -> position map followed by the elements).
+   *
+   * \param ar      The archive.
+   * \param version The file format version number.
+   */
+  template <typename Archive>
+  void save(Archive& ar, const unsigned int version) const
+  {
+    std::map<ID,size_t> dictionary;
+    for(size_t id = 0, size = m_positions.size(); id < size; ++id)
+    {
+      if(m_positions[id] != NOT_PRESENT) dictionary.insert(dictionary.end(), std::make_pair(static_cast<ID>(id), m_positions[id]));
+    }
+
+    ar & dictionary;
+    ar & m_heap;
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+  friend class boost::serialization::access;
+};
+
+//#################### STATIC MEMBER DEFINITIONS ####################
+
+template <typename ID, typename Key, typename Data, typename Comp, size_t Arity>
+const size_t IndexedDaryHeap<ID,Key,Data,Comp,Arity>::NOT_PRESENT;
+
+template <typename ID, typename Key, typename Data, typename Comp, size_t Arity>
+const size_t IndexedDaryHeap<ID,Key,Data,Comp,Arity>::REBUILD_DIVISOR;
+
+}
+
+#endif
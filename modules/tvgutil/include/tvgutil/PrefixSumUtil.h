@@ -0,0 +1,117 @@
+/**
+ * tvgutil: PrefixSumUtil.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_TVGUTIL_PREFIXSUMUTIL
+#define H_TVGUTIL_PREFIXSUMUTIL
+
+#include <cstddef>
+#include <vector>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+namespace tvgutil {
+
+/**
+ * \brief This class provides utility functions for calculating prefix sums (in parallel, if OpenMP is available).
+ *
+ * Note: This class is deliberately header-only, so that the parallelism is determined by the project that uses it.
+ */
+class PrefixSumUtil
+{
+  //#################### PUBLIC STATIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Calculates the exclusive prefix sum of an array.
+   *
+   * \param input   The input array.
+   * \param output  The output array (must not overlap the input array).
+   * \param length  The length of the arrays.
+   */
+  template <typename InputType, typename OutputType>
+  static void calculate_exclusive_prefix_sum(const InputType *input, OutputType *output, int length)
+  {
+    calculate_exclusive_prefix_sums(input, output, length, std::vector<int>(1, 0));
+  }
+
+  /**
+   * \brief Calculates the exclusive prefix sums of the specified segments of an array that has been divided into equal-length segments.
+   *
+   * The sums for all of the segments are calculated together using a blocked, two-pass algorithm: each thread first sums
+   * its own block of every segment, and then rescans its blocks, starting from the sums of the preceding threads' blocks.
+   * This means that only a single parallel region (with a single barrier) is needed, however many segments there are.
+   * Segments that are not specified are left untouched in the output.
+   *
+   * \param input           The input array.
+   * \param output          The output array (must not overlap the input array).
+   * \param segmentLength   The length of each segment.
+   * \param segmentIndices  The indices of the segments whose prefix sums should be calculated.
+   */
+  template <typename InputType, typename OutputType>
+  static void calculate_exclusive_prefix_sums(const InputType *input, OutputType *output, int segmentLength, const std::vector<int>& segmentIndices)
+  {
+    const int segmentCount = static_cast<int>(segmentIndices.size());
+    if(segmentCount == 0 || segmentLength <= 0) return;
+
+#ifdef WITH_OPENMP
+    const int maxThreadCount = omp_get_max_threads();
+    std::vector<OutputType> blockSums(segmentCount * maxThreadCount);
+
+    #pragma omp parallel
+    {
+      const int threadCount = omp_get_num_threads();
+      const int threadIndex = omp_get_thread_num();
+      const int blockBegin = static_cast<int>(static_cast<long long>(segmentLength) * threadIndex / threadCount);
+      const int blockEnd = static_cast<int>(static_cast<long long>(segmentLength) * (threadIndex + 1) / threadCount);
+
+      // First pass: sum this thread's block of each segment.
+      for(int s = 0; s < segmentCount; ++s)
+      {
+        const InputType *segmentInput = input + static_cast<size_t>(segmentIndices[s]) * segmentLength;
+        OutputType blockSum = 0;
+        for(int i = blockBegin; i < blockEnd; ++i) blockSum += segmentInput[i];
+        blockSums[s * maxThreadCount + threadIndex] = blockSum;
+      }
+
+      #pragma omp barrier
+
+      // Second pass: rescan this thread's block of each segment, starting from the sum of the preceding blocks.
+      for(int s = 0; s < segmentCount; ++s)
+      {
+        OutputType sum = 0;
+        for(int t = 0; t < threadIndex; ++t) sum += blockSums[s * maxThreadCount + t];
+
+        const size_t segmentOffset = static_cast<size_t>(segmentIndices[s]) * segmentLength;
+        const InputType *segmentInput = input + segmentOffset;
+        OutputType *segmentOutput = output + segmentOffset;
+        for(int i = blockBegin; i < blockEnd; ++i)
+        {
+          segmentOutput[i] = sum;
+          sum += segmentInput[i];
+        }
+      }
+    }
+#else
+    for(int s = 0; s < segmentCount; ++s)
+    {
+      const size_t segmentOffset = static_cast<size_t>(segmentIndices[s]) * segmentLength;
+      const InputType *segmentInput = input + segmentOffset;
+      OutputType *segmentOutput = output + segmentOffset;
+
+      OutputType sum = 0;
+      for(int i = 0; i < segmentLength; ++i)
+      {
+        segmentOutput[i] = sum;
+        sum += segmentInput[i];
+      }
+    }
+#endif
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+/**
+ * tvgutil: ThreadLocalRNG.h
+ * Copyright (c) Torr Vision Group, University of Oxford, 2015. All rights reserved.
+ */
+
+#ifndef H_TVGUTIL_THREADLOCALRNG
+#define H_TVGUTIL_THREADLOCALRNG
+
+#include <stdexcept>
+#include <vector>
+
+#include <boost/random.hpp>
+#include <boost/random/seed_seq.hpp>
+#include <boost/shared_ptr.hpp>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+namespace tvgutil {
+
+/**
+ * \brief An instance of this class represents a random number generator that gives each OpenMP thread its own independent stream of random numbers.
+ *
+ * Unlike RandomNumberGenerator, no lock is taken when generating a number: each thread only ever touches the generation engine
+ * for its own stream. The engine for stream i is seeded deterministically from the master seed and i, so the numbers generated
+ * by a thread are reproducible provided that the same work is assigned to the same thread (e.g. by using a static schedule with
+ * a fixed number of threads).
+ *
+ * Alternatively, the stream to use can be specified explicitly. If the work is divided into a fixed number of chunks, each
+ * of which uses its own stream, then the numbers generated do not depend on the number of threads at all. In that case, the
+ * caller must ensure that no two threads use the same stream at once.
+ *
+ * Note: A generator may be used concurrently by the threads of a single parallel region, but not by nested parallel regions.
+ */
+class ThreadLocalRNG
+{
+  //#################### PRIVATE VARIABLES ####################
+private:
+  /** The generation engines for the streams (allocated separately to keep them on different cache lines). */
+  std::vector<boost::shared_ptr<boost::mt19937> > m_engines;
+
+  /** The master seed from which the seeds of the streams are derived. */
+  unsigned int m_seed;
+
+  //#################### CONSTRUCTORS ####################
+public:
+  /**
+   * \brief Constructs a thread-local random number generator.
+   *
+   * \param seed        The master seed from which to derive the seeds of the streams.
+   * \param streamCount The number of streams to create (if 0, one stream is created for each thread that OpenMP can use).
+   */
+  explicit ThreadLocalRNG(unsigned int seed, size_t streamCount = 0)
+  : m_seed(seed)
+  {
+    if(streamCount == 0)
+    {
+#ifdef WITH_OPENMP
+      streamCount = static_cast<size_t>(omp_get_max_threads());
+#else
+      streamCount = 1;
+#endif
+    }
+
+    m_engines.resize(streamCount);
+    for(size_t i = 0; i < streamCount; ++i)
+    {
+      // Note: Mixing the master seed and stream index using a seed sequence avoids the correlated streams that
+      //       would result from simply seeding the engines with consecutive integers.
+      const unsigned int seedData[] = { seed, static_cast<unsigned int>(i) };
+      boost::random::seed_seq seq(seedData, seedData + 2);
+      m_engines[i].reset(new boost::mt19937(seq));
+    }
+  }
+
+  //#################### PUBLIC MEMBER FUNCTIONS ####################
+public:
+  /**
+   * \brief Generates a random number from a 1D Gaussian distribution with the specified parameters, using the calling thread's stream.
+   *
+   * \param mean  The mean of the Gaussian distribution.
+   * \param sigma The standard deviation of the Gaussian distribution.
+   * \return      The generated number.
+   */
+  template <typename T = float>
+  T generate_from_gaussian(T mean, T sigma)
+  {
+    boost::random::normal_distribution<T> dist(mean, sigma);
+    return dist(get_engine());
+  }
+
+  /**
+   * \brief Generates a random number from a 1D Gaussian distribution with the specified parameters, using the specified stream.
+   *
+   * \param mean                The mean of the Gaussian distribution.
+   * \param sigma               The standard deviation of the Gaussian distribution.
+   * \param streamIndex         The index of the stream to use.
+   * \return                    The generated number.
+   * \throws std::runtime_error If the specified stream does not exist.
+   */
+  template <typename T>
+  T generate_from_gaussian(T mean, T sigma, size_t streamIndex)
+  {
+    boost::random::normal_distribution<T> dist(mean, sigma);
+    return dist(get_engine(streamIndex));
+  }
+
+  /**
+   * \brief Generates a random integer from a uniform distribution over the specified (closed) range, using the calling thread's stream.
+   *
+   * \param lower The lower bound of the range.
+   * \param upper The upper bound of the range.
+   * \return      The generated integer.
+   */
+  int generate_int_from_uniform(int lower, int upper)
+  {
+    // Note: As in RandomNumberGenerator, we generate from [0,upper-lower] and shift, since the engine can only generate numbers >= 0.
+    boost::random::uniform_int_distribution<> dist(0, upper - lower);
+    return dist(get_engine()) + lower;
+  }
+
+  /**
+   * \brief Generates a random integer from a uniform distribution over the specified (closed) range, using the specified stream.
+   *
+   * \param lower               The lower bound of the range.
+   * \param upper               The upper bound of the range.
+   * \param streamIndex         The index of the stream to use.
+   * \return                    The generated integer.
+   * \throws std::runtime_error If the specified stream does not exist.
+   */
+  int generate_int_from_uniform(int lower, int upper, size_t streamIndex)
+  {
+    boost::random::uniform_int_distribution<> dist(0, upper - lower);
+    return dist(get_engine(streamIndex)) + lower;
+  }
+
+  /**
+   * \brief Generates a random real number from a uniform distribution over the specified (closed) range, using the calling thread's stream.
+   *
+   * \param lower The lower bound of the range.
+   * \param upper The upper bound of the range.
+   * \return      The generated real number.
+   */
+  template <typename T = float>
+  T generate_real_from_uniform(T lower, T upper)
+  {
+    boost::random::uniform_real_distribution<T> dist(lower, upper);
+    return dist(get_engine());
+  }
+
+  /**
+   * \brief Generates a random real number from a uniform distribution over the specified (closed) range, using the specified stream.
+   *
+   * \param lower               The lower bound of the range.
+   * \param upper               The upper bound of the range.
+   * \param streamIndex         The index of the stream to use.
+   * \return                    The generated real number.
+   * \throws std::runtime_error If the specified stream does not exist.
+   */
+  template <typename T>
+  T generate_real_from_uniform(T lower, T upper, size_t streamIndex)
+  {
+    boost::random::uniform_real_distribution<T> dist(lower, upper);
+    return dist(get_engine(streamIndex));
+  }
+
+  /**
+   * \brief Gets the master seed of the generator.
+   *
+   * \return  The master seed of the generator.
+   */
+  unsigned int get_seed() const
+  {
+    return m_seed;
+  }
+
+  /**
+   * \brief Gets the number of streams the generator has.
+   *
+   * \return  The number of streams the generator has.
+   */
+  size_t get_stream_count() const
+  {
+    return m_engines.size();
+  }
+
+  //#################### PRIVATE MEMBER FUNCTIONS ####################
+private:
+  /**
+   * \brief Gets the generation engine for the calling thread's stream.
+   *
+   * \return                    The generation engine for the calling thread's stream.
+   * \throws std::runtime_error If the calling thread does not have a stream.
+   */
+  boost::mt19937& get_engine()
+  {
+#ifdef WITH_OPENMP
+    size_t threadIndex = static_cast<size_t>(omp_get_thread_num());
+#else
+    size_t threadIndex = 0;
+#endif
+
+    if(threadIndex >= m_engines.size()) throw std::runtime_error("The calling thread does not have its own random number stream");
+    return *m_engines[threadIndex];
+  }
+
+  /**
+   * \brief Gets the generation engine for the specified stream.
+   *
+   * \param streamIndex         The index of the stream.
+   * \return                    The generation engine for the specified stream.
+   * \throws std::runtime_error If the specified stream does not exist.
+   */
+  boost::mt19937& get_engine(size_t streamIndex)
+  {
+    if(streamIndex >= m_engines.size()) throw std::runtime_error("The specified random number stream does not exist");
+    return *m_engines[streamIndex];
+  }
+};
+
+//#################### TYPEDEFS ####################
+
+typedef boost::shared_ptr<ThreadLocalRNG> ThreadLocalRNG_Ptr;
+
+}
+
+#endif
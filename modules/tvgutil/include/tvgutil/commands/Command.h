@@ -58,6 +58,16 @@ public:
    * \return  A short description of what the command does.
    */
   const std::string& get_description() const;
+
+  /**
+   * \brief Gets the (approximate) amount of memory used by the command to store the state it needs in order to be undone/redone.
+   *
+   * By default, this is assumed to be negligible. Commands that store substantial amounts of state should override this,
+   * so that the command manager can keep the memory used by the command history within its budget.
+   *
+   * \return  The (approximate) amount of memory used by the command (in bytes).
+   */
+  virtual size_t get_memory_usage() const;
 };
 
 //#################### TYPEDEFS ####################
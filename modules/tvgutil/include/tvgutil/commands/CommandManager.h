@@ -8,6 +8,7 @@
 
 #include <climits>
 #include <deque>
+#include <limits>
 #include <map>
 
 #include "Command.h"
@@ -24,20 +25,34 @@ private:
   /** A stack containing commands that have been executed and not undone. */
   std::deque<Command_CPtr> m_executed;
 
+  /** The (approximate) amount of memory (in bytes) used by the commands on the executed stack (kept up to date as the stack changes). */
+  size_t m_executedMemoryUsage;
+
   /** The maximum size of the command history (the maximum combined size of the two command stacks). */
   size_t m_maxHistorySize;
 
+  /** The maximum amount of memory (in bytes) that the commands in the command history may use between them. */
+  size_t m_maxMemoryUsage;
+
   /** A stack containing commands that have been undone. */
   std::deque<Command_CPtr> m_undone;
 
+  /** The (approximate) amount of memory (in bytes) used by the commands on the undone stack (kept up to date as the stack changes). */
+  size_t m_undoneMemoryUsage;
+
   //#################### CONSTRUCTORS ####################
 public:
   /**
    * \brief Constructs a command manager.
    *
+   * When a command is executed, the oldest commands in the history are discarded as necessary to keep both the size of the command
+   * history and the memory used by its commands within the specified limits. The most recently executed command is always kept,
+   * even if it exceeds the memory budget on its own.
+   *
    * \param maxHistorySize  The maximum size of the command history (the maximum combined size of the two command stacks).
+   * \param maxMemoryUsage  The maximum amount of memory (in bytes) that the commands in the command history may use between them.
    */
-  explicit CommandManager(size_t maxHistorySize = INT_MAX);
+  explicit CommandManager(size_t maxHistorySize = INT_MAX, size_t maxMemoryUsage = std::numeric_limits<size_t>::max());
 
   //#################### PUBLIC MEMBER FUNCTIONS ####################
 public:
@@ -85,6 +100,13 @@ public:
    */
   size_t executed_count() const;
 
+  /**
+   * \brief Gets the (approximate) amount of memory currently used by the commands in the command history.
+   *
+   * \return  The (approximate) amount of memory currently used by the commands in the command history (in bytes).
+   */
+  size_t memory_usage() const;
+
   /**
    * \brief Redoes the last command undone, if any.
    */
@@ -109,10 +131,20 @@ public:
 
   //#################### PRIVATE MEMBER FUNCTIONS ####################
 private:
+  /**
+   * \brief Discards the oldest executed commands as necessary to bring the memory used by the command history within budget.
+   */
+  void enforce_memory_budget();
+
   /**
    * \brief Makes space for a new command if the command history is full.
    */
   void make_space_for_command();
+
+  /**
+   * \brief Discards the oldest command on the executed stack.
+   */
+  void pop_oldest_executed_command();
 };
 
 }
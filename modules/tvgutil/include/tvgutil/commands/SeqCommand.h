@@ -50,6 +50,9 @@ public:
   /** Override */
   virtual void execute() const;
 
+  /** Override */
+  virtual size_t get_memory_usage() const;
+
   /** Override */
   virtual void undo() const;
 };
@@ -24,4 +24,9 @@ const std::string& Command::get_description() const
   return m_description;
 }
 
+size_t Command::get_memory_usage() const
+{
+  return 0;
+}
+
 }
@@ -13,8 +13,8 @@ namespace tvgutil {
 
 //#################### CONSTRUCTORS ####################
 
-CommandManager::CommandManager(size_t maxHistorySize)
-: m_maxHistorySize(maxHistorySize)
+CommandManager::CommandManager(size_t maxHistorySize, size_t maxMemoryUsage)
+: m_executedMemoryUsage(0), m_maxHistorySize(maxHistorySize), m_maxMemoryUsage(maxMemoryUsage), m_undoneMemoryUsage(0)
 {
   if(maxHistorySize == 0)
   {
@@ -39,7 +39,12 @@ void CommandManager::execute_command(const Command_CPtr& c)
   make_space_for_command();
   m_executed.push_back(c);
   m_undone.clear();
+  m_undoneMemoryUsage = 0;
   c->execute();
+
+  // Note: The memory used by a command is only known once it has been executed.
+  m_executedMemoryUsage += c->get_memory_usage();
+  enforce_memory_budget();
 }
 
 void CommandManager::execute_compressible_command(const Command_CPtr& c, const std::map<std::string,std::string>& precursors)
@@ -56,10 +61,14 @@ void CommandManager::execute_compressible_command(const Command_CPtr& c, const s
     if(it != precursors.end())
     {
       // Note: We don't need to make space for a command here, since we're just replacing one command with another.
+      m_executedMemoryUsage -= last->get_memory_usage();
       m_executed.pop_back();
       m_executed.push_back(Command_CPtr(new SeqCommand(last, c, it->second)));
       m_undone.clear();
+      m_undoneMemoryUsage = 0;
       c->execute();
+      m_executedMemoryUsage += m_executed.back()->get_memory_usage();
+      enforce_memory_budget();
       return;
     }
 
@@ -73,21 +82,30 @@ size_t CommandManager::executed_count() const
   return m_executed.size();
 }
 
+size_t CommandManager::memory_usage() const
+{
+  return m_executedMemoryUsage + m_undoneMemoryUsage;
+}
+
 void CommandManager::redo()
 {
   if(can_redo())
   {
     Command_CPtr c = m_undone.back();
+    m_undoneMemoryUsage -= c->get_memory_usage();
     m_undone.pop_back();
     m_executed.push_back(c);
     c->execute();
+    m_executedMemoryUsage += c->get_memory_usage();
   }
 }
 
 void CommandManager::reset()
 {
   m_executed.clear();
+  m_executedMemoryUsage = 0;
   m_undone.clear();
+  m_undoneMemoryUsage = 0;
 }
 
 void CommandManager::undo()
@@ -95,9 +113,11 @@ void CommandManager::undo()
   if(can_undo())
   {
     Command_CPtr c = m_executed.back();
+    m_executedMemoryUsage -= c->get_memory_usage();
     m_executed.pop_back();
     m_undone.push_back(c);
     c->undo();
+    m_undoneMemoryUsage += c->get_memory_usage();
   }
 }
 
@@ -108,6 +128,17 @@ size_t CommandManager::undone_count() const
 
 //#################### PRIVATE MEMBER FUNCTIONS ####################
 
+void CommandManager::enforce_memory_budget()
+{
+  // This function is called just after the execution of a new command (at which point the undo stack is empty).
+  // Note that the memory used by a command is only known once it has been executed, which is why we can't make
+  // space for the command in advance, as we do when limiting the size of the command history.
+  while(m_executed.size() > 1 && memory_usage() > m_maxMemoryUsage)
+  {
+    pop_oldest_executed_command();
+  }
+}
+
 void CommandManager::make_space_for_command()
 {
   // This function is called just before the execution of a new command to ensure that
@@ -115,7 +146,13 @@ void CommandManager::make_space_for_command()
   // is the one in which the executed stack is taking up all of the space in the
   // command history and the undo stack is empty. The other cases will be handled
   // automatically, since the undo stack is cleared when a new command is executed.
-  if(m_executed.size() == m_maxHistorySize) m_executed.pop_front();
+  if(m_executed.size() == m_maxHistorySize) pop_oldest_executed_command();
+}
+
+void CommandManager::pop_oldest_executed_command()
+{
+  m_executedMemoryUsage -= m_executed.front()->get_memory_usage();
+  m_executed.pop_front();
 }
 
 }
@@ -38,6 +38,16 @@ void SeqCommand::execute() const
   }
 }
 
+size_t SeqCommand::get_memory_usage() const
+{
+  size_t memoryUsage = 0;
+  for(std::vector<Command_CPtr>::const_iterator it = m_cs.begin(), iend = m_cs.end(); it != iend; ++it)
+  {
+    memoryUsage += (*it)->get_memory_usage();
+  }
+  return memoryUsage;
+}
+
 void SeqCommand::undo() const
 {
   for(std::vector<Command_CPtr>::const_reverse_iterator it = m_cs.rbegin(), iend = m_cs.rend(); it != iend; ++it)
@@ -0,0 +1,184 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include <infermous/engines/DenseMeanFieldInferenceEngine.h>
+#include <infermous/engines/MeanFieldInferenceEngine.h>
+using namespace infermous;
+
+#include <tvgutil/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+//#################### HELPERS ####################
+
+typedef int Label;
+
+/**
+ * \brief An instance of this class calculates pairwise potentials by looking them up in a random symmetric matrix.
+ */
+class RandomPPC : public PairwisePotentialCalculator<Label>
+{
+private:
+  Eigen::MatrixXf m_potentials;
+
+public:
+  RandomPPC(int labelCount, RandomNumberGenerator& rng)
+  : m_potentials(labelCount, labelCount)
+  {
+    for(int i = 0; i < labelCount; ++i)
+    {
+      for(int j = 0; j <= i; ++j)
+      {
+        m_potentials(i, j) = m_potentials(j, i) = i == j ? 0.0f : rng.generate_real_from_uniform<float>(0.0f, 0.2f);
+      }
+    }
+  }
+
+  virtual float calculate_potential(const Label& l1, const Label& l2) const
+  {
+    return m_potentials(l1, l2);
+  }
+};
+
+/**
+ * \brief Makes a pair of identical CRFs with random unaries and pairwise potentials.
+ *
+ * \param height        The height of the CRFs.
+ * \param width         The width of the CRFs.
+ * \param labelCount    The number of labels.
+ * \param seed          The seed for the random number generator.
+ * \param missingLabel  Whether or not to remove a label from the unaries of one of the pixels.
+ * \return              The pair of CRFs.
+ */
+std::pair<CRF2D_Ptr<Label>,CRF2D_Ptr<Label> > make_random_crfs(int height, int width, int labelCount, unsigned int seed, bool missingLabel)
+{
+  RandomNumberGenerator rng(seed);
+
+  ProbabilitiesGrid_Ptr<Label> unaries(new ProbabilitiesGrid<Label>(height, width));
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      std::map<Label,float>& psi_i = (*unaries)(y, x);
+      float sum = 0.0f;
+      for(int k = 0; k < labelCount; ++k)
+      {
+        psi_i[k] = rng.generate_real_from_uniform<float>(0.05f, 1.0f);
+        sum += psi_i[k];
+      }
+
+      for(int k = 0; k < labelCount; ++k) psi_i[k] /= sum;
+    }
+  }
+
+  if(missingLabel) (*unaries)(height / 2, width / 2).erase(labelCount / 2);
+
+  PairwisePotentialCalculator_CPtr<Label> ppc(new RandomPPC(labelCount, rng));
+  return std::make_pair(
+    CRF2D_Ptr<Label>(new CRF2D<Label>(ProbabilitiesGrid_Ptr<Label>(new ProbabilitiesGrid<Label>(*unaries)), ppc)),
+    CRF2D_Ptr<Label>(new CRF2D<Label>(unaries, ppc))
+  );
+}
+
+/**
+ * \brief Checks that the marginals of two CRFs with the same dimensions are (almost) equal.
+ *
+ * \param crf1  The first CRF.
+ * \param crf2  The second CRF.
+ */
+void check_marginals_equal(const CRF2D_CPtr<Label>& crf1, const CRF2D_CPtr<Label>& crf2)
+{
+  for(int y = 0, height = crf1->get_height(); y < height; ++y)
+  {
+    for(int x = 0, width = crf1->get_width(); x < width; ++x)
+    {
+      const std::map<Label,float>& Q1 = crf1->get_marginals_at(Eigen::Vector2i(x, y));
+      const std::map<Label,float>& Q2 = crf2->get_marginals_at(Eigen::Vector2i(x, y));
+      BOOST_REQUIRE_EQUAL(Q1.size(), Q2.size());
+      for(std::map<Label,float>::const_iterator it = Q1.begin(), jt = Q2.begin(), iend = Q1.end(); it != iend; ++it, ++jt)
+      {
+        BOOST_CHECK_EQUAL(it->first, jt->first);
+        BOOST_CHECK_SMALL(it->second - jt->second, 1e-5f);
+      }
+    }
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_DenseMeanFieldInferenceEngine)
+
+BOOST_AUTO_TEST_CASE(parity_test)
+{
+  const int sizes[][2] = { {1, 1}, {8, 8}, {7, 12}, {20, 15} };
+  const int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+
+  for(int s = 0; s < sizeCount; ++s)
+  {
+    for(int labelCount = 2; labelCount <= 5; ++labelCount)
+    {
+      const int height = sizes[s][0], width = sizes[s][1];
+      const bool missingLabel = labelCount == 5;
+      std::pair<CRF2D_Ptr<Label>,CRF2D_Ptr<Label> > crfs = make_random_crfs(height, width, labelCount, 12345 + s * 10 + labelCount, missingLabel);
+
+      MeanFieldInferenceEngine<Label> engine(crfs.first, CRFUtil::make_circular_neighbour_offsets(2));
+      DenseMeanFieldInferenceEngine<Label> denseEngine(crfs.second, CRFUtil::make_circular_neighbour_offsets(2));
+
+      // Update the CRFs in several steps, to check that the dense engine also keeps the CRF's marginals correct between calls.
+      for(size_t iterations = 1; iterations <= 3; ++iterations)
+      {
+        engine.update_crf(iterations);
+        denseEngine.update_crf(iterations);
+        check_marginals_equal(crfs.first, crfs.second);
+      }
+
+      // Check that the dense engine's own predictions match those made from the CRF.
+      Grid<Label> expectedLabels(height, width);
+      for(int y = 0; y < height; ++y)
+      {
+        for(int x = 0; x < width; ++x)
+        {
+          expectedLabels(y, x) = tvgutil::ArgUtil::argmax(crfs.second->get_marginals_at(Eigen::Vector2i(x, y)));
+        }
+      }
+      BOOST_CHECK_EQUAL(denseEngine.predict_labels(), expectedLabels);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(smoothing_test)
+{
+  // Make a 10x10 CRF whose unaries favour label 1 in a central square and label 0 elsewhere, and then flip the unaries of a single pixel.
+  ProbabilitiesGrid_Ptr<Label> unaries(new ProbabilitiesGrid<Label>(10, 10));
+  for(int y = 0; y < 10; ++y)
+  {
+    for(int x = 0; x < 10; ++x)
+    {
+      const bool inside = x >= 3 && x < 7 && y >= 3 && y < 7;
+      (*unaries)(y, x)[1] = inside ? 0.9f : 0.1f;
+      (*unaries)(y, x)[0] = 1.0f - (*unaries)(y, x)[1];
+    }
+  }
+  std::swap((*unaries)(4, 5)[0], (*unaries)(4, 5)[1]);
+
+  struct PottsPPC : PairwisePotentialCalculator<Label>
+  {
+    virtual float calculate_potential(const Label& l1, const Label& l2) const
+    {
+      return l1 == l2 ? 0.0f : 1.0f;
+    }
+  };
+
+  CRF2D_Ptr<Label> crf(new CRF2D<Label>(unaries, PairwisePotentialCalculator_CPtr<Label>(new PottsPPC)));
+  DenseMeanFieldInferenceEngine<Label> engine(crf, CRFUtil::make_square_neighbour_offsets(1));
+  engine.update_crf(5);
+
+  // The flipped pixel should have been smoothed back to label 1.
+  Grid<Label> labels = engine.predict_labels();
+  BOOST_CHECK_EQUAL(labels(4, 5), 1);
+  BOOST_CHECK_EQUAL(labels(0, 0), 0);
+  BOOST_CHECK_EQUAL(labels(5, 5), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,239 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
+using boost::assign::list_of;
+namespace bf = boost::filesystem;
+
+#include <rafl/core/CompiledForest.h>
+#include <rafl/decisionfunctions/DecisionFunctionGeneratorFactory.h>
+#include <rafl/examples/UnitCircleExampleGenerator.h>
+using namespace rafl;
+
+#include <tvgutil/SerializationUtil.h>
+using namespace tvgutil;
+
+typedef int Label;
+typedef CompiledForest<Label> CF;
+typedef boost::shared_ptr<const CF> CF_CPtr;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+typedef DecisionTree<Label> DT;
+typedef RandomForest<Label> RF;
+
+//#################### HELPERS ####################
+
+/**
+ * \brief Makes the settings for the trees of a random forest, setting every field explicitly.
+ *
+ * \param decisionFunctionGenerator The decision function generator to use when splitting nodes.
+ * \param usePMFReweighting         Whether or not to enable PMF reweighting.
+ * \param seed                      The seed for the random number generator.
+ * \return                          The settings.
+ */
+DT::Settings make_settings(const DT::DecisionFunctionGenerator_CPtr& decisionFunctionGenerator, bool usePMFReweighting, unsigned int seed)
+{
+  DT::Settings settings;
+  settings.candidateCount = 64;
+  settings.decisionFunctionGenerator = decisionFunctionGenerator;
+  settings.gainThreshold = 0.0f;
+  settings.maxClassSize = 500;
+  settings.maxTreeHeight = 12;
+  settings.randomNumberGenerator.reset(new tvgutil::RandomNumberGenerator(seed));
+  settings.seenExamplesThreshold = 20;
+  settings.splittabilityThreshold = 0.5f;
+  settings.usePMFReweighting = usePMFReweighting;
+  return settings;
+}
+
+/**
+ * \brief Trains a random forest on examples generated around the unit circle.
+ *
+ * \param decisionFunctionGenerator The decision function generator to use when splitting nodes.
+ * \param usePMFReweighting         Whether or not to enable PMF reweighting.
+ * \return                          The trained forest.
+ */
+boost::shared_ptr<RF> train_forest(const DT::DecisionFunctionGenerator_CPtr& decisionFunctionGenerator, bool usePMFReweighting)
+{
+  const unsigned int seed = 12345;
+  DT::Settings settings = make_settings(decisionFunctionGenerator, usePMFReweighting, seed);
+
+  // Generate a deliberately imbalanced training set so that the reweighting has some effect.
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(3)(5)(7), seed);
+  std::vector<Example_CPtr> examples = generator.generate_examples(list_of(1)(3)(5), 200);
+  std::vector<Example_CPtr> extraExamples = generator.generate_examples(list_of(7), 1000);
+  examples.insert(examples.end(), extraExamples.begin(), extraExamples.end());
+
+  const size_t treeCount = 4;
+  boost::shared_ptr<RF> forest(new RF(treeCount, settings));
+  forest->add_examples(examples);
+  forest->train(1024);
+  return forest;
+}
+
+/**
+ * \brief Checks that a compiled forest makes exactly the same predictions as the specified random forest.
+ *
+ * \param compiledForest  The compiled forest.
+ * \param forest          The random forest.
+ */
+void check_predictions(const CF& compiledForest, const RF& forest)
+{
+  BOOST_REQUIRE_EQUAL(compiledForest.get_tree_count(), forest.get_tree_count());
+
+  // Compare the predictions on a dense grid of descriptors covering (and extending beyond) the unit circle.
+  for(int y = -30; y <= 30; ++y)
+  {
+    for(int x = -30; x <= 30; ++x)
+    {
+      Descriptor_Ptr descriptor(new Descriptor(2));
+      (*descriptor)[0] = x / 20.0f;
+      (*descriptor)[1] = y / 20.0f;
+
+      BOOST_CHECK_EQUAL(compiledForest.predict(descriptor), forest.predict(descriptor));
+
+      // Check that the masses in the PMFs are bit-exact, not merely close.
+      ProbabilityMassFunction<Label> expectedPMF = forest.calculate_pmf(descriptor);
+      ProbabilityMassFunction<Label> actualPMF = compiledForest.calculate_pmf(descriptor);
+      BOOST_CHECK(actualPMF.get_masses() == expectedPMF.get_masses());
+    }
+  }
+}
+
+/**
+ * \brief Checks that a compiled version of the specified forest makes exactly the same predictions as the forest itself.
+ *
+ * \param forest  The forest.
+ */
+void check_predictions(const RF& forest)
+{
+  CF compiledForest(forest);
+  check_predictions(compiledForest, forest);
+}
+
+/**
+ * \brief Reads the raw contents of a file.
+ *
+ * \param path  The path to the file.
+ * \return      The contents of the file.
+ */
+std::string read_file(const bf::path& path)
+{
+  std::ifstream fs(path.string().c_str(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+}
+
+/**
+ * \brief Writes the specified raw contents to a file.
+ *
+ * \param path      The path to the file.
+ * \param contents  The contents to write.
+ */
+void write_file(const bf::path& path, const std::string& contents)
+{
+  std::ofstream fs(path.string().c_str(), std::ios::binary);
+  fs.write(contents.data(), contents.size());
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_CompiledForest)
+
+BOOST_AUTO_TEST_CASE(feature_thresholding_test)
+{
+  DT::DecisionFunctionGenerator_CPtr generator(new FeatureThresholdingDecisionFunctionGenerator<Label>);
+  check_predictions(*train_forest(generator, false));
+  check_predictions(*train_forest(generator, true));
+}
+
+BOOST_AUTO_TEST_CASE(pairwise_op_and_threshold_test)
+{
+  DT::DecisionFunctionGenerator_CPtr generator(new PairwiseOpAndThresholdDecisionFunctionGenerator<Label>);
+  check_predictions(*train_forest(generator, false));
+  check_predictions(*train_forest(generator, true));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_forest_test)
+{
+  // A forest that has not been trained yet is not valid, and so cannot be compiled.
+  DT::DecisionFunctionGenerator_CPtr generator(new FeatureThresholdingDecisionFunctionGenerator<Label>);
+  RF forest(2, make_settings(generator, false, 12345));
+  BOOST_CHECK_THROW(CF compiledForest(forest), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(binary_model_round_trip_test)
+{
+  DecisionFunctionGeneratorFactory<Label>::instance().register_rafl_makers();
+
+  DT::DecisionFunctionGenerator_CPtr generators[] = {
+    DT::DecisionFunctionGenerator_CPtr(new FeatureThresholdingDecisionFunctionGenerator<Label>),
+    DT::DecisionFunctionGenerator_CPtr(new PairwiseOpAndThresholdDecisionFunctionGenerator<Label>)
+  };
+
+  for(size_t i = 0; i < sizeof(generators) / sizeof(DT::DecisionFunctionGenerator_CPtr); ++i)
+  {
+    // Save the forest using Boost serialization and load it again.
+    bf::path forestPath = bf::temp_directory_path() / bf::unique_path();
+    SerializationUtil::save_text(forestPath.string(), *train_forest(generators[i], true));
+    boost::shared_ptr<RF> loadedForest = SerializationUtil::load_text(forestPath.string(), loadedForest);
+    bf::remove(forestPath);
+
+    // Compile the loaded forest, save it as a binary model, and load (map) the model again.
+    bf::path modelPath = bf::temp_directory_path() / bf::unique_path();
+    CF(*loadedForest).save_binary(modelPath.string());
+    CF_CPtr loadedModel = CF::load_binary(modelPath.string());
+
+    // Check that the mapped model makes exactly the same predictions as the forest loaded using Boost serialization.
+    BOOST_CHECK_EQUAL(loadedModel->get_label_count(), CF(*loadedForest).get_label_count());
+    BOOST_CHECK_EQUAL(loadedModel->get_node_count(), CF(*loadedForest).get_node_count());
+    check_predictions(*loadedModel, *loadedForest);
+
+    // Check that saving the mapped model again produces an identical file.
+    bf::path resavedModelPath = bf::temp_directory_path() / bf::unique_path();
+    loadedModel->save_binary(resavedModelPath.string());
+    BOOST_CHECK(read_file(resavedModelPath) == read_file(modelPath));
+
+    bf::remove(modelPath);
+    bf::remove(resavedModelPath);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_binary_model_test)
+{
+  DT::DecisionFunctionGenerator_CPtr generator(new FeatureThresholdingDecisionFunctionGenerator<Label>);
+  bf::path modelPath = bf::temp_directory_path() / bf::unique_path();
+  CF(*train_forest(generator, false)).save_binary(modelPath.string());
+  const std::string contents = read_file(modelPath);
+  BOOST_REQUIRE_NO_THROW(CF::load_binary(modelPath.string()));
+
+  // A flipped bit in the payload should be detected by the checksum.
+  std::string corrupted = contents;
+  corrupted[corrupted.size() / 2] ^= 0x01;
+  write_file(modelPath, corrupted);
+  BOOST_CHECK_THROW(CF::load_binary(modelPath.string()), std::runtime_error);
+
+  // A truncated file should be rejected.
+  write_file(modelPath, contents.substr(0, contents.size() - 64));
+  BOOST_CHECK_THROW(CF::load_binary(modelPath.string()), std::runtime_error);
+
+  // A file with the wrong magic string should be rejected.
+  corrupted = contents;
+  corrupted[0] = 'X';
+  write_file(modelPath, corrupted);
+  BOOST_CHECK_THROW(CF::load_binary(modelPath.string()), std::runtime_error);
+
+  // A file saved on a machine with the opposite byte order should be rejected.
+  corrupted = contents;
+  std::reverse(corrupted.begin() + 8, corrupted.begin() + 12);
+  write_file(modelPath, corrupted);
+  BOOST_CHECK_THROW(CF::load_binary(modelPath.string()), std::runtime_error);
+
+  bf::remove(modelPath);
+  BOOST_CHECK_THROW(CF::load_binary(modelPath.string()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
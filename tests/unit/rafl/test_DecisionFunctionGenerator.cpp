@@ -0,0 +1,96 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#include <boost/assign/list_of.hpp>
+using boost::assign::list_of;
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include <rafl/decisionfunctions/FeatureThresholdingDecisionFunctionGenerator.h>
+#include <rafl/decisionfunctions/PairwiseOpAndThresholdDecisionFunctionGenerator.h>
+#include <rafl/examples/UnitCircleExampleGenerator.h>
+using namespace rafl;
+
+#include <tvgutil/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+typedef DecisionFunctionGenerator<Label> DFG;
+typedef boost::shared_ptr<const DFG> DFG_CPtr;
+
+//#################### HELPERS ####################
+
+/**
+ * \brief Splits a reservoir of examples using the specified number of threads and returns a string describing the chosen split.
+ *
+ * \param generator   The decision function generator to use.
+ * \param threadCount The number of threads to use.
+ * \return            A string describing the chosen split.
+ */
+std::string split_with_threads(const DFG_CPtr& generator, int threadCount)
+{
+#ifdef WITH_OPENMP
+  int oldThreadCount = omp_get_max_threads();
+  omp_set_num_threads(threadCount);
+#endif
+
+  const unsigned int seed = 12345;
+  const int candidateCount = 100;
+
+  RandomNumberGenerator_Ptr rng(new RandomNumberGenerator(seed));
+  ExampleReservoir<Label> reservoir(1000, rng);
+  UnitCircleExampleGenerator<Label> exampleGenerator(list_of(1)(3)(5)(7), seed);
+  std::vector<Example_CPtr> examples = exampleGenerator.generate_examples(list_of(1)(3)(5)(7), 250);
+  for(size_t i = 0, size = examples.size(); i < size; ++i)
+  {
+    reservoir.add_example(examples[i]);
+  }
+
+  DFG::Split_CPtr split = generator->split_examples(reservoir, candidateCount, 0.0f, boost::none, rng);
+
+#ifdef WITH_OPENMP
+  omp_set_num_threads(oldThreadCount);
+#endif
+
+  // Describe the split in terms of its decision function and the examples it sends each way.
+  BOOST_REQUIRE(split);
+  std::ostringstream os;
+  os << *split->m_decisionFunction << ' ' << split->m_leftExamples.size() << ' ' << split->m_rightExamples.size();
+  for(size_t i = 0, size = split->m_leftExamples.size(); i < size; ++i)
+  {
+    os << ' ' << split->m_leftExamples[i]->get_descriptor_view()[0];
+  }
+
+  // Append the next number from the random number generator, to check that its state after the split is also the same.
+  os << ' ' << rng->generate_int_from_uniform(0, 1000000);
+  return os.str();
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_DecisionFunctionGenerator)
+
+BOOST_AUTO_TEST_CASE(deterministic_split_test)
+{
+  const DFG_CPtr generators[] = {
+    DFG_CPtr(new FeatureThresholdingDecisionFunctionGenerator<Label>),
+    DFG_CPtr(new PairwiseOpAndThresholdDecisionFunctionGenerator<Label>)
+  };
+
+  for(size_t i = 0; i < sizeof(generators) / sizeof(DFG_CPtr); ++i)
+  {
+    std::string splitFor1 = split_with_threads(generators[i], 1);
+    std::string splitFor3 = split_with_threads(generators[i], 3);
+    std::string splitFor8 = split_with_threads(generators[i], 8);
+
+    BOOST_CHECK_EQUAL(splitFor1, splitFor3);
+    BOOST_CHECK_EQUAL(splitFor1, splitFor8);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
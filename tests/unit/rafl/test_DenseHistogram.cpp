@@ -0,0 +1,130 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#include <rafl/base/DenseHistogram.h>
+#include <rafl/base/Histogram.h>
+using namespace rafl;
+
+#include <tvgutil/RandomNumberGenerator.h>
+#include <tvgutil/SerializationUtil.h>
+using namespace tvgutil;
+
+typedef int Label;
+
+/**
+ * \brief Serializes a histogram to a string using a text archive.
+ *
+ * \param histogram The histogram to serialize.
+ * \return          The contents of the archive.
+ */
+template <typename HistogramType>
+std::string serialize_histogram(const HistogramType& histogram)
+{
+  std::ostringstream os;
+  {
+    boost::archive::text_oarchive ar(os);
+    ar << histogram;
+  }
+  return os.str();
+}
+
+/**
+ * \brief Deserializes a histogram from a string containing a text archive.
+ *
+ * \param s The contents of the archive.
+ * \return  The histogram.
+ */
+template <typename HistogramType>
+HistogramType deserialize_histogram(const std::string& s)
+{
+  HistogramType histogram;
+  std::istringstream is(s);
+  boost::archive::text_iarchive ar(is);
+  ar >> histogram;
+  return histogram;
+}
+
+BOOST_AUTO_TEST_SUITE(test_DenseHistogram)
+
+BOOST_AUTO_TEST_CASE(add_test)
+{
+  Histogram<Label> histogram;
+  DenseHistogram<Label> denseHistogram(4);
+  BOOST_CHECK(denseHistogram.empty());
+
+  // Add a random set of labels (some larger than the initial number of bins) to both histograms, and check that they match.
+  RandomNumberGenerator rng(12345);
+  for(int i = 0; i < 1000; ++i)
+  {
+    Label label = rng.generate_int_from_uniform(0, 9);
+    if(label == 5) continue;
+    histogram.add(label);
+    denseHistogram.add(label);
+  }
+
+  BOOST_CHECK(!denseHistogram.empty());
+  BOOST_CHECK_EQUAL(denseHistogram.get_count(), histogram.get_count());
+  BOOST_CHECK(denseHistogram.get_bins() == histogram.get_bins());
+  BOOST_CHECK_EQUAL(denseHistogram.get_bin(5), 0);
+  BOOST_CHECK_EQUAL(denseHistogram.get_bin(100), 0);
+  BOOST_CHECK_EQUAL(denseHistogram.get_bin(-1), 0);
+  BOOST_CHECK_EQUAL(denseHistogram.get_bin(3), histogram.get_bins().find(3)->second);
+}
+
+BOOST_AUTO_TEST_CASE(sparse_label_test)
+{
+  Histogram<Label> histogram;
+  DenseHistogram<Label> denseHistogram;
+
+  // Negative labels and labels that are too large to have compact IDs should be stored in the map, without growing the array.
+  const Label labels[] = { -5, 2, 1000000, -5, 2, 7, 1000000, -1 };
+  for(size_t i = 0; i < sizeof(labels) / sizeof(Label); ++i)
+  {
+    histogram.add(labels[i]);
+    denseHistogram.add(labels[i]);
+  }
+
+  BOOST_CHECK_EQUAL(denseHistogram.get_count(), histogram.get_count());
+  BOOST_CHECK(denseHistogram.get_bins() == histogram.get_bins());
+  BOOST_CHECK_EQUAL(denseHistogram.get_bin(-5), 2);
+  BOOST_CHECK_EQUAL(denseHistogram.get_bin(1000000), 2);
+  BOOST_CHECK_EQUAL(denseHistogram.get_bin(-2), 0);
+  BOOST_CHECK_EQUAL(denseHistogram.get_dense_bins().size(), 8);
+  BOOST_CHECK_EQUAL(denseHistogram.get_sparse_bins().size(), 3);
+
+  // The histogram should still round-trip through the map-based serialization format.
+  DenseHistogram<Label> loadedDenseHistogram = deserialize_histogram<DenseHistogram<Label> >(serialize_histogram(denseHistogram));
+  BOOST_CHECK(loadedDenseHistogram.get_bins() == histogram.get_bins());
+  BOOST_CHECK_EQUAL(loadedDenseHistogram.get_dense_bins().size(), 8);
+  BOOST_CHECK_EQUAL(loadedDenseHistogram.get_sparse_bins().size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(serialization_test)
+{
+  Histogram<Label> histogram;
+  DenseHistogram<Label> denseHistogram;
+  const Label labels[] = { 3, 7, 3, 0, 7, 7 };
+  for(size_t i = 0; i < sizeof(labels) / sizeof(Label); ++i)
+  {
+    histogram.add(labels[i]);
+    denseHistogram.add(labels[i]);
+  }
+
+  // A dense histogram should be serialized in exactly the same way as the equivalent ordinary histogram.
+  const std::string s = serialize_histogram(histogram);
+  BOOST_CHECK_EQUAL(serialize_histogram(denseHistogram), s);
+
+  // It should therefore be possible to load either kind of histogram from an archive containing the other.
+  DenseHistogram<Label> loadedDenseHistogram = deserialize_histogram<DenseHistogram<Label> >(s);
+  BOOST_CHECK(loadedDenseHistogram.get_bins() == histogram.get_bins());
+  BOOST_CHECK_EQUAL(loadedDenseHistogram.get_count(), histogram.get_count());
+  BOOST_CHECK_EQUAL(loadedDenseHistogram.get_dense_bins().size(), 8);
+
+  Histogram<Label> loadedHistogram = deserialize_histogram<Histogram<Label> >(serialize_histogram(denseHistogram));
+  BOOST_CHECK(loadedHistogram.get_bins() == histogram.get_bins());
+  BOOST_CHECK_EQUAL(loadedHistogram.get_count(), histogram.get_count());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/assign/list_of.hpp>
+using boost::assign::map_list_of;
+
+#include <rafl/base/DenseProbabilityMassFunction.h>
+using namespace rafl;
+
+#include <tvgutil/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+typedef int Label;
+
+/**
+ * \brief Checks that a dense PMF is identical to the equivalent map-based PMF.
+ *
+ * \param densePMF  The dense PMF.
+ * \param pmf       The map-based PMF.
+ */
+void check_pmfs_equal(const DenseProbabilityMassFunction<Label>& densePMF, const ProbabilityMassFunction<Label>& pmf)
+{
+  BOOST_CHECK(densePMF.get_masses() == pmf.get_masses());
+  BOOST_CHECK_EQUAL(densePMF.calculate_best_label(), pmf.calculate_best_label());
+  BOOST_CHECK_EQUAL(densePMF.calculate_entropy(), pmf.calculate_entropy());
+}
+
+BOOST_AUTO_TEST_SUITE(test_DenseProbabilityMassFunction)
+
+BOOST_AUTO_TEST_CASE(histogram_test)
+{
+  RandomNumberGenerator rng(12345);
+  for(int labelCount = 2; labelCount <= 64; labelCount *= 2)
+  {
+    // Make a random histogram in which roughly half the labels are missing.
+    Histogram<Label> histogram;
+    DenseHistogram<Label> denseHistogram;
+    for(int i = 0; i < 200; ++i)
+    {
+      Label label = rng.generate_int_from_uniform(0, labelCount - 1);
+      if(label % 2 == 1 && labelCount > 2) continue;
+      histogram.add(label);
+      denseHistogram.add(label);
+    }
+
+    check_pmfs_equal(DenseProbabilityMassFunction<Label>(denseHistogram), ProbabilityMassFunction<Label>(histogram));
+
+    // Check that the results are also identical when multipliers are used (including for labels that are not in the histogram).
+    std::map<Label,float> multipliers;
+    for(Label label = 0; label < labelCount; label += 3)
+    {
+      multipliers[label] = rng.generate_real_from_uniform<float>(0.5f, 2.0f);
+    }
+
+    check_pmfs_equal(DenseProbabilityMassFunction<Label>(denseHistogram, multipliers), ProbabilityMassFunction<Label>(histogram, multipliers));
+  }
+
+  BOOST_CHECK_THROW(DenseProbabilityMassFunction<Label>(DenseHistogram<Label>()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(masses_test)
+{
+  // Labels with zero mass should stay in the PMF, as for the map-based version.
+  std::map<Label,float> masses = map_list_of(1,0.5f)(4,0.0f)(6,1.5f)(9,0.5f);
+  DenseProbabilityMassFunction<Label> densePMF(masses);
+  check_pmfs_equal(densePMF, ProbabilityMassFunction<Label>(masses));
+  BOOST_CHECK_EQUAL(densePMF.get_mass(6), 0.6f);
+  BOOST_CHECK_EQUAL(densePMF.get_mass(4), 0.0f);
+  BOOST_CHECK_EQUAL(densePMF.get_mass(100), 0.0f);
+
+  // When constructing a PMF from an array of masses, labels with zero mass should be omitted.
+  std::vector<float> denseMasses(10, 0.0f);
+  denseMasses[1] = 0.5f;
+  denseMasses[6] = 1.5f;
+  denseMasses[9] = 0.5f;
+  masses.erase(4);
+  check_pmfs_equal(DenseProbabilityMassFunction<Label>(denseMasses), ProbabilityMassFunction<Label>(masses));
+
+  // Ties should be broken in favour of the smallest label.
+  std::map<Label,float> tiedMasses = map_list_of(2,1.0f)(3,2.0f)(5,2.0f);
+  BOOST_CHECK_EQUAL(DenseProbabilityMassFunction<Label>(tiedMasses).calculate_best_label(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(sparse_label_test)
+{
+  // Labels without compact IDs should give exactly the same results as for the map-based version.
+  Histogram<Label> histogram;
+  DenseHistogram<Label> denseHistogram;
+  const Label labels[] = { -7, 3, 500, -7, 3, 3, 500, -2, 500, 0 };
+  for(size_t i = 0; i < sizeof(labels) / sizeof(Label); ++i)
+  {
+    histogram.add(labels[i]);
+    denseHistogram.add(labels[i]);
+  }
+
+  std::map<Label,float> multipliers = map_list_of(-7,1.5f)(3,0.5f)(500,2.0f);
+  check_pmfs_equal(DenseProbabilityMassFunction<Label>(denseHistogram), ProbabilityMassFunction<Label>(histogram));
+  check_pmfs_equal(DenseProbabilityMassFunction<Label>(denseHistogram, multipliers), ProbabilityMassFunction<Label>(histogram, multipliers));
+
+  std::map<Label,float> masses = map_list_of(-3,1.0f)(2,0.5f)(1000,1.0f)(4,0.0f);
+  DenseProbabilityMassFunction<Label> densePMF(masses);
+  check_pmfs_equal(densePMF, ProbabilityMassFunction<Label>(masses));
+  BOOST_CHECK_EQUAL(densePMF.get_mass(1000), 0.4f);
+  BOOST_CHECK_EQUAL(densePMF.calculate_best_label(), -3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
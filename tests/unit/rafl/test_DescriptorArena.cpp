@@ -0,0 +1,95 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+
+#include <rafl/base/DescriptorArena.h>
+#include <rafl/examples/Example.h>
+using namespace rafl;
+
+#include <tvgutil/SerializationUtil.h>
+
+typedef int Label;
+
+/**
+ * \brief Serializes an example to a string using a text archive.
+ *
+ * \param example The example to serialize.
+ * \return        The contents of the archive.
+ */
+std::string serialize_example(const boost::shared_ptr<const Example<Label> >& example)
+{
+  std::ostringstream os;
+  {
+    boost::archive::text_oarchive ar(os);
+    ar << example;
+  }
+  return os.str();
+}
+
+BOOST_AUTO_TEST_SUITE(test_DescriptorArena)
+
+BOOST_AUTO_TEST_CASE(layout_test)
+{
+  const size_t descriptorCount = 10, featureCount = 17;
+  DescriptorArena arena(descriptorCount, featureCount);
+
+  BOOST_CHECK_EQUAL(arena.get_descriptor_count(), descriptorCount);
+  BOOST_CHECK_EQUAL(arena.get_feature_count(), featureCount);
+  BOOST_CHECK_EQUAL(arena.get_stride(), 2 * DescriptorArena::ROW_ALIGNMENT);
+
+  // Check that every row is aligned and that the views see exactly what was written into the rows.
+  for(size_t i = 0; i < descriptorCount; ++i)
+  {
+    float *row = arena.get_row(i);
+    BOOST_CHECK_EQUAL(reinterpret_cast<boost::uintptr_t>(row) % (DescriptorArena::ROW_ALIGNMENT * sizeof(float)), 0);
+    for(size_t j = 0; j < featureCount; ++j) row[j] = static_cast<float>(i * 100 + j);
+  }
+
+  for(size_t i = 0; i < descriptorCount; ++i)
+  {
+    DescriptorView view = arena.get_view(i);
+    BOOST_REQUIRE_EQUAL(view.size(), featureCount);
+    for(size_t j = 0; j < featureCount; ++j) BOOST_CHECK_EQUAL(view[j], static_cast<float>(i * 100 + j));
+
+    Descriptor_Ptr descriptor = arena.make_descriptor(i);
+    BOOST_CHECK(*descriptor == Descriptor(view.begin(), view.end()));
+  }
+
+  BOOST_CHECK_THROW(arena.get_view(descriptorCount), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(resize_test)
+{
+  DescriptorArena arena(100, 32);
+  const float *storage = arena.get_row(0);
+
+  // Shrinking the arena (or resizing it back to its original size) should reuse the existing storage.
+  arena.resize(50, 16);
+  BOOST_CHECK_EQUAL(arena.get_descriptor_count(), 50);
+  BOOST_CHECK_EQUAL(arena.get_stride(), 16);
+  BOOST_CHECK(arena.get_row(0) == storage);
+
+  arena.resize(100, 32);
+  BOOST_CHECK(arena.get_row(0) == storage);
+}
+
+BOOST_AUTO_TEST_CASE(serialization_test)
+{
+  const size_t featureCount = 5;
+  boost::shared_ptr<DescriptorArena> arena(new DescriptorArena(1, featureCount));
+  for(size_t j = 0; j < featureCount; ++j) arena->get_row(0)[j] = j * 0.5f;
+
+  // An arena-based example should be serialized in exactly the same way as the equivalent standalone example.
+  boost::shared_ptr<const Example<Label> > arenaExample(new Example<Label>(arena, 0, 23));
+  boost::shared_ptr<const Example<Label> > standaloneExample(new Example<Label>(arena->make_descriptor(0), 23));
+  BOOST_CHECK_EQUAL(serialize_example(arenaExample), serialize_example(standaloneExample));
+
+  // An arena-based example should keep its arena alive.
+  arena.reset();
+  BOOST_CHECK_EQUAL(arenaExample->get_descriptor_view()[featureCount - 1], (featureCount - 1) * 0.5f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
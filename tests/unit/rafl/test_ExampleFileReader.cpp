@@ -0,0 +1,188 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+namespace bf = boost::filesystem;
+
+#include <rafl/examples/ExampleUtil.h>
+using namespace rafl;
+
+#include <tvgutil/RandomNumberGenerator.h>
+#include <tvgutil/WordExtractor.h>
+using namespace tvgutil;
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+//#################### HELPERS ####################
+
+/**
+ * \brief Checks that two sets of examples have exactly the same descriptors and labels.
+ *
+ * \param actual    The first set of examples.
+ * \param expected  The second set of examples.
+ */
+void check_same_examples(const std::vector<Example_CPtr>& actual, const std::vector<Example_CPtr>& expected)
+{
+  BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+  for(size_t i = 0, size = actual.size(); i < size; ++i)
+  {
+    const DescriptorView& actualDescriptor = actual[i]->get_descriptor_view();
+    const DescriptorView& expectedDescriptor = expected[i]->get_descriptor_view();
+    BOOST_CHECK_EQUAL_COLLECTIONS(actualDescriptor.begin(), actualDescriptor.end(), expectedDescriptor.begin(), expectedDescriptor.end());
+    BOOST_CHECK_EQUAL(actual[i]->get_label(), expected[i]->get_label());
+  }
+}
+
+/**
+ * \brief Loads a set of examples from the specified file using the original (word-based) approach, for comparison purposes.
+ *
+ * \param filename  The name of the file from which to load the examples.
+ * \return          The loaded examples.
+ */
+std::vector<Example_CPtr> load_examples_word_based(const std::string& filename)
+{
+  std::vector<Example_CPtr> result;
+
+  std::ifstream fs(filename.c_str());
+  std::vector<std::vector<std::string> > wordLines = WordExtractor::extract_word_lines(fs, ", \r");
+  for(size_t i = 0, lineCount = wordLines.size(); i < lineCount; ++i)
+  {
+    const std::vector<std::string>& words = wordLines[i];
+
+    Descriptor_Ptr descriptor(new Descriptor);
+    for(size_t j = 0; j < words.size() - 1; ++j)
+    {
+      descriptor->push_back(boost::lexical_cast<float>(words[j]));
+    }
+
+    result.push_back(Example_CPtr(new Example<Label>(descriptor, boost::lexical_cast<Label>(words.back()))));
+  }
+
+  return result;
+}
+
+/**
+ * \brief Writes a file of randomly-generated examples, using a variety of number formats and delimiters.
+ *
+ * \param path          The path to the file.
+ * \param exampleCount  The number of examples to write.
+ * \param featureCount  The number of features in each example.
+ */
+void write_random_examples(const bf::path& path, int exampleCount, int featureCount)
+{
+  const char *formats[] = { "%g", "%.9g", "%e", "%.3f", "%.0f" };
+  const char *delimiters[] = { ",", ", ", " ", " , " };
+  RandomNumberGenerator rng(12345);
+
+  std::ofstream fs(path.string().c_str(), std::ios::binary);
+  for(int i = 0; i < exampleCount; ++i)
+  {
+    const char *delimiter = delimiters[rng.generate_int_from_uniform(0, 3)];
+    for(int j = 0; j < featureCount; ++j)
+    {
+      char buffer[64];
+      float value = rng.generate_real_from_uniform<float>(-1000.0f, 1000.0f) / (j + 1);
+      sprintf(buffer, formats[rng.generate_int_from_uniform(0, 4)], value);
+      fs << buffer << delimiter;
+    }
+    fs << rng.generate_int_from_uniform(-5, 20) << (i % 3 == 0 ? "\r\n" : "\n");
+  }
+}
+
+/**
+ * \brief Writes the specified text to a file.
+ *
+ * \param path  The path to the file.
+ * \param text  The text to write.
+ */
+void write_text(const bf::path& path, const std::string& text)
+{
+  std::ofstream fs(path.string().c_str(), std::ios::binary);
+  fs << text;
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_ExampleFileReader)
+
+BOOST_AUTO_TEST_CASE(parity_test)
+{
+  bf::path path = bf::temp_directory_path() / bf::unique_path();
+  write_random_examples(path, 5000, 7);
+
+  // The streaming loader should produce exactly the same examples as the word-based loader.
+  std::vector<Example_CPtr> expected = load_examples_word_based(path.string());
+  check_same_examples(ExampleUtil::load_examples<Label>(path.string()), expected);
+
+  // Reading the examples in chunks (with a tiny block size, to exercise both refilling and growing the buffer) should also produce the same examples.
+  ExampleFileReader<Label> reader(path.string(), 16);
+  std::vector<Example_CPtr> chunked;
+  for(;;)
+  {
+    std::vector<Example_CPtr> chunk = reader.read_chunk(333);
+    if(chunk.empty()) break;
+    BOOST_CHECK_LE(chunk.size(), 333);
+    chunked.insert(chunked.end(), chunk.begin(), chunk.end());
+  }
+  BOOST_CHECK_EQUAL(reader.get_feature_count(), 7);
+  check_same_examples(chunked, expected);
+
+  bf::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(format_test)
+{
+  bf::path path = bf::temp_directory_path() / bf::unique_path();
+
+  // Blank lines should be skipped, and a final line without a newline should still be read.
+  write_text(path, "1.5,2,3\n\n  \r\n-4e1, 5 ,7\r\n\t0.25\t-0.5\t9");
+  std::vector<Example_CPtr> examples = ExampleUtil::load_examples<Label>(path.string());
+  BOOST_REQUIRE_EQUAL(examples.size(), 3);
+  BOOST_CHECK_EQUAL(examples[0]->get_descriptor_view()[0], 1.5f);
+  BOOST_CHECK_EQUAL(examples[0]->get_descriptor_view()[1], 2.0f);
+  BOOST_CHECK_EQUAL(examples[0]->get_label(), 3);
+  BOOST_CHECK_EQUAL(examples[1]->get_descriptor_view()[0], -40.0f);
+  BOOST_CHECK_EQUAL(examples[1]->get_descriptor_view()[1], 5.0f);
+  BOOST_CHECK_EQUAL(examples[1]->get_label(), 7);
+  BOOST_CHECK_EQUAL(examples[2]->get_descriptor_view()[0], 0.25f);
+  BOOST_CHECK_EQUAL(examples[2]->get_descriptor_view()[1], -0.5f);
+  BOOST_CHECK_EQUAL(examples[2]->get_label(), 9);
+
+  // An empty file should contain no examples.
+  write_text(path, "");
+  BOOST_CHECK(ExampleUtil::load_examples<Label>(path.string()).empty());
+
+  bf::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(bad_data_test)
+{
+  bf::path path = bf::temp_directory_path() / bf::unique_path();
+
+  // A line with the wrong number of features should be rejected.
+  write_text(path, "1,2,3\n4,5\n");
+  BOOST_CHECK_THROW(ExampleUtil::load_examples<Label>(path.string()), std::runtime_error);
+
+  // A line with an invalid feature should be rejected.
+  write_text(path, "1,2,3\n4,5x,6\n");
+  BOOST_CHECK_THROW(ExampleUtil::load_examples<Label>(path.string()), std::runtime_error);
+
+  // A line with an invalid label should be rejected.
+  write_text(path, "1,2,3\n4,5,6.5\n");
+  BOOST_CHECK_THROW(ExampleUtil::load_examples<Label>(path.string()), std::runtime_error);
+
+  // A line with only a label should be rejected.
+  write_text(path, "3\n");
+  BOOST_CHECK_THROW(ExampleUtil::load_examples<Label>(path.string()), std::runtime_error);
+
+  // A missing file should be rejected.
+  bf::remove(path);
+  BOOST_CHECK_THROW(ExampleUtil::load_examples<Label>(path.string()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,173 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#include <rafl/examples/ExampleReservoir.h>
+using namespace rafl;
+
+#include <tvgutil/SerializationUtil.h>
+using namespace tvgutil;
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+//#################### HELPERS ####################
+
+/**
+ * \brief Makes an example whose (one-dimensional) descriptor records its index, so that the example can be identified.
+ *
+ * \param index The index of the example.
+ * \param label The label of the example.
+ * \return      The example.
+ */
+Example_CPtr make_example(int index, Label label)
+{
+  return Example_CPtr(new Example<Label>(Descriptor_CPtr(new Descriptor(1, static_cast<float>(index))), label));
+}
+
+/**
+ * \brief Gets the index of an example made by make_example.
+ *
+ * \param example The example.
+ * \return        The index of the example.
+ */
+int get_index(const Example_CPtr& example)
+{
+  return static_cast<int>(example->get_descriptor_view()[0]);
+}
+
+/**
+ * \brief Checks that the number of times each example was kept in a reservoir is consistent with each example being equally likely to be kept.
+ *
+ * This uses Pearson's chi-squared test, with a significance level of 0.001.
+ *
+ * \param keptCounts    The number of times each example was kept.
+ * \param expectedCount The expected number of times each example was kept.
+ * \param criticalValue The critical value of the chi-squared distribution (with keptCounts.size() - 1 degrees of freedom).
+ */
+void check_uniform(const std::vector<int>& keptCounts, double expectedCount, double criticalValue)
+{
+  double chiSquared = 0.0;
+  for(size_t i = 0, size = keptCounts.size(); i < size; ++i)
+  {
+    double difference = keptCounts[i] - expectedCount;
+    chiSquared += difference * difference / expectedCount;
+  }
+  BOOST_CHECK_LT(chiSquared, criticalValue);
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_ExampleReservoir)
+
+BOOST_AUTO_TEST_CASE(contents_test)
+{
+  RandomNumberGenerator_Ptr rng(new RandomNumberGenerator(12345));
+  ExampleReservoir<Label> reservoir(3, rng);
+
+  // Add examples of three classes (out of label order), with only class 5 exceeding the maximum class size.
+  const Label labels[] = { 5, 2, 5, 9, 5, 2, 5, 5, 5 };
+  const int exampleCount = sizeof(labels) / sizeof(Label);
+  for(int i = 0; i < exampleCount; ++i)
+  {
+    bool added = reservoir.add_example(make_example(i, labels[i]));
+    if(labels[i] != 5 || i < 4) BOOST_CHECK(added);
+  }
+
+  BOOST_CHECK_EQUAL(reservoir.current_size(), 6);
+  BOOST_CHECK_EQUAL(reservoir.seen_examples(), exampleCount);
+
+  // The examples should be grouped by label, in ascending order of label.
+  std::vector<Example_CPtr> examples = reservoir.get_examples();
+  BOOST_REQUIRE_EQUAL(examples.size(), 6);
+  BOOST_CHECK_EQUAL(get_index(examples[0]), 1);
+  BOOST_CHECK_EQUAL(get_index(examples[1]), 5);
+  for(int i = 2; i < 5; ++i) BOOST_CHECK_EQUAL(examples[i]->get_label(), 5);
+  BOOST_CHECK_EQUAL(get_index(examples[5]), 3);
+
+  // The histogram should record every example that has been seen, and the multipliers should relate this to the examples in the reservoir.
+  const std::map<Label,size_t>& bins = reservoir.get_histogram()->get_bins();
+  BOOST_CHECK_EQUAL(bins.find(2)->second, 2);
+  BOOST_CHECK_EQUAL(bins.find(5)->second, 6);
+  BOOST_CHECK_EQUAL(bins.find(9)->second, 1);
+
+  std::map<Label,float> multipliers = reservoir.get_class_multipliers();
+  BOOST_CHECK_EQUAL(multipliers.size(), 3);
+  BOOST_CHECK_EQUAL(multipliers[2], 1.0f);
+  BOOST_CHECK_EQUAL(multipliers[5], 2.0f);
+  BOOST_CHECK_EQUAL(multipliers[9], 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(uniformity_test)
+{
+  // Repeatedly add a stream of examples of two interleaved classes to a reservoir, and count how often each example is kept.
+  const size_t maxClassSize = 10;
+  const int exampleCounts[] = { 50, 20 };
+  const int trialCount = 20000;
+
+  RandomNumberGenerator_Ptr rng(new RandomNumberGenerator(12345));
+  std::vector<std::vector<int> > keptCounts(2);
+  keptCounts[0].resize(exampleCounts[0]);
+  keptCounts[1].resize(exampleCounts[1]);
+
+  for(int trial = 0; trial < trialCount; ++trial)
+  {
+    ExampleReservoir<Label> reservoir(maxClassSize, rng);
+    for(int i = 0; i < exampleCounts[0]; ++i)
+    {
+      reservoir.add_example(make_example(i, 0));
+      if(i < exampleCounts[1]) reservoir.add_example(make_example(i, 1));
+    }
+
+    std::vector<Example_CPtr> examples = reservoir.get_examples();
+    BOOST_REQUIRE_EQUAL(examples.size(), 2 * maxClassSize);
+    for(size_t j = 0, size = examples.size(); j < size; ++j)
+    {
+      ++keptCounts[examples[j]->get_label()][get_index(examples[j])];
+    }
+  }
+
+  // Each example of a class should be equally likely to have been kept (the critical values are for 49 and 19 degrees of freedom).
+  check_uniform(keptCounts[0], static_cast<double>(trialCount) * maxClassSize / exampleCounts[0], 85.351);
+  check_uniform(keptCounts[1], static_cast<double>(trialCount) * maxClassSize / exampleCounts[1], 43.820);
+}
+
+BOOST_AUTO_TEST_CASE(serialization_test)
+{
+  RandomNumberGenerator_Ptr rng(new RandomNumberGenerator(12345));
+  ExampleReservoir<Label> reservoir(4, rng);
+  for(int i = 0; i < 20; ++i)
+  {
+    reservoir.add_example(make_example(i, (i * 7) % 3));
+  }
+
+  // Save the reservoir, load it again, and check that the loaded reservoir is the same as the original.
+  std::ostringstream os;
+  {
+    boost::archive::text_oarchive ar(os);
+    ar << reservoir;
+  }
+
+  ExampleReservoir<Label> loadedReservoir;
+  {
+    std::istringstream is(os.str());
+    boost::archive::text_iarchive ar(is);
+    ar >> loadedReservoir;
+  }
+
+  BOOST_CHECK_EQUAL(loadedReservoir.current_size(), reservoir.current_size());
+  BOOST_CHECK_EQUAL(loadedReservoir.seen_examples(), reservoir.seen_examples());
+  BOOST_CHECK(loadedReservoir.get_class_multipliers() == reservoir.get_class_multipliers());
+  BOOST_CHECK(loadedReservoir.get_histogram()->get_bins() == reservoir.get_histogram()->get_bins());
+
+  std::vector<Example_CPtr> examples = reservoir.get_examples(), loadedExamples = loadedReservoir.get_examples();
+  BOOST_REQUIRE_EQUAL(loadedExamples.size(), examples.size());
+  for(size_t i = 0, size = examples.size(); i < size; ++i)
+  {
+    BOOST_CHECK_EQUAL(loadedExamples[i]->get_label(), examples[i]->get_label());
+    BOOST_CHECK_EQUAL(get_index(loadedExamples[i]), get_index(examples[i]));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
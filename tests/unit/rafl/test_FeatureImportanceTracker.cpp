@@ -0,0 +1,234 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
+using boost::assign::list_of;
+namespace bf = boost::filesystem;
+
+#include <rafl/core/RandomForest.h>
+#include <rafl/decisionfunctions/DecisionFunctionGeneratorFactory.h>
+using namespace rafl;
+
+#include <tvgutil/RandomNumberGenerator.h>
+#include <tvgutil/SerializationUtil.h>
+using namespace tvgutil;
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+typedef DecisionTree<Label> DT;
+typedef RandomForest<Label> RF;
+
+/**
+ * \brief Generates examples whose labels depend on only a few of the features in their descriptors.
+ *
+ * Each descriptor has 32 features drawn uniformly from [0,1]. The label of an example is determined by features 3 and 17,
+ * and the remaining features are noise.
+ *
+ * \param exampleCount  The number of examples to generate.
+ * \param rng           The random number generator to use.
+ * \return              The generated examples.
+ */
+std::vector<Example_CPtr> generate_examples(size_t exampleCount, RandomNumberGenerator& rng)
+{
+  const size_t featureCount = 32;
+  std::vector<Example_CPtr> examples;
+  for(size_t i = 0; i < exampleCount; ++i)
+  {
+    Descriptor_Ptr descriptor(new Descriptor(featureCount));
+    for(size_t j = 0; j < featureCount; ++j)
+    {
+      (*descriptor)[j] = rng.generate_real_from_uniform(0.0f, 1.0f);
+    }
+
+    Label label = ((*descriptor)[3] < 0.5f ? 0 : 1) + ((*descriptor)[17] < 0.3f ? 0 : 2);
+    examples.push_back(Example_CPtr(new Example<Label>(descriptor, label)));
+  }
+  return examples;
+}
+
+/**
+ * \brief Makes the settings for a forest that uses the specified decision function generator.
+ *
+ * \param decisionFunctionGenerator The decision function generator to use.
+ * \param seed                      The seed for the forest's random number generator.
+ * \return                          The settings.
+ */
+DT::Settings make_settings(const DT::DecisionFunctionGenerator_CPtr& decisionFunctionGenerator, unsigned int seed)
+{
+  DT::Settings settings;
+  settings.candidateCount = 64;
+  settings.decisionFunctionGenerator = decisionFunctionGenerator;
+  settings.gainThreshold = 0.0f;
+  settings.maxClassSize = 1000;
+  settings.maxTreeHeight = 10;
+  settings.randomNumberGenerator.reset(new RandomNumberGenerator(seed));
+  settings.seenExamplesThreshold = 20;
+  settings.splittabilityThreshold = 0.5f;
+  settings.usePMFReweighting = true;
+  return settings;
+}
+
+/**
+ * \brief Counts the branch nodes in the trees of the specified forest.
+ *
+ * \param forest  The forest.
+ * \return        The number of branch nodes in the trees of the forest.
+ */
+size_t count_branch_nodes(const RF& forest)
+{
+  size_t result = 0;
+  for(size_t i = 0, treeCount = forest.get_tree_count(); i < treeCount; ++i)
+  {
+    boost::shared_ptr<const DT> tree = forest.get_tree(i);
+    for(int nodeIndex = 0, nodeCount = static_cast<int>(tree->get_node_count()); nodeIndex < nodeCount; ++nodeIndex)
+    {
+      if(!tree->is_leaf(nodeIndex)) ++result;
+    }
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_SUITE(test_FeatureImportanceTracker)
+
+BOOST_AUTO_TEST_CASE(record_split_test)
+{
+  FeatureImportanceTracker tracker;
+  BOOST_CHECK_EQUAL(tracker.get_feature_count(), 0);
+  BOOST_CHECK(tracker.get_used_feature_indices().empty());
+
+  tracker.record_split(FeatureThresholdingDecisionFunction(5, 0.5f).get_feature_indices(), 0.25f);
+  tracker.record_split(PairwiseOpAndThresholdDecisionFunction(2, 5, PairwiseOpAndThresholdDecisionFunction::PO_ADD, 0.5f).get_feature_indices(), 0.5f);
+
+  BOOST_CHECK_EQUAL(tracker.get_feature_count(), 6);
+  BOOST_CHECK_EQUAL(tracker.get_split_count(2), 1);
+  BOOST_CHECK_EQUAL(tracker.get_split_count(3), 0);
+  BOOST_CHECK_EQUAL(tracker.get_split_count(5), 2);
+  BOOST_CHECK_EQUAL(tracker.get_split_count(100), 0);
+  BOOST_CHECK_CLOSE(tracker.get_gain(2), 0.5, 1e-4);
+  BOOST_CHECK_CLOSE(tracker.get_gain(5), 0.75, 1e-4);
+  BOOST_CHECK(tracker.get_used_feature_indices() == list_of<size_t>(2)(5).convert_to_container<std::vector<size_t> >());
+
+  tracker.reset();
+  BOOST_CHECK_EQUAL(tracker.get_feature_count(), 0);
+  BOOST_CHECK_EQUAL(tracker.get_split_count(5), 0);
+}
+
+BOOST_AUTO_TEST_CASE(forest_tracking_test)
+{
+  const unsigned int seed = 12345;
+  RandomNumberGenerator rng(seed);
+
+  DT::DecisionFunctionGenerator_CPtr generators[] =
+  {
+    DT::DecisionFunctionGenerator_CPtr(new FeatureThresholdingDecisionFunctionGenerator<Label>),
+    DT::DecisionFunctionGenerator_CPtr(new PairwiseOpAndThresholdDecisionFunctionGenerator<Label>)
+  };
+
+  for(size_t i = 0; i < sizeof(generators) / sizeof(generators[0]); ++i)
+  {
+    RF forest(4, make_settings(generators[i], seed));
+    forest.add_examples(generate_examples(1000, rng));
+    while(forest.train(16) > 0);
+
+    // The tracker should have seen every split in every tree of the forest, and nothing else.
+    FeatureImportanceTracker_Ptr tracker = forest.get_feature_importance_tracker();
+    std::vector<size_t> usedFeatureIndices = forest.get_used_feature_indices();
+    BOOST_REQUIRE(!usedFeatureIndices.empty());
+    BOOST_CHECK(tracker->get_used_feature_indices() == usedFeatureIndices);
+
+    size_t splitCount = 0;
+    for(size_t j = 0, featureCount = tracker->get_feature_count(); j < featureCount; ++j)
+    {
+      splitCount += tracker->get_split_count(j);
+    }
+    BOOST_CHECK_EQUAL(splitCount, count_branch_nodes(forest) * (i == 0 ? 1 : 2));
+
+    // The informative features should have been used by some split.
+    if(i == 0)
+    {
+      BOOST_CHECK(tracker->get_split_count(3) > 0);
+      BOOST_CHECK(tracker->get_split_count(17) > 0);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pruned_prediction_test)
+{
+  const unsigned int seed = 12345;
+  RandomNumberGenerator rng(seed);
+
+  RF forest(4, make_settings(DT::DecisionFunctionGenerator_CPtr(new FeatureThresholdingDecisionFunctionGenerator<Label>), seed));
+  forest.add_examples(generate_examples(1000, rng));
+  while(forest.train(16) > 0);
+
+  // Make pruned copies of some new descriptors, in which all of the features that the forest does not use are zeroed.
+  std::vector<size_t> usedFeatureIndices = forest.get_used_feature_indices();
+  std::vector<Example_CPtr> examples = generate_examples(500, rng);
+  const size_t featureCount = examples[0]->get_descriptor()->size();
+  BOOST_REQUIRE(usedFeatureIndices.size() < featureCount);
+
+  DescriptorArena fullArena(examples.size(), featureCount), prunedArena(examples.size(), featureCount);
+  for(size_t i = 0, size = examples.size(); i < size; ++i)
+  {
+    const Descriptor& descriptor = *examples[i]->get_descriptor();
+    std::copy(descriptor.begin(), descriptor.end(), fullArena.get_row(i));
+
+    float *prunedRow = prunedArena.get_row(i);
+    std::fill(prunedRow, prunedRow + featureCount, 0.0f);
+    for(size_t j = 0, usedCount = usedFeatureIndices.size(); j < usedCount; ++j)
+    {
+      prunedRow[usedFeatureIndices[j]] = descriptor[usedFeatureIndices[j]];
+    }
+  }
+
+  // The pruned descriptors should give exactly the same predictions as the full ones.
+  std::vector<ProbabilityMassFunction<Label> > fullPMFs = forest.calculate_pmfs_batch(fullArena);
+  std::vector<ProbabilityMassFunction<Label> > prunedPMFs = forest.calculate_pmfs_batch(prunedArena);
+  BOOST_REQUIRE_EQUAL(fullPMFs.size(), prunedPMFs.size());
+  for(size_t i = 0, size = fullPMFs.size(); i < size; ++i)
+  {
+    BOOST_CHECK(fullPMFs[i].get_masses() == prunedPMFs[i].get_masses());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(save_load_test)
+{
+  DecisionFunctionGeneratorFactory<Label>::instance().register_rafl_makers();
+
+  const unsigned int seed = 12345;
+  RandomNumberGenerator rng(seed);
+
+  RF forest(4, make_settings(DT::DecisionFunctionGenerator_CPtr(new FeatureThresholdingDecisionFunctionGenerator<Label>), seed));
+  forest.add_examples(generate_examples(1000, rng));
+  while(forest.train(16) > 0);
+
+  // Save the forest using Boost serialization and load it again.
+  bf::path forestPath = bf::temp_directory_path() / bf::unique_path();
+  SerializationUtil::save_text(forestPath.string(), forest);
+  boost::shared_ptr<RF> loadedForest = SerializationUtil::load_text(forestPath.string(), loadedForest);
+  bf::remove(forestPath);
+
+  // The loaded forest should report exactly the same feature importances as the original one.
+  FeatureImportanceTracker_Ptr tracker = forest.get_feature_importance_tracker();
+  FeatureImportanceTracker_Ptr loadedTracker = loadedForest->get_feature_importance_tracker();
+  BOOST_REQUIRE(!tracker->get_used_feature_indices().empty());
+  BOOST_CHECK(loadedTracker->get_used_feature_indices() == tracker->get_used_feature_indices());
+  BOOST_REQUIRE_EQUAL(loadedTracker->get_feature_count(), tracker->get_feature_count());
+  for(size_t i = 0, featureCount = tracker->get_feature_count(); i < featureCount; ++i)
+  {
+    BOOST_CHECK_EQUAL(loadedTracker->get_split_count(i), tracker->get_split_count(i));
+    BOOST_CHECK_CLOSE(loadedTracker->get_gain(i), tracker->get_gain(i), 1e-4);
+  }
+
+  // Training the loaded forest further should add to the loaded statistics rather than starting again from scratch.
+  loadedForest->add_examples(generate_examples(1000, rng));
+  while(loadedForest->train(16) > 0);
+  loadedTracker = loadedForest->get_feature_importance_tracker();
+  for(size_t i = 0, featureCount = tracker->get_feature_count(); i < featureCount; ++i)
+  {
+    BOOST_CHECK(loadedTracker->get_split_count(i) >= tracker->get_split_count(i));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
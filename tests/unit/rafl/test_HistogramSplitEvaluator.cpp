@@ -0,0 +1,84 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/assign/list_of.hpp>
+using boost::assign::list_of;
+
+#include <rafl/decisionfunctions/FeatureThresholdingDecisionFunctionGenerator.h>
+#include <rafl/decisionfunctions/HistogramSplitEvaluator.h>
+#include <rafl/decisionfunctions/PairwiseOpAndThresholdDecisionFunctionGenerator.h>
+#include <rafl/examples/UnitCircleExampleGenerator.h>
+using namespace rafl;
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+
+/**
+ * \brief Checks that the histogram-based split evaluator calculates exactly the same gains as explicitly partitioning the examples.
+ *
+ * \param generator      The generator to use to make the split candidates.
+ * \param candidateCount The number of split candidates to make.
+ */
+void check_gains(const DecisionFunctionGenerator<Label>& generator, int candidateCount)
+{
+  tvgutil::RandomNumberGenerator_Ptr rng(new tvgutil::RandomNumberGenerator(12345));
+
+  // Generate an imbalanced set of examples, and some arbitrary multipliers (one label is deliberately left without a multiplier).
+  UnitCircleExampleGenerator<Label> exampleGenerator(list_of(1)(3)(5)(7), 12345);
+  std::vector<Example_CPtr> examples = exampleGenerator.generate_examples(list_of(1)(3)(5), 50);
+  std::vector<Example_CPtr> extraExamples = exampleGenerator.generate_examples(list_of(7), 300);
+  examples.insert(examples.end(), extraExamples.begin(), extraExamples.end());
+
+  std::map<Label,float> multipliers = boost::assign::map_list_of(1,0.5f)(3,2.0f)(7,0.25f);
+  float initialEntropy = ExampleUtil::calculate_entropy(examples, multipliers);
+  float exampleCount = static_cast<float>(examples.size());
+
+  std::vector<DecisionFunction_Ptr> candidates(candidateCount);
+  for(int i = 0; i < candidateCount; ++i)
+  {
+    candidates[i] = generator.generate_candidate_decision_function(examples, rng);
+  }
+
+  HistogramSplitEvaluator<Label> evaluator(examples, multipliers);
+  std::vector<HistogramSplitEvaluator<Label>::Evaluation> evaluations = evaluator.evaluate(candidates, initialEntropy);
+  BOOST_REQUIRE_EQUAL(evaluations.size(), candidates.size());
+
+  for(int i = 0; i < candidateCount; ++i)
+  {
+    std::vector<Example_CPtr> leftExamples, rightExamples;
+    for(size_t j = 0, size = examples.size(); j < size; ++j)
+    {
+      if(candidates[i]->classify_descriptor(*examples[j]->get_descriptor()) == DecisionFunction::DC_LEFT) leftExamples.push_back(examples[j]);
+      else rightExamples.push_back(examples[j]);
+    }
+
+    float leftEntropy = ExampleUtil::calculate_entropy(leftExamples, multipliers);
+    float rightEntropy = ExampleUtil::calculate_entropy(rightExamples, multipliers);
+    float leftWeight = leftExamples.size() / exampleCount;
+    float rightWeight = rightExamples.size() / exampleCount;
+    float expectedGain = initialEntropy - (leftWeight * leftEntropy + rightWeight * rightEntropy);
+
+    BOOST_CHECK_EQUAL(evaluations[i].m_leftCount, leftExamples.size());
+    BOOST_CHECK_EQUAL(evaluations[i].m_rightCount, rightExamples.size());
+    BOOST_CHECK_EQUAL(evaluations[i].m_gain, expectedGain);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(test_HistogramSplitEvaluator)
+
+BOOST_AUTO_TEST_CASE(feature_thresholding_test)
+{
+  // Note: With only two features, the larger candidate count forces the evaluator to use its sorted sweep.
+  FeatureThresholdingDecisionFunctionGenerator<Label> generator;
+  check_gains(generator, 4);
+  check_gains(generator, 256);
+}
+
+BOOST_AUTO_TEST_CASE(pairwise_op_and_threshold_test)
+{
+  PairwiseOpAndThresholdDecisionFunctionGenerator<Label> generator;
+  check_gains(generator, 4);
+  check_gains(generator, 256);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,141 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iterator>
+
+#include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
+using boost::assign::list_of;
+namespace bf = boost::filesystem;
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include <rafl/core/RandomForest.h>
+#include <rafl/examples/UnitCircleExampleGenerator.h>
+using namespace rafl;
+
+#include <tvgutil/SerializationUtil.h>
+using namespace tvgutil;
+
+typedef int Label;
+typedef boost::shared_ptr<const Example<Label> > Example_CPtr;
+typedef DecisionTree<Label> DT;
+typedef RandomForest<Label> RF;
+
+/**
+ * \brief Trains a random forest using the specified number of threads and returns its serialized form.
+ *
+ * \param threadCount The number of threads to use.
+ * \return            The contents of a text archive containing the trained forest.
+ */
+std::string train_and_serialize_forest(int threadCount)
+{
+#ifdef WITH_OPENMP
+  int oldThreadCount = omp_get_max_threads();
+  omp_set_num_threads(threadCount);
+#endif
+
+  const unsigned int seed = 12345;
+
+  DT::Settings settings;
+  settings.candidateCount = 32;
+  settings.decisionFunctionGenerator.reset(new FeatureThresholdingDecisionFunctionGenerator<Label>);
+  settings.gainThreshold = 0.0f;
+  settings.maxClassSize = 200;
+  settings.maxTreeHeight = 10;
+  settings.randomNumberGenerator.reset(new RandomNumberGenerator(seed));
+  settings.seenExamplesThreshold = 20;
+  settings.splittabilityThreshold = 0.5f;
+  settings.usePMFReweighting = true;
+
+  // Interleave adding examples with training, as in the online setting, so that both operations are exercised.
+  const size_t treeCount = 6;
+  RF forest(treeCount, settings);
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(3)(5)(7), seed);
+  for(int i = 0; i < 4; ++i)
+  {
+    forest.add_examples(generator.generate_examples(list_of(1)(3)(5)(7), 100));
+    forest.train(4);
+  }
+
+#ifdef WITH_OPENMP
+  omp_set_num_threads(oldThreadCount);
+#endif
+
+  // Serialize the forest to a temporary file and read back the raw contents of the file.
+  bf::path path = bf::temp_directory_path() / bf::unique_path();
+  SerializationUtil::save_text(path.string(), forest);
+
+  std::string result;
+  {
+    std::ifstream fs(path.string().c_str(), std::ios::binary);
+    result.assign(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+  }
+
+  bf::remove(path);
+  return result;
+}
+
+BOOST_AUTO_TEST_SUITE(test_RandomForest)
+
+BOOST_AUTO_TEST_CASE(deterministic_training_test)
+{
+  std::string serialFor1 = train_and_serialize_forest(1);
+  std::string serialFor4 = train_and_serialize_forest(4);
+  std::string serialFor8 = train_and_serialize_forest(8);
+
+  BOOST_REQUIRE(!serialFor1.empty());
+  BOOST_CHECK(serialFor1 == serialFor4);
+  BOOST_CHECK(serialFor1 == serialFor8);
+}
+
+BOOST_AUTO_TEST_CASE(batch_prediction_test)
+{
+  const unsigned int seed = 12345;
+
+  DT::Settings settings;
+  settings.candidateCount = 32;
+  settings.decisionFunctionGenerator.reset(new FeatureThresholdingDecisionFunctionGenerator<Label>);
+  settings.gainThreshold = 0.0f;
+  settings.maxClassSize = 200;
+  settings.maxTreeHeight = 10;
+  settings.randomNumberGenerator.reset(new RandomNumberGenerator(seed));
+  settings.seenExamplesThreshold = 20;
+  settings.splittabilityThreshold = 0.5f;
+  settings.usePMFReweighting = true;
+
+  RF forest(5, settings);
+  UnitCircleExampleGenerator<Label> generator(list_of(1)(3)(5)(7), seed);
+  forest.add_examples(generator.generate_examples(list_of(1)(3)(5)(7), 200));
+  while(forest.train(16) > 0);
+
+  // Copy the descriptors of some new examples into an arena (using a count that is not a multiple of the tile size).
+  std::vector<Example_CPtr> examples = generator.generate_examples(list_of(1)(3)(5)(7), 250);
+  DescriptorArena arena(examples.size() + 3, 2);
+  for(size_t i = 0, size = arena.get_descriptor_count(); i < size; ++i)
+  {
+    const DescriptorView& descriptor = examples[i % examples.size()]->get_descriptor_view();
+    std::copy(descriptor.begin(), descriptor.end(), arena.get_row(i));
+  }
+
+  // Check that the batch versions of the functions give exactly the same results as their per-descriptor counterparts.
+  std::vector<Label> labels(arena.get_descriptor_count());
+  forest.predict_batch(arena, &labels[0]);
+  std::vector<ProbabilityMassFunction<Label> > pmfs = forest.calculate_pmfs_batch(arena);
+  BOOST_REQUIRE_EQUAL(pmfs.size(), arena.get_descriptor_count());
+
+  for(size_t i = 0, size = arena.get_descriptor_count(); i < size; ++i)
+  {
+    BOOST_CHECK_EQUAL(labels[i], forest.predict(arena.get_view(i)));
+    BOOST_CHECK(pmfs[i].get_masses() == forest.calculate_pmf(arena.get_view(i)).get_masses());
+  }
+
+  // Check that an empty arena is handled correctly.
+  DescriptorArena emptyArena;
+  BOOST_CHECK(forest.calculate_pmfs_batch(emptyArena).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+
+#include <spaint/features/FeatureWorkspace.h>
+#include <spaint/features/cpu/VOPFeatureKernels_CPU.h>
+#include <spaint/features/shared/VOPFeatureCalculator_Shared.h>
+using namespace spaint;
+
+BOOST_AUTO_TEST_SUITE(test_FeatureWorkspace)
+
+BOOST_AUTO_TEST_CASE(layout_test)
+{
+  const size_t patchSize = 13, binCount = 36, threadCount = 3;
+  FeatureWorkspace workspace(patchSize, binCount, threadCount);
+  BOOST_CHECK_EQUAL(workspace.get_thread_count(), static_cast<int>(threadCount));
+
+  // Check that the calling thread's histogram immediately follows its intensity patch, and that both can be written in full.
+  float *intensityPatch = workspace.get_intensity_patch();
+  float *histogram = workspace.get_histogram();
+  BOOST_CHECK_EQUAL(histogram - intensityPatch, static_cast<std::ptrdiff_t>(patchSize * patchSize));
+
+  for(size_t i = 0; i < patchSize * patchSize; ++i) intensityPatch[i] = 1.0f;
+  for(size_t i = 0; i < binCount; ++i) histogram[i] = 2.0f;
+  for(size_t i = 0; i < patchSize * patchSize; ++i) BOOST_CHECK_EQUAL(intensityPatch[i], 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(parity_test)
+{
+  const int patchSize = 13, patchArea = patchSize * patchSize, voxelLocationCount = 100;
+  const int featureCount = patchArea * 3 + 4;
+  const size_t binCount = 36;
+
+  // Generate random RGB patches and coordinate systems for the voxels.
+  boost::mt19937 gen(12345);
+  boost::uniform_real<float> colourDist(0.0f, 255.0f), axisDist(-1.0f, 1.0f);
+  std::vector<float> features(voxelLocationCount * featureCount);
+  for(size_t i = 0, size = features.size(); i < size; ++i) features[i] = colourDist(gen);
+
+  std::vector<Vector3f> xAxes(voxelLocationCount), yAxes(voxelLocationCount);
+  for(int i = 0; i < voxelLocationCount; ++i)
+  {
+    Vector3f n = normalize(Vector3f(axisDist(gen), axisDist(gen), axisDist(gen)));
+    generate_coordinate_system(0, &n, &xAxes[i], &yAxes[i]);
+  }
+
+  // Update the coordinate systems using the per-pixel kernels and freshly-allocated per-voxel storage, as the CPU calculator originally did.
+  std::vector<Vector3f> expectedXAxes = xAxes, expectedYAxes = yAxes;
+  std::vector<std::vector<float> > histograms(voxelLocationCount, std::vector<float>(binCount));
+  std::vector<std::vector<float> > intensities(voxelLocationCount, std::vector<float>(patchArea));
+  const int threadCount = voxelLocationCount * patchArea;
+  for(int tid = 0; tid < threadCount; ++tid)
+  {
+    compute_intensities_for_patch(tid, &features[0], featureCount, patchSize, &intensities[tid / patchArea][0]);
+  }
+  for(int tid = 0; tid < threadCount; ++tid)
+  {
+    compute_histogram_for_patch(tid, patchSize, &intensities[tid / patchArea][0], binCount, &histograms[tid / patchArea][0]);
+  }
+  for(int tid = 0; tid < threadCount; ++tid)
+  {
+    const int voxelLocationIndex = tid / patchArea;
+    update_coordinate_system(tid, patchArea, &histograms[voxelLocationIndex][0], binCount, &expectedXAxes[voxelLocationIndex], &expectedYAxes[voxelLocationIndex]);
+  }
+
+  // Update the coordinate systems a patch at a time using the workspace, and check that the results are identical. Note that the
+  // workspace is deliberately not cleared between voxels, to check that stale data from the previous voxel cannot leak through.
+  FeatureWorkspace workspace(patchSize, binCount);
+  VOPFeatureKernels_CPU kernels(VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR);
+  for(int i = 0; i < voxelLocationCount; ++i)
+  {
+    float *intensityPatch = workspace.get_intensity_patch();
+    float *histogram = workspace.get_histogram();
+    for(int j = 0; j < patchArea; ++j) compute_intensities_for_patch(i * patchArea + j, &features[0], featureCount, patchSize, intensityPatch);
+    kernels.compute_histogram(intensityPatch, patchSize, static_cast<int>(binCount), histogram);
+    update_coordinate_system(i * patchArea, patchArea, histogram, binCount, &xAxes[i], &yAxes[i]);
+  }
+
+  for(int i = 0; i < voxelLocationCount; ++i)
+  {
+    BOOST_CHECK(xAxes[i] == expectedXAxes[i]);
+    BOOST_CHECK(yAxes[i] == expectedYAxes[i]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
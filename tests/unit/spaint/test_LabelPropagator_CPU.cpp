@@ -0,0 +1,342 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ITMLib/Engine/DeviceSpecific/CPU/ITMSceneReconstructionEngine_CPU.h>
+
+#include <spaint/propagation/cpu/LabelPropagator_CPU.h>
+#include <spaint/propagation/shared/LabelPropagator_Shared.h>
+#include <spaint/util/MemoryBlockFactory.h>
+using namespace spaint;
+
+//#################### TYPEDEFS ####################
+
+typedef ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> Scene;
+typedef boost::shared_ptr<Scene> Scene_Ptr;
+
+//#################### CONSTANTS ####################
+
+/** The x coordinate (in voxels) at which the colour of the floor changes (propagation should stop here). */
+const int COLOUR_BOUNDARY_X = 4;
+
+/** The number of voxel blocks by which the floor extends either side of the origin along each of the x and z axes. */
+const int FLOOR_HALF_EXTENT = 16;
+
+/** The label to propagate. */
+const SpaintVoxel::Label LABEL = 1;
+
+/** The largest angle allowed between the normals of neighbouring voxels if propagation is to occur (as in the pipeline). */
+const float MAX_ANGLE_BETWEEN_NORMALS = static_cast<float>(2.0f * M_PI / 180.0f);
+
+/** The maximum squared distance allowed between the colours of neighbouring voxels if propagation is to occur (as in the pipeline). */
+const float MAX_SQUARED_DISTANCE_BETWEEN_COLOURS = 50.0f * 50.0f;
+
+/** The maximum squared distance allowed between the positions of neighbouring voxels if propagation is to occur (as in the pipeline). */
+const float MAX_SQUARED_DISTANCE_BETWEEN_VOXELS = static_cast<float>(INT_MAX);
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Makes a scene containing a flat floor at y = 0, whose colour changes abruptly at x = COLOUR_BOUNDARY_X.
+ *
+ * \param settings  The settings to use for the scene.
+ * \return          The scene.
+ */
+Scene_Ptr make_floor_scene(const ITMLibSettings& settings)
+{
+  Scene_Ptr scene(new Scene(&settings.sceneParams, false, MEMORYDEVICE_CPU));
+  ITMSceneReconstructionEngine_CPU<SpaintVoxel,ITMVoxelIndex> sceneReconstructionEngine;
+  sceneReconstructionEngine.ResetScene(scene.get());
+
+  ITMHashEntry *hashTable = scene->index.GetEntries();
+  int *allocationList = scene->localVBA.GetAllocationList();
+  SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+
+  // Allocate a layer of blocks either side of y = 0, skipping any that collide with an existing block in the ordered part of the table.
+  for(int bz = -FLOOR_HALF_EXTENT; bz < FLOOR_HALF_EXTENT; ++bz)
+    for(int by = -1; by <= 0; ++by)
+      for(int bx = -FLOOR_HALF_EXTENT; bx < FLOOR_HALF_EXTENT; ++bx)
+      {
+        const Vector3s blockPos(static_cast<short>(bx), static_cast<short>(by), static_cast<short>(bz));
+        ITMHashEntry& hashEntry = hashTable[hashIndex(blockPos)];
+        if(hashEntry.ptr >= -1) continue;
+
+        hashEntry.pos = blockPos;
+        hashEntry.offset = 0;
+        hashEntry.ptr = allocationList[scene->localVBA.lastFreeBlockId--];
+
+        for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+        {
+          const int x = bx * SDF_BLOCK_SIZE + linearIdx % SDF_BLOCK_SIZE;
+          const int y = by * SDF_BLOCK_SIZE + (linearIdx / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE;
+
+          SpaintVoxel& voxel = voxelData[hashEntry.ptr * SDF_BLOCK_SIZE3 + linearIdx];
+          voxel.sdf = SpaintVoxel::SDF_floatToValue(std::max(-1.0f, std::min(1.0f, y / 4.0f)));
+          voxel.w_depth = 1;
+#ifndef USE_LOW_POWER_MODE
+          voxel.clr = x < COLOUR_BOUNDARY_X ? Vector3u(220, 200, 160) : Vector3u(60, 40, 30);
+          voxel.w_color = 1;
+#endif
+        }
+      }
+
+  return scene;
+}
+
+/**
+ * \brief Makes a raycast result that looks straight down at the floor, with the specified number of pixels per voxel.
+ *
+ * \param width           The width of the raycast result.
+ * \param height          The height of the raycast result.
+ * \param pixelsPerVoxel  The number of pixels spanned by each voxel along each axis (this can be less than one).
+ * \return                The raycast result.
+ */
+boost::shared_ptr<ITMFloat4Image> make_raycast_result(int width, int height, float pixelsPerVoxel)
+{
+  boost::shared_ptr<ITMFloat4Image> raycastResult(new ITMFloat4Image(Vector2i(width, height), true, false));
+  Vector4f *raycastResultData = raycastResult->GetData(MEMORYDEVICE_CPU);
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      raycastResultData[y * width + x] = Vector4f((x - width / 2 + 0.25f) / pixelsPerVoxel, 0.0f, (y - height / 2 + 0.25f) / pixelsPerVoxel, 1.0f);
+    }
+  }
+  return raycastResult;
+}
+
+/**
+ * \brief Gets the labels of all of the voxels on the surface of the floor.
+ *
+ * \param scene The scene.
+ * \return      The labels of the voxels on the surface of the floor.
+ */
+std::vector<SpaintVoxel::PackedLabel> get_floor_labels(const Scene& scene)
+{
+  std::vector<SpaintVoxel::PackedLabel> labels;
+  const int limit = FLOOR_HALF_EXTENT * SDF_BLOCK_SIZE;
+  for(int z = -limit; z < limit; ++z)
+  {
+    for(int x = -limit; x < limit; ++x)
+    {
+      bool isFound;
+      SpaintVoxel voxel = readVoxel(scene.localVBA.GetVoxelBlocks(), scene.index.getIndexData(), Vector3i(x, 0, z), isFound);
+      labels.push_back(isFound ? voxel.packedLabel : SpaintVoxel::PackedLabel());
+    }
+  }
+  return labels;
+}
+
+/**
+ * \brief Propagates a label across the scene by performing a single sweep over the entire raycast result, in which
+ *        every pixel is tested against the labels present at the start of the sweep before any of them are marked.
+ *
+ * \param raycastResult The raycast result.
+ * \param scene         The scene.
+ */
+void propagate_by_single_sweep(const ITMFloat4Image& raycastResult, Scene& scene)
+{
+  const int width = raycastResult.noDims.x, height = raycastResult.noDims.y;
+  const int raycastResultSize = static_cast<int>(raycastResult.dataSize);
+  const ITMVoxelIndex::IndexData *indexData = scene.index.getIndexData();
+  const Vector4f *raycastResultData = raycastResult.GetData(MEMORYDEVICE_CPU);
+  SpaintVoxel *voxelData = scene.localVBA.GetVoxelBlocks();
+
+  std::vector<Vector3f> surfaceNormals(raycastResultSize);
+  for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+  {
+    write_surface_normal(voxelIndex, raycastResultData, voxelData, indexData, &surfaceNormals[0]);
+  }
+
+  std::vector<unsigned char> shouldMark(raycastResultSize);
+  for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+  {
+    shouldMark[voxelIndex] = should_propagate_from_neighbours(
+      voxelIndex, width, height, LABEL, raycastResultData, &surfaceNormals[0], voxelData, indexData,
+      MAX_ANGLE_BETWEEN_NORMALS, MAX_SQUARED_DISTANCE_BETWEEN_COLOURS, MAX_SQUARED_DISTANCE_BETWEEN_VOXELS
+    );
+  }
+
+  for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+  {
+    if(shouldMark[voxelIndex])
+    {
+      const Vector3s loc = raycastResultData[voxelIndex].toVector3().toShortRound();
+      mark_voxel(loc, SpaintVoxel::PackedLabel(LABEL, SpaintVoxel::LG_PROPAGATED), NULL, voxelData, indexData);
+    }
+  }
+}
+
+/**
+ * \brief Propagates a label across the scene by repeatedly sweeping over the entire raycast result (as the CUDA propagator
+ *        does once per frame), until a sweep no longer changes the labels of any voxels.
+ *
+ * \param raycastResult The raycast result.
+ * \param scene         The scene.
+ */
+void propagate_by_sweeping(const ITMFloat4Image& raycastResult, Scene& scene)
+{
+  const int width = raycastResult.noDims.x, height = raycastResult.noDims.y;
+  const int raycastResultSize = static_cast<int>(raycastResult.dataSize);
+  const ITMVoxelIndex::IndexData *indexData = scene.index.getIndexData();
+  const Vector4f *raycastResultData = raycastResult.GetData(MEMORYDEVICE_CPU);
+  SpaintVoxel *voxelData = scene.localVBA.GetVoxelBlocks();
+
+  std::vector<Vector3f> surfaceNormals(raycastResultSize);
+  for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+  {
+    write_surface_normal(voxelIndex, raycastResultData, voxelData, indexData, &surfaceNormals[0]);
+  }
+
+  std::vector<SpaintVoxel::PackedLabel> labels = get_floor_labels(scene), oldLabels;
+  do
+  {
+    oldLabels = labels;
+    for(int voxelIndex = 0; voxelIndex < raycastResultSize; ++voxelIndex)
+    {
+      propagate_from_neighbours(
+        voxelIndex, width, height, LABEL, raycastResultData, &surfaceNormals[0], voxelData, indexData,
+        MAX_ANGLE_BETWEEN_NORMALS, MAX_SQUARED_DISTANCE_BETWEEN_COLOURS, MAX_SQUARED_DISTANCE_BETWEEN_VOXELS
+      );
+    }
+    labels = get_floor_labels(scene);
+  }
+  while(labels != oldLabels);
+}
+
+/**
+ * \brief Clears the labels of all of the voxels on the surface of the floor, and then labels the voxels that are visible
+ *        in a small square of the raycast result (to the left of the colour boundary), as if they had been painted by the user.
+ *
+ * \param raycastResult The raycast result.
+ * \param scene         The scene.
+ */
+void reset_labels(const ITMFloat4Image& raycastResult, Scene& scene)
+{
+  const ITMVoxelIndex::IndexData *indexData = scene.index.getIndexData();
+  const Vector4f *raycastResultData = raycastResult.GetData(MEMORYDEVICE_CPU);
+  SpaintVoxel *voxelData = scene.localVBA.GetVoxelBlocks();
+  const int width = raycastResult.noDims.x;
+
+  const int limit = FLOOR_HALF_EXTENT * SDF_BLOCK_SIZE;
+  for(int z = -limit; z < limit; ++z)
+  {
+    for(int x = -limit; x < limit; ++x)
+    {
+      mark_voxel(Vector3s(static_cast<short>(x), 0, static_cast<short>(z)), SpaintVoxel::PackedLabel(), NULL, voxelData, indexData, FORCED_MARKING);
+    }
+  }
+
+  for(int y = 50; y < 70; ++y)
+  {
+    for(int x = 20; x < 40; ++x)
+    {
+      const Vector3s loc = raycastResultData[y * width + x].toVector3().toShortRound();
+      mark_voxel(loc, SpaintVoxel::PackedLabel(LABEL, SpaintVoxel::LG_USER), NULL, voxelData, indexData);
+    }
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_LabelPropagator_CPU)
+
+BOOST_AUTO_TEST_CASE(parity_test)
+{
+  MemoryBlockFactory::instance().set_device_type(ITMLibSettings::DEVICE_CPU);
+
+  ITMLibSettings settings;
+  Scene_Ptr scene = make_floor_scene(settings);
+
+  const int width = 160, height = 120;
+  LabelPropagator_CPU propagator(width * height, MAX_ANGLE_BETWEEN_NORMALS, MAX_SQUARED_DISTANCE_BETWEEN_COLOURS, MAX_SQUARED_DISTANCE_BETWEEN_VOXELS, INT_MAX);
+
+  // Check that the incremental propagator (when allowed to run to completion) reaches exactly the same labelling as repeated sweeps over the raycast result,
+  // whether the camera is far from the floor (several voxels per pixel) or close to it (a voxel spans many pixels, more
+  // than the window in which the propagator looks for pixels that share a newly-labelled voxel).
+  const float pixelsPerVoxels[] = { 0.5f, 1.0f, 2.0f, 3.0f, 8.0f, 12.0f, 25.0f };
+  for(size_t i = 0; i < sizeof(pixelsPerVoxels) / sizeof(float); ++i)
+  {
+    boost::shared_ptr<ITMFloat4Image> raycastResult = make_raycast_result(width, height, pixelsPerVoxels[i]);
+
+    reset_labels(*raycastResult, *scene);
+    const std::vector<SpaintVoxel::PackedLabel> seedLabels = get_floor_labels(*scene);
+    propagator.propagate_label(LABEL, raycastResult.get(), scene.get());
+    const std::vector<SpaintVoxel::PackedLabel> incrementalLabels = get_floor_labels(*scene);
+
+    reset_labels(*raycastResult, *scene);
+    propagate_by_sweeping(*raycastResult, *scene);
+    const std::vector<SpaintVoxel::PackedLabel> sweptLabels = get_floor_labels(*scene);
+
+    BOOST_CHECK(incrementalLabels == sweptLabels);
+
+    // Check that the label actually spread beyond the seed, but not across the colour boundary.
+    size_t seedCount = 0, labelledCount = 0;
+    bool crossedBoundary = false;
+    const int limit = FLOOR_HALF_EXTENT * SDF_BLOCK_SIZE;
+    for(size_t j = 0, size = incrementalLabels.size(); j < size; ++j)
+    {
+      if(seedLabels[j].label == LABEL) ++seedCount;
+      if(incrementalLabels[j].label != LABEL) continue;
+      ++labelledCount;
+      if(static_cast<int>(j % (2 * limit)) - limit >= COLOUR_BOUNDARY_X) crossedBoundary = true;
+    }
+    BOOST_CHECK_GT(labelledCount, seedCount);
+    BOOST_CHECK(!crossedBoundary);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(single_sweep_test)
+{
+  MemoryBlockFactory::instance().set_device_type(ITMLibSettings::DEVICE_CPU);
+
+  ITMLibSettings settings;
+  Scene_Ptr scene = make_floor_scene(settings);
+
+  // Use a propagator with the default settings, which performs one sweep per call (as the CUDA propagator does).
+  const int width = 160, height = 120;
+  LabelPropagator_CPU propagator(width * height, MAX_ANGLE_BETWEEN_NORMALS, MAX_SQUARED_DISTANCE_BETWEEN_COLOURS, MAX_SQUARED_DISTANCE_BETWEEN_VOXELS);
+
+  const float pixelsPerVoxels[] = { 0.5f, 1.0f, 2.0f, 8.0f, 25.0f };
+  for(size_t i = 0; i < sizeof(pixelsPerVoxels) / sizeof(float); ++i)
+  {
+    boost::shared_ptr<ITMFloat4Image> raycastResult = make_raycast_result(width, height, pixelsPerVoxels[i]);
+
+    // Check that a single call labels exactly the voxels labelled by a single sweep over the whole raycast result.
+    reset_labels(*raycastResult, *scene);
+    propagator.propagate_label(LABEL, raycastResult.get(), scene.get());
+    std::vector<SpaintVoxel::PackedLabel> incrementalLabels = get_floor_labels(*scene);
+
+    reset_labels(*raycastResult, *scene);
+    propagate_by_single_sweep(*raycastResult, *scene);
+    BOOST_CHECK(incrementalLabels == get_floor_labels(*scene));
+
+    // Check that calling the propagator repeatedly (as on successive frames) reaches the same labelling as repeated sweeps,
+    // and that it needs more than one call to do so (i.e. that each call is actually bounded to a single sweep).
+    reset_labels(*raycastResult, *scene);
+    std::vector<SpaintVoxel::PackedLabel> oldLabels;
+    incrementalLabels = get_floor_labels(*scene);
+    size_t callCount = 0;
+    do
+    {
+      oldLabels = incrementalLabels;
+      propagator.propagate_label(LABEL, raycastResult.get(), scene.get());
+      incrementalLabels = get_floor_labels(*scene);
+      ++callCount;
+    }
+    while(incrementalLabels != oldLabels);
+
+    reset_labels(*raycastResult, *scene);
+    propagate_by_sweeping(*raycastResult, *scene);
+    BOOST_CHECK(incrementalLabels == get_floor_labels(*scene));
+    BOOST_CHECK_GT(callCount, 2);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
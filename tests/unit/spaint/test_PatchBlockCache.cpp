@@ -0,0 +1,202 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <vector>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+
+#include <spaint/features/shared/VOPFeatureCalculator_Shared.h>
+using namespace spaint;
+
+//#################### HELPER TYPES ####################
+
+/**
+ * \brief An instance of this struct represents a minimal voxel block hash scene with a flat floor at y = 0.
+ */
+struct FloorScene
+{
+  std::vector<ITMHashEntry> hashTable;
+  std::vector<SpaintVoxel> voxelData;
+
+  explicit FloorScene(int halfExtent)
+  : hashTable(ITMVoxelBlockHash::noTotalEntries)
+  {
+    for(size_t i = 0, size = hashTable.size(); i < size; ++i)
+    {
+      hashTable[i].pos = Vector3s(0, 0, 0);
+      hashTable[i].offset = 0;
+      hashTable[i].ptr = -2;
+    }
+
+    // Allocate a layer of blocks either side of y = 0, skipping any that collide with an existing block in the ordered part of the table.
+    int blockCount = 0;
+    for(int bz = -halfExtent; bz < halfExtent; ++bz)
+      for(int by = -1; by <= 0; ++by)
+        for(int bx = -halfExtent; bx < halfExtent; ++bx)
+        {
+          const Vector3s blockPos(static_cast<short>(bx), static_cast<short>(by), static_cast<short>(bz));
+          ITMHashEntry& hashEntry = hashTable[hashIndex(blockPos)];
+          if(hashEntry.ptr >= -1) continue;
+          hashEntry.pos = blockPos;
+          hashEntry.ptr = blockCount++;
+        }
+
+    // Give each voxel a colour that identifies it.
+    voxelData.resize(blockCount * SDF_BLOCK_SIZE3);
+    for(size_t i = 0, size = voxelData.size(); i < size; ++i)
+    {
+#ifndef USE_LOW_POWER_MODE
+      voxelData[i].clr = Vector3u(static_cast<uchar>(i % 251), static_cast<uchar>((i / 251) % 251), static_cast<uchar>(i / (251 * 251)));
+#endif
+    }
+  }
+};
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Generates an RGB patch by performing a full lookup for each sample (as patches were originally gathered).
+ */
+void generate_rgb_patch_without_cache(const Vector3s& voxelLocation, const Vector3f& xAxis, const Vector3f& yAxis, const FloorScene& scene,
+                                      int patchSize, float patchSpacing, float *patch, std::set<std::vector<int> >& blocksTouched)
+{
+  const int halfPatchSize = (patchSize - 1) / 2;
+  const Vector3f centre = voxelLocation.toFloat();
+  for(int y = -halfPatchSize; y <= halfPatchSize; ++y)
+  {
+    for(int x = -halfPatchSize; x <= halfPatchSize; ++x)
+    {
+      Vector3i loc = (centre + static_cast<float>(y) * (yAxis * patchSpacing) + static_cast<float>(x) * (xAxis * patchSpacing)).toIntRound();
+
+      std::vector<int> blockPos(3);
+      blockPos[0] = (loc.x < 0 ? loc.x - SDF_BLOCK_SIZE + 1 : loc.x) / SDF_BLOCK_SIZE;
+      blockPos[1] = (loc.y < 0 ? loc.y - SDF_BLOCK_SIZE + 1 : loc.y) / SDF_BLOCK_SIZE;
+      blockPos[2] = (loc.z < 0 ? loc.z - SDF_BLOCK_SIZE + 1 : loc.z) / SDF_BLOCK_SIZE;
+      blocksTouched.insert(blockPos);
+
+      bool isFound;
+      Vector3u clr(255, 0, 255);
+      SpaintVoxel voxel = readVoxel(&scene.voxelData[0], &scene.hashTable[0], loc, isFound);
+      if(isFound) clr = VoxelColourReader<SpaintVoxel::hasColorInformation>::read(voxel);
+
+      *patch++ = clr.r;
+      *patch++ = clr.g;
+      *patch++ = clr.b;
+    }
+  }
+}
+
+/**
+ * \brief Checks that gathering a patch via a patch block cache (or via the cache-less version of generate_rgb_patch used on the GPU)
+ *        yields the same result as gathering it by hand, and that the cache looks up each block touched by the patch exactly once
+ *        (provided that no two of them share a slot).
+ */
+void check_patch(const FloorScene& scene, const Vector3s& voxelLocation, const Vector3f& xAxis, const Vector3f& yAxis, int patchSize, float patchSpacing)
+{
+  const int featureCount = patchSize * patchSize * 3 + 4;
+  std::vector<float> directFeatures(featureCount), expectedFeatures(featureCount), features(featureCount);
+  std::set<std::vector<int> > blocksTouched;
+  generate_rgb_patch_without_cache(voxelLocation, xAxis, yAxis, scene, patchSize, patchSpacing, &expectedFeatures[0], blocksTouched);
+
+  PatchBlockCache cache;
+  generate_rgb_patch(0, &voxelLocation, &xAxis, &yAxis, &scene.voxelData[0], &scene.hashTable[0], patchSize, patchSpacing, featureCount, &features[0], cache);
+
+  std::set<int> slotsTouched;
+  for(std::set<std::vector<int> >::const_iterator it = blocksTouched.begin(), iend = blocksTouched.end(); it != iend; ++it)
+  {
+    const std::vector<int>& blockPos = *it;
+    slotsTouched.insert(PatchBlockCache::get_slot(Vector3s(static_cast<short>(blockPos[0]), static_cast<short>(blockPos[1]), static_cast<short>(blockPos[2]))));
+  }
+
+  generate_rgb_patch(0, &voxelLocation, &xAxis, &yAxis, &scene.voxelData[0], &scene.hashTable[0], patchSize, patchSpacing, featureCount, &directFeatures[0]);
+
+  BOOST_CHECK(features == expectedFeatures);
+  BOOST_CHECK(directFeatures == expectedFeatures);
+  if(slotsTouched.size() == blocksTouched.size()) BOOST_CHECK_EQUAL(cache.lookupCount, static_cast<int>(blocksTouched.size()));
+  else BOOST_CHECK_GE(cache.lookupCount, static_cast<int>(blocksTouched.size()));
+  BOOST_CHECK_LE(cache.lookupCount, patchSize * patchSize);
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_PatchBlockCache)
+
+BOOST_AUTO_TEST_CASE(lookup_count_test)
+{
+  FloorScene scene(8);
+
+  // Check patches of various sizes at various orientations, both on the floor and straddling its edge.
+  for(int patchSize = 7; patchSize <= 21; patchSize += 2)
+  {
+    for(int i = 0; i < 8; ++i)
+    {
+      const float angle = static_cast<float>(i * M_PI / 8);
+      const Vector3f xAxis(cosf(angle), 0.0f, sinf(angle)), yAxis(-sinf(angle), 0.0f, cosf(angle));
+      check_patch(scene, Vector3s(3, 0, -5), xAxis, yAxis, patchSize, 2.0f);
+      check_patch(scene, Vector3s(60, 0, 60), xAxis, yAxis, patchSize, 2.0f);
+    }
+  }
+
+  // Check that a typical 13x13 patch on the floor only needs a handful of lookups, rather than one per sample.
+  PatchBlockCache cache;
+  const Vector3s voxelLocation(0, 0, 0);
+  const Vector3f xAxis(1.0f, 0.0f, 0.0f), yAxis(0.0f, 0.0f, 1.0f);
+  std::vector<float> features(13 * 13 * 3 + 4);
+  generate_rgb_patch(0, &voxelLocation, &xAxis, &yAxis, &scene.voxelData[0], &scene.hashTable[0], 13, 2.0f, features.size(), &features[0], cache);
+  BOOST_CHECK_LE(cache.lookupCount, 16);
+}
+
+BOOST_AUTO_TEST_CASE(conflict_test)
+{
+  // With a large enough spacing, every sample in a 21x21 patch lies in a different block, so many of the blocks share slots in the cache.
+  FloorScene scene(64);
+  const Vector3f xAxis(1.0f, 0.0f, 0.0f), yAxis(0.0f, 0.0f, 1.0f);
+  check_patch(scene, Vector3s(0, 0, 0), xAxis, yAxis, 21, 9.0f);
+}
+
+BOOST_AUTO_TEST_CASE(read_test)
+{
+  FloorScene scene(4);
+  PatchBlockCache cache;
+  for(int z = -40; z < 40; z += 3)
+    for(int y = -12; y < 12; ++y)
+      for(int x = -40; x < 40; x += 5)
+      {
+        const Vector3i loc(x, y, z);
+        bool isFound;
+        SpaintVoxel expectedVoxel = readVoxel(&scene.voxelData[0], &scene.hashTable[0], loc, isFound);
+        const SpaintVoxel *voxel = read_voxel_via_cache(loc, &scene.voxelData[0], &scene.hashTable[0], cache);
+        BOOST_REQUIRE_EQUAL(voxel != NULL, isFound);
+#ifndef USE_LOW_POWER_MODE
+        if(voxel) BOOST_CHECK(voxel->clr == expectedVoxel.clr);
+#endif
+      }
+}
+
+BOOST_AUTO_TEST_CASE(tile_key_test)
+{
+  // Voxels in the same block should have the same key, and voxels in different blocks (within range) should have different keys.
+  BOOST_CHECK_EQUAL(compute_tile_key(Vector3s(0, 0, 0)), compute_tile_key(Vector3s(7, 7, 7)));
+  BOOST_CHECK_EQUAL(compute_tile_key(Vector3s(-1, -8, -3)), compute_tile_key(Vector3s(-8, -1, -6)));
+  BOOST_CHECK_EQUAL(compute_tile_key(Vector3s(0, 0, 0)), 0u);
+
+  std::set<unsigned int> keys;
+  for(int bz = -4; bz < 4; ++bz)
+    for(int by = -4; by < 4; ++by)
+      for(int bx = -4; bx < 4; ++bx)
+      {
+        keys.insert(compute_tile_key(Vector3s(static_cast<short>(bx * SDF_BLOCK_SIZE), static_cast<short>(by * SDF_BLOCK_SIZE), static_cast<short>(bz * SDF_BLOCK_SIZE))));
+      }
+  BOOST_CHECK_EQUAL(keys.size(), 512u);
+
+  // The blocks in each 2x2x2 group of blocks aligned to even coordinates should have consecutive keys.
+  const unsigned int baseKey = compute_tile_key(Vector3s(16, 16, 16));
+  for(int i = 0; i < 8; ++i)
+  {
+    const Vector3s loc(static_cast<short>(16 + (i & 1) * SDF_BLOCK_SIZE), static_cast<short>(16 + ((i >> 1) & 1) * SDF_BLOCK_SIZE), static_cast<short>(16 + ((i >> 2) & 1) * SDF_BLOCK_SIZE));
+    BOOST_CHECK_EQUAL(compute_tile_key(loc), baseKey + i);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
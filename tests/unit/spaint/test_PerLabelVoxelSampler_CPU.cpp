@@ -0,0 +1,290 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+#include <ITMLib/Engine/DeviceSpecific/CPU/ITMSceneReconstructionEngine_CPU.h>
+
+#include <spaint/sampling/cpu/PerLabelVoxelSampler_CPU.h>
+#include <spaint/util/MemoryBlockFactory.h>
+using namespace spaint;
+
+//#################### TYPEDEFS ####################
+
+typedef ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> Scene;
+typedef boost::shared_ptr<Scene> Scene_Ptr;
+
+//#################### CONSTANTS ####################
+
+/** The width (and height) of the square patch of floor that is visible in the raycast result (in voxels, one per pixel). */
+const int FLOOR_SIZE = 64;
+
+/** The maximum number of labels that can be in use. */
+const size_t MAX_LABEL_COUNT = 8;
+
+/** The maximum number of voxels to sample for each label. */
+const size_t MAX_VOXELS_PER_LABEL = 64;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Gets the label with which the voxel at the specified location on the floor is marked.
+ *
+ * The floor is divided into labelled regions of different sizes, so that the sampler has differing numbers of candidates
+ * to choose from for each label: label 1 covers a 16x16 square, label 2 a 40x8 strip, label 3 a row of 10 voxels (fewer
+ * than the number of voxels to sample), and label 0 (the background) covers everything else. A 4x4 square is marked with
+ * label 4 by the forest (voxels whose labels were predicted by the forest should never be sampled).
+ *
+ * \param x     The x coordinate of the voxel.
+ * \param z     The z coordinate of the voxel.
+ * \param group A place in which to store the group of the label.
+ * \return      The label.
+ */
+SpaintVoxel::Label get_floor_label(int x, int z, SpaintVoxel::LabelGroup& group)
+{
+  group = SpaintVoxel::LG_USER;
+  if(x < 16 && z < 16) return 1;
+  if(x >= 16 && x < 56 && z >= 20 && z < 28) return 2;
+  if(x >= 30 && x < 40 && z == 40) return 3;
+  if(x >= 50 && z >= 50 && x < 54 && z < 54)
+  {
+    group = SpaintVoxel::LG_FOREST;
+    return 4;
+  }
+  return 0;
+}
+
+/**
+ * \brief Makes a scene containing a labelled square of floor at y = 0, with its corner at the origin.
+ *
+ * \param settings  The settings to use for the scene.
+ * \return          The scene.
+ */
+Scene_Ptr make_floor_scene(const ITMLibSettings& settings)
+{
+  Scene_Ptr scene(new Scene(&settings.sceneParams, false, MEMORYDEVICE_CPU));
+  ITMSceneReconstructionEngine_CPU<SpaintVoxel,ITMVoxelIndex> sceneReconstructionEngine;
+  sceneReconstructionEngine.ResetScene(scene.get());
+
+  ITMHashEntry *hashTable = scene->index.GetEntries();
+  int *allocationList = scene->localVBA.GetAllocationList();
+  SpaintVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+
+  // Allocate the blocks that contain the floor, skipping any that collide with an existing block in the ordered part of the table.
+  for(int bz = 0; bz < FLOOR_SIZE / SDF_BLOCK_SIZE; ++bz)
+    for(int bx = 0; bx < FLOOR_SIZE / SDF_BLOCK_SIZE; ++bx)
+    {
+      const Vector3s blockPos(static_cast<short>(bx), 0, static_cast<short>(bz));
+      ITMHashEntry& hashEntry = hashTable[hashIndex(blockPos)];
+      if(hashEntry.ptr >= -1) continue;
+
+      hashEntry.pos = blockPos;
+      hashEntry.offset = 0;
+      hashEntry.ptr = allocationList[scene->localVBA.lastFreeBlockId--];
+
+      for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+      {
+        const int x = bx * SDF_BLOCK_SIZE + linearIdx % SDF_BLOCK_SIZE;
+        const int z = bz * SDF_BLOCK_SIZE + linearIdx / (SDF_BLOCK_SIZE * SDF_BLOCK_SIZE);
+
+        SpaintVoxel::LabelGroup group;
+        const SpaintVoxel::Label label = get_floor_label(x, z, group);
+        voxelData[hashEntry.ptr * SDF_BLOCK_SIZE3 + linearIdx].packedLabel = SpaintVoxel::PackedLabel(label, group);
+      }
+    }
+
+  return scene;
+}
+
+/**
+ * \brief Makes a raycast result that looks straight down at the floor, with one voxel per pixel.
+ *
+ * \return  The raycast result.
+ */
+boost::shared_ptr<ITMFloat4Image> make_raycast_result()
+{
+  boost::shared_ptr<ITMFloat4Image> raycastResult(new ITMFloat4Image(Vector2i(FLOOR_SIZE, FLOOR_SIZE), true, false));
+  Vector4f *raycastResultData = raycastResult->GetData(MEMORYDEVICE_CPU);
+  for(int z = 0; z < FLOOR_SIZE; ++z)
+  {
+    for(int x = 0; x < FLOOR_SIZE; ++x)
+    {
+      raycastResultData[z * FLOOR_SIZE + x] = Vector4f(static_cast<float>(x), 0.0f, static_cast<float>(z), 1.0f);
+    }
+  }
+  return raycastResult;
+}
+
+/**
+ * \brief Calculates an approximate critical value for the chi-squared distribution (using the Wilson-Hilferty transformation).
+ *
+ * \param degreesOfFreedom  The number of degrees of freedom.
+ * \param z                 The standard normal quantile corresponding to the desired significance level.
+ * \return                  The critical value.
+ */
+double chi_squared_critical_value(int degreesOfFreedom, double z)
+{
+  const double k = degreesOfFreedom;
+  const double t = 1.0 - 2.0 / (9.0 * k) + z * sqrt(2.0 / (9.0 * k));
+  return k * t * t * t;
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_PerLabelVoxelSampler_CPU)
+
+BOOST_AUTO_TEST_CASE(uniformity_test)
+{
+  MemoryBlockFactory::instance().set_device_type(ITMLibSettings::DEVICE_CPU);
+
+  ITMLibSettings settings;
+  Scene_Ptr scene = make_floor_scene(settings);
+  boost::shared_ptr<ITMFloat4Image> raycastResult = make_raycast_result();
+
+  // Determine the candidate voxels for each label.
+  std::map<SpaintVoxel::Label,int> candidateCounts;
+  for(int z = 0; z < FLOOR_SIZE; ++z)
+  {
+    for(int x = 0; x < FLOOR_SIZE; ++x)
+    {
+      SpaintVoxel::LabelGroup group;
+      const SpaintVoxel::Label label = get_floor_label(x, z, group);
+      if(group != SpaintVoxel::LG_FOREST) ++candidateCounts[label];
+    }
+  }
+
+  // Use labels 0 to 4 (label 4 has voxels in the scene, but they were all labelled by the forest, so it has no candidates).
+  ORUtils::MemoryBlock<bool> labelMaskMB(MAX_LABEL_COUNT, true, false);
+  bool *labelMask = labelMaskMB.GetData(MEMORYDEVICE_CPU);
+  for(size_t k = 0; k < MAX_LABEL_COUNT; ++k) labelMask[k] = k <= 4;
+
+  ORUtils::MemoryBlock<Vector3s> sampledVoxelLocationsMB(MAX_LABEL_COUNT * MAX_VOXELS_PER_LABEL, true, false);
+  ORUtils::MemoryBlock<unsigned int> voxelCountsForLabelsMB(MAX_LABEL_COUNT, true, false);
+  const Vector3s *sampledVoxelLocations = sampledVoxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+  const unsigned int *voxelCountsForLabels = voxelCountsForLabelsMB.GetData(MEMORYDEVICE_CPU);
+
+  // Sample voxels repeatedly, counting how many times each voxel is sampled for each label.
+  const unsigned int seed = 12345;
+  const int runCount = 400;
+  PerLabelVoxelSampler_CPU sampler(MAX_LABEL_COUNT, MAX_VOXELS_PER_LABEL, FLOOR_SIZE * FLOOR_SIZE, seed);
+  std::map<SpaintVoxel::Label,std::vector<int> > sampleCounts;
+  for(int run = 0; run < runCount; ++run)
+  {
+    sampler.sample_voxels(raycastResult.get(), scene.get(), labelMaskMB, sampledVoxelLocationsMB, voxelCountsForLabelsMB);
+
+    for(SpaintVoxel::Label k = 0; k < MAX_LABEL_COUNT; ++k)
+    {
+      // Each used label should be sampled as many times as possible, and each unused label should not be sampled at all.
+      const int candidateCount = labelMask[k] ? candidateCounts[k] : 0;
+      BOOST_REQUIRE_EQUAL(voxelCountsForLabels[k], static_cast<unsigned int>(std::min(candidateCount, static_cast<int>(MAX_VOXELS_PER_LABEL))));
+
+      std::vector<int>& counts = sampleCounts[k];
+      counts.resize(FLOOR_SIZE * FLOOR_SIZE);
+      for(unsigned int i = 0; i < voxelCountsForLabels[k]; ++i)
+      {
+        // Each sampled voxel should have been marked with the label by the user.
+        const Vector3s& loc = sampledVoxelLocations[k * MAX_VOXELS_PER_LABEL + i];
+        SpaintVoxel::LabelGroup group;
+        BOOST_REQUIRE(loc.x >= 0 && loc.x < FLOOR_SIZE && loc.y == 0 && loc.z >= 0 && loc.z < FLOOR_SIZE);
+        BOOST_REQUIRE_EQUAL(get_floor_label(loc.x, loc.z, group), k);
+        BOOST_REQUIRE(group != SpaintVoxel::LG_FOREST);
+        ++counts[loc.z * FLOOR_SIZE + loc.x];
+      }
+    }
+  }
+
+  for(SpaintVoxel::Label k = 0; k <= 3; ++k)
+  {
+    const std::vector<int>& counts = sampleCounts[k];
+    const int candidateCount = candidateCounts[k];
+
+    if(candidateCount <= static_cast<int>(MAX_VOXELS_PER_LABEL))
+    {
+      // If there are too few candidates for the label, each of them should have been used exactly once in each run.
+      for(size_t i = 0, size = counts.size(); i < size; ++i)
+      {
+        SpaintVoxel::LabelGroup group;
+        const bool isCandidate = get_floor_label(static_cast<int>(i % FLOOR_SIZE), static_cast<int>(i / FLOOR_SIZE), group) == k;
+        BOOST_CHECK_EQUAL(counts[i], isCandidate ? runCount : 0);
+      }
+    }
+    else
+    {
+      // Otherwise, the candidates should have been sampled uniformly: perform a chi-squared goodness-of-fit test
+      // against the uniform distribution (the seed is fixed, so this is deterministic).
+      const double expected = static_cast<double>(runCount * MAX_VOXELS_PER_LABEL) / candidateCount;
+      double chiSquared = 0.0;
+      for(size_t i = 0, size = counts.size(); i < size; ++i)
+      {
+        SpaintVoxel::LabelGroup group;
+        if(get_floor_label(static_cast<int>(i % FLOOR_SIZE), static_cast<int>(i / FLOOR_SIZE), group) != k || group == SpaintVoxel::LG_FOREST) continue;
+        const double difference = counts[i] - expected;
+        chiSquared += difference * difference / expected;
+      }
+
+      // Use a significance level of 0.1% (the corresponding standard normal quantile is 3.09).
+      BOOST_CHECK_LT(chiSquared, chi_squared_critical_value(candidateCount - 1, 3.09));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(thread_count_test)
+{
+#ifdef WITH_OPENMP
+  MemoryBlockFactory::instance().set_device_type(ITMLibSettings::DEVICE_CPU);
+
+  ITMLibSettings settings;
+  Scene_Ptr scene = make_floor_scene(settings);
+  boost::shared_ptr<ITMFloat4Image> raycastResult = make_raycast_result();
+
+  ORUtils::MemoryBlock<bool> labelMaskMB(MAX_LABEL_COUNT, true, false);
+  bool *labelMask = labelMaskMB.GetData(MEMORYDEVICE_CPU);
+  for(size_t k = 0; k < MAX_LABEL_COUNT; ++k) labelMask[k] = k <= 4;
+
+  // Sample voxels several times using samplers with the same seed, but different numbers of threads.
+  const unsigned int seed = 12345;
+  const int runCount = 5;
+  const int threadCounts[] = { 1, 3, 8 };
+  const int originalThreadCount = omp_get_max_threads();
+  std::vector<std::vector<Vector3s> > sampledVoxelLocations(sizeof(threadCounts) / sizeof(int));
+  for(size_t t = 0; t < sizeof(threadCounts) / sizeof(int); ++t)
+  {
+    omp_set_num_threads(threadCounts[t]);
+
+    PerLabelVoxelSampler_CPU sampler(MAX_LABEL_COUNT, MAX_VOXELS_PER_LABEL, FLOOR_SIZE * FLOOR_SIZE, seed);
+    ORUtils::MemoryBlock<Vector3s> sampledVoxelLocationsMB(MAX_LABEL_COUNT * MAX_VOXELS_PER_LABEL, true, false);
+    ORUtils::MemoryBlock<unsigned int> voxelCountsForLabelsMB(MAX_LABEL_COUNT, true, false);
+    for(int run = 0; run < runCount; ++run)
+    {
+      sampler.sample_voxels(raycastResult.get(), scene.get(), labelMaskMB, sampledVoxelLocationsMB, voxelCountsForLabelsMB);
+
+      const Vector3s *locs = sampledVoxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+      const unsigned int *voxelCountsForLabels = voxelCountsForLabelsMB.GetData(MEMORYDEVICE_CPU);
+      for(size_t k = 0; k < MAX_LABEL_COUNT; ++k)
+      {
+        sampledVoxelLocations[t].insert(sampledVoxelLocations[t].end(), locs + k * MAX_VOXELS_PER_LABEL, locs + k * MAX_VOXELS_PER_LABEL + voxelCountsForLabels[k]);
+      }
+    }
+  }
+
+  omp_set_num_threads(originalThreadCount);
+
+  // The sampled voxels should not depend on the number of threads.
+  for(size_t t = 1; t < sizeof(threadCounts) / sizeof(int); ++t)
+  {
+    BOOST_CHECK(sampledVoxelLocations[t] == sampledVoxelLocations[0]);
+  }
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
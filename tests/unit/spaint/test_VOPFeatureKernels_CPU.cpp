@@ -0,0 +1,174 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+
+#include <spaint/features/cpu/VOPFeatureKernels_CPU.h>
+#include <spaint/features/shared/VOPFeatureCalculator_Shared.h>
+using namespace spaint;
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Gets the instruction sets supported by the CPU on which the tests are running.
+ */
+std::vector<VOPFeatureKernels_CPU::InstructionSet> supported_instruction_sets()
+{
+  std::vector<VOPFeatureKernels_CPU::InstructionSet> result;
+  result.push_back(VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR);
+  if(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::INSTRUCTIONSET_SSE2)) result.push_back(VOPFeatureKernels_CPU::INSTRUCTIONSET_SSE2);
+  if(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::INSTRUCTIONSET_AVX2)) result.push_back(VOPFeatureKernels_CPU::INSTRUCTIONSET_AVX2);
+  return result;
+}
+
+/**
+ * \brief Computes the sum of the CIELab a and b values of an RGB colour before they are normalised (in double precision).
+ *
+ * The normalised a and b values are badly conditioned when this is close to zero, so they are only compared when it is not.
+ */
+double unnormalised_a_plus_b(double r, double g, double b)
+{
+  const double x = (0.412453 * r + 0.357580 * g + 0.180423 * b) / 0.950456;
+  const double y = 0.212671 * r + 0.715160 * g + 0.072169 * b;
+  const double z = (0.019334 * r + 0.119193 * g + 0.950227 * b) / 1.088754;
+  const double fx = x > 0.008856 ? pow(x, 1.0 / 3.0) : 7.787 * x + 16.0 / 116.0;
+  const double fy = y > 0.008856 ? pow(y, 1.0 / 3.0) : 7.787 * y + 16.0 / 116.0;
+  const double fz = z > 0.008856 ? pow(z, 1.0 / 3.0) : 7.787 * z + 16.0 / 116.0;
+  return 500.0 * (fx - fy) + 200.0 * (fy - fz);
+}
+
+/**
+ * \brief Checks that the histogram computed by the specified kernels for a patch matches the one computed by the scalar kernels.
+ *
+ * Note that the reference histogram is deliberately computed by the scalar kernels rather than by calling compute_histogram_for_patch
+ * directly: the bin into which compute_oriented_gradient puts a gradient that lies exactly on a bin boundary depends on whether
+ * the float or double overload of atan2 is visible where it is compiled, and this could otherwise differ between the test and the
+ * kernels.
+ */
+void check_histogram(const VOPFeatureKernels_CPU& kernels, const std::vector<float>& intensityPatch, int patchSize, int binCount)
+{
+  std::vector<float> expectedHistogram(binCount);
+  VOPFeatureKernels_CPU(VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR).compute_histogram(&intensityPatch[0], patchSize, binCount, &expectedHistogram[0]);
+
+  // Fill the histogram with junk first, to check that the kernels clear it.
+  std::vector<float> histogram(binCount, 123.0f);
+  kernels.compute_histogram(&intensityPatch[0], patchSize, binCount, &histogram[0]);
+
+  float total = 0.0f;
+  for(int i = 0; i < binCount; ++i) total += expectedHistogram[i];
+  for(int i = 0; i < binCount; ++i)
+  {
+    BOOST_CHECK_SMALL(histogram[i] - expectedHistogram[i], 1e-5f * (total + 1.0f));
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_VOPFeatureKernels_CPU)
+
+BOOST_AUTO_TEST_CASE(detection_test)
+{
+  BOOST_CHECK(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR));
+  BOOST_CHECK(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::get_best_instruction_set()));
+
+  // The vectorised kernels are not bit-exact, so they must be opt-in: the scalar kernels should be used by default.
+  BOOST_CHECK_EQUAL(VOPFeatureKernels_CPU().get_instruction_set(), VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR);
+
+  // AVX2 implies SSE2, so if AVX2 is supported, so must SSE2 be.
+  if(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::INSTRUCTIONSET_AVX2))
+  {
+    BOOST_CHECK(VOPFeatureKernels_CPU::is_supported(VOPFeatureKernels_CPU::INSTRUCTIONSET_SSE2));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(lab_parity_test)
+{
+  boost::mt19937 gen(12345);
+  boost::uniform_real<float> colourDist(0.0f, 255.0f);
+  boost::uniform_int<int> intColourDist(0, 255);
+
+  const std::vector<VOPFeatureKernels_CPU::InstructionSet> instructionSets = supported_instruction_sets();
+  for(size_t i = 0, size = instructionSets.size(); i < size; ++i)
+  {
+    VOPFeatureKernels_CPU kernels(instructionSets[i]);
+
+    // Use patch sizes that do and do not divide evenly into vectors, and both fractional and integer colours (including greys and black).
+    for(int patchSize = 1; patchSize <= 21; patchSize += 2)
+    {
+      const int pixelCount = patchSize * patchSize;
+      std::vector<float> rgbPatch(pixelCount * 3);
+      for(int j = 0; j < pixelCount * 3; ++j)
+      {
+        rgbPatch[j] = j % 2 == 0 ? colourDist(gen) : static_cast<float>(intColourDist(gen));
+      }
+      for(int j = 0; j < pixelCount && j < 3; ++j)
+      {
+        const float grey = static_cast<float>(j * 100);
+        rgbPatch[j*3] = rgbPatch[j*3+1] = rgbPatch[j*3+2] = grey;
+      }
+
+      std::vector<float> labPatch = rgbPatch;
+      kernels.convert_patch_to_lab(&labPatch[0], pixelCount);
+
+      for(int j = 0; j < pixelCount; ++j)
+      {
+        const float r = rgbPatch[j*3], g = rgbPatch[j*3+1], b = rgbPatch[j*3+2];
+        const Vector3f expectedLab = convert_rgb_to_lab(Vector3f(r / 255.0f, g / 255.0f, b / 255.0f));
+        BOOST_CHECK_SMALL(labPatch[j*3] - expectedLab.x, 1e-3f);
+
+        // The errors in the normalised a and b values grow as the sum by which they are divided shrinks, so scale the tolerance accordingly.
+        const double aPlusB = fabs(unnormalised_a_plus_b(r / 255.0, g / 255.0, b / 255.0));
+        if(aPlusB > 0.1)
+        {
+          BOOST_CHECK_SMALL(labPatch[j*3+1] - expectedLab.y, static_cast<float>(1e-3 * (1 + fabs(expectedLab.y)) / std::min(aPlusB, 1.0)));
+          BOOST_CHECK_SMALL(labPatch[j*3+2] - expectedLab.z, static_cast<float>(1e-3 * (1 + fabs(expectedLab.z)) / std::min(aPlusB, 1.0)));
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(histogram_parity_test)
+{
+  boost::mt19937 gen(12345);
+  boost::uniform_real<float> intensityDist(0.0f, 255.0f);
+  boost::uniform_int<int> intIntensityDist(0, 3);
+
+  const std::vector<VOPFeatureKernels_CPU::InstructionSet> instructionSets = supported_instruction_sets();
+  for(size_t i = 0, size = instructionSets.size(); i < size; ++i)
+  {
+    VOPFeatureKernels_CPU kernels(instructionSets[i]);
+    for(int patchSize = 3; patchSize <= 21; patchSize += 2)
+    {
+      const int patchArea = patchSize * patchSize;
+      for(int trial = 0; trial < 20; ++trial)
+      {
+        // Check a patch with random intensities.
+        std::vector<float> intensityPatch(patchArea);
+        for(int j = 0; j < patchArea; ++j) intensityPatch[j] = intensityDist(gen);
+        check_histogram(kernels, intensityPatch, patchSize, 36);
+        check_histogram(kernels, intensityPatch, patchSize, 8);
+
+        // Check that the scalar kernels match the per-pixel kernel (for random intensities, no gradient will lie on a bin boundary).
+        std::vector<float> sharedHistogram(36, 0.0f), scalarHistogram(36);
+        for(int tid = 0; tid < patchArea; ++tid) compute_histogram_for_patch(tid, patchSize, &intensityPatch[0], 36, &sharedHistogram[0]);
+        VOPFeatureKernels_CPU(VOPFeatureKernels_CPU::INSTRUCTIONSET_SCALAR).compute_histogram(&intensityPatch[0], patchSize, 36, &scalarHistogram[0]);
+        for(int j = 0; j < 36; ++j) BOOST_CHECK_CLOSE(scalarHistogram[j], sharedHistogram[j], 1e-3f);
+
+        // Check a patch with a few distinct integer intensities, whose gradients are often horizontal, vertical, diagonal or zero,
+        // and thus lie exactly on the boundaries between bins.
+        for(int j = 0; j < patchArea; ++j) intensityPatch[j] = static_cast<float>(intIntensityDist(gen));
+        check_histogram(kernels, intensityPatch, patchSize, 36);
+        check_histogram(kernels, intensityPatch, patchSize, 8);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
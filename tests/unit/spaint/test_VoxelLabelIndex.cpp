@@ -0,0 +1,320 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h>
+#include <ITMLib/Engine/DeviceSpecific/CPU/ITMSceneReconstructionEngine_CPU.h>
+
+#include <spaint/markers/VoxelLabelIndex.h>
+#include <spaint/markers/cpu/VoxelMarker_CPU.h>
+#include <spaint/markers/shared/VoxelMarker_Shared.h>
+using namespace spaint;
+
+#include <tvgutil/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+//#################### TYPEDEFS ####################
+
+typedef ITMLib::Objects::ITMScene<SpaintVoxel,ITMVoxelIndex> Scene;
+typedef boost::shared_ptr<Scene> Scene_Ptr;
+
+//#################### CONSTANTS ####################
+
+/** The number of voxel blocks to allocate in the test scene. */
+const int BLOCK_COUNT = 64;
+
+/** The number of voxels to label in each round of marking. */
+const int LABELLED_VOXEL_COUNT = 2000;
+
+/** The largest label with which voxels are marked. */
+const int MAX_LABEL = 7;
+
+/** The number of overlapping rounds of marking to perform. */
+const int ROUND_COUNT = 4;
+
+//#################### HELPER TYPES ####################
+
+/**
+ * \brief A scene into which voxel blocks have been allocated directly, together with the locations and addresses of its voxels.
+ */
+struct TestScene
+{
+  /** The scene (this must not use swapping, since the label index only supports scenes without swapping). */
+  Scene_Ptr scene;
+
+  /** The settings used for the scene. */
+  ITMLibSettings settings;
+
+  /** The addresses of the allocated voxels in the voxel block array (parallel to voxelLocations). */
+  std::vector<int> voxelAddresses;
+
+  /** The locations of the allocated voxels in the scene. */
+  std::vector<Vector3s> voxelLocations;
+};
+
+//#################### HELPER FUNCTIONS ####################
+
+/**
+ * \brief Determines whether or not one voxel location precedes another in lexicographical order.
+ *
+ * \param lhs The first voxel location.
+ * \param rhs The second voxel location.
+ * \return    true, if the first voxel location precedes the second, or false otherwise.
+ */
+bool location_less(const Vector3s& lhs, const Vector3s& rhs)
+{
+  if(lhs.x != rhs.x) return lhs.x < rhs.x;
+  if(lhs.y != rhs.y) return lhs.y < rhs.y;
+  return lhs.z < rhs.z;
+}
+
+/**
+ * \brief Checks that the index contains exactly the voxels in the scene that currently have each label (found by brute force).
+ *
+ * \param labelIndex  The index.
+ * \param testScene   The scene.
+ */
+void check_index(VoxelLabelIndex& labelIndex, const TestScene& testScene)
+{
+  std::vector<std::vector<Vector3s> > expectedLocations(VoxelLabelIndex::LABEL_COUNT);
+  const SpaintVoxel *voxelData = testScene.scene->localVBA.GetVoxelBlocks();
+  for(size_t i = 0, size = testScene.voxelLocations.size(); i < size; ++i)
+  {
+    const SpaintVoxel::PackedLabel& packedLabel = voxelData[testScene.voxelAddresses[i]].packedLabel;
+    if(!(packedLabel == SpaintVoxel::PackedLabel())) expectedLocations[packedLabel.label].push_back(testScene.voxelLocations[i]);
+  }
+
+  // Since all of the voxels are in the local voxel block array, the compacted list for each label must not contain any other entries.
+  for(int label = 0; label < VoxelLabelIndex::LABEL_COUNT; ++label)
+  {
+    std::vector<Vector3s> actualLocations = labelIndex.get_voxels(static_cast<SpaintVoxel::Label>(label), testScene.scene.get());
+    std::sort(actualLocations.begin(), actualLocations.end(), location_less);
+    std::sort(expectedLocations[label].begin(), expectedLocations[label].end(), location_less);
+    BOOST_CHECK_MESSAGE(actualLocations == expectedLocations[label], "The label index is inconsistent with the scene for label " << label);
+  }
+}
+
+/**
+ * \brief Checks that the labels of the allocated voxels in the scene match the expected ones.
+ *
+ * \param testScene       The scene.
+ * \param expectedLabels  The expected labels (parallel to testScene.voxelLocations).
+ * \param description     A description of the operation that produced the labels.
+ */
+void check_labels(const TestScene& testScene, const std::vector<SpaintVoxel::PackedLabel>& expectedLabels, const std::string& description)
+{
+  const SpaintVoxel *voxelData = testScene.scene->localVBA.GetVoxelBlocks();
+  size_t mismatchCount = 0;
+  for(size_t i = 0, size = testScene.voxelLocations.size(); i < size; ++i)
+  {
+    if(!(voxelData[testScene.voxelAddresses[i]].packedLabel == expectedLabels[i])) ++mismatchCount;
+  }
+  BOOST_CHECK_MESSAGE(mismatchCount == 0, mismatchCount << " voxels have unexpected labels after " << description);
+}
+
+/**
+ * \brief Gets the current labels of the allocated voxels in the scene.
+ *
+ * \param testScene The scene.
+ * \return          The current labels of the allocated voxels (parallel to testScene.voxelLocations).
+ */
+std::vector<SpaintVoxel::PackedLabel> get_labels(const TestScene& testScene)
+{
+  std::vector<SpaintVoxel::PackedLabel> labels(testScene.voxelLocations.size());
+  const SpaintVoxel *voxelData = testScene.scene->localVBA.GetVoxelBlocks();
+  for(size_t i = 0, size = testScene.voxelLocations.size(); i < size; ++i)
+  {
+    labels[i] = voxelData[testScene.voxelAddresses[i]].packedLabel;
+  }
+  return labels;
+}
+
+/**
+ * \brief Labels a random subset of a contiguous run of the allocated voxels in the scene, as a user might when painting over an area.
+ *
+ * Since the voxels are picked with replacement from a run that is only twice as long as the number of voxels labelled, repeated
+ * rounds of marking overlap substantially, so the index ends up containing both duplicate entries and entries for voxels that
+ * have since been relabelled.
+ *
+ * \param marker    The voxel marker to use.
+ * \param testScene The scene.
+ * \param round     The index of the round of marking (this determines the way in which the voxels are marked).
+ * \param runStart  The index of the first voxel in the run.
+ * \param rng       The random number generator to use.
+ */
+void label_random_voxels(const VoxelMarker& marker, TestScene& testScene, int round, int runStart, RandomNumberGenerator& rng)
+{
+  ORUtils::MemoryBlock<Vector3s> voxelLocationsMB(LABELLED_VOXEL_COUNT, true, false);
+  ORUtils::MemoryBlock<SpaintVoxel::PackedLabel> voxelLabelsMB(LABELLED_VOXEL_COUNT, true, false);
+  Vector3s *voxelLocations = voxelLocationsMB.GetData(MEMORYDEVICE_CPU);
+  SpaintVoxel::PackedLabel *voxelLabels = voxelLabelsMB.GetData(MEMORYDEVICE_CPU);
+
+  for(int i = 0; i < LABELLED_VOXEL_COUNT; ++i)
+  {
+    voxelLocations[i] = testScene.voxelLocations[runStart + rng.generate_int_from_uniform(0, 2 * LABELLED_VOXEL_COUNT - 1)];
+    voxelLabels[i] = SpaintVoxel::PackedLabel(
+      static_cast<SpaintVoxel::Label>(rng.generate_int_from_uniform(0, MAX_LABEL)),
+      static_cast<SpaintVoxel::LabelGroup>(rng.generate_int_from_uniform(SpaintVoxel::LG_FOREST, SpaintVoxel::LG_USER))
+    );
+  }
+
+  // Alternate between marking the voxels with a single label and with per-voxel labels, and force the marking in the last round
+  // (as happens when a marking operation is undone) so that labels in the user group can also be overwritten by other labels.
+  const MarkingMode mode = round == ROUND_COUNT - 1 ? FORCED_MARKING : NORMAL_MARKING;
+  if(round % 2 == 0) marker.mark_voxels(voxelLocationsMB, voxelLabels[0], testScene.scene.get(), NULL, mode);
+  else marker.mark_voxels(voxelLocationsMB, voxelLabelsMB, testScene.scene.get(), NULL, mode);
+}
+
+/**
+ * \brief Makes a scene containing voxel blocks allocated at random positions around the origin.
+ *
+ * \param rng The random number generator to use.
+ * \return    The scene.
+ */
+boost::shared_ptr<TestScene> make_test_scene(RandomNumberGenerator& rng)
+{
+  boost::shared_ptr<TestScene> testScene(new TestScene);
+  testScene->scene.reset(new Scene(&testScene->settings.sceneParams, false, MEMORYDEVICE_CPU));
+
+  ITMSceneReconstructionEngine_CPU<SpaintVoxel,ITMVoxelIndex> sceneReconstructionEngine;
+  sceneReconstructionEngine.ResetScene(testScene->scene.get());
+
+  ITMHashEntry *hashTable = testScene->scene->index.GetEntries();
+  int *allocationList = testScene->scene->localVBA.GetAllocationList();
+
+  // For simplicity, we only use positions whose entries in the ordered part of the hash table are free.
+  const int range = 16;
+  for(int i = 0; i < BLOCK_COUNT;)
+  {
+    Vector3s blockPos(
+      static_cast<short>(rng.generate_int_from_uniform(-range, range - 1)),
+      static_cast<short>(rng.generate_int_from_uniform(-range, range - 1)),
+      static_cast<short>(rng.generate_int_from_uniform(-range, range - 1))
+    );
+
+    ITMHashEntry& hashEntry = hashTable[hashIndex(blockPos)];
+    if(hashEntry.ptr >= -1) continue;
+
+    hashEntry.pos = blockPos;
+    hashEntry.offset = 0;
+    hashEntry.ptr = allocationList[testScene->scene->localVBA.lastFreeBlockId--];
+
+    for(int linearIdx = 0; linearIdx < SDF_BLOCK_SIZE3; ++linearIdx)
+    {
+      const int x = linearIdx % SDF_BLOCK_SIZE;
+      const int y = (linearIdx / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE;
+      const int z = linearIdx / (SDF_BLOCK_SIZE * SDF_BLOCK_SIZE);
+      testScene->voxelLocations.push_back(Vector3s(
+        static_cast<short>(blockPos.x * SDF_BLOCK_SIZE + x),
+        static_cast<short>(blockPos.y * SDF_BLOCK_SIZE + y),
+        static_cast<short>(blockPos.z * SDF_BLOCK_SIZE + z)
+      ));
+      testScene->voxelAddresses.push_back(hashEntry.ptr * SDF_BLOCK_SIZE3 + linearIdx);
+    }
+
+    ++i;
+  }
+
+  return testScene;
+}
+
+/**
+ * \brief Directly sets the labels of the allocated voxels in the scene.
+ *
+ * \param testScene The scene.
+ * \param labels    The labels to set (parallel to testScene.voxelLocations).
+ */
+void set_labels(TestScene& testScene, const std::vector<SpaintVoxel::PackedLabel>& labels)
+{
+  SpaintVoxel *voxelData = testScene.scene->localVBA.GetVoxelBlocks();
+  for(size_t i = 0, size = testScene.voxelLocations.size(); i < size; ++i)
+  {
+    voxelData[testScene.voxelAddresses[i]].packedLabel = labels[i];
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_VoxelLabelIndex)
+
+BOOST_AUTO_TEST_CASE(clearing_test)
+{
+  RandomNumberGenerator rng(12345);
+  boost::shared_ptr<TestScene> testScene = make_test_scene(rng);
+  VoxelLabelIndex_Ptr labelIndex(new VoxelLabelIndex);
+  VoxelMarker_CPU indexedMarker(labelIndex), sweepingMarker;
+
+  std::vector<std::pair<std::string,ClearingSettings> > clearingModes;
+  clearingModes.push_back(std::make_pair("CLEAR_ALL", ClearingSettings(CLEAR_ALL, 0, 0)));
+  clearingModes.push_back(std::make_pair("CLEAR_EQ_LABEL", ClearingSettings(CLEAR_EQ_LABEL, 0, 1)));
+  clearingModes.push_back(std::make_pair("CLEAR_EQ_LABEL_NEQ_GROUP", ClearingSettings(CLEAR_EQ_LABEL_NEQ_GROUP, SpaintVoxel::LG_USER, 1)));
+  clearingModes.push_back(std::make_pair("CLEAR_NEQ_GROUP", ClearingSettings(CLEAR_NEQ_GROUP, SpaintVoxel::LG_USER, 0)));
+
+  const std::vector<SpaintVoxel::PackedLabel> defaultLabels(testScene->voxelLocations.size());
+  for(size_t i = 0, size = clearingModes.size(); i < size; ++i)
+  {
+    const std::string& modeName = clearingModes[i].first;
+    const ClearingSettings& settings = clearingModes[i].second;
+
+    // Label some of the voxels in a scene that starts without any labelled voxels.
+    set_labels(*testScene, defaultLabels);
+    labelIndex->rebuild(testScene->scene.get());
+    const int runStart = rng.generate_int_from_uniform(0, static_cast<int>(testScene->voxelLocations.size()) - 2 * LABELLED_VOXEL_COUNT);
+    for(int round = 0; round < ROUND_COUNT; ++round)
+    {
+      label_random_voxels(indexedMarker, *testScene, round, runStart, rng);
+    }
+
+    // Determine the labels that the voxels should have after they have been cleared.
+    const std::vector<SpaintVoxel::PackedLabel> labelsBeforeClearing = get_labels(*testScene);
+    std::vector<SpaintVoxel::PackedLabel> expectedLabels = labelsBeforeClearing;
+    for(size_t j = 0, voxelCount = expectedLabels.size(); j < voxelCount; ++j)
+    {
+      SpaintVoxel voxel;
+      voxel.packedLabel = expectedLabels[j];
+      clear_label(voxel, settings);
+      expectedLabels[j] = voxel.packedLabel;
+    }
+
+    // Clear the labels using the index, and check both the result and the index.
+    indexedMarker.clear_labels(testScene->scene.get(), settings);
+    check_labels(*testScene, expectedLabels, "clearing labels using the index in mode " + modeName);
+    check_index(*labelIndex, *testScene);
+
+    // Restore the labels, rebuild the index from scratch and check it.
+    set_labels(*testScene, labelsBeforeClearing);
+    labelIndex->rebuild(testScene->scene.get());
+    check_index(*labelIndex, *testScene);
+
+    // Clear the labels by sweeping the whole voxel block array, and check that the result is the same.
+    sweepingMarker.clear_labels(testScene->scene.get(), settings);
+    check_labels(*testScene, expectedLabels, "clearing labels by sweeping in mode " + modeName);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(marking_test)
+{
+  RandomNumberGenerator rng(12345);
+  boost::shared_ptr<TestScene> testScene = make_test_scene(rng);
+  VoxelLabelIndex_Ptr labelIndex(new VoxelLabelIndex);
+  VoxelMarker_CPU marker(labelIndex);
+
+  labelIndex->rebuild(testScene->scene.get());
+  check_index(*labelIndex, *testScene);
+
+  // Check that the index keeps track of the labelled voxels correctly as overlapping rounds of marking are performed.
+  const int runStart = rng.generate_int_from_uniform(0, static_cast<int>(testScene->voxelLocations.size()) - 2 * LABELLED_VOXEL_COUNT);
+  for(int round = 0; round < ROUND_COUNT; ++round)
+  {
+    label_random_voxels(marker, *testScene, round, runStart, rng);
+    check_index(*labelIndex, *testScene);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
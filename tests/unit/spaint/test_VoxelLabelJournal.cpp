@@ -0,0 +1,107 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <climits>
+#include <stdexcept>
+
+#include <spaint/markers/VoxelLabelJournal.h>
+using namespace spaint;
+
+//#################### HELPER FUNCTIONS ####################
+
+void check_round_trip(const std::vector<Vector3s>& voxelLocations, const std::vector<SpaintVoxel::PackedLabel>& oldLabels)
+{
+  VoxelLabelJournal journal(voxelLocations, oldLabels);
+  BOOST_CHECK_EQUAL(journal.get_voxel_count(), voxelLocations.size());
+
+  std::vector<Vector3s> decodedLocations;
+  std::vector<SpaintVoxel::PackedLabel> decodedLabels;
+  journal.decode(decodedLocations, decodedLabels);
+
+  BOOST_REQUIRE_EQUAL(decodedLocations.size(), voxelLocations.size());
+  BOOST_REQUIRE_EQUAL(decodedLabels.size(), oldLabels.size());
+  for(size_t i = 0, size = voxelLocations.size(); i < size; ++i)
+  {
+    BOOST_CHECK(decodedLocations[i] == voxelLocations[i]);
+    BOOST_CHECK(decodedLabels[i] == oldLabels[i]);
+  }
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_VoxelLabelJournal)
+
+BOOST_AUTO_TEST_CASE(cube_test)
+{
+  // Make the selection of a cubic brush of radius 5 (in the order in which the voxel-to-cube selection transformer would emit it),
+  // and give the voxels in its lower half one old label and the voxels in its upper half another.
+  const int radius = 5;
+  std::vector<Vector3s> voxelLocations;
+  std::vector<SpaintVoxel::PackedLabel> oldLabels;
+  for(int z = -radius; z <= radius; ++z)
+    for(int y = -radius; y <= radius; ++y)
+      for(int x = -radius; x <= radius; ++x)
+      {
+        voxelLocations.push_back(Vector3s(static_cast<short>(100 + x), static_cast<short>(-200 + y), static_cast<short>(300 + z)));
+        oldLabels.push_back(z < 0 ? SpaintVoxel::PackedLabel(0, SpaintVoxel::LG_USER) : SpaintVoxel::PackedLabel(3, SpaintVoxel::LG_FOREST));
+      }
+
+  check_round_trip(voxelLocations, oldLabels);
+
+  // Check that the journal is much smaller than the raw locations and labels would be.
+  VoxelLabelJournal journal(voxelLocations, oldLabels);
+  const size_t rawSize = voxelLocations.size() * (sizeof(Vector3s) + sizeof(SpaintVoxel::PackedLabel));
+  BOOST_CHECK_LT(journal.get_memory_usage() * 10, rawSize);
+}
+
+BOOST_AUTO_TEST_CASE(empty_test)
+{
+  VoxelLabelJournal journal;
+  BOOST_CHECK_EQUAL(journal.get_voxel_count(), 0);
+
+  std::vector<Vector3s> voxelLocations(1, Vector3s(1, 2, 3));
+  std::vector<SpaintVoxel::PackedLabel> oldLabels(1);
+  journal.decode(voxelLocations, oldLabels);
+  BOOST_CHECK(voxelLocations.empty());
+  BOOST_CHECK(oldLabels.empty());
+
+  check_round_trip(std::vector<Vector3s>(), std::vector<SpaintVoxel::PackedLabel>());
+}
+
+BOOST_AUTO_TEST_CASE(mismatch_test)
+{
+  std::vector<Vector3s> voxelLocations(3, Vector3s(0, 0, 0));
+  std::vector<SpaintVoxel::PackedLabel> oldLabels(2);
+  BOOST_CHECK_THROW(VoxelLabelJournal(voxelLocations, oldLabels), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(scattered_test)
+{
+  // Make a selection containing isolated voxels, short runs, large jumps and the extremes of the coordinate range,
+  // and give the voxels a mixture of old labels from all of the label groups.
+  std::vector<Vector3s> voxelLocations;
+  std::vector<SpaintVoxel::PackedLabel> oldLabels;
+  unsigned int state = 12345;
+  for(int i = 0; i < 5000; ++i)
+  {
+    state = state * 1103515245 + 12345;
+    const int runLength = 1 + (state >> 16) % 4;
+    const short x = static_cast<short>(state >> 8), y = static_cast<short>(state >> 4), z = static_cast<short>(i - 2500);
+    for(int j = 0; j < runLength; ++j)
+    {
+      voxelLocations.push_back(Vector3s(static_cast<short>(x + j), y, z));
+      oldLabels.push_back(SpaintVoxel::PackedLabel((state >> 20) % 64, static_cast<SpaintVoxel::LabelGroup>((state >> 28) % 3)));
+    }
+  }
+
+  voxelLocations.push_back(Vector3s(SHRT_MAX, SHRT_MIN, SHRT_MAX));
+  voxelLocations.push_back(Vector3s(SHRT_MIN, SHRT_MAX, SHRT_MIN));
+  voxelLocations.push_back(Vector3s(SHRT_MIN, SHRT_MAX, SHRT_MIN));
+  oldLabels.push_back(SpaintVoxel::PackedLabel(63, SpaintVoxel::LG_PROPAGATED));
+  oldLabels.push_back(SpaintVoxel::PackedLabel(0, SpaintVoxel::LG_USER));
+  oldLabels.push_back(SpaintVoxel::PackedLabel(0, SpaintVoxel::LG_USER));
+
+  check_round_trip(voxelLocations, oldLabels);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,67 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+
+#include <tvgutil/BoundedQueue.h>
+using namespace tvgutil;
+
+/**
+ * \brief Pushes the integers [0,count) onto a queue and then closes it.
+ *
+ * \param queue The queue.
+ * \param count The number of integers to push.
+ */
+void push_ints(BoundedQueue<int>& queue, int count)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    if(!queue.push(i)) return;
+  }
+  queue.close();
+}
+
+BOOST_AUTO_TEST_SUITE(test_BoundedQueue)
+
+BOOST_AUTO_TEST_CASE(close_test)
+{
+  BoundedQueue<int> queue(2);
+  BOOST_CHECK(queue.push(23));
+  queue.close();
+  BOOST_CHECK(queue.is_closed());
+
+  // Pushing onto a closed queue should fail, but elements that were already in the queue should still be poppable.
+  BOOST_CHECK(!queue.push(24));
+
+  int element = 0;
+  BOOST_CHECK(queue.pop(element));
+  BOOST_CHECK_EQUAL(element, 23);
+  BOOST_CHECK(!queue.pop(element));
+}
+
+BOOST_AUTO_TEST_CASE(constructor_test)
+{
+  BOOST_CHECK_THROW(BoundedQueue<int>(0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(producer_consumer_test)
+{
+  // Push many more elements than the capacity of the queue from another thread, so that the producer has to block.
+  const int count = 10000;
+  BoundedQueue<int> queue(2);
+  boost::thread producer(boost::bind(&push_ints, boost::ref(queue), count));
+
+  // Check that the consumer receives every element exactly once, in the order in which they were pushed, and that the queue never overfills.
+  int element = -1, expected = 0;
+  while(queue.pop(element))
+  {
+    BOOST_REQUIRE_EQUAL(element, expected);
+    BOOST_REQUIRE(queue.size() <= queue.capacity());
+    ++expected;
+  }
+
+  producer.join();
+  BOOST_CHECK_EQUAL(expected, count);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
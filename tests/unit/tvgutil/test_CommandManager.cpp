@@ -30,6 +30,47 @@ struct TestCommand : Command
   }
 };
 
+struct SizedTestCommand : TestCommand
+{
+  size_t m_memoryUsage;
+
+  SizedTestCommand(std::string& output, const std::string& executeText, const std::string& undoText, const std::string& description, size_t memoryUsage)
+  : TestCommand(output, executeText, undoText, description), m_memoryUsage(memoryUsage)
+  {}
+
+  virtual size_t get_memory_usage() const
+  {
+    return m_memoryUsage;
+  }
+};
+
+struct StatefulTestCommand : TestCommand
+{
+  mutable bool m_executed;
+
+  StatefulTestCommand(std::string& output, const std::string& executeText, const std::string& undoText, const std::string& description)
+  : TestCommand(output, executeText, undoText, description), m_executed(false)
+  {}
+
+  virtual void execute() const
+  {
+    TestCommand::execute();
+    m_executed = true;
+  }
+
+  virtual size_t get_memory_usage() const
+  {
+    // Like a command that records the state it overwrites, this uses more memory once it has been executed than after it has been undone.
+    return m_executed ? 100 : 10;
+  }
+
+  virtual void undo() const
+  {
+    TestCommand::undo();
+    m_executed = false;
+  }
+};
+
 BOOST_AUTO_TEST_SUITE(test_CommandManager)
 
 BOOST_AUTO_TEST_CASE(basic_test)
@@ -196,6 +237,103 @@ BOOST_AUTO_TEST_CASE(historysize_test)
     BOOST_CHECK_EQUAL(cm2.undone_count(), 2);
 }
 
+BOOST_AUTO_TEST_CASE(memorybudget_test)
+{
+  std::string output;
+
+  Command_CPtr c1(new SizedTestCommand(output, "E1", "U1", "", 40));
+  Command_CPtr c2(new SizedTestCommand(output, "E2", "U2", "", 50));
+  Command_CPtr c3(new SizedTestCommand(output, "E3", "U3", "", 30));
+  Command_CPtr big(new SizedTestCommand(output, "Eb", "Ub", "", 200));
+  Command_CPtr noop(new TestCommand(output, "En", "Un", ""));
+
+  CommandManager cm(INT_MAX, 100);
+  cm.execute_command(c1);
+  cm.execute_command(c2);
+    BOOST_CHECK_EQUAL(cm.executed_count(), 2);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 90);
+
+  // Executing a command that takes the history over budget should discard the oldest command(s).
+  cm.execute_command(c3);
+    BOOST_CHECK_EQUAL(output, "E1E2E3");
+    BOOST_CHECK_EQUAL(cm.executed_count(), 2);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 80);
+
+  // Commands that use no memory should never cause other commands to be discarded.
+  cm.execute_command(noop);
+    BOOST_CHECK_EQUAL(cm.executed_count(), 3);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 80);
+
+  // Undone commands still count towards the memory usage until they are discarded by the execution of a new command.
+  cm.undo();
+  cm.undo();
+    BOOST_CHECK_EQUAL(output, "E1E2E3EnUnU3");
+    BOOST_CHECK_EQUAL(cm.undone_count(), 2);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 80);
+
+  // The most recently executed command should be kept even if it exceeds the budget on its own.
+  cm.execute_command(big);
+    BOOST_CHECK_EQUAL(cm.executed_count(), 1);
+    BOOST_CHECK_EQUAL(cm.undone_count(), 0);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 200);
+  cm.undo();
+    BOOST_CHECK_EQUAL(output, "E1E2E3EnUnU3EbUb");
+    BOOST_CHECK_EQUAL(cm.can_undo(), false);
+
+  // The memory used by a compressed command should be that of all of the commands from which it was built.
+  std::map<std::string,std::string> precursors = map_list_of("Sized","Sized");
+  Command_CPtr s1(new SizedTestCommand(output, "", "", "Sized", 30));
+  Command_CPtr s2(new SizedTestCommand(output, "", "", "Sized", 30));
+  CommandManager cm2(INT_MAX, 100);
+  cm2.execute_command(s1);
+  cm2.execute_compressible_command(s2, precursors);
+  cm2.execute_compressible_command(s2, precursors);
+    BOOST_CHECK_EQUAL(cm2.executed_count(), 1);
+    BOOST_CHECK_EQUAL(cm2.memory_usage(), 90);
+}
+
+BOOST_AUTO_TEST_CASE(memoryusage_test)
+{
+  std::string output;
+
+  Command_CPtr c1(new StatefulTestCommand(output, "E1", "U1", "Stateful"));
+  Command_CPtr c2(new StatefulTestCommand(output, "E2", "U2", "Stateful"));
+  Command_CPtr c3(new SizedTestCommand(output, "E3", "U3", "", 30));
+  std::map<std::string,std::string> precursors = map_list_of("Stateful","Stateful");
+
+  // The memory usage should track the memory used by each command as it is executed, undone and redone.
+  CommandManager cm;
+  cm.execute_command(c1);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 100);
+  cm.execute_command(c3);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 130);
+  cm.undo();
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 130);
+  cm.undo();
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 40);
+  cm.redo();
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 130);
+
+  // Executing a new command should discard the memory used by the undone commands.
+  cm.execute_compressible_command(c2, precursors);
+    BOOST_CHECK_EQUAL(cm.executed_count(), 1);
+    BOOST_CHECK_EQUAL(cm.undone_count(), 0);
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 200);
+  cm.undo();
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 20);
+
+  cm.reset();
+    BOOST_CHECK_EQUAL(cm.memory_usage(), 0);
+
+  // Discarding commands to limit the size of the history should also discard the memory they use.
+  CommandManager cm2(2);
+  cm2.execute_command(c3);
+  cm2.execute_command(c1);
+  cm2.execute_command(c2);
+    BOOST_CHECK_EQUAL(cm2.executed_count(), 2);
+    BOOST_CHECK_EQUAL(cm2.memory_usage(), 200);
+}
+
 BOOST_AUTO_TEST_CASE(seq_test)
 {
   std::string output;
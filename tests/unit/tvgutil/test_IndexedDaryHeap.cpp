@@ -0,0 +1,225 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <tvgutil/IndexedDaryHeap.h>
+#include <tvgutil/PriorityQueue.h>
+#include <tvgutil/RandomNumberGenerator.h>
+using namespace tvgutil;
+
+typedef PriorityQueue<int, int, int, std::greater<int> > IntPQ;
+
+//#################### HELPERS ####################
+
+/**
+ * \brief Checks that an indexed d-ary heap is in the same state as a priority queue containing the same elements.
+ *
+ * Since all keys are distinct in the tests that use this, the fronts of the two queues should be the same element.
+ *
+ * \param pq    The priority queue.
+ * \param heap  The heap.
+ * \param maxID The maximum ID that can be in the queues.
+ */
+template <typename Heap>
+void check_same_state(IntPQ& pq, Heap& heap, int maxID)
+{
+  BOOST_REQUIRE_EQUAL(heap.size(), pq.size());
+  BOOST_REQUIRE_EQUAL(heap.empty(), pq.empty());
+  if(!pq.empty())
+  {
+    BOOST_REQUIRE_EQUAL(heap.top().id(), pq.top().id());
+    BOOST_REQUIRE_EQUAL(heap.top().key(), pq.top().key());
+    BOOST_REQUIRE_EQUAL(heap.element(heap.top().id()).data(), pq.top().data());
+  }
+
+  for(int id = -1; id <= maxID + 1; ++id)
+  {
+    BOOST_REQUIRE_EQUAL(heap.contains(id), pq.contains(id));
+  }
+}
+
+/**
+ * \brief Performs a random sequence of operations on both an indexed d-ary heap and a priority queue, and checks that they behave identically.
+ *
+ * \param seed  The seed for the random number generator.
+ */
+template <typename Heap>
+void run_differential_test(unsigned int seed)
+{
+  const int maxID = 299;
+  const int operationCount = 5000;
+
+  RandomNumberGenerator rng(seed);
+  IntPQ pq;
+  Heap heap;
+
+  // Each key is made distinct by combining a random value with a counter, so that the order of the elements is fully determined.
+  int keyCounter = 0;
+
+  for(int i = 0; i < operationCount; ++i)
+  {
+    int operation = rng.generate_int_from_uniform(0, 9);
+    int id = rng.generate_int_from_uniform(0, maxID);
+    int key = rng.generate_int_from_uniform(0, 9999) * 100000 + keyCounter++;
+
+    switch(operation)
+    {
+      case 0: case 1: case 2:
+      {
+        // Insert an element (if it's not already present).
+        if(!pq.contains(id))
+        {
+          pq.insert(id, key, i);
+          heap.insert(id, key, i);
+        }
+        else BOOST_CHECK_THROW(heap.insert(id, key, i), std::runtime_error);
+        break;
+      }
+      case 3:
+      {
+        // Erase an element (if it's present).
+        if(pq.contains(id))
+        {
+          pq.erase(id);
+          heap.erase(id);
+        }
+        break;
+      }
+      case 4:
+      {
+        // Pop the front element (if any).
+        if(!pq.empty())
+        {
+          pq.pop();
+          heap.pop();
+        }
+        break;
+      }
+      case 5: case 6:
+      {
+        // Update the key of an element (if it's present).
+        if(pq.contains(id))
+        {
+          pq.update_key(id, key);
+          heap.update_key(id, key);
+        }
+        break;
+      }
+      case 7: case 8:
+      {
+        // Update the keys of a random subset of the elements in bulk (sometimes enough of them to make the heap rebuild itself).
+        const int updateDivisor = operation == 7 ? 2 : 20;
+        std::vector<int> ids;
+        std::vector<int> keys;
+        for(int j = 0; j <= maxID; ++j)
+        {
+          if(pq.contains(j) && rng.generate_int_from_uniform(0, updateDivisor - 1) == 0)
+          {
+            ids.push_back(j);
+            keys.push_back(rng.generate_int_from_uniform(0, 9999) * 100000 + keyCounter++);
+            pq.update_key(j, keys.back());
+          }
+        }
+        heap.update_keys(ids, keys);
+        break;
+      }
+      case 9:
+      {
+        // Pop several elements at once.
+        size_t k = rng.generate_int_from_uniform(0, 5);
+        std::vector<typename Heap::Element> popped = heap.pop_k(k);
+        BOOST_REQUIRE_EQUAL(popped.size(), std::min(k, pq.size()));
+        for(size_t j = 0, size = popped.size(); j < size; ++j)
+        {
+          BOOST_REQUIRE_EQUAL(popped[j].id(), pq.top().id());
+          BOOST_REQUIRE_EQUAL(popped[j].key(), pq.top().key());
+          pq.pop();
+        }
+        break;
+      }
+    }
+
+    // Keys are unique only up to the key counter's range, so stop early rather than risk duplicate keys.
+    if(keyCounter >= 99000) break;
+
+    check_same_state(pq, heap, maxID);
+  }
+
+  // Drain both queues and check that the elements come out in the same order.
+  while(!pq.empty())
+  {
+    BOOST_REQUIRE_EQUAL(heap.top().id(), pq.top().id());
+    pq.pop();
+    heap.pop();
+  }
+  BOOST_CHECK(heap.empty());
+}
+
+//#################### TESTS ####################
+
+BOOST_AUTO_TEST_SUITE(test_IndexedDaryHeap)
+
+BOOST_AUTO_TEST_CASE(differential_test)
+{
+  run_differential_test<IndexedDaryHeap<int,int,int,std::greater<int> > >(12345);
+  run_differential_test<IndexedDaryHeap<int,int,int,std::greater<int>,2> >(23456);
+  run_differential_test<IndexedDaryHeap<int,int,int,std::greater<int>,7> >(34567);
+}
+
+BOOST_AUTO_TEST_CASE(serialization_test)
+{
+  typedef IndexedDaryHeap<int,int,int,std::greater<int> > Heap;
+
+  IntPQ pq;
+  RandomNumberGenerator rng(12345);
+  for(int id = 0; id < 100; ++id)
+  {
+    pq.insert(id, rng.generate_int_from_uniform(0, 99999) * 1000 + id, id * 2);
+  }
+
+  // A heap should be able to load a priority queue saved using Boost serialization (and then save and load itself).
+  std::ostringstream pqOS;
+  {
+    boost::archive::text_oarchive ar(pqOS);
+    ar << pq;
+  }
+
+  Heap heap;
+  {
+    std::istringstream is(pqOS.str());
+    boost::archive::text_iarchive ar(is);
+    ar >> heap;
+  }
+
+  std::ostringstream heapOS;
+  {
+    boost::archive::text_oarchive ar(heapOS);
+    ar << heap;
+  }
+
+  Heap reloadedHeap;
+  {
+    std::istringstream is(heapOS.str());
+    boost::archive::text_iarchive ar(is);
+    ar >> reloadedHeap;
+  }
+
+  BOOST_REQUIRE_EQUAL(reloadedHeap.size(), pq.size());
+  while(!pq.empty())
+  {
+    BOOST_REQUIRE_EQUAL(reloadedHeap.top().id(), pq.top().id());
+    BOOST_REQUIRE_EQUAL(reloadedHeap.top().key(), pq.top().key());
+    BOOST_REQUIRE_EQUAL(reloadedHeap.element(pq.top().id()).data(), pq.top().data());
+    pq.pop();
+    reloadedHeap.pop();
+  }
+  BOOST_CHECK(reloadedHeap.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,95 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include <tvgutil/PrefixSumUtil.h>
+using namespace tvgutil;
+
+/**
+ * \brief Calculates the exclusive prefix sum of an array serially (for comparison purposes).
+ *
+ * \param input   The input array.
+ * \param output  The output array.
+ * \param length  The length of the arrays.
+ */
+void calculate_serial_prefix_sum(const unsigned char *input, unsigned int *output, int length)
+{
+  unsigned int sum = 0;
+  for(int i = 0; i < length; ++i)
+  {
+    output[i] = sum;
+    sum += input[i];
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(test_PrefixSumUtil)
+
+BOOST_AUTO_TEST_CASE(calculate_exclusive_prefix_sum_test)
+{
+  const unsigned char input[] = { 1, 0, 0, 1, 1, 0, 1, 0 };
+  const unsigned int expected[] = { 0, 1, 1, 1, 2, 3, 3, 4 };
+  const int length = sizeof(input) / sizeof(unsigned char);
+
+  unsigned int output[length];
+  PrefixSumUtil::calculate_exclusive_prefix_sum(input, output, length);
+  BOOST_CHECK_EQUAL_COLLECTIONS(output, output + length, expected, expected + length);
+}
+
+BOOST_AUTO_TEST_CASE(calculate_exclusive_prefix_sums_test)
+{
+  // Make some random masks, and mark the output for each mask with a sentinel value.
+  const int segmentLength = 10007, segmentCount = 5;
+  const unsigned int sentinel = 12345;
+  srand(23);
+
+  std::vector<unsigned char> input(segmentLength * segmentCount);
+  for(size_t i = 0, size = input.size(); i < size; ++i)
+  {
+    input[i] = rand() % 4 == 0 ? 1 : 0;
+  }
+
+  // Calculate the prefix sums of all but one of the masks, using several different numbers of threads.
+  std::vector<int> segmentIndices;
+  segmentIndices.push_back(0);
+  segmentIndices.push_back(2);
+  segmentIndices.push_back(3);
+  segmentIndices.push_back(4);
+
+  for(int threadCount = 1; threadCount <= 7; ++threadCount)
+  {
+#ifdef WITH_OPENMP
+    omp_set_num_threads(threadCount);
+#endif
+
+    std::vector<unsigned int> output(input.size(), sentinel);
+    PrefixSumUtil::calculate_exclusive_prefix_sums(&input[0], &output[0], segmentLength, segmentIndices);
+
+    // Check that the prefix sums of the specified masks are correct, and that the output for the remaining mask has been left untouched.
+    std::vector<unsigned int> expected(segmentLength);
+    for(int s = 0; s < segmentCount; ++s)
+    {
+      if(s == 1) expected.assign(segmentLength, sentinel);
+      else calculate_serial_prefix_sum(&input[s * segmentLength], &expected[0], segmentLength);
+
+      BOOST_CHECK(std::equal(expected.begin(), expected.end(), output.begin() + s * segmentLength));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(empty_test)
+{
+  // Calculating the prefix sums of no segments, or of empty segments, should do nothing.
+  unsigned char input = 1;
+  unsigned int output = 23;
+  PrefixSumUtil::calculate_exclusive_prefix_sums(&input, &output, 1, std::vector<int>());
+  PrefixSumUtil::calculate_exclusive_prefix_sums(&input, &output, 0, std::vector<int>(1, 0));
+  BOOST_CHECK_EQUAL(output, 23);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
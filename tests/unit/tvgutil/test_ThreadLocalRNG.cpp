@@ -0,0 +1,190 @@
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+#include <tvgutil/ThreadLocalRNG.h>
+using namespace tvgutil;
+
+/**
+ * \brief Generates the specified number of integers from a uniform distribution using each of the streams of a thread-local generator.
+ *
+ * \param rng            The generator.
+ * \param countPerStream The number of integers to generate from each stream.
+ * \return               The integers generated from each stream.
+ */
+std::vector<std::vector<int> > generate_ints_per_stream(ThreadLocalRNG& rng, int countPerStream)
+{
+  int streamCount = static_cast<int>(rng.get_stream_count());
+  std::vector<std::vector<int> > result(streamCount, std::vector<int>(countPerStream));
+
+#ifdef WITH_OPENMP
+  #pragma omp parallel num_threads(streamCount)
+#endif
+  {
+#ifdef WITH_OPENMP
+    int threadIndex = omp_get_thread_num();
+#else
+    int threadIndex = 0;
+#endif
+
+    for(int i = 0; i < countPerStream; ++i)
+    {
+      result[threadIndex][i] = rng.generate_int_from_uniform(0, 1000000);
+    }
+  }
+
+  return result;
+}
+
+BOOST_AUTO_TEST_SUITE(test_ThreadLocalRNG)
+
+BOOST_AUTO_TEST_CASE(generate_from_gaussian_test)
+{
+  ThreadLocalRNG rng(1234, 1);
+  const int count = 100000;
+  const float mean = 3.0f, sigma = 2.0f;
+
+  double sum = 0.0, sumOfSquares = 0.0;
+  for(int i = 0; i < count; ++i)
+  {
+    double x = rng.generate_from_gaussian(mean, sigma);
+    sum += x;
+    sumOfSquares += x * x;
+  }
+
+  double sampleMean = sum / count;
+  double sampleSigma = sqrt(sumOfSquares / count - sampleMean * sampleMean);
+  BOOST_CHECK_SMALL(sampleMean - mean, 0.05);
+  BOOST_CHECK_SMALL(sampleSigma - sigma, 0.05);
+}
+
+BOOST_AUTO_TEST_CASE(generate_int_from_uniform_test)
+{
+  ThreadLocalRNG rng(1234, 1);
+  BOOST_CHECK_EQUAL(rng.generate_int_from_uniform(23,23), 23);
+
+  // Check that the generated integers stay within the (closed) range, and that the bins are filled evenly (using a chi-squared test).
+  const int lower = -3, upper = 6, binCount = upper - lower + 1, count = 100000;
+  std::vector<int> bins(binCount, 0);
+  for(int i = 0; i < count; ++i)
+  {
+    int x = rng.generate_int_from_uniform(lower, upper);
+    BOOST_REQUIRE(x >= lower && x <= upper);
+    ++bins[x - lower];
+  }
+
+  double expected = static_cast<double>(count) / binCount;
+  double chiSquared = 0.0;
+  for(int i = 0; i < binCount; ++i)
+  {
+    chiSquared += (bins[i] - expected) * (bins[i] - expected) / expected;
+  }
+
+  // Note: 27.88 is the critical value of the chi-squared distribution with 9 degrees of freedom at the 0.1% significance level.
+  BOOST_CHECK_LT(chiSquared, 27.88);
+}
+
+BOOST_AUTO_TEST_CASE(generate_real_from_uniform_test)
+{
+  ThreadLocalRNG rng(1234, 1);
+  const int count = 100000;
+
+  double sum = 0.0;
+  for(int i = 0; i < count; ++i)
+  {
+    float x = rng.generate_real_from_uniform(-1.0f, 3.0f);
+    BOOST_REQUIRE(x >= -1.0f && x <= 3.0f);
+    sum += x;
+  }
+
+  BOOST_CHECK_SMALL(sum / count - 1.0, 0.02);
+}
+
+BOOST_AUTO_TEST_CASE(reproducibility_test)
+{
+  const size_t streamCount = 4;
+  const int countPerStream = 1000;
+
+  ThreadLocalRNG rng1(1234, streamCount), rng2(1234, streamCount), rng3(1235, streamCount);
+  std::vector<std::vector<int> > ints1 = generate_ints_per_stream(rng1, countPerStream);
+  std::vector<std::vector<int> > ints2 = generate_ints_per_stream(rng2, countPerStream);
+  std::vector<std::vector<int> > ints3 = generate_ints_per_stream(rng3, countPerStream);
+
+  // Generators with the same master seed should produce the same streams, and generators with different master seeds should not.
+  BOOST_CHECK(ints1 == ints2);
+  BOOST_CHECK(ints1 != ints3);
+
+#ifdef WITH_OPENMP
+  // The streams of a generator should differ from each other.
+  for(size_t i = 0; i < streamCount; ++i)
+  {
+    for(size_t j = i + 1; j < streamCount; ++j)
+    {
+      BOOST_CHECK(ints1[i] != ints1[j]);
+    }
+  }
+
+  // A thread that does not have its own stream should not be allowed to generate numbers.
+  ThreadLocalRNG rng4(1234, 1);
+  int failureCount = 0, threadCount = 0;
+  #pragma omp parallel num_threads(2) reduction(+:failureCount,threadCount)
+  {
+    ++threadCount;
+    try { rng4.generate_int_from_uniform(0, 10); }
+    catch(std::runtime_error&) { ++failureCount; }
+  }
+  BOOST_CHECK_EQUAL(failureCount, threadCount - 1);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(explicit_stream_test)
+{
+  const int streamCount = 4;
+  const int countPerStream = 1000;
+
+  // Generating from the streams explicitly should produce the same numbers as generating from them on their own threads.
+  ThreadLocalRNG rng1(1234, streamCount), rng2(1234, streamCount);
+  std::vector<std::vector<int> > ints1 = generate_ints_per_stream(rng1, countPerStream);
+  std::vector<std::vector<int> > ints2(streamCount, std::vector<int>(countPerStream));
+  for(int i = 0; i < streamCount; ++i)
+  {
+    for(int j = 0; j < countPerStream; ++j)
+    {
+      ints2[i][j] = rng2.generate_int_from_uniform(0, 1000000, i);
+    }
+  }
+  BOOST_CHECK(ints1 == ints2);
+
+#ifdef WITH_OPENMP
+  // Generating from the streams explicitly in parallel should produce the same numbers whatever the number of threads.
+  const int threadCounts[] = { 1, 2, 3 };
+  for(size_t t = 0; t < sizeof(threadCounts) / sizeof(int); ++t)
+  {
+    ThreadLocalRNG rng3(1234, streamCount);
+    std::vector<std::vector<int> > ints3(streamCount, std::vector<int>(countPerStream));
+
+    #pragma omp parallel for schedule(dynamic) num_threads(threadCounts[t])
+    for(int i = 0; i < streamCount; ++i)
+    {
+      for(int j = 0; j < countPerStream; ++j)
+      {
+        ints3[i][j] = rng3.generate_int_from_uniform(0, 1000000, i);
+      }
+    }
+
+    BOOST_CHECK(ints3 == ints1);
+  }
+#endif
+
+  // A stream that does not exist should not be usable.
+  BOOST_CHECK_THROW(rng1.generate_int_from_uniform(0, 10, streamCount), std::runtime_error);
+  BOOST_CHECK_THROW(rng1.generate_real_from_uniform(0.0f, 1.0f, streamCount), std::runtime_error);
+  BOOST_CHECK_THROW(rng1.generate_from_gaussian(0.0f, 1.0f, streamCount), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()